@@ -0,0 +1,187 @@
+/*
+ A simple benchmark for the arena allocator, used to compare the speed of
+ reading and traversing a large document with regular pages and huge pages:
+
+    cmake .. -DYYJSON_BUILD_MISC=ON -DCMAKE_BUILD_TYPE=Release
+
+ Usage: bench_arena [size_mb]
+ A synthetic document of `size_mb` megabytes (default 64) is generated: an
+ array of small objects. It is read with the default allocator and with the
+ arena allocator using different options (`yyjson_arena_flag`). The options
+ that took effect are printed, as huge pages and NUMA placement depend on the
+ system configuration (e.g. `/sys/kernel/mm/transparent_hugepage/enabled`).
+
+ The values are traversed in two ways:
+ - sequential: visit the values in the order of the tape.
+ - random: visit the objects in a random order and look up a key in each one,
+   which accesses pages all over the document and is sensitive to TLB misses.
+ */
+
+#include "yyjson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Number of rounds for each measurement, the best time is printed. */
+#define BENCH_ROUNDS 3
+
+static unsigned long long bench_seed = 0x853C49E6748FEA9BULL;
+
+static unsigned long long bench_rand(void) {
+    bench_seed = bench_seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return bench_seed >> 16;
+}
+
+static double get_time(void) {
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+}
+
+/* Array of small objects. */
+static char *gen_objects(size_t size, size_t *len) {
+    char *dat = (char *)malloc(size + 1024), *cur = dat;
+    unsigned long id = 0;
+    if (!dat) return NULL;
+    *cur++ = '[';
+    while ((size_t)(cur - dat) < size) {
+        cur += sprintf(cur, "{\"id\":%lu,\"name\":\"item%lu\",\"price\":%.2f,"
+                       "\"tags\":[%u,%u],\"ok\":%s},", id, id,
+                       (double)(bench_rand() % 100000) / 100.0,
+                       (unsigned)(bench_rand() % 1000),
+                       (unsigned)(bench_rand() % 1000),
+                       (id & 1) ? "true" : "false");
+        id++;
+    }
+    cur[-1] = ']';
+    *len = (size_t)(cur - dat);
+    return dat;
+}
+
+/* Visit all values in the order of the tape. */
+static unsigned long long traverse_seq(yyjson_doc *doc) {
+    yyjson_val *val = yyjson_doc_get_root(doc);
+    yyjson_val *end = val + yyjson_doc_get_val_count(doc);
+    unsigned long long sum = 0;
+    for (; val < end; val++) {
+        sum += yyjson_get_type(val) + (yyjson_is_int(val) ?
+                                       yyjson_get_uint(val) : 0);
+    }
+    return sum;
+}
+
+/* Visit the objects in a random order. */
+static unsigned long long traverse_rand(yyjson_val **objs, size_t num) {
+    unsigned long long sum = 0;
+    size_t i;
+    for (i = 0; i < num; i++) {
+        sum += yyjson_get_len(yyjson_obj_get(objs[i], "tags")) +
+               yyjson_get_uint(yyjson_obj_get(objs[i], "id"));
+    }
+    return sum;
+}
+
+static void bench_alc(const char *name, yyjson_alc *alc,
+                      const char *dat, size_t len) {
+    double t_read = 1e9, t_seq = 1e9, t_rand = 1e9, begin, end;
+    unsigned long long sum = 0;
+    yyjson_val **objs = NULL;
+    size_t num = 0, val_num = 0, i, j;
+    int round;
+
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+        yyjson_doc *doc;
+        yyjson_val *root;
+        yyjson_arr_iter iter;
+
+        begin = get_time();
+        doc = yyjson_read_opts((char *)(void *)(size_t)(const void *)dat,
+                               len, 0, alc, NULL);
+        end = get_time();
+        if (!doc) {
+            printf("%-28s read failed\n", name);
+            return;
+        }
+        if (end - begin < t_read) t_read = end - begin;
+        val_num = yyjson_doc_get_val_count(doc);
+
+        begin = get_time();
+        sum += traverse_seq(doc);
+        end = get_time();
+        if (end - begin < t_seq) t_seq = end - begin;
+
+        /* the objects in a random order (Fisher-Yates shuffle) */
+        root = yyjson_doc_get_root(doc);
+        num = yyjson_arr_size(root);
+        objs = (yyjson_val **)malloc(num * sizeof(yyjson_val *));
+        if (!objs) {
+            printf("%-28s out of memory\n", name);
+            yyjson_doc_free(doc);
+            return;
+        }
+        yyjson_arr_iter_init(root, &iter);
+        for (i = 0; i < num; i++) objs[i] = yyjson_arr_iter_next(&iter);
+        for (i = num; i > 1; i--) {
+            yyjson_val *tmp;
+            j = (size_t)(bench_rand() % i);
+            tmp = objs[i - 1];
+            objs[i - 1] = objs[j];
+            objs[j] = tmp;
+        }
+        begin = get_time();
+        sum += traverse_rand(objs, num);
+        end = get_time();
+        if (end - begin < t_rand) t_rand = end - begin;
+        free(objs);
+
+        yyjson_doc_free(doc);
+        if (alc) yyjson_alc_arena_reset(alc);
+    }
+
+    printf("%-28s read %8.2f MB/s, sequential %8.2f M values/s, "
+           "random %8.2f M objects/s (%llu)\n", name,
+           (double)len / t_read / 1024.0 / 1024.0,
+           (double)val_num / t_seq / 1e6,
+           (double)num / t_rand / 1e6, sum % 10);
+}
+
+static void bench_arena(const char *name, yyjson_arena_flag flg,
+                        const char *dat, size_t len) {
+    char desc[64];
+    yyjson_arena_flag got;
+    /* the values and strings need a few times the input size */
+    yyjson_alc *alc = yyjson_alc_arena_new(len * 8, flg, 0);
+    if (!alc) {
+        printf("%-28s cannot create the arena\n", name);
+        return;
+    }
+    got = yyjson_alc_arena_get_flag(alc);
+    snprintf(desc, sizeof(desc), "%s%s%s%s", name,
+             (got & YYJSON_ARENA_HUGETLB) ? " +hugetlb" : "",
+             (got & YYJSON_ARENA_HUGE_PAGE) ? " +thp" : "",
+             (got & YYJSON_ARENA_NUMA_NODE) ? " +numa" : "");
+    bench_alc(desc, alc, dat, len);
+    yyjson_alc_arena_free(alc);
+}
+
+int main(int argc, char *argv[]) {
+    size_t size = 64, len = 0;
+    char *dat;
+
+    if (argc > 1) size = (size_t)strtoul(argv[1], NULL, 10);
+    if (!size) size = 64;
+    dat = gen_objects(size * 1024 * 1024, &len);
+    if (!dat) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    printf("document: %.1f MB\n", (double)len / 1024.0 / 1024.0);
+
+    bench_alc("default", NULL, dat, len);
+    bench_arena("arena", YYJSON_ARENA_NOFLAG, dat, len);
+    bench_arena("arena huge", YYJSON_ARENA_HUGE_PAGE, dat, len);
+    bench_arena("arena hugetlb", YYJSON_ARENA_HUGETLB, dat, len);
+    bench_arena("arena huge numa0",
+                YYJSON_ARENA_HUGE_PAGE | YYJSON_ARENA_NUMA_NODE, dat, len);
+    free(dat);
+    return 0;
+}
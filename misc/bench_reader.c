@@ -0,0 +1,371 @@
+/*
+ A simple benchmark for the JSON reader, used to compare the hot loops of the
+ reader with different compile-time options, for example:
+
+    cmake .. -DYYJSON_BUILD_MISC=ON -DCMAKE_BUILD_TYPE=Release
+    cmake .. -DYYJSON_BUILD_MISC=ON -DCMAKE_BUILD_TYPE=Release -DYYJSON_DISABLE_SIMD=ON
+
+ Usage: bench_reader [file.json ...]
+ When no file is given, some synthetic documents are generated: long strings,
+ short keys, deep indentation, and arrays of integers and real numbers.
+ Each document is read with the default reader, with the value count pass
+ (`YYJSON_READ_PRECOUNT`) and with the structural index
+ (`YYJSON_READ_STRUCTURAL_INDEX`). The values allocated before and after
+ reading and the reallocation count are printed, see `yyjson_read_stats`.
+ When built with pthreads, it is also read with `yyjson_read_par()` and
+ BENCH_THREADS threads, timed by wall clock.
+ */
+
+#include "yyjson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if BENCH_USE_PTHREADS
+#include <pthread.h>
+#include <sys/time.h>
+#endif
+
+/* Minimum benchmark time for each document, in seconds. */
+#define BENCH_MIN_TIME 0.5
+
+/* Number of threads for the parallel reader. */
+#define BENCH_THREADS 4
+
+/* Synthetic document size, in bytes. */
+#define BENCH_DOC_SIZE (4 * 1024 * 1024)
+
+typedef struct {
+    char *dat;
+    size_t len;
+} bench_buf;
+
+static void buf_init(bench_buf *buf) {
+    buf->dat = (char *)malloc(BENCH_DOC_SIZE + 1024);
+    buf->len = 0;
+    if (!buf->dat) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+}
+
+static void buf_append(bench_buf *buf, const char *str) {
+    size_t len = strlen(str);
+    memcpy(buf->dat + buf->len, str, len);
+    buf->len += len;
+}
+
+static int buf_full(bench_buf *buf) {
+    return buf->len >= BENCH_DOC_SIZE;
+}
+
+static void buf_end(bench_buf *buf) {
+    buf->len--; /* remove the last comma */
+    buf_append(buf, "]");
+}
+
+/* Array of long ASCII strings without escapes. */
+static void gen_long_ascii(bench_buf *buf) {
+    buf_append(buf, "[");
+    while (!buf_full(buf)) {
+        buf_append(buf, "\"Lorem ipsum dolor sit amet, consectetur adipiscing "
+                   "elit, sed do eiusmod tempor incididunt ut labore et dolore "
+                   "magna aliqua. Ut enim ad minim veniam, quis nostrud.\",");
+    }
+    buf_end(buf);
+}
+
+/* Array of long strings with sparse escapes. */
+static void gen_long_escaped(bench_buf *buf) {
+    buf_append(buf, "[");
+    while (!buf_full(buf)) {
+        buf_append(buf, "\"Lorem ipsum dolor sit amet,\\nconsectetur adipiscing "
+                   "elit, sed do eiusmod tempor \\\"incididunt\\\" ut labore et "
+                   "dolore magna aliqua.\\tUt enim ad minim veniam.\",");
+    }
+    buf_end(buf);
+}
+
+/* Array of objects with short keys and values. */
+static void gen_short_keys(bench_buf *buf) {
+    buf_append(buf, "[");
+    while (!buf_full(buf)) {
+        buf_append(buf, "{\"id\":\"a1\",\"name\":\"Harry\",\"tag\":\"wizard\","
+                   "\"city\":\"London\",\"lang\":\"en\"},");
+    }
+    buf_end(buf);
+}
+
+/* Pretty-printed objects with deep indentation, mostly whitespace. */
+static void gen_pretty_indent(bench_buf *buf) {
+    char line[256];
+    int depth;
+    buf_append(buf, "[\n");
+    while (!buf_full(buf)) {
+        for (depth = 1; depth <= 12; depth++) {
+            memset(line, ' ', (size_t)depth * 4);
+            line[depth * 4] = '\0';
+            buf_append(buf, line);
+            buf_append(buf, depth == 1 ? "{\n" : "\"node\": {\n");
+        }
+        memset(line, ' ', 13 * 4);
+        line[13 * 4] = '\0';
+        buf_append(buf, line);
+        buf_append(buf, "\"id\": 12345,\n");
+        buf_append(buf, line);
+        buf_append(buf, "\"enabled\": true\n");
+        for (depth = 12; depth >= 1; depth--) {
+            memset(line, ' ', (size_t)depth * 4);
+            line[depth * 4] = '\0';
+            buf_append(buf, line);
+            buf_append(buf, depth == 1 ? "},\n" : "}\n");
+        }
+    }
+    buf->len -= 2; /* remove the last comma and newline */
+    buf_append(buf, "\n]");
+}
+
+/* Simple random number generator for the synthetic numbers. */
+static unsigned long long bench_rand(void) {
+    static unsigned long long seed = 1;
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return seed >> 1;
+}
+
+/* Array of 64-bit IDs with 18 or 19 digits. */
+static void gen_int_ids(bench_buf *buf) {
+    char num[64];
+    buf_append(buf, "[");
+    while (!buf_full(buf)) {
+        sprintf(num, "%llu,", bench_rand());
+        buf_append(buf, num);
+    }
+    buf_end(buf);
+}
+
+/* Array of millisecond timestamps with 13 digits. */
+static void gen_int_timestamps(bench_buf *buf) {
+    char num[64];
+    buf_append(buf, "[");
+    while (!buf_full(buf)) {
+        sprintf(num, "%llu,", 1600000000000ULL + bench_rand() % 100000000000ULL);
+        buf_append(buf, num);
+    }
+    buf_end(buf);
+}
+
+/* Array of small integers with 1 to 4 digits. */
+static void gen_int_small(bench_buf *buf) {
+    char num[64];
+    buf_append(buf, "[");
+    while (!buf_full(buf)) {
+        sprintf(num, "%llu,", bench_rand() % 10000);
+        buf_append(buf, num);
+    }
+    buf_end(buf);
+}
+
+/* Array of real numbers with a few fraction digits, e.g. prices. */
+static void gen_real_short(bench_buf *buf) {
+    char num[64];
+    buf_append(buf, "[");
+    while (!buf_full(buf)) {
+        unsigned long long r = bench_rand() % 10000000;
+        sprintf(num, "%llu.%02llu,", r / 100, r % 100);
+        buf_append(buf, num);
+    }
+    buf_end(buf);
+}
+
+/* Array of real numbers with 17 significant digits. */
+static void gen_real_long(bench_buf *buf) {
+    char num[64];
+    buf_append(buf, "[");
+    while (!buf_full(buf)) {
+        sprintf(num, "%.17g,", (double)bench_rand() / 1e15);
+        buf_append(buf, num);
+    }
+    buf_end(buf);
+}
+
+static double get_time(void) {
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+}
+
+static void bench_read_flg(const char *name, const char *dat, size_t len,
+                           yyjson_read_flag flg) {
+    double begin, end;
+    long count = 0;
+    yyjson_read_stats stats;
+    yyjson_doc *doc = yyjson_read(dat, len, flg);
+    if (!doc) {
+        printf("%-16s invalid JSON\n", name);
+        return;
+    }
+    if (!yyjson_doc_get_read_stats(doc, &stats)) {
+        memset(&stats, 0, sizeof(stats));
+    }
+    yyjson_doc_free(doc);
+
+    begin = get_time();
+    do {
+        doc = yyjson_read(dat, len, flg);
+        yyjson_doc_free(doc);
+        count++;
+        end = get_time();
+    } while (end - begin < BENCH_MIN_TIME);
+
+    printf("%-16s %-8s %10.2f MB/s  values: %lu, alloc: %lu -> %lu, "
+           "realloc: %lu\n", name,
+           (flg & YYJSON_READ_STRUCTURAL_INDEX) ? "index" :
+           (flg & YYJSON_READ_PRECOUNT) ? "precount" : "default",
+           (double)len * (double)count / (end - begin) / 1024.0 / 1024.0,
+           (unsigned long)stats.val_count, (unsigned long)stats.val_alloc,
+           (unsigned long)stats.val_cap, (unsigned long)stats.realloc_count);
+}
+
+#if BENCH_USE_PTHREADS
+typedef struct {
+    yyjson_par_task task;
+    void *arg;
+    size_t idx;
+} bench_job;
+
+static void *bench_job_main(void *ptr) {
+    bench_job *job = (bench_job *)ptr;
+    job->task(job->arg, job->idx);
+    return NULL;
+}
+
+/* Run each task on its own thread. */
+static void bench_par_run(void *ctx, yyjson_par_task task, void *arg,
+                          size_t num) {
+    pthread_t threads[BENCH_THREADS];
+    bench_job jobs[BENCH_THREADS];
+    size_t i;
+    (void)ctx;
+    for (i = 0; i < num; i++) {
+        jobs[i].task = task;
+        jobs[i].arg = arg;
+        jobs[i].idx = i;
+        if (i == 0 || pthread_create(&threads[i], NULL, bench_job_main,
+                                     &jobs[i]) != 0) {
+            threads[i] = pthread_self();
+            task(arg, i);
+        }
+    }
+    for (i = 1; i < num; i++) {
+        if (!pthread_equal(threads[i], pthread_self())) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+}
+
+static double get_wall_time(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+}
+
+static void bench_read_par(const char *name, const char *dat, size_t len) {
+    double begin, end;
+    long count = 0;
+    yyjson_doc *doc;
+
+    begin = get_wall_time();
+    do {
+        doc = yyjson_read_par((char *)dat, len, 0, NULL, BENCH_THREADS,
+                              bench_par_run, NULL, NULL);
+        if (!doc) {
+            printf("%-16s invalid JSON\n", name);
+            return;
+        }
+        yyjson_doc_free(doc);
+        count++;
+        end = get_wall_time();
+    } while (end - begin < BENCH_MIN_TIME);
+
+    printf("%-16s %-8s %10.2f MB/s\n", name, "parallel",
+           (double)len * (double)count / (end - begin) / 1024.0 / 1024.0);
+}
+#endif
+
+static void bench_read(const char *name, const char *dat, size_t len) {
+    bench_read_flg(name, dat, len, 0);
+    bench_read_flg(name, dat, len, YYJSON_READ_PRECOUNT);
+    bench_read_flg(name, dat, len, YYJSON_READ_STRUCTURAL_INDEX);
+#if BENCH_USE_PTHREADS
+    bench_read_par(name, dat, len);
+#endif
+}
+
+int main(int argc, char *argv[]) {
+    bench_buf buf;
+    int i;
+
+    if (argc > 1) {
+        for (i = 1; i < argc; i++) {
+            char *dat;
+            size_t len;
+            FILE *fp = fopen(argv[i], "rb");
+            if (!fp) {
+                printf("%-16s cannot open file\n", argv[i]);
+                continue;
+            }
+            fseek(fp, 0, SEEK_END);
+            len = (size_t)ftell(fp);
+            fseek(fp, 0, SEEK_SET);
+            dat = (char *)malloc(len + 1);
+            if (!dat || fread(dat, 1, len, fp) != len) {
+                printf("%-16s cannot read file\n", argv[i]);
+                fclose(fp);
+                free(dat);
+                continue;
+            }
+            fclose(fp);
+            bench_read(argv[i], dat, len);
+            free(dat);
+        }
+        return 0;
+    }
+
+    buf_init(&buf);
+    gen_long_ascii(&buf);
+    bench_read("long_ascii", buf.dat, buf.len);
+
+    buf.len = 0;
+    gen_long_escaped(&buf);
+    bench_read("long_escaped", buf.dat, buf.len);
+
+    buf.len = 0;
+    gen_short_keys(&buf);
+    bench_read("short_keys", buf.dat, buf.len);
+
+    buf.len = 0;
+    gen_pretty_indent(&buf);
+    bench_read("pretty_indent", buf.dat, buf.len);
+
+    buf.len = 0;
+    gen_int_ids(&buf);
+    bench_read("int_ids", buf.dat, buf.len);
+
+    buf.len = 0;
+    gen_int_timestamps(&buf);
+    bench_read("int_timestamps", buf.dat, buf.len);
+
+    buf.len = 0;
+    gen_int_small(&buf);
+    bench_read("int_small", buf.dat, buf.len);
+
+    buf.len = 0;
+    gen_real_short(&buf);
+    bench_read("real_short", buf.dat, buf.len);
+
+    buf.len = 0;
+    gen_real_long(&buf);
+    bench_read("real_long", buf.dat, buf.len);
+
+    free(buf.dat);
+    return 0;
+}
@@ -307,6 +307,76 @@ uint32_t yyjson_version(void) {
 #   endif
 #endif
 
+/*
+ SIMD instruction sets, selected at compile-time by the target flags.
+
+ YYJSON_HAS_SSE2: x86 with SSE2, default on x86-64.
+ YYJSON_HAS_AVX2: x86 with AVX2, e.g. `-mavx2` or `-march=native`.
+ YYJSON_HAS_NEON: little-endian AArch64 with NEON.
+
+ The SIMD code paths are only used for the hot loops of the reader and writer,
+ the scalar code paths are always available as the fallback.
+ */
+#if !YYJSON_DISABLE_SIMD && !YYJSON_FREESTANDING
+#   if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64) || \
+        (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#       define YYJSON_HAS_SSE2 1
+#       if defined(__AVX2__)
+#           define YYJSON_HAS_AVX2 1
+#           include <immintrin.h>
+#       else
+#           include <emmintrin.h>
+#       endif
+#   elif (defined(__ARM_NEON) || defined(_M_ARM64)) && \
+        (defined(__aarch64__) || defined(_M_ARM64)) && \
+        YYJSON_ENDIAN == YYJSON_LITTLE_ENDIAN
+#       define YYJSON_HAS_NEON 1
+#       include <arm_neon.h>
+#   endif
+#endif
+#ifndef YYJSON_HAS_SSE2
+#   define YYJSON_HAS_SSE2 0
+#endif
+#ifndef YYJSON_HAS_AVX2
+#   define YYJSON_HAS_AVX2 0
+#endif
+#ifndef YYJSON_HAS_NEON
+#   define YYJSON_HAS_NEON 0
+#endif
+#define YYJSON_HAS_SIMD (YYJSON_HAS_SSE2 || YYJSON_HAS_NEON)
+
+/*
+ Memory-mapped file support (POSIX `mmap()`), used by `yyjson_read_file_mmap()`
+ and the arena allocator. On other platforms, that function reads the file with
+ `yyjson_read_file()`, and the arena allocator uses the default allocator.
+ */
+#if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE && \
+    (defined(__unix__) || defined(__unix) || \
+     (defined(__APPLE__) && defined(__MACH__))) && \
+    yyjson_has_include(<sys/mman.h>) && yyjson_has_include(<unistd.h>)
+#   define YYJSON_HAS_MMAP 1
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#   if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#       define MAP_ANONYMOUS MAP_ANON /* BSD, Darwin */
+#   endif
+#   ifndef O_CLOEXEC
+#       define O_CLOEXEC 0
+#   endif
+#   if defined(__linux__) && yyjson_has_include(<sys/syscall.h>)
+#       include <sys/syscall.h>
+#   endif
+#   ifdef MAP_POPULATE
+#       define YYJSON_MAP_FILE (MAP_PRIVATE | MAP_POPULATE) /* Linux prefault */
+#   else
+#       define YYJSON_MAP_FILE MAP_PRIVATE
+#   endif
+#else
+#   define YYJSON_HAS_MMAP 0
+#endif
+
 /*
  Estimated initial ratio of the JSON data (data_size / value_count).
  For example:
@@ -332,11 +402,62 @@ uint32_t yyjson_version(void) {
 #define YYJSON_MUT_DOC_STR_POOL_INIT_SIZE   0x100
 #define YYJSON_MUT_DOC_STR_POOL_MAX_SIZE    0x10000000
 #define YYJSON_MUT_DOC_VAL_POOL_INIT_SIZE   (0x10 * sizeof(yyjson_mut_val))
+#if YYJSON_MUT_COMPACT
+#define YYJSON_MUT_DOC_VAL_POOL_MAX_SIZE    \
+    ((YYJSON_MUT_OFS_MASK + 1) * sizeof(yyjson_mut_val))
+#else
 #define YYJSON_MUT_DOC_VAL_POOL_MAX_SIZE    (0x1000000 * sizeof(yyjson_mut_val))
+#endif
+
+/* The number of value slots taken by the header of a value pool's chunk. */
+#define YYJSON_MUT_DOC_VAL_CHUNK_HDR \
+    ((sizeof(yyjson_val_chunk) + sizeof(yyjson_mut_val) - 1) / \
+     sizeof(yyjson_mut_val))
 
 /* The minimum size of the dynamic allocator's chunk. */
 #define YYJSON_ALC_DYN_MIN_SIZE             0x1000
 
+/* The minimum size of each part in the parallel reader. */
+#define YYJSON_READER_PAR_MIN_SIZE          0x10000
+
+/* The minimum size of the string pool of the zero-copy reader. */
+#define YYJSON_READER_COPY_POOL_MIN         0x100
+
+/* The initial size of the file buffer in the JSON Lines reader. */
+#define YYJSON_READER_NDJSON_BUF_SIZE       0x10000
+
+/* The number of 64-bit words of the SAX reader's nesting stack on the C stack,
+   one bit per level, deeper documents use the allocator. */
+#define YYJSON_READER_SAX_STACK_SIZE        8
+
+/* The default buffer size of the streaming writer. */
+#define YYJSON_WRITER_STREAM_BUF_SIZE       0x10000
+
+/* The minimum size of the values of each part in the parallel writer. */
+#define YYJSON_WRITER_PAR_MIN_SIZE          0x10000
+
+/* The default minimum length of the strings referenced by the vectored writer. */
+#define YYJSON_WRITER_IOV_REF_LEN           0x1000
+
+/* The buffer size of the streaming writer inside the exact-size writer, and
+   the minimum length of the strings it writes straight to the output. */
+#define YYJSON_WRITER_EXACT_BUF_SIZE        0x400
+#define YYJSON_WRITER_EXACT_REF_LEN         0x40
+
+/* The size of the memory on the C stack used by `yyjson_write_buf()` for the
+   exact-size writer, deeply nested values may need more and fail. */
+#define YYJSON_WRITER_EXACT_STACK_SIZE      0x2000
+
+/* The minimum number of pairs to build an object index on the first lookup. */
+#define YYJSON_DOC_OBJ_INDEX_MIN_SIZE       32
+
+/* The minimum number of elements to build an array index on the first access. */
+#define YYJSON_DOC_ARR_INDEX_MIN_SIZE       32
+
+/* The minimum and maximum size of the container index arena's chunk. */
+#define YYJSON_DOC_IDX_CHUNK_MIN_SIZE       0x1000
+#define YYJSON_DOC_IDX_CHUNK_MAX_SIZE       0x100000
+
 /* Default value for compile-time options. */
 
 #ifndef YYJSON_READER_DEPTH_LIMIT
@@ -421,6 +542,7 @@ uint32_t yyjson_version(void) {
 #define MSG_FREAD       "failed to read file"
 #define MSG_FWRITE      "failed to write file"
 #define MSG_FCLOSE      "failed to close file"
+#define MSG_SINK        "failed to write to sink"
 #define MSG_MALLOC      "failed to allocate memory"
 #define MSG_CHAR_T      "invalid literal, expected 'true'"
 #define MSG_CHAR_F      "invalid literal, expected 'false'"
@@ -2023,6 +2145,15 @@ static_inline u32 u64_lz_bits(u64 v) {
 #endif
 }
 
+/** Returns the number of 1-bits in value. */
+static_inline u32 u64_pop_bits(u64 v) {
+    v = v - ((v >> 1) & U64(0x55555555, 0x55555555));
+    v = (v & U64(0x33333333, 0x33333333)) +
+        ((v >> 2) & U64(0x33333333, 0x33333333));
+    v = (v + (v >> 4)) & U64(0x0F0F0F0F, 0x0F0F0F0F);
+    return (u32)((v * U64(0x01010101, 0x01010101)) >> 56);
+}
+
 /** Returns the number of trailing 0-bits in value (input should not be 0). */
 static_inline u32 u64_tz_bits(u64 v) {
 #if GCC_HAS_CTZLL
@@ -2092,6 +2223,173 @@ static_inline void u128_mul_add(u64 a, u64 b, u64 c, u64 *hi, u64 *lo) {
 
 
 
+/*==============================================================================
+ * MARK: - SIMD Utils (Private)
+ *============================================================================*/
+
+#if YYJSON_HAS_SIMD
+
+/** The number of bytes scanned by a single `simd_str_stop()` call. */
+#if YYJSON_HAS_AVX2
+#define SIMD_STR_SIZE 32
+#else
+#define SIMD_STR_SIZE 16
+#endif
+
+/**
+ Returns the index of the first byte that stops the string scanning in the
+ `SIMD_STR_SIZE` bytes at `src`: the quote, backslash, control character
+ [0x00-0x1F] or non-ASCII character [0x80-0xFF]. This is the same set as the
+ `char_is_ascii_skip()` (or `char_is_ascii_skip_sq()` for single quote).
+ Returns `SIMD_STR_SIZE` if there is no such byte.
+ */
+static_inline usize simd_str_stop(const u8 *src, u8 quo) {
+#if YYJSON_HAS_AVX2
+    __m256i v = _mm256_loadu_si256((const __m256i *)(const void *)src);
+    __m256i m = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8((char)quo)),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+        /* signed compare: [0x00-0x1F] and [0x80-0xFF] are less than 0x20 */
+        _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v));
+    u32 bits = (u32)_mm256_movemask_epi8(m);
+    if (likely(!bits)) return 32;
+    return u64_tz_bits(bits);
+#elif YYJSON_HAS_SSE2
+    __m128i v = _mm_loadu_si128((const __m128i *)(const void *)src);
+    __m128i m = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)quo)),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+        /* signed compare: [0x00-0x1F] and [0x80-0xFF] are less than 0x20 */
+        _mm_cmplt_epi8(v, _mm_set1_epi8(0x20)));
+    u32 bits = (u32)_mm_movemask_epi8(m);
+    if (likely(!bits)) return 16;
+    return u64_tz_bits(bits);
+#elif YYJSON_HAS_NEON
+    uint8x16_t v = vld1q_u8(src);
+    uint8x16_t m = vorrq_u8(
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8(quo)), vceqq_u8(v, vdupq_n_u8('\\'))),
+        vorrq_u8(vcltq_u8(v, vdupq_n_u8(0x20)), vcgeq_u8(v, vdupq_n_u8(0x80))));
+    /* narrow the 128-bit mask to 64-bit, 4 bits per byte */
+    u64 bits = vget_lane_u64(vreinterpret_u64_u8(
+        vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+    if (likely(!bits)) return 16;
+    return u64_tz_bits(bits) >> 2;
+#endif
+}
+
+/**
+ Copies `SIMD_STR_SIZE` bytes from `src` to `dst`, and returns the index of
+ the first byte that the string writer can't copy as is: the quote, backslash,
+ control character [0x00-0x1F], non-ASCII character [0x80-0xFF] or `sla`.
+ Pass '/' as `sla` to stop at slashes, or '"' to ignore it.
+ Returns `SIMD_STR_SIZE` if there is no such byte.
+ */
+static_inline usize simd_str_esc_copy(u8 *dst, const u8 *src, u8 sla) {
+#if YYJSON_HAS_AVX2
+    __m256i v = _mm256_loadu_si256((const __m256i *)(const void *)src);
+    __m256i m = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8((char)sla)),
+                        _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v)));
+    u32 bits = (u32)_mm256_movemask_epi8(m);
+    _mm256_storeu_si256((__m256i *)(void *)dst, v);
+    if (likely(!bits)) return 32;
+    return u64_tz_bits(bits);
+#elif YYJSON_HAS_SSE2
+    __m128i v = _mm_loadu_si128((const __m128i *)(const void *)src);
+    __m128i m = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)sla)),
+                     _mm_cmplt_epi8(v, _mm_set1_epi8(0x20))));
+    u32 bits = (u32)_mm_movemask_epi8(m);
+    _mm_storeu_si128((__m128i *)(void *)dst, v);
+    if (likely(!bits)) return 16;
+    return u64_tz_bits(bits);
+#elif YYJSON_HAS_NEON
+    uint8x16_t v = vld1q_u8(src);
+    uint8x16_t m = vorrq_u8(
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\\'))),
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8(sla)),
+                 vorrq_u8(vcltq_u8(v, vdupq_n_u8(0x20)),
+                          vcgeq_u8(v, vdupq_n_u8(0x80)))));
+    u64 bits = vget_lane_u64(vreinterpret_u64_u8(
+        vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+    vst1q_u8(dst, v);
+    if (likely(!bits)) return 16;
+    return u64_tz_bits(bits) >> 2;
+#endif
+}
+
+/** The number of bytes scanned by a single `simd_space_len()` call. */
+#if YYJSON_HAS_AVX2
+#define SIMD_SPACE_SIZE 64
+#else
+#define SIMD_SPACE_SIZE 32
+#endif
+
+#if YYJSON_HAS_AVX2
+/** Returns a 32-bit mask of whitespace [ \t\n\r] in 32 bytes. */
+static_inline u32 simd_space_mask_32(const u8 *src) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(const void *)src);
+    __m256i m = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+    return (u32)_mm256_movemask_epi8(m);
+}
+#elif YYJSON_HAS_SSE2
+/** Returns a 16-bit mask of whitespace [ \t\n\r] in 16 bytes. */
+static_inline u32 simd_space_mask_16(const u8 *src) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(const void *)src);
+    __m128i m = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+    return (u32)_mm_movemask_epi8(m);
+}
+#elif YYJSON_HAS_NEON
+/** Returns a 64-bit mask of whitespace [ \t\n\r] in 16 bytes, 4 bits/byte. */
+static_inline u64 simd_space_mask_16(const u8 *src) {
+    uint8x16_t v = vld1q_u8(src);
+    uint8x16_t m = vorrq_u8(
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t'))),
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\r'))));
+    return vget_lane_u64(vreinterpret_u64_u8(
+        vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+}
+#endif
+
+/**
+ Returns the number of leading whitespace [ \t\n\r] in the `SIMD_SPACE_SIZE`
+ bytes at `src`, the whitespace of the whole block is tested at once.
+ */
+static_inline usize simd_space_len(const u8 *src) {
+#if YYJSON_HAS_AVX2
+    u64 bits = (u64)simd_space_mask_32(src) |
+               ((u64)simd_space_mask_32(src + 32) << 32);
+    if (unlikely(!~bits)) return 64;
+    return u64_tz_bits(~bits);
+#elif YYJSON_HAS_SSE2
+    u32 bits = simd_space_mask_16(src) | (simd_space_mask_16(src + 16) << 16);
+    if (unlikely(!~bits)) return 32;
+    return u64_tz_bits(~bits);
+#elif YYJSON_HAS_NEON
+    u64 bits = simd_space_mask_16(src);
+    if (likely(~bits)) return u64_tz_bits(~bits) >> 2;
+    bits = simd_space_mask_16(src + 16);
+    if (unlikely(!~bits)) return 32;
+    return 16 + (u64_tz_bits(~bits) >> 2);
+#endif
+}
+
+#endif /* YYJSON_HAS_SIMD */
+
+
+
 /*==============================================================================
  * MARK: - File Utils (Private)
  * These functions are used to read and write JSON files.
@@ -2406,85 +2704,116 @@ bool yyjson_alc_pool_init(yyjson_alc *alc, void *buf, usize size) {
  * unused memory. Instead, it places the unused memory into a freelist for
  * potential reuse in the future. It is only when the entire allocator is
  * destroyed that all previously allocated memory is released at once.
+ *
+ * The chunk sizes are powers of two, and the unused chunks are kept in a bin
+ * for each size, with a bitmap of the non-empty bins, so the smallest unused
+ * chunk that is large enough can be found in constant time. The chunks in use
+ * are kept in a doubly linked list, so they can be removed in constant time.
  *============================================================================*/
 
 /** memory chunk header */
 typedef struct dyn_chunk {
-    usize size; /* chunk size, including header */
+    usize size; /* chunk size (power of 2), including header */
+    usize used; /* requested size if the chunk is in use, or 0 if unused */
+    struct dyn_chunk *prev; /* only used in the used list */
     struct dyn_chunk *next;
     /* char mem[]; flexible array member */
 } dyn_chunk;
 
 /** allocator ctx header */
 typedef struct {
-    dyn_chunk free_list; /* dummy header, sorted from small to large */
-    dyn_chunk used_list; /* dummy header */
+    dyn_chunk *bins[sizeof(usize) * 8]; /* unused chunks of size (1 << i) */
+    u64 bin_map; /* bit i is set if bins[i] is not empty */
+    dyn_chunk used_list; /* dummy header of a circular list */
+    usize held_size; /* see yyjson_alc_dyn_stats */
+    usize used_size;
+    usize alloc_count;
+    usize hit_count;
+    usize grow_count;
 } dyn_ctx;
 
-/** align up the input size to chunk size */
-static_inline bool dyn_size_align(usize *size) {
-    usize alc_size = *size + sizeof(dyn_chunk);
-    alc_size = size_align_up(alc_size, YYJSON_ALC_DYN_MIN_SIZE);
-    if (unlikely(alc_size < *size)) return false; /* overflow */
-    *size = alc_size;
+/** Get the bin (log2 of the chunk size) for the input size. */
+static_inline bool dyn_size_bin(usize size, usize *bin) {
+    usize alc_size = size + sizeof(dyn_chunk), pow;
+    if (unlikely(alc_size < size)) return false; /* overflow */
+    if (alc_size < YYJSON_ALC_DYN_MIN_SIZE) alc_size = YYJSON_ALC_DYN_MIN_SIZE;
+    pow = 64 - u64_lz_bits((u64)alc_size - 1);
+    if (unlikely(pow >= sizeof(usize) * 8)) return false; /* overflow */
+    *bin = pow;
     return true;
 }
 
-/** remove a chunk from list (the chunk must already be in the list) */
-static_inline void dyn_chunk_list_remove(dyn_chunk *list, dyn_chunk *chunk) {
-    dyn_chunk *prev = list, *cur;
-    for (cur = prev->next; cur; cur = cur->next) {
-        if (cur == chunk) {
-            prev->next = cur->next;
-            cur->next = NULL;
-            return;
-        }
-        prev = cur;
-    }
+/** Remove a chunk from the used list. */
+static_inline void dyn_used_remove(dyn_ctx *ctx, dyn_chunk *chunk) {
+    chunk->prev->next = chunk->next;
+    chunk->next->prev = chunk->prev;
+    ctx->used_size -= chunk->used;
+    chunk->used = 0;
+}
+
+/** Add a chunk to the used list. */
+static_inline void dyn_used_add(dyn_ctx *ctx, dyn_chunk *chunk, usize used) {
+    chunk->prev = &ctx->used_list;
+    chunk->next = ctx->used_list.next;
+    chunk->next->prev = chunk;
+    ctx->used_list.next = chunk;
+    ctx->used_size += used;
+    chunk->used = used;
+}
+
+/** Remove the first chunk from a bin (the bin must not be empty). */
+static_inline dyn_chunk *dyn_bin_pop(dyn_ctx *ctx, usize bin) {
+    dyn_chunk *chunk = ctx->bins[bin];
+    ctx->bins[bin] = chunk->next;
+    if (!chunk->next) ctx->bin_map &= ~((u64)1 << bin);
+    return chunk;
 }
 
-/** add a chunk to list header (the chunk must not be in the list) */
-static_inline void dyn_chunk_list_add(dyn_chunk *list, dyn_chunk *chunk) {
-    chunk->next = list->next;
-    list->next = chunk;
+/** Add a chunk to its bin. */
+static_inline void dyn_bin_push(dyn_ctx *ctx, dyn_chunk *chunk) {
+    usize bin = u64_tz_bits((u64)chunk->size);
+    chunk->next = ctx->bins[bin];
+    ctx->bins[bin] = chunk;
+    ctx->bin_map |= (u64)1 << bin;
 }
 
 static void *dyn_malloc(void *ctx_ptr, usize size) {
     /* assert(size != 0) */
     const yyjson_alc def = YYJSON_DEFAULT_ALC;
     dyn_ctx *ctx = (dyn_ctx *)ctx_ptr;
-    dyn_chunk *chunk, *prev;
-    if (unlikely(!dyn_size_align(&size))) return NULL;
-
-    /* freelist is empty, create new chunk */
-    if (!ctx->free_list.next) {
-        chunk = (dyn_chunk *)def.malloc(def.ctx, size);
-        if (unlikely(!chunk)) return NULL;
-        chunk->size = size;
-        chunk->next = NULL;
-        dyn_chunk_list_add(&ctx->used_list, chunk);
-        return (void *)(chunk + 1);
-    }
-
-    /* find a large enough chunk, or resize the largest chunk */
-    prev = &ctx->free_list;
-    while (true) {
-        chunk = prev->next;
-        if (chunk->size >= size) { /* enough size, reuse this chunk */
-            prev->next = chunk->next;
-            dyn_chunk_list_add(&ctx->used_list, chunk);
-            return (void *)(chunk + 1);
-        }
-        if (!chunk->next) { /* resize the largest chunk */
-            chunk = (dyn_chunk *)def.realloc(def.ctx, chunk, chunk->size, size);
-            if (unlikely(!chunk)) return NULL;
-            prev->next = NULL;
-            chunk->size = size;
-            dyn_chunk_list_add(&ctx->used_list, chunk);
-            return (void *)(chunk + 1);
+    dyn_chunk *chunk, *tmp;
+    usize bin, top;
+    u64 map;
+    if (unlikely(!dyn_size_bin(size, &bin))) return NULL;
+    ctx->alloc_count++;
+
+    map = ctx->bin_map >> bin;
+    if (map) {
+        /* reuse the smallest unused chunk that is large enough */
+        chunk = dyn_bin_pop(ctx, bin + u64_tz_bits(map));
+        ctx->hit_count++;
+    } else if (ctx->bin_map) {
+        /* resize the largest unused chunk */
+        top = 63 - u64_lz_bits(ctx->bin_map);
+        chunk = dyn_bin_pop(ctx, top);
+        tmp = (dyn_chunk *)def.realloc(def.ctx, chunk, chunk->size,
+                                       (usize)1 << bin);
+        if (unlikely(!tmp)) {
+            dyn_bin_push(ctx, chunk);
+            return NULL;
         }
-        prev = chunk;
+        chunk = tmp;
+        ctx->held_size += ((usize)1 << bin) - chunk->size;
+        chunk->size = (usize)1 << bin;
+    } else {
+        /* freelist is empty, create new chunk */
+        chunk = (dyn_chunk *)def.malloc(def.ctx, (usize)1 << bin);
+        if (unlikely(!chunk)) return NULL;
+        chunk->size = (usize)1 << bin;
+        ctx->held_size += chunk->size;
     }
+    dyn_used_add(ctx, chunk, size);
+    return (void *)(chunk + 1);
 }
 
 static void *dyn_realloc(void *ctx_ptr, void *ptr,
@@ -2493,32 +2822,33 @@ static void *dyn_realloc(void *ctx_ptr, void *ptr,
     const yyjson_alc def = YYJSON_DEFAULT_ALC;
     dyn_ctx *ctx = (dyn_ctx *)ctx_ptr;
     dyn_chunk *new_chunk, *chunk = (dyn_chunk *)ptr - 1;
-    if (unlikely(!dyn_size_align(&size))) return NULL;
-    if (chunk->size >= size) return ptr;
-
-    dyn_chunk_list_remove(&ctx->used_list, chunk);
-    new_chunk = (dyn_chunk *)def.realloc(def.ctx, chunk, chunk->size, size);
-    if (likely(new_chunk)) {
-        new_chunk->size = size;
-        chunk = new_chunk;
+    usize bin;
+    if (unlikely(!dyn_size_bin(size, &bin))) return NULL;
+    if (chunk->size >= ((usize)1 << bin)) {
+        ctx->used_size += size - chunk->used;
+        chunk->used = size;
+        return ptr;
     }
-    dyn_chunk_list_add(&ctx->used_list, chunk);
-    return new_chunk ? (void *)(new_chunk + 1) : NULL;
+
+    ctx->grow_count++;
+    new_chunk = (dyn_chunk *)def.realloc(def.ctx, chunk, chunk->size,
+                                         (usize)1 << bin);
+    if (unlikely(!new_chunk)) return NULL;
+    new_chunk->prev->next = new_chunk; /* the chunk may have been moved */
+    new_chunk->next->prev = new_chunk;
+    ctx->held_size += ((usize)1 << bin) - new_chunk->size;
+    ctx->used_size += size - new_chunk->used;
+    new_chunk->size = (usize)1 << bin;
+    new_chunk->used = size;
+    return (void *)(new_chunk + 1);
 }
 
 static void dyn_free(void *ctx_ptr, void *ptr) {
     /* assert(ptr != NULL) */
     dyn_ctx *ctx = (dyn_ctx *)ctx_ptr;
-    dyn_chunk *chunk = (dyn_chunk *)ptr - 1, *prev;
-
-    dyn_chunk_list_remove(&ctx->used_list, chunk);
-    for (prev = &ctx->free_list; prev; prev = prev->next) {
-        if (!prev->next || prev->next->size >= chunk->size) {
-            chunk->next = prev->next;
-            prev->next = chunk;
-            break;
-        }
-    }
+    dyn_chunk *chunk = (dyn_chunk *)ptr - 1;
+    dyn_used_remove(ctx, chunk);
+    dyn_bin_push(ctx, chunk);
 }
 
 yyjson_alc *yyjson_alc_dyn_new(void) {
@@ -2534,6 +2864,8 @@ yyjson_alc *yyjson_alc_dyn_new(void) {
     alc->free = dyn_free;
     alc->ctx = alc + 1;
     memset(ctx, 0, sizeof(*ctx));
+    ctx->used_list.prev = &ctx->used_list;
+    ctx->used_list.next = &ctx->used_list;
     return alc;
 }
 
@@ -2541,1964 +2873,2967 @@ void yyjson_alc_dyn_free(yyjson_alc *alc) {
     const yyjson_alc def = YYJSON_DEFAULT_ALC;
     dyn_ctx *ctx;
     dyn_chunk *chunk, *next;
+    usize bin;
     if (unlikely(!alc)) return;
     ctx = (dyn_ctx *)(void *)(alc + 1);
-    for (chunk = ctx->free_list.next; chunk; chunk = next) {
-        next = chunk->next;
-        def.free(def.ctx, chunk);
+    for (bin = 0; bin < sizeof(usize) * 8; bin++) {
+        for (chunk = ctx->bins[bin]; chunk; chunk = next) {
+            next = chunk->next;
+            def.free(def.ctx, chunk);
+        }
     }
-    for (chunk = ctx->used_list.next; chunk; chunk = next) {
+    for (chunk = ctx->used_list.next; chunk != &ctx->used_list; chunk = next) {
         next = chunk->next;
         def.free(def.ctx, chunk);
     }
     def.free(def.ctx, alc);
 }
 
+bool yyjson_alc_dyn_get_stats(const yyjson_alc *alc,
+                              yyjson_alc_dyn_stats *stats) {
+    const dyn_ctx *ctx;
+    if (unlikely(!alc || !stats || alc->malloc != dyn_malloc)) return false;
+    ctx = (const dyn_ctx *)alc->ctx;
+    stats->held_size = ctx->held_size;
+    stats->used_size = ctx->used_size;
+    stats->alloc_count = ctx->alloc_count;
+    stats->hit_count = ctx->hit_count;
+    stats->grow_count = ctx->grow_count;
+    return true;
+}
+
 
 
 /*==============================================================================
- * MARK: - JSON Struct Utils (Public)
- * These functions are used for creating, copying, releasing, and comparing
- * JSON documents and values. They are widely used throughout this library.
+ * MARK: - Thread-Safe Memory Allocator (Public)
+ * This allocator can be shared by multiple threads. It allocates memory in
+ * power-of-two size classes, and like the dynamic allocator, it does not
+ * release unused memory until the allocator is destroyed.
+ *
+ * Unused chunks are kept in several caches. Each cache is protected by a spin
+ * lock that is never waited on: a thread picks a cache by its stack address,
+ * and tries the next cache if it is locked. Chunks are moved between the caches
+ * and a lock-free depot in batches. For each size class, the depot is a stack
+ * of batches, which only supports pushing and taking all the batches at once,
+ * so it does not suffer from the ABA problem.
  *============================================================================*/
 
-static_inline void unsafe_yyjson_str_pool_release(yyjson_str_pool *pool,
-                                                  yyjson_alc *alc) {
-    yyjson_str_chunk *chunk = pool->chunks, *next;
-    while (chunk) {
-        next = chunk->next;
-        alc->free(alc->ctx, chunk);
-        chunk = next;
-    }
-}
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+#   define YYJSON_HAS_ATOMIC 1
+#   define MSC_HAS_ATOMIC 0
+typedef int mt_lock;
+#elif YYJSON_MSC_VER >= 1400 && (defined(_M_AMD64) || defined(_M_ARM64))
+#   define YYJSON_HAS_ATOMIC 1
+#   define MSC_HAS_ATOMIC 1
+typedef long mt_lock;
+#else
+#   define YYJSON_HAS_ATOMIC 0
+#endif
 
-static_inline void unsafe_yyjson_val_pool_release(yyjson_val_pool *pool,
-                                                  yyjson_alc *alc) {
-    yyjson_val_chunk *chunk = pool->chunks, *next;
-    while (chunk) {
-        next = chunk->next;
-        alc->free(alc->ctx, chunk);
-        chunk = next;
-    }
+#if YYJSON_HAS_ATOMIC
+
+/** The smallest size class (64 bytes). */
+#define MT_CLASS_MIN 6
+/** The number of size classes. */
+#define MT_CLASS_NUM (sizeof(usize) * 8 - MT_CLASS_MIN)
+/** The number of chunks moved between a cache and the depot at once. */
+#define MT_BATCH_NUM 8
+/** The number of caches tried before falling back to the depot. */
+#define MT_CACHE_TRY 2
+/** The default and maximum number of caches. */
+#define MT_CACHE_DEF 8
+#define MT_CACHE_MAX 256
+
+/** Try to acquire a spin lock without waiting. */
+static_inline bool mt_lock_try(volatile mt_lock *lock) {
+#if MSC_HAS_ATOMIC
+    return _InterlockedExchange(lock, 1) == 0;
+#else
+    return __atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) == 0;
+#endif
 }
 
-bool unsafe_yyjson_str_pool_grow(yyjson_str_pool *pool,
-                                 const yyjson_alc *alc, usize len) {
-    yyjson_str_chunk *chunk;
-    usize size, max_len;
+/** Release a spin lock. */
+static_inline void mt_unlock(volatile mt_lock *lock) {
+#if MSC_HAS_ATOMIC
+    _InterlockedExchange(lock, 0);
+#else
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+#endif
+}
 
-    /* create a new chunk */
-    max_len = USIZE_MAX - sizeof(yyjson_str_chunk);
-    if (unlikely(len > max_len)) return false;
-    size = len + sizeof(yyjson_str_chunk);
-    size = yyjson_max(pool->chunk_size, size);
-    chunk = (yyjson_str_chunk *)alc->malloc(alc->ctx, size);
-    if (unlikely(!chunk)) return false;
+/** Load a pointer atomically. */
+static_inline void *mt_ptr_load(void *volatile *ptr) {
+#if MSC_HAS_ATOMIC
+    return _InterlockedCompareExchangePointer(ptr, NULL, NULL);
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
 
-    /* insert the new chunk as the head of the linked list */
-    chunk->next = pool->chunks;
-    chunk->chunk_size = size;
-    pool->chunks = chunk;
-    pool->cur = (char *)chunk + sizeof(yyjson_str_chunk);
-    pool->end = (char *)chunk + size;
+/** Replace a pointer atomically, returns the old pointer. */
+static_inline void *mt_ptr_xchg(void *volatile *ptr, void *val) {
+#if MSC_HAS_ATOMIC
+    return _InterlockedExchangePointer(ptr, val);
+#else
+    return __atomic_exchange_n(ptr, val, __ATOMIC_ACQ_REL);
+#endif
+}
 
-    /* the next chunk is twice the size of the current one */
-    size = yyjson_min(pool->chunk_size * 2, pool->chunk_size_max);
-    if (size < pool->chunk_size) size = pool->chunk_size_max; /* overflow */
-    pool->chunk_size = size;
-    return true;
+/** Replace a pointer atomically if it is equal to `cmp`. */
+static_inline bool mt_ptr_cas(void *volatile *ptr, void *cmp, void *val) {
+#if MSC_HAS_ATOMIC
+    return _InterlockedCompareExchangePointer(ptr, val, cmp) == cmp;
+#else
+    return __atomic_compare_exchange_n(ptr, &cmp, val, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
 }
 
-bool unsafe_yyjson_val_pool_grow(yyjson_val_pool *pool,
-                                 const yyjson_alc *alc, usize count) {
-    yyjson_val_chunk *chunk;
-    usize size, max_count;
+/** memory chunk header */
+typedef struct mt_chunk {
+    usize cls; /* size class, the chunk size (including header) is 1 << cls */
+    struct mt_chunk *all; /* the list of all chunks, for destroying */
+    /* char mem[]; flexible array member */
+} mt_chunk;
 
-    /* create a new chunk */
-    max_count = USIZE_MAX / sizeof(yyjson_mut_val) - 1;
-    if (unlikely(count > max_count)) return false;
-    size = (count + 1) * sizeof(yyjson_mut_val);
-    size = yyjson_max(pool->chunk_size, size);
-    chunk = (yyjson_val_chunk *)alc->malloc(alc->ctx, size);
-    if (unlikely(!chunk)) return false;
+/** memory of an unused chunk */
+typedef struct mt_node {
+    struct mt_node *next; /* next chunk in this cache or batch */
+    struct mt_node *batch; /* next batch in the depot */
+} mt_node;
 
-    /* insert the new chunk as the head of the linked list */
-    chunk->next = pool->chunks;
-    chunk->chunk_size = size;
-    pool->chunks = chunk;
-    pool->cur = (yyjson_mut_val *)(void *)((u8 *)chunk) + 1;
-    pool->end = (yyjson_mut_val *)(void *)((u8 *)chunk + size);
+/** chunk cache, only accessed with the lock held */
+typedef struct mt_cache {
+    volatile mt_lock lock;
+    u32 num[MT_CLASS_NUM]; /* number of chunks in each list */
+    mt_node *list[MT_CLASS_NUM];
+} mt_cache;
 
-    /* the next chunk is twice the size of the current one */
-    size = yyjson_min(pool->chunk_size * 2, pool->chunk_size_max);
-    if (size < pool->chunk_size) size = pool->chunk_size_max; /* overflow */
-    pool->chunk_size = size;
-    return true;
+/** allocator ctx header */
+typedef struct mt_ctx {
+    void *volatile depot[MT_CLASS_NUM]; /* stacks of batches (mt_node) */
+    void *volatile all; /* all chunks allocated from system (mt_chunk) */
+    mt_cache *caches;
+    usize cache_num;
+} mt_ctx;
+
+/** Returns the size class for the memory size, or 0 on overflow. */
+static_inline usize mt_size_class(usize size) {
+    usize cls;
+    if (unlikely(size_add_is_overflow(size, sizeof(mt_chunk)))) return 0;
+    size += sizeof(mt_chunk);
+    cls = 64 - u64_lz_bits((u64)size - 1);
+    if (cls < MT_CLASS_MIN) cls = MT_CLASS_MIN;
+    return cls < sizeof(usize) * 8 ? cls : 0;
 }
 
-bool yyjson_mut_doc_set_str_pool_size(yyjson_mut_doc *doc, size_t len) {
-    usize max_size = USIZE_MAX - sizeof(yyjson_str_chunk);
-    if (!doc || !len || len > max_size) return false;
-    doc->str_pool.chunk_size = len + sizeof(yyjson_str_chunk);
-    return true;
+/** Lock a cache for the current thread, returns NULL if they are locked. */
+static_inline mt_cache *mt_cache_lock(mt_ctx *ctx) {
+    usize i, idx, addr;
+    void *mark = (void *)&addr; /* an address on the stack of this thread */
+    memcpy(&addr, &mark, sizeof(usize));
+    idx = (usize)(((u64)(addr >> 16) * U64(0x9E3779B9, 0x7F4A7C15)) >> 40);
+    for (i = 0; i < MT_CACHE_TRY; i++) {
+        mt_cache *cache = ctx->caches + (idx + i) % ctx->cache_num;
+        if (mt_lock_try(&cache->lock)) return cache;
+    }
+    return NULL;
 }
 
-bool yyjson_mut_doc_set_val_pool_size(yyjson_mut_doc *doc, size_t count) {
-    usize max_count = USIZE_MAX / sizeof(yyjson_mut_val) - 1;
-    if (!doc || !count || count > max_count) return false;
-    doc->val_pool.chunk_size = (count + 1) * sizeof(yyjson_mut_val);
-    return true;
+/** Push a list of batches to the depot. */
+static_inline void mt_depot_push(void *volatile *depot,
+                                 mt_node *first, mt_node *last) {
+    void *head;
+    do {
+        head = mt_ptr_load(depot);
+        last->batch = (mt_node *)head;
+    } while (!mt_ptr_cas(depot, head, (void *)first));
 }
 
-void yyjson_mut_doc_free(yyjson_mut_doc *doc) {
-    if (doc) {
-        yyjson_alc alc = doc->alc;
-        memset(&doc->alc, 0, sizeof(alc));
-        unsafe_yyjson_str_pool_release(&doc->str_pool, &alc);
-        unsafe_yyjson_val_pool_release(&doc->val_pool, &alc);
-        alc.free(alc.ctx, doc);
+/** Pop a batch from the depot, returns NULL if the depot is empty. */
+static_inline mt_node *mt_depot_pop(void *volatile *depot) {
+    mt_node *top, *rest, *last;
+    if (!mt_ptr_load(depot)) return NULL;
+    top = (mt_node *)mt_ptr_xchg(depot, NULL);
+    if (!top) return NULL;
+    rest = top->batch;
+    if (rest && !mt_ptr_cas(depot, NULL, (void *)rest)) {
+        /* other batches were pushed in the meantime */
+        for (last = rest; last->batch; ) last = last->batch;
+        mt_depot_push(depot, rest, last);
+    }
+    return top;
+}
+
+static void *mt_malloc(void *ctx_ptr, usize size) {
+    /* assert(size != 0) */
+    const yyjson_alc def = YYJSON_DEFAULT_ALC;
+    mt_ctx *ctx = (mt_ctx *)ctx_ptr;
+    mt_cache *cache;
+    mt_chunk *chunk;
+    mt_node *mem, *tmp;
+    usize cls = mt_size_class(size), idx;
+    void *head;
+    if (unlikely(!cls)) return NULL;
+    idx = cls - MT_CLASS_MIN;
+
+    cache = mt_cache_lock(ctx);
+    if (likely(cache)) {
+        mem = cache->list[idx];
+        if (!mem) { /* refill the cache with a batch from the depot */
+            mem = mt_depot_pop(&ctx->depot[idx]);
+            for (tmp = mem; tmp; tmp = tmp->next) cache->num[idx]++;
+        }
+        if (mem) {
+            cache->list[idx] = mem->next;
+            cache->num[idx]--;
+        }
+        mt_unlock(&cache->lock);
+    } else { /* take one chunk from the depot and return the others */
+        mem = mt_depot_pop(&ctx->depot[idx]);
+        if (mem && mem->next) {
+            mt_depot_push(&ctx->depot[idx], mem->next, mem->next);
+        }
     }
+    if (mem) return (void *)mem;
+
+    /* no unused chunk, allocate a new one */
+    chunk = (mt_chunk *)def.malloc(def.ctx, (usize)1 << cls);
+    if (unlikely(!chunk)) return NULL;
+    chunk->cls = cls;
+    do {
+        head = mt_ptr_load(&ctx->all);
+        chunk->all = (mt_chunk *)head;
+    } while (!mt_ptr_cas(&ctx->all, head, (void *)chunk));
+    return (void *)(chunk + 1);
 }
 
-yyjson_mut_doc *yyjson_mut_doc_new(const yyjson_alc *alc) {
-    yyjson_mut_doc *doc;
-    if (!alc) alc = &YYJSON_DEFAULT_ALC;
-    doc = (yyjson_mut_doc *)alc->malloc(alc->ctx, sizeof(yyjson_mut_doc));
-    if (!doc) return NULL;
-    memset(doc, 0, sizeof(yyjson_mut_doc));
+static void mt_free(void *ctx_ptr, void *ptr) {
+    /* assert(ptr != NULL) */
+    mt_ctx *ctx = (mt_ctx *)ctx_ptr;
+    mt_node *mem = (mt_node *)ptr, *last;
+    usize idx = ((mt_chunk *)ptr - 1)->cls - MT_CLASS_MIN, i;
+    mt_cache *cache = mt_cache_lock(ctx);
+
+    if (likely(cache)) {
+        mem->next = cache->list[idx];
+        cache->list[idx] = mem;
+        if (++cache->num[idx] < MT_BATCH_NUM * 2) {
+            mt_unlock(&cache->lock);
+            return;
+        }
+        /* the cache is full, move a batch to the depot */
+        for (last = mem, i = 1; i < MT_BATCH_NUM; i++) last = last->next;
+        cache->list[idx] = last->next;
+        cache->num[idx] -= MT_BATCH_NUM;
+        mt_unlock(&cache->lock);
+        last->next = NULL;
+    } else {
+        mem->next = NULL;
+    }
+    mt_depot_push(&ctx->depot[idx], mem, mem);
+}
 
-    doc->alc = *alc;
-    doc->str_pool.chunk_size = YYJSON_MUT_DOC_STR_POOL_INIT_SIZE;
-    doc->str_pool.chunk_size_max = YYJSON_MUT_DOC_STR_POOL_MAX_SIZE;
-    doc->val_pool.chunk_size = YYJSON_MUT_DOC_VAL_POOL_INIT_SIZE;
-    doc->val_pool.chunk_size_max = YYJSON_MUT_DOC_VAL_POOL_MAX_SIZE;
-    return doc;
+static void *mt_realloc(void *ctx_ptr, void *ptr,
+                        usize old_size, usize size) {
+    /* assert(ptr != NULL && size != 0 && old_size < size) */
+    mt_chunk *chunk = (mt_chunk *)ptr - 1;
+    void *new_ptr;
+    if (size <= ((usize)1 << chunk->cls) - sizeof(mt_chunk)) return ptr;
+    new_ptr = mt_malloc(ctx_ptr, size);
+    if (likely(new_ptr)) {
+        memcpy(new_ptr, ptr, old_size);
+        mt_free(ctx_ptr, ptr);
+    }
+    return new_ptr;
 }
 
-yyjson_mut_doc *yyjson_doc_mut_copy(const yyjson_doc *doc,
-                                    const yyjson_alc *alc) {
-    yyjson_mut_doc *m_doc;
-    yyjson_mut_val *m_val;
+#endif /* YYJSON_HAS_ATOMIC */
 
-    if (!doc || !doc->root) return NULL;
-    m_doc = yyjson_mut_doc_new(alc);
-    if (!m_doc) return NULL;
-    m_val = yyjson_val_mut_copy(m_doc, doc->root);
-    if (!m_val) {
-        yyjson_mut_doc_free(m_doc);
-        return NULL;
+yyjson_alc *yyjson_alc_mt_new(usize cache_num) {
+#if YYJSON_HAS_ATOMIC
+    const yyjson_alc def = YYJSON_DEFAULT_ALC;
+    usize hdr_len;
+    yyjson_alc *alc;
+    mt_ctx *ctx;
+    if (!cache_num) cache_num = MT_CACHE_DEF;
+    if (cache_num > MT_CACHE_MAX) cache_num = MT_CACHE_MAX;
+    hdr_len = sizeof(yyjson_alc) + sizeof(mt_ctx);
+    hdr_len += sizeof(mt_cache) * cache_num;
+    alc = (yyjson_alc *)def.malloc(def.ctx, hdr_len);
+    if (unlikely(!alc)) return NULL;
+    memset((void *)(alc + 1), 0, hdr_len - sizeof(yyjson_alc));
+    ctx = (mt_ctx *)(void *)(alc + 1);
+    ctx->caches = (mt_cache *)(void *)(ctx + 1);
+    ctx->cache_num = cache_num;
+    alc->malloc = mt_malloc;
+    alc->realloc = mt_realloc;
+    alc->free = mt_free;
+    alc->ctx = (void *)ctx;
+    return alc;
+#else
+    return NULL;
+#endif
+}
+
+void yyjson_alc_mt_free(yyjson_alc *alc) {
+#if YYJSON_HAS_ATOMIC
+    const yyjson_alc def = YYJSON_DEFAULT_ALC;
+    mt_ctx *ctx;
+    mt_chunk *chunk, *next;
+    if (unlikely(!alc)) return;
+    ctx = (mt_ctx *)alc->ctx;
+    for (chunk = (mt_chunk *)ctx->all; chunk; chunk = next) {
+        next = chunk->all;
+        def.free(def.ctx, chunk);
     }
-    yyjson_mut_doc_set_root(m_doc, m_val);
-    return m_doc;
+    def.free(def.ctx, alc);
+#endif
 }
 
-yyjson_mut_doc *yyjson_mut_doc_mut_copy(const yyjson_mut_doc *doc,
-                                        const yyjson_alc *alc) {
-    yyjson_mut_doc *m_doc;
-    yyjson_mut_val *m_val;
-
-    if (!doc) return NULL;
-    if (!doc->root) return yyjson_mut_doc_new(alc);
 
-    m_doc = yyjson_mut_doc_new(alc);
-    if (!m_doc) return NULL;
-    m_val = yyjson_mut_val_mut_copy(m_doc, doc->root);
-    if (!m_val) {
-        yyjson_mut_doc_free(m_doc);
-        return NULL;
-    }
-    yyjson_mut_doc_set_root(m_doc, m_val);
-    return m_doc;
-}
 
-yyjson_mut_val *yyjson_val_mut_copy(yyjson_mut_doc *m_doc,
-                                    const yyjson_val *i_vals) {
-    /*
-     The immutable object or array stores all sub-values in a contiguous memory,
-     We copy them to another contiguous memory as mutable values,
-     then reconnect the mutable values with the original relationship.
-     */
-    usize i_vals_len;
-    yyjson_mut_val *m_vals, *m_val;
-    yyjson_val *i_val, *i_end;
+/*==============================================================================
+ * MARK: - Limited Memory Allocator (Public)
+ * This allocator wraps another allocator. It counts the memory in use and
+ * fails the allocations that would exceed the limit. Each chunk has a header
+ * to record its size, as free() does not know the size.
+ *============================================================================*/
 
-    if (!m_doc || !i_vals) return NULL;
-    i_end = unsafe_yyjson_get_next(i_vals);
-    i_vals_len = (usize)(unsafe_yyjson_get_next(i_vals) - i_vals);
-    m_vals = unsafe_yyjson_mut_val(m_doc, i_vals_len);
-    if (!m_vals) return NULL;
-    i_val = constcast(yyjson_val *)i_vals;
-    m_val = m_vals;
+/** memory chunk header, two words to keep the alignment of the base */
+typedef struct limit_chunk {
+    usize size; /* requested size, not including header */
+    usize reserved;
+    /* char mem[]; flexible array member */
+} limit_chunk;
 
-    for (; i_val < i_end; i_val++, m_val++) {
-        yyjson_type type = unsafe_yyjson_get_type(i_val);
-        m_val->tag = i_val->tag;
-        m_val->uni.u64 = i_val->uni.u64;
-        if (type == YYJSON_TYPE_STR || type == YYJSON_TYPE_RAW) {
-            const char *str = i_val->uni.str;
-            usize str_len = unsafe_yyjson_get_len(i_val);
-            m_val->uni.str = unsafe_yyjson_mut_strncpy(m_doc, str, str_len);
-            if (!m_val->uni.str) return NULL;
-        } else if (type == YYJSON_TYPE_ARR) {
-            usize len = unsafe_yyjson_get_len(i_val);
-            if (len > 0) {
-                yyjson_val *ii_val = i_val + 1, *ii_next;
-                yyjson_mut_val *mm_val = m_val + 1, *mm_ctn = m_val, *mm_next;
-                while (len-- > 1) {
-                    ii_next = unsafe_yyjson_get_next(ii_val);
-                    mm_next = mm_val + (ii_next - ii_val);
-                    mm_val->next = mm_next;
-                    ii_val = ii_next;
-                    mm_val = mm_next;
-                }
-                mm_val->next = mm_ctn + 1;
-                mm_ctn->uni.ptr = mm_val;
-            }
-        } else if (type == YYJSON_TYPE_OBJ) {
-            usize len = unsafe_yyjson_get_len(i_val);
-            if (len > 0) {
-                yyjson_val *ii_key = i_val + 1, *ii_nextkey;
-                yyjson_mut_val *mm_key = m_val + 1, *mm_ctn = m_val;
-                yyjson_mut_val *mm_nextkey;
-                while (len-- > 1) {
-                    ii_nextkey = unsafe_yyjson_get_next(ii_key + 1);
-                    mm_nextkey = mm_key + (ii_nextkey - ii_key);
-                    mm_key->next = mm_key + 1;
-                    mm_key->next->next = mm_nextkey;
-                    ii_key = ii_nextkey;
-                    mm_key = mm_nextkey;
-                }
-                mm_key->next = mm_key + 1;
-                mm_key->next->next = mm_ctn + 1;
-                mm_ctn->uni.ptr = mm_key;
-            }
-        }
-    }
-    return m_vals;
+/** Returns whether the memory in use can be increased by `inc` bytes. */
+static_inline bool limit_check(yyjson_alc_limit *lim, usize inc) {
+    if (likely(lim->cur_size <= lim->limit &&
+               inc <= lim->limit - lim->cur_size)) return true;
+    lim->fail_count++;
+    return false;
 }
 
-static yyjson_mut_val *unsafe_yyjson_mut_val_mut_copy(
-    yyjson_mut_doc *m_doc, const yyjson_mut_val *m_vals) {
-    /*
-     The mutable object or array stores all sub-values in a circular linked
-     list, so we can traverse them in the same loop. The traversal starts from
-     the last item, continues with the first item in a list, and ends with the
-     second to last item, which needs to be linked to the last item to close the
-     circle.
-     */
-    yyjson_mut_val *m_val = unsafe_yyjson_mut_val(m_doc, 1);
-    if (unlikely(!m_val)) return NULL;
-    m_val->tag = m_vals->tag;
-
-    switch (unsafe_yyjson_get_type(m_vals)) {
-        case YYJSON_TYPE_OBJ:
-        case YYJSON_TYPE_ARR:
-            if (unsafe_yyjson_get_len(m_vals) > 0) {
-                yyjson_mut_val *last = (yyjson_mut_val *)m_vals->uni.ptr;
-                yyjson_mut_val *next = last->next, *prev;
-                prev = unsafe_yyjson_mut_val_mut_copy(m_doc, last);
-                if (!prev) return NULL;
-                m_val->uni.ptr = (void *)prev;
-                while (next != last) {
-                    prev->next = unsafe_yyjson_mut_val_mut_copy(m_doc, next);
-                    if (!prev->next) return NULL;
-                    prev = prev->next;
-                    next = next->next;
-                }
-                prev->next = (yyjson_mut_val *)m_val->uni.ptr;
-            }
-            break;
-        case YYJSON_TYPE_RAW:
-        case YYJSON_TYPE_STR: {
-            const char *str = m_vals->uni.str;
-            usize str_len = unsafe_yyjson_get_len(m_vals);
-            m_val->uni.str = unsafe_yyjson_mut_strncpy(m_doc, str, str_len);
-            if (!m_val->uni.str) return NULL;
-            break;
-        }
-        default:
-            m_val->uni = m_vals->uni;
-            break;
-    }
-    return m_val;
+/** Update the statistics after a successful allocation. */
+static_inline void limit_update(yyjson_alc_limit *lim, usize cur_size) {
+    lim->cur_size = cur_size;
+    if (lim->peak_size < cur_size) lim->peak_size = cur_size;
+    lim->alloc_count++;
 }
 
-yyjson_mut_val *yyjson_mut_val_mut_copy(yyjson_mut_doc *doc,
-                                        const yyjson_mut_val *val) {
-    if (doc && val) return unsafe_yyjson_mut_val_mut_copy(doc, val);
-    return NULL;
+static void *limit_malloc(void *ctx_ptr, usize size) {
+    yyjson_alc_limit *lim = (yyjson_alc_limit *)ctx_ptr;
+    limit_chunk *chunk;
+    if (unlikely(!limit_check(lim, size))) return NULL;
+    if (unlikely(size_add_is_overflow(size, sizeof(limit_chunk)))) return NULL;
+    chunk = (limit_chunk *)lim->base.malloc(lim->base.ctx,
+                                            size + sizeof(limit_chunk));
+    if (unlikely(!chunk)) return NULL;
+    chunk->size = size;
+    limit_update(lim, lim->cur_size + size);
+    return (void *)(chunk + 1);
 }
 
-/* Count the number of values and the total length of the strings. */
-static void yyjson_mut_stat(const yyjson_mut_val *val,
-                            usize *val_sum, usize *str_sum) {
-    yyjson_type type = unsafe_yyjson_get_type(val);
-    *val_sum += 1;
-    if (type == YYJSON_TYPE_ARR || type == YYJSON_TYPE_OBJ) {
-        yyjson_mut_val *child = (yyjson_mut_val *)val->uni.ptr;
-        usize len = unsafe_yyjson_get_len(val), i;
-        len <<= (u8)(type == YYJSON_TYPE_OBJ);
-        *val_sum += len;
-        for (i = 0; i < len; i++) {
-            yyjson_type stype = unsafe_yyjson_get_type(child);
-            if (stype == YYJSON_TYPE_STR || stype == YYJSON_TYPE_RAW) {
-                *str_sum += unsafe_yyjson_get_len(child) + 1;
-            } else if (stype == YYJSON_TYPE_ARR || stype == YYJSON_TYPE_OBJ) {
-                yyjson_mut_stat(child, val_sum, str_sum);
-                *val_sum -= 1;
-            }
-            child = child->next;
-        }
-    } else if (type == YYJSON_TYPE_STR || type == YYJSON_TYPE_RAW) {
-        *str_sum += unsafe_yyjson_get_len(val) + 1;
-    }
+static void *limit_realloc(void *ctx_ptr, void *ptr,
+                           usize old_size, usize size) {
+    yyjson_alc_limit *lim = (yyjson_alc_limit *)ctx_ptr;
+    limit_chunk *chunk = (limit_chunk *)ptr - 1, *new_chunk;
+    usize old = chunk->size;
+    if (size > old && unlikely(!limit_check(lim, size - old))) return NULL;
+    if (unlikely(size_add_is_overflow(size, sizeof(limit_chunk)))) return NULL;
+    new_chunk = (limit_chunk *)lim->base.realloc(lim->base.ctx, chunk,
+                                                 old + sizeof(limit_chunk),
+                                                 size + sizeof(limit_chunk));
+    if (unlikely(!new_chunk)) return NULL;
+    new_chunk->size = size;
+    limit_update(lim, lim->cur_size - old + size);
+    return (void *)(new_chunk + 1);
 }
 
-/* Copy mutable values to immutable value pool. */
-static usize yyjson_imut_copy(yyjson_val **val_ptr, char **buf_ptr,
-                              const yyjson_mut_val *mval) {
-    yyjson_val *val = *val_ptr;
-    yyjson_type type = unsafe_yyjson_get_type(mval);
-    if (type == YYJSON_TYPE_ARR || type == YYJSON_TYPE_OBJ) {
-        yyjson_mut_val *child = (yyjson_mut_val *)mval->uni.ptr;
-        usize len = unsafe_yyjson_get_len(mval), i;
-        usize val_sum = 1;
-        if (type == YYJSON_TYPE_OBJ) {
-            if (len) child = child->next->next;
-            len <<= 1;
-        } else {
-            if (len) child = child->next;
-        }
-        *val_ptr = val + 1;
-        for (i = 0; i < len; i++) {
-            val_sum += yyjson_imut_copy(val_ptr, buf_ptr, child);
-            child = child->next;
-        }
-        val->tag = mval->tag;
-        val->uni.ofs = val_sum * sizeof(yyjson_val);
-        return val_sum;
-    } else if (type == YYJSON_TYPE_STR || type == YYJSON_TYPE_RAW) {
-        char *buf = *buf_ptr;
-        usize len = unsafe_yyjson_get_len(mval);
-        memcpy((void *)buf, (const void *)mval->uni.str, len);
-        buf[len] = '\0';
-        val->tag = mval->tag;
-        val->uni.str = buf;
-        *val_ptr = val + 1;
-        *buf_ptr = buf + len + 1;
-        return 1;
-    } else {
-        val->tag = mval->tag;
-        val->uni = mval->uni;
-        *val_ptr = val + 1;
-        return 1;
-    }
+static void limit_free(void *ctx_ptr, void *ptr) {
+    yyjson_alc_limit *lim = (yyjson_alc_limit *)ctx_ptr;
+    limit_chunk *chunk = (limit_chunk *)ptr - 1;
+    lim->cur_size -= chunk->size;
+    lim->base.free(lim->base.ctx, chunk);
 }
 
-yyjson_doc *yyjson_mut_doc_imut_copy(const yyjson_mut_doc *mdoc,
-                                     const yyjson_alc *alc) {
-    if (!mdoc) return NULL;
-    return yyjson_mut_val_imut_copy(mdoc->root, alc);
+bool yyjson_alc_limit_init(yyjson_alc *alc, yyjson_alc_limit *lim,
+                           const yyjson_alc *base, usize limit) {
+    if (unlikely(!alc)) return false;
+    *alc = YYJSON_NULL_ALC;
+    if (unlikely(!lim)) return false;
+    memset(lim, 0, sizeof(yyjson_alc_limit));
+    lim->base = base ? *base : YYJSON_DEFAULT_ALC;
+    lim->limit = limit;
+    alc->malloc = limit_malloc;
+    alc->realloc = limit_realloc;
+    alc->free = limit_free;
+    alc->ctx = (void *)lim;
+    return true;
 }
 
-yyjson_doc *yyjson_mut_val_imut_copy(const yyjson_mut_val *mval,
-                                     const yyjson_alc *alc) {
-    usize val_num = 0, str_sum = 0, hdr_size, buf_size;
-    yyjson_doc *doc = NULL;
-    yyjson_val *val_hdr = NULL;
 
-    /* This value should be NULL here. Setting a non-null value suppresses
-       warning from the clang analyzer. */
-    char *str_hdr = (char *)(void *)&str_sum;
-    if (!mval) return NULL;
-    if (!alc) alc = &YYJSON_DEFAULT_ALC;
 
-    /* traverse the input value to get pool size */
-    yyjson_mut_stat(mval, &val_num, &str_sum);
+/*==============================================================================
+ * MARK: - Arena Memory Allocator (Public)
+ * This allocator reserves a large memory region at once, and allocates memory
+ * from it by bumping an offset. Only the last allocation can be resized in
+ * place or released, the other memory is reused after the allocator is reset.
+ *
+ * On Linux, the region can be backed by huge pages to reduce the TLB misses
+ * when accessing a large document, and can be placed on a NUMA node with the
+ * `mbind()` system call (libnuma is not required).
+ *============================================================================*/
 
-    /* create doc and val pool */
-    hdr_size = size_align_up(sizeof(yyjson_doc), sizeof(yyjson_val));
-    buf_size = hdr_size + val_num * sizeof(yyjson_val);
-    doc = (yyjson_doc *)alc->malloc(alc->ctx, buf_size);
-    if (!doc) return NULL;
-    memset(doc, 0, sizeof(yyjson_doc));
-    val_hdr = (yyjson_val *)(void *)((char *)(void *)doc + hdr_size);
-    doc->root = val_hdr;
-    doc->alc = *alc;
+/** The size of huge pages, also the alignment of the region for huge pages. */
+#define ARENA_HUGE_SIZE ((usize)2 << 20)
+/** The alignment of each allocation. */
+#define ARENA_ALIGN 16
+/** The maximum NUMA node number supported. */
+#define ARENA_NODE_MAX 256
 
-    /* create str pool */
-    if (str_sum > 0) {
-        str_hdr = (char *)alc->malloc(alc->ctx, str_sum);
-        doc->str_pool = str_hdr;
-        if (!str_hdr) {
-            alc->free(alc->ctx, (void *)doc);
-            return NULL;
-        }
+#if YYJSON_HAS_MMAP && defined(MAP_ANONYMOUS)
+#   define YYJSON_HAS_ARENA_MMAP 1
+#else
+#   define YYJSON_HAS_ARENA_MMAP 0
+#endif
+
+/* syscall() is only declared with the default or GNU/BSD features */
+#if YYJSON_HAS_ARENA_MMAP && defined(__linux__) && defined(SYS_mbind) && \
+    (defined(_DEFAULT_SOURCE) || defined(_BSD_SOURCE) || defined(_GNU_SOURCE))
+#   define YYJSON_HAS_MBIND 1
+#else
+#   define YYJSON_HAS_MBIND 0
+#endif
+
+/** allocator ctx header */
+typedef struct arena_ctx {
+    u8 *hdr; /* the beginning of the region */
+    usize size; /* the size of the region */
+    usize used; /* the end of the last allocation */
+    usize last; /* the beginning of the last allocation */
+    void *map; /* the mapped memory or the memory from the default allocator */
+    usize map_len; /* the length of the mapping, 0 if not mapped */
+    yyjson_arena_flag flg; /* the options that took effect */
+} arena_ctx;
+
+static void *arena_malloc(void *ctx_ptr, usize size) {
+    /* assert(size != 0) */
+    arena_ctx *ctx = (arena_ctx *)ctx_ptr;
+    usize pos = size_align_up(ctx->used, ARENA_ALIGN);
+    if (unlikely(pos > ctx->size || size > ctx->size - pos)) return NULL;
+    ctx->last = pos;
+    ctx->used = pos + size;
+    return (void *)(ctx->hdr + pos);
+}
+
+static void *arena_realloc(void *ctx_ptr, void *ptr,
+                           usize old_size, usize size) {
+    /* assert(ptr != NULL && size != 0 && old_size < size) */
+    arena_ctx *ctx = (arena_ctx *)ctx_ptr;
+    void *new_ptr;
+    if ((u8 *)ptr == ctx->hdr + ctx->last) {
+        /* resize the last allocation in place */
+        if (unlikely(size > ctx->size - ctx->last)) return NULL;
+        ctx->used = ctx->last + size;
+        return ptr;
     }
+    new_ptr = arena_malloc(ctx_ptr, size);
+    if (likely(new_ptr)) memcpy(new_ptr, ptr, old_size);
+    return new_ptr;
+}
 
-    /* copy vals and strs */
-    doc->val_read = yyjson_imut_copy(&val_hdr, &str_hdr, mval);
-    doc->dat_read = str_sum + 1;
-    return doc;
+static void arena_free(void *ctx_ptr, void *ptr) {
+    /* assert(ptr != NULL) */
+    arena_ctx *ctx = (arena_ctx *)ctx_ptr;
+    if ((u8 *)ptr == ctx->hdr + ctx->last) ctx->used = ctx->last;
 }
 
-static_inline bool unsafe_yyjson_num_equals(const void *lhs, const void *rhs) {
-    const yyjson_val_uni *luni = &((const yyjson_val *)lhs)->uni;
-    const yyjson_val_uni *runi = &((const yyjson_val *)rhs)->uni;
-    yyjson_subtype lt = unsafe_yyjson_get_subtype(lhs);
-    yyjson_subtype rt = unsafe_yyjson_get_subtype(rhs);
-    if (lt == rt) return luni->u64 == runi->u64;
-    if (lt == YYJSON_SUBTYPE_SINT && rt == YYJSON_SUBTYPE_UINT) {
-        return luni->i64 >= 0 && luni->u64 == runi->u64;
+#if YYJSON_HAS_ARENA_MMAP
+/** Map the region with the options, returns false on failure. */
+static bool arena_map(arena_ctx *ctx, usize size,
+                      yyjson_arena_flag flg, u32 node) {
+    const int prot = PROT_READ | PROT_WRITE;
+    int map_flg = MAP_PRIVATE | MAP_ANONYMOUS;
+    bool huge = (flg & (YYJSON_ARENA_HUGE_PAGE | YYJSON_ARENA_HUGETLB)) != 0;
+    void *map = MAP_FAILED;
+    usize len = size, map_size = size;
+
+#ifdef MAP_NORESERVE
+    map_flg |= MAP_NORESERVE; /* the pages are only used when touched */
+#endif
+    if (huge) {
+        map_size = size_align_up(size, ARENA_HUGE_SIZE);
+        if (map_size < size ||
+            size_add_is_overflow(map_size, ARENA_HUGE_SIZE)) return false;
+    }
+#ifdef MAP_HUGETLB
+    if (flg & YYJSON_ARENA_HUGETLB) {
+        /* explicit huge pages, fails if not enough pages are reserved
+           (with MAP_NORESERVE, it would raise SIGBUS when touched instead) */
+        len = map_size;
+        map = mmap(NULL, len, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                   -1, 0);
+        if (map != MAP_FAILED) {
+            ctx->hdr = (u8 *)map;
+            ctx->flg |= YYJSON_ARENA_HUGETLB;
+        }
     }
-    if (lt == YYJSON_SUBTYPE_UINT && rt == YYJSON_SUBTYPE_SINT) {
-        return runi->i64 >= 0 && luni->u64 == runi->u64;
+#endif
+    if (map == MAP_FAILED) {
+        /* regular pages, the region is aligned for transparent huge pages */
+        len = huge ? map_size + ARENA_HUGE_SIZE : size;
+        map = mmap(NULL, len, prot, map_flg, -1, 0);
+        if (map == MAP_FAILED) return false;
+        ctx->hdr = (u8 *)(huge ? mem_align_up(map, ARENA_HUGE_SIZE) : map);
+#ifdef MADV_HUGEPAGE
+        if (huge && madvise((void *)ctx->hdr, map_size, MADV_HUGEPAGE) == 0) {
+            ctx->flg |= YYJSON_ARENA_HUGE_PAGE;
+        }
+#endif
     }
-    return false;
+#if YYJSON_HAS_MBIND
+    if ((flg & YYJSON_ARENA_NUMA_NODE) && node < ARENA_NODE_MAX) {
+        /* prefer the node, and fall back to other nodes if it is full */
+        const unsigned long bits = sizeof(unsigned long) * 8;
+        const int mpol_preferred = 1;
+        unsigned long mask[ARENA_NODE_MAX / (sizeof(unsigned long) * 8)];
+        memset(mask, 0, sizeof(mask));
+        mask[node / bits] |= 1UL << (node % bits);
+        if (syscall(SYS_mbind, (void *)ctx->hdr, (unsigned long)map_size,
+                    mpol_preferred, mask, (unsigned long)ARENA_NODE_MAX + 1,
+                    0U) == 0) {
+            ctx->flg |= YYJSON_ARENA_NUMA_NODE;
+        }
+    }
+#endif
+    ctx->size = size;
+    ctx->map = map;
+    ctx->map_len = len;
+    return true;
 }
+#endif
 
-static_inline bool unsafe_yyjson_str_equals(const void *lhs, const void *rhs) {
-    usize len = unsafe_yyjson_get_len(lhs);
-    if (len != unsafe_yyjson_get_len(rhs)) return false;
-    return !memcmp(unsafe_yyjson_get_str(lhs),
-                   unsafe_yyjson_get_str(rhs), len);
+yyjson_alc *yyjson_alc_arena_new(usize size, yyjson_arena_flag flg, u32 node) {
+    const yyjson_alc def = YYJSON_DEFAULT_ALC;
+    usize hdr_len = sizeof(yyjson_alc) + sizeof(arena_ctx);
+    yyjson_alc *alc;
+    arena_ctx *ctx;
+    if (unlikely(!size)) return NULL;
+    alc = (yyjson_alc *)def.malloc(def.ctx, hdr_len);
+    if (unlikely(!alc)) return NULL;
+    ctx = (arena_ctx *)(void *)(alc + 1);
+    memset(ctx, 0, sizeof(*ctx));
+#if YYJSON_HAS_ARENA_MMAP
+    if (!arena_map(ctx, size, flg, node))
+#endif
+    {
+        /* fall back to the default allocator */
+        ctx->flg = 0;
+        ctx->map = def.malloc(def.ctx, size);
+        if (unlikely(!ctx->map)) {
+            def.free(def.ctx, alc);
+            return NULL;
+        }
+        ctx->hdr = (u8 *)ctx->map;
+        ctx->size = size;
+    }
+    alc->malloc = arena_malloc;
+    alc->realloc = arena_realloc;
+    alc->free = arena_free;
+    alc->ctx = (void *)ctx;
+    return alc;
 }
 
-bool unsafe_yyjson_equals(const yyjson_val *lhs, const yyjson_val *rhs) {
-    yyjson_type type = unsafe_yyjson_get_type(lhs);
-    if (type != unsafe_yyjson_get_type(rhs)) return false;
+void yyjson_alc_arena_reset(yyjson_alc *alc) {
+    arena_ctx *ctx;
+    if (unlikely(!alc || alc->malloc != arena_malloc)) return;
+    ctx = (arena_ctx *)alc->ctx;
+    ctx->used = 0;
+    ctx->last = 0;
+}
 
-    switch (type) {
-        case YYJSON_TYPE_OBJ: {
-            usize len = unsafe_yyjson_get_len(lhs);
-            if (len != unsafe_yyjson_get_len(rhs)) return false;
-            if (len > 0) {
-                yyjson_obj_iter iter;
-                yyjson_obj_iter_init(rhs, &iter);
-                lhs = unsafe_yyjson_get_first(lhs);
-                while (len-- > 0) {
-                    rhs = yyjson_obj_iter_getn(&iter, lhs->uni.str,
-                                               unsafe_yyjson_get_len(lhs));
-                    if (!rhs) return false;
-                    if (!unsafe_yyjson_equals(lhs + 1, rhs)) return false;
-                    lhs = unsafe_yyjson_get_next(lhs + 1);
-                }
-            }
-            /* yyjson allows duplicate keys, so the check may be inaccurate */
-            return true;
-        }
+yyjson_arena_flag yyjson_alc_arena_get_flag(const yyjson_alc *alc) {
+    if (unlikely(!alc || alc->malloc != arena_malloc)) return 0;
+    return ((const arena_ctx *)alc->ctx)->flg;
+}
 
-        case YYJSON_TYPE_ARR: {
-            usize len = unsafe_yyjson_get_len(lhs);
-            if (len != unsafe_yyjson_get_len(rhs)) return false;
-            if (len > 0) {
-                lhs = unsafe_yyjson_get_first(lhs);
-                rhs = unsafe_yyjson_get_first(rhs);
-                while (len-- > 0) {
-                    if (!unsafe_yyjson_equals(lhs, rhs)) return false;
-                    lhs = unsafe_yyjson_get_next(lhs);
-                    rhs = unsafe_yyjson_get_next(rhs);
-                }
-            }
-            return true;
-        }
+void yyjson_alc_arena_free(yyjson_alc *alc) {
+    const yyjson_alc def = YYJSON_DEFAULT_ALC;
+    arena_ctx *ctx;
+    if (unlikely(!alc)) return;
+    ctx = (arena_ctx *)alc->ctx;
+#if YYJSON_HAS_ARENA_MMAP
+    if (ctx->map_len) munmap(ctx->map, ctx->map_len);
+    else
+#endif
+    def.free(def.ctx, ctx->map);
+    def.free(def.ctx, alc);
+}
 
-        case YYJSON_TYPE_NUM:
-            return unsafe_yyjson_num_equals(lhs, rhs);
 
-        case YYJSON_TYPE_RAW:
-        case YYJSON_TYPE_STR:
-            return unsafe_yyjson_str_equals(lhs, rhs);
 
-        case YYJSON_TYPE_NULL:
-        case YYJSON_TYPE_BOOL:
-            return lhs->tag == rhs->tag;
+/*==============================================================================
+ * MARK: - JSON Struct Utils (Public)
+ * These functions are used for creating, copying, releasing, and comparing
+ * JSON documents and values. They are widely used throughout this library.
+ *============================================================================*/
 
-        default:
-            return false;
+static_inline void unsafe_yyjson_str_pool_release(yyjson_str_pool *pool,
+                                                  yyjson_alc *alc) {
+    yyjson_str_chunk *chunk = pool->chunks, *next;
+    while (chunk) {
+        next = chunk->next;
+        alc->free(alc->ctx, chunk);
+        chunk = next;
     }
+#if YYJSON_MUT_COMPACT
+    if (pool->pages) alc->free(alc->ctx, (void *)pool->pages);
+#endif
 }
 
-bool unsafe_yyjson_mut_equals(const yyjson_mut_val *lhs,
-                              const yyjson_mut_val *rhs) {
-    yyjson_type type = unsafe_yyjson_get_type(lhs);
-    if (type != unsafe_yyjson_get_type(rhs)) return false;
-
-    switch (type) {
-        case YYJSON_TYPE_OBJ: {
-            usize len = unsafe_yyjson_get_len(lhs);
-            if (len != unsafe_yyjson_get_len(rhs)) return false;
-            if (len > 0) {
-                yyjson_mut_obj_iter iter;
-                yyjson_mut_obj_iter_init(constcast(yyjson_mut_val *)rhs, &iter);
-                lhs = (yyjson_mut_val *)lhs->uni.ptr;
-                while (len-- > 0) {
-                    rhs = yyjson_mut_obj_iter_getn(&iter, lhs->uni.str,
-                                                   unsafe_yyjson_get_len(lhs));
-                    if (!rhs) return false;
-                    if (!unsafe_yyjson_mut_equals(lhs->next, rhs)) return false;
-                    lhs = lhs->next->next;
-                }
-            }
-            /* yyjson allows duplicate keys, so the check may be inaccurate */
-            return true;
-        }
-
-        case YYJSON_TYPE_ARR: {
-            usize len = unsafe_yyjson_get_len(lhs);
-            if (len != unsafe_yyjson_get_len(rhs)) return false;
-            if (len > 0) {
-                lhs = (yyjson_mut_val *)lhs->uni.ptr;
-                rhs = (yyjson_mut_val *)rhs->uni.ptr;
-                while (len-- > 0) {
-                    if (!unsafe_yyjson_mut_equals(lhs, rhs)) return false;
-                    lhs = lhs->next;
-                    rhs = rhs->next;
-                }
-            }
-            return true;
-        }
-
-        case YYJSON_TYPE_NUM:
-            return unsafe_yyjson_num_equals(lhs, rhs);
-
-        case YYJSON_TYPE_RAW:
-        case YYJSON_TYPE_STR:
-            return unsafe_yyjson_str_equals(lhs, rhs);
-
-        case YYJSON_TYPE_NULL:
-        case YYJSON_TYPE_BOOL:
-            return lhs->tag == rhs->tag;
+static_inline void unsafe_yyjson_val_pool_release(yyjson_val_pool *pool,
+                                                  yyjson_alc *alc) {
+    yyjson_val_chunk *chunk = pool->chunks, *next;
+    while (chunk) {
+        next = chunk->next;
+        alc->free(alc->ctx, chunk);
+        chunk = next;
+    }
+#if YYJSON_MUT_COMPACT
+    if (pool->pages) alc->free(alc->ctx, (void *)pool->pages);
+#endif
+}
 
-        default:
-            return false;
+#if YYJSON_MUT_COMPACT
+/*
+ Ensures the capacity of a page table (an array of pointers) to at least
+ `num` pages, returns the new table or NULL on allocation failure.
+ The page tables map the 32-bit indexes of compact mutable values to memory.
+ */
+static void *unsafe_yyjson_page_table_grow(void *pages, usize *cap, usize num,
+                                           const yyjson_alc *alc) {
+    usize new_cap = *cap ? *cap : 16;
+    while (new_cap < num) new_cap *= 2;
+    if (new_cap == *cap) return pages;
+    if (pages) {
+        pages = alc->realloc(alc->ctx, pages, *cap * sizeof(void *),
+                             new_cap * sizeof(void *));
+    } else {
+        pages = alc->malloc(alc->ctx, new_cap * sizeof(void *));
     }
+    if (pages) *cap = new_cap;
+    return pages;
 }
+#endif
 
-bool yyjson_locate_pos(const char *str, size_t len, size_t pos,
-                       size_t *line, size_t *col, size_t *chr) {
-    usize line_sum = 0, line_pos = 0, chr_sum = 0;
-    const u8 *cur = (const u8 *)str;
-    const u8 *end = cur + pos;
+bool unsafe_yyjson_str_pool_grow(yyjson_str_pool *pool,
+                                 const yyjson_alc *alc, usize len) {
+    yyjson_str_chunk *chunk;
+    usize size, max_len;
+#if YYJSON_MUT_COMPACT
+    usize data, num, i;
+    char **pages;
+#endif
 
-    if (!str || pos > len) {
-        if (line) *line = 0;
-        if (col) *col = 0;
-        if (chr) *chr = 0;
-        return false;
-    }
+    /* create a new chunk */
+    max_len = USIZE_MAX - sizeof(yyjson_str_chunk);
+    if (unlikely(len > max_len)) return false;
+    size = len + sizeof(yyjson_str_chunk);
+    size = yyjson_max(pool->chunk_size, size);
+#if YYJSON_MUT_COMPACT
+    /* the string offsets of the new chunk should fit in 32 bits */
+    data = size - sizeof(yyjson_str_chunk);
+    num = (data + ((usize)1 << YYJSON_MUT_STR_PAGE_BIT) - 1) >>
+          YYJSON_MUT_STR_PAGE_BIT;
+    if (unlikely(((u64)pool->page_num << YYJSON_MUT_STR_PAGE_BIT) +
+                 (u64)data > U32(0xFFFFFFFF))) return false;
+    pages = (char **)unsafe_yyjson_page_table_grow(
+        (void *)pool->pages, &pool->page_cap, pool->page_num + num, alc);
+    if (unlikely(!pages)) return false;
+    pool->pages = pages;
+#endif
+    chunk = (yyjson_str_chunk *)alc->malloc(alc->ctx, size);
+    if (unlikely(!chunk)) return false;
 
-    if (pos >= 3 && is_utf8_bom(cur)) cur += 3; /* don't count BOM */
-    while (cur < end) {
-        u8 c = *cur;
-        chr_sum += 1;
-        if (likely(c < 0x80)) {         /* 0xxxxxxx (0x00-0x7F) ASCII */
-            if (c == '\n') {
-                line_sum += 1;
-                line_pos = chr_sum;
-            }
-            cur += 1;
-        }
-        else if (c < 0xC0) cur += 1;    /* 10xxxxxx (0x80-0xBF) Invalid */
-        else if (c < 0xE0) cur += 2;    /* 110xxxxx (0xC0-0xDF) 2-byte UTF-8 */
-        else if (c < 0xF0) cur += 3;    /* 1110xxxx (0xE0-0xEF) 3-byte UTF-8 */
-        else if (c < 0xF8) cur += 4;    /* 11110xxx (0xF0-0xF7) 4-byte UTF-8 */
-        else               cur += 1;    /* 11111xxx (0xF8-0xFF) Invalid */
+    /* insert the new chunk as the head of the linked list */
+    chunk->next = pool->chunks;
+    chunk->chunk_size = size;
+    pool->chunks = chunk;
+    pool->cur = (char *)chunk + sizeof(yyjson_str_chunk);
+    pool->end = (char *)chunk + size;
+#if YYJSON_MUT_COMPACT
+    /* add the pages of the new chunk to the page table */
+    for (i = 0; i < num; i++) {
+        pages[pool->page_num + i] = pool->cur + (i << YYJSON_MUT_STR_PAGE_BIT);
     }
-    if (line) *line = line_sum + 1;
-    if (col) *col = chr_sum - line_pos + 1;
-    if (chr) *chr = chr_sum;
+    pool->end_ofs = (pool->page_num << YYJSON_MUT_STR_PAGE_BIT) + data;
+    pool->page_num += num;
+#endif
+
+    /* the next chunk is twice the size of the current one */
+    size = yyjson_min(pool->chunk_size * 2, pool->chunk_size_max);
+    if (size < pool->chunk_size) size = pool->chunk_size_max; /* overflow */
+    pool->chunk_size = size;
     return true;
 }
 
+bool unsafe_yyjson_val_pool_grow(yyjson_val_pool *pool,
+                                 const yyjson_alc *alc, usize count) {
+    yyjson_val_chunk *chunk;
+    usize size, max_count;
+#if YYJSON_MUT_COMPACT
+    usize slots, num, i;
+    yyjson_mut_val **pages;
+#endif
 
-
-#if !YYJSON_DISABLE_READER /* reader begin */
-
-/* Check read flag, avoids `always false` warning when disabled. */
-#define has_flg(_flg) unlikely(has_rflag(flg, YYJSON_READ_##_flg, 0))
-#define has_allow(_flg) unlikely(has_rflag(flg, YYJSON_READ_ALLOW_##_flg, 1))
-#define YYJSON_READ_ALLOW_TRIVIA (YYJSON_READ_ALLOW_COMMENTS | \
-                                  YYJSON_READ_ALLOW_EXT_WHITESPACE)
-static_inline bool has_rflag(yyjson_read_flag flg, yyjson_read_flag chk,
-                             bool non_standard) {
-#if YYJSON_DISABLE_NON_STANDARD
-    if (non_standard) return false;
+    /* create a new chunk */
+    max_count = USIZE_MAX / sizeof(yyjson_mut_val) - YYJSON_MUT_DOC_VAL_CHUNK_HDR;
+#if YYJSON_MUT_COMPACT
+    /* the slot offset in chunk is stored in the value's tag */
+    max_count = YYJSON_MUT_OFS_MASK + 1 - YYJSON_MUT_DOC_VAL_CHUNK_HDR;
 #endif
-    return (flg & chk) != 0;
-}
+    if (unlikely(count > max_count)) return false;
+    size = (count + YYJSON_MUT_DOC_VAL_CHUNK_HDR) * sizeof(yyjson_mut_val);
+    size = yyjson_max(pool->chunk_size, size);
+#if YYJSON_MUT_COMPACT
+    /* the value indexes of the new chunk should fit in 32 bits */
+    size = yyjson_min(size, YYJSON_MUT_DOC_VAL_POOL_MAX_SIZE);
+    slots = size / sizeof(yyjson_mut_val);
+    num = (slots + ((usize)1 << YYJSON_MUT_VAL_PAGE_BIT) - 1) >>
+          YYJSON_MUT_VAL_PAGE_BIT;
+    if (unlikely(((u64)pool->page_num << YYJSON_MUT_VAL_PAGE_BIT) +
+                 (u64)slots > U32(0xFFFFFFFF))) return false;
+    pages = (yyjson_mut_val **)unsafe_yyjson_page_table_grow(
+        (void *)pool->pages, &pool->page_cap, pool->page_num + num, alc);
+    if (unlikely(!pages)) return false;
+    pool->pages = pages;
+#endif
+    chunk = (yyjson_val_chunk *)alc->malloc(alc->ctx, size);
+    if (unlikely(!chunk)) return false;
 
+    /* insert the new chunk as the head of the linked list */
+    chunk->next = pool->chunks;
+    chunk->chunk_size = size;
+    pool->chunks = chunk;
+    pool->cur = (yyjson_mut_val *)(void *)((u8 *)chunk) +
+                YYJSON_MUT_DOC_VAL_CHUNK_HDR;
+    pool->end = (yyjson_mut_val *)(void *)((u8 *)chunk + size);
+#if YYJSON_MUT_COMPACT
+    /* add the pages of the new chunk to the page table */
+    for (i = 0; i < num; i++) {
+        pages[pool->page_num + i] = (yyjson_mut_val *)(void *)chunk +
+                                    (i << YYJSON_MUT_VAL_PAGE_BIT);
+    }
+    chunk->doc = pool->doc;
+    chunk->base = (u32)(pool->page_num << YYJSON_MUT_VAL_PAGE_BIT);
+    pool->page_num += num;
+#endif
 
+    /* the next chunk is twice the size of the current one */
+    size = yyjson_min(pool->chunk_size * 2, pool->chunk_size_max);
+    if (size < pool->chunk_size) size = pool->chunk_size_max; /* overflow */
+    pool->chunk_size = size;
+    return true;
+}
 
-/*==============================================================================
- * MARK: - JSON Reader Utils (Private)
- * These functions are used by JSON reader to read literals and comments.
- *============================================================================*/
+bool yyjson_mut_doc_set_str_pool_size(yyjson_mut_doc *doc, size_t len) {
+    usize max_size = USIZE_MAX - sizeof(yyjson_str_chunk);
+    if (!doc || !len || len > max_size) return false;
+    doc->str_pool.chunk_size = len + sizeof(yyjson_str_chunk);
+    return true;
+}
 
-/** Read `true` literal, `*ptr[0]` should be `t`. */
-static_inline bool read_true(u8 **ptr, yyjson_val *val) {
-    u8 *cur = *ptr;
-    if (likely(byte_match_4(cur, "true"))) {
-        val->tag = YYJSON_TYPE_BOOL | YYJSON_SUBTYPE_TRUE;
-        *ptr = cur + 4;
-        return true;
-    }
-    return false;
+bool yyjson_mut_doc_set_val_pool_size(yyjson_mut_doc *doc, size_t count) {
+    usize max_count = YYJSON_MUT_DOC_VAL_POOL_MAX_SIZE / sizeof(yyjson_mut_val);
+#if !YYJSON_MUT_COMPACT
+    max_count = USIZE_MAX / sizeof(yyjson_mut_val);
+#endif
+    max_count -= YYJSON_MUT_DOC_VAL_CHUNK_HDR;
+    if (!doc || !count || count > max_count) return false;
+    doc->val_pool.chunk_size = (count + YYJSON_MUT_DOC_VAL_CHUNK_HDR) *
+                               sizeof(yyjson_mut_val);
+    return true;
 }
 
-/** Read `false` literal, `*ptr[0]` should be `f`. */
-static_inline bool read_false(u8 **ptr, yyjson_val *val) {
-    u8 *cur = *ptr;
-    if (likely(byte_match_4(cur + 1, "alse"))) {
-        val->tag = YYJSON_TYPE_BOOL | YYJSON_SUBTYPE_FALSE;
-        *ptr = cur + 5;
-        return true;
+void yyjson_mut_doc_free(yyjson_mut_doc *doc) {
+    if (doc) {
+        yyjson_alc alc = doc->alc;
+        yyjson_mut_doc_index_free(doc);
+        memset(&doc->alc, 0, sizeof(alc));
+        unsafe_yyjson_str_pool_release(&doc->str_pool, &alc);
+        unsafe_yyjson_val_pool_release(&doc->val_pool, &alc);
+        alc.free(alc.ctx, doc);
     }
-    return false;
 }
 
-/** Read `null` literal, `*ptr[0]` should be `n`. */
-static_inline bool read_null(u8 **ptr, yyjson_val *val) {
-    u8 *cur = *ptr;
-    if (likely(byte_match_4(cur, "null"))) {
-        val->tag = YYJSON_TYPE_NULL;
-        *ptr = cur + 4;
-        return true;
+yyjson_mut_doc *yyjson_mut_doc_new(const yyjson_alc *alc) {
+    yyjson_mut_doc *doc;
+    if (!alc) alc = &YYJSON_DEFAULT_ALC;
+    doc = (yyjson_mut_doc *)alc->malloc(alc->ctx, sizeof(yyjson_mut_doc));
+    if (!doc) return NULL;
+    memset(doc, 0, sizeof(yyjson_mut_doc));
+
+    doc->alc = *alc;
+    doc->str_pool.chunk_size = YYJSON_MUT_DOC_STR_POOL_INIT_SIZE;
+    doc->str_pool.chunk_size_max = YYJSON_MUT_DOC_STR_POOL_MAX_SIZE;
+    doc->val_pool.chunk_size = YYJSON_MUT_DOC_VAL_POOL_INIT_SIZE;
+    doc->val_pool.chunk_size_max = YYJSON_MUT_DOC_VAL_POOL_MAX_SIZE;
+#if YYJSON_MUT_COMPACT
+    doc->val_pool.doc = doc;
+#endif
+    return doc;
+}
+
+yyjson_mut_doc *yyjson_doc_mut_copy(const yyjson_doc *doc,
+                                    const yyjson_alc *alc) {
+    yyjson_mut_doc *m_doc;
+    yyjson_mut_val *m_val;
+
+    if (!doc || !doc->root) return NULL;
+    m_doc = yyjson_mut_doc_new(alc);
+    if (!m_doc) return NULL;
+    m_val = yyjson_val_mut_copy(m_doc, doc->root);
+    if (!m_val) {
+        yyjson_mut_doc_free(m_doc);
+        return NULL;
     }
-    return false;
+    yyjson_mut_doc_set_root(m_doc, m_val);
+    return m_doc;
 }
 
-/** Read `Inf` or `Infinity` literal (ignoring case). */
-static_inline bool read_inf(u8 **ptr, u8 **pre,
-                            yyjson_read_flag flg, yyjson_val *val) {
-    u8 *hdr = *ptr;
-    u8 *cur = *ptr;
-    u8 **end = ptr;
-    bool sign = (*cur == '-');
-    if (*cur == '+' && !has_allow(EXT_NUMBER)) return false;
-    cur += char_is_sign(*cur);
-    if (char_to_lower(cur[0]) == 'i' &&
-        char_to_lower(cur[1]) == 'n' &&
-        char_to_lower(cur[2]) == 'f') {
-        if (char_to_lower(cur[3]) == 'i') {
-            if (char_to_lower(cur[4]) == 'n' &&
-                char_to_lower(cur[5]) == 'i' &&
-                char_to_lower(cur[6]) == 't' &&
-                char_to_lower(cur[7]) == 'y') {
-                cur += 8;
-            } else {
-                return false;
-            }
-        } else {
-            cur += 3;
-        }
-        *end = cur;
-        if (has_flg(NUMBER_AS_RAW)) {
-            **pre = '\0'; /* add null-terminator for previous raw string */
-            *pre = cur; /* save end position for current raw string */
-            val->tag = ((u64)(cur - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_RAW;
-            val->uni.str = (const char *)hdr;
-        } else {
-            val->tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL;
-            val->uni.u64 = f64_bits_inf(sign);
-        }
-        return true;
+yyjson_mut_doc *yyjson_mut_doc_mut_copy(const yyjson_mut_doc *doc,
+                                        const yyjson_alc *alc) {
+    yyjson_mut_doc *m_doc;
+    yyjson_mut_val *m_val;
+
+    if (!doc) return NULL;
+    if (!doc->root) return yyjson_mut_doc_new(alc);
+
+    m_doc = yyjson_mut_doc_new(alc);
+    if (!m_doc) return NULL;
+    m_val = yyjson_mut_val_mut_copy(m_doc, doc->root);
+    if (!m_val) {
+        yyjson_mut_doc_free(m_doc);
+        return NULL;
     }
-    return false;
+    yyjson_mut_doc_set_root(m_doc, m_val);
+    return m_doc;
 }
 
-/** Read `NaN` literal (ignoring case). */
-static_inline bool read_nan(u8 **ptr, u8 **pre,
-                            yyjson_read_flag flg, yyjson_val *val) {
-    u8 *hdr = *ptr;
-    u8 *cur = *ptr;
-    u8 **end = ptr;
-    bool sign = (*cur == '-');
-    if (*cur == '+' && !has_allow(EXT_NUMBER)) return false;
-    cur += char_is_sign(*cur);
-    if (char_to_lower(cur[0]) == 'n' &&
-        char_to_lower(cur[1]) == 'a' &&
-        char_to_lower(cur[2]) == 'n') {
-        cur += 3;
-        *end = cur;
-        if (has_flg(NUMBER_AS_RAW)) {
-            **pre = '\0'; /* add null-terminator for previous raw string */
-            *pre = cur; /* save end position for current raw string */
-            val->tag = ((u64)(cur - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_RAW;
-            val->uni.str = (const char *)hdr;
-        } else {
-            val->tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL;
-            val->uni.u64 = f64_bits_nan(sign);
+#if YYJSON_MUT_COMPACT
+
+static yyjson_mut_val *unsafe_yyjson_val_mut_copy(yyjson_mut_doc *m_doc,
+                                                  const yyjson_val *i_val) {
+    /*
+     The compact mutable values of a large container may not fit in one pool
+     chunk (see `YYJSON_MUT_OFS_MASK`), so we copy them one by one, and link
+     the children of each container in the original order.
+     */
+    yyjson_type type = unsafe_yyjson_get_type(i_val);
+    yyjson_subtype subtype = unsafe_yyjson_get_subtype(i_val);
+    yyjson_mut_val *m_val = unsafe_yyjson_mut_val(m_doc, 1);
+    if (unlikely(!m_val)) return NULL;
+
+    if (type == YYJSON_TYPE_ARR || type == YYJSON_TYPE_OBJ) {
+        usize len = unsafe_yyjson_get_len(i_val), i;
+        bool is_obj = (type == YYJSON_TYPE_OBJ);
+        yyjson_val *i_child = constcast(yyjson_val *)i_val + 1;
+        yyjson_mut_val *m_child, *m_first = NULL, *m_prev = NULL;
+        unsafe_yyjson_mut_set_tag(m_val, type, subtype, len);
+        len <<= (u8)is_obj;
+        for (i = 0; i < len; i++) {
+            m_child = unsafe_yyjson_val_mut_copy(m_doc, i_child);
+            if (unlikely(!m_child)) return NULL;
+            if (m_prev) unsafe_yyjson_mut_set_next(m_prev, m_child);
+            else m_first = m_child;
+            /* the last child of an object is the key of the last pair */
+            if (!is_obj || !(i & 1)) unsafe_yyjson_mut_set_last(m_val, m_child);
+            m_prev = m_child;
+            i_child = unsafe_yyjson_get_next(i_child);
         }
-        return true;
+        if (m_prev) unsafe_yyjson_mut_set_next(m_prev, m_first);
+    } else if (type == YYJSON_TYPE_STR || type == YYJSON_TYPE_RAW) {
+        if (unlikely(!unsafe_yyjson_mut_set_strx(m_val, type, subtype,
+                                                 i_val->uni.str,
+                                                 unsafe_yyjson_get_len(i_val)))) {
+            return NULL;
+        }
+    } else {
+        unsafe_yyjson_mut_set_tag(m_val, type, subtype, 0);
+        m_val->uni = i_val->uni;
     }
-    return false;
+    return m_val;
 }
 
-/** Read `Inf`, `Infinity` or `NaN` literal (ignoring case). */
-static_inline bool read_inf_or_nan(u8 **ptr, u8 **pre,
-                                   yyjson_read_flag flg, yyjson_val *val) {
-    if (read_inf(ptr, pre, flg, val)) return true;
-    if (read_nan(ptr, pre, flg, val)) return true;
-    return false;
+yyjson_mut_val *yyjson_val_mut_copy(yyjson_mut_doc *m_doc,
+                                    const yyjson_val *i_vals) {
+    if (!m_doc || !i_vals) return NULL;
+    return unsafe_yyjson_val_mut_copy(m_doc, i_vals);
 }
 
-/** Read a JSON number as raw string. */
-static_noinline bool read_num_raw(u8 **ptr, u8 **pre, yyjson_read_flag flg,
-                                  yyjson_val *val, const char **msg) {
-#define return_err(_pos, _msg) do { \
-    *msg = _msg; *end = _pos; return false; \
-} while (false)
-
-#define return_raw() do { \
-    val->tag = ((u64)(cur - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_RAW; \
-    val->uni.str = (const char *)hdr; \
-    **pre = '\0'; *pre = cur; *end = cur; return true; \
-} while (false)
+#else
 
-    u8 *hdr = *ptr;
-    u8 *cur = *ptr;
-    u8 **end = ptr;
+yyjson_mut_val *yyjson_val_mut_copy(yyjson_mut_doc *m_doc,
+                                    const yyjson_val *i_vals) {
+    /*
+     The immutable object or array stores all sub-values in a contiguous memory,
+     We copy them to another contiguous memory as mutable values,
+     then reconnect the mutable values with the original relationship.
+     */
+    usize i_vals_len;
+    yyjson_mut_val *m_vals, *m_val;
+    yyjson_val *i_val, *i_end;
 
-    /* skip sign */
-    cur += (*cur == '-');
+    if (!m_doc || !i_vals) return NULL;
+    i_end = unsafe_yyjson_get_next(i_vals);
+    i_vals_len = (usize)(unsafe_yyjson_get_next(i_vals) - i_vals);
+    m_vals = unsafe_yyjson_mut_val(m_doc, i_vals_len);
+    if (!m_vals) return NULL;
+    i_val = constcast(yyjson_val *)i_vals;
+    m_val = m_vals;
 
-    /* read first digit, check leading zero */
-    while (unlikely(!char_is_digit(*cur))) {
-        if (has_allow(EXT_NUMBER)) {
-            if (*cur == '+' && cur == hdr) { /* leading `+` sign */
-                cur++;
-                continue;
+    for (; i_val < i_end; i_val++, m_val++) {
+        yyjson_type type = unsafe_yyjson_get_type(i_val);
+        m_val->tag = i_val->tag;
+        m_val->uni.u64 = i_val->uni.u64;
+        if (type == YYJSON_TYPE_STR || type == YYJSON_TYPE_RAW) {
+            const char *str = i_val->uni.str;
+            usize str_len = unsafe_yyjson_get_len(i_val);
+            m_val->uni.str = unsafe_yyjson_mut_strncpy(m_doc, str, str_len);
+            if (!m_val->uni.str) return NULL;
+        } else if (type == YYJSON_TYPE_ARR) {
+            usize len = unsafe_yyjson_get_len(i_val);
+            if (len > 0) {
+                yyjson_val *ii_val = i_val + 1, *ii_next;
+                yyjson_mut_val *mm_val = m_val + 1, *mm_ctn = m_val, *mm_next;
+                while (len-- > 1) {
+                    ii_next = unsafe_yyjson_get_next(ii_val);
+                    mm_next = mm_val + (ii_next - ii_val);
+                    mm_val->next = mm_next;
+                    ii_val = ii_next;
+                    mm_val = mm_next;
+                }
+                mm_val->next = mm_ctn + 1;
+                mm_ctn->uni.ptr = mm_val;
             }
-            if (*cur == '.' && char_is_digit(cur[1])) { /* e.g. '.123' */
-                goto read_double;
+        } else if (type == YYJSON_TYPE_OBJ) {
+            usize len = unsafe_yyjson_get_len(i_val);
+            if (len > 0) {
+                yyjson_val *ii_key = i_val + 1, *ii_nextkey;
+                yyjson_mut_val *mm_key = m_val + 1, *mm_ctn = m_val;
+                yyjson_mut_val *mm_nextkey;
+                while (len-- > 1) {
+                    ii_nextkey = unsafe_yyjson_get_next(ii_key + 1);
+                    mm_nextkey = mm_key + (ii_nextkey - ii_key);
+                    mm_key->next = mm_key + 1;
+                    mm_key->next->next = mm_nextkey;
+                    ii_key = ii_nextkey;
+                    mm_key = mm_nextkey;
+                }
+                mm_key->next = mm_key + 1;
+                mm_key->next->next = mm_ctn + 1;
+                mm_ctn->uni.ptr = mm_key;
             }
         }
-        if (has_allow(INF_AND_NAN)) {
-            if (read_inf_or_nan(ptr, pre, flg, val)) return true;
-        }
-        return_err(cur, "no digit after sign");
     }
+    return m_vals;
+}
 
-    /* read integral part */
-    if (*cur == '0') {
-        cur++;
-        if (unlikely(char_is_digit(*cur))) {
-            return_err(cur - 1, "number with leading zero is not allowed");
-        }
-        if (!char_is_fp(*cur)) {
-            if (has_allow(EXT_NUMBER) && char_to_lower(*cur) == 'x') { /* hex */
-                if (!char_is_hex(*++cur)) return_err(cur, "invalid hex number");
-                while(char_is_hex(*cur)) cur++;
+#endif /* YYJSON_MUT_COMPACT */
+
+static yyjson_mut_val *unsafe_yyjson_mut_val_mut_copy(
+    yyjson_mut_doc *m_doc, const yyjson_mut_val *m_vals) {
+    /*
+     The mutable object or array stores all sub-values in a circular linked
+     list, so we can traverse them in the same loop. The traversal starts from
+     the last item, continues with the first item in a list, and ends with the
+     second to last item, which needs to be linked to the last item to close the
+     circle.
+     */
+    yyjson_mut_val *m_val = unsafe_yyjson_mut_val(m_doc, 1);
+    if (unlikely(!m_val)) return NULL;
+    unsafe_yyjson_mut_set_val(m_val, m_vals);
+
+    switch (unsafe_yyjson_get_type(m_vals)) {
+        case YYJSON_TYPE_OBJ:
+        case YYJSON_TYPE_ARR:
+            if (unsafe_yyjson_mut_get_len(m_vals) > 0) {
+                yyjson_mut_val *last = unsafe_yyjson_mut_get_last(m_vals);
+                yyjson_mut_val *next = unsafe_yyjson_mut_get_next(last);
+                yyjson_mut_val *first, *prev, *cur;
+                first = unsafe_yyjson_mut_val_mut_copy(m_doc, last);
+                if (!first) return NULL;
+                unsafe_yyjson_mut_set_last(m_val, first);
+                prev = first;
+                while (next != last) {
+                    cur = unsafe_yyjson_mut_val_mut_copy(m_doc, next);
+                    if (!cur) return NULL;
+                    unsafe_yyjson_mut_set_next(prev, cur);
+                    prev = cur;
+                    next = unsafe_yyjson_mut_get_next(next);
+                }
+                unsafe_yyjson_mut_set_next(prev, first);
             }
-            return_raw();
+            break;
+        case YYJSON_TYPE_RAW:
+        case YYJSON_TYPE_STR: {
+            const char *str = unsafe_yyjson_mut_get_str(m_vals);
+            usize str_len = unsafe_yyjson_mut_get_len(m_vals);
+            char *new_str = unsafe_yyjson_mut_strncpy(m_doc, str, str_len);
+            if (!new_str) return NULL;
+            unsafe_yyjson_mut_set_strx(m_val, unsafe_yyjson_get_type(m_vals),
+                                       unsafe_yyjson_get_subtype(m_vals),
+                                       new_str, str_len);
+            break;
         }
-    } else {
-        while (char_is_digit(*cur)) cur++;
-        if (!char_is_fp(*cur)) return_raw();
+        default:
+            break;
     }
+    return m_val;
+}
 
-read_double:
-    /* read fraction part */
-    if (*cur == '.') {
-        cur++;
-        if (!char_is_digit(*cur)) {
-            if (has_allow(EXT_NUMBER)) {
-                if (!char_is_exp(*cur)) return_raw();
-            } else {
-                return_err(cur, "no digit after decimal point");
+yyjson_mut_val *yyjson_mut_val_mut_copy(yyjson_mut_doc *doc,
+                                        const yyjson_mut_val *val) {
+    if (doc && val) return unsafe_yyjson_mut_val_mut_copy(doc, val);
+    return NULL;
+}
+
+/* Count the number of values and the total length of the strings. */
+static void yyjson_mut_stat(const yyjson_mut_val *val,
+                            usize *val_sum, usize *str_sum) {
+    yyjson_type type = unsafe_yyjson_get_type(val);
+    *val_sum += 1;
+    if (type == YYJSON_TYPE_ARR || type == YYJSON_TYPE_OBJ) {
+        usize len = unsafe_yyjson_mut_get_len(val), i;
+        yyjson_mut_val *child = len ? unsafe_yyjson_mut_get_last(val) : NULL;
+        len <<= (u8)(type == YYJSON_TYPE_OBJ);
+        *val_sum += len;
+        for (i = 0; i < len; i++) {
+            yyjson_type stype = unsafe_yyjson_get_type(child);
+            if (stype == YYJSON_TYPE_STR || stype == YYJSON_TYPE_RAW) {
+                *str_sum += unsafe_yyjson_mut_get_len(child) + 1;
+            } else if (stype == YYJSON_TYPE_ARR || stype == YYJSON_TYPE_OBJ) {
+                yyjson_mut_stat(child, val_sum, str_sum);
+                *val_sum -= 1;
             }
+            child = unsafe_yyjson_mut_get_next(child);
         }
-        while (char_is_digit(*cur)) cur++;
+    } else if (type == YYJSON_TYPE_STR || type == YYJSON_TYPE_RAW) {
+        *str_sum += unsafe_yyjson_mut_get_len(val) + 1;
     }
+}
 
-    /* read exponent part */
-    if (char_is_exp(*cur)) {
-        cur += 1 + char_is_sign(cur[1]);
-        if (!char_is_digit(*cur++)) {
-            return_err(cur, "no digit after exponent sign");
-        }
-        while (char_is_digit(*cur)) cur++;
+/* Copy a mutable value to an immutable value, without the children. */
+static_inline void unsafe_yyjson_mut_val_to_imut(yyjson_val *val,
+                                                 const yyjson_mut_val *mval) {
+#if YYJSON_MUT_COMPACT
+    yyjson_type type = unsafe_yyjson_get_type(mval);
+    yyjson_subtype subtype = unsafe_yyjson_get_subtype(mval);
+    usize len = unsafe_yyjson_mut_get_len(mval);
+    if (type == YYJSON_TYPE_STR || type == YYJSON_TYPE_RAW) {
+        unsafe_yyjson_set_tag(val, type, subtype, len);
+        val->uni.str = unsafe_yyjson_mut_get_str(mval);
+    } else if (type == YYJSON_TYPE_ARR || type == YYJSON_TYPE_OBJ) {
+        unsafe_yyjson_set_tag(val, type, subtype, len);
+        val->uni.ofs = sizeof(yyjson_val);
+    } else {
+        /* keep the output format of real number in the high bits */
+        val->tag = (mval->tag & YYJSON_TAG_MASK) |
+                   ((u64)unsafe_yyjson_mut_get_fp_fmt(mval) << 32);
+        val->uni = mval->uni;
     }
+#else
+    val->tag = mval->tag;
+    val->uni = mval->uni;
+#endif
+}
 
-    return_raw();
+/* Copy mutable values to immutable value pool. */
+static usize yyjson_imut_copy(yyjson_val **val_ptr, char **buf_ptr,
+                              const yyjson_mut_val *mval) {
+    yyjson_val *val = *val_ptr;
+    yyjson_type type = unsafe_yyjson_get_type(mval);
+    if (type == YYJSON_TYPE_ARR || type == YYJSON_TYPE_OBJ) {
+        usize len = unsafe_yyjson_mut_get_len(mval), i;
+        yyjson_mut_val *child = NULL;
+        usize val_sum = 1;
+        unsafe_yyjson_set_tag(val, type, YYJSON_SUBTYPE_NONE, len);
+        if (len) child = unsafe_yyjson_mut_get_last(mval);
+        if (type == YYJSON_TYPE_OBJ) {
+            if (len) child = unsafe_yyjson_mut_get_next(child);
+            len <<= 1;
+        }
+        if (len) child = unsafe_yyjson_mut_get_next(child);
+        *val_ptr = val + 1;
+        for (i = 0; i < len; i++) {
+            val_sum += yyjson_imut_copy(val_ptr, buf_ptr, child);
+            child = unsafe_yyjson_mut_get_next(child);
+        }
+        val->uni.ofs = val_sum * sizeof(yyjson_val);
+        return val_sum;
+    } else if (type == YYJSON_TYPE_STR || type == YYJSON_TYPE_RAW) {
+        char *buf = *buf_ptr;
+        usize len = unsafe_yyjson_mut_get_len(mval);
+        memcpy((void *)buf, (const void *)unsafe_yyjson_mut_get_str(mval), len);
+        buf[len] = '\0';
+        unsafe_yyjson_set_tag(val, type, unsafe_yyjson_get_subtype(mval), len);
+        val->uni.str = buf;
+        *val_ptr = val + 1;
+        *buf_ptr = buf + len + 1;
+        return 1;
+    } else {
+        unsafe_yyjson_mut_val_to_imut(val, mval);
+        *val_ptr = val + 1;
+        return 1;
+    }
+}
 
-#undef return_err
-#undef return_raw
+yyjson_doc *yyjson_mut_doc_imut_copy(const yyjson_mut_doc *mdoc,
+                                     const yyjson_alc *alc) {
+    if (!mdoc) return NULL;
+    return yyjson_mut_val_imut_copy(mdoc->root, alc);
 }
 
-/** Read a hex number. */
-static_noinline bool read_num_hex(u8 **ptr, u8 **pre, yyjson_read_flag flg,
-                                  yyjson_val *val, const char **msg) {
-    u8 *hdr = *ptr;
-    u8 *cur = *ptr;
-    u8 **end = ptr;
-    u64 sig = 0, i = 0;
-    bool sign;
+yyjson_doc *yyjson_mut_val_imut_copy(const yyjson_mut_val *mval,
+                                     const yyjson_alc *alc) {
+    usize val_num = 0, str_sum = 0, hdr_size, buf_size;
+    yyjson_doc *doc = NULL;
+    yyjson_val *val_hdr = NULL;
 
-    /* skip sign and '0x' */
-    sign = (*cur == '-');
-    cur += (*cur == '-' || *cur == '+') + 2;
+    /* This value should be NULL here. Setting a non-null value suppresses
+       warning from the clang analyzer. */
+    char *str_hdr = (char *)(void *)&str_sum;
+    if (!mval) return NULL;
+    if (!alc) alc = &YYJSON_DEFAULT_ALC;
 
-    /* read hex */
-    for(; i < 16; i++) {
-        u8 c = hex_conv_table[cur[i]];
-        if (c == 0xF0) break;
-        sig <<= 4;
-        sig |= c;
-    }
+    /* traverse the input value to get pool size */
+    yyjson_mut_stat(mval, &val_num, &str_sum);
 
-    /* check error */
-    if (unlikely(i == 0)) {
-        *msg = "invalid hex number";
-        return false;
-    }
+    /* create doc and val pool */
+    hdr_size = size_align_up(sizeof(yyjson_doc), sizeof(yyjson_val));
+    buf_size = hdr_size + val_num * sizeof(yyjson_val);
+    doc = (yyjson_doc *)alc->malloc(alc->ctx, buf_size);
+    if (!doc) return NULL;
+    memset(doc, 0, sizeof(yyjson_doc));
+    val_hdr = (yyjson_val *)(void *)((char *)(void *)doc + hdr_size);
+    doc->root = val_hdr;
+    doc->alc = *alc;
 
-    /* check overflow */
-    if (unlikely(i == 16)) {
-        if (char_is_hex(cur[16]) || (sign && sig > ((u64)1 << 63))) {
-            if (!has_flg(BIGNUM_AS_RAW)) {
-                *msg = "hex number overflow";
-                return false;
-            }
-            cur += 16;
-            while (char_is_hex(*cur)) cur++;
-            **pre = '\0';
-            val->tag = ((u64)(cur - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_RAW;
-            val->uni.str = (const char *)hdr;
-            *pre = cur; *end = cur;
-            return true;
+    /* create str pool */
+    if (str_sum > 0) {
+        str_hdr = (char *)alc->malloc(alc->ctx, str_sum);
+        doc->str_pool = str_hdr;
+        if (!str_hdr) {
+            alc->free(alc->ctx, (void *)doc);
+            return NULL;
         }
     }
 
-    val->tag = YYJSON_TYPE_NUM | (u64)((u8)sign << 3);
-    val->uni.u64 = (u64)(sign ? (u64)(~(sig) + 1) : (u64)(sig));
-    *end = cur + i;
-    return true;
+    /* copy vals and strs */
+    doc->val_read = yyjson_imut_copy(&val_hdr, &str_hdr, mval);
+    doc->dat_read = str_sum + 1;
+    return doc;
 }
 
-/**
- Skip trivia (whitespace and comments).
- This function should be used only when `char_is_trivia()` returns true.
- @param ptr  (inout) Input current position, output end position.
- @param eof  JSON end position.
- @param flg  JSON read flags.
- @return true  if at least one character was skipped.
-         false if no characters were skipped,
-               or if a multi-line comment is unterminated;
-               in the latter case, `ptr` will be set to `eof`.
- */
-static_noinline bool skip_trivia(u8 **ptr, u8 *eof, yyjson_read_flag flg) {
-    u8 *hdr = *ptr, *cur = *ptr;
-    usize len;
+static_inline bool unsafe_yyjson_num_equals(const void *lhs, const void *rhs) {
+    const yyjson_val_uni *luni = &((const yyjson_val *)lhs)->uni;
+    const yyjson_val_uni *runi = &((const yyjson_val *)rhs)->uni;
+    yyjson_subtype lt = unsafe_yyjson_get_subtype(lhs);
+    yyjson_subtype rt = unsafe_yyjson_get_subtype(rhs);
+    if (lt == rt) return luni->u64 == runi->u64;
+    if (lt == YYJSON_SUBTYPE_SINT && rt == YYJSON_SUBTYPE_UINT) {
+        return luni->i64 >= 0 && luni->u64 == runi->u64;
+    }
+    if (lt == YYJSON_SUBTYPE_UINT && rt == YYJSON_SUBTYPE_SINT) {
+        return runi->i64 >= 0 && luni->u64 == runi->u64;
+    }
+    return false;
+}
 
-    while (cur < eof) {
-        u8 *loop_begin = cur;
+static_inline bool unsafe_yyjson_str_equals(const void *lhs, const void *rhs) {
+    usize len = unsafe_yyjson_get_len(lhs);
+    if (len != unsafe_yyjson_get_len(rhs)) return false;
+    return !memcmp(unsafe_yyjson_get_str(lhs),
+                   unsafe_yyjson_get_str(rhs), len);
+}
 
-        /* skip standard whitespace */
-        while(char_is_space(*cur)) cur++;
+bool unsafe_yyjson_equals(const yyjson_val *lhs, const yyjson_val *rhs) {
+    yyjson_type type = unsafe_yyjson_get_type(lhs);
+    if (type != unsafe_yyjson_get_type(rhs)) return false;
 
-        /* skip extended whitespace */
-        if (has_allow(EXT_WHITESPACE)) {
-            while (char_is_space_ext(*cur)) {
-                cur += (len = ext_space_len(cur));
-                if (!len) break;
+    switch (type) {
+        case YYJSON_TYPE_OBJ: {
+            usize len = unsafe_yyjson_get_len(lhs);
+            if (len != unsafe_yyjson_get_len(rhs)) return false;
+            if (len > 0) {
+                yyjson_obj_iter iter;
+                yyjson_obj_iter_init(rhs, &iter);
+                lhs = unsafe_yyjson_get_first(lhs);
+                while (len-- > 0) {
+                    rhs = yyjson_obj_iter_getn(&iter, lhs->uni.str,
+                                               unsafe_yyjson_get_len(lhs));
+                    if (!rhs) return false;
+                    if (!unsafe_yyjson_equals(lhs + 1, rhs)) return false;
+                    lhs = unsafe_yyjson_get_next(lhs + 1);
+                }
             }
+            /* yyjson allows duplicate keys, so the check may be inaccurate */
+            return true;
         }
 
-        /* skip comment, do not validate encoding */
-        if (has_allow(COMMENTS) && cur[0] == '/') {
-            if (cur[1] == '/') { /* single-line comment */
-                cur += 2;
-                if (has_allow(EXT_WHITESPACE)) {
-                    while (cur < eof) {
-                        if (char_is_eol_ext(*cur)) {
-                            cur += (len = ext_eol_len(cur));
-                            if (len) break;
-                        }
-                        cur++;
-                    }
-                } else {
-                    while (cur < eof && !char_is_eol(*cur)) cur++;
-                }
-            } else if (cur[1] == '*') { /* multi-line comment */
-                cur += 2;
-                while (!byte_match_2(cur, "*/") && cur < eof) cur++;
-                if (cur == eof) {
-                    *ptr = eof;
-                    return false; /* unclosed comment */
+        case YYJSON_TYPE_ARR: {
+            usize len = unsafe_yyjson_get_len(lhs);
+            if (len != unsafe_yyjson_get_len(rhs)) return false;
+            if (len > 0) {
+                lhs = unsafe_yyjson_get_first(lhs);
+                rhs = unsafe_yyjson_get_first(rhs);
+                while (len-- > 0) {
+                    if (!unsafe_yyjson_equals(lhs, rhs)) return false;
+                    lhs = unsafe_yyjson_get_next(lhs);
+                    rhs = unsafe_yyjson_get_next(rhs);
                 }
-                cur += 2;
             }
+            return true;
         }
-        if (cur == loop_begin) break;
-    }
-    *ptr = cur;
-    return cur > hdr;
-}
 
-/**
- Check truncated UTF-8 character.
- Return true if `cur` starts a valid UTF-8 sequence that is truncated.
- */
-static bool is_truncated_utf8(u8 *cur, u8 *eof) {
-    u8 c0, c1, c2;
-    usize len = (usize)(eof - cur);
-    if (cur >= eof || len >= 4) return false;
-    c0 = cur[0]; c1 = cur[1]; c2 = cur[2];
-    /* 1-byte UTF-8, not truncated */
-    if (c0 < 0x80) return false;
-    if (len == 1) {
-        /* 2-byte UTF-8, truncated */
-        if ((c0 & 0xE0) == 0xC0 && (c0 & 0x1E) != 0x00) return true;
-        /* 3-byte UTF-8, truncated */
-        if ((c0 & 0xF0) == 0xE0) return true;
-        /* 4-byte UTF-8, truncated */
-        if ((c0 & 0xF8) == 0xF0 && (c0 & 0x07) <= 0x04) return true;
-    } else if (len == 2) {
-        /* 3-byte UTF-8, truncated */
-        if ((c0 & 0xF0) == 0xE0 && (c1 & 0xC0) == 0x80) {
-            u8 t = (u8)(((c0 & 0x0F) << 1) | ((c1 & 0x20) >> 5));
-            return 0x01 <= t && t != 0x1B;
-        }
-        /* 4-byte UTF-8, truncated */
-        if ((c0 & 0xF8) == 0xF0 && (c1 & 0xC0) == 0x80) {
-            u8 t = (u8)(((c0 & 0x07) << 2) | ((c1 & 0x30) >> 4));
-            return 0x01 <= t && t <= 0x10;
-        }
-    } else if (len == 3) {
-        /* 4 bytes UTF-8, truncated */
-        if ((c0 & 0xF8) == 0xF0 && (c1 & 0xC0) == 0x80 && (c2 & 0xC0) == 0x80) {
-            u8 t = (u8)(((c0 & 0x07) << 2) | ((c1 & 0x30) >> 4));
-            return 0x01 <= t && t <= 0x10;
-        }
-    }
-    return false;
-}
+        case YYJSON_TYPE_NUM:
+            return unsafe_yyjson_num_equals(lhs, rhs);
 
-/**
- Check truncated string.
- Returns true if `cur` match `str` but is truncated.
- The `str` should be lowercase ASCII letters.
- */
-static bool is_truncated_str(u8 *cur, u8 *eof, const char *str,
-                             bool case_sensitive) {
-    usize len = strlen(str);
-    if (cur + len <= eof || eof <= cur) return false;
-    if (case_sensitive) {
-        return memcmp(cur, str, (usize)(eof - cur)) == 0;
-    }
-    for (; cur < eof; cur++, str++) {
-        if (char_to_lower(*cur) != *(const u8 *)str) return false;
+        case YYJSON_TYPE_RAW:
+        case YYJSON_TYPE_STR:
+            return unsafe_yyjson_str_equals(lhs, rhs);
+
+        case YYJSON_TYPE_NULL:
+        case YYJSON_TYPE_BOOL:
+            return lhs->tag == rhs->tag;
+
+        default:
+            return false;
     }
-    return true;
 }
 
-/**
- Check truncated JSON on parsing errors.
- Returns true if the input is valid but truncated.
- */
-static_noinline bool is_truncated_end(u8 *hdr, u8 *cur, u8 *eof,
-                                      yyjson_read_code code,
-                                      yyjson_read_flag flg) {
-    if (cur >= eof) return true;
-    if (code == YYJSON_READ_ERROR_LITERAL) {
-        if (is_truncated_str(cur, eof, "true", true) ||
-            is_truncated_str(cur, eof, "false", true) ||
-            is_truncated_str(cur, eof, "null", true)) {
-            return true;
-        }
-    }
-    if (code == YYJSON_READ_ERROR_UNEXPECTED_CHARACTER ||
-        code == YYJSON_READ_ERROR_INVALID_NUMBER ||
-        code == YYJSON_READ_ERROR_LITERAL) {
-        if (has_allow(INF_AND_NAN)) {
-            if (*cur == '-') cur++;
-            if (is_truncated_str(cur, eof, "infinity", false) ||
-                is_truncated_str(cur, eof, "nan", false)) {
-                return true;
-            }
-        }
-    }
-    if (code == YYJSON_READ_ERROR_UNEXPECTED_CONTENT) {
-        if (has_allow(INF_AND_NAN)) {
-            if (hdr + 3 <= cur &&
-                is_truncated_str(cur - 3, eof, "infinity", false)) {
-                return true; /* e.g. infin would be read as inf + in */
-            }
-        }
-    }
-    if (code == YYJSON_READ_ERROR_INVALID_STRING) {
-        usize len = (usize)(eof - cur);
+bool unsafe_yyjson_mut_equals(const yyjson_mut_val *lhs,
+                              const yyjson_mut_val *rhs) {
+    yyjson_type type = unsafe_yyjson_get_type(lhs);
+    if (type != unsafe_yyjson_get_type(rhs)) return false;
 
-        /* unicode escape sequence */
-        if (*cur == '\\') {
-            if (len == 1) return true;
-            if (len <= 5) {
-                if (*++cur != 'u') return false;
-                for (++cur; cur < eof; cur++) {
-                    if (!char_is_hex(*cur)) return false;
+    switch (type) {
+        case YYJSON_TYPE_OBJ: {
+            usize len = unsafe_yyjson_mut_get_len(lhs);
+            if (len != unsafe_yyjson_mut_get_len(rhs)) return false;
+            if (len > 0) {
+                yyjson_mut_obj_iter iter;
+                yyjson_mut_val *val;
+                yyjson_mut_obj_iter_init(constcast(yyjson_mut_val *)rhs, &iter);
+                lhs = unsafe_yyjson_mut_get_last(lhs);
+                while (len-- > 0) {
+                    rhs = yyjson_mut_obj_iter_getn(&iter,
+                        unsafe_yyjson_mut_get_str(lhs),
+                        unsafe_yyjson_mut_get_len(lhs));
+                    if (!rhs) return false;
+                    val = unsafe_yyjson_mut_get_next(lhs);
+                    if (!unsafe_yyjson_mut_equals(val, rhs)) return false;
+                    lhs = unsafe_yyjson_mut_get_next(val);
                 }
-                return true;
-            } else if (len <= 11) {
-                /* incomplete surrogate pair? */
-                u16 hi;
-                if (*++cur != 'u') return false;
-                if (!hex_load_4(++cur, &hi)) return false;
-                if ((hi & 0xF800) != 0xD800) return false;
-                cur += 4;
-                if (cur >= eof) return true;
-                /* valid low surrogate is DC00...DFFF */
-                if (*cur != '\\') return false;
-                if (++cur >= eof) return true;
-                if (*cur != 'u') return false;
-                if (++cur >= eof) return true;
-                if (*cur != 'd' && *cur != 'D') return false;
-                if (++cur >= eof) return true;
-                if ((*cur < 'c' || *cur > 'f') && (*cur < 'C' || *cur > 'F'))
-                    return false;
-                if (++cur >= eof) return true;
-                if (!char_is_hex(*cur)) return false;
-                return true;
             }
-            return false;
+            /* yyjson allows duplicate keys, so the check may be inaccurate */
+            return true;
         }
 
-        /* 2 to 4 bytes UTF-8 */
-        if (is_truncated_utf8(cur, eof)) {
+        case YYJSON_TYPE_ARR: {
+            usize len = unsafe_yyjson_mut_get_len(lhs);
+            if (len != unsafe_yyjson_mut_get_len(rhs)) return false;
+            if (len > 0) {
+                lhs = unsafe_yyjson_mut_get_last(lhs);
+                rhs = unsafe_yyjson_mut_get_last(rhs);
+                while (len-- > 0) {
+                    if (!unsafe_yyjson_mut_equals(lhs, rhs)) return false;
+                    lhs = unsafe_yyjson_mut_get_next(lhs);
+                    rhs = unsafe_yyjson_mut_get_next(rhs);
+                }
+            }
             return true;
         }
+
+        case YYJSON_TYPE_NUM:
+            return unsafe_yyjson_num_equals(lhs, rhs);
+
+        case YYJSON_TYPE_RAW:
+        case YYJSON_TYPE_STR:
+            return unsafe_yyjson_mut_equals_strn(lhs,
+                unsafe_yyjson_mut_get_str(rhs),
+                unsafe_yyjson_mut_get_len(rhs));
+
+        case YYJSON_TYPE_NULL:
+        case YYJSON_TYPE_BOOL:
+            return unsafe_yyjson_get_subtype(lhs) ==
+                   unsafe_yyjson_get_subtype(rhs);
+
+        default:
+            return false;
     }
-    if (has_allow(COMMENTS)) {
-        if (code == YYJSON_READ_ERROR_INVALID_COMMENT) {
-            /* unclosed multiline comment */
-            return true;
-        }
-        if (code == YYJSON_READ_ERROR_UNEXPECTED_CHARACTER &&
-            *cur == '/' && cur + 1 == eof) {
-            /* truncated beginning of comment */
-            return true;
-        }
+}
+
+bool yyjson_locate_pos(const char *str, size_t len, size_t pos,
+                       size_t *line, size_t *col, size_t *chr) {
+    usize line_sum = 0, line_pos = 0, chr_sum = 0;
+    const u8 *cur = (const u8 *)str;
+    const u8 *end = cur + pos;
+
+    if (!str || pos > len) {
+        if (line) *line = 0;
+        if (col) *col = 0;
+        if (chr) *chr = 0;
+        return false;
     }
-    if (code == YYJSON_READ_ERROR_UNEXPECTED_CHARACTER &&
-        has_allow(BOM)) {
-        /* truncated UTF-8 BOM */
-        usize len = (usize)(eof - cur);
-        if (cur == hdr && len < 3 && !memcmp(hdr, "\xEF\xBB\xBF", len)) {
-            return true;
+
+    if (pos >= 3 && is_utf8_bom(cur)) cur += 3; /* don't count BOM */
+    while (cur < end) {
+        u8 c = *cur;
+        chr_sum += 1;
+        if (likely(c < 0x80)) {         /* 0xxxxxxx (0x00-0x7F) ASCII */
+            if (c == '\n') {
+                line_sum += 1;
+                line_pos = chr_sum;
+            }
+            cur += 1;
         }
+        else if (c < 0xC0) cur += 1;    /* 10xxxxxx (0x80-0xBF) Invalid */
+        else if (c < 0xE0) cur += 2;    /* 110xxxxx (0xC0-0xDF) 2-byte UTF-8 */
+        else if (c < 0xF0) cur += 3;    /* 1110xxxx (0xE0-0xEF) 3-byte UTF-8 */
+        else if (c < 0xF8) cur += 4;    /* 11110xxx (0xF0-0xF7) 4-byte UTF-8 */
+        else               cur += 1;    /* 11111xxx (0xF8-0xFF) Invalid */
     }
-    return false;
+    if (line) *line = line_sum + 1;
+    if (col) *col = chr_sum - line_pos + 1;
+    if (chr) *chr = chr_sum;
+    return true;
 }
 
 
 
-#if !YYJSON_DISABLE_FAST_FP_CONV /* FP_READER */
-
 /*==============================================================================
- * MARK: - BigInt For Floating Point Number Reader (Private)
+ * MARK: - JSON Container Index (Public)
  *
- * The bigint algorithm is used by floating-point number reader to get correctly
- * rounded result for numbers with lots of digits. This part of code is rarely
- * used for common numbers.
+ * The indexes of containers are stored in a side arena owned by the document,
+ * the layout of `yyjson_val` is not changed. A map from the container to its
+ * table is used to find the index of a container.
  *============================================================================*/
 
-/** Unsigned arbitrarily large integer */
-typedef struct bigint {
-    u32 used; /* used chunks count, should not be 0 */
-    u64 bits[64]; /* chunks (58 is enough here) */
-} bigint;
+/** A chunk of the index arena, followed by its memory. */
+typedef struct idx_chunk {
+    struct idx_chunk *next; /* the previous chunk */
+    usize size; /* size of this chunk, including the header */
+} idx_chunk;
+
+/** An entry of the container map. */
+typedef struct idx_entry {
+    const void *ctn; /* the container, NULL if empty */
+    void *tab; /* the index table of the container */
+} idx_entry;
+
+/** An open addressing map from containers to their index tables. */
+typedef struct idx_map {
+    idx_entry *ent; /* the entries, NULL if empty */
+    usize len; /* number of used entries */
+    usize cap; /* capacity of the entries, power of 2 */
+} idx_map;
+
+/** The indexes of containers, opaque in the API. */
+struct yyjson_doc_idx {
+    idx_chunk *chunk; /* the newest chunk of the arena */
+    usize used; /* used size of the newest chunk, including the header */
+    usize size; /* total memory size of the indexes */
+    idx_map map; /* map from containers to tables */
+};
 
-/**
- Evaluate 'big += val'.
- @param big A big number (can be 0).
- @param val An unsigned integer (can be 0).
- */
-static_inline void bigint_add_u64(bigint *big, u64 val) {
-    u32 idx, max;
-    u64 num = big->bits[0];
-    u64 add = num + val;
-    big->bits[0] = add;
-    if (likely((add >= num) || (add >= val))) return;
-    for ((void)(idx = 1), max = big->used; idx < max; idx++) {
-        if (likely(big->bits[idx] != U64_MAX)) {
-            big->bits[idx] += 1;
-            return;
+/** The hash table of an object, with linear probing. */
+typedef struct obj_idx_tab {
+    usize mask; /* capacity - 1, the capacity is power of 2 */
+    u64 slots[1]; /* (hash_hi << 32) | key_ofs, 0 if empty,
+                     key_ofs is the offset from the object in values */
+} obj_idx_tab;
+
+/** Returns the hash of a string. */
+static_inline u64 idx_hash_str(const u8 *str, usize len) {
+    u64 mul = U64(0x9E3779B9, 0x7F4A7C15), h = mul ^ (u64)len, v;
+    for (; len >= 8; str += 8, len -= 8) {
+        byte_copy_8(&v, str);
+        h = (h ^ v) * mul;
+        h ^= h >> 29;
+    }
+    if (len) {
+        v = 0;
+        while (len--) v = (v << 8) | str[len];
+        h = (h ^ v) * mul;
+    }
+    h ^= h >> 32;
+    h *= U64(0xBF58476D, 0x1CE4E5B9);
+    h ^= h >> 29;
+    return h;
+}
+
+/** Returns the hash of a container pointer. */
+static_inline usize idx_hash_ptr(const void *ctn) {
+    u64 h = (u64)((usize)ctn >> 4) * U64(0x9E3779B9, 0x7F4A7C15);
+    return (usize)(h >> 32);
+}
+
+/** Allocate memory from the index arena, aligned to 8 bytes. */
+static void *idx_alloc(yyjson_doc *doc, usize size) {
+    yyjson_doc_idx *idx = doc->ext.idx;
+    idx_chunk *chunk = idx->chunk;
+    usize hdr = size_align_up(sizeof(idx_chunk), 8);
+    void *ptr;
+
+    size = size_align_up(size, 8);
+    if (!chunk || chunk->size - idx->used < size) {
+        usize chunk_size = chunk ? chunk->size * 2 : 0;
+        if (chunk_size < YYJSON_DOC_IDX_CHUNK_MIN_SIZE) {
+            chunk_size = YYJSON_DOC_IDX_CHUNK_MIN_SIZE;
         }
-        big->bits[idx] = 0;
+        if (chunk_size > YYJSON_DOC_IDX_CHUNK_MAX_SIZE) {
+            chunk_size = YYJSON_DOC_IDX_CHUNK_MAX_SIZE;
+        }
+        if (size > USIZE_MAX - hdr) return NULL;
+        if (chunk_size < size + hdr) chunk_size = size + hdr;
+        chunk = (idx_chunk *)doc->alc.malloc(doc->alc.ctx, chunk_size);
+        if (!chunk) return NULL;
+        chunk->next = idx->chunk;
+        chunk->size = chunk_size;
+        idx->chunk = chunk;
+        idx->used = hdr;
+        idx->size += chunk_size;
+    }
+    ptr = (void *)((u8 *)chunk + idx->used);
+    idx->used += size;
+    return ptr;
+}
+
+/** Returns the map entry of the container, or an empty entry. */
+static_inline idx_entry *idx_map_find(const idx_map *map, const void *ctn) {
+    usize i = idx_hash_ptr(ctn) & (map->cap - 1);
+    while (map->ent[i].ctn && map->ent[i].ctn != ctn) {
+        i = (i + 1) & (map->cap - 1);
     }
-    big->bits[big->used++] = 1;
+    return map->ent + i;
 }
 
-/**
- Evaluate 'big *= val'.
- @param big A big number (can be 0).
- @param val An unsigned integer (cannot be 0).
- */
-static_inline void bigint_mul_u64(bigint *big, u64 val) {
-    u32 idx = 0, max = big->used;
-    u64 hi, lo, carry = 0;
-    for (; idx < max; idx++) {
-        if (big->bits[idx]) break;
-    }
-    for (; idx < max; idx++) {
-        u128_mul_add(big->bits[idx], val, carry, &hi, &lo);
-        big->bits[idx] = lo;
-        carry = hi;
+/** Returns the index table of the container, or NULL. */
+static_inline void *idx_map_get(const idx_map *map, const void *ctn) {
+    if (!map->len) return NULL;
+    return idx_map_find(map, ctn)->tab;
+}
+
+/** Add the index table of the container to the map, the memory size of the
+    map is added to `size`. */
+static bool idx_map_add(idx_map *map, const yyjson_alc *alc, usize *size,
+                        const void *ctn, void *tab) {
+    idx_entry *entry;
+    if ((map->len + 1) * 2 > map->cap) {
+        /* grow the map, keep the load factor no more than 0.5 */
+        usize i, cap = map->cap ? map->cap * 2 : 16;
+        idx_entry *old = map->ent;
+        usize old_cap = map->cap;
+        if (cap > USIZE_MAX / sizeof(idx_entry)) return false;
+        entry = (idx_entry *)alc->malloc(alc->ctx, cap * sizeof(idx_entry));
+        if (!entry) return false;
+        memset(entry, 0, cap * sizeof(idx_entry));
+        map->ent = entry;
+        map->cap = cap;
+        for (i = 0; i < old_cap; i++) {
+            if (old[i].ctn) *idx_map_find(map, old[i].ctn) = old[i];
+        }
+        if (old) alc->free(alc->ctx, old);
+        *size += (cap - old_cap) * sizeof(idx_entry);
     }
-    if (carry) big->bits[big->used++] = carry;
+    entry = idx_map_find(map, ctn);
+    entry->ctn = ctn;
+    entry->tab = tab;
+    map->len++;
+    return true;
 }
 
-/**
- Evaluate 'big *= 2^exp'.
- @param big A big number (can be 0).
- @param exp An exponent integer (can be 0).
- */
-static_inline void bigint_mul_pow2(bigint *big, u32 exp) {
-    u32 shft = exp % 64;
-    u32 move = exp / 64;
-    u32 idx = big->used;
-    if (unlikely(shft == 0)) {
-        for (; idx > 0; idx--) {
-            big->bits[idx + move - 1] = big->bits[idx - 1];
+/** Create the indexes of the document if needed. */
+static_inline bool idx_init(yyjson_doc *doc) {
+    if (doc->ext.idx) return true;
+    doc->ext.idx = (yyjson_doc_idx *)doc->alc.malloc(doc->alc.ctx,
+                                                 sizeof(yyjson_doc_idx));
+    if (!doc->ext.idx) return false;
+    memset(doc->ext.idx, 0, sizeof(yyjson_doc_idx));
+    doc->ext.idx->size = sizeof(yyjson_doc_idx);
+    return true;
+}
+
+/** Returns whether the value is in the document. */
+static_inline bool idx_doc_has(const yyjson_doc *doc, const yyjson_val *val) {
+    return val >= doc->root && val < doc->root + doc->val_read;
+}
+
+/** Returns the value of the key in the object with an index table. */
+static_inline yyjson_val *obj_idx_get(const obj_idx_tab *tab,
+                                      const yyjson_val *obj,
+                                      const char *key, usize key_len) {
+    u64 h = idx_hash_str((const u8 *)key, key_len), slot;
+    usize i = (usize)h & tab->mask;
+    while ((slot = tab->slots[i]) != 0) {
+        if ((u32)(slot >> 32) == (u32)(h >> 32)) {
+            yyjson_val *k = constcast(yyjson_val *)obj + (u32)slot;
+            if (unsafe_yyjson_equals_strn(k, key, key_len)) return k + 1;
         }
-        big->used += move;
-        while (move) big->bits[--move] = 0;
-    } else {
-        big->bits[idx] = 0;
-        for (; idx > 0; idx--) {
-            u64 num = big->bits[idx] << shft;
-            num |= big->bits[idx - 1] >> (64 - shft);
-            big->bits[idx + move] = num;
+        i = (i + 1) & tab->mask;
+    }
+    return NULL;
+}
+
+bool yyjson_obj_index_build(yyjson_doc *doc, const yyjson_val *obj) {
+    obj_idx_tab *tab;
+    yyjson_val *key;
+    usize len, cap, ofs;
+
+    if (!doc || !yyjson_is_obj(obj) || !idx_doc_has(doc, obj)) return false;
+    if (doc->ext.idx && idx_map_get(&doc->ext.idx->map, obj)) return true;
+    len = unsafe_yyjson_get_len(obj);
+    if ((u64)obj->uni.ofs / sizeof(yyjson_val) > U32(0xFFFFFFFF)) return false;
+    for (cap = 8; cap < len * 2; cap *= 2);
+
+    if (!idx_init(doc)) return false;
+    tab = (obj_idx_tab *)idx_alloc(doc, sizeof(obj_idx_tab) +
+                                   (cap - 1) * sizeof(u64));
+    if (!tab) return false;
+    tab->mask = cap - 1;
+    memset(tab->slots, 0, cap * sizeof(u64));
+
+    key = unsafe_yyjson_get_first(constcast(yyjson_val *)obj);
+    while (len-- > 0) {
+        usize key_len = unsafe_yyjson_get_len(key);
+        ofs = (usize)(key - obj);
+        /* keep the first one of the duplicate keys, same as linear search */
+        if (!obj_idx_get(tab, obj, key->uni.str, key_len)) {
+            u64 h = idx_hash_str((const u8 *)key->uni.str, key_len);
+            usize i = (usize)h & tab->mask;
+            while (tab->slots[i]) i = (i + 1) & tab->mask;
+            tab->slots[i] = ((h >> 32) << 32) | (u64)ofs;
         }
-        big->bits[move] = big->bits[0] << shft;
-        big->used += move + (big->bits[big->used + move] > 0);
-        while (move) big->bits[--move] = 0;
+        key = unsafe_yyjson_get_next(key + 1);
     }
+    return idx_map_add(&doc->ext.idx->map, &doc->alc, &doc->ext.idx->size,
+                       obj, (void *)tab);
 }
 
-/**
- Evaluate 'big *= 10^exp'.
- @param big A big number (can be 0).
- @param exp An exponent integer (cannot be 0).
- */
-static_inline void bigint_mul_pow10(bigint *big, i32 exp) {
-    for (; exp >= U64_POW10_MAX_EXACT_EXP; exp -= U64_POW10_MAX_EXACT_EXP) {
-        bigint_mul_u64(big, u64_pow10_table[U64_POW10_MAX_EXACT_EXP]);
+yyjson_val *yyjson_doc_obj_getn(yyjson_doc *doc, const yyjson_val *obj,
+                                const char *key, usize key_len) {
+    obj_idx_tab *tab;
+    if (!doc || !yyjson_is_obj(obj) || !key) {
+        return yyjson_obj_getn(obj, key, key_len);
     }
-    if (exp) {
-        bigint_mul_u64(big, u64_pow10_table[exp]);
+    tab = doc->ext.idx ? (obj_idx_tab *)idx_map_get(&doc->ext.idx->map, obj) : NULL;
+    if (!tab && unsafe_yyjson_get_len(obj) >= YYJSON_DOC_OBJ_INDEX_MIN_SIZE &&
+        yyjson_obj_index_build(doc, obj)) {
+        tab = (obj_idx_tab *)idx_map_get(&doc->ext.idx->map, obj);
     }
+    if (!tab) return yyjson_obj_getn(obj, key, key_len);
+    return obj_idx_get(tab, obj, key, key_len);
 }
 
-/**
- Compare two bigint.
- @return -1 if 'a < b', +1 if 'a > b', 0 if 'a == b'.
- */
-static_inline i32 bigint_cmp(bigint *a, bigint *b) {
-    u32 idx = a->used;
-    if (a->used < b->used) return -1;
-    if (a->used > b->used) return +1;
-    while (idx-- > 0) {
-        u64 av = a->bits[idx];
-        u64 bv = b->bits[idx];
-        if (av < bv) return -1;
-        if (av > bv) return +1;
-    }
-    return 0;
+/** Build the offset index of an array that is not flat. */
+static bool arr_idx_build(yyjson_doc *doc, const yyjson_val *arr) {
+    usize i, len = unsafe_yyjson_get_len(arr);
+    yyjson_val *val;
+    u32 *tab;
+
+    if (doc->ext.idx && idx_map_get(&doc->ext.idx->map, arr)) return true;
+    if ((u64)arr->uni.ofs / sizeof(yyjson_val) > U32(0xFFFFFFFF)) return false;
+    if (!idx_init(doc)) return false;
+    tab = (u32 *)idx_alloc(doc, len * sizeof(u32));
+    if (!tab) return false;
+    val = unsafe_yyjson_get_first(constcast(yyjson_val *)arr);
+    for (i = 0; i < len; i++) {
+        tab[i] = (u32)(val - arr);
+        val = unsafe_yyjson_get_next(val);
+    }
+    return idx_map_add(&doc->ext.idx->map, &doc->alc, &doc->ext.idx->size,
+                       arr, (void *)tab);
 }
 
-/**
- Evaluate 'big = val'.
- @param big A big number (can be 0).
- @param val An unsigned integer (can be 0).
- */
-static_inline void bigint_set_u64(bigint *big, u64 val) {
-    big->used = 1;
-    big->bits[0] = val;
+bool yyjson_arr_index_build(yyjson_doc *doc, const yyjson_val *arr) {
+    if (!doc || !yyjson_is_arr(arr) || !idx_doc_has(doc, arr)) return false;
+    if (unsafe_yyjson_arr_is_flat(arr)) return true;
+    return arr_idx_build(doc, arr);
 }
 
-/** Set a bigint with floating point number string. */
-static_noinline void bigint_set_buf(bigint *big, u64 sig, i32 *exp,
-                                    u8 *sig_cut, u8 *sig_end, u8 *dot_pos) {
+bool yyjson_doc_arr_index_build(yyjson_doc *doc, usize min_size) {
+    yyjson_val *val, *end;
+    if (!doc) return false;
+    val = doc->root;
+    end = val + doc->val_read;
+    for (; val < end; val++) {
+        if (unsafe_yyjson_is_arr(val) &&
+            unsafe_yyjson_get_len(val) >= min_size &&
+            !unsafe_yyjson_arr_is_flat(val)) {
+            if (!arr_idx_build(doc, val)) return false;
+        }
+    }
+    return true;
+}
 
-    if (unlikely(!sig_cut)) {
-        /* no digit cut, set significant part only */
-        bigint_set_u64(big, sig);
-        return;
+yyjson_val *yyjson_doc_arr_get(yyjson_doc *doc, const yyjson_val *arr,
+                               usize idx) {
+    u32 *tab;
+    if (!doc || !yyjson_is_arr(arr) || unsafe_yyjson_arr_is_flat(arr) ||
+        idx >= unsafe_yyjson_get_len(arr)) {
+        return yyjson_arr_get(arr, idx);
+    }
+    tab = doc->ext.idx ? (u32 *)idx_map_get(&doc->ext.idx->map, arr) : NULL;
+    if (!tab && unsafe_yyjson_get_len(arr) >= YYJSON_DOC_ARR_INDEX_MIN_SIZE &&
+        yyjson_arr_index_build(doc, arr)) {
+        tab = (u32 *)idx_map_get(&doc->ext.idx->map, arr);
+    }
+    if (!tab) return yyjson_arr_get(arr, idx);
+    return constcast(yyjson_val *)arr + tab[idx];
+}
 
-    } else {
-        /* some digits were cut, read them from 'sig_cut' to 'sig_end' */
-        u8 *hdr = sig_cut;
-        u8 *cur = hdr;
-        u32 len = 0;
-        u64 val = 0;
-        bool dig_big_cut = false;
-        bool has_dot = (hdr < dot_pos) & (dot_pos < sig_end);
-        u32 dig_len_total = U64_SAFE_DIG + (u32)(sig_end - hdr) - has_dot;
+bool yyjson_doc_arr_slice(yyjson_doc *doc, const yyjson_val *arr,
+                          usize start, usize end, yyjson_arr_iter *iter) {
+    if (!yyjson_arr_iter_init(arr, iter)) return false;
+    if (end > iter->max) end = iter->max;
+    if (start >= end) {
+        iter->idx = iter->max = 0;
+        return true;
+    }
+    iter->idx = start;
+    iter->max = end;
+    iter->cur = yyjson_doc_arr_get(doc, arr, start);
+    return true;
+}
 
-        sig -= (*sig_cut >= '5'); /* sig was rounded before */
-        if (dig_len_total > F64_MAX_DEC_DIG) {
-            dig_big_cut = true;
-            sig_end -= dig_len_total - (F64_MAX_DEC_DIG + 1);
-            sig_end -= (dot_pos + 1 == sig_end);
-            dig_len_total = (F64_MAX_DEC_DIG + 1);
-        }
-        *exp -= (i32)dig_len_total - U64_SAFE_DIG;
+usize yyjson_doc_index_size(const yyjson_doc *doc) {
+    return (doc && doc->ext.idx) ? doc->ext.idx->size : 0;
+}
 
-        big->used = 1;
-        big->bits[0] = sig;
-        while (cur < sig_end) {
-            if (likely(cur != dot_pos)) {
-                val = val * 10 + (u8)(*cur++ - '0');
-                len++;
-                if (unlikely(cur == sig_end && dig_big_cut)) {
-                    /* The last digit must be non-zero,    */
-                    /* set it to '1' for correct rounding. */
-                    val = val - (val % 10) + 1;
-                }
-                if (len == U64_SAFE_DIG || cur == sig_end) {
-                    bigint_mul_pow10(big, (i32)len);
-                    bigint_add_u64(big, val);
-                    val = 0;
-                    len = 0;
-                }
-            } else {
-                cur++;
-            }
-        }
+void yyjson_doc_index_free(yyjson_doc *doc) {
+    yyjson_doc_idx *idx;
+    idx_chunk *chunk, *next;
+    if (!doc || !doc->ext.idx) return;
+    idx = doc->ext.idx;
+    for (chunk = idx->chunk; chunk; chunk = next) {
+        next = chunk->next;
+        doc->alc.free(doc->alc.ctx, chunk);
     }
+    if (idx->map.ent) doc->alc.free(doc->alc.ctx, idx->map.ent);
+    doc->alc.free(doc->alc.ctx, idx);
+    doc->ext.idx = NULL;
 }
 
 
 
 /*==============================================================================
- * MARK: - Diy Floating Point (Private)
+ * MARK: - Mutable JSON Container Index (Public)
+ *
+ * An indexed container is still a linked list, it has `YYJSON_MUT_IDX_FLAG` in
+ * its tag, and its index table is kept up to date by the modification
+ * functions, or dropped by the functions that can't update it. An array index
+ * holds the elements in order. An object index is a hash table of the keys,
+ * each key holds the key of its previous pair, so a pair can be unlinked in a
+ * constant time. Without `YYJSON_MUT_COMPACT`, the container points to its
+ * table, and the table holds the last child. In compact layout, the table is
+ * found by the map of the document. A dropped table is kept in the map, and
+ * reused when the container is indexed again.
  *============================================================================*/
 
-/** "Do It Yourself Floating Point" struct. */
-typedef struct diy_fp {
-    u64 sig; /* significand */
-    i32 exp; /* exponent, base 2 */
-    i32 pad; /* padding, useless */
-} diy_fp;
+/** The indexes of mutable containers, opaque in the API. */
+struct yyjson_mut_doc_idx {
+    usize size; /* total memory size of the indexes */
+    idx_map map; /* map from containers to tables */
+};
 
-/** Get cached rounded diy_fp for pow(10, e). The input value must be in the
-    range [POW10_SIG_TABLE_MIN_EXP, POW10_SIG_TABLE_MAX_EXP]. */
-static_inline diy_fp diy_fp_get_cached_pow10(i32 exp10) {
-    diy_fp fp;
-    u64 sig_ext;
-    pow10_table_get_sig(exp10, &fp.sig, &sig_ext);
-    pow10_table_get_exp(exp10, &fp.exp);
-    fp.sig += (sig_ext >> 63);
-    return fp;
+/** The header of a mutable container's index table. */
+typedef struct mut_idx_hdr {
+    yyjson_mut_val *last; /* last child, in place of the container's link */
+    yyjson_mut_doc *doc; /* the document of the container */
+    usize size; /* memory size of the table */
+} mut_idx_hdr;
+
+/** The index table of a mutable array. */
+typedef struct mut_arr_idx {
+    mut_idx_hdr hdr;
+    usize cap; /* capacity of the elements */
+    yyjson_mut_val *vals[1]; /* the elements in order */
+} mut_arr_idx;
+
+/** A slot of the mutable object hash table. */
+typedef struct mut_obj_slot {
+    yyjson_mut_val *key; /* the key, NULL if empty */
+    yyjson_mut_val *prev; /* the key of the previous pair */
+    u64 hash; /* hash of the key string */
+} mut_obj_slot;
+
+/** The hash table of a mutable object, with linear probing.
+    Only the first one of the duplicate keys has a slot. */
+typedef struct mut_obj_idx {
+    mut_idx_hdr hdr;
+    usize dup; /* number of the duplicate keys */
+    usize mask; /* capacity - 1, the capacity is power of 2 */
+    mut_obj_slot slots[1];
+} mut_obj_idx;
+
+static_inline usize mut_arr_idx_size(usize cap) {
+    return sizeof(mut_arr_idx) + (cap - 1) * sizeof(yyjson_mut_val *);
 }
 
-/** Returns fp * fp2. */
-static_inline diy_fp diy_fp_mul(diy_fp fp, diy_fp fp2) {
-    u64 hi, lo;
-    u128_mul(fp.sig, fp2.sig, &hi, &lo);
-    fp.sig = hi + (lo >> 63);
-    fp.exp += fp2.exp + 64;
-    return fp;
+static_inline usize mut_obj_idx_size(usize cap) {
+    return sizeof(mut_obj_idx) + (cap - 1) * sizeof(mut_obj_slot);
 }
 
-/** Convert diy_fp to IEEE-754 raw value. */
-static_inline u64 diy_fp_to_ieee_raw(diy_fp fp) {
-    u64 sig = fp.sig;
-    i32 exp = fp.exp;
-    u32 lz_bits;
-    if (unlikely(fp.sig == 0)) return 0;
+/** Returns the index table of an indexed container. */
+static_inline mut_idx_hdr *mut_idx_tab(const yyjson_mut_val *ctn) {
+#if YYJSON_MUT_COMPACT
+    yyjson_mut_doc *doc = unsafe_yyjson_mut_chunk(ctn)->doc;
+    return (mut_idx_hdr *)idx_map_get(&doc->idx->map, ctn);
+#else
+    return (mut_idx_hdr *)ctn->uni.ptr;
+#endif
+}
 
-    lz_bits = u64_lz_bits(sig);
-    sig <<= lz_bits;
-    sig >>= F64_BITS - F64_SIG_FULL_BITS;
-    exp -= (i32)lz_bits;
-    exp += F64_BITS - F64_SIG_FULL_BITS;
-    exp += F64_SIG_BITS;
+/** Returns whether the container has the table as its index. */
+static_inline bool mut_idx_has_tab(const yyjson_mut_val *ctn,
+                                   const mut_idx_hdr *tab) {
+    return unsafe_yyjson_mut_is_indexed(ctn) && mut_idx_tab(ctn) == tab;
+}
 
-    if (unlikely(exp >= F64_MAX_BIN_EXP)) {
-        /* overflow */
-        return F64_BITS_INF;
-    } else if (likely(exp >= F64_MIN_BIN_EXP - 1)) {
-        /* normal */
-        exp += F64_EXP_BIAS;
-        return ((u64)exp << F64_SIG_BITS) | (sig & F64_SIG_MASK);
-    } else if (likely(exp >= F64_MIN_BIN_EXP - F64_SIG_FULL_BITS)) {
-        /* subnormal */
-        return sig >> (F64_MIN_BIN_EXP - exp - 1);
+/** Create the indexes of the mutable document if needed. */
+static_inline bool mut_idx_init(yyjson_mut_doc *doc) {
+    if (doc->idx) return true;
+    doc->idx = (yyjson_mut_doc_idx *)doc->alc.malloc(
+        doc->alc.ctx, sizeof(yyjson_mut_doc_idx));
+    if (!doc->idx) return false;
+    memset(doc->idx, 0, sizeof(yyjson_mut_doc_idx));
+    doc->idx->size = sizeof(yyjson_mut_doc_idx);
+    return true;
+}
+
+/** Allocate a table of at least `size` bytes for the container. The table of
+    the container in the map is reused if it's large enough, or resized with
+    its content kept if `keep` is true. Returns NULL on failure, the old table
+    is not changed. */
+static mut_idx_hdr *mut_idx_alloc(yyjson_mut_doc *doc, yyjson_mut_val *ctn,
+                                  usize size, bool keep) {
+    const yyjson_alc *alc = &doc->alc;
+    mut_idx_hdr *old, *tab;
+    usize old_size;
+    if (!mut_idx_init(doc)) return NULL;
+    old = (mut_idx_hdr *)idx_map_get(&doc->idx->map, ctn);
+    if (old && old->size >= size) return old;
+    old_size = old ? old->size : 0;
+    if (old && keep) {
+        tab = (mut_idx_hdr *)alc->realloc(alc->ctx, old, old_size, size);
+        if (!tab) return NULL;
     } else {
-        /* underflow */
-        return 0;
+        tab = (mut_idx_hdr *)alc->malloc(alc->ctx, size);
+        if (!tab) return NULL;
+        if (old) {
+            tab->last = old->last;
+            alc->free(alc->ctx, old);
+        }
+    }
+    if (old) {
+        idx_map_find(&doc->idx->map, ctn)->tab = (void *)tab;
+    } else if (!idx_map_add(&doc->idx->map, alc, &doc->idx->size,
+                            ctn, (void *)tab)) {
+        alc->free(alc->ctx, tab);
+        return NULL;
     }
+#if !YYJSON_MUT_COMPACT
+    if (unsafe_yyjson_mut_is_indexed(ctn)) ctn->uni.ptr = (void *)tab;
+#endif
+    tab->doc = doc;
+    tab->size = size;
+    doc->idx->size += size - old_size;
+    return tab;
 }
 
+/** Set the table as the index of the container. */
+static_inline void mut_idx_attach(yyjson_mut_val *ctn, mut_idx_hdr *tab) {
+#if !YYJSON_MUT_COMPACT
+    tab->last = (yyjson_mut_val *)ctn->uni.ptr;
+    ctn->uni.ptr = (void *)tab;
+#endif
+    ctn->tag |= YYJSON_MUT_IDX_FLAG;
+}
 
+/** Returns whether the container can be indexed in the document. */
+static_inline bool mut_idx_doc_has(yyjson_mut_doc *doc,
+                                   const yyjson_mut_val *ctn) {
+#if YYJSON_MUT_COMPACT
+    return unsafe_yyjson_mut_chunk(ctn)->doc == doc;
+#else
+    (void)doc;
+    (void)ctn;
+    return true;
+#endif
+}
 
-/*==============================================================================
- * MARK: - Number Reader (Private)
- *============================================================================*/
+/** Fill the array index with the elements of the array. */
+static void mut_arr_idx_fill(mut_arr_idx *tab, yyjson_mut_val *arr) {
+    usize i, len = unsafe_yyjson_mut_get_len(arr);
+    yyjson_mut_val *val = len ? unsafe_yyjson_mut_get_last(arr) : NULL;
+    for (i = 0; i < len; i++) {
+        val = unsafe_yyjson_mut_get_next(val);
+        tab->vals[i] = val;
+    }
+}
 
-/**
- Read a JSON number.
+/** Reserve the index of an indexed array for at least `cap` elements.
+    Returns NULL and drops the index on failure. */
+static mut_arr_idx *mut_arr_idx_reserve(yyjson_mut_val *arr, usize cap) {
+    mut_arr_idx *tab = (mut_arr_idx *)mut_idx_tab(arr);
+    usize max_cap = (USIZE_MAX - sizeof(mut_arr_idx)) /
+                    sizeof(yyjson_mut_val *);
+    if (cap <= tab->cap) return tab;
+    if (cap < tab->cap + tab->cap / 2) cap = tab->cap + tab->cap / 2;
+    if (cap <= max_cap) {
+        tab = (mut_arr_idx *)mut_idx_alloc(tab->hdr.doc, arr,
+                                           mut_arr_idx_size(cap), true);
+    } else {
+        tab = NULL;
+    }
+    if (!tab) {
+        unsafe_yyjson_mut_idx_drop(arr);
+        return NULL;
+    }
+    tab->cap = cap;
+    return tab;
+}
 
- 1. This function assume that the floating-point number is in IEEE-754 format.
- 2. This function support uint64/int64/double number. If an integer number
-    cannot fit in uint64/int64, it will returns as a double number. If a double
-    number is infinite, the return value is based on flag.
- 3. This function (with inline attribute) may generate a lot of instructions.
- */
-static_inline bool read_num(u8 **ptr, u8 **pre, yyjson_read_flag flg,
-                            yyjson_val *val, const char **msg) {
-#define return_err(_pos, _msg) do { \
-    *msg = _msg; \
-    *end = _pos; \
-    return false; \
-} while (false)
+bool yyjson_mut_arr_index_build(yyjson_mut_doc *doc, yyjson_mut_val *arr) {
+    mut_arr_idx *tab;
+    usize cap;
+    if (!doc || !yyjson_mut_is_arr(arr)) return false;
+    if (unsafe_yyjson_mut_is_indexed(arr)) return true;
+    if (!mut_idx_doc_has(doc, arr)) return false;
+    cap = unsafe_yyjson_mut_get_len(arr);
+    if (cap < 8) cap = 8;
+    if (cap > (USIZE_MAX - sizeof(mut_arr_idx)) / sizeof(yyjson_mut_val *)) {
+        return false;
+    }
+    tab = (mut_arr_idx *)mut_idx_alloc(doc, arr, mut_arr_idx_size(cap), false);
+    if (!tab) return false;
+    tab->cap = (tab->hdr.size - sizeof(mut_arr_idx)) /
+               sizeof(yyjson_mut_val *) + 1;
+    mut_arr_idx_fill(tab, arr);
+    mut_idx_attach(arr, &tab->hdr);
+    return true;
+}
 
-#define return_0() do { \
-    val->tag = YYJSON_TYPE_NUM | (u8)((u8)sign << 3); \
-    val->uni.u64 = 0; \
-    *end = cur; return true; \
-} while (false)
+yyjson_mut_val *unsafe_yyjson_mut_arr_idx_get(const yyjson_mut_val *arr,
+                                              usize idx) {
+    return ((mut_arr_idx *)mut_idx_tab(arr))->vals[idx];
+}
 
-#define return_i64(_v) do { \
-    val->tag = YYJSON_TYPE_NUM | (u8)((u8)sign << 3); \
-    val->uni.u64 = (u64)(sign ? (u64)(~(_v) + 1) : (u64)(_v)); \
-    *end = cur; return true; \
-} while (false)
+bool unsafe_yyjson_mut_arr_idx_insert(yyjson_mut_val *arr,
+                                      yyjson_mut_val *val, usize idx) {
+    usize len = unsafe_yyjson_mut_get_len(arr);
+    mut_arr_idx *tab = mut_arr_idx_reserve(arr, len + 1);
+    if (!tab) return yyjson_mut_arr_insert(arr, val, idx);
 
-#define return_f64(_v) do { \
-    val->tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL; \
-    val->uni.f64 = sign ? -(f64)(_v) : (f64)(_v); \
-    *end = cur; return true; \
-} while (false)
+    if (len == 0) {
+        unsafe_yyjson_mut_set_next(val, val);
+        unsafe_yyjson_mut_set_last(arr, val);
+    } else {
+        yyjson_mut_val *prev = idx ? tab->vals[idx - 1] : tab->vals[len - 1];
+        unsafe_yyjson_mut_set_next(val, unsafe_yyjson_mut_get_next(prev));
+        unsafe_yyjson_mut_set_next(prev, val);
+        if (idx == len) unsafe_yyjson_mut_set_last(arr, val);
+    }
+    memmove(tab->vals + idx + 1, tab->vals + idx,
+            (len - idx) * sizeof(yyjson_mut_val *));
+    tab->vals[idx] = val;
+    unsafe_yyjson_mut_set_len(arr, len + 1);
+    return true;
+}
 
-#define return_f64_bin(_v) do { \
-    val->tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL; \
-    val->uni.u64 = ((u64)sign << 63) | (u64)(_v); \
-    *end = cur; return true; \
-} while (false)
-
-#define return_inf() do { \
-    if (has_flg(BIGNUM_AS_RAW)) return_raw(); \
-    if (has_allow(INF_AND_NAN)) return_f64_bin(F64_BITS_INF); \
-    else return_err(hdr, "number is infinity when parsed as double"); \
-} while (false)
-
-#define return_raw() do { \
-    **pre = '\0'; /* add null-terminator for previous raw string */ \
-    val->tag = ((u64)(cur - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_RAW; \
-    val->uni.str = (const char *)hdr; \
-    *pre = cur; *end = cur; return true; \
-} while (false)
+yyjson_mut_val *unsafe_yyjson_mut_arr_idx_replace(yyjson_mut_val *arr,
+                                                  usize idx,
+                                                  yyjson_mut_val *val) {
+    usize len = unsafe_yyjson_mut_get_len(arr);
+    mut_arr_idx *tab = (mut_arr_idx *)mut_idx_tab(arr);
+    yyjson_mut_val *old = tab->vals[idx];
+    if (len == 1) {
+        unsafe_yyjson_mut_set_next(val, val);
+    } else {
+        yyjson_mut_val *prev = idx ? tab->vals[idx - 1] : tab->vals[len - 1];
+        unsafe_yyjson_mut_set_next(prev, val);
+        unsafe_yyjson_mut_set_next(val, unsafe_yyjson_mut_get_next(old));
+    }
+    if (idx == len - 1) unsafe_yyjson_mut_set_last(arr, val);
+    tab->vals[idx] = val;
+    return old;
+}
 
-    u8 *sig_cut = NULL; /* significant part cutting position for long number */
-    u8 *sig_end = NULL; /* significant part ending position */
-    u8 *dot_pos = NULL; /* decimal point position */
+yyjson_mut_val *unsafe_yyjson_mut_arr_idx_remove(yyjson_mut_val *arr,
+                                                 usize idx) {
+    usize len = unsafe_yyjson_mut_get_len(arr);
+    mut_arr_idx *tab = (mut_arr_idx *)mut_idx_tab(arr);
+    yyjson_mut_val *old = tab->vals[idx];
+    if (len > 1) {
+        yyjson_mut_val *prev = idx ? tab->vals[idx - 1] : tab->vals[len - 1];
+        unsafe_yyjson_mut_set_next(prev, unsafe_yyjson_mut_get_next(old));
+        if (idx == len - 1) unsafe_yyjson_mut_set_last(arr, prev);
+    }
+    memmove(tab->vals + idx, tab->vals + idx + 1,
+            (len - idx - 1) * sizeof(yyjson_mut_val *));
+    unsafe_yyjson_mut_set_len(arr, len - 1);
+    return old;
+}
 
-    u64 sig = 0; /* significant part of the number */
-    i32 exp = 0; /* exponent part of the number */
+/** Returns the slot of the key string, or an empty slot. */
+static_inline mut_obj_slot *mut_obj_idx_find(mut_obj_idx *tab,
+                                             const char *key, usize key_len,
+                                             u64 hash) {
+    usize i = (usize)hash & tab->mask;
+    while (tab->slots[i].key) {
+        if (tab->slots[i].hash == hash &&
+            unsafe_yyjson_mut_equals_strn(tab->slots[i].key, key, key_len)) {
+            break;
+        }
+        i = (i + 1) & tab->mask;
+    }
+    return tab->slots + i;
+}
 
-    bool exp_sign; /* temporary exponent sign from literal part */
-    i64 exp_sig = 0; /* temporary exponent number from significant part */
-    i64 exp_lit = 0; /* temporary exponent number from exponent literal part */
-    u64 num; /* temporary number for reading */
-    u8 *tmp; /* temporary cursor for reading */
+/** Returns the slot of the key value, or NULL if the key has no slot. */
+static_inline mut_obj_slot *mut_obj_idx_find_key(mut_obj_idx *tab,
+                                                 const yyjson_mut_val *key) {
+    u64 hash = idx_hash_str((const u8 *)unsafe_yyjson_mut_get_str(key),
+                            unsafe_yyjson_mut_get_len(key));
+    usize i = (usize)hash & tab->mask;
+    while (tab->slots[i].key) {
+        if (tab->slots[i].key == key) return tab->slots + i;
+        i = (i + 1) & tab->mask;
+    }
+    return NULL;
+}
 
-    u8 *hdr = *ptr;
-    u8 *cur = *ptr;
-    u8 **end = ptr;
-    bool sign;
+/** Delete the slot, the following slots are shifted back. */
+static void mut_obj_idx_del(mut_obj_idx *tab, mut_obj_slot *slot) {
+    usize i = (usize)(slot - tab->slots), j = i, home;
+    while (true) {
+        j = (j + 1) & tab->mask;
+        if (!tab->slots[j].key) break;
+        home = (usize)tab->slots[j].hash & tab->mask;
+        /* move the slot if its home position is not in range (i, j] */
+        if (i < j ? (home <= i || home > j) : (home <= i && home > j)) {
+            tab->slots[i] = tab->slots[j];
+            i = j;
+        }
+    }
+    tab->slots[i].key = NULL;
+}
 
-    /* read number as raw string if has `YYJSON_READ_NUMBER_AS_RAW` flag */
-    if (has_flg(NUMBER_AS_RAW)) {
-        return read_num_raw(ptr, pre, flg, val, msg);
+/** Allocate the object index for `num` keys, and fill it with the keys of
+    the object. Returns NULL on failure, the old index is not changed. */
+static mut_obj_idx *mut_obj_idx_fill(yyjson_mut_doc *doc, yyjson_mut_val *obj,
+                                     usize num) {
+    usize cap = 8, len = unsafe_yyjson_mut_get_len(obj);
+    usize max_cap = (USIZE_MAX - sizeof(mut_obj_idx)) / sizeof(mut_obj_slot);
+    yyjson_mut_val *prev;
+    mut_obj_idx *tab;
+
+    if (num > max_cap / 4) return NULL;
+    while (cap < num * 2) cap *= 2;
+    tab = (mut_obj_idx *)mut_idx_alloc(doc, obj, mut_obj_idx_size(cap), false);
+    if (!tab) return NULL;
+    memset(tab->slots, 0, cap * sizeof(mut_obj_slot));
+    tab->mask = cap - 1;
+    tab->dup = 0;
+    prev = len ? unsafe_yyjson_mut_get_last(obj) : NULL;
+    while (len-- > 0) {
+        yyjson_mut_val *prev_val = unsafe_yyjson_mut_get_next(prev);
+        yyjson_mut_val *key = unsafe_yyjson_mut_get_next(prev_val);
+        const char *key_str = unsafe_yyjson_mut_get_str(key);
+        usize key_len = unsafe_yyjson_mut_get_len(key);
+        u64 hash = idx_hash_str((const u8 *)key_str, key_len);
+        mut_obj_slot *slot = mut_obj_idx_find(tab, key_str, key_len, hash);
+        /* keep the first one of the duplicate keys, same as linear search */
+        if (slot->key) {
+            tab->dup++;
+        } else {
+            slot->key = key;
+            slot->prev = prev;
+            slot->hash = hash;
+        }
+        prev = key;
     }
+    return tab;
+}
 
-    sign = (*hdr == '-');
-    cur += sign;
+bool yyjson_mut_obj_index_build(yyjson_mut_doc *doc, yyjson_mut_val *obj) {
+    mut_obj_idx *tab;
+    if (!doc || !yyjson_mut_is_obj(obj)) return false;
+    if (unsafe_yyjson_mut_is_indexed(obj)) return true;
+    if (!mut_idx_doc_has(doc, obj)) return false;
+    tab = mut_obj_idx_fill(doc, obj, unsafe_yyjson_mut_get_len(obj));
+    if (!tab) return false;
+    mut_idx_attach(obj, &tab->hdr);
+    return true;
+}
 
-    /* begin with a leading zero or non-digit */
-    while (unlikely(!char_is_nonzero(*cur))) { /* 0 or non-digit char */
-        if (unlikely(*cur != '0')) { /* non-digit char */
-            if (has_allow(EXT_NUMBER)) {
-                if (*cur == '+' && cur == hdr) { /* leading `+` sign */
-                    cur++;
-                    continue;
-                }
-                if (*cur == '.' && char_is_digit(cur[1])) { /* e.g. '.123' */
-                    goto leading_dot;
-                }
-            }
-            if (has_allow(INF_AND_NAN)) {
-                if (read_inf_or_nan(ptr, pre, flg, val)) return true;
-            }
-            return_err(cur, "no digit after sign");
-        }
-        /* begin with 0 */
-        if (likely(!char_is_digit_or_fp(*++cur))) {
-            if (has_allow(EXT_NUMBER) && char_to_lower(*cur) == 'x') { /* hex */
-                return read_num_hex(ptr, pre, flg, val, msg);
-            }
-            return_0();
-        }
-        if (likely(*cur == '.')) {
-leading_dot:
-            dot_pos = cur++;
-            if (unlikely(!char_is_digit(*cur))) {
-                if (has_allow(EXT_NUMBER)) {
-                    if (char_is_exp(*cur)) {
-                        goto digi_exp_more;
-                    } else {
-                        return_f64_bin(0);
-                    }
-                }
-                return_err(cur, "no digit after decimal point");
-            }
-            while (unlikely(*cur == '0')) cur++;
-            if (likely(char_is_digit(*cur))) {
-                /* first non-zero digit after decimal point */
-                sig = (u64)(*cur - '0'); /* read first digit */
-                cur--;
-                goto digi_frac_1; /* continue read fraction part */
-            }
-        }
-        if (unlikely(char_is_digit(*cur))) {
-            return_err(cur - 1, "number with leading zero is not allowed");
-        }
-        if (unlikely(char_is_exp(*cur))) { /* 0 with any exponent is still 0 */
-            cur += (usize)1 + char_is_sign(cur[1]);
-            if (unlikely(!char_is_digit(*cur))) {
-                return_err(cur, "no digit after exponent sign");
-            }
-            while (char_is_digit(*++cur));
+yyjson_mut_val *unsafe_yyjson_mut_obj_idx_getn(const yyjson_mut_val *obj,
+                                               const char *key,
+                                               usize key_len) {
+    mut_obj_idx *tab = (mut_obj_idx *)mut_idx_tab(obj);
+    mut_obj_slot *slot = mut_obj_idx_find(tab, key, key_len,
+                                          idx_hash_str((const u8 *)key,
+                                                       key_len));
+    return slot->key ? unsafe_yyjson_mut_get_next(slot->key) : NULL;
+}
+
+void unsafe_yyjson_mut_obj_idx_add(yyjson_mut_val *obj, yyjson_mut_val *key) {
+    usize len = unsafe_yyjson_mut_get_len(obj);
+    mut_obj_idx *tab = (mut_obj_idx *)mut_idx_tab(obj);
+    const char *key_str = unsafe_yyjson_mut_get_str(key);
+    usize key_len = unsafe_yyjson_mut_get_len(key);
+    u64 hash = idx_hash_str((const u8 *)key_str, key_len);
+    mut_obj_slot *slot;
+
+    if ((len - tab->dup + 1) * 2 > tab->mask + 1) {
+        /* grow the table, keep the load factor no more than 0.5 */
+        tab = mut_obj_idx_fill(tab->hdr.doc, obj, len + 1);
+        if (!tab) {
+            unsafe_yyjson_mut_idx_drop(obj);
+            return;
         }
-        return_f64_bin(0);
     }
+    slot = mut_obj_idx_find(tab, key_str, key_len, hash);
+    if (slot->key) {
+        tab->dup++;
+    } else {
+        slot->key = key;
+        slot->prev = len ? unsafe_yyjson_mut_get_last(obj) : key;
+        slot->hash = hash;
+    }
+    if (len) {
+        /* the new pair will be the previous pair of the first one */
+        yyjson_mut_val *last = unsafe_yyjson_mut_get_last(obj);
+        yyjson_mut_val *first_key = unsafe_yyjson_mut_get_next(
+            unsafe_yyjson_mut_get_next(last));
+        mut_obj_slot *first = mut_obj_idx_find_key(tab, first_key);
+        if (first) first->prev = key;
+    }
+}
 
-    /* begin with non-zero digit */
-    sig = (u64)(*cur - '0');
+/** Remove the pair of the slot from the object, returns the value. */
+static yyjson_mut_val *mut_obj_idx_remove(mut_obj_idx *tab,
+                                          yyjson_mut_val *obj,
+                                          mut_obj_slot *slot) {
+    yyjson_mut_val *key = slot->key, *prev = slot->prev;
+    yyjson_mut_val *val = unsafe_yyjson_mut_get_next(key);
+    usize len = unsafe_yyjson_mut_get_len(obj);
+    if (len > 1) {
+        yyjson_mut_val *prev_val = unsafe_yyjson_mut_get_next(prev);
+        yyjson_mut_val *next_key = unsafe_yyjson_mut_get_next(val);
+        mut_obj_slot *next = mut_obj_idx_find_key(tab, next_key);
+        unsafe_yyjson_mut_set_next(prev_val, next_key);
+        if (key == unsafe_yyjson_mut_get_last(obj)) {
+            unsafe_yyjson_mut_set_last(obj, prev);
+        }
+        if (next) next->prev = prev;
+    }
+    mut_obj_idx_del(tab, slot);
+    unsafe_yyjson_mut_set_len(obj, len - 1);
+    return val;
+}
 
-    /*
-     Read integral part, same as the following code.
+bool unsafe_yyjson_mut_obj_idx_put(yyjson_mut_val *obj, yyjson_mut_val *key,
+                                   yyjson_mut_val *val) {
+    mut_obj_idx *tab = (mut_obj_idx *)mut_idx_tab(obj);
+    const char *key_str = unsafe_yyjson_mut_get_str(key);
+    usize key_len = unsafe_yyjson_mut_get_len(key);
+    mut_obj_slot *slot;
+    if (tab->dup) {
+        /* the duplicate keys have no slot, use the linear function */
+        unsafe_yyjson_mut_idx_drop(obj);
+        return yyjson_mut_obj_put(obj, key, val);
+    }
+    slot = mut_obj_idx_find(tab, key_str, key_len,
+                            idx_hash_str((const u8 *)key_str, key_len));
+    if (!slot->key) {
+        if (val) {
+            unsafe_yyjson_mut_obj_add(obj, key, val,
+                                      unsafe_yyjson_mut_get_len(obj));
+        }
+    } else if (val) {
+        yyjson_mut_val *old = unsafe_yyjson_mut_get_next(slot->key);
+        unsafe_yyjson_mut_set_next(val, unsafe_yyjson_mut_get_next(old));
+        unsafe_yyjson_mut_set_next(slot->key, val);
+    } else {
+        mut_obj_idx_remove(tab, obj, slot);
+    }
+    return true;
+}
 
-         for (int i = 1; i <= 18; i++) {
-            num = cur[i] - '0';
-            if (num <= 9) sig = num + sig * 10;
-            else goto digi_sepr_i;
-         }
-     */
-#define expr_intg(i) \
-    if (likely((num = (u64)(cur[i] - (u8)'0')) <= 9)) sig = num + sig * 10; \
-    else { goto digi_sepr_##i; }
-    repeat_in_1_18(expr_intg)
-#undef expr_intg
+yyjson_mut_val *unsafe_yyjson_mut_obj_idx_remove(yyjson_mut_val *obj,
+                                                 const char *key,
+                                                 usize key_len) {
+    mut_obj_idx *tab = (mut_obj_idx *)mut_idx_tab(obj);
+    mut_obj_slot *slot;
+    if (tab->dup) {
+        /* the duplicate keys have no slot, use the linear function */
+        unsafe_yyjson_mut_idx_drop(obj);
+        return unsafe_yyjson_mut_obj_remove(obj, key, key_len);
+    }
+    slot = mut_obj_idx_find(tab, key, key_len,
+                            idx_hash_str((const u8 *)key, key_len));
+    if (!slot->key) return NULL;
+    return mut_obj_idx_remove(tab, obj, slot);
+}
 
+usize yyjson_mut_doc_index_size(const yyjson_mut_doc *doc) {
+    return (doc && doc->idx) ? doc->idx->size : 0;
+}
 
-    cur += 19; /* skip continuous 19 digits */
-    if (!char_is_digit_or_fp(*cur)) {
-        /* this number is an integer consisting of 19 digits */
-        if (sign && (sig > ((u64)1 << 63))) { /* overflow */
-            if (has_flg(BIGNUM_AS_RAW)) return_raw();
-            return_f64(unsafe_yyjson_u64_to_f64(sig));
+void yyjson_mut_doc_index_free(yyjson_mut_doc *doc) {
+    idx_map *map;
+    usize i;
+    if (!doc || !doc->idx) return;
+    map = &doc->idx->map;
+    for (i = 0; i < map->cap; i++) {
+        yyjson_mut_val *ctn = constcast(yyjson_mut_val *)map->ent[i].ctn;
+        mut_idx_hdr *tab = (mut_idx_hdr *)map->ent[i].tab;
+        if (!ctn) continue;
+        /* the indexed containers fall back to the linear functions */
+        if (unsafe_yyjson_is_ctn(ctn) && mut_idx_has_tab(ctn, tab)) {
+            unsafe_yyjson_mut_idx_drop(ctn);
         }
-        return_i64(sig);
+        doc->alc.free(doc->alc.ctx, tab);
     }
-    goto digi_intg_more; /* read more digits in integral part */
+    if (map->ent) doc->alc.free(doc->alc.ctx, map->ent);
+    doc->alc.free(doc->alc.ctx, doc->idx);
+    doc->idx = NULL;
+}
 
 
-    /* process first non-digit character */
-#define expr_sepr(i) \
-    digi_sepr_##i: \
-    if (likely(!char_is_fp(cur[i]))) { cur += i; return_i64(sig); } \
-    dot_pos = cur + i; \
-    if (likely(cur[i] == '.')) goto digi_frac_##i; \
-    cur += i; sig_end = cur; goto digi_exp_more;
-    repeat_in_1_18(expr_sepr)
-#undef expr_sepr
 
+/*==============================================================================
+ * MARK: - Memory-Mapped Document (Public)
+ *============================================================================*/
+
+void unsafe_yyjson_doc_unmap(yyjson_doc *doc) {
+#if YYJSON_HAS_MMAP
+    munmap(doc->ext.map, doc->ext.map_len);
+#endif
+    doc->ext.map = NULL;
+    doc->ext.map_len = 0;
+}
 
-    /* read fraction part */
-#define expr_frac(i) \
-    digi_frac_##i: \
-    if (likely((num = (u64)(cur[i + 1] - (u8)'0')) <= 9)) \
-        sig = num + sig * 10; \
-    else { goto digi_stop_##i; }
-    repeat_in_1_18(expr_frac)
-#undef expr_frac
 
-    cur += 20; /* skip 19 digits and 1 decimal point */
-    if (!char_is_digit(*cur)) goto digi_frac_end; /* fraction part end */
-    goto digi_frac_more; /* read more digits in fraction part */
 
+#if !YYJSON_DISABLE_READER /* reader begin */
 
-    /* significant part end */
-#define expr_stop(i) \
-    digi_stop_##i: \
-    cur += i + 1; \
-    goto digi_frac_end;
-    repeat_in_1_18(expr_stop)
-#undef expr_stop
+/* Check read flag, avoids `always false` warning when disabled. */
+#define has_flg(_flg) unlikely(has_rflag(flg, YYJSON_READ_##_flg, 0))
+#define has_allow(_flg) unlikely(has_rflag(flg, YYJSON_READ_ALLOW_##_flg, 1))
+#define YYJSON_READ_ALLOW_TRIVIA (YYJSON_READ_ALLOW_COMMENTS | \
+                                  YYJSON_READ_ALLOW_EXT_WHITESPACE)
+static_inline bool has_rflag(yyjson_read_flag flg, yyjson_read_flag chk,
+                             bool non_standard) {
+#if YYJSON_DISABLE_NON_STANDARD
+    if (non_standard) return false;
+#endif
+    return (flg & chk) != 0;
+}
 
 
-    /* read more digits in integral part */
-digi_intg_more:
-    if (char_is_digit(*cur)) {
-        if (!char_is_digit_or_fp(cur[1])) {
-            /* this number is an integer consisting of 20 digits */
-            num = (u64)(*cur - '0');
-            if ((sig < (U64_MAX / 10)) ||
-                (sig == (U64_MAX / 10) && num <= (U64_MAX % 10))) {
-                sig = num + sig * 10;
-                cur++;
-                /* convert to double if overflow */
-                if (sign) {
-                    if (has_flg(BIGNUM_AS_RAW)) return_raw();
-                    return_f64(unsafe_yyjson_u64_to_f64(sig));
-                }
-                return_i64(sig);
-            }
-        }
+
+/*==============================================================================
+ * MARK: - JSON Reader Utils (Private)
+ * These functions are used by JSON reader to read literals and comments.
+ *============================================================================*/
+
+/** Read `true` literal, `*ptr[0]` should be `t`. */
+static_inline bool read_true(u8 **ptr, yyjson_val *val) {
+    u8 *cur = *ptr;
+    if (likely(byte_match_4(cur, "true"))) {
+        val->tag = YYJSON_TYPE_BOOL | YYJSON_SUBTYPE_TRUE;
+        *ptr = cur + 4;
+        return true;
     }
+    return false;
+}
 
-    if (char_is_exp(*cur)) {
-        dot_pos = cur;
-        goto digi_exp_more;
+/** Read `false` literal, `*ptr[0]` should be `f`. */
+static_inline bool read_false(u8 **ptr, yyjson_val *val) {
+    u8 *cur = *ptr;
+    if (likely(byte_match_4(cur + 1, "alse"))) {
+        val->tag = YYJSON_TYPE_BOOL | YYJSON_SUBTYPE_FALSE;
+        *ptr = cur + 5;
+        return true;
     }
+    return false;
+}
 
-    if (*cur == '.') {
-        dot_pos = cur++;
-        if (unlikely(!char_is_digit(*cur))) {
-            if (has_allow(EXT_NUMBER)) {
-                goto digi_frac_end;
-            }
-            return_err(cur, "no digit after decimal point");
-        }
+/** Read `null` literal, `*ptr[0]` should be `n`. */
+static_inline bool read_null(u8 **ptr, yyjson_val *val) {
+    u8 *cur = *ptr;
+    if (likely(byte_match_4(cur, "null"))) {
+        val->tag = YYJSON_TYPE_NULL;
+        *ptr = cur + 4;
+        return true;
     }
+    return false;
+}
 
-
-    /* read more digits in fraction part */
-digi_frac_more:
-    sig_cut = cur; /* too large to fit in u64, excess digits need to be cut */
-    sig += (*cur >= '5'); /* round */
-    while (char_is_digit(*++cur));
-    if (!dot_pos) {
-        if (!char_is_fp(*cur) && has_flg(BIGNUM_AS_RAW)) {
-            return_raw(); /* it's a large integer */
-        }
-        dot_pos = cur;
-        if (*cur == '.') {
-            if (unlikely(!char_is_digit(*++cur))) {
-                if (!has_allow(EXT_NUMBER)) {
-                    return_err(cur, "no digit after decimal point");
-                }
+/** Read `Inf` or `Infinity` literal (ignoring case). */
+static_inline bool read_inf(u8 **ptr, u8 **pre,
+                            yyjson_read_flag flg, yyjson_val *val) {
+    u8 *hdr = *ptr;
+    u8 *cur = *ptr;
+    u8 **end = ptr;
+    bool sign = (*cur == '-');
+    if (*cur == '+' && !has_allow(EXT_NUMBER)) return false;
+    cur += char_is_sign(*cur);
+    if (char_to_lower(cur[0]) == 'i' &&
+        char_to_lower(cur[1]) == 'n' &&
+        char_to_lower(cur[2]) == 'f') {
+        if (char_to_lower(cur[3]) == 'i') {
+            if (char_to_lower(cur[4]) == 'n' &&
+                char_to_lower(cur[5]) == 'i' &&
+                char_to_lower(cur[6]) == 't' &&
+                char_to_lower(cur[7]) == 'y') {
+                cur += 8;
+            } else {
+                return false;
             }
-            while (char_is_digit(*cur)) cur++;
+        } else {
+            cur += 3;
+        }
+        *end = cur;
+        if (has_flg(NUMBER_AS_RAW)) {
+            **pre = '\0'; /* add null-terminator for previous raw string */
+            *pre = cur; /* save end position for current raw string */
+            val->tag = ((u64)(cur - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_RAW;
+            val->uni.str = (const char *)hdr;
+        } else {
+            val->tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL;
+            val->uni.u64 = f64_bits_inf(sign);
         }
+        return true;
     }
-    exp_sig = (i64)(dot_pos - sig_cut);
-    exp_sig += (dot_pos < sig_cut);
+    return false;
+}
 
-    /* ignore trailing zeros */
-    tmp = cur - 1;
-    while ((*tmp == '0' || *tmp == '.') && tmp > hdr) tmp--;
-    if (tmp < sig_cut) {
-        sig_cut = NULL;
-    } else {
-        sig_end = cur;
+/** Read `NaN` literal (ignoring case). */
+static_inline bool read_nan(u8 **ptr, u8 **pre,
+                            yyjson_read_flag flg, yyjson_val *val) {
+    u8 *hdr = *ptr;
+    u8 *cur = *ptr;
+    u8 **end = ptr;
+    bool sign = (*cur == '-');
+    if (*cur == '+' && !has_allow(EXT_NUMBER)) return false;
+    cur += char_is_sign(*cur);
+    if (char_to_lower(cur[0]) == 'n' &&
+        char_to_lower(cur[1]) == 'a' &&
+        char_to_lower(cur[2]) == 'n') {
+        cur += 3;
+        *end = cur;
+        if (has_flg(NUMBER_AS_RAW)) {
+            **pre = '\0'; /* add null-terminator for previous raw string */
+            *pre = cur; /* save end position for current raw string */
+            val->tag = ((u64)(cur - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_RAW;
+            val->uni.str = (const char *)hdr;
+        } else {
+            val->tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL;
+            val->uni.u64 = f64_bits_nan(sign);
+        }
+        return true;
     }
+    return false;
+}
 
-    if (char_is_exp(*cur)) goto digi_exp_more;
-    goto digi_exp_finish;
+/** Read `Inf`, `Infinity` or `NaN` literal (ignoring case). */
+static_inline bool read_inf_or_nan(u8 **ptr, u8 **pre,
+                                   yyjson_read_flag flg, yyjson_val *val) {
+    if (read_inf(ptr, pre, flg, val)) return true;
+    if (read_nan(ptr, pre, flg, val)) return true;
+    return false;
+}
 
+/** Read a JSON number as raw string. */
+static_noinline bool read_num_raw(u8 **ptr, u8 **pre, yyjson_read_flag flg,
+                                  yyjson_val *val, const char **msg) {
+#define return_err(_pos, _msg) do { \
+    *msg = _msg; *end = _pos; return false; \
+} while (false)
 
-    /* fraction part end */
-digi_frac_end:
-    if (unlikely(dot_pos + 1 == cur)) {
-        if (!has_allow(EXT_NUMBER)) {
-            return_err(cur, "no digit after decimal point");
+#define return_raw() do { \
+    val->tag = ((u64)(cur - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_RAW; \
+    val->uni.str = (const char *)hdr; \
+    **pre = '\0'; *pre = cur; *end = cur; return true; \
+} while (false)
+
+    u8 *hdr = *ptr;
+    u8 *cur = *ptr;
+    u8 **end = ptr;
+
+    /* skip sign */
+    cur += (*cur == '-');
+
+    /* read first digit, check leading zero */
+    while (unlikely(!char_is_digit(*cur))) {
+        if (has_allow(EXT_NUMBER)) {
+            if (*cur == '+' && cur == hdr) { /* leading `+` sign */
+                cur++;
+                continue;
+            }
+            if (*cur == '.' && char_is_digit(cur[1])) { /* e.g. '.123' */
+                goto read_double;
+            }
+        }
+        if (has_allow(INF_AND_NAN)) {
+            if (read_inf_or_nan(ptr, pre, flg, val)) return true;
         }
+        return_err(cur, "no digit after sign");
     }
-    sig_end = cur;
-    exp_sig = -(i64)((u64)(cur - dot_pos) - 1);
-    if (likely(!char_is_exp(*cur))) {
-        if (unlikely(exp_sig < F64_MIN_DEC_EXP - 19)) {
-            return_f64_bin(0); /* underflow */
+
+    /* read integral part */
+    if (*cur == '0') {
+        cur++;
+        if (unlikely(char_is_digit(*cur))) {
+            return_err(cur - 1, "number with leading zero is not allowed");
+        }
+        if (!char_is_fp(*cur)) {
+            if (has_allow(EXT_NUMBER) && char_to_lower(*cur) == 'x') { /* hex */
+                if (!char_is_hex(*++cur)) return_err(cur, "invalid hex number");
+                while(char_is_hex(*cur)) cur++;
+            }
+            return_raw();
         }
-        exp = (i32)exp_sig;
-        goto digi_finish;
     } else {
-        goto digi_exp_more;
+        while (char_is_digit(*cur)) cur++;
+        if (!char_is_fp(*cur)) return_raw();
     }
 
-
-    /* read exponent part */
-digi_exp_more:
-    exp_sign = (*++cur == '-');
-    cur += char_is_sign(*cur);
-    if (unlikely(!char_is_digit(*cur))) {
-        return_err(cur, "no digit after exponent sign");
+read_double:
+    /* read fraction part */
+    if (*cur == '.') {
+        cur++;
+        if (!char_is_digit(*cur)) {
+            if (has_allow(EXT_NUMBER)) {
+                if (!char_is_exp(*cur)) return_raw();
+            } else {
+                return_err(cur, "no digit after decimal point");
+            }
+        }
+        while (char_is_digit(*cur)) cur++;
     }
-    while (*cur == '0') cur++;
 
-    /* read exponent literal */
-    tmp = cur;
-    while (char_is_digit(*cur)) {
-        exp_lit = (i64)((u8)(*cur++ - '0') + (u64)exp_lit * 10);
-    }
-    if (unlikely(cur - tmp >= U64_SAFE_DIG)) {
-        if (exp_sign) {
-            return_f64_bin(0); /* underflow */
-        } else {
-            return_inf(); /* overflow */
+    /* read exponent part */
+    if (char_is_exp(*cur)) {
+        cur += 1 + char_is_sign(cur[1]);
+        if (!char_is_digit(*cur++)) {
+            return_err(cur, "no digit after exponent sign");
         }
+        while (char_is_digit(*cur)) cur++;
     }
-    exp_sig += exp_sign ? -exp_lit : exp_lit;
 
+    return_raw();
 
-    /* validate exponent value */
-digi_exp_finish:
-    if (unlikely(exp_sig < F64_MIN_DEC_EXP - 19)) {
-        return_f64_bin(0); /* underflow */
-    }
-    if (unlikely(exp_sig > F64_MAX_DEC_EXP)) {
-        return_inf(); /* overflow */
-    }
-    exp = (i32)exp_sig;
-
+#undef return_err
+#undef return_raw
+}
 
-    /* all digit read finished */
-digi_finish:
+/** Read a hex number. */
+static_noinline bool read_num_hex(u8 **ptr, u8 **pre, yyjson_read_flag flg,
+                                  yyjson_val *val, const char **msg) {
+    u8 *hdr = *ptr;
+    u8 *cur = *ptr;
+    u8 **end = ptr;
+    u64 sig = 0, i = 0;
+    bool sign;
 
-    /*
-     Fast path 1:
+    /* skip sign and '0x' */
+    sign = (*cur == '-');
+    cur += (*cur == '-' || *cur == '+') + 2;
 
-     1. The floating-point number calculation should be accurate, see the
-        comments of macro `YYJSON_DOUBLE_MATH_CORRECT`.
-     2. Correct rounding should be performed (fegetround() == FE_TONEAREST).
-     3. The input to floating-point calculations does not lose precision,
-        which means: 64 - leading_zero(input) - trailing_zero(input) < 53.
+    /* read hex */
+    for(; i < 16; i++) {
+        u8 c = hex_conv_table[cur[i]];
+        if (c == 0xF0) break;
+        sig <<= 4;
+        sig |= c;
+    }
 
-     We don't check all available inputs here, because that would make the code
-     more complicated, and not friendly to branch predictor.
-     */
-#if YYJSON_DOUBLE_MATH_CORRECT
-    if (sig < ((u64)1 << 53) &&
-        exp >= -F64_POW10_MAX_EXACT_EXP &&
-        exp <= +F64_POW10_MAX_EXACT_EXP) {
-        f64 dbl = (f64)sig;
-        if (exp < 0) {
-            dbl /= f64_pow10_table[-exp];
-        } else {
-            dbl *= f64_pow10_table[+exp];
-        }
-        return_f64(dbl);
+    /* check error */
+    if (unlikely(i == 0)) {
+        *msg = "invalid hex number";
+        return false;
     }
-#endif
-    if (unlikely(sig == 0)) return_f64_bin(0);
 
-    /*
-     Fast path 2:
-
-     To keep it simple, we only accept normal number here,
-     let the slow path handle subnormal and infinite numbers.
-     */
-    if (likely(!sig_cut &&
-               exp > -F64_MAX_DEC_EXP + 1 &&
-               exp < +F64_MAX_DEC_EXP - 20)) {
-        /*
-         The result value is exactly equal to (sig * 10^exp),
-         the exponent part (10^exp) can be converted to (sig2 * 2^exp2).
-
-         The sig2 can be an infinite length number, only the highest 128 bits
-         is cached in the pow10_sig_table.
-
-         Now we have these bits:
-         sig1 (normalized 64bit)        : aaaaaaaa
-         sig2 (higher 64bit)            : bbbbbbbb
-         sig2_ext (lower 64bit)         : cccccccc
-         sig2_cut (extra unknown bits)  : dddddddddddd....
-
-         And the calculation process is:
-         ----------------------------------------
-                 aaaaaaaa *
-                 bbbbbbbbccccccccdddddddddddd....
-         ----------------------------------------
-         abababababababab +
-                 acacacacacacacac +
-                         adadadadadadadadadad....
-         ----------------------------------------
-         [hi____][lo____] +
-                 [hi2___][lo2___] +
-                         [unknown___________....]
-         ----------------------------------------
-
-         The addition with carry may affect higher bits, but if there is a 0
-         in higher bits, the bits higher than 0 will not be affected.
-
-         `lo2` + `unknown` may get a carry bit and may affect `hi2`, the max
-         value of `hi2` is 0xFFFFFFFFFFFFFFFE, so `hi2` will not overflow.
-
-         `lo` + `hi2` may also get a carry bit and may affect `hi`, but only
-         the highest significant 53 bits of `hi` is needed. If there is a 0
-         in the lower bits of `hi`, then all the following bits can be dropped.
-
-         To convert the result to IEEE-754 double number, we need to perform
-         correct rounding:
-         1. if bit 54 is 0, round down,
-         2. if bit 54 is 1 and any bit beyond bit 54 is 1, round up,
-         3. if bit 54 is 1 and all bits beyond bit 54 are 0, round to even,
-            as the extra bits is unknown, this case will not be handled here.
-         */
-
-        u64 raw;
-        u64 sig1, sig2, sig2_ext, hi, lo, hi2, lo2, add, bits;
-        i32 exp2;
-        u32 lz;
-        bool exact = false, carry, round_up;
-
-        /* convert (10^exp) to (sig2 * 2^exp2) */
-        pow10_table_get_sig(exp, &sig2, &sig2_ext);
-        pow10_table_get_exp(exp, &exp2);
+    /* check overflow */
+    if (unlikely(i == 16)) {
+        if (char_is_hex(cur[16]) || (sign && sig > ((u64)1 << 63))) {
+            if (!has_flg(BIGNUM_AS_RAW)) {
+                *msg = "hex number overflow";
+                return false;
+            }
+            cur += 16;
+            while (char_is_hex(*cur)) cur++;
+            **pre = '\0';
+            val->tag = ((u64)(cur - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_RAW;
+            val->uni.str = (const char *)hdr;
+            *pre = cur; *end = cur;
+            return true;
+        }
+    }
 
-        /* normalize and multiply */
-        lz = u64_lz_bits(sig);
-        sig1 = sig << lz;
-        exp2 -= (i32)lz;
-        u128_mul(sig1, sig2, &hi, &lo);
+    val->tag = YYJSON_TYPE_NUM | (u64)((u8)sign << 3);
+    val->uni.u64 = (u64)(sign ? (u64)(~(sig) + 1) : (u64)(sig));
+    *end = cur + i;
+    return true;
+}
 
-        /*
-         The `hi` is in range [0x4000000000000000, 0xFFFFFFFFFFFFFFFE],
-         To get normalized value, `hi` should be shifted to the left by 0 or 1.
+/**
+ Skip standard whitespace [ \t\n\r].
+ @param cur The current position.
+ @param eof JSON end position, the SIMD code path is only used for the blocks
+    before `eof`, the remaining bytes are skipped one by one.
+ @return The position of the first non-whitespace character.
+ */
+static_inline u8 *skip_space(u8 *cur, u8 *eof) {
+#if YYJSON_HAS_SIMD
+    while (likely(eof - cur >= SIMD_SPACE_SIZE)) {
+        usize n = simd_space_len(cur);
+        cur += n;
+        if (likely(n < SIMD_SPACE_SIZE)) return cur;
+    }
+#else
+    (void)eof;
+#endif
+    while (char_is_space(*cur)) cur++;
+    return cur;
+}
 
-         The highest significant 53 bits is used by IEEE-754 double number,
-         and the bit 54 is used to detect rounding direction.
+/**
+ Skip trivia (whitespace and comments).
+ This function should be used only when `char_is_trivia()` returns true.
+ @param ptr  (inout) Input current position, output end position.
+ @param eof  JSON end position.
+ @param flg  JSON read flags.
+ @return true  if at least one character was skipped.
+         false if no characters were skipped,
+               or if a multi-line comment is unterminated;
+               in the latter case, `ptr` will be set to `eof`.
+ */
+static_noinline bool skip_trivia(u8 **ptr, u8 *eof, yyjson_read_flag flg) {
+    u8 *hdr = *ptr, *cur = *ptr;
+    usize len;
 
-         The lowest (64 - 54 - 1) bits is used to check whether it contains 0.
-         */
-        bits = hi & (((u64)1 << (64 - 54 - 1)) - 1);
-        if (bits - 1 < (((u64)1 << (64 - 54 - 1)) - 2)) {
-            /*
-             (bits != 0 && bits != 0x1FF) => (bits - 1 < 0x1FF - 1)
-             The `bits` is not zero, so we don't need to check `round to even`
-             case. The `bits` contains bit `0`, so we can drop the extra bits
-             after `0`.
-             */
-            exact = true;
+    while (cur < eof) {
+        u8 *loop_begin = cur;
 
-        } else {
-            /*
-             (bits == 0 || bits == 0x1FF)
-             The `bits` is filled with all `0` or all `1`, so we need to check
-             lower bits with another 64-bit multiplication.
-             */
-            u128_mul(sig1, sig2_ext, &hi2, &lo2);
+        /* skip standard whitespace */
+        cur = skip_space(cur, eof);
 
-            add = lo + hi2;
-            if (add + 1 > (u64)1) {
-                /*
-                 (add != 0 && add != U64_MAX) => (add + 1 > 1)
-                 The `add` is not zero, so we don't need to check `round to
-                 even` case. The `add` contains bit `0`, so we can drop the
-                 extra bits after `0`. The `hi` cannot be U64_MAX, so it will
-                 not overflow.
-                 */
-                carry = add < lo || add < hi2;
-                hi += carry;
-                exact = true;
+        /* skip extended whitespace */
+        if (has_allow(EXT_WHITESPACE)) {
+            while (char_is_space_ext(*cur)) {
+                cur += (len = ext_space_len(cur));
+                if (!len) break;
             }
         }
 
-        if (exact) {
-            /* normalize */
-            lz = hi < ((u64)1 << 63);
-            hi <<= lz;
-            exp2 -= (i32)lz;
-            exp2 += 64;
-
-            /* test the bit 54 and get rounding direction */
-            round_up = (hi & ((u64)1 << (64 - 54))) > (u64)0;
-            hi += (round_up ? ((u64)1 << (64 - 54)) : (u64)0);
-
-            /* test overflow */
-            if (hi < ((u64)1 << (64 - 54))) {
-                hi = ((u64)1 << 63);
-                exp2 += 1;
+        /* skip comment, do not validate encoding */
+        if (has_allow(COMMENTS) && cur[0] == '/') {
+            if (cur[1] == '/') { /* single-line comment */
+                cur += 2;
+                if (has_allow(EXT_WHITESPACE)) {
+                    while (cur < eof) {
+                        if (char_is_eol_ext(*cur)) {
+                            cur += (len = ext_eol_len(cur));
+                            if (len) break;
+                        }
+                        cur++;
+                    }
+                } else {
+                    while (cur < eof && !char_is_eol(*cur)) cur++;
+                }
+            } else if (cur[1] == '*') { /* multi-line comment */
+                cur += 2;
+                while (!byte_match_2(cur, "*/") && cur < eof) cur++;
+                if (cur == eof) {
+                    *ptr = eof;
+                    return false; /* unclosed comment */
+                }
+                cur += 2;
             }
-
-            /* This is a normal number, convert it to IEEE-754 format. */
-            hi >>= F64_BITS - F64_SIG_FULL_BITS;
-            exp2 += F64_BITS - F64_SIG_FULL_BITS + F64_SIG_BITS;
-            exp2 += F64_EXP_BIAS;
-            raw = ((u64)exp2 << F64_SIG_BITS) | (hi & F64_SIG_MASK);
-            return_f64_bin(raw);
         }
+        if (cur == loop_begin) break;
     }
+    *ptr = cur;
+    return cur > hdr;
+}
 
-    /*
-     Slow path: read double number exactly with diyfp.
-     1. Use cached diyfp to get an approximation value.
-     2. Use bigcomp to check the approximation value if needed.
-
-     This algorithm refers to google's double-conversion project:
-     https://github.com/google/double-conversion
-     */
-    {
-        const i32 ERR_ULP_LOG = 3;
-        const i32 ERR_ULP = 1 << ERR_ULP_LOG;
-        const i32 ERR_CACHED_POW = ERR_ULP / 2;
-        const i32 ERR_MUL_FIXED = ERR_ULP / 2;
-        const i32 DIY_SIG_BITS = 64;
-        const i32 EXP_BIAS = F64_EXP_BIAS + F64_SIG_BITS;
-        const i32 EXP_SUBNORMAL = -EXP_BIAS + 1;
+/**
+ Check truncated UTF-8 character.
+ Return true if `cur` starts a valid UTF-8 sequence that is truncated.
+ */
+static bool is_truncated_utf8(u8 *cur, u8 *eof) {
+    u8 c0, c1, c2;
+    usize len = (usize)(eof - cur);
+    if (cur >= eof || len >= 4) return false;
+    c0 = cur[0]; c1 = cur[1]; c2 = cur[2];
+    /* 1-byte UTF-8, not truncated */
+    if (c0 < 0x80) return false;
+    if (len == 1) {
+        /* 2-byte UTF-8, truncated */
+        if ((c0 & 0xE0) == 0xC0 && (c0 & 0x1E) != 0x00) return true;
+        /* 3-byte UTF-8, truncated */
+        if ((c0 & 0xF0) == 0xE0) return true;
+        /* 4-byte UTF-8, truncated */
+        if ((c0 & 0xF8) == 0xF0 && (c0 & 0x07) <= 0x04) return true;
+    } else if (len == 2) {
+        /* 3-byte UTF-8, truncated */
+        if ((c0 & 0xF0) == 0xE0 && (c1 & 0xC0) == 0x80) {
+            u8 t = (u8)(((c0 & 0x0F) << 1) | ((c1 & 0x20) >> 5));
+            return 0x01 <= t && t != 0x1B;
+        }
+        /* 4-byte UTF-8, truncated */
+        if ((c0 & 0xF8) == 0xF0 && (c1 & 0xC0) == 0x80) {
+            u8 t = (u8)(((c0 & 0x07) << 2) | ((c1 & 0x30) >> 4));
+            return 0x01 <= t && t <= 0x10;
+        }
+    } else if (len == 3) {
+        /* 4 bytes UTF-8, truncated */
+        if ((c0 & 0xF8) == 0xF0 && (c1 & 0xC0) == 0x80 && (c2 & 0xC0) == 0x80) {
+            u8 t = (u8)(((c0 & 0x07) << 2) | ((c1 & 0x30) >> 4));
+            return 0x01 <= t && t <= 0x10;
+        }
+    }
+    return false;
+}
 
-        u64 fp_err;
-        u32 bits;
-        i32 order_of_magnitude;
-        i32 effective_significand_size;
-        i32 precision_digits_count;
-        u64 precision_bits;
-        u64 half_way;
-
-        u64 raw;
-        diy_fp fp, fp_upper;
-        bigint big_full, big_comp;
-        i32 cmp;
-
-        fp.sig = sig;
-        fp.exp = 0;
-        fp_err = sig_cut ? (u64)(ERR_ULP / 2) : (u64)0;
-
-        /* normalize */
-        bits = u64_lz_bits(fp.sig);
-        fp.sig <<= bits;
-        fp.exp -= (i32)bits;
-        fp_err <<= bits;
-
-        /* multiply and add error */
-        fp = diy_fp_mul(fp, diy_fp_get_cached_pow10(exp));
-        fp_err += (u64)ERR_CACHED_POW + (fp_err != 0) + (u64)ERR_MUL_FIXED;
-
-        /* normalize */
-        bits = u64_lz_bits(fp.sig);
-        fp.sig <<= bits;
-        fp.exp -= (i32)bits;
-        fp_err <<= bits;
+/**
+ Check truncated string.
+ Returns true if `cur` match `str` but is truncated.
+ The `str` should be lowercase ASCII letters.
+ */
+static bool is_truncated_str(u8 *cur, u8 *eof, const char *str,
+                             bool case_sensitive) {
+    usize len = strlen(str);
+    if (cur + len <= eof || eof <= cur) return false;
+    if (case_sensitive) {
+        return memcmp(cur, str, (usize)(eof - cur)) == 0;
+    }
+    for (; cur < eof; cur++, str++) {
+        if (char_to_lower(*cur) != *(const u8 *)str) return false;
+    }
+    return true;
+}
 
-        /* effective significand */
-        order_of_magnitude = DIY_SIG_BITS + fp.exp;
-        if (likely(order_of_magnitude >= EXP_SUBNORMAL + F64_SIG_FULL_BITS)) {
-            effective_significand_size = F64_SIG_FULL_BITS;
-        } else if (order_of_magnitude <= EXP_SUBNORMAL) {
-            effective_significand_size = 0;
-        } else {
-            effective_significand_size = order_of_magnitude - EXP_SUBNORMAL;
+/**
+ Check truncated JSON on parsing errors.
+ Returns true if the input is valid but truncated.
+ */
+static_noinline bool is_truncated_end(u8 *hdr, u8 *cur, u8 *eof,
+                                      yyjson_read_code code,
+                                      yyjson_read_flag flg) {
+    if (cur >= eof) return true;
+    if (code == YYJSON_READ_ERROR_LITERAL) {
+        if (is_truncated_str(cur, eof, "true", true) ||
+            is_truncated_str(cur, eof, "false", true) ||
+            is_truncated_str(cur, eof, "null", true)) {
+            return true;
         }
-
-        /* precision digits count */
-        precision_digits_count = DIY_SIG_BITS - effective_significand_size;
-        if (unlikely(precision_digits_count + ERR_ULP_LOG >= DIY_SIG_BITS)) {
-            i32 shr = (precision_digits_count + ERR_ULP_LOG) - DIY_SIG_BITS + 1;
-            fp.sig >>= shr;
-            fp.exp += shr;
-            fp_err = (fp_err >> shr) + 1 + (u32)ERR_ULP;
-            precision_digits_count -= shr;
+    }
+    if (code == YYJSON_READ_ERROR_UNEXPECTED_CHARACTER ||
+        code == YYJSON_READ_ERROR_INVALID_NUMBER ||
+        code == YYJSON_READ_ERROR_LITERAL) {
+        if (has_allow(INF_AND_NAN)) {
+            if (*cur == '-') cur++;
+            if (is_truncated_str(cur, eof, "infinity", false) ||
+                is_truncated_str(cur, eof, "nan", false)) {
+                return true;
+            }
         }
-
-        /* half way */
-        precision_bits = fp.sig & (((u64)1 << precision_digits_count) - 1);
-        precision_bits *= (u32)ERR_ULP;
-        half_way = (u64)1 << (precision_digits_count - 1);
-        half_way *= (u32)ERR_ULP;
-
-        /* rounding */
-        fp.sig >>= precision_digits_count;
-        fp.sig += (precision_bits >= half_way + fp_err);
-        fp.exp += precision_digits_count;
-
-        /* get IEEE double raw value */
-        raw = diy_fp_to_ieee_raw(fp);
-        if (unlikely(raw == F64_BITS_INF)) return_inf();
-        if (likely(precision_bits <= half_way - fp_err ||
-                   precision_bits >= half_way + fp_err)) {
-            return_f64_bin(raw); /* number is accurate */
+    }
+    if (code == YYJSON_READ_ERROR_UNEXPECTED_CONTENT) {
+        if (has_allow(INF_AND_NAN)) {
+            if (hdr + 3 <= cur &&
+                is_truncated_str(cur - 3, eof, "infinity", false)) {
+                return true; /* e.g. infin would be read as inf + in */
+            }
         }
-        /* now the number is the correct value, or the next lower value */
+    }
+    if (code == YYJSON_READ_ERROR_INVALID_STRING) {
+        usize len = (usize)(eof - cur);
 
-        /* upper boundary */
-        if (raw & F64_EXP_MASK) {
-            fp_upper.sig = (raw & F64_SIG_MASK) + ((u64)1 << F64_SIG_BITS);
-            fp_upper.exp = (i32)((raw & F64_EXP_MASK) >> F64_SIG_BITS);
-        } else {
-            fp_upper.sig = (raw & F64_SIG_MASK);
-            fp_upper.exp = 1;
+        /* unicode escape sequence */
+        if (*cur == '\\') {
+            if (len == 1) return true;
+            if (len <= 5) {
+                if (*++cur != 'u') return false;
+                for (++cur; cur < eof; cur++) {
+                    if (!char_is_hex(*cur)) return false;
+                }
+                return true;
+            } else if (len <= 11) {
+                /* incomplete surrogate pair? */
+                u16 hi;
+                if (*++cur != 'u') return false;
+                if (!hex_load_4(++cur, &hi)) return false;
+                if ((hi & 0xF800) != 0xD800) return false;
+                cur += 4;
+                if (cur >= eof) return true;
+                /* valid low surrogate is DC00...DFFF */
+                if (*cur != '\\') return false;
+                if (++cur >= eof) return true;
+                if (*cur != 'u') return false;
+                if (++cur >= eof) return true;
+                if (*cur != 'd' && *cur != 'D') return false;
+                if (++cur >= eof) return true;
+                if ((*cur < 'c' || *cur > 'f') && (*cur < 'C' || *cur > 'F'))
+                    return false;
+                if (++cur >= eof) return true;
+                if (!char_is_hex(*cur)) return false;
+                return true;
+            }
+            return false;
         }
-        fp_upper.exp -= F64_EXP_BIAS + F64_SIG_BITS;
-        fp_upper.sig <<= 1;
-        fp_upper.exp -= 1;
-        fp_upper.sig += 1; /* add half ulp */
 
-        /* compare with bigint */
-        bigint_set_buf(&big_full, sig, &exp, sig_cut, sig_end, dot_pos);
-        bigint_set_u64(&big_comp, fp_upper.sig);
-        if (exp >= 0) {
-            bigint_mul_pow10(&big_full, +exp);
-        } else {
-            bigint_mul_pow10(&big_comp, -exp);
+        /* 2 to 4 bytes UTF-8 */
+        if (is_truncated_utf8(cur, eof)) {
+            return true;
         }
-        if (fp_upper.exp > 0) {
-            bigint_mul_pow2(&big_comp, (u32)+fp_upper.exp);
-        } else {
-            bigint_mul_pow2(&big_full, (u32)-fp_upper.exp);
+    }
+    if (has_allow(COMMENTS)) {
+        if (code == YYJSON_READ_ERROR_INVALID_COMMENT) {
+            /* unclosed multiline comment */
+            return true;
         }
-        cmp = bigint_cmp(&big_full, &big_comp);
-        if (likely(cmp != 0)) {
-            /* round down or round up */
-            raw += (cmp > 0);
-        } else {
-            /* falls midway, round to even */
-            raw += (raw & 1);
+        if (code == YYJSON_READ_ERROR_UNEXPECTED_CHARACTER &&
+            *cur == '/' && cur + 1 == eof) {
+            /* truncated beginning of comment */
+            return true;
         }
-
-        if (unlikely(raw == F64_BITS_INF)) return_inf();
-        return_f64_bin(raw);
     }
-
-#undef return_err
-#undef return_inf
-#undef return_0
-#undef return_i64
-#undef return_f64
-#undef return_f64_bin
-#undef return_raw
+    if (code == YYJSON_READ_ERROR_UNEXPECTED_CHARACTER &&
+        has_allow(BOM)) {
+        /* truncated UTF-8 BOM */
+        usize len = (usize)(eof - cur);
+        if (cur == hdr && len < 3 && !memcmp(hdr, "\xEF\xBB\xBF", len)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 
 
-#else /* FP_READER */
+#if !YYJSON_DISABLE_FAST_FP_CONV /* FP_READER */
+
+/*==============================================================================
+ * MARK: - BigInt For Floating Point Number Reader (Private)
+ *
+ * The bigint algorithm is used by floating-point number reader to get correctly
+ * rounded result for numbers with lots of digits. This part of code is rarely
+ * used for common numbers.
+ *============================================================================*/
+
+/** Unsigned arbitrarily large integer */
+typedef struct bigint {
+    u32 used; /* used chunks count, should not be 0 */
+    u64 bits[64]; /* chunks (58 is enough here) */
+} bigint;
 
 /**
- Read a JSON number.
- This is a fallback function if the custom number reader is disabled.
- This function use libc's strtod() to read floating-point number.
+ Evaluate 'big += val'.
+ @param big A big number (can be 0).
+ @param val An unsigned integer (can be 0).
  */
-static_inline bool read_num(u8 **ptr, u8 **pre, yyjson_read_flag flg,
-                            yyjson_val *val, const char **msg) {
-#define return_err(_pos, _msg) do { \
-    *msg = _msg; \
-    *end = _pos; \
-    return false; \
-} while (false)
+static_inline void bigint_add_u64(bigint *big, u64 val) {
+    u32 idx, max;
+    u64 num = big->bits[0];
+    u64 add = num + val;
+    big->bits[0] = add;
+    if (likely((add >= num) || (add >= val))) return;
+    for ((void)(idx = 1), max = big->used; idx < max; idx++) {
+        if (likely(big->bits[idx] != U64_MAX)) {
+            big->bits[idx] += 1;
+            return;
+        }
+        big->bits[idx] = 0;
+    }
+    big->bits[big->used++] = 1;
+}
 
-#define return_0() do { \
-    val->tag = YYJSON_TYPE_NUM | (u64)((u8)sign << 3); \
-    val->uni.u64 = 0; \
-    *end = cur; return true; \
-} while (false)
+/**
+ Evaluate 'big *= val'.
+ @param big A big number (can be 0).
+ @param val An unsigned integer (cannot be 0).
+ */
+static_inline void bigint_mul_u64(bigint *big, u64 val) {
+    u32 idx = 0, max = big->used;
+    u64 hi, lo, carry = 0;
+    for (; idx < max; idx++) {
+        if (big->bits[idx]) break;
+    }
+    for (; idx < max; idx++) {
+        u128_mul_add(big->bits[idx], val, carry, &hi, &lo);
+        big->bits[idx] = lo;
+        carry = hi;
+    }
+    if (carry) big->bits[big->used++] = carry;
+}
+
+/**
+ Evaluate 'big *= 2^exp'.
+ @param big A big number (can be 0).
+ @param exp An exponent integer (can be 0).
+ */
+static_inline void bigint_mul_pow2(bigint *big, u32 exp) {
+    u32 shft = exp % 64;
+    u32 move = exp / 64;
+    u32 idx = big->used;
+    if (unlikely(shft == 0)) {
+        for (; idx > 0; idx--) {
+            big->bits[idx + move - 1] = big->bits[idx - 1];
+        }
+        big->used += move;
+        while (move) big->bits[--move] = 0;
+    } else {
+        big->bits[idx] = 0;
+        for (; idx > 0; idx--) {
+            u64 num = big->bits[idx] << shft;
+            num |= big->bits[idx - 1] >> (64 - shft);
+            big->bits[idx + move] = num;
+        }
+        big->bits[move] = big->bits[0] << shft;
+        big->used += move + (big->bits[big->used + move] > 0);
+        while (move) big->bits[--move] = 0;
+    }
+}
+
+/**
+ Evaluate 'big *= 10^exp'.
+ @param big A big number (can be 0).
+ @param exp An exponent integer (cannot be 0).
+ */
+static_inline void bigint_mul_pow10(bigint *big, i32 exp) {
+    for (; exp >= U64_POW10_MAX_EXACT_EXP; exp -= U64_POW10_MAX_EXACT_EXP) {
+        bigint_mul_u64(big, u64_pow10_table[U64_POW10_MAX_EXACT_EXP]);
+    }
+    if (exp) {
+        bigint_mul_u64(big, u64_pow10_table[exp]);
+    }
+}
+
+/**
+ Compare two bigint.
+ @return -1 if 'a < b', +1 if 'a > b', 0 if 'a == b'.
+ */
+static_inline i32 bigint_cmp(bigint *a, bigint *b) {
+    u32 idx = a->used;
+    if (a->used < b->used) return -1;
+    if (a->used > b->used) return +1;
+    while (idx-- > 0) {
+        u64 av = a->bits[idx];
+        u64 bv = b->bits[idx];
+        if (av < bv) return -1;
+        if (av > bv) return +1;
+    }
+    return 0;
+}
+
+/**
+ Evaluate 'big = val'.
+ @param big A big number (can be 0).
+ @param val An unsigned integer (can be 0).
+ */
+static_inline void bigint_set_u64(bigint *big, u64 val) {
+    big->used = 1;
+    big->bits[0] = val;
+}
+
+/** Set a bigint with floating point number string. */
+static_noinline void bigint_set_buf(bigint *big, u64 sig, i32 *exp,
+                                    u8 *sig_cut, u8 *sig_end, u8 *dot_pos) {
+
+    if (unlikely(!sig_cut)) {
+        /* no digit cut, set significant part only */
+        bigint_set_u64(big, sig);
+        return;
+
+    } else {
+        /* some digits were cut, read them from 'sig_cut' to 'sig_end' */
+        u8 *hdr = sig_cut;
+        u8 *cur = hdr;
+        u32 len = 0;
+        u64 val = 0;
+        bool dig_big_cut = false;
+        bool has_dot = (hdr < dot_pos) & (dot_pos < sig_end);
+        u32 dig_len_total = U64_SAFE_DIG + (u32)(sig_end - hdr) - has_dot;
+
+        sig -= (*sig_cut >= '5'); /* sig was rounded before */
+        if (dig_len_total > F64_MAX_DEC_DIG) {
+            dig_big_cut = true;
+            sig_end -= dig_len_total - (F64_MAX_DEC_DIG + 1);
+            sig_end -= (dot_pos + 1 == sig_end);
+            dig_len_total = (F64_MAX_DEC_DIG + 1);
+        }
+        *exp -= (i32)dig_len_total - U64_SAFE_DIG;
+
+        big->used = 1;
+        big->bits[0] = sig;
+        while (cur < sig_end) {
+            if (likely(cur != dot_pos)) {
+                val = val * 10 + (u8)(*cur++ - '0');
+                len++;
+                if (unlikely(cur == sig_end && dig_big_cut)) {
+                    /* The last digit must be non-zero,    */
+                    /* set it to '1' for correct rounding. */
+                    val = val - (val % 10) + 1;
+                }
+                if (len == U64_SAFE_DIG || cur == sig_end) {
+                    bigint_mul_pow10(big, (i32)len);
+                    bigint_add_u64(big, val);
+                    val = 0;
+                    len = 0;
+                }
+            } else {
+                cur++;
+            }
+        }
+    }
+}
+
+
+
+/*==============================================================================
+ * MARK: - Diy Floating Point (Private)
+ *============================================================================*/
+
+/** "Do It Yourself Floating Point" struct. */
+typedef struct diy_fp {
+    u64 sig; /* significand */
+    i32 exp; /* exponent, base 2 */
+    i32 pad; /* padding, useless */
+} diy_fp;
+
+/** Get cached rounded diy_fp for pow(10, e). The input value must be in the
+    range [POW10_SIG_TABLE_MIN_EXP, POW10_SIG_TABLE_MAX_EXP]. */
+static_inline diy_fp diy_fp_get_cached_pow10(i32 exp10) {
+    diy_fp fp;
+    u64 sig_ext;
+    pow10_table_get_sig(exp10, &fp.sig, &sig_ext);
+    pow10_table_get_exp(exp10, &fp.exp);
+    fp.sig += (sig_ext >> 63);
+    return fp;
+}
+
+/** Returns fp * fp2. */
+static_inline diy_fp diy_fp_mul(diy_fp fp, diy_fp fp2) {
+    u64 hi, lo;
+    u128_mul(fp.sig, fp2.sig, &hi, &lo);
+    fp.sig = hi + (lo >> 63);
+    fp.exp += fp2.exp + 64;
+    return fp;
+}
+
+/** Convert diy_fp to IEEE-754 raw value. */
+static_inline u64 diy_fp_to_ieee_raw(diy_fp fp) {
+    u64 sig = fp.sig;
+    i32 exp = fp.exp;
+    u32 lz_bits;
+    if (unlikely(fp.sig == 0)) return 0;
+
+    lz_bits = u64_lz_bits(sig);
+    sig <<= lz_bits;
+    sig >>= F64_BITS - F64_SIG_FULL_BITS;
+    exp -= (i32)lz_bits;
+    exp += F64_BITS - F64_SIG_FULL_BITS;
+    exp += F64_SIG_BITS;
+
+    if (unlikely(exp >= F64_MAX_BIN_EXP)) {
+        /* overflow */
+        return F64_BITS_INF;
+    } else if (likely(exp >= F64_MIN_BIN_EXP - 1)) {
+        /* normal */
+        exp += F64_EXP_BIAS;
+        return ((u64)exp << F64_SIG_BITS) | (sig & F64_SIG_MASK);
+    } else if (likely(exp >= F64_MIN_BIN_EXP - F64_SIG_FULL_BITS)) {
+        /* subnormal */
+        return sig >> (F64_MIN_BIN_EXP - exp - 1);
+    } else {
+        /* underflow */
+        return 0;
+    }
+}
+
+
+
+/*==============================================================================
+ * MARK: - Number Reader (Private)
+ *============================================================================*/
+
+#if YYJSON_ENDIAN == YYJSON_LITTLE_ENDIAN
+/** Whether `read_digi_8()` is available to read 8 digits at once (SWAR). */
+#define YYJSON_HAS_DIGI_8 1
+
+/**
+ Read 8 digits at once (SWAR), the 8 bytes should be readable.
+ Returns false if any of these bytes is not a digit.
+ */
+static_inline bool read_digi_8(const u8 *cur, u64 *val) {
+    u64 v, m;
+    byte_copy_8(&v, cur);
+    v ^= U64(0x30303030, 0x30303030); /* '0'-'9' -> 0-9 */
+
+    /* the high bit of each byte is set if this byte is not a digit */
+    m = (v & U64(0x7F7F7F7F, 0x7F7F7F7F)) + U64(0x76767676, 0x76767676);
+    m = (m | v) & U64(0x80808080, 0x80808080);
+    if (m) return false;
+
+    /* merge the digits: 8 x 1 -> 4 x 2 -> 2 x 4 -> 1 x 8 */
+    v = (v * 10) + (v >> 8);
+    v = ((v & U64(0x000000FF, 0x000000FF)) * U64(0x000F4240, 0x00000064)) +
+        (((v >> 16) & U64(0x000000FF, 0x000000FF)) *
+         U64(0x00002710, 0x00000001));
+    *val = v >> 32;
+    return true;
+}
+#else
+#define YYJSON_HAS_DIGI_8 0
+#endif
+
+/**
+ Read a JSON number.
+
+ 1. This function assume that the floating-point number is in IEEE-754 format.
+ 2. This function support uint64/int64/double number. If an integer number
+    cannot fit in uint64/int64, it will returns as a double number. If a double
+    number is infinite, the return value is based on flag.
+ 3. This function (with inline attribute) may generate a lot of instructions.
+ */
+static_inline bool read_num(u8 **ptr, u8 *eof, u8 **pre,
+                            yyjson_read_flag flg, yyjson_val *val,
+                            const char **msg) {
+#define return_err(_pos, _msg) do { \
+    *msg = _msg; \
+    *end = _pos; \
+    return false; \
+} while (false)
+
+#define return_0() do { \
+    val->tag = YYJSON_TYPE_NUM | (u8)((u8)sign << 3); \
+    val->uni.u64 = 0; \
+    *end = cur; return true; \
+} while (false)
 
 #define return_i64(_v) do { \
-    val->tag = YYJSON_TYPE_NUM | (u64)((u8)sign << 3); \
+    val->tag = YYJSON_TYPE_NUM | (u8)((u8)sign << 3); \
     val->uni.u64 = (u64)(sign ? (u64)(~(_v) + 1) : (u64)(_v)); \
     *end = cur; return true; \
 } while (false)
@@ -4522,341 +5857,1089 @@ static_inline bool read_num(u8 **ptr, u8 **pre, yyjson_read_flag flg,
 } while (false)
 
 #define return_raw() do { \
+    **pre = '\0'; /* add null-terminator for previous raw string */ \
     val->tag = ((u64)(cur - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_RAW; \
     val->uni.str = (const char *)hdr; \
-    **pre = '\0'; *pre = cur; *end = cur; return true; \
+    *pre = cur; *end = cur; return true; \
 } while (false)
 
-    u64 sig, num;
-    u8 *hdr = *ptr;
-    u8 *cur = *ptr;
-    u8 **end = ptr;
-    u8 *dot = NULL;
-    u8 *f64_end = NULL;
-    bool sign;
+    u8 *sig_cut = NULL; /* significant part cutting position for long number */
+    u8 *sig_end = NULL; /* significant part ending position */
+    u8 *dot_pos = NULL; /* decimal point position */
 
-    /* read number as raw string if has `YYJSON_READ_NUMBER_AS_RAW` flag */
-    if (has_flg(NUMBER_AS_RAW)) {
-        return read_num_raw(ptr, pre, flg, val, msg);
+    u64 sig = 0; /* significant part of the number */
+    i32 exp = 0; /* exponent part of the number */
+
+    bool exp_sign; /* temporary exponent sign from literal part */
+    i64 exp_sig = 0; /* temporary exponent number from significant part */
+    i64 exp_lit = 0; /* temporary exponent number from exponent literal part */
+    u64 num; /* temporary number for reading */
+    u8 *tmp; /* temporary cursor for reading */
+
+    u8 *hdr = *ptr;
+    u8 *cur = *ptr;
+    u8 **end = ptr;
+    bool sign;
+
+    /* read number as raw string if has `YYJSON_READ_NUMBER_AS_RAW` flag */
+    if (has_flg(NUMBER_AS_RAW)) {
+        return read_num_raw(ptr, pre, flg, val, msg);
     }
 
     sign = (*hdr == '-');
     cur += sign;
-    sig = (u8)(*cur - '0');
 
-    /* read first digit, check leading zero */
-    while (unlikely(!char_is_digit(*cur))) {
-        if (has_allow(EXT_NUMBER)) {
-            if (*cur == '+' && cur == hdr) { /* leading `+` sign */
-                cur++;
-                sig = (u8)(*cur - '0');
-                continue;
+    /* begin with a leading zero or non-digit */
+    while (unlikely(!char_is_nonzero(*cur))) { /* 0 or non-digit char */
+        if (unlikely(*cur != '0')) { /* non-digit char */
+            if (has_allow(EXT_NUMBER)) {
+                if (*cur == '+' && cur == hdr) { /* leading `+` sign */
+                    cur++;
+                    continue;
+                }
+                if (*cur == '.' && char_is_digit(cur[1])) { /* e.g. '.123' */
+                    goto leading_dot;
+                }
             }
-            if (*cur == '.' && char_is_num(cur[1])) { /* no integer part */
-                goto read_double; /* e.g. '.123' */
+            if (has_allow(INF_AND_NAN)) {
+                if (read_inf_or_nan(ptr, pre, flg, val)) return true;
             }
+            return_err(cur, "no digit after sign");
         }
-        if (has_allow(INF_AND_NAN)) {
-            if (read_inf_or_nan(ptr, pre, flg, val)) return true;
+        /* begin with 0 */
+        if (likely(!char_is_digit_or_fp(*++cur))) {
+            if (has_allow(EXT_NUMBER) && char_to_lower(*cur) == 'x') { /* hex */
+                return read_num_hex(ptr, pre, flg, val, msg);
+            }
+            return_0();
+        }
+        if (likely(*cur == '.')) {
+leading_dot:
+            dot_pos = cur++;
+            if (unlikely(!char_is_digit(*cur))) {
+                if (has_allow(EXT_NUMBER)) {
+                    if (char_is_exp(*cur)) {
+                        goto digi_exp_more;
+                    } else {
+                        return_f64_bin(0);
+                    }
+                }
+                return_err(cur, "no digit after decimal point");
+            }
+            while (unlikely(*cur == '0')) cur++;
+            if (likely(char_is_digit(*cur))) {
+                /* first non-zero digit after decimal point */
+                sig = (u64)(*cur - '0'); /* read first digit */
+                cur--;
+                goto digi_frac_1; /* continue read fraction part */
+            }
         }
-        return_err(cur, "no digit after sign");
-    }
-    if (*cur == '0') {
-        cur++;
         if (unlikely(char_is_digit(*cur))) {
             return_err(cur - 1, "number with leading zero is not allowed");
         }
-        if (!char_is_fp(*cur)) {
-            if (has_allow(EXT_NUMBER) &&
-                (*cur == 'x' || *cur == 'X')) { /* hex integer */
-                return read_num_hex(ptr, pre, flg, val, msg);
+        if (unlikely(char_is_exp(*cur))) { /* 0 with any exponent is still 0 */
+            cur += (usize)1 + char_is_sign(cur[1]);
+            if (unlikely(!char_is_digit(*cur))) {
+                return_err(cur, "no digit after exponent sign");
             }
-            return_0();
+            while (char_is_digit(*++cur));
         }
-        goto read_double;
+        return_f64_bin(0);
     }
 
-    /* read continuous digits, up to 19 characters */
+    /* begin with non-zero digit */
+#if YYJSON_HAS_DIGI_8
+    /*
+     Read 8 digits at once for long integral part (e.g. IDs and timestamps)
+     while the input has enough bytes, and continue with the code below.
+     Short numbers skip this, as reading them one by one is faster.
+     */
+    if (likely(eof - cur >= 8) && read_digi_8(cur, &sig)) {
+        if (eof - cur >= 16 && read_digi_8(cur + 8, &num)) {
+            sig = sig * 100000000 + num;
+            goto digi_intg_16;
+        }
+        goto digi_intg_8;
+    }
+#endif
+    sig = (u64)(*cur - '0');
+
+    /*
+     Read integral part, same as the following code.
+
+         for (int i = 1; i <= 18; i++) {
+            num = cur[i] - '0';
+            if (num <= 9) sig = num + sig * 10;
+            else goto digi_sepr_i;
+         }
+     */
 #define expr_intg(i) \
     if (likely((num = (u64)(cur[i] - (u8)'0')) <= 9)) sig = num + sig * 10; \
-    else { cur += i; goto intg_end; }
-    repeat_in_1_18(expr_intg)
+    else { goto digi_sepr_##i; }
+    expr_intg(1)  expr_intg(2)  expr_intg(3)  expr_intg(4)
+    expr_intg(5)  expr_intg(6)  expr_intg(7)
+#if YYJSON_HAS_DIGI_8
+digi_intg_8:
+#endif
+    expr_intg(8)  expr_intg(9)  expr_intg(10) expr_intg(11)
+    expr_intg(12) expr_intg(13) expr_intg(14) expr_intg(15)
+#if YYJSON_HAS_DIGI_8
+digi_intg_16:
+#endif
+    expr_intg(16) expr_intg(17) expr_intg(18)
 #undef expr_intg
 
-    /* here are 19 continuous digits, skip them */
-    cur += 19;
-    if (char_is_digit(cur[0]) && !char_is_digit_or_fp(cur[1])) {
-        /* this number is an integer consisting of 20 digits */
-        num = (u8)(*cur - '0');
-        if ((sig < (U64_MAX / 10)) ||
-            (sig == (U64_MAX / 10) && num <= (U64_MAX % 10))) {
-            sig = num + sig * 10;
-            cur++;
-            if (sign) {
-                if (has_flg(BIGNUM_AS_RAW)) return_raw();
-                return_f64(unsafe_yyjson_u64_to_f64(sig));
-            }
-            return_i64(sig);
-        }
-    }
 
-intg_end:
-    /* continuous digits ended */
+    cur += 19; /* skip continuous 19 digits */
     if (!char_is_digit_or_fp(*cur)) {
-        /* this number is an integer consisting of 1 to 19 digits */
-        if (sign && (sig > ((u64)1 << 63))) {
+        /* this number is an integer consisting of 19 digits */
+        if (sign && (sig > ((u64)1 << 63))) { /* overflow */
             if (has_flg(BIGNUM_AS_RAW)) return_raw();
             return_f64(unsafe_yyjson_u64_to_f64(sig));
         }
         return_i64(sig);
     }
+    goto digi_intg_more; /* read more digits in integral part */
 
-read_double:
-    /* this number should be read as double */
-    while (char_is_digit(*cur)) cur++;
-    if (!char_is_fp(*cur) && has_flg(BIGNUM_AS_RAW)) {
-        return_raw(); /* it's a large integer */
-    }
-    while (*cur == '.') {
-        /* skip fraction part */
-        dot = cur;
-        cur++;
-        if (!char_is_digit(*cur)) {
-            if (has_allow(EXT_NUMBER)) {
-                break;
-            } else {
-                return_err(cur, "no digit after decimal point");
-            }
-        }
-        cur++;
-        while (char_is_digit(*cur)) cur++;
-        break;
-    }
-    if (char_is_exp(*cur)) {
-        /* skip exponent part */
-        cur += 1 + char_is_sign(cur[1]);
-        if (!char_is_digit(*cur)) {
-            return_err(cur, "no digit after exponent sign");
-        }
-        cur++;
-        while (char_is_digit(*cur)) cur++;
-    }
 
-    /*
-     libc's strtod() is used to parse the floating-point number.
+    /* process first non-digit character */
+#define expr_sepr(i) \
+    digi_sepr_##i: \
+    if (likely(!char_is_fp(cur[i]))) { cur += i; return_i64(sig); } \
+    dot_pos = cur + i; \
+    if (likely(cur[i] == '.')) goto digi_frac_##i; \
+    cur += i; sig_end = cur; goto digi_exp_more;
+    repeat_in_1_18(expr_sepr)
+#undef expr_sepr
 
-     Note that the decimal point character used by strtod() is locale-dependent,
-     and the rounding direction may affected by fesetround().
 
-     For currently known locales, (en, zh, ja, ko, am, he, hi) use '.' as the
-     decimal point, while other locales use ',' as the decimal point.
+    /* read fraction part */
+#define expr_frac(i) \
+    digi_frac_##i: \
+    if (likely((num = (u64)(cur[i + 1] - (u8)'0')) <= 9)) \
+        sig = num + sig * 10; \
+    else { goto digi_stop_##i; }
+    repeat_in_1_18(expr_frac)
+#undef expr_frac
 
-     Here strtod() is called twice for different locales, but if another thread
-     happens calls setlocale() between two strtod(), parsing may still fail.
-     */
-    val->uni.f64 = strtod((const char *)hdr, (char **)&f64_end);
-    if (unlikely(f64_end != cur)) {
-        /* replace '.' with ',' for locale */
-        bool cut = (*cur == ',');
-        if (cut) *cur = ' ';
-        if (dot) *dot = ',';
-        val->uni.f64 = strtod((const char *)hdr, (char **)&f64_end);
-        /* restore ',' to '.' */
-        if (cut) *cur = ',';
-        if (dot) *dot = '.';
-        if (unlikely(f64_end != cur)) {
-            return_err(hdr, "strtod() failed to parse the number");
-        }
-    }
-    if (unlikely(f64_is_inf(val->uni.f64))) {
-        return_inf();
-    }
-    val->tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL;
-    *end = cur;
-    return true;
+    cur += 20; /* skip 19 digits and 1 decimal point */
+    if (!char_is_digit(*cur)) goto digi_frac_end; /* fraction part end */
+    goto digi_frac_more; /* read more digits in fraction part */
 
-#undef return_err
-#undef return_0
-#undef return_i64
-#undef return_f64
-#undef return_f64_bin
-#undef return_inf
-#undef return_raw
-}
 
-#endif /* FP_READER */
+    /* significant part end */
+#define expr_stop(i) \
+    digi_stop_##i: \
+    cur += i + 1; \
+    goto digi_frac_end;
+    repeat_in_1_18(expr_stop)
+#undef expr_stop
 
 
+    /* read more digits in integral part */
+digi_intg_more:
+    if (char_is_digit(*cur)) {
+        if (!char_is_digit_or_fp(cur[1])) {
+            /* this number is an integer consisting of 20 digits */
+            num = (u64)(*cur - '0');
+            if ((sig < (U64_MAX / 10)) ||
+                (sig == (U64_MAX / 10) && num <= (U64_MAX % 10))) {
+                sig = num + sig * 10;
+                cur++;
+                /* convert to double if overflow */
+                if (sign) {
+                    if (has_flg(BIGNUM_AS_RAW)) return_raw();
+                    return_f64(unsafe_yyjson_u64_to_f64(sig));
+                }
+                return_i64(sig);
+            }
+        }
+    }
 
-/*==============================================================================
- * MARK: - String Reader (Private)
- *============================================================================*/
+    if (char_is_exp(*cur)) {
+        dot_pos = cur;
+        goto digi_exp_more;
+    }
 
-/** Read unicode escape sequence. */
-static_inline bool read_uni_esc(u8 **src_ptr, u8 **dst_ptr, const char **msg) {
-#define return_err(_end, _msg) *msg = _msg; *src_ptr = _end; return false
+    if (*cur == '.') {
+        dot_pos = cur++;
+        if (unlikely(!char_is_digit(*cur))) {
+            if (has_allow(EXT_NUMBER)) {
+                goto digi_frac_end;
+            }
+            return_err(cur, "no digit after decimal point");
+        }
+    }
 
-    u8 *src = *src_ptr;
-    u8 *dst = *dst_ptr;
-    u16 hi, lo;
-    u32 uni;
 
-    src += 2; /* skip `\u` */
-    if (unlikely(!hex_load_4(src, &hi))) {
-        return_err(src - 2, "invalid escaped sequence in string");
-    }
-    src += 4; /* skip hex */
-    if (likely((hi & 0xF800) != 0xD800)) {
-        /* a BMP character */
-        if (hi >= 0x800) {
-            *dst++ = (u8)(0xE0 | (hi >> 12));
-            *dst++ = (u8)(0x80 | ((hi >> 6) & 0x3F));
-            *dst++ = (u8)(0x80 | (hi & 0x3F));
-        } else if (hi >= 0x80) {
-            *dst++ = (u8)(0xC0 | (hi >> 6));
-            *dst++ = (u8)(0x80 | (hi & 0x3F));
-        } else {
-            *dst++ = (u8)hi;
-        }
-    } else {
-        /* a non-BMP character, represented as a surrogate pair */
-        if (unlikely((hi & 0xFC00) != 0xD800)) {
-            return_err(src - 6, "invalid high surrogate in string");
-        }
-        if (unlikely(!byte_match_2(src, "\\u"))) {
-            return_err(src - 6, "no low surrogate in string");
-        }
-        if (unlikely(!hex_load_4(src + 2, &lo))) {
-            return_err(src - 6, "invalid escape in string");
+    /* read more digits in fraction part */
+digi_frac_more:
+    sig_cut = cur; /* too large to fit in u64, excess digits need to be cut */
+    sig += (*cur >= '5'); /* round */
+    while (char_is_digit(*++cur));
+    if (!dot_pos) {
+        if (!char_is_fp(*cur) && has_flg(BIGNUM_AS_RAW)) {
+            return_raw(); /* it's a large integer */
         }
-        if (unlikely((lo & 0xFC00) != 0xDC00)) {
-            return_err(src - 6, "invalid low surrogate in string");
+        dot_pos = cur;
+        if (*cur == '.') {
+            if (unlikely(!char_is_digit(*++cur))) {
+                if (!has_allow(EXT_NUMBER)) {
+                    return_err(cur, "no digit after decimal point");
+                }
+            }
+            while (char_is_digit(*cur)) cur++;
         }
-        uni = ((((u32)hi - 0xD800) << 10) |
-                ((u32)lo - 0xDC00)) + 0x10000;
-        *dst++ = (u8)(0xF0 | (uni >> 18));
-        *dst++ = (u8)(0x80 | ((uni >> 12) & 0x3F));
-        *dst++ = (u8)(0x80 | ((uni >> 6) & 0x3F));
-        *dst++ = (u8)(0x80 | (uni & 0x3F));
-        src += 6;
     }
-    *src_ptr = src;
-    *dst_ptr = dst;
-    return true;
-#undef return_err
-}
+    exp_sig = (i64)(dot_pos - sig_cut);
+    exp_sig += (dot_pos < sig_cut);
 
-/**
- Read a JSON string.
- @param quo The quote character (single quote or double quote).
- @param ptr The head pointer of string before quote (inout).
- @param eof JSON end position.
- @param flg JSON read flag.
- @param val The string value to be written.
- @param msg The error message pointer.
- @param con Continuation for incremental parsing.
- @return Whether success.
- */
-static_inline bool read_str_opt(u8 quo, u8 **ptr, u8 *eof, yyjson_read_flag flg,
-                                yyjson_val *val, const char **msg, u8 *con[2]) {
-    /*
-     GCC may sometimes load variables into registers too early, causing
-     unnecessary instructions and performance degradation. This inline assembly
-     serves as a hint to GCC: 'This variable will be modified, so avoid loading
-     it too early.' Other compilers like MSVC, Clang, and ICC can generate the
-     expected instructions without needing this hint.
+    /* ignore trailing zeros */
+    tmp = cur - 1;
+    while ((*tmp == '0' || *tmp == '.') && tmp > hdr) tmp--;
+    if (tmp < sig_cut) {
+        sig_cut = NULL;
+    } else {
+        sig_end = cur;
+    }
 
-     Check out this example: https://godbolt.org/z/YG6a5W5Ec
-     */
-#define return_err(_end, _msg) do { \
-    *msg = _msg; \
-    *end = _end; \
-    if (con) { con[0] = _end; con[1] = dst; } \
-    return false; \
-} while (false)
+    if (char_is_exp(*cur)) goto digi_exp_more;
+    goto digi_exp_finish;
 
-    u8 *hdr = *ptr + 1;
-    u8 **end = ptr;
-    u8 *src = hdr, *dst = NULL, *pos;
-    u32 uni, tmp;
 
-    /* Resume incremental parsing. */
-    if (con && unlikely(con[0])) {
-        src = con[0];
-        dst = con[1];
-        if (dst) goto copy_ascii;
+    /* fraction part end */
+digi_frac_end:
+    if (unlikely(dot_pos + 1 == cur)) {
+        if (!has_allow(EXT_NUMBER)) {
+            return_err(cur, "no digit after decimal point");
+        }
+    }
+    sig_end = cur;
+    exp_sig = -(i64)((u64)(cur - dot_pos) - 1);
+    if (likely(!char_is_exp(*cur))) {
+        if (unlikely(exp_sig < F64_MIN_DEC_EXP - 19)) {
+            return_f64_bin(0); /* underflow */
+        }
+        exp = (i32)exp_sig;
+        goto digi_finish;
+    } else {
+        goto digi_exp_more;
     }
 
-skip_ascii:
-    /*
-     Most strings have no escaped characters, so we can jump them quickly.
 
-     We want to make loop unrolling, as shown in the following code. Some
-     compiler may not generate instructions as expected, so we rewrite it with
-     explicit goto statements. We hope the compiler can generate instructions
-     like this: https://godbolt.org/z/8vjsYq
+    /* read exponent part */
+digi_exp_more:
+    exp_sign = (*++cur == '-');
+    cur += char_is_sign(*cur);
+    if (unlikely(!char_is_digit(*cur))) {
+        return_err(cur, "no digit after exponent sign");
+    }
+    while (*cur == '0') cur++;
 
-     while (true) repeat16({
-        if (likely((char_is_ascii_skip(*src)))) src++;
-        else break;
-     })
-     */
-    if (quo == '"') {
-#define expr_jump(i) \
-    if (likely(char_is_ascii_skip(src[i]))) {} \
-    else goto skip_ascii_stop##i;
+    /* read exponent literal */
+    tmp = cur;
+    while (char_is_digit(*cur)) {
+        exp_lit = (i64)((u8)(*cur++ - '0') + (u64)exp_lit * 10);
+    }
+    if (unlikely(cur - tmp >= U64_SAFE_DIG)) {
+        if (exp_sign) {
+            return_f64_bin(0); /* underflow */
+        } else {
+            return_inf(); /* overflow */
+        }
+    }
+    exp_sig += exp_sign ? -exp_lit : exp_lit;
 
-#define expr_stop(i) \
-    skip_ascii_stop##i: \
-    src += i; \
-    goto skip_ascii_end;
 
-    repeat16_incr(expr_jump)
-    src += 16;
-    goto skip_ascii;
-    repeat16_incr(expr_stop)
+    /* validate exponent value */
+digi_exp_finish:
+    if (unlikely(exp_sig < F64_MIN_DEC_EXP - 19)) {
+        return_f64_bin(0); /* underflow */
+    }
+    if (unlikely(exp_sig > F64_MAX_DEC_EXP)) {
+        return_inf(); /* overflow */
+    }
+    exp = (i32)exp_sig;
 
-#undef expr_jump
-#undef expr_stop
-    } else {
-#define expr_jump(i) \
-    if (likely(char_is_ascii_skip_sq(src[i]))) {} \
-    else goto skip_ascii_stop_sq##i;
 
-#define expr_stop(i) \
-    skip_ascii_stop_sq##i: \
-    src += i; \
-    goto skip_ascii_end;
+    /* all digit read finished */
+digi_finish:
 
-    repeat16_incr(expr_jump)
-    src += 16;
-    goto skip_ascii;
-    repeat16_incr(expr_stop)
+    /*
+     Fast path 1:
 
-#undef expr_jump
-#undef expr_stop
-    }
+     1. The floating-point number calculation should be accurate, see the
+        comments of macro `YYJSON_DOUBLE_MATH_CORRECT`.
+     2. Correct rounding should be performed (fegetround() == FE_TONEAREST).
+     3. The input to floating-point calculations does not lose precision,
+        which means: 64 - leading_zero(input) - trailing_zero(input) < 53.
 
-skip_ascii_end:
-    gcc_store_barrier(*src);
-    if (likely(*src == quo)) {
-        val->tag = ((u64)(src - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_STR |
-                        (quo == '"' ? YYJSON_SUBTYPE_NOESC : 0);
-        val->uni.str = (const char *)hdr;
-        *src = '\0';
-        *end = src + 1;
-        if (con) con[0] = con[1] = NULL;
-        return true;
+     We don't check all available inputs here, because that would make the code
+     more complicated, and not friendly to branch predictor.
+     */
+#if YYJSON_DOUBLE_MATH_CORRECT
+    if (sig < ((u64)1 << 53) &&
+        exp >= -F64_POW10_MAX_EXACT_EXP &&
+        exp <= +F64_POW10_MAX_EXACT_EXP) {
+        f64 dbl = (f64)sig;
+        if (exp < 0) {
+            dbl /= f64_pow10_table[-exp];
+        } else {
+            dbl *= f64_pow10_table[+exp];
+        }
+        return_f64(dbl);
     }
+#endif
+    if (unlikely(sig == 0)) return_f64_bin(0);
 
-skip_utf8:
-    if (*src & 0x80) { /* non-ASCII character */
+    /*
+     Fast path 2:
+
+     To keep it simple, we only accept normal number here,
+     let the slow path handle subnormal and infinite numbers.
+     */
+    if (likely(!sig_cut &&
+               exp > -F64_MAX_DEC_EXP + 1 &&
+               exp < +F64_MAX_DEC_EXP - 20)) {
         /*
-         Non-ASCII character appears here, which means that the text is likely
-         to be written in non-English or emoticons. According to some common
-         data set statistics, byte sequences of the same length may appear
-         consecutively. We process the byte sequences of the same length in each
-         loop, which is more friendly to branch prediction.
+         The result value is exactly equal to (sig * 10^exp),
+         the exponent part (10^exp) can be converted to (sig2 * 2^exp2).
+
+         The sig2 can be an infinite length number, only the highest 128 bits
+         is cached in the pow10_sig_table.
+
+         Now we have these bits:
+         sig1 (normalized 64bit)        : aaaaaaaa
+         sig2 (higher 64bit)            : bbbbbbbb
+         sig2_ext (lower 64bit)         : cccccccc
+         sig2_cut (extra unknown bits)  : dddddddddddd....
+
+         And the calculation process is:
+         ----------------------------------------
+                 aaaaaaaa *
+                 bbbbbbbbccccccccdddddddddddd....
+         ----------------------------------------
+         abababababababab +
+                 acacacacacacacac +
+                         adadadadadadadadadad....
+         ----------------------------------------
+         [hi____][lo____] +
+                 [hi2___][lo2___] +
+                         [unknown___________....]
+         ----------------------------------------
+
+         The addition with carry may affect higher bits, but if there is a 0
+         in higher bits, the bits higher than 0 will not be affected.
+
+         `lo2` + `unknown` may get a carry bit and may affect `hi2`, the max
+         value of `hi2` is 0xFFFFFFFFFFFFFFFE, so `hi2` will not overflow.
+
+         `lo` + `hi2` may also get a carry bit and may affect `hi`, but only
+         the highest significant 53 bits of `hi` is needed. If there is a 0
+         in the lower bits of `hi`, then all the following bits can be dropped.
+
+         To convert the result to IEEE-754 double number, we need to perform
+         correct rounding:
+         1. if bit 54 is 0, round down,
+         2. if bit 54 is 1 and any bit beyond bit 54 is 1, round up,
+         3. if bit 54 is 1 and all bits beyond bit 54 are 0, round to even,
+            as the extra bits is unknown, this case will not be handled here.
+         */
+
+        u64 raw;
+        u64 sig1, sig2, sig2_ext, hi, lo, hi2, lo2, add, bits;
+        i32 exp2;
+        u32 lz;
+        bool exact = false, carry, round_up;
+
+        /* convert (10^exp) to (sig2 * 2^exp2) */
+        pow10_table_get_sig(exp, &sig2, &sig2_ext);
+        pow10_table_get_exp(exp, &exp2);
+
+        /* normalize and multiply */
+        lz = u64_lz_bits(sig);
+        sig1 = sig << lz;
+        exp2 -= (i32)lz;
+        u128_mul(sig1, sig2, &hi, &lo);
+
+        /*
+         The `hi` is in range [0x4000000000000000, 0xFFFFFFFFFFFFFFFE],
+         To get normalized value, `hi` should be shifted to the left by 0 or 1.
+
+         The highest significant 53 bits is used by IEEE-754 double number,
+         and the bit 54 is used to detect rounding direction.
+
+         The lowest (64 - 54 - 1) bits is used to check whether it contains 0.
+         */
+        bits = hi & (((u64)1 << (64 - 54 - 1)) - 1);
+        if (bits - 1 < (((u64)1 << (64 - 54 - 1)) - 2)) {
+            /*
+             (bits != 0 && bits != 0x1FF) => (bits - 1 < 0x1FF - 1)
+             The `bits` is not zero, so we don't need to check `round to even`
+             case. The `bits` contains bit `0`, so we can drop the extra bits
+             after `0`.
+             */
+            exact = true;
+
+        } else {
+            /*
+             (bits == 0 || bits == 0x1FF)
+             The `bits` is filled with all `0` or all `1`, so we need to check
+             lower bits with another 64-bit multiplication.
+             */
+            u128_mul(sig1, sig2_ext, &hi2, &lo2);
+
+            add = lo + hi2;
+            if (add + 1 > (u64)1) {
+                /*
+                 (add != 0 && add != U64_MAX) => (add + 1 > 1)
+                 The `add` is not zero, so we don't need to check `round to
+                 even` case. The `add` contains bit `0`, so we can drop the
+                 extra bits after `0`. The `hi` cannot be U64_MAX, so it will
+                 not overflow.
+                 */
+                carry = add < lo || add < hi2;
+                hi += carry;
+                exact = true;
+            }
+        }
+
+        if (exact) {
+            /* normalize */
+            lz = hi < ((u64)1 << 63);
+            hi <<= lz;
+            exp2 -= (i32)lz;
+            exp2 += 64;
+
+            /* test the bit 54 and get rounding direction */
+            round_up = (hi & ((u64)1 << (64 - 54))) > (u64)0;
+            hi += (round_up ? ((u64)1 << (64 - 54)) : (u64)0);
+
+            /* test overflow */
+            if (hi < ((u64)1 << (64 - 54))) {
+                hi = ((u64)1 << 63);
+                exp2 += 1;
+            }
+
+            /* This is a normal number, convert it to IEEE-754 format. */
+            hi >>= F64_BITS - F64_SIG_FULL_BITS;
+            exp2 += F64_BITS - F64_SIG_FULL_BITS + F64_SIG_BITS;
+            exp2 += F64_EXP_BIAS;
+            raw = ((u64)exp2 << F64_SIG_BITS) | (hi & F64_SIG_MASK);
+            return_f64_bin(raw);
+        }
+    }
+
+    /*
+     Slow path: read double number exactly with diyfp.
+     1. Use cached diyfp to get an approximation value.
+     2. Use bigcomp to check the approximation value if needed.
+
+     This algorithm refers to google's double-conversion project:
+     https://github.com/google/double-conversion
+     */
+    {
+        const i32 ERR_ULP_LOG = 3;
+        const i32 ERR_ULP = 1 << ERR_ULP_LOG;
+        const i32 ERR_CACHED_POW = ERR_ULP / 2;
+        const i32 ERR_MUL_FIXED = ERR_ULP / 2;
+        const i32 DIY_SIG_BITS = 64;
+        const i32 EXP_BIAS = F64_EXP_BIAS + F64_SIG_BITS;
+        const i32 EXP_SUBNORMAL = -EXP_BIAS + 1;
+
+        u64 fp_err;
+        u32 bits;
+        i32 order_of_magnitude;
+        i32 effective_significand_size;
+        i32 precision_digits_count;
+        u64 precision_bits;
+        u64 half_way;
+
+        u64 raw;
+        diy_fp fp, fp_upper;
+        bigint big_full, big_comp;
+        i32 cmp;
+
+        fp.sig = sig;
+        fp.exp = 0;
+        fp_err = sig_cut ? (u64)(ERR_ULP / 2) : (u64)0;
+
+        /* normalize */
+        bits = u64_lz_bits(fp.sig);
+        fp.sig <<= bits;
+        fp.exp -= (i32)bits;
+        fp_err <<= bits;
+
+        /* multiply and add error */
+        fp = diy_fp_mul(fp, diy_fp_get_cached_pow10(exp));
+        fp_err += (u64)ERR_CACHED_POW + (fp_err != 0) + (u64)ERR_MUL_FIXED;
+
+        /* normalize */
+        bits = u64_lz_bits(fp.sig);
+        fp.sig <<= bits;
+        fp.exp -= (i32)bits;
+        fp_err <<= bits;
+
+        /* effective significand */
+        order_of_magnitude = DIY_SIG_BITS + fp.exp;
+        if (likely(order_of_magnitude >= EXP_SUBNORMAL + F64_SIG_FULL_BITS)) {
+            effective_significand_size = F64_SIG_FULL_BITS;
+        } else if (order_of_magnitude <= EXP_SUBNORMAL) {
+            effective_significand_size = 0;
+        } else {
+            effective_significand_size = order_of_magnitude - EXP_SUBNORMAL;
+        }
+
+        /* precision digits count */
+        precision_digits_count = DIY_SIG_BITS - effective_significand_size;
+        if (unlikely(precision_digits_count + ERR_ULP_LOG >= DIY_SIG_BITS)) {
+            i32 shr = (precision_digits_count + ERR_ULP_LOG) - DIY_SIG_BITS + 1;
+            fp.sig >>= shr;
+            fp.exp += shr;
+            fp_err = (fp_err >> shr) + 1 + (u32)ERR_ULP;
+            precision_digits_count -= shr;
+        }
+
+        /* half way */
+        precision_bits = fp.sig & (((u64)1 << precision_digits_count) - 1);
+        precision_bits *= (u32)ERR_ULP;
+        half_way = (u64)1 << (precision_digits_count - 1);
+        half_way *= (u32)ERR_ULP;
+
+        /* rounding */
+        fp.sig >>= precision_digits_count;
+        fp.sig += (precision_bits >= half_way + fp_err);
+        fp.exp += precision_digits_count;
+
+        /* get IEEE double raw value */
+        raw = diy_fp_to_ieee_raw(fp);
+        if (unlikely(raw == F64_BITS_INF)) return_inf();
+        if (likely(precision_bits <= half_way - fp_err ||
+                   precision_bits >= half_way + fp_err)) {
+            return_f64_bin(raw); /* number is accurate */
+        }
+        /* now the number is the correct value, or the next lower value */
+
+        /* upper boundary */
+        if (raw & F64_EXP_MASK) {
+            fp_upper.sig = (raw & F64_SIG_MASK) + ((u64)1 << F64_SIG_BITS);
+            fp_upper.exp = (i32)((raw & F64_EXP_MASK) >> F64_SIG_BITS);
+        } else {
+            fp_upper.sig = (raw & F64_SIG_MASK);
+            fp_upper.exp = 1;
+        }
+        fp_upper.exp -= F64_EXP_BIAS + F64_SIG_BITS;
+        fp_upper.sig <<= 1;
+        fp_upper.exp -= 1;
+        fp_upper.sig += 1; /* add half ulp */
+
+        /* compare with bigint */
+        bigint_set_buf(&big_full, sig, &exp, sig_cut, sig_end, dot_pos);
+        bigint_set_u64(&big_comp, fp_upper.sig);
+        if (exp >= 0) {
+            bigint_mul_pow10(&big_full, +exp);
+        } else {
+            bigint_mul_pow10(&big_comp, -exp);
+        }
+        if (fp_upper.exp > 0) {
+            bigint_mul_pow2(&big_comp, (u32)+fp_upper.exp);
+        } else {
+            bigint_mul_pow2(&big_full, (u32)-fp_upper.exp);
+        }
+        cmp = bigint_cmp(&big_full, &big_comp);
+        if (likely(cmp != 0)) {
+            /* round down or round up */
+            raw += (cmp > 0);
+        } else {
+            /* falls midway, round to even */
+            raw += (raw & 1);
+        }
+
+        if (unlikely(raw == F64_BITS_INF)) return_inf();
+        return_f64_bin(raw);
+    }
+
+#undef return_err
+#undef return_inf
+#undef return_0
+#undef return_i64
+#undef return_f64
+#undef return_f64_bin
+#undef return_raw
+}
+
+
+
+#else /* FP_READER */
+
+/**
+ Read a JSON number.
+ This is a fallback function if the custom number reader is disabled.
+ This function use libc's strtod() to read floating-point number.
+ */
+static_inline bool read_num(u8 **ptr, u8 *eof, u8 **pre,
+                            yyjson_read_flag flg, yyjson_val *val,
+                            const char **msg) {
+#define return_err(_pos, _msg) do { \
+    *msg = _msg; \
+    *end = _pos; \
+    return false; \
+} while (false)
+
+#define return_0() do { \
+    val->tag = YYJSON_TYPE_NUM | (u64)((u8)sign << 3); \
+    val->uni.u64 = 0; \
+    *end = cur; return true; \
+} while (false)
+
+#define return_i64(_v) do { \
+    val->tag = YYJSON_TYPE_NUM | (u64)((u8)sign << 3); \
+    val->uni.u64 = (u64)(sign ? (u64)(~(_v) + 1) : (u64)(_v)); \
+    *end = cur; return true; \
+} while (false)
+
+#define return_f64(_v) do { \
+    val->tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL; \
+    val->uni.f64 = sign ? -(f64)(_v) : (f64)(_v); \
+    *end = cur; return true; \
+} while (false)
+
+#define return_f64_bin(_v) do { \
+    val->tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL; \
+    val->uni.u64 = ((u64)sign << 63) | (u64)(_v); \
+    *end = cur; return true; \
+} while (false)
+
+#define return_inf() do { \
+    if (has_flg(BIGNUM_AS_RAW)) return_raw(); \
+    if (has_allow(INF_AND_NAN)) return_f64_bin(F64_BITS_INF); \
+    else return_err(hdr, "number is infinity when parsed as double"); \
+} while (false)
+
+#define return_raw() do { \
+    val->tag = ((u64)(cur - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_RAW; \
+    val->uni.str = (const char *)hdr; \
+    **pre = '\0'; *pre = cur; *end = cur; return true; \
+} while (false)
+
+    u64 sig, num;
+    u8 *hdr = *ptr;
+    u8 *cur = *ptr;
+    u8 **end = ptr;
+    u8 *dot = NULL;
+    u8 *f64_end = NULL;
+    bool sign;
+
+    /* read number as raw string if has `YYJSON_READ_NUMBER_AS_RAW` flag */
+    if (has_flg(NUMBER_AS_RAW)) {
+        return read_num_raw(ptr, pre, flg, val, msg);
+    }
+
+    sign = (*hdr == '-');
+    cur += sign;
+    sig = (u8)(*cur - '0');
+
+    /* read first digit, check leading zero */
+    while (unlikely(!char_is_digit(*cur))) {
+        if (has_allow(EXT_NUMBER)) {
+            if (*cur == '+' && cur == hdr) { /* leading `+` sign */
+                cur++;
+                sig = (u8)(*cur - '0');
+                continue;
+            }
+            if (*cur == '.' && char_is_num(cur[1])) { /* no integer part */
+                goto read_double; /* e.g. '.123' */
+            }
+        }
+        if (has_allow(INF_AND_NAN)) {
+            if (read_inf_or_nan(ptr, pre, flg, val)) return true;
+        }
+        return_err(cur, "no digit after sign");
+    }
+    if (*cur == '0') {
+        cur++;
+        if (unlikely(char_is_digit(*cur))) {
+            return_err(cur - 1, "number with leading zero is not allowed");
+        }
+        if (!char_is_fp(*cur)) {
+            if (has_allow(EXT_NUMBER) &&
+                (*cur == 'x' || *cur == 'X')) { /* hex integer */
+                return read_num_hex(ptr, pre, flg, val, msg);
+            }
+            return_0();
+        }
+        goto read_double;
+    }
+
+    /* read continuous digits, up to 19 characters */
+#define expr_intg(i) \
+    if (likely((num = (u64)(cur[i] - (u8)'0')) <= 9)) sig = num + sig * 10; \
+    else { cur += i; goto intg_end; }
+    repeat_in_1_18(expr_intg)
+#undef expr_intg
+
+    /* here are 19 continuous digits, skip them */
+    cur += 19;
+    if (char_is_digit(cur[0]) && !char_is_digit_or_fp(cur[1])) {
+        /* this number is an integer consisting of 20 digits */
+        num = (u8)(*cur - '0');
+        if ((sig < (U64_MAX / 10)) ||
+            (sig == (U64_MAX / 10) && num <= (U64_MAX % 10))) {
+            sig = num + sig * 10;
+            cur++;
+            if (sign) {
+                if (has_flg(BIGNUM_AS_RAW)) return_raw();
+                return_f64(unsafe_yyjson_u64_to_f64(sig));
+            }
+            return_i64(sig);
+        }
+    }
+
+intg_end:
+    /* continuous digits ended */
+    if (!char_is_digit_or_fp(*cur)) {
+        /* this number is an integer consisting of 1 to 19 digits */
+        if (sign && (sig > ((u64)1 << 63))) {
+            if (has_flg(BIGNUM_AS_RAW)) return_raw();
+            return_f64(unsafe_yyjson_u64_to_f64(sig));
+        }
+        return_i64(sig);
+    }
+
+read_double:
+    /* this number should be read as double */
+    while (char_is_digit(*cur)) cur++;
+    if (!char_is_fp(*cur) && has_flg(BIGNUM_AS_RAW)) {
+        return_raw(); /* it's a large integer */
+    }
+    while (*cur == '.') {
+        /* skip fraction part */
+        dot = cur;
+        cur++;
+        if (!char_is_digit(*cur)) {
+            if (has_allow(EXT_NUMBER)) {
+                break;
+            } else {
+                return_err(cur, "no digit after decimal point");
+            }
+        }
+        cur++;
+        while (char_is_digit(*cur)) cur++;
+        break;
+    }
+    if (char_is_exp(*cur)) {
+        /* skip exponent part */
+        cur += 1 + char_is_sign(cur[1]);
+        if (!char_is_digit(*cur)) {
+            return_err(cur, "no digit after exponent sign");
+        }
+        cur++;
+        while (char_is_digit(*cur)) cur++;
+    }
+
+    /*
+     libc's strtod() is used to parse the floating-point number.
+
+     Note that the decimal point character used by strtod() is locale-dependent,
+     and the rounding direction may affected by fesetround().
+
+     For currently known locales, (en, zh, ja, ko, am, he, hi) use '.' as the
+     decimal point, while other locales use ',' as the decimal point.
+
+     Here strtod() is called twice for different locales, but if another thread
+     happens calls setlocale() between two strtod(), parsing may still fail.
+     */
+    val->uni.f64 = strtod((const char *)hdr, (char **)&f64_end);
+    if (unlikely(f64_end != cur)) {
+        /* replace '.' with ',' for locale */
+        bool cut = (*cur == ',');
+        if (cut) *cur = ' ';
+        if (dot) *dot = ',';
+        val->uni.f64 = strtod((const char *)hdr, (char **)&f64_end);
+        /* restore ',' to '.' */
+        if (cut) *cur = ',';
+        if (dot) *dot = '.';
+        if (unlikely(f64_end != cur)) {
+            return_err(hdr, "strtod() failed to parse the number");
+        }
+    }
+    if (unlikely(f64_is_inf(val->uni.f64))) {
+        return_inf();
+    }
+    val->tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL;
+    *end = cur;
+    return true;
+
+#undef return_err
+#undef return_0
+#undef return_i64
+#undef return_f64
+#undef return_f64_bin
+#undef return_inf
+#undef return_raw
+}
+
+#endif /* FP_READER */
+
+
+
+/*==============================================================================
+ * MARK: - String Reader (Private)
+ *============================================================================*/
+
+/** Read unicode escape sequence. */
+static_inline bool read_uni_esc(u8 **src_ptr, u8 **dst_ptr, const char **msg) {
+#define return_err(_end, _msg) *msg = _msg; *src_ptr = _end; return false
+
+    u8 *src = *src_ptr;
+    u8 *dst = *dst_ptr;
+    u16 hi, lo;
+    u32 uni;
+
+    src += 2; /* skip `\u` */
+    if (unlikely(!hex_load_4(src, &hi))) {
+        return_err(src - 2, "invalid escaped sequence in string");
+    }
+    src += 4; /* skip hex */
+    if (likely((hi & 0xF800) != 0xD800)) {
+        /* a BMP character */
+        if (hi >= 0x800) {
+            *dst++ = (u8)(0xE0 | (hi >> 12));
+            *dst++ = (u8)(0x80 | ((hi >> 6) & 0x3F));
+            *dst++ = (u8)(0x80 | (hi & 0x3F));
+        } else if (hi >= 0x80) {
+            *dst++ = (u8)(0xC0 | (hi >> 6));
+            *dst++ = (u8)(0x80 | (hi & 0x3F));
+        } else {
+            *dst++ = (u8)hi;
+        }
+    } else {
+        /* a non-BMP character, represented as a surrogate pair */
+        if (unlikely((hi & 0xFC00) != 0xD800)) {
+            return_err(src - 6, "invalid high surrogate in string");
+        }
+        if (unlikely(!byte_match_2(src, "\\u"))) {
+            return_err(src - 6, "no low surrogate in string");
+        }
+        if (unlikely(!hex_load_4(src + 2, &lo))) {
+            return_err(src - 6, "invalid escape in string");
+        }
+        if (unlikely((lo & 0xFC00) != 0xDC00)) {
+            return_err(src - 6, "invalid low surrogate in string");
+        }
+        uni = ((((u32)hi - 0xD800) << 10) |
+                ((u32)lo - 0xDC00)) + 0x10000;
+        *dst++ = (u8)(0xF0 | (uni >> 18));
+        *dst++ = (u8)(0x80 | ((uni >> 12) & 0x3F));
+        *dst++ = (u8)(0x80 | ((uni >> 6) & 0x3F));
+        *dst++ = (u8)(0x80 | (uni & 0x3F));
+        src += 6;
+    }
+    *src_ptr = src;
+    *dst_ptr = dst;
+    return true;
+#undef return_err
+}
+
+/**
+ The string pool of the zero-copy reader (`YYJSON_READ_ZERO_COPY`), holds the
+ strings which cannot reference the input. The strings are stored as offsets
+ while reading, because the pool may be moved when it grows.
+ */
+typedef struct copy_pool {
+    u8 *hdr; /* the head of the pool, NULL if nothing is copied */
+    u8 *cur; /* the end of the used space */
+    u8 *end; /* the end of the pool */
+    const yyjson_alc *alc;
+    bool oom; /* memory allocation failed */
+} copy_pool;
+
+/**
+ Reserve space in the pool for the string beginning at `*hdr`, copy the bytes
+ before `src` into it, and move `*hdr` and `*dst` to the copy.
+ The unescaped string is never longer than the escaped one, so the space is
+ bounded by the distance to the closing quote.
+ */
+static_noinline bool copy_pool_str(copy_pool *pool, u8 quo, u8 **hdr,
+                                   u8 **dst, u8 *src, u8 *eof) {
+    u8 *end = src;
+    usize len = (usize)(src - *hdr), max, cap, use;
+    u8 *tmp;
+
+    while (end < eof && *end != quo) end += (*end == '\\') ? 2 : 1;
+    if (end > eof) end = eof;
+    /* null-terminator, and the extra bytes moved by `byte_move_forward()` */
+    max = (usize)(end - *hdr) + 1 + 16;
+    if ((usize)(pool->end - pool->cur) < max) {
+        use = (usize)(pool->cur - pool->hdr);
+        cap = (usize)(pool->end - pool->hdr);
+        cap = cap < USIZE_MAX / 2 ? cap * 2 : USIZE_MAX;
+        if (cap < use + max) cap = use + max;
+        if (cap < YYJSON_READER_COPY_POOL_MIN) cap = YYJSON_READER_COPY_POOL_MIN;
+        if (pool->hdr) {
+            tmp = (u8 *)pool->alc->realloc(pool->alc->ctx, pool->hdr,
+                                           (usize)(pool->end - pool->hdr), cap);
+        } else {
+            tmp = (u8 *)pool->alc->malloc(pool->alc->ctx, cap);
+        }
+        if (unlikely(!tmp)) {
+            pool->oom = true;
+            return false;
+        }
+        pool->hdr = tmp;
+        pool->cur = tmp + use;
+        pool->end = tmp + cap;
+    }
+    memcpy(pool->cur, *hdr, len);
+    *hdr = pool->cur;
+    *dst = pool->cur + len;
+    return true;
+}
+
+/** Move the copied strings from offsets to pointers, and pass the pool to
+    the document. The pool is not shrunk, as the allocator only grows memory. */
+static_noinline void copy_pool_end(copy_pool *pool, yyjson_doc *doc) {
+    yyjson_val *val = doc->root, *end = val + doc->val_read;
+
+    if (!pool->hdr) return;
+    for (; val < end; val++) {
+        if (unsafe_yyjson_get_tag(val) == YYJSON_TYPE_STR) {
+            val->uni.str = (const char *)pool->hdr + val->uni.ofs;
+        }
+    }
+    doc->str_pool = (char *)pool->hdr;
+}
+
+/**
+ Read a JSON string.
+ @param quo The quote character (single quote or double quote).
+ @param ptr The head pointer of string before quote (inout).
+ @param eof JSON end position.
+ @param flg JSON read flag.
+ @param val The string value to be written.
+ @param msg The error message pointer.
+ @param con Continuation for incremental parsing.
+ @param pool The string pool for zero-copy reading, or NULL to read in place.
+ @return Whether success.
+ */
+static_inline bool read_str_opt(u8 quo, u8 **ptr, u8 *eof, yyjson_read_flag flg,
+                                yyjson_val *val, const char **msg, u8 *con[2],
+                                copy_pool *pool) {
+    /*
+     GCC may sometimes load variables into registers too early, causing
+     unnecessary instructions and performance degradation. This inline assembly
+     serves as a hint to GCC: 'This variable will be modified, so avoid loading
+     it too early.' Other compilers like MSVC, Clang, and ICC can generate the
+     expected instructions without needing this hint.
+
+     Check out this example: https://godbolt.org/z/YG6a5W5Ec
+     */
+#define return_err(_end, _msg) do { \
+    *msg = _msg; \
+    *end = _end; \
+    if (con) { con[0] = _end; con[1] = dst; } \
+    return false; \
+} while (false)
+
+    u8 *hdr = *ptr + 1;
+    u8 **end = ptr;
+    u8 *src = hdr, *dst = NULL, *pos;
+    u32 uni, tmp;
+
+    /* Resume incremental parsing. */
+    if (con && unlikely(con[0])) {
+        src = con[0];
+        dst = con[1];
+        if (dst) goto copy_ascii;
+    }
+
+skip_ascii:
+    /*
+     Most strings have no escaped characters, so we can jump them quickly.
+
+     We want to make loop unrolling, as shown in the following code. Some
+     compiler may not generate instructions as expected, so we rewrite it with
+     explicit goto statements. We hope the compiler can generate instructions
+     like this: https://godbolt.org/z/8vjsYq
+
+     while (true) repeat16({
+        if (likely((char_is_ascii_skip(*src)))) src++;
+        else break;
+     })
+     */
+    if (quo == '"') {
+#define expr_jump(i) \
+    if (likely(char_is_ascii_skip(src[i]))) {} \
+    else goto skip_ascii_stop##i;
+
+#define expr_stop(i) \
+    skip_ascii_stop##i: \
+    src += i; \
+    goto skip_ascii_end;
+
+    repeat16_incr(expr_jump)
+    src += 16;
+    goto skip_ascii_more;
+    repeat16_incr(expr_stop)
+
+#undef expr_jump
+#undef expr_stop
+    } else {
+#define expr_jump(i) \
+    if (likely(char_is_ascii_skip_sq(src[i]))) {} \
+    else goto skip_ascii_stop_sq##i;
+
+#define expr_stop(i) \
+    skip_ascii_stop_sq##i: \
+    src += i; \
+    goto skip_ascii_end;
+
+    repeat16_incr(expr_jump)
+    src += 16;
+    goto skip_ascii_more;
+    repeat16_incr(expr_stop)
+
+#undef expr_jump
+#undef expr_stop
+    }
+
+skip_ascii_more:
+#if YYJSON_HAS_SIMD
+    /*
+     The string is longer than 16 bytes, skip the rest in blocks while the
+     block is entirely within the input. Short strings never get here, as the
+     table lookup above is faster for them.
+     */
+    while (likely(eof - src >= SIMD_STR_SIZE)) {
+        usize n = simd_str_stop(src, quo);
+        src += n;
+        if (likely(n < SIMD_STR_SIZE)) goto skip_ascii_end;
+    }
+#endif
+    goto skip_ascii;
+
+skip_ascii_end:
+    gcc_store_barrier(*src);
+    if (likely(*src == quo)) {
+        /* only the strings with `NOESC` may reference the input */
+        if (quo != '"' && pool) goto copy_begin;
+        val->tag = ((u64)(src - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_STR |
+                        (quo == '"' ? YYJSON_SUBTYPE_NOESC : 0);
+        val->uni.str = (const char *)hdr;
+        if (!pool) *src = '\0';
+        *end = src + 1;
+        if (con) con[0] = con[1] = NULL;
+        return true;
+    }
+
+skip_utf8:
+    if (*src & 0x80) { /* non-ASCII character */
+        /*
+         Non-ASCII character appears here, which means that the text is likely
+         to be written in non-English or emoticons. According to some common
+         data set statistics, byte sequences of the same length may appear
+         consecutively. We process the byte sequences of the same length in each
+         loop, which is more friendly to branch prediction.
          */
         pos = src;
 #if YYJSON_DISABLE_UTF8_VALIDATION
@@ -4897,7 +6980,12 @@ skip_utf8:
     }
 
     /* The escape character appears, we need to copy it. */
-    dst = src;
+copy_begin:
+    if (!pool) {
+        dst = src;
+    } else if (!copy_pool_str(pool, quo, &hdr, &dst, src, eof)) {
+        return_err(src, MSG_MALLOC);
+    }
 copy_escape:
     if (likely(*src == '\\')) {
         switch (*++src) {
@@ -4962,19 +7050,251 @@ copy_escape:
                 }
             }
         }
-    } else if (likely(*src == quo)) {
-        val->tag = ((u64)(dst - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_STR;
-        val->uni.str = (const char *)hdr;
-        *dst = '\0';
-        *end = src + 1;
-        if (con) con[0] = con[1] = NULL;
-        return true;
+    } else if (likely(*src == quo)) {
+        val->tag = ((u64)(dst - hdr) << YYJSON_TAG_BIT) | YYJSON_TYPE_STR;
+        if (!pool) {
+            val->uni.str = (const char *)hdr;
+        } else {
+            val->uni.ofs = (usize)(hdr - pool->hdr);
+            pool->cur = dst + 1;
+        }
+        *dst = '\0';
+        *end = src + 1;
+        if (con) con[0] = con[1] = NULL;
+        return true;
+    } else {
+        if (!has_allow(INVALID_UNICODE)) {
+            return_err(src, "unexpected control character in string");
+        }
+        if (src >= eof) return_err(src, "unclosed string");
+        *dst++ = *src++;
+    }
+
+copy_ascii:
+    /*
+     Copy continuous ASCII, loop unrolling, same as the following code:
+
+     while (true) repeat16({
+        if (char_is_ascii_skip(*src)) *dst++ = *src++;
+        else break;
+     })
+     */
+    if (quo == '"') {
+#define expr_jump(i) \
+    if (likely((char_is_ascii_skip(src[i])))) {} \
+    else { gcc_store_barrier(src[i]); goto copy_ascii_stop_##i; }
+    repeat16_incr(expr_jump)
+#undef expr_jump
+    } else {
+#define expr_jump(i) \
+    if (likely((char_is_ascii_skip_sq(src[i])))) {} \
+    else { gcc_store_barrier(src[i]); goto copy_ascii_stop_##i; }
+    repeat16_incr(expr_jump)
+#undef expr_jump
+    }
+
+    byte_move_16(dst, src);
+    dst += 16; src += 16;
+#if YYJSON_HAS_SIMD
+    goto copy_ascii_more;
+#else
+    goto copy_ascii;
+#endif
+
+    /*
+     The memory is copied forward since `dst < src`.
+     So it's safe to move one extra byte to reduce instruction count.
+     */
+#define expr_jump(i) \
+    copy_ascii_stop_##i: \
+    byte_move_forward(dst, src, i); \
+    dst += i; src += i; \
+    goto copy_utf8;
+    repeat16_incr(expr_jump)
+#undef expr_jump
+
+#if YYJSON_HAS_SIMD
+copy_ascii_more:
+    /* Same as `skip_ascii_more`, copy the rest of a long run in blocks. */
+    while (likely(eof - src >= SIMD_STR_SIZE)) {
+        usize n = simd_str_stop(src, quo);
+        if (likely(n == SIMD_STR_SIZE)) {
+            byte_move_16(dst, src);
+#if SIMD_STR_SIZE == 32
+            byte_move_16(dst + 16, src + 16);
+#endif
+            dst += SIMD_STR_SIZE; src += SIMD_STR_SIZE;
+            continue;
+        }
+#if SIMD_STR_SIZE == 32
+        if (n >= 16) {
+            byte_move_16(dst, src);
+            dst += 16; src += 16; n -= 16;
+        }
+#endif
+        /* same as `copy_ascii_stop_##i` above */
+        byte_move_forward(dst, src, n);
+        dst += n; src += n;
+        goto copy_utf8;
+    }
+    goto copy_ascii;
+#endif
+
+copy_utf8:
+    if (*src & 0x80) { /* non-ASCII character */
+        pos = src;
+        uni = byte_load_4(src);
+#if YYJSON_DISABLE_UTF8_VALIDATION
+        while (true) repeat4({
+            if ((uni & utf8_seq(b3_mask)) == utf8_seq(b3_patt)) {
+                byte_copy_4(dst, &uni);
+                dst += 3; src += 3;
+                uni = byte_load_4(src);
+            } else break;
+        })
+        if ((uni & utf8_seq(b1_mask)) == utf8_seq(b1_patt)) goto copy_ascii;
+        while (true) repeat4({
+            if ((uni & utf8_seq(b2_mask)) == utf8_seq(b2_patt)) {
+                byte_copy_2(dst, &uni);
+                dst += 2; src += 2;
+                uni = byte_load_4(src);
+            } else break;
+        })
+        while (true) repeat4({
+            if ((uni & utf8_seq(b4_mask)) == utf8_seq(b4_patt)) {
+                byte_copy_4(dst, &uni);
+                dst += 4; src += 4;
+                uni = byte_load_4(src);
+            } else break;
+        })
+#else
+        while (is_utf8_seq3(uni)) {
+            byte_copy_4(dst, &uni);
+            dst += 3; src += 3;
+            uni = byte_load_4(src);
+        }
+        if (is_utf8_seq1(uni)) goto copy_ascii;
+        while (is_utf8_seq2(uni)) {
+            byte_copy_2(dst, &uni);
+            dst += 2; src += 2;
+            uni = byte_load_4(src);
+        }
+        while (is_utf8_seq4(uni)) {
+            byte_copy_4(dst, &uni);
+            dst += 4; src += 4;
+            uni = byte_load_4(src);
+        }
+#endif
+        if (unlikely(pos == src)) {
+            if (!has_allow(INVALID_UNICODE)) {
+                return_err(src, MSG_ERR_UTF8);
+            }
+            goto copy_ascii_stop_1;
+        }
+        goto copy_ascii;
+    }
+    goto copy_escape;
+
+#undef return_err
+}
+
+static_inline bool read_str(u8 **ptr, u8 *eof, yyjson_read_flag flg,
+                            yyjson_val *val, const char **msg,
+                            copy_pool *pool) {
+    return read_str_opt('\"', ptr, eof, flg, val, msg, NULL, pool);
+}
+
+static_inline bool read_str_con(u8 **ptr, u8 *eof, yyjson_read_flag flg,
+                                yyjson_val *val, const char **msg, u8 **con) {
+    return read_str_opt('\"', ptr, eof, flg, val, msg, con, NULL);
+}
+
+static_noinline bool read_str_sq(u8 **ptr, u8 *eof, yyjson_read_flag flg,
+                                 yyjson_val *val, const char **msg,
+                                 copy_pool *pool) {
+    return read_str_opt('\'', ptr, eof, flg, val, msg, NULL, pool);
+}
+
+/** Read unquoted key (identifier name). */
+static_noinline bool read_str_id(u8 **ptr, u8 *eof, yyjson_read_flag flg,
+                                 u8 **pre, yyjson_val *val, const char **msg) {
+#define return_err(_end, _msg) do { \
+    *msg = _msg; \
+    *end = _end; \
+    return false; \
+} while (false)
+
+#define return_suc(_str_end, _cur_end) do { \
+    val->tag = ((u64)(_str_end - hdr) << YYJSON_TAG_BIT) | \
+                (u64)(YYJSON_TYPE_STR); \
+    val->uni.str = (const char *)hdr; \
+    *pre = _str_end; *end = _cur_end; \
+    return true; \
+} while (false)
+
+    u8 *hdr = *ptr;
+    u8 **end = ptr;
+    u8 *src = hdr, *dst = NULL;
+    u32 uni, tmp;
+
+    /* add null-terminator for previous raw string */
+    **pre = '\0';
+
+skip_ascii:
+#define expr_jump(i) \
+    if (likely(char_is_id_ascii(src[i]))) {} \
+    else goto skip_ascii_stop##i;
+
+#define expr_stop(i) \
+    skip_ascii_stop##i: \
+    src += i; \
+    goto skip_ascii_end;
+
+    repeat16_incr(expr_jump)
+    src += 16;
+    goto skip_ascii;
+    repeat16_incr(expr_stop)
+
+#undef expr_jump
+#undef expr_stop
+
+skip_ascii_end:
+    gcc_store_barrier(*src);
+    if (likely(!char_is_id_next(*src))) {
+        return_suc(src, src);
+    }
+
+skip_utf8:
+    while (*src >= 0x80) {
+        if (has_allow(EXT_WHITESPACE)) {
+            if (char_is_space_ext(*src) && ext_space_len(src)) {
+                return_suc(src, src);
+            }
+        }
+        uni = byte_load_4(src);
+        if (is_utf8_seq2(uni)) {
+            src += 2;
+        } else if (is_utf8_seq3(uni)) {
+            src += 3;
+        } else if (is_utf8_seq4(uni)) {
+            src += 4;
+        } else {
+#if !YYJSON_DISABLE_UTF8_VALIDATION
+            if (!has_allow(INVALID_UNICODE)) return_err(src, MSG_ERR_UTF8);
+#endif
+            src += 1;
+        }
+    }
+    if (char_is_id_ascii(*src)) goto skip_ascii;
+
+    /* The escape character appears, we need to copy it. */
+    dst = src;
+copy_escape:
+    if (byte_match_2(src, "\\u")) {
+        if (!read_uni_esc(&src, &dst, msg)) return_err(src, *msg);
     } else {
-        if (!has_allow(INVALID_UNICODE)) {
-            return_err(src, "unexpected control character in string");
-        }
-        if (src >= eof) return_err(src, "unclosed string");
-        *dst++ = *src++;
+        if (!char_is_id_next(*src)) return_suc(dst, src);
+        return_err(src, "unexpected character in key");
     }
 
 copy_ascii:
@@ -4986,28 +7306,16 @@ copy_ascii:
         else break;
      })
      */
-    if (quo == '"') {
-#define expr_jump(i) \
-    if (likely((char_is_ascii_skip(src[i])))) {} \
-    else { gcc_store_barrier(src[i]); goto copy_ascii_stop_##i; }
-    repeat16_incr(expr_jump)
-#undef expr_jump
-    } else {
 #define expr_jump(i) \
-    if (likely((char_is_ascii_skip_sq(src[i])))) {} \
+    if (likely((char_is_id_ascii(src[i])))) {} \
     else { gcc_store_barrier(src[i]); goto copy_ascii_stop_##i; }
     repeat16_incr(expr_jump)
 #undef expr_jump
-    }
 
     byte_move_16(dst, src);
     dst += 16; src += 16;
     goto copy_ascii;
 
-    /*
-     The memory is copied forward since `dst < src`.
-     So it's safe to move one extra byte to reduce instruction count.
-     */
 #define expr_jump(i) \
     copy_ascii_stop_##i: \
     byte_move_forward(dst, src, i); \
@@ -5017,234 +7325,605 @@ copy_ascii:
 #undef expr_jump
 
 copy_utf8:
-    if (*src & 0x80) { /* non-ASCII character */
-        pos = src;
-        uni = byte_load_4(src);
-#if YYJSON_DISABLE_UTF8_VALIDATION
-        while (true) repeat4({
-            if ((uni & utf8_seq(b3_mask)) == utf8_seq(b3_patt)) {
-                byte_copy_4(dst, &uni);
-                dst += 3; src += 3;
-                uni = byte_load_4(src);
-            } else break;
-        })
-        if ((uni & utf8_seq(b1_mask)) == utf8_seq(b1_patt)) goto copy_ascii;
-        while (true) repeat4({
-            if ((uni & utf8_seq(b2_mask)) == utf8_seq(b2_patt)) {
-                byte_copy_2(dst, &uni);
-                dst += 2; src += 2;
-                uni = byte_load_4(src);
-            } else break;
-        })
-        while (true) repeat4({
-            if ((uni & utf8_seq(b4_mask)) == utf8_seq(b4_patt)) {
-                byte_copy_4(dst, &uni);
-                dst += 4; src += 4;
-                uni = byte_load_4(src);
-            } else break;
-        })
-#else
-        while (is_utf8_seq3(uni)) {
-            byte_copy_4(dst, &uni);
-            dst += 3; src += 3;
-            uni = byte_load_4(src);
+    while (*src >= 0x80) { /* non-ASCII character */
+        if (has_allow(EXT_WHITESPACE)) {
+            if (char_is_space_ext(*src) && ext_space_len(src)) {
+                return_suc(dst, src);
+            }
         }
-        if (is_utf8_seq1(uni)) goto copy_ascii;
-        while (is_utf8_seq2(uni)) {
+        uni = byte_load_4(src);
+        if (is_utf8_seq2(uni)) {
             byte_copy_2(dst, &uni);
             dst += 2; src += 2;
-            uni = byte_load_4(src);
-        }
-        while (is_utf8_seq4(uni)) {
+        } else if (is_utf8_seq3(uni)) {
+            byte_copy_4(dst, &uni);
+            dst += 3; src += 3;
+        } else if (is_utf8_seq4(uni)) {
             byte_copy_4(dst, &uni);
             dst += 4; src += 4;
-            uni = byte_load_4(src);
+        } else {
+#if !YYJSON_DISABLE_UTF8_VALIDATION
+            if (!has_allow(INVALID_UNICODE)) return_err(src, MSG_ERR_UTF8);
+#endif
+            *dst = *src;
+            dst += 1; src += 1;
+        }
+    }
+    if (char_is_id_ascii(*src)) goto copy_ascii;
+    goto copy_escape;
+
+#undef return_err
+#undef return_suc
+}
+
+
+
+/*==============================================================================
+ * MARK: - JSON Reader Implementation (Private)
+ *
+ * We use goto statements to build the finite state machine (FSM).
+ * The FSM's state was held by program counter (PC) and the 'goto' make the
+ * state transitions.
+ *============================================================================*/
+
+/** Read single value JSON document. */
+static_noinline yyjson_doc *read_root_single(u8 *hdr, u8 *cur, u8 *eof,
+                                             yyjson_alc alc,
+                                             yyjson_read_flag flg,
+                                             yyjson_read_err *err,
+                                             copy_pool *pool) {
+#define return_err(_pos, _code, _msg) do { \
+    if (is_truncated_end(hdr, _pos, eof, YYJSON_READ_ERROR_##_code, flg)) { \
+        err->pos = (usize)(eof - hdr); \
+        err->code = YYJSON_READ_ERROR_UNEXPECTED_END; \
+        err->msg = MSG_NOT_END; \
+    } else { \
+        err->pos = (usize)(_pos - hdr); \
+        err->code = YYJSON_READ_ERROR_##_code; \
+        err->msg = _msg; \
+    } \
+    if (val_hdr) alc.free(alc.ctx, val_hdr); \
+    return NULL; \
+} while (false)
+
+    usize hdr_len; /* value count used by doc */
+    usize alc_num; /* value count capacity */
+    yyjson_val *val_hdr; /* the head of allocated values */
+    yyjson_val *val; /* current value */
+    yyjson_doc *doc; /* the JSON document, equals to val_hdr */
+    const char *msg; /* error message */
+
+    u8 raw_end[1]; /* raw end for null-terminator */
+    u8 *raw_ptr = raw_end;
+    u8 **pre = &raw_ptr; /* previous raw end pointer */
+
+    hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
+    hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
+    alc_num = hdr_len + 1; /* single value */
+
+    val_hdr = (yyjson_val *)alc.malloc(alc.ctx, alc_num * sizeof(yyjson_val));
+    if (unlikely(!val_hdr)) goto fail_alloc;
+    val = val_hdr + hdr_len;
+
+    if (char_is_num(*cur)) {
+        if (likely(read_num(&cur, eof, pre, flg, val, &msg))) goto doc_end;
+        goto fail_number;
+    }
+    if (*cur == '"') {
+        if (likely(read_str(&cur, eof, flg, val, &msg, pool))) goto doc_end;
+        goto fail_string;
+    }
+    if (*cur == 't') {
+        if (likely(read_true(&cur, val))) goto doc_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        if (likely(read_false(&cur, val))) goto doc_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        if (likely(read_null(&cur, val))) goto doc_end;
+        if (has_allow(INF_AND_NAN)) {
+            if (read_nan(&cur, pre, flg, val)) goto doc_end;
+        }
+        goto fail_literal_null;
+    }
+    if (has_allow(INF_AND_NAN)) {
+        if (read_inf_or_nan(&cur, pre, flg, val)) goto doc_end;
+    }
+    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
+        if (likely(read_str_sq(&cur, eof, flg, val, &msg, pool))) goto doc_end;
+        goto fail_string;
+    }
+    goto fail_character;
+
+doc_end:
+    /* check invalid contents after json document */
+    if (unlikely(cur < eof) && !has_flg(STOP_WHEN_DONE)) {
+        while (char_is_space(*cur)) cur++;
+        if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+            if (!skip_trivia(&cur, eof, flg) && cur == eof) {
+                goto fail_comment;
+            }
         }
+        if (unlikely(cur < eof)) goto fail_garbage;
+    }
+
+    **pre = '\0';
+    doc = (yyjson_doc *)val_hdr;
+    doc->root = val_hdr + hdr_len;
+    doc->alc = alc;
+    doc->dat_read = (usize)(cur - hdr);
+    doc->val_read = 1;
+    doc->str_pool = has_flg(INSITU) ? NULL : (char *)hdr;
+    memset(&doc->ext, 0, sizeof(yyjson_doc_ext));
+    doc->ext.stats.val_alloc = 1;
+    doc->ext.stats.val_cap = 1;
+    return doc;
+
+fail_string:        return_err(cur, INVALID_STRING, msg);
+fail_number:        return_err(cur, INVALID_NUMBER, msg);
+fail_alloc:         return_err(cur, MEMORY_ALLOCATION, MSG_MALLOC);
+fail_literal_true:  return_err(cur, LITERAL, MSG_CHAR_T);
+fail_literal_false: return_err(cur, LITERAL, MSG_CHAR_F);
+fail_literal_null:  return_err(cur, LITERAL, MSG_CHAR_N);
+fail_character:     return_err(cur, UNEXPECTED_CHARACTER, MSG_CHAR);
+fail_comment:       return_err(cur, INVALID_COMMENT, MSG_COMMENT);
+fail_garbage:       return_err(cur, UNEXPECTED_CONTENT, MSG_GARBAGE);
+fail_depth:         return_err(cur, DEPTH, MSG_DEPTH);
+
+#undef return_err
+}
+
+/** Read JSON document (accept all style, but optimized for minify). */
+static_inline yyjson_doc *read_root_minify(u8 *hdr, u8 *cur, u8 *eof,
+                                           yyjson_alc alc,
+                                           yyjson_read_flag flg,
+                                           yyjson_read_err *err,
+                                           usize val_num,
+                                           copy_pool *pool) {
+#define return_err(_pos, _code, _msg) do { \
+    if (is_truncated_end(hdr, _pos, eof, YYJSON_READ_ERROR_##_code, flg)) { \
+        err->pos = (usize)(eof - hdr); \
+        err->code = YYJSON_READ_ERROR_UNEXPECTED_END; \
+        err->msg = MSG_NOT_END; \
+    } else { \
+        err->pos = (usize)(_pos - hdr); \
+        err->code = YYJSON_READ_ERROR_##_code; \
+        err->msg = _msg; \
+    } \
+    if (val_hdr) alc.free(alc.ctx, val_hdr); \
+    return NULL; \
+} while (false)
+
+#define val_incr() do { \
+    val++; \
+    if (unlikely(val >= val_end)) { \
+        usize alc_old = alc_len; \
+        usize val_ofs = (usize)(val - val_hdr); \
+        usize ctn_ofs = (usize)(ctn - val_hdr); \
+        alc_len += alc_len / 2; \
+        if ((sizeof(usize) < 8) && (alc_len >= alc_max)) goto fail_alloc; \
+        val_tmp = (yyjson_val *)alc.realloc(alc.ctx, (void *)val_hdr, \
+            alc_old * sizeof(yyjson_val), \
+            alc_len * sizeof(yyjson_val)); \
+        if ((!val_tmp)) goto fail_alloc; \
+        val_grow++; \
+        val = val_tmp + val_ofs; \
+        ctn = val_tmp + ctn_ofs; \
+        val_hdr = val_tmp; \
+        val_end = val_tmp + (alc_len - 2); \
+    } \
+} while (false)
+
+    usize dat_len; /* data length in bytes, hint for allocator */
+    usize hdr_len; /* value count used by yyjson_doc */
+    usize alc_len; /* value count allocated */
+    usize alc_ini; /* value count allocated before reading */
+    usize alc_max; /* maximum value count for allocator */
+    usize val_grow = 0; /* the number of times the values are reallocated */
+    usize ctn_len; /* the number of elements in current container */
+    yyjson_val *val_hdr; /* the head of allocated values */
+    yyjson_val *val_end; /* the end of allocated values */
+    yyjson_val *val_tmp; /* temporary pointer for realloc */
+    yyjson_val *val; /* current JSON value */
+    yyjson_val *ctn; /* current container */
+    yyjson_val *ctn_parent; /* parent of current container */
+    yyjson_doc *doc; /* the JSON document, equals to val_hdr */
+    const char *msg; /* error message */
+
+    u8 raw_end[1]; /* raw end for null-terminator */
+    u8 *raw_ptr = raw_end;
+    u8 **pre = &raw_ptr; /* previous raw end pointer */
+
+#if YYJSON_READER_DEPTH_LIMIT
+    u32 container_depth = 0; /* current array/object depth */
 #endif
-        if (unlikely(pos == src)) {
-            if (!has_allow(INVALID_UNICODE)) {
-                return_err(src, MSG_ERR_UTF8);
-            }
-            goto copy_ascii_stop_1;
-        }
-        goto copy_ascii;
+
+    dat_len = has_flg(STOP_WHEN_DONE) ? 256 : (usize)(eof - cur);
+    hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
+    hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
+    alc_max = USIZE_MAX / sizeof(yyjson_val);
+    if (val_num) {
+        alc_len = hdr_len + val_num + 2; /* padding for key-value pair */
+    } else {
+        alc_len = hdr_len +
+                  (dat_len / YYJSON_READER_ESTIMATED_MINIFY_RATIO) + 4;
     }
-    goto copy_escape;
+    alc_len = yyjson_min(alc_len, alc_max);
+    alc_ini = alc_len;
 
-#undef return_err
-}
+    val_hdr = (yyjson_val *)alc.malloc(alc.ctx, alc_len * sizeof(yyjson_val));
+    if (unlikely(!val_hdr)) goto fail_alloc;
+    val_end = val_hdr + (alc_len - 2); /* padding for key-value pair reading */
+    val = val_hdr + hdr_len;
+    ctn = val;
+    ctn_len = 0;
 
-static_inline bool read_str(u8 **ptr, u8 *eof, yyjson_read_flag flg,
-                            yyjson_val *val, const char **msg) {
-    return read_str_opt('\"', ptr, eof, flg, val, msg, NULL);
-}
+    if (*cur++ == '{') {
+        ctn->tag = YYJSON_TYPE_OBJ;
+        ctn->uni.ofs = 0;
+        goto obj_key_begin;
+    } else {
+        ctn->tag = YYJSON_TYPE_ARR;
+        ctn->uni.ofs = 0;
+        goto arr_val_begin;
+    }
 
-static_inline bool read_str_con(u8 **ptr, u8 *eof, yyjson_read_flag flg,
-                                yyjson_val *val, const char **msg, u8 **con) {
-    return read_str_opt('\"', ptr, eof, flg, val, msg, con);
-}
+arr_begin:
+#if YYJSON_READER_DEPTH_LIMIT
+    container_depth++;
+    if (unlikely(container_depth >= YYJSON_READER_DEPTH_LIMIT)) {
+        goto fail_depth;
+    }
+#endif
+    /* save current container */
+    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
+               (ctn->tag & YYJSON_TAG_MASK);
 
-static_noinline bool read_str_sq(u8 **ptr, u8 *eof, yyjson_read_flag flg,
-                                 yyjson_val *val, const char **msg) {
-    return read_str_opt('\'', ptr, eof, flg, val, msg, NULL);
-}
+    /* create a new array value, save parent container offset */
+    val_incr();
+    val->tag = YYJSON_TYPE_ARR;
+    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
 
-/** Read unquoted key (identifier name). */
-static_noinline bool read_str_id(u8 **ptr, u8 *eof, yyjson_read_flag flg,
-                                 u8 **pre, yyjson_val *val, const char **msg) {
-#define return_err(_end, _msg) do { \
-    *msg = _msg; \
-    *end = _end; \
-    return false; \
-} while (false)
+    /* push the new array value as current container */
+    ctn = val;
+    ctn_len = 0;
 
-#define return_suc(_str_end, _cur_end) do { \
-    val->tag = ((u64)(_str_end - hdr) << YYJSON_TAG_BIT) | \
-                (u64)(YYJSON_TYPE_STR); \
-    val->uni.str = (const char *)hdr; \
-    *pre = _str_end; *end = _cur_end; \
-    return true; \
-} while (false)
+arr_val_begin:
+    if (*cur == '{') {
+        cur++;
+        goto obj_begin;
+    }
+    if (*cur == '[') {
+        cur++;
+        goto arr_begin;
+    }
+    if (char_is_num(*cur)) {
+        val_incr();
+        ctn_len++;
+        if (likely(read_num(&cur, eof, pre, flg, val, &msg))) goto arr_val_end;
+        goto fail_number;
+    }
+    if (*cur == '"') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_str(&cur, eof, flg, val, &msg, pool))) goto arr_val_end;
+        goto fail_string;
+    }
+    if (*cur == 't') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_true(&cur, val))) goto arr_val_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_false(&cur, val))) goto arr_val_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_null(&cur, val))) goto arr_val_end;
+        if (has_allow(INF_AND_NAN)) {
+            if (read_nan(&cur, pre, flg, val)) goto arr_val_end;
+        }
+        goto fail_literal_null;
+    }
+    if (*cur == ']') {
+        cur++;
+        if (likely(ctn_len == 0)) goto arr_end;
+        if (has_allow(TRAILING_COMMAS)) goto arr_end;
+        do { cur--; } while (*cur != ',');
+        goto fail_trailing_comma;
+    }
+    if (char_is_space(*cur)) {
+        while (char_is_space(*++cur));
+        goto arr_val_begin;
+    }
+    if (has_allow(INF_AND_NAN) &&
+        (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
+        val_incr();
+        ctn_len++;
+        if (read_inf_or_nan(&cur, pre, flg, val)) goto arr_val_end;
+        goto fail_character_val;
+    }
+    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_str_sq(&cur, eof, flg, val, &msg, pool))) goto arr_val_end;
+        goto fail_string;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto arr_val_begin;
+        if (cur == eof) goto fail_comment;
+    }
+    goto fail_character_val;
 
-    u8 *hdr = *ptr;
-    u8 **end = ptr;
-    u8 *src = hdr, *dst = NULL;
-    u32 uni, tmp;
+arr_val_end:
+    if (*cur == ',') {
+        cur++;
+        goto arr_val_begin;
+    }
+    if (*cur == ']') {
+        cur++;
+        goto arr_end;
+    }
+    if (char_is_space(*cur)) {
+        while (char_is_space(*++cur));
+        goto arr_val_end;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto arr_val_end;
+        if (cur == eof) goto fail_comment;
+    }
+    goto fail_character_arr_end;
 
-    /* add null-terminator for previous raw string */
-    **pre = '\0';
+arr_end:
+#if YYJSON_READER_DEPTH_LIMIT
+    container_depth--;
+#endif
+    /* get parent container */
+    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
 
-skip_ascii:
-#define expr_jump(i) \
-    if (likely(char_is_id_ascii(src[i]))) {} \
-    else goto skip_ascii_stop##i;
+    /* save the next sibling value offset */
+    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
+    ctn->tag = ((ctn_len) << YYJSON_TAG_BIT) | YYJSON_TYPE_ARR;
+    if (unlikely(ctn == ctn_parent)) goto doc_end;
 
-#define expr_stop(i) \
-    skip_ascii_stop##i: \
-    src += i; \
-    goto skip_ascii_end;
+    /* pop parent as current container */
+    ctn = ctn_parent;
+    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
+    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
+        goto obj_val_end;
+    } else {
+        goto arr_val_end;
+    }
 
-    repeat16_incr(expr_jump)
-    src += 16;
-    goto skip_ascii;
-    repeat16_incr(expr_stop)
+obj_begin:
+#if YYJSON_READER_DEPTH_LIMIT
+    container_depth++;
+    if (unlikely(container_depth >= YYJSON_READER_DEPTH_LIMIT)) {
+        goto fail_depth;
+    }
+#endif
+    /* push container */
+    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
+               (ctn->tag & YYJSON_TAG_MASK);
+    val_incr();
+    val->tag = YYJSON_TYPE_OBJ;
+    /* offset to the parent */
+    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
+    ctn = val;
+    ctn_len = 0;
 
-#undef expr_jump
-#undef expr_stop
+obj_key_begin:
+    if (likely(*cur == '"')) {
+        val_incr();
+        ctn_len++;
+        if (likely(read_str(&cur, eof, flg, val, &msg, pool))) goto obj_key_end;
+        goto fail_string;
+    }
+    if (likely(*cur == '}')) {
+        cur++;
+        if (likely(ctn_len == 0)) goto obj_end;
+        if (has_allow(TRAILING_COMMAS)) goto obj_end;
+        do { cur--; } while (*cur != ',');
+        goto fail_trailing_comma;
+    }
+    if (char_is_space(*cur)) {
+        while (char_is_space(*++cur));
+        goto obj_key_begin;
+    }
+    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_str_sq(&cur, eof, flg, val, &msg, pool))) goto obj_key_end;
+        goto fail_string;
+    }
+    if (has_allow(UNQUOTED_KEY) && char_is_id_start(*cur)) {
+        val_incr();
+        ctn_len++;
+        if (read_str_id(&cur, eof, flg, pre, val, &msg)) goto obj_key_end;
+        goto fail_string;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto obj_key_begin;
+        if (cur == eof) goto fail_comment;
+    }
+    goto fail_character_obj_key;
 
-skip_ascii_end:
-    gcc_store_barrier(*src);
-    if (likely(!char_is_id_next(*src))) {
-        return_suc(src, src);
+obj_key_end:
+    if (*cur == ':') {
+        cur++;
+        goto obj_val_begin;
+    }
+    if (char_is_space(*cur)) {
+        while (char_is_space(*++cur));
+        goto obj_key_end;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto obj_key_end;
+        if (cur == eof) goto fail_comment;
     }
+    goto fail_character_obj_sep;
 
-skip_utf8:
-    while (*src >= 0x80) {
-        if (has_allow(EXT_WHITESPACE)) {
-            if (char_is_space_ext(*src) && ext_space_len(src)) {
-                return_suc(src, src);
-            }
-        }
-        uni = byte_load_4(src);
-        if (is_utf8_seq2(uni)) {
-            src += 2;
-        } else if (is_utf8_seq3(uni)) {
-            src += 3;
-        } else if (is_utf8_seq4(uni)) {
-            src += 4;
-        } else {
-#if !YYJSON_DISABLE_UTF8_VALIDATION
-            if (!has_allow(INVALID_UNICODE)) return_err(src, MSG_ERR_UTF8);
-#endif
-            src += 1;
+obj_val_begin:
+    if (*cur == '"') {
+        val++;
+        ctn_len++;
+        if (likely(read_str(&cur, eof, flg, val, &msg, pool))) goto obj_val_end;
+        goto fail_string;
+    }
+    if (char_is_num(*cur)) {
+        val++;
+        ctn_len++;
+        if (likely(read_num(&cur, eof, pre, flg, val, &msg))) goto obj_val_end;
+        goto fail_number;
+    }
+    if (*cur == '{') {
+        cur++;
+        goto obj_begin;
+    }
+    if (*cur == '[') {
+        cur++;
+        goto arr_begin;
+    }
+    if (*cur == 't') {
+        val++;
+        ctn_len++;
+        if (likely(read_true(&cur, val))) goto obj_val_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        val++;
+        ctn_len++;
+        if (likely(read_false(&cur, val))) goto obj_val_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        val++;
+        ctn_len++;
+        if (likely(read_null(&cur, val))) goto obj_val_end;
+        if (has_allow(INF_AND_NAN)) {
+            if (read_nan(&cur, pre, flg, val)) goto obj_val_end;
         }
+        goto fail_literal_null;
     }
-    if (char_is_id_ascii(*src)) goto skip_ascii;
-
-    /* The escape character appears, we need to copy it. */
-    dst = src;
-copy_escape:
-    if (byte_match_2(src, "\\u")) {
-        if (!read_uni_esc(&src, &dst, msg)) return_err(src, *msg);
-    } else {
-        if (!char_is_id_next(*src)) return_suc(dst, src);
-        return_err(src, "unexpected character in key");
+    if (char_is_space(*cur)) {
+        while (char_is_space(*++cur));
+        goto obj_val_begin;
     }
+    if (has_allow(INF_AND_NAN) &&
+        (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
+        val++;
+        ctn_len++;
+        if (read_inf_or_nan(&cur, pre, flg, val)) goto obj_val_end;
+        goto fail_character_val;
+    }
+    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
+        val++;
+        ctn_len++;
+        if (likely(read_str_sq(&cur, eof, flg, val, &msg, pool))) goto obj_val_end;
+        goto fail_string;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto obj_val_begin;
+        if (cur == eof) goto fail_comment;
+    }
+    goto fail_character_val;
 
-copy_ascii:
-    /*
-     Copy continuous ASCII, loop unrolling, same as the following code:
-
-     while (true) repeat16({
-        if (char_is_ascii_skip(*src)) *dst++ = *src++;
-        else break;
-     })
-     */
-#define expr_jump(i) \
-    if (likely((char_is_id_ascii(src[i])))) {} \
-    else { gcc_store_barrier(src[i]); goto copy_ascii_stop_##i; }
-    repeat16_incr(expr_jump)
-#undef expr_jump
-
-    byte_move_16(dst, src);
-    dst += 16; src += 16;
-    goto copy_ascii;
+obj_val_end:
+    if (likely(*cur == ',')) {
+        cur++;
+        goto obj_key_begin;
+    }
+    if (likely(*cur == '}')) {
+        cur++;
+        goto obj_end;
+    }
+    if (char_is_space(*cur)) {
+        while (char_is_space(*++cur));
+        goto obj_val_end;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto obj_val_end;
+        if (cur == eof) goto fail_comment;
+    }
+    goto fail_character_obj_end;
 
-#define expr_jump(i) \
-    copy_ascii_stop_##i: \
-    byte_move_forward(dst, src, i); \
-    dst += i; src += i; \
-    goto copy_utf8;
-    repeat16_incr(expr_jump)
-#undef expr_jump
+obj_end:
+#if YYJSON_READER_DEPTH_LIMIT
+    container_depth--;
+#endif
+    /* pop container */
+    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
+    /* point to the next value */
+    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
+    ctn->tag = (ctn_len << (YYJSON_TAG_BIT - 1)) | YYJSON_TYPE_OBJ;
+    if (unlikely(ctn == ctn_parent)) goto doc_end;
+    ctn = ctn_parent;
+    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
+    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
+        goto obj_val_end;
+    } else {
+        goto arr_val_end;
+    }
 
-copy_utf8:
-    while (*src >= 0x80) { /* non-ASCII character */
-        if (has_allow(EXT_WHITESPACE)) {
-            if (char_is_space_ext(*src) && ext_space_len(src)) {
-                return_suc(dst, src);
+doc_end:
+    /* check invalid contents after json document */
+    if (unlikely(cur < eof) && !has_flg(STOP_WHEN_DONE)) {
+        while (char_is_space(*cur)) cur++;
+        if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+            if (!skip_trivia(&cur, eof, flg) && cur == eof) {
+                goto fail_comment;
             }
         }
-        uni = byte_load_4(src);
-        if (is_utf8_seq2(uni)) {
-            byte_copy_2(dst, &uni);
-            dst += 2; src += 2;
-        } else if (is_utf8_seq3(uni)) {
-            byte_copy_4(dst, &uni);
-            dst += 3; src += 3;
-        } else if (is_utf8_seq4(uni)) {
-            byte_copy_4(dst, &uni);
-            dst += 4; src += 4;
-        } else {
-#if !YYJSON_DISABLE_UTF8_VALIDATION
-            if (!has_allow(INVALID_UNICODE)) return_err(src, MSG_ERR_UTF8);
-#endif
-            *dst = *src;
-            dst += 1; src += 1;
-        }
+        if (unlikely(cur < eof)) goto fail_garbage;
     }
-    if (char_is_id_ascii(*src)) goto copy_ascii;
-    goto copy_escape;
-
-#undef return_err
-#undef return_suc
-}
 
+    **pre = '\0';
+    doc = (yyjson_doc *)val_hdr;
+    doc->root = val_hdr + hdr_len;
+    doc->alc = alc;
+    doc->dat_read = (usize)(cur - hdr);
+    doc->val_read = (usize)((val - doc->root) + 1);
+    doc->str_pool = has_flg(INSITU) ? NULL : (char *)hdr;
+    memset(&doc->ext, 0, sizeof(yyjson_doc_ext));
+    doc->ext.stats.val_alloc = alc_ini - hdr_len;
+    doc->ext.stats.val_cap = alc_len - hdr_len;
+    doc->ext.stats.realloc_count = val_grow;
+    return doc;
 
+fail_string:            return_err(cur, INVALID_STRING, msg);
+fail_number:            return_err(cur, INVALID_NUMBER, msg);
+fail_alloc:             return_err(cur, MEMORY_ALLOCATION, MSG_MALLOC);
+fail_trailing_comma:    return_err(cur, JSON_STRUCTURE, MSG_COMMA);
+fail_literal_true:      return_err(cur, LITERAL, MSG_CHAR_T);
+fail_literal_false:     return_err(cur, LITERAL, MSG_CHAR_F);
+fail_literal_null:      return_err(cur, LITERAL, MSG_CHAR_N);
+fail_character_val:     return_err(cur, UNEXPECTED_CHARACTER, MSG_CHAR);
+fail_character_arr_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_ARR_END);
+fail_character_obj_key: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_KEY);
+fail_character_obj_sep: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_SEP);
+fail_character_obj_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_END);
+fail_comment:           return_err(cur, INVALID_COMMENT, MSG_COMMENT);
+fail_garbage:           return_err(cur, UNEXPECTED_CONTENT, MSG_GARBAGE);
+fail_depth:             return_err(cur, DEPTH, MSG_DEPTH);
 
-/*==============================================================================
- * MARK: - JSON Reader Implementation (Private)
- *
- * We use goto statements to build the finite state machine (FSM).
- * The FSM's state was held by program counter (PC) and the 'goto' make the
- * state transitions.
- *============================================================================*/
+#undef val_incr
+#undef return_err
+}
 
-/** Read single value JSON document. */
-static_noinline yyjson_doc *read_root_single(u8 *hdr, u8 *cur, u8 *eof,
-                                             yyjson_alc alc,
-                                             yyjson_read_flag flg,
-                                             yyjson_read_err *err) {
+/** Read JSON document (accept all style, but optimized for pretty). */
+static_inline yyjson_doc *read_root_pretty(u8 *hdr, u8 *cur, u8 *eof,
+                                           yyjson_alc alc,
+                                           yyjson_read_flag flg,
+                                           yyjson_read_err *err,
+                                           usize val_num,
+                                           copy_pool *pool) {
 #define return_err(_pos, _code, _msg) do { \
     if (is_truncated_end(hdr, _pos, eof, YYJSON_READ_ERROR_##_code, flg)) { \
         err->pos = (usize)(eof - hdr); \
@@ -5255,60 +7934,446 @@ static_noinline yyjson_doc *read_root_single(u8 *hdr, u8 *cur, u8 *eof,
         err->code = YYJSON_READ_ERROR_##_code; \
         err->msg = _msg; \
     } \
-    if (val_hdr) alc.free(alc.ctx, val_hdr); \
-    return NULL; \
+    if (val_hdr) alc.free(alc.ctx, val_hdr); \
+    return NULL; \
+} while (false)
+
+#define val_incr() do { \
+    val++; \
+    if (unlikely(val >= val_end)) { \
+        usize alc_old = alc_len; \
+        usize val_ofs = (usize)(val - val_hdr); \
+        usize ctn_ofs = (usize)(ctn - val_hdr); \
+        alc_len += alc_len / 2; \
+        if ((sizeof(usize) < 8) && (alc_len >= alc_max)) goto fail_alloc; \
+        val_tmp = (yyjson_val *)alc.realloc(alc.ctx, (void *)val_hdr, \
+            alc_old * sizeof(yyjson_val), \
+            alc_len * sizeof(yyjson_val)); \
+        if ((!val_tmp)) goto fail_alloc; \
+        val_grow++; \
+        val = val_tmp + val_ofs; \
+        ctn = val_tmp + ctn_ofs; \
+        val_hdr = val_tmp; \
+        val_end = val_tmp + (alc_len - 2); \
+    } \
 } while (false)
 
-    usize hdr_len; /* value count used by doc */
-    usize alc_num; /* value count capacity */
+    usize dat_len; /* data length in bytes, hint for allocator */
+    usize hdr_len; /* value count used by yyjson_doc */
+    usize alc_len; /* value count allocated */
+    usize alc_ini; /* value count allocated before reading */
+    usize alc_max; /* maximum value count for allocator */
+    usize val_grow = 0; /* the number of times the values are reallocated */
+    usize ctn_len; /* the number of elements in current container */
     yyjson_val *val_hdr; /* the head of allocated values */
-    yyjson_val *val; /* current value */
+    yyjson_val *val_end; /* the end of allocated values */
+    yyjson_val *val_tmp; /* temporary pointer for realloc */
+    yyjson_val *val; /* current JSON value */
+    yyjson_val *ctn; /* current container */
+    yyjson_val *ctn_parent; /* parent of current container */
     yyjson_doc *doc; /* the JSON document, equals to val_hdr */
     const char *msg; /* error message */
 
     u8 raw_end[1]; /* raw end for null-terminator */
     u8 *raw_ptr = raw_end;
     u8 **pre = &raw_ptr; /* previous raw end pointer */
+#if YYJSON_READER_DEPTH_LIMIT
+    u32 container_depth = 0; /* current array/object depth */
+#endif
 
+    dat_len = has_flg(STOP_WHEN_DONE) ? 256 : (usize)(eof - cur);
     hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
     hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
-    alc_num = hdr_len + 1; /* single value */
+    alc_max = USIZE_MAX / sizeof(yyjson_val);
+    if (val_num) {
+        alc_len = hdr_len + val_num + 2; /* padding for key-value pair */
+    } else {
+        alc_len = hdr_len +
+                  (dat_len / YYJSON_READER_ESTIMATED_PRETTY_RATIO) + 4;
+    }
+    alc_len = yyjson_min(alc_len, alc_max);
+    alc_ini = alc_len;
+
+    val_hdr = (yyjson_val *)alc.malloc(alc.ctx, alc_len * sizeof(yyjson_val));
+    if (unlikely(!val_hdr)) goto fail_alloc;
+    val_end = val_hdr + (alc_len - 2); /* padding for key-value pair reading */
+    val = val_hdr + hdr_len;
+    ctn = val;
+    ctn_len = 0;
+
+    if (*cur++ == '{') {
+        ctn->tag = YYJSON_TYPE_OBJ;
+        ctn->uni.ofs = 0;
+        if (*cur == '\n') cur++;
+        goto obj_key_begin;
+    } else {
+        ctn->tag = YYJSON_TYPE_ARR;
+        ctn->uni.ofs = 0;
+        if (*cur == '\n') cur++;
+        goto arr_val_begin;
+    }
+
+arr_begin:
+#if YYJSON_READER_DEPTH_LIMIT
+    container_depth++;
+    if (unlikely(container_depth >= YYJSON_READER_DEPTH_LIMIT)) {
+        goto fail_depth;
+    }
+#endif
+
+    /* save current container */
+    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
+               (ctn->tag & YYJSON_TAG_MASK);
+
+    /* create a new array value, save parent container offset */
+    val_incr();
+    val->tag = YYJSON_TYPE_ARR;
+    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
+
+    /* push the new array value as current container */
+    ctn = val;
+    ctn_len = 0;
+    if (*cur == '\n') cur++;
+
+arr_val_begin:
+#if YYJSON_HAS_SIMD
+    do {
+        repeat16({
+            if (likely(byte_match_2(cur, "  "))) cur += 2;
+            else break;
+        })
+        /* long indentation or other whitespace, skip in blocks */
+        cur = skip_space(cur, eof);
+    } while (false);
+#elif YYJSON_IS_REAL_GCC
+    while (true) repeat16({
+        if (byte_match_2(cur, "  ")) cur += 2;
+        else break;
+    })
+#else
+    while (true) repeat16({
+        if (likely(byte_match_2(cur, "  "))) cur += 2;
+        else break;
+    })
+#endif
+
+    if (*cur == '{') {
+        cur++;
+        goto obj_begin;
+    }
+    if (*cur == '[') {
+        cur++;
+        goto arr_begin;
+    }
+    if (char_is_num(*cur)) {
+        val_incr();
+        ctn_len++;
+        if (likely(read_num(&cur, eof, pre, flg, val, &msg))) goto arr_val_end;
+        goto fail_number;
+    }
+    if (*cur == '"') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_str(&cur, eof, flg, val, &msg, pool))) goto arr_val_end;
+        goto fail_string;
+    }
+    if (*cur == 't') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_true(&cur, val))) goto arr_val_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_false(&cur, val))) goto arr_val_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_null(&cur, val))) goto arr_val_end;
+        if (has_allow(INF_AND_NAN)) {
+            if (read_nan(&cur, pre, flg, val)) goto arr_val_end;
+        }
+        goto fail_literal_null;
+    }
+    if (*cur == ']') {
+        cur++;
+        if (likely(ctn_len == 0)) goto arr_end;
+        if (has_allow(TRAILING_COMMAS)) goto arr_end;
+        do { cur--; } while (*cur != ',');
+        goto fail_trailing_comma;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_space(cur + 1, eof);
+        goto arr_val_begin;
+    }
+    if (has_allow(INF_AND_NAN) &&
+        (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
+        val_incr();
+        ctn_len++;
+        if (read_inf_or_nan(&cur, pre, flg, val)) goto arr_val_end;
+        goto fail_character_val;
+    }
+    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_str_sq(&cur, eof, flg, val, &msg, pool))) goto arr_val_end;
+        goto fail_string;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto arr_val_begin;
+        if (cur == eof) goto fail_comment;
+    }
+    goto fail_character_val;
+
+arr_val_end:
+    if (byte_match_2(cur, ",\n")) {
+        cur += 2;
+        goto arr_val_begin;
+    }
+    if (*cur == ',') {
+        cur++;
+        goto arr_val_begin;
+    }
+    if (*cur == ']') {
+        cur++;
+        goto arr_end;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_space(cur + 1, eof);
+        goto arr_val_end;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto arr_val_end;
+        if (cur == eof) goto fail_comment;
+    }
+    goto fail_character_arr_end;
+
+arr_end:
+#if YYJSON_READER_DEPTH_LIMIT
+    container_depth--;
+#endif
+    /* get parent container */
+    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
+
+    /* save the next sibling value offset */
+    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
+    ctn->tag = ((ctn_len) << YYJSON_TAG_BIT) | YYJSON_TYPE_ARR;
+    if (unlikely(ctn == ctn_parent)) goto doc_end;
+
+    /* pop parent as current container */
+    ctn = ctn_parent;
+    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
+    if (*cur == '\n') cur++;
+    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
+        goto obj_val_end;
+    } else {
+        goto arr_val_end;
+    }
+
+obj_begin:
+#if YYJSON_READER_DEPTH_LIMIT
+    container_depth++;
+    if (unlikely(container_depth >= YYJSON_READER_DEPTH_LIMIT)) {
+        goto fail_depth;
+    }
+#endif
+
+    /* push container */
+    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
+               (ctn->tag & YYJSON_TAG_MASK);
+    val_incr();
+    val->tag = YYJSON_TYPE_OBJ;
+    /* offset to the parent */
+    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
+    ctn = val;
+    ctn_len = 0;
+    if (*cur == '\n') cur++;
+
+obj_key_begin:
+#if YYJSON_HAS_SIMD
+    do {
+        repeat16({
+            if (likely(byte_match_2(cur, "  "))) cur += 2;
+            else break;
+        })
+        /* long indentation or other whitespace, skip in blocks */
+        cur = skip_space(cur, eof);
+    } while (false);
+#elif YYJSON_IS_REAL_GCC
+    while (true) repeat16({
+        if (byte_match_2(cur, "  ")) cur += 2;
+        else break;
+    })
+#else
+    while (true) repeat16({
+        if (likely(byte_match_2(cur, "  "))) cur += 2;
+        else break;
+    })
+#endif
+    if (likely(*cur == '"')) {
+        val_incr();
+        ctn_len++;
+        if (likely(read_str(&cur, eof, flg, val, &msg, pool))) goto obj_key_end;
+        goto fail_string;
+    }
+    if (likely(*cur == '}')) {
+        cur++;
+        if (likely(ctn_len == 0)) goto obj_end;
+        if (has_allow(TRAILING_COMMAS)) goto obj_end;
+        do { cur--; } while (*cur != ',');
+        goto fail_trailing_comma;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_space(cur + 1, eof);
+        goto obj_key_begin;
+    }
+    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_str_sq(&cur, eof, flg, val, &msg, pool))) goto obj_key_end;
+        goto fail_string;
+    }
+    if (has_allow(UNQUOTED_KEY) && char_is_id_start(*cur)) {
+        val_incr();
+        ctn_len++;
+        if (read_str_id(&cur, eof, flg, pre, val, &msg)) goto obj_key_end;
+        goto fail_string;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto obj_key_begin;
+        if (cur == eof) goto fail_comment;
+    }
+    goto fail_character_obj_key;
 
-    val_hdr = (yyjson_val *)alc.malloc(alc.ctx, alc_num * sizeof(yyjson_val));
-    if (unlikely(!val_hdr)) goto fail_alloc;
-    val = val_hdr + hdr_len;
+obj_key_end:
+    if (byte_match_2(cur, ": ")) {
+        cur += 2;
+        goto obj_val_begin;
+    }
+    if (*cur == ':') {
+        cur++;
+        goto obj_val_begin;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_space(cur + 1, eof);
+        goto obj_key_end;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto obj_key_end;
+        if (cur == eof) goto fail_comment;
+    }
+    goto fail_character_obj_sep;
 
+obj_val_begin:
+    if (*cur == '"') {
+        val++;
+        ctn_len++;
+        if (likely(read_str(&cur, eof, flg, val, &msg, pool))) goto obj_val_end;
+        goto fail_string;
+    }
     if (char_is_num(*cur)) {
-        if (likely(read_num(&cur, pre, flg, val, &msg))) goto doc_end;
+        val++;
+        ctn_len++;
+        if (likely(read_num(&cur, eof, pre, flg, val, &msg))) goto obj_val_end;
         goto fail_number;
     }
-    if (*cur == '"') {
-        if (likely(read_str(&cur, eof, flg, val, &msg))) goto doc_end;
-        goto fail_string;
+    if (*cur == '{') {
+        cur++;
+        goto obj_begin;
+    }
+    if (*cur == '[') {
+        cur++;
+        goto arr_begin;
     }
     if (*cur == 't') {
-        if (likely(read_true(&cur, val))) goto doc_end;
+        val++;
+        ctn_len++;
+        if (likely(read_true(&cur, val))) goto obj_val_end;
         goto fail_literal_true;
     }
     if (*cur == 'f') {
-        if (likely(read_false(&cur, val))) goto doc_end;
+        val++;
+        ctn_len++;
+        if (likely(read_false(&cur, val))) goto obj_val_end;
         goto fail_literal_false;
     }
     if (*cur == 'n') {
-        if (likely(read_null(&cur, val))) goto doc_end;
+        val++;
+        ctn_len++;
+        if (likely(read_null(&cur, val))) goto obj_val_end;
         if (has_allow(INF_AND_NAN)) {
-            if (read_nan(&cur, pre, flg, val)) goto doc_end;
+            if (read_nan(&cur, pre, flg, val)) goto obj_val_end;
         }
         goto fail_literal_null;
     }
-    if (has_allow(INF_AND_NAN)) {
-        if (read_inf_or_nan(&cur, pre, flg, val)) goto doc_end;
+    if (char_is_space(*cur)) {
+        cur = skip_space(cur + 1, eof);
+        goto obj_val_begin;
+    }
+    if (has_allow(INF_AND_NAN) &&
+        (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
+        val++;
+        ctn_len++;
+        if (read_inf_or_nan(&cur, pre, flg, val)) goto obj_val_end;
+        goto fail_character_val;
     }
     if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
-        if (likely(read_str_sq(&cur, eof, flg, val, &msg))) goto doc_end;
+        val++;
+        ctn_len++;
+        if (likely(read_str_sq(&cur, eof, flg, val, &msg, pool))) goto obj_val_end;
         goto fail_string;
     }
-    goto fail_character;
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto obj_val_begin;
+        if (cur == eof) goto fail_comment;
+    }
+    goto fail_character_val;
+
+obj_val_end:
+    if (byte_match_2(cur, ",\n")) {
+        cur += 2;
+        goto obj_key_begin;
+    }
+    if (likely(*cur == ',')) {
+        cur++;
+        goto obj_key_begin;
+    }
+    if (likely(*cur == '}')) {
+        cur++;
+        goto obj_end;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_space(cur + 1, eof);
+        goto obj_val_end;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto obj_val_end;
+        if (cur == eof) goto fail_comment;
+    }
+    goto fail_character_obj_end;
+
+obj_end:
+#if YYJSON_READER_DEPTH_LIMIT
+    container_depth--;
+#endif
+
+    /* pop container */
+    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
+    /* point to the next value */
+    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
+    ctn->tag = (ctn_len << (YYJSON_TAG_BIT - 1)) | YYJSON_TYPE_OBJ;
+    if (unlikely(ctn == ctn_parent)) goto doc_end;
+    ctn = ctn_parent;
+    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
+    if (*cur == '\n') cur++;
+    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
+        goto obj_val_end;
+    } else {
+        goto arr_val_end;
+    }
 
 doc_end:
     /* check invalid contents after json document */
@@ -5327,29 +8392,359 @@ doc_end:
     doc->root = val_hdr + hdr_len;
     doc->alc = alc;
     doc->dat_read = (usize)(cur - hdr);
-    doc->val_read = 1;
+    doc->val_read = (usize)((val - doc->root) + 1);
     doc->str_pool = has_flg(INSITU) ? NULL : (char *)hdr;
+    memset(&doc->ext, 0, sizeof(yyjson_doc_ext));
+    doc->ext.stats.val_alloc = alc_ini - hdr_len;
+    doc->ext.stats.val_cap = alc_len - hdr_len;
+    doc->ext.stats.realloc_count = val_grow;
     return doc;
 
-fail_string:        return_err(cur, INVALID_STRING, msg);
-fail_number:        return_err(cur, INVALID_NUMBER, msg);
-fail_alloc:         return_err(cur, MEMORY_ALLOCATION, MSG_MALLOC);
-fail_literal_true:  return_err(cur, LITERAL, MSG_CHAR_T);
-fail_literal_false: return_err(cur, LITERAL, MSG_CHAR_F);
-fail_literal_null:  return_err(cur, LITERAL, MSG_CHAR_N);
-fail_character:     return_err(cur, UNEXPECTED_CHARACTER, MSG_CHAR);
-fail_comment:       return_err(cur, INVALID_COMMENT, MSG_COMMENT);
-fail_garbage:       return_err(cur, UNEXPECTED_CONTENT, MSG_GARBAGE);
-fail_depth:         return_err(cur, DEPTH, MSG_DEPTH);
+fail_string:            return_err(cur, INVALID_STRING, msg);
+fail_number:            return_err(cur, INVALID_NUMBER, msg);
+fail_alloc:             return_err(cur, MEMORY_ALLOCATION, MSG_MALLOC);
+fail_trailing_comma:    return_err(cur, JSON_STRUCTURE, MSG_COMMA);
+fail_literal_true:      return_err(cur, LITERAL, MSG_CHAR_T);
+fail_literal_false:     return_err(cur, LITERAL, MSG_CHAR_F);
+fail_literal_null:      return_err(cur, LITERAL, MSG_CHAR_N);
+fail_character_val:     return_err(cur, UNEXPECTED_CHARACTER, MSG_CHAR);
+fail_character_arr_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_ARR_END);
+fail_character_obj_key: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_KEY);
+fail_character_obj_sep: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_SEP);
+fail_character_obj_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_END);
+fail_comment:           return_err(cur, INVALID_COMMENT, MSG_COMMENT);
+fail_garbage:           return_err(cur, UNEXPECTED_CONTENT, MSG_GARBAGE);
+fail_depth:             return_err(cur, DEPTH, MSG_DEPTH);
 
+#undef val_incr
 #undef return_err
 }
 
-/** Read JSON document (accept all style, but optimized for minify). */
-static_inline yyjson_doc *read_root_minify(u8 *hdr, u8 *cur, u8 *eof,
-                                           yyjson_alc alc,
-                                           yyjson_read_flag flg,
-                                           yyjson_read_err *err) {
+
+
+/*==============================================================================
+ * MARK: - JSON Reader Structural Index (Private)
+ *
+ * An alternative two-stage reader, enabled by `YYJSON_READ_STRUCTURAL_INDEX`.
+ *
+ * Stage 1 scans the input in 64-byte blocks, classifies the bytes with SIMD
+ * (if available) and resolves the escaped quotes and the string regions with
+ * bit operations. The position of each token is stored in an array of `u32`:
+ *  - the structural characters `{}[]:,` outside strings;
+ *  - the opening and closing quotes of strings;
+ *  - the first byte of each run of other characters outside strings, such as
+ *    numbers, literals or invalid characters;
+ *  - the first byte of each run of backslash, control or non-ASCII characters
+ *    inside strings, these strings need to be unescaped or validated.
+ *
+ * Stage 2 is the same state machine as `read_root_minify()`, but it jumps from
+ * token to token instead of skipping whitespace, and takes the length of the
+ * strings that need no unescaping or validation from the index. The document
+ * and the error information are the same as the default reader.
+ *============================================================================*/
+
+/** Character class bitmaps of a 64-byte block, bit `i` for the byte `i`. */
+typedef struct idx_block {
+    u64 quote; /* '"' */
+    u64 bs; /* '\\' */
+    u64 space; /* ' ', '\t', '\n', '\r' */
+    u64 op; /* '{', '}', '[', ']', ':', ',' */
+    u64 open; /* '{', '[' */
+    u64 ctrl; /* control character [0x00-0x1F] or non-ASCII [0x80-0xFF] */
+} idx_block;
+
+#if YYJSON_HAS_NEON
+/** Packs four 16-byte comparison results into a 64-bit mask. */
+static_inline u64 idx_neon_mask(uint8x16_t m0, uint8x16_t m1,
+                                uint8x16_t m2, uint8x16_t m3) {
+    static const u8 bits[16] = {
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+    };
+    uint8x16_t b = vld1q_u8(bits);
+    uint8x16_t s0 = vpaddq_u8(vandq_u8(m0, b), vandq_u8(m1, b));
+    uint8x16_t s1 = vpaddq_u8(vandq_u8(m2, b), vandq_u8(m3, b));
+    s0 = vpaddq_u8(s0, s1);
+    s0 = vpaddq_u8(s0, s0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(s0), 0);
+}
+#endif
+
+/** Classifies the 64 bytes at `src`. */
+static_inline void idx_classify(const u8 *src, idx_block *blk) {
+#if YYJSON_HAS_AVX2
+    /*
+     Table lookup with the low 4 bits of each byte (0 if the high bit is set).
+     A whitespace equals its table entry. An operator OR 0x20 equals its table
+     entry, '[' and ']' become '{' and '}'. This also matches 0x0C and 0x1A as
+     operators, they are invalid outside strings and are tested as control
+     characters inside strings, the error position is the same.
+     */
+    const __m256i space_tab = _mm256_setr_epi8(
+        ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100, '\r',
+        100, 100,
+        ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100, '\r',
+        100, 100);
+    const __m256i op_tab = _mm256_setr_epi8(
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0);
+    usize i;
+    blk->quote = blk->bs = blk->space = blk->op = blk->open = blk->ctrl = 0;
+    for (i = 0; i < 64; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(const void *)(src + i));
+        __m256i b = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i q = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'));
+        __m256i e = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'));
+        __m256i s = _mm256_cmpeq_epi8(v, _mm256_shuffle_epi8(space_tab, v));
+        __m256i o = _mm256_cmpeq_epi8(b, _mm256_shuffle_epi8(op_tab, v));
+        __m256i p = _mm256_cmpeq_epi8(b, _mm256_set1_epi8('{'));
+        /* signed compare: [0x00-0x1F] and [0x80-0xFF] are less than 0x20 */
+        __m256i c = _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v);
+        blk->quote |= (u64)(u32)_mm256_movemask_epi8(q) << i;
+        blk->bs |= (u64)(u32)_mm256_movemask_epi8(e) << i;
+        blk->space |= (u64)(u32)_mm256_movemask_epi8(s) << i;
+        blk->op |= (u64)(u32)_mm256_movemask_epi8(o) << i;
+        blk->open |= (u64)(u32)_mm256_movemask_epi8(p) << i;
+        blk->ctrl |= (u64)(u32)_mm256_movemask_epi8(c) << i;
+    }
+#elif YYJSON_HAS_SSE2
+    usize i;
+    blk->quote = blk->bs = blk->space = blk->op = blk->open = blk->ctrl = 0;
+    for (i = 0; i < 64; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(src + i));
+        /* '[' and ']' become '{' and '}' */
+        __m128i b = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i q = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+        __m128i e = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+        __m128i s = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        __m128i p = _mm_cmpeq_epi8(b, _mm_set1_epi8('{'));
+        __m128i o = _mm_or_si128(
+            _mm_or_si128(p, _mm_cmpeq_epi8(b, _mm_set1_epi8('}'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+        /* signed compare: [0x00-0x1F] and [0x80-0xFF] are less than 0x20 */
+        __m128i c = _mm_cmplt_epi8(v, _mm_set1_epi8(0x20));
+        blk->quote |= (u64)(u32)_mm_movemask_epi8(q) << i;
+        blk->bs |= (u64)(u32)_mm_movemask_epi8(e) << i;
+        blk->space |= (u64)(u32)_mm_movemask_epi8(s) << i;
+        blk->op |= (u64)(u32)_mm_movemask_epi8(o) << i;
+        blk->open |= (u64)(u32)_mm_movemask_epi8(p) << i;
+        blk->ctrl |= (u64)(u32)_mm_movemask_epi8(c) << i;
+    }
+#elif YYJSON_HAS_NEON
+    uint8x16_t v[4], q[4], e[4], s[4], o[4], p[4], c[4];
+    usize i;
+    for (i = 0; i < 4; i++) {
+        uint8x16_t b;
+        v[i] = vld1q_u8(src + i * 16);
+        /* '[' and ']' become '{' and '}' */
+        b = vorrq_u8(v[i], vdupq_n_u8(0x20));
+        q[i] = vceqq_u8(v[i], vdupq_n_u8('"'));
+        e[i] = vceqq_u8(v[i], vdupq_n_u8('\\'));
+        s[i] = vorrq_u8(
+            vorrq_u8(vceqq_u8(v[i], vdupq_n_u8(' ')),
+                     vceqq_u8(v[i], vdupq_n_u8('\t'))),
+            vorrq_u8(vceqq_u8(v[i], vdupq_n_u8('\n')),
+                     vceqq_u8(v[i], vdupq_n_u8('\r'))));
+        p[i] = vceqq_u8(b, vdupq_n_u8('{'));
+        o[i] = vorrq_u8(
+            vorrq_u8(p[i], vceqq_u8(b, vdupq_n_u8('}'))),
+            vorrq_u8(vceqq_u8(v[i], vdupq_n_u8(':')),
+                     vceqq_u8(v[i], vdupq_n_u8(','))));
+        c[i] = vorrq_u8(vcltq_u8(v[i], vdupq_n_u8(0x20)),
+                        vcgeq_u8(v[i], vdupq_n_u8(0x80)));
+    }
+    blk->quote = idx_neon_mask(q[0], q[1], q[2], q[3]);
+    blk->bs = idx_neon_mask(e[0], e[1], e[2], e[3]);
+    blk->space = idx_neon_mask(s[0], s[1], s[2], s[3]);
+    blk->op = idx_neon_mask(o[0], o[1], o[2], o[3]);
+    blk->open = idx_neon_mask(p[0], p[1], p[2], p[3]);
+    blk->ctrl = idx_neon_mask(c[0], c[1], c[2], c[3]);
+#else
+    usize i;
+    blk->quote = blk->bs = blk->space = blk->op = blk->open = blk->ctrl = 0;
+    for (i = 0; i < 64; i++) {
+        u8 c = src[i];
+        u64 bit = (u64)1 << i;
+        if (c == '"') blk->quote |= bit;
+        if (c == '\\') blk->bs |= bit;
+        if (char_is_space(c)) blk->space |= bit;
+        if (c == '{' || c == '}' || c == '[' || c == ']' ||
+            c == ':' || c == ',') blk->op |= bit;
+        if (c == '{' || c == '[') blk->open |= bit;
+        if (c < 0x20 || c >= 0x80) blk->ctrl |= bit;
+    }
+#endif
+}
+
+/** Returns the bits preceded by an odd number of backslashes. */
+static_inline u64 idx_escaped(u64 bs, u64 *carry) {
+    const u64 odd = U64(0xAAAAAAAA, 0xAAAAAAAA);
+    u64 potential = bs & ~*carry;
+    u64 code = (((potential << 1) | odd) - potential) ^ odd;
+    u64 escaped = code ^ (bs | *carry);
+    *carry = (code & bs) >> 63;
+    return escaped;
+}
+
+/** Returns the prefix XOR of the bits: bit `i` is the XOR of bits [0, i]. */
+static_inline u64 idx_prefix_xor(u64 v) {
+    v ^= v << 1;
+    v ^= v << 2;
+    v ^= v << 4;
+    v ^= v << 8;
+    v ^= v << 16;
+    v ^= v << 32;
+    return v;
+}
+
+/**
+ Builds the structural index of the JSON data `[cur, eof)` (stage 1).
+ The offsets are relative to `hdr`, the index is terminated by two `eof`
+ offsets. The index is allocated once with the max token count, the pages
+ that are not used may not be committed by the system.
+ The value count is written to `val_num`, see `idx_count()`.
+ Returns NULL if memory allocation failed.
+ */
+static_noinline u32 *idx_build(u8 *hdr, u8 *cur, u8 *eof, yyjson_alc alc,
+                               usize *val_num) {
+    u8 buf[64]; /* zero-padded tail block */
+    idx_block blk;
+    u64 esc_carry = 0; /* the first byte of the block is escaped */
+    u64 str_carry = 0; /* the block begins inside a string (all bits set) */
+    u64 run_carry = 0; /* the block begins inside a run of other characters */
+    u64 spc_carry = 0; /* the block begins inside a run of special string
+                          characters */
+    usize ofs, end = (usize)(eof - hdr);
+    usize idx_len = 0;
+    usize num = 0;
+    /* at most one token per byte, with 2 terminators and 3 extra entries */
+    usize idx_cap = (usize)(eof - cur) + 2 + 3;
+    u32 *idx;
+
+    if (unlikely(idx_cap > USIZE_MAX / sizeof(u32))) return NULL;
+    idx = (u32 *)alc.malloc(alc.ctx, idx_cap * sizeof(u32));
+    if (unlikely(!idx)) return NULL;
+
+    for (ofs = (usize)(cur - hdr); ofs < end; ofs += 64) {
+        const u8 *src = hdr + ofs;
+        u64 valid = ~(u64)0;
+        u64 quote, instr, outside, run, beg, spc, tok;
+
+        if (unlikely(end - ofs < 64)) {
+            usize n = end - ofs;
+            memset(buf, 0, sizeof(buf));
+            memcpy(buf, src, n);
+            src = buf;
+            valid = ((u64)1 << n) - 1;
+        }
+        idx_classify(src, &blk);
+
+        /* real quotes, and the string regions with the opening quotes */
+        quote = blk.quote & ~idx_escaped(blk.bs, &esc_carry);
+        instr = idx_prefix_xor(quote) ^ str_carry;
+        str_carry = (u64)0 - (instr >> 63);
+        outside = ~(instr | quote);
+
+        /* the first byte of each run */
+        run = ~(blk.op | blk.space) & outside;
+        beg = run & ~((run << 1) | run_carry);
+        spc = (blk.bs | blk.ctrl) & instr;
+        tok = (blk.op & outside) | quote | beg |
+              (spc & ~((spc << 1) | spc_carry));
+        run_carry = run >> 63;
+        spc_carry = spc >> 63;
+        tok &= valid;
+        num += u64_pop_bits(((quote & instr) | beg | (blk.open & outside)) &
+                            valid);
+
+        if (tok) {
+            /* write 4 tokens at a time, the extra entries are overwritten */
+            u32 *out = idx + idx_len;
+            u64 hi = (u64)1 << 63; /* avoid ctz(0) for the extra entries */
+            idx_len += u64_pop_bits(tok);
+            do {
+                out[0] = (u32)ofs + u64_tz_bits(tok);
+                tok &= tok - 1;
+                out[1] = (u32)ofs + u64_tz_bits(tok | hi);
+                tok &= tok - 1;
+                out[2] = (u32)ofs + u64_tz_bits(tok | hi);
+                tok &= tok - 1;
+                out[3] = (u32)ofs + u64_tz_bits(tok | hi);
+                tok &= tok - 1;
+                out += 4;
+            } while (tok);
+        }
+    }
+    idx[idx_len++] = (u32)end;
+    idx[idx_len++] = (u32)end;
+    *val_num = yyjson_min(num, (usize)(eof - cur) / 2 + 1);
+    return idx;
+}
+
+/**
+ Counts the values of the JSON data `[cur, eof)` with the same classification
+ as `idx_build()`, used to allocate the values before reading. Each value
+ begins with an opening quote, an opening bracket, or a run of other
+ characters outside strings (numbers and literals). The count is exact for
+ standard JSON, it may be larger with comments or unquoted strings, and
+ smaller if a quote is not a string delimiter (e.g. in comments). The count is
+ limited to the max value count of valid JSON, which is `len / 2 + 1`.
+ */
+static_noinline usize idx_count(const u8 *cur, const u8 *eof) {
+    u8 buf[64]; /* zero-padded tail block */
+    idx_block blk;
+    u64 esc_carry = 0; /* the first byte of the block is escaped */
+    u64 str_carry = 0; /* the block begins inside a string (all bits set) */
+    u64 run_carry = 0; /* the block begins inside a run of other characters */
+    usize ofs, end = (usize)(eof - cur);
+    usize num = 0;
+
+    for (ofs = 0; ofs < end; ofs += 64) {
+        const u8 *src = cur + ofs;
+        u64 valid = ~(u64)0;
+        u64 quote, instr, outside, run, beg;
+
+        if (unlikely(end - ofs < 64)) {
+            usize n = end - ofs;
+            memset(buf, 0, sizeof(buf));
+            memcpy(buf, src, n);
+            src = buf;
+            valid = ((u64)1 << n) - 1;
+        }
+        idx_classify(src, &blk);
+
+        quote = blk.quote & ~idx_escaped(blk.bs, &esc_carry);
+        instr = idx_prefix_xor(quote) ^ str_carry;
+        str_carry = (u64)0 - (instr >> 63);
+        outside = ~(instr | quote);
+        run = ~(blk.op | blk.space) & outside;
+        beg = run & ~((run << 1) | run_carry);
+        run_carry = run >> 63;
+        num += u64_pop_bits(((quote & instr) | beg | (blk.open & outside)) &
+                            valid);
+    }
+    return yyjson_min(num, end / 2 + 1);
+}
+
+/** Returns whether the structural index reader supports the input. */
+static_inline bool idx_read_enabled(yyjson_read_flag flg, usize len) {
+    if (!has_flg(STRUCTURAL_INDEX) || has_flg(STOP_WHEN_DONE)) return false;
+    if (has_allow(TRIVIA) || has_allow(SINGLE_QUOTED_STR) ||
+        has_allow(UNQUOTED_KEY)) return false;
+    /* the offsets are stored as u32 */
+    return (u64)len < (u64)0xFFFFFFFFu;
+}
+
+/** Read JSON document with the structural index (stage 2). */
+static_noinline yyjson_doc *read_root_index(u8 *hdr, u8 *cur, u8 *eof,
+                                            yyjson_alc alc,
+                                            yyjson_read_flag flg,
+                                            yyjson_read_err *err) {
 #define return_err(_pos, _code, _msg) do { \
     if (is_truncated_end(hdr, _pos, eof, YYJSON_READ_ERROR_##_code, flg)) { \
         err->pos = (usize)(eof - hdr); \
@@ -5361,6 +8756,7 @@ static_inline yyjson_doc *read_root_minify(u8 *hdr, u8 *cur, u8 *eof,
         err->msg = _msg; \
     } \
     if (val_hdr) alc.free(alc.ctx, val_hdr); \
+    if (idx_hdr) alc.free(alc.ctx, idx_hdr); \
     return NULL; \
 } while (false)
 
@@ -5376,6 +8772,7 @@ static_inline yyjson_doc *read_root_minify(u8 *hdr, u8 *cur, u8 *eof,
             alc_old * sizeof(yyjson_val), \
             alc_len * sizeof(yyjson_val)); \
         if ((!val_tmp)) goto fail_alloc; \
+        val_grow++; \
         val = val_tmp + val_ofs; \
         ctn = val_tmp + ctn_ofs; \
         val_hdr = val_tmp; \
@@ -5383,12 +8780,49 @@ static_inline yyjson_doc *read_root_minify(u8 *hdr, u8 *cur, u8 *eof,
     } \
 } while (false)
 
+/* Move to the next token, the bytes before it are all whitespace. */
+#define idx_next() do { \
+    cur = hdr + *idx++; \
+} while (false)
+
+/* Move to the next token after a value, or fail with `_fail` if there are
+   other characters before it. */
+#define idx_next_after(_fail) do { \
+    if (unlikely(cur != hdr + *idx)) { \
+        if (!char_is_space(*cur)) goto _fail; \
+        cur = hdr + *idx; \
+    } \
+    idx++; \
+} while (false)
+
+/* Read a string at the opening quote, the next token is the closing quote if
+   the string has no escape, control or non-ASCII character. */
+#define read_str_idx(_end) do { \
+    u8 *str_end = hdr + *idx; \
+    if (likely(*str_end == '"')) { \
+        val->tag = ((u64)(str_end - cur - 1) << YYJSON_TAG_BIT) | \
+                   YYJSON_TYPE_STR | YYJSON_SUBTYPE_NOESC; \
+        val->uni.str = (const char *)(cur + 1); \
+        *str_end = '\0'; \
+        cur = str_end + 1; \
+        idx++; \
+        goto _end; \
+    } \
+    if (likely(read_str(&cur, eof, flg, val, &msg, NULL))) { \
+        while (hdr + *idx < cur) idx++; \
+        goto _end; \
+    } \
+} while (false)
+
     usize dat_len; /* data length in bytes, hint for allocator */
     usize hdr_len; /* value count used by yyjson_doc */
     usize alc_len; /* value count allocated */
+    usize alc_ini; /* value count allocated before reading */
     usize alc_max; /* maximum value count for allocator */
+    usize val_grow = 0; /* the number of times the values are reallocated */
+    usize val_num; /* the value count of the input, 0 if not counted */
     usize ctn_len; /* the number of elements in current container */
-    yyjson_val *val_hdr; /* the head of allocated values */
+    yyjson_val *val_hdr = NULL; /* the head of allocated values */
     yyjson_val *val_end; /* the end of allocated values */
     yyjson_val *val_tmp; /* temporary pointer for realloc */
     yyjson_val *val; /* current JSON value */
@@ -5396,6 +8830,8 @@ static_inline yyjson_doc *read_root_minify(u8 *hdr, u8 *cur, u8 *eof,
     yyjson_val *ctn_parent; /* parent of current container */
     yyjson_doc *doc; /* the JSON document, equals to val_hdr */
     const char *msg; /* error message */
+    u32 *idx_hdr; /* the structural index */
+    u32 *idx; /* the next token in the structural index */
 
     u8 raw_end[1]; /* raw end for null-terminator */
     u8 *raw_ptr = raw_end;
@@ -5405,12 +8841,23 @@ static_inline yyjson_doc *read_root_minify(u8 *hdr, u8 *cur, u8 *eof,
     u32 container_depth = 0; /* current array/object depth */
 #endif
 
-    dat_len = has_flg(STOP_WHEN_DONE) ? 256 : (usize)(eof - cur);
+    idx_hdr = idx_build(hdr, cur, eof, alc, &val_num);
+    if (unlikely(!idx_hdr)) goto fail_alloc;
+    idx = idx_hdr + 1; /* the first token is the root container */
+    if (!has_flg(PRECOUNT)) val_num = 0;
+
+    dat_len = (usize)(eof - cur);
     hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
     hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
     alc_max = USIZE_MAX / sizeof(yyjson_val);
-    alc_len = hdr_len + (dat_len / YYJSON_READER_ESTIMATED_MINIFY_RATIO) + 4;
+    if (val_num) {
+        alc_len = hdr_len + val_num + 2; /* padding for key-value pair */
+    } else {
+        alc_len = hdr_len +
+                  (dat_len / YYJSON_READER_ESTIMATED_MINIFY_RATIO) + 4;
+    }
     alc_len = yyjson_min(alc_len, alc_max);
+    alc_ini = alc_len;
 
     val_hdr = (yyjson_val *)alc.malloc(alc.ctx, alc_len * sizeof(yyjson_val));
     if (unlikely(!val_hdr)) goto fail_alloc;
@@ -5450,6 +8897,13 @@ arr_begin:
     ctn_len = 0;
 
 arr_val_begin:
+    idx_next();
+    if (*cur == '"') {
+        val_incr();
+        ctn_len++;
+        read_str_idx(arr_val_end);
+        goto fail_string;
+    }
     if (*cur == '{') {
         cur++;
         goto obj_begin;
@@ -5461,15 +8915,9 @@ arr_val_begin:
     if (char_is_num(*cur)) {
         val_incr();
         ctn_len++;
-        if (likely(read_num(&cur, pre, flg, val, &msg))) goto arr_val_end;
+        if (likely(read_num(&cur, eof, pre, flg, val, &msg))) goto arr_val_end;
         goto fail_number;
     }
-    if (*cur == '"') {
-        val_incr();
-        ctn_len++;
-        if (likely(read_str(&cur, eof, flg, val, &msg))) goto arr_val_end;
-        goto fail_string;
-    }
     if (*cur == 't') {
         val_incr();
         ctn_len++;
@@ -5498,10 +8946,6 @@ arr_val_begin:
         do { cur--; } while (*cur != ',');
         goto fail_trailing_comma;
     }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto arr_val_begin;
-    }
     if (has_allow(INF_AND_NAN) &&
         (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
         val_incr();
@@ -5509,19 +8953,10 @@ arr_val_begin:
         if (read_inf_or_nan(&cur, pre, flg, val)) goto arr_val_end;
         goto fail_character_val;
     }
-    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
-        val_incr();
-        ctn_len++;
-        if (likely(read_str_sq(&cur, eof, flg, val, &msg))) goto arr_val_end;
-        goto fail_string;
-    }
-    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-        if (skip_trivia(&cur, eof, flg)) goto arr_val_begin;
-        if (cur == eof) goto fail_comment;
-    }
     goto fail_character_val;
 
 arr_val_end:
+    idx_next_after(fail_character_arr_end);
     if (*cur == ',') {
         cur++;
         goto arr_val_begin;
@@ -5530,14 +8965,6 @@ arr_val_end:
         cur++;
         goto arr_end;
     }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto arr_val_end;
-    }
-    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-        if (skip_trivia(&cur, eof, flg)) goto arr_val_end;
-        if (cur == eof) goto fail_comment;
-    }
     goto fail_character_arr_end;
 
 arr_end:
@@ -5577,69 +9004,44 @@ obj_begin:
     val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
     ctn = val;
     ctn_len = 0;
-
-obj_key_begin:
-    if (likely(*cur == '"')) {
-        val_incr();
-        ctn_len++;
-        if (likely(read_str(&cur, eof, flg, val, &msg))) goto obj_key_end;
-        goto fail_string;
-    }
-    if (likely(*cur == '}')) {
-        cur++;
-        if (likely(ctn_len == 0)) goto obj_end;
-        if (has_allow(TRAILING_COMMAS)) goto obj_end;
-        do { cur--; } while (*cur != ',');
-        goto fail_trailing_comma;
-    }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto obj_key_begin;
-    }
-    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
-        val_incr();
-        ctn_len++;
-        if (likely(read_str_sq(&cur, eof, flg, val, &msg))) goto obj_key_end;
-        goto fail_string;
-    }
-    if (has_allow(UNQUOTED_KEY) && char_is_id_start(*cur)) {
+
+obj_key_begin:
+    idx_next();
+    if (likely(*cur == '"')) {
         val_incr();
         ctn_len++;
-        if (read_str_id(&cur, eof, flg, pre, val, &msg)) goto obj_key_end;
+        read_str_idx(obj_key_end);
         goto fail_string;
     }
-    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-        if (skip_trivia(&cur, eof, flg)) goto obj_key_begin;
-        if (cur == eof) goto fail_comment;
+    if (likely(*cur == '}')) {
+        cur++;
+        if (likely(ctn_len == 0)) goto obj_end;
+        if (has_allow(TRAILING_COMMAS)) goto obj_end;
+        do { cur--; } while (*cur != ',');
+        goto fail_trailing_comma;
     }
     goto fail_character_obj_key;
 
 obj_key_end:
+    idx_next_after(fail_character_obj_sep);
     if (*cur == ':') {
         cur++;
         goto obj_val_begin;
     }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto obj_key_end;
-    }
-    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-        if (skip_trivia(&cur, eof, flg)) goto obj_key_end;
-        if (cur == eof) goto fail_comment;
-    }
     goto fail_character_obj_sep;
 
 obj_val_begin:
+    idx_next();
     if (*cur == '"') {
         val++;
         ctn_len++;
-        if (likely(read_str(&cur, eof, flg, val, &msg))) goto obj_val_end;
+        read_str_idx(obj_val_end);
         goto fail_string;
     }
     if (char_is_num(*cur)) {
         val++;
         ctn_len++;
-        if (likely(read_num(&cur, pre, flg, val, &msg))) goto obj_val_end;
+        if (likely(read_num(&cur, eof, pre, flg, val, &msg))) goto obj_val_end;
         goto fail_number;
     }
     if (*cur == '{') {
@@ -5671,10 +9073,6 @@ obj_val_begin:
         }
         goto fail_literal_null;
     }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto obj_val_begin;
-    }
     if (has_allow(INF_AND_NAN) &&
         (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
         val++;
@@ -5682,19 +9080,10 @@ obj_val_begin:
         if (read_inf_or_nan(&cur, pre, flg, val)) goto obj_val_end;
         goto fail_character_val;
     }
-    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
-        val++;
-        ctn_len++;
-        if (likely(read_str_sq(&cur, eof, flg, val, &msg))) goto obj_val_end;
-        goto fail_string;
-    }
-    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-        if (skip_trivia(&cur, eof, flg)) goto obj_val_begin;
-        if (cur == eof) goto fail_comment;
-    }
     goto fail_character_val;
 
 obj_val_end:
+    idx_next_after(fail_character_obj_end);
     if (likely(*cur == ',')) {
         cur++;
         goto obj_key_begin;
@@ -5703,14 +9092,6 @@ obj_val_end:
         cur++;
         goto obj_end;
     }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto obj_val_end;
-    }
-    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-        if (skip_trivia(&cur, eof, flg)) goto obj_val_end;
-        if (cur == eof) goto fail_comment;
-    }
     goto fail_character_obj_end;
 
 obj_end:
@@ -5733,15 +9114,9 @@ obj_end:
 
 doc_end:
     /* check invalid contents after json document */
-    if (unlikely(cur < eof) && !has_flg(STOP_WHEN_DONE)) {
-        while (char_is_space(*cur)) cur++;
-        if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-            if (!skip_trivia(&cur, eof, flg) && cur == eof) {
-                goto fail_comment;
-            }
-        }
-        if (unlikely(cur < eof)) goto fail_garbage;
-    }
+    cur = hdr + *idx;
+    if (unlikely(cur < eof)) goto fail_garbage;
+    alc.free(alc.ctx, idx_hdr);
 
     **pre = '\0';
     doc = (yyjson_doc *)val_hdr;
@@ -5750,6 +9125,10 @@ doc_end:
     doc->dat_read = (usize)(cur - hdr);
     doc->val_read = (usize)((val - doc->root) + 1);
     doc->str_pool = has_flg(INSITU) ? NULL : (char *)hdr;
+    memset(&doc->ext, 0, sizeof(yyjson_doc_ext));
+    doc->ext.stats.val_alloc = alc_ini - hdr_len;
+    doc->ext.stats.val_cap = alc_len - hdr_len;
+    doc->ext.stats.realloc_count = val_grow;
     return doc;
 
 fail_string:            return_err(cur, INVALID_STRING, msg);
@@ -5764,1160 +9143,1980 @@ fail_character_arr_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_ARR_END);
 fail_character_obj_key: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_KEY);
 fail_character_obj_sep: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_SEP);
 fail_character_obj_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_END);
-fail_comment:           return_err(cur, INVALID_COMMENT, MSG_COMMENT);
 fail_garbage:           return_err(cur, UNEXPECTED_CONTENT, MSG_GARBAGE);
 fail_depth:             return_err(cur, DEPTH, MSG_DEPTH);
 
+#undef read_str_idx
+#undef idx_next_after
+#undef idx_next
 #undef val_incr
 #undef return_err
 }
 
-/** Read JSON document (accept all style, but optimized for pretty). */
-static_inline yyjson_doc *read_root_pretty(u8 *hdr, u8 *cur, u8 *eof,
-                                           yyjson_alc alc,
-                                           yyjson_read_flag flg,
-                                           yyjson_read_err *err) {
+
+
+/*==============================================================================
+ * MARK: - JSON Reader Parallel (Private)
+ *
+ * The parallel reader splits the input at the commas of the root container,
+ * and copies each part into its own region of the string pool:
+ *
+ *     input:  [e1, e2, e3, e4, e5]
+ *     parts:  [e1, e2]    [ e3]    [ e4, e5]
+ *
+ * The first part is the input before the first split point with a closing
+ * bracket, the other parts begin with an opening bracket, and all but the last
+ * one end with a closing bracket. Each part is read as a standalone document,
+ * then the values are merged into one document.
+ *
+ * The split points are found with a heuristic and are not validated before
+ * reading. If every part is read successfully, fully consumed and not empty,
+ * the state at the end of each part is the same as the state of the serial
+ * reader at its split point (outside any string, comment or nested container,
+ * after a complete element), so all the split points are real separators and
+ * the document is the same as the serial reader's.
+ *============================================================================*/
+
+/** Read JSON document, `cur` is the beginning of the root value. */
+static_noinline yyjson_doc *read_root(u8 *hdr, u8 *cur, u8 *eof,
+                                      yyjson_alc alc,
+                                      yyjson_read_flag flg,
+                                      yyjson_read_err *err,
+                                      copy_pool *pool) {
+    if (likely(char_is_ctn(*cur))) {
+        /* the structural index writes to the input */
+        usize val_num = 0;
+        if (!pool && idx_read_enabled(flg, (usize)(eof - hdr))) {
+            return read_root_index(hdr, cur, eof, alc, flg, err);
+        }
+        if (has_flg(PRECOUNT) && !has_flg(STOP_WHEN_DONE)) {
+            val_num = idx_count(cur, eof);
+        }
+        if (char_is_space(cur[1]) && char_is_space(cur[2])) {
+            return read_root_pretty(hdr, cur, eof, alc, flg, err,
+                                    val_num, pool);
+        }
+        return read_root_minify(hdr, cur, eof, alc, flg, err, val_num, pool);
+    }
+    return read_root_single(hdr, cur, eof, alc, flg, err, pool);
+}
+
+/** A part of the input for the parallel reader. */
+typedef struct par_part {
+    usize pos; /* the beginning of this part in the input */
+    usize end; /* the end of this part in the input (split point or length) */
+    u8 *hdr; /* the copy of this part in the string pool */
+    yyjson_doc *doc; /* the document of this part, NULL on failure */
+    usize val_ofs; /* the offset of the first value in the merged document */
+} par_part;
+
+/** The shared context of the parallel reader tasks. */
+typedef struct par_ctx {
+    const u8 *dat; /* the input data */
+    usize root; /* the offset of the root container in the input */
+    u8 open, close; /* the brackets of the root container */
+    yyjson_alc alc;
+    yyjson_read_flag flg;
+    par_part *parts;
+    usize num; /* the number of parts */
+    yyjson_val *val_hdr; /* the values of the merged document */
+} par_ctx;
+
+/** Returns the offset after the string beginning at `pos` and the spaces
+    after it. */
+static_inline usize par_skip_str(const u8 *dat, usize len, usize pos) {
+    for (pos++; pos < len && dat[pos] != '"'; pos++) {
+        if (dat[pos] == '\\') pos++;
+    }
+    for (pos++; pos < len && char_is_space(dat[pos]); ) pos++;
+    return pos;
+}
+
+/** Returns the last character of an element beginning with `c`,
+    or 0 if unknown. */
+static_inline u8 par_tail_char(u8 c) {
+    if (c == '{' || c == '[') return (u8)(c + 2);
+    if (c == '"') return c;
+    return 0;
+}
+
+/** Returns whether the comma at `pos` may be a split point of the root
+    container. The next element should begin with the same character `head`
+    as the first element, and the previous element should end with `tail`
+    (0 for any character). */
+static_inline bool par_is_split(const u8 *dat, usize len, usize pos,
+                                u8 head, u8 tail, bool obj) {
+    usize i = pos + 1, k;
+    while (i < len && char_is_space(dat[i])) i++;
+    if (i >= len) return false;
+    if (char_is_num(head)) {
+        if (!char_is_num(dat[i])) return false;
+    } else if (dat[i] != head) {
+        return false;
+    }
+    if (tail) {
+        k = pos;
+        while (k > 0 && char_is_space(dat[k - 1])) k--;
+        if (k == 0 || dat[k - 1] != tail) return false;
+    }
+    if (obj && head == '"') {
+        /* the next key should be followed by a colon */
+        k = par_skip_str(dat, len, i);
+        if (k >= len || dat[k] != ':') return false;
+    }
+    return true;
+}
+
+/** Returns the offset of the first split point in `[pos, end)`, or 0. */
+static_inline usize par_find_split(const u8 *dat, usize len, usize pos,
+                                   usize end, u8 head, u8 tail, bool obj) {
+    for (; pos < end; pos++) {
+        if (dat[pos] == ',' && par_is_split(dat, len, pos, head, tail, obj)) {
+            return pos;
+        }
+    }
+    return 0;
+}
+
+/** Copy and read a part. */
+static void par_read_task(void *arg, usize idx) {
+    par_ctx *ctx = (par_ctx *)arg;
+    par_part *part = ctx->parts + idx;
+    yyjson_read_flag flg = ctx->flg;
+    usize dat_len = part->end - part->pos;
+    u8 *hdr = part->hdr, *cur, *eof;
+    yyjson_read_err err;
+
+    if (idx == 0) {
+        memcpy(hdr, ctx->dat, dat_len);
+        cur = hdr + ctx->root;
+        eof = hdr + dat_len;
+    } else {
+        hdr[0] = ctx->open;
+        memcpy(hdr + 1, ctx->dat + part->pos, dat_len);
+        cur = hdr;
+        eof = hdr + 1 + dat_len;
+    }
+    if (idx + 1 < ctx->num) {
+        *eof++ = ctx->close;
+        /* a trailing comma before the split point makes the input invalid */
+        flg &= ~YYJSON_READ_ALLOW_TRAILING_COMMAS;
+    }
+    memset(eof, 0, YYJSON_PADDING_SIZE);
+
+    part->doc = read_root(hdr, cur, eof, ctx->alc, flg, &err, NULL);
+    if (!part->doc) return;
+    part->doc->str_pool = NULL; /* the string pool is owned by the context */
+    if (unsafe_yyjson_get_len(part->doc->root) == 0 ||
+        (idx + 1 < ctx->num && part->doc->dat_read != (usize)(eof - hdr))) {
+        yyjson_doc_free(part->doc);
+        part->doc = NULL;
+    }
+}
+
+/** Copy the values of a part to the merged document. */
+static void par_merge_task(void *arg, usize idx) {
+    par_ctx *ctx = (par_ctx *)arg;
+    par_part *part = ctx->parts + idx;
+    memcpy(ctx->val_hdr + part->val_ofs, part->doc->root + 1,
+           (part->doc->val_read - 1) * sizeof(yyjson_val));
+}
+
+/** Run the tasks with `run`, or one by one if `run` is NULL. */
+static_inline void par_run_tasks(yyjson_par_run run, void *run_ctx,
+                                 yyjson_par_task task, par_ctx *ctx) {
+    if (run) {
+        run(run_ctx, task, (void *)ctx, ctx->num);
+    } else {
+        usize i;
+        for (i = 0; i < ctx->num; i++) task((void *)ctx, i);
+    }
+}
+
+
+
+/*==============================================================================
+ * MARK: - JSON Reader (Public)
+ *============================================================================*/
+
+yyjson_doc *yyjson_read_opts(char *dat, usize len,
+                             yyjson_read_flag flg,
+                             const yyjson_alc *alc_ptr,
+                             yyjson_read_err *err) {
 #define return_err(_pos, _code, _msg) do { \
-    if (is_truncated_end(hdr, _pos, eof, YYJSON_READ_ERROR_##_code, flg)) { \
-        err->pos = (usize)(eof - hdr); \
-        err->code = YYJSON_READ_ERROR_UNEXPECTED_END; \
-        err->msg = MSG_NOT_END; \
-    } else { \
-        err->pos = (usize)(_pos - hdr); \
-        err->code = YYJSON_READ_ERROR_##_code; \
-        err->msg = _msg; \
-    } \
-    if (val_hdr) alc.free(alc.ctx, val_hdr); \
+    err->pos = (usize)(_pos); \
+    err->msg = _msg; \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    if (!has_flg(INSITU) && hdr) alc.free(alc.ctx, (void *)hdr); \
     return NULL; \
 } while (false)
 
-#define val_incr() do { \
-    val++; \
-    if (unlikely(val >= val_end)) { \
-        usize alc_old = alc_len; \
-        usize val_ofs = (usize)(val - val_hdr); \
-        usize ctn_ofs = (usize)(ctn - val_hdr); \
-        alc_len += alc_len / 2; \
-        if ((sizeof(usize) < 8) && (alc_len >= alc_max)) goto fail_alloc; \
-        val_tmp = (yyjson_val *)alc.realloc(alc.ctx, (void *)val_hdr, \
-            alc_old * sizeof(yyjson_val), \
-            alc_len * sizeof(yyjson_val)); \
-        if ((!val_tmp)) goto fail_alloc; \
-        val = val_tmp + val_ofs; \
-        ctn = val_tmp + ctn_ofs; \
-        val_hdr = val_tmp; \
-        val_end = val_tmp + (alc_len - 2); \
-    } \
-} while (false)
-
-    usize dat_len; /* data length in bytes, hint for allocator */
-    usize hdr_len; /* value count used by yyjson_doc */
-    usize alc_len; /* value count allocated */
-    usize alc_max; /* maximum value count for allocator */
-    usize ctn_len; /* the number of elements in current container */
-    yyjson_val *val_hdr; /* the head of allocated values */
-    yyjson_val *val_end; /* the end of allocated values */
-    yyjson_val *val_tmp; /* temporary pointer for realloc */
-    yyjson_val *val; /* current JSON value */
-    yyjson_val *ctn; /* current container */
-    yyjson_val *ctn_parent; /* parent of current container */
-    yyjson_doc *doc; /* the JSON document, equals to val_hdr */
-    const char *msg; /* error message */
+    yyjson_read_err tmp_err;
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    yyjson_doc *doc;
+    u8 *hdr = NULL, *eof, *cur;
+    copy_pool copy = { NULL, NULL, NULL, NULL, false }, *pool = NULL;
+    usize i;
 
-    u8 raw_end[1]; /* raw end for null-terminator */
-    u8 *raw_ptr = raw_end;
-    u8 **pre = &raw_ptr; /* previous raw end pointer */
-#if YYJSON_READER_DEPTH_LIMIT
-    u32 container_depth = 0; /* current array/object depth */
-#endif
+    /* validate input parameters */
+    if (!err) err = &tmp_err;
+    if (unlikely(!dat)) return_err(0, INVALID_PARAMETER, "input data is NULL");
+    if (unlikely(!len)) return_err(0, INVALID_PARAMETER, "input length is 0");
+    if (has_flg(ZERO_COPY)) {
+        if (unlikely(flg & (YYJSON_READ_INSITU |
+                            YYJSON_READ_NUMBER_AS_RAW |
+                            YYJSON_READ_BIGNUM_AS_RAW |
+                            YYJSON_READ_ALLOW_UNQUOTED_KEY))) {
+            return_err(0, INVALID_PARAMETER,
+                       "flag is not supported with zero-copy reading");
+        }
+        for (i = 0; i < YYJSON_PADDING_SIZE; i++) {
+            if (unlikely(dat[len + i])) {
+                return_err(0, INVALID_PARAMETER,
+                           "input data is not padded with zero bytes");
+            }
+        }
+        /* read the input in place, the strings are never written to it */
+        flg |= YYJSON_READ_INSITU;
+        copy.alc = &alc;
+        pool = &copy;
+    }
 
-    dat_len = has_flg(STOP_WHEN_DONE) ? 256 : (usize)(eof - cur);
-    hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
-    hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
-    alc_max = USIZE_MAX / sizeof(yyjson_val);
-    alc_len = hdr_len + (dat_len / YYJSON_READER_ESTIMATED_PRETTY_RATIO) + 4;
-    alc_len = yyjson_min(alc_len, alc_max);
+    /* add 4-byte zero padding for input data if necessary */
+    if (has_flg(INSITU)) {
+        hdr = (u8 *)dat;
+        eof = (u8 *)dat + len;
+        cur = (u8 *)dat;
+        if (!pool) memset(eof, 0, YYJSON_PADDING_SIZE);
+    } else {
+        if (unlikely(len >= USIZE_MAX - YYJSON_PADDING_SIZE)) {
+            return_err(0, MEMORY_ALLOCATION, MSG_MALLOC);
+        }
+        hdr = (u8 *)alc.malloc(alc.ctx, len + YYJSON_PADDING_SIZE);
+        if (unlikely(!hdr)) {
+            return_err(0, MEMORY_ALLOCATION, MSG_MALLOC);
+        }
+        eof = hdr + len;
+        cur = hdr;
+        memcpy(hdr, dat, len);
+        memset(eof, 0, YYJSON_PADDING_SIZE);
+    }
 
-    val_hdr = (yyjson_val *)alc.malloc(alc.ctx, alc_len * sizeof(yyjson_val));
-    if (unlikely(!val_hdr)) goto fail_alloc;
-    val_end = val_hdr + (alc_len - 2); /* padding for key-value pair reading */
-    val = val_hdr + hdr_len;
-    ctn = val;
-    ctn_len = 0;
+    if (has_allow(BOM)) {
+        if (len >= 3 && is_utf8_bom(cur)) cur += 3;
+    }
 
-    if (*cur++ == '{') {
-        ctn->tag = YYJSON_TYPE_OBJ;
-        ctn->uni.ofs = 0;
-        if (*cur == '\n') cur++;
-        goto obj_key_begin;
-    } else {
-        ctn->tag = YYJSON_TYPE_ARR;
-        ctn->uni.ofs = 0;
-        if (*cur == '\n') cur++;
-        goto arr_val_begin;
+    /* skip empty contents before json document */
+    if (unlikely(!char_is_ctn(*cur))) {
+        while (char_is_space(*cur)) cur++;
+        if (unlikely(!char_is_ctn(*cur))) {
+            if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+                if (!skip_trivia(&cur, eof, flg) && cur == eof) {
+                    return_err(cur - hdr, INVALID_COMMENT, MSG_COMMENT);
+                }
+            }
+        }
+        if (unlikely(cur >= eof)) {
+            return_err(0, EMPTY_CONTENT, "input data is empty");
+        }
     }
 
-arr_begin:
-#if YYJSON_READER_DEPTH_LIMIT
-    container_depth++;
-    if (unlikely(container_depth >= YYJSON_READER_DEPTH_LIMIT)) {
-        goto fail_depth;
+    /* read json document */
+    doc = read_root(hdr, cur, eof, alc, flg, err, pool);
+
+    /* check result */
+    if (likely(doc)) {
+        memset(err, 0, sizeof(yyjson_read_err));
+        if (pool) copy_pool_end(pool, doc);
+    } else {
+        if (pool) {
+            if (copy.oom) err->code = YYJSON_READ_ERROR_MEMORY_ALLOCATION;
+            if (copy.hdr) alc.free(alc.ctx, copy.hdr);
+        }
+        /* RFC 8259: JSON text MUST be encoded using UTF-8 */
+        if (err->pos == 0 && err->code != YYJSON_READ_ERROR_MEMORY_ALLOCATION) {
+            if (is_utf8_bom(hdr)) err->msg = MSG_ERR_BOM;
+            else if (len >= 4 && is_utf32_bom(hdr)) err->msg = MSG_ERR_UTF32;
+            else if (len >= 2 && is_utf16_bom(hdr)) err->msg = MSG_ERR_UTF16;
+        }
+        if (!has_flg(INSITU)) alc.free(alc.ctx, hdr);
     }
-#endif
+    return doc;
 
-    /* save current container */
-    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
-               (ctn->tag & YYJSON_TAG_MASK);
+#undef return_err
+}
 
-    /* create a new array value, save parent container offset */
-    val_incr();
-    val->tag = YYJSON_TYPE_ARR;
-    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
+/** The number of memory blocks tracked by the reuse allocator. */
+#define REUSE_BLK_NUM 8
 
-    /* push the new array value as current container */
-    ctn = val;
-    ctn_len = 0;
-    if (*cur == '\n') cur++;
+/** A memory block of the reuse allocator. */
+typedef struct reuse_blk {
+    void *ptr; /* the block, NULL if this slot is empty */
+    usize cap; /* the size of the block */
+    bool used; /* whether the block is used by the reader */
+} reuse_blk;
 
-arr_val_begin:
-#if YYJSON_IS_REAL_GCC
-    while (true) repeat16({
-        if (byte_match_2(cur, "  ")) cur += 2;
-        else break;
-    })
-#else
-    while (true) repeat16({
-        if (likely(byte_match_2(cur, "  "))) cur += 2;
-        else break;
-    })
-#endif
+/** The allocator of `yyjson_read_into()`, which serves the reader with the
+    retained blocks of the previous document if they are large enough. */
+typedef struct reuse_ctx {
+    yyjson_alc alc; /* the allocator of the document */
+    reuse_blk blk[REUSE_BLK_NUM];
+} reuse_ctx;
 
-    if (*cur == '{') {
-        cur++;
-        goto obj_begin;
-    }
-    if (*cur == '[') {
-        cur++;
-        goto arr_begin;
+static_inline reuse_blk *reuse_find(reuse_ctx *ctx, void *ptr) {
+    reuse_blk *blk = ctx->blk, *end = ctx->blk + REUSE_BLK_NUM;
+    for (; blk < end; blk++) {
+        if (blk->ptr == ptr) return blk;
     }
-    if (char_is_num(*cur)) {
-        val_incr();
-        ctn_len++;
-        if (likely(read_num(&cur, pre, flg, val, &msg))) goto arr_val_end;
-        goto fail_number;
+    return NULL;
+}
+
+static void *reuse_malloc(void *ctx_ptr, usize size) {
+    reuse_ctx *ctx = (reuse_ctx *)ctx_ptr;
+    reuse_blk *blk = ctx->blk, *end = ctx->blk + REUSE_BLK_NUM, *fit = NULL;
+    void *ptr;
+
+    /* the smallest free block which is large enough */
+    for (; blk < end; blk++) {
+        if (blk->ptr && !blk->used && blk->cap >= size &&
+            (!fit || blk->cap < fit->cap)) fit = blk;
     }
-    if (*cur == '"') {
-        val_incr();
-        ctn_len++;
-        if (likely(read_str(&cur, eof, flg, val, &msg))) goto arr_val_end;
-        goto fail_string;
+    if (fit) {
+        fit->used = true;
+        return fit->ptr;
     }
-    if (*cur == 't') {
-        val_incr();
-        ctn_len++;
-        if (likely(read_true(&cur, val))) goto arr_val_end;
-        goto fail_literal_true;
+    ptr = ctx->alc.malloc(ctx->alc.ctx, size);
+    if (ptr && (blk = reuse_find(ctx, NULL)) != NULL) {
+        blk->ptr = ptr;
+        blk->cap = size;
+        blk->used = true;
     }
-    if (*cur == 'f') {
-        val_incr();
-        ctn_len++;
-        if (likely(read_false(&cur, val))) goto arr_val_end;
-        goto fail_literal_false;
+    return ptr;
+}
+
+static void *reuse_realloc(void *ctx_ptr, void *ptr,
+                           usize old_size, usize size) {
+    reuse_ctx *ctx = (reuse_ctx *)ctx_ptr;
+    reuse_blk *blk = reuse_find(ctx, ptr);
+    void *tmp;
+
+    if (!blk) return ctx->alc.realloc(ctx->alc.ctx, ptr, old_size, size);
+    if (blk->cap >= size) return ptr;
+    tmp = ctx->alc.realloc(ctx->alc.ctx, ptr, blk->cap, size);
+    if (tmp) {
+        blk->ptr = tmp;
+        blk->cap = size;
     }
-    if (*cur == 'n') {
-        val_incr();
-        ctn_len++;
-        if (likely(read_null(&cur, val))) goto arr_val_end;
-        if (has_allow(INF_AND_NAN)) {
-            if (read_nan(&cur, pre, flg, val)) goto arr_val_end;
+    return tmp;
+}
+
+static void reuse_free(void *ctx_ptr, void *ptr) {
+    reuse_ctx *ctx = (reuse_ctx *)ctx_ptr;
+    reuse_blk *blk = reuse_find(ctx, ptr);
+    if (blk) blk->used = false;
+    else ctx->alc.free(ctx->alc.ctx, ptr);
+}
+
+yyjson_doc *yyjson_read_into(yyjson_doc *doc, char *dat, usize len,
+                             yyjson_read_flag flg,
+                             const yyjson_alc *alc_ptr,
+                             yyjson_read_err *err) {
+    reuse_ctx ctx;
+    reuse_blk *blk, *end = ctx.blk + REUSE_BLK_NUM, *spare = NULL;
+    yyjson_alc alc;
+    usize hdr_len;
+
+    /* retain the memory of the previous document */
+    memset(&ctx, 0, sizeof(ctx));
+    if (doc) {
+        ctx.alc = doc->alc;
+        if (doc->ext.idx) yyjson_doc_index_free(doc);
+        if (doc->ext.map_len) unsafe_yyjson_doc_unmap(doc);
+        if (doc->str_pool) {
+            if (doc->ext.str_cap) {
+                ctx.blk[1].ptr = doc->str_pool;
+                ctx.blk[1].cap = doc->ext.str_cap;
+            } else {
+                ctx.alc.free(ctx.alc.ctx, doc->str_pool);
+            }
         }
-        goto fail_literal_null;
-    }
-    if (*cur == ']') {
-        cur++;
-        if (likely(ctn_len == 0)) goto arr_end;
-        if (has_allow(TRAILING_COMMAS)) goto arr_end;
-        do { cur--; } while (*cur != ',');
-        goto fail_trailing_comma;
-    }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto arr_val_begin;
-    }
-    if (has_allow(INF_AND_NAN) &&
-        (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
-        val_incr();
-        ctn_len++;
-        if (read_inf_or_nan(&cur, pre, flg, val)) goto arr_val_end;
-        goto fail_character_val;
-    }
-    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
-        val_incr();
-        ctn_len++;
-        if (likely(read_str_sq(&cur, eof, flg, val, &msg))) goto arr_val_end;
-        goto fail_string;
-    }
-    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-        if (skip_trivia(&cur, eof, flg)) goto arr_val_begin;
-        if (cur == eof) goto fail_comment;
+        /* the values read is the lower bound of an unknown size */
+        hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
+        hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
+        ctx.blk[0].ptr = (void *)doc;
+        ctx.blk[0].cap = doc->ext.doc_cap ? doc->ext.doc_cap :
+                         (hdr_len + doc->val_read) * sizeof(yyjson_val);
+    } else {
+        ctx.alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
     }
-    goto fail_character_val;
+    alc.malloc = reuse_malloc;
+    alc.realloc = reuse_realloc;
+    alc.free = reuse_free;
+    alc.ctx = (void *)&ctx;
 
-arr_val_end:
-    if (byte_match_2(cur, ",\n")) {
-        cur += 2;
-        goto arr_val_begin;
+    doc = yyjson_read_opts(dat, len, flg, &alc, err);
+
+    /* record the size of the memory, and free the unused blocks */
+    if (doc) {
+        doc->alc = ctx.alc;
+        blk = reuse_find(&ctx, (void *)doc);
+        doc->ext.doc_cap = blk ? blk->cap : 0;
+        if (doc->str_pool) {
+            blk = reuse_find(&ctx, (void *)doc->str_pool);
+            doc->ext.str_cap = blk ? blk->cap : 0;
+        } else if (!doc->str_pool) {
+            /* keep the largest free block as the string pool */
+            for (blk = ctx.blk; blk < end; blk++) {
+                if (blk->ptr && !blk->used &&
+                    (!spare || blk->cap > spare->cap)) spare = blk;
+            }
+            if (spare) {
+                spare->used = true;
+                doc->str_pool = (char *)spare->ptr;
+                doc->ext.str_cap = spare->cap;
+            }
+        }
     }
-    if (*cur == ',') {
-        cur++;
-        goto arr_val_begin;
+    for (blk = ctx.blk; blk < end; blk++) {
+        if (blk->ptr && (!blk->used || !doc)) {
+            ctx.alc.free(ctx.alc.ctx, blk->ptr);
+        }
     }
-    if (*cur == ']') {
-        cur++;
-        goto arr_end;
+    return doc;
+}
+
+yyjson_doc *yyjson_read_par(char *dat, usize len,
+                            yyjson_read_flag flg,
+                            const yyjson_alc *alc_ptr,
+                            usize par_num,
+                            yyjson_par_run run, void *run_ctx,
+                            yyjson_read_err *err) {
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    const u8 *src = (const u8 *)dat;
+    par_ctx ctx;
+    par_part *part;
+    yyjson_doc *doc = NULL;
+    yyjson_val *root;
+    usize i, num, pos, end, root_pos, pool_len, hdr_len, val_len, ctn_len;
+    u8 *pool = NULL, head, tail;
+    bool obj;
+
+    if (!dat || has_flg(INSITU) || has_flg(ZERO_COPY) || par_num <= 1 ||
+        len < YYJSON_READER_PAR_MIN_SIZE * 2) {
+        return yyjson_read_opts(dat, len, flg, alc_ptr, err);
+    }
+    if (par_num > len / YYJSON_READER_PAR_MIN_SIZE) {
+        par_num = len / YYJSON_READER_PAR_MIN_SIZE;
+    }
+
+    /* find the root container and the first character of its first element */
+    root_pos = 0;
+    if (has_allow(BOM) && is_utf8_bom(src)) root_pos = 3;
+    while (root_pos < len && char_is_space(src[root_pos])) root_pos++;
+    if (root_pos >= len || !char_is_ctn(src[root_pos])) {
+        return yyjson_read_opts(dat, len, flg, alc_ptr, err);
+    }
+    obj = src[root_pos] == '{';
+    pos = root_pos + 1;
+    while (pos < len && char_is_space(src[pos])) pos++;
+    if (pos >= len || src[pos] == ']' || src[pos] == '}') {
+        return yyjson_read_opts(dat, len, flg, alc_ptr, err);
+    }
+    head = src[pos];
+    tail = par_tail_char(head);
+    if (obj) {
+        /* the previous pair should end with the same character as the
+           first value */
+        tail = 0;
+        if (head == '"') {
+            pos = par_skip_str(src, len, pos);
+            if (pos < len && src[pos] == ':') {
+                for (pos++; pos < len && char_is_space(src[pos]); ) pos++;
+                if (pos < len) tail = par_tail_char(src[pos]);
+            }
+        }
     }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto arr_val_end;
+
+    ctx.parts = (par_part *)alc.malloc(alc.ctx, par_num * sizeof(par_part));
+    if (!ctx.parts) return yyjson_read_opts(dat, len, flg, alc_ptr, err);
+    memset(ctx.parts, 0, par_num * sizeof(par_part));
+
+    /* choose the split points near evenly spaced positions */
+    num = 0;
+    end = 0;
+    for (i = 1; i < par_num; i++) {
+        usize beg = len / par_num * i;
+        if (beg <= end) beg = end + 1;
+        end = par_find_split(src, len, beg, len / par_num * (i + 1),
+                             head, tail, obj);
+        if (!end) {
+            end = beg;
+            continue;
+        }
+        ctx.parts[num].end = end;
+        ctx.parts[++num].pos = end + 1;
+    }
+    if (num == 0) goto fail;
+    ctx.parts[num++].end = len;
+
+    /* each part is copied to its own region of the string pool */
+    pool_len = 0;
+    for (i = 0; i < num; i++) {
+        pool_len += ctx.parts[i].end - ctx.parts[i].pos;
+        pool_len += (usize)(i > 0) + (usize)(i + 1 < num); /* brackets */
+        pool_len += YYJSON_PADDING_SIZE;
+    }
+    pool = (u8 *)alc.malloc(alc.ctx, pool_len);
+    if (!pool) goto fail;
+    pool_len = 0;
+    for (i = 0; i < num; i++) {
+        ctx.parts[i].hdr = pool + pool_len;
+        pool_len += ctx.parts[i].end - ctx.parts[i].pos;
+        pool_len += (usize)(i > 0) + (usize)(i + 1 < num); /* brackets */
+        pool_len += YYJSON_PADDING_SIZE;
+    }
+
+    /* read the parts */
+    ctx.dat = src;
+    ctx.root = root_pos;
+    ctx.open = src[root_pos];
+    ctx.close = (u8)(ctx.open + 2);
+    ctx.alc = alc;
+    ctx.flg = flg;
+    ctx.num = num;
+    ctx.val_hdr = NULL;
+    par_run_tasks(run, run_ctx, par_read_task, &ctx);
+
+    val_len = 1;
+    ctn_len = 0;
+    for (i = 0; i < num; i++) {
+        part = ctx.parts + i;
+        if (!part->doc) goto fail;
+        part->val_ofs = val_len;
+        val_len += part->doc->val_read - 1;
+        ctn_len += unsafe_yyjson_get_len(part->doc->root);
     }
-    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-        if (skip_trivia(&cur, eof, flg)) goto arr_val_end;
-        if (cur == eof) goto fail_comment;
+
+    /* merge the values of the parts */
+    hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
+    hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
+    ctx.val_hdr = (yyjson_val *)alc.malloc(alc.ctx,
+        (hdr_len + val_len) * sizeof(yyjson_val));
+    if (!ctx.val_hdr) goto fail;
+    ctx.val_hdr += hdr_len;
+    par_run_tasks(run, run_ctx, par_merge_task, &ctx);
+
+    root = ctx.val_hdr;
+    root->tag = ((u64)ctn_len << YYJSON_TAG_BIT) |
+                (obj ? YYJSON_TYPE_OBJ : YYJSON_TYPE_ARR);
+    root->uni.ofs = val_len * sizeof(yyjson_val);
+
+    doc = (yyjson_doc *)(void *)(ctx.val_hdr - hdr_len);
+    doc->root = root;
+    doc->alc = alc;
+    part = ctx.parts + num - 1;
+    doc->dat_read = part->pos + part->doc->dat_read - 1;
+    doc->val_read = val_len;
+    doc->str_pool = (char *)pool;
+    memset(&doc->ext, 0, sizeof(yyjson_doc_ext));
+    for (i = 0; i < num; i++) yyjson_doc_free(ctx.parts[i].doc);
+    alc.free(alc.ctx, ctx.parts);
+    if (err) memset(err, 0, sizeof(yyjson_read_err));
+    return doc;
+
+fail:
+    /* read the whole input again on the calling thread */
+    for (i = 0; i < num; i++) yyjson_doc_free(ctx.parts[i].doc);
+    alc.free(alc.ctx, ctx.parts);
+    if (pool) alc.free(alc.ctx, pool);
+    return yyjson_read_opts(dat, len, flg, alc_ptr, err);
+}
+
+#if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
+
+yyjson_doc *yyjson_read_file(const char *path,
+                             yyjson_read_flag flg,
+                             const yyjson_alc *alc_ptr,
+                             yyjson_read_err *err) {
+#define return_err(_code, _msg) do { \
+    err->pos = 0; \
+    err->msg = _msg; \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    return NULL; \
+} while (false)
+
+    yyjson_read_err tmp_err;
+    yyjson_doc *doc;
+    FILE *file;
+
+    if (!err) err = &tmp_err;
+    if (unlikely(!path)) return_err(INVALID_PARAMETER, "input path is NULL");
+
+    file = fopen_readonly(path);
+    if (unlikely(!file)) return_err(FILE_OPEN, MSG_FREAD);
+
+    doc = yyjson_read_fp(file, flg, alc_ptr, err);
+    fclose(file);
+    return doc;
+
+#undef return_err
+}
+
+yyjson_doc *yyjson_read_fp(FILE *file,
+                           yyjson_read_flag flg,
+                           const yyjson_alc *alc_ptr,
+                           yyjson_read_err *err) {
+#define return_err(_code, _msg) do { \
+    err->pos = 0; \
+    err->msg = _msg; \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    if (buf) alc.free(alc.ctx, buf); \
+    return NULL; \
+} while (false)
+
+    yyjson_read_err tmp_err;
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    yyjson_doc *doc;
+
+    long file_size = 0, file_pos;
+    void *buf = NULL;
+    usize buf_size = 0;
+    usize dat_size = 0;
+
+    /* validate input parameters */
+    if (!err) err = &tmp_err;
+    if (unlikely(!file)) return_err(INVALID_PARAMETER, "input file is NULL");
+
+    /* get current position */
+    file_pos = ftell(file);
+    if (file_pos != -1) {
+        /* get total file size, may fail */
+        if (fseek(file, 0, SEEK_END) == 0) {
+            file_size = ftell(file);
+            if (file_size == -1) file_size = 0;
+        }
+        /* reset to original position, may fail */
+        if (fseek(file, file_pos, SEEK_SET) != 0) file_size = 0;
+        /* get file size from current position to end */
+        if (file_size > 0) file_size -= file_pos;
     }
-    goto fail_character_arr_end;
 
-arr_end:
-#if YYJSON_READER_DEPTH_LIMIT
-    container_depth--;
-#endif
-    /* get parent container */
-    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
+    /* read file */
+    if (file_size > 0) {
+        /* read the entire file in one call */
+        dat_size = (usize)file_size;
+        buf_size = dat_size + YYJSON_PADDING_SIZE;
+        buf = alc.malloc(alc.ctx, buf_size);
+        if (buf == NULL) {
+            return_err(MEMORY_ALLOCATION, MSG_MALLOC);
+        }
+        if (fread_safe(buf, dat_size, file) != dat_size) {
+            return_err(FILE_READ, MSG_FREAD);
+        }
+    } else {
+        /* failed to get file size, read it as a stream */
+        usize chunk_min = (usize)64;
+        usize chunk_max = (usize)512 * 1024 * 1024;
+        usize chunk_now = chunk_min;
+        usize read_size;
+        void *tmp;
+
+        buf_size = YYJSON_PADDING_SIZE;
+        while (true) {
+            if (buf_size + chunk_now < buf_size) { /* overflow */
+                return_err(MEMORY_ALLOCATION, MSG_MALLOC);
+            }
+            buf_size += chunk_now;
+            if (!buf) {
+                buf = alc.malloc(alc.ctx, buf_size);
+                if (!buf) return_err(MEMORY_ALLOCATION, MSG_MALLOC);
+            } else {
+                tmp = alc.realloc(alc.ctx, buf, buf_size - chunk_now, buf_size);
+                if (!tmp) return_err(MEMORY_ALLOCATION, MSG_MALLOC);
+                buf = tmp;
+            }
+            tmp = ((u8 *)buf) + buf_size - YYJSON_PADDING_SIZE - chunk_now;
+            read_size = fread_safe(tmp, chunk_now, file);
+            dat_size += read_size;
+            if (read_size != chunk_now) break;
 
-    /* save the next sibling value offset */
-    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
-    ctn->tag = ((ctn_len) << YYJSON_TAG_BIT) | YYJSON_TYPE_ARR;
-    if (unlikely(ctn == ctn_parent)) goto doc_end;
+            chunk_now *= 2;
+            if (chunk_now > chunk_max) chunk_now = chunk_max;
+        }
+    }
 
-    /* pop parent as current container */
-    ctn = ctn_parent;
-    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
-    if (*cur == '\n') cur++;
-    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
-        goto obj_val_end;
+    /* read JSON */
+    memset((u8 *)buf + dat_size, 0, YYJSON_PADDING_SIZE);
+    flg |= YYJSON_READ_INSITU;
+    flg &= ~YYJSON_READ_ZERO_COPY;
+    doc = yyjson_read_opts((char *)buf, dat_size, flg, &alc, err);
+    if (doc) {
+        doc->str_pool = (char *)buf;
+        return doc;
     } else {
-        goto arr_val_end;
+        alc.free(alc.ctx, buf);
+        return NULL;
     }
 
-obj_begin:
-#if YYJSON_READER_DEPTH_LIMIT
-    container_depth++;
-    if (unlikely(container_depth >= YYJSON_READER_DEPTH_LIMIT)) {
-        goto fail_depth;
-    }
-#endif
+#undef return_err
+}
 
-    /* push container */
-    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
-               (ctn->tag & YYJSON_TAG_MASK);
-    val_incr();
-    val->tag = YYJSON_TYPE_OBJ;
-    /* offset to the parent */
-    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
-    ctn = val;
-    ctn_len = 0;
-    if (*cur == '\n') cur++;
+yyjson_doc *yyjson_read_file_mmap(const char *path,
+                                  yyjson_read_flag flg,
+                                  const yyjson_alc *alc_ptr,
+                                  yyjson_read_err *err) {
+#if YYJSON_HAS_MMAP
+#define return_err(_code, _msg) do { \
+    err->pos = 0; \
+    err->msg = _msg; \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    if (fd != -1) close(fd); \
+    return NULL; \
+} while (false)
 
-obj_key_begin:
-#if YYJSON_IS_REAL_GCC
-    while (true) repeat16({
-        if (byte_match_2(cur, "  ")) cur += 2;
-        else break;
-    })
-#else
-    while (true) repeat16({
-        if (likely(byte_match_2(cur, "  "))) cur += 2;
-        else break;
-    })
-#endif
-    if (likely(*cur == '"')) {
-        val_incr();
-        ctn_len++;
-        if (likely(read_str(&cur, eof, flg, val, &msg))) goto obj_key_end;
-        goto fail_string;
-    }
-    if (likely(*cur == '}')) {
-        cur++;
-        if (likely(ctn_len == 0)) goto obj_end;
-        if (has_allow(TRAILING_COMMAS)) goto obj_end;
-        do { cur--; } while (*cur != ',');
-        goto fail_trailing_comma;
-    }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto obj_key_begin;
-    }
-    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
-        val_incr();
-        ctn_len++;
-        if (likely(read_str_sq(&cur, eof, flg, val, &msg))) goto obj_key_end;
-        goto fail_string;
-    }
-    if (has_allow(UNQUOTED_KEY) && char_is_id_start(*cur)) {
-        val_incr();
-        ctn_len++;
-        if (read_str_id(&cur, eof, flg, pre, val, &msg)) goto obj_key_end;
-        goto fail_string;
-    }
-    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-        if (skip_trivia(&cur, eof, flg)) goto obj_key_begin;
-        if (cur == eof) goto fail_comment;
-    }
-    goto fail_character_obj_key;
+    yyjson_read_err tmp_err;
+    yyjson_doc *doc;
+    struct stat st;
+    usize dat_len, map_len, page;
+    long page_size;
+    int fd = -1;
+    u8 *map, *dat;
 
-obj_key_end:
-    if (byte_match_2(cur, ": ")) {
-        cur += 2;
-        goto obj_val_begin;
-    }
-    if (*cur == ':') {
-        cur++;
-        goto obj_val_begin;
-    }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto obj_key_end;
-    }
-    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-        if (skip_trivia(&cur, eof, flg)) goto obj_key_end;
-        if (cur == eof) goto fail_comment;
-    }
-    goto fail_character_obj_sep;
+    if (!err) err = &tmp_err;
+    if (unlikely(!path)) return_err(INVALID_PARAMETER, "input path is NULL");
 
-obj_val_begin:
-    if (*cur == '"') {
-        val++;
-        ctn_len++;
-        if (likely(read_str(&cur, eof, flg, val, &msg))) goto obj_val_end;
-        goto fail_string;
-    }
-    if (char_is_num(*cur)) {
-        val++;
-        ctn_len++;
-        if (likely(read_num(&cur, pre, flg, val, &msg))) goto obj_val_end;
-        goto fail_number;
-    }
-    if (*cur == '{') {
-        cur++;
-        goto obj_begin;
-    }
-    if (*cur == '[') {
-        cur++;
-        goto arr_begin;
-    }
-    if (*cur == 't') {
-        val++;
-        ctn_len++;
-        if (likely(read_true(&cur, val))) goto obj_val_end;
-        goto fail_literal_true;
-    }
-    if (*cur == 'f') {
-        val++;
-        ctn_len++;
-        if (likely(read_false(&cur, val))) goto obj_val_end;
-        goto fail_literal_false;
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (unlikely(fd == -1)) return_err(FILE_OPEN, MSG_FOPEN);
+
+    /* read empty or special files (pipe, device) with the stream reader,
+       and the flags which cannot be used with zero-copy reading */
+    flg &= ~YYJSON_READ_INSITU;
+    if (flg & (YYJSON_READ_NUMBER_AS_RAW | YYJSON_READ_BIGNUM_AS_RAW |
+               YYJSON_READ_ALLOW_UNQUOTED_KEY) ||
+        fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        (u64)st.st_size >= (u64)USIZE_MAX / 2) {
+        close(fd);
+        return yyjson_read_file(path, flg, alc_ptr, err);
     }
-    if (*cur == 'n') {
-        val++;
-        ctn_len++;
-        if (likely(read_null(&cur, val))) goto obj_val_end;
-        if (has_allow(INF_AND_NAN)) {
-            if (read_nan(&cur, pre, flg, val)) goto obj_val_end;
+
+    /*
+     The mapping is read-only, the zero-copy reader never writes the input, so
+     the pages are shared with the page cache. The rest of the last page after
+     the file is zero-filled and used as the padding. If there's not enough
+     room for the padding, an anonymous zero-filled mapping is reserved first
+     and the file is mapped over it.
+     */
+    page_size = sysconf(_SC_PAGESIZE);
+    page = page_size > 0 ? (usize)page_size : 4096;
+    dat_len = (usize)st.st_size;
+    map_len = size_align_up(dat_len + YYJSON_PADDING_SIZE, page);
+    if (map_len == size_align_up(dat_len, page)) {
+        map = (u8 *)mmap(NULL, dat_len, PROT_READ, YYJSON_MAP_FILE, fd, 0);
+    } else {
+#if defined(MAP_ANONYMOUS) && defined(MAP_FIXED)
+        map = (u8 *)mmap(NULL, map_len, PROT_READ,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if ((void *)map != MAP_FAILED) {
+            dat = (u8 *)mmap(map, dat_len, PROT_READ,
+                             YYJSON_MAP_FILE | MAP_FIXED, fd, 0);
+            if (unlikely((void *)dat == MAP_FAILED)) {
+                munmap(map, map_len);
+                map = (u8 *)MAP_FAILED;
+            }
         }
-        goto fail_literal_null;
-    }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto obj_val_begin;
-    }
-    if (has_allow(INF_AND_NAN) &&
-        (*cur == 'i' || *cur == 'I' || *cur == 'N')) {
-        val++;
-        ctn_len++;
-        if (read_inf_or_nan(&cur, pre, flg, val)) goto obj_val_end;
-        goto fail_character_val;
-    }
-    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
-        val++;
-        ctn_len++;
-        if (likely(read_str_sq(&cur, eof, flg, val, &msg))) goto obj_val_end;
-        goto fail_string;
+#else
+        map = (u8 *)MAP_FAILED;
+#endif
     }
-    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-        if (skip_trivia(&cur, eof, flg)) goto obj_val_begin;
-        if (cur == eof) goto fail_comment;
+    close(fd);
+    fd = -1;
+    if (unlikely((void *)map == MAP_FAILED)) {
+        return yyjson_read_file(path, flg, alc_ptr, err);
     }
-    goto fail_character_val;
 
-obj_val_end:
-    if (byte_match_2(cur, ",\n")) {
-        cur += 2;
-        goto obj_key_begin;
-    }
-    if (likely(*cur == ',')) {
-        cur++;
-        goto obj_key_begin;
+#if defined(MADV_SEQUENTIAL) && defined(MADV_NORMAL)
+    madvise(map, dat_len, MADV_SEQUENTIAL);
+#endif
+    flg |= YYJSON_READ_ZERO_COPY;
+    doc = yyjson_read_opts((char *)map, dat_len, flg, alc_ptr, err);
+#if defined(MADV_SEQUENTIAL) && defined(MADV_NORMAL)
+    if (doc) madvise(map, dat_len, MADV_NORMAL);
+#endif
+    if (unlikely(!doc)) {
+        munmap(map, map_len);
+        return NULL;
     }
-    if (likely(*cur == '}')) {
-        cur++;
-        goto obj_end;
+    doc->ext.map = (void *)map;
+    doc->ext.map_len = map_len;
+    return doc;
+
+#undef return_err
+#else
+    return yyjson_read_file(path, flg, alc_ptr, err);
+#endif
+}
+
+#endif /* !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE */
+
+const char *yyjson_read_number(const char *dat,
+                               yyjson_val *val,
+                               yyjson_read_flag flg,
+                               const yyjson_alc *alc,
+                               yyjson_read_err *err) {
+#define return_err(_pos, _code, _msg) do { \
+    err->pos = _pos > hdr ? (usize)(_pos - hdr) : 0; \
+    err->msg = _msg; \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    return NULL; \
+} while (false)
+
+    u8 *hdr = constcast(u8 *)dat, *cur = hdr;
+    u8 raw_end[1]; /* raw end for null-terminator */
+    u8 *raw_ptr = raw_end;
+    u8 **pre = &raw_ptr; /* previous raw end pointer */
+    const char *msg;
+    yyjson_read_err tmp_err;
+
+#if YYJSON_DISABLE_FAST_FP_CONV
+    u8 buf[128];
+    usize dat_len;
+#endif
+
+    if (!err) err = &tmp_err;
+    if (unlikely(!dat)) {
+        return_err(cur, INVALID_PARAMETER, "input data is NULL");
     }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto obj_val_end;
+    if (unlikely(!val)) {
+        return_err(cur, INVALID_PARAMETER, "output value is NULL");
     }
-    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-        if (skip_trivia(&cur, eof, flg)) goto obj_val_end;
-        if (cur == eof) goto fail_comment;
+
+#if YYJSON_DISABLE_FAST_FP_CONV
+    if (!alc) alc = &YYJSON_DEFAULT_ALC;
+    dat_len = strlen(dat);
+    if (dat_len < sizeof(buf)) {
+        memcpy(buf, dat, dat_len + 1);
+        hdr = buf;
+        cur = hdr;
+    } else {
+        hdr = (u8 *)alc->malloc(alc->ctx, dat_len + 1);
+        cur = hdr;
+        if (unlikely(!hdr)) {
+            return_err(cur, MEMORY_ALLOCATION, MSG_MALLOC);
+        }
+        memcpy(hdr, dat, dat_len + 1);
     }
-    goto fail_character_obj_end;
-
-obj_end:
-#if YYJSON_READER_DEPTH_LIMIT
-    container_depth--;
+    hdr[dat_len] = 0;
 #endif
 
-    /* pop container */
-    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
-    /* point to the next value */
-    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
-    ctn->tag = (ctn_len << (YYJSON_TAG_BIT - 1)) | YYJSON_TYPE_OBJ;
-    if (unlikely(ctn == ctn_parent)) goto doc_end;
-    ctn = ctn_parent;
-    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
-    if (*cur == '\n') cur++;
-    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
-        goto obj_val_end;
-    } else {
-        goto arr_val_end;
+#if YYJSON_DISABLE_FAST_FP_CONV
+    if (!read_num(&cur, hdr + dat_len, pre, flg, val, &msg)) {
+        if (dat_len >= sizeof(buf)) alc->free(alc->ctx, hdr);
+        return_err(cur, INVALID_NUMBER, msg);
     }
-
-doc_end:
-    /* check invalid contents after json document */
-    if (unlikely(cur < eof) && !has_flg(STOP_WHEN_DONE)) {
-        while (char_is_space(*cur)) cur++;
-        if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-            if (!skip_trivia(&cur, eof, flg) && cur == eof) {
-                goto fail_comment;
-            }
-        }
-        if (unlikely(cur < eof)) goto fail_garbage;
+    if (dat_len >= sizeof(buf)) alc->free(alc->ctx, hdr);
+    if (yyjson_is_raw(val)) val->uni.str = dat;
+    return dat + (cur - hdr);
+#else
+    /* the input length is unknown, so the digits are read one by one */
+    if (!read_num(&cur, cur, pre, flg, val, &msg)) {
+        return_err(cur, INVALID_NUMBER, msg);
     }
+    return (const char *)cur;
+#endif
 
-    **pre = '\0';
-    doc = (yyjson_doc *)val_hdr;
-    doc->root = val_hdr + hdr_len;
-    doc->alc = alc;
-    doc->dat_read = (usize)(cur - hdr);
-    doc->val_read = (usize)((val - doc->root) + 1);
-    doc->str_pool = has_flg(INSITU) ? NULL : (char *)hdr;
-    return doc;
+#undef return_err
+}
 
-fail_string:            return_err(cur, INVALID_STRING, msg);
-fail_number:            return_err(cur, INVALID_NUMBER, msg);
-fail_alloc:             return_err(cur, MEMORY_ALLOCATION, MSG_MALLOC);
-fail_trailing_comma:    return_err(cur, JSON_STRUCTURE, MSG_COMMA);
-fail_literal_true:      return_err(cur, LITERAL, MSG_CHAR_T);
-fail_literal_false:     return_err(cur, LITERAL, MSG_CHAR_F);
-fail_literal_null:      return_err(cur, LITERAL, MSG_CHAR_N);
-fail_character_val:     return_err(cur, UNEXPECTED_CHARACTER, MSG_CHAR);
-fail_character_arr_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_ARR_END);
-fail_character_obj_key: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_KEY);
-fail_character_obj_sep: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_SEP);
-fail_character_obj_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_END);
-fail_comment:           return_err(cur, INVALID_COMMENT, MSG_COMMENT);
-fail_garbage:           return_err(cur, UNEXPECTED_CONTENT, MSG_GARBAGE);
-fail_depth:             return_err(cur, DEPTH, MSG_DEPTH);
+#if YYJSON_MUT_COMPACT
+const char *yyjson_mut_read_number(const char *dat,
+                                   yyjson_mut_val *val,
+                                   yyjson_read_flag flg,
+                                   const yyjson_alc *alc,
+                                   yyjson_read_err *err) {
+    yyjson_val num;
+    yyjson_read_err tmp_err;
+    const char *end;
 
-#undef val_incr
-#undef return_err
+    if (!err) err = &tmp_err;
+    end = yyjson_read_number(dat, val ? &num : NULL, flg, alc, err);
+    if (unlikely(!end)) return NULL;
+    if (unsafe_yyjson_is_raw(&num)) {
+        if (unlikely(!unsafe_yyjson_mut_set_raw(val, num.uni.str,
+                                                unsafe_yyjson_get_len(&num)))) {
+            err->pos = 0;
+            err->msg = MSG_MALLOC;
+            err->code = YYJSON_READ_ERROR_MEMORY_ALLOCATION;
+            return NULL;
+        }
+    } else {
+        unsafe_yyjson_mut_set_tag(val, unsafe_yyjson_get_type(&num),
+                                  unsafe_yyjson_get_subtype(&num), 0);
+        val->uni = num.uni;
+    }
+    return end;
 }
+#endif
 
 
 
 /*==============================================================================
- * MARK: - JSON Reader (Public)
+ * MARK: - Incremental JSON Reader (Public)
  *============================================================================*/
 
-yyjson_doc *yyjson_read_opts(char *dat, usize len,
-                             yyjson_read_flag flg,
-                             const yyjson_alc *alc_ptr,
+#if !YYJSON_DISABLE_INCR_READER
+
+/* labels within yyjson_incr_read() to resume incremental parsing */
+#define LABEL_doc_begin     0
+#define LABEL_arr_val_begin 1
+#define LABEL_arr_val_end   2
+#define LABEL_obj_key_begin 3
+#define LABEL_obj_key_end   4
+#define LABEL_obj_val_begin 5
+#define LABEL_obj_val_end   6
+#define LABEL_doc_end       7
+
+/** State for incremental JSON reader, opaque in the API. */
+struct yyjson_incr_state {
+    u32 label; /* current parser goto label */
+    yyjson_alc alc; /* allocator */
+    yyjson_read_flag flg; /* read flags */
+    u8 *hdr; /* JSON data header */
+    u8 *cur; /* current position in JSON data */
+    usize buf_len; /* total buffer length (without padding) */
+    usize hdr_len; /* value count used by yyjson_doc */
+    usize alc_len; /* value count allocated */
+    usize ctn_len; /* the number of elements in current container */
+    yyjson_val *val_hdr; /* the head of allocated values */
+    yyjson_val *val_end; /* the end of allocated values */
+    yyjson_val *val; /* current JSON value */
+    yyjson_val *ctn; /* current container */
+    u8 *str_con[2]; /* string parser incremental state */
+    u8 *raw_ptr; /* pending position for a deferred raw null-terminator */
+    u8 raw_end[1]; /* dummy target for the first deferred null-terminator */
+};
+
+yyjson_incr_state *yyjson_incr_new(char *buf, size_t buf_len,
+                                   yyjson_read_flag flg,
+                                   const yyjson_alc *alc_ptr) {
+    yyjson_incr_state *state = NULL;
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+
+    /* remove non-standard flags */
+    flg &= ~YYJSON_READ_JSON5;
+    flg &= ~YYJSON_READ_ALLOW_BOM;
+    flg &= ~YYJSON_READ_ALLOW_INVALID_UNICODE;
+
+    if (unlikely(!buf)) return NULL;
+    if (unlikely(buf_len >= USIZE_MAX - YYJSON_PADDING_SIZE)) return NULL;
+    state = (yyjson_incr_state *)alc.malloc(alc.ctx, sizeof(*state));
+    if (!state) return NULL;
+    memset(state, 0, sizeof(yyjson_incr_state));
+    state->alc = alc;
+    state->flg = flg;
+    state->buf_len = buf_len;
+
+    /* add 4-byte zero padding for input data if necessary */
+    if (has_flg(INSITU)) {
+        state->hdr = (u8 *)buf;
+    } else {
+        state->hdr = (u8 *)alc.malloc(alc.ctx, buf_len + YYJSON_PADDING_SIZE);
+        if (unlikely(!state->hdr)) {
+            alc.free(alc.ctx, state);
+            return NULL;
+        }
+        memcpy(state->hdr, buf, buf_len);
+    }
+    memset(state->hdr + buf_len, 0, YYJSON_PADDING_SIZE);
+    state->cur = state->hdr;
+    state->raw_ptr = state->raw_end;
+    state->label = LABEL_doc_begin;
+    return state;
+}
+
+void yyjson_incr_free(yyjson_incr_state *state) {
+    if (state) {
+        yyjson_alc alc = state->alc;
+        memset(&state->alc, 0, sizeof(alc));
+        if (state->val_hdr) {
+            alc.free(alc.ctx, (void *)state->val_hdr);
+        }
+        if (state->hdr && !(state->flg & YYJSON_READ_INSITU)) {
+            alc.free(alc.ctx, state->hdr);
+        }
+        alc.free(alc.ctx, state);
+    }
+}
+
+yyjson_doc *yyjson_incr_read(yyjson_incr_state *state, size_t len,
                              yyjson_read_err *err) {
-#define return_err(_pos, _code, _msg) do { \
-    err->pos = (usize)(_pos); \
+#define return_err_inv_param(_msg) do { \
+    err->pos = 0; \
     err->msg = _msg; \
-    err->code = YYJSON_READ_ERROR_##_code; \
-    if (!has_flg(INSITU) && hdr) alc.free(alc.ctx, (void *)hdr); \
+    err->code = YYJSON_READ_ERROR_INVALID_PARAMETER; \
+    return NULL; \
+} while (false)
+
+#define return_err(_pos, _code, _msg) do { \
+    if (is_truncated_end(hdr, _pos, end, YYJSON_READ_ERROR_##_code, flg)) { \
+        goto unexpected_end; \
+    } else { \
+        err->pos = (usize)(_pos - hdr); \
+        err->code = YYJSON_READ_ERROR_##_code; \
+        err->msg = _msg; \
+    } \
     return NULL; \
 } while (false)
 
+#define val_incr() do { \
+    val++; \
+    if (unlikely(val >= val_end)) { \
+        usize alc_old = alc_len; \
+        alc_len += alc_len / 2; \
+        if ((sizeof(usize) < 8) && (alc_len >= alc_max)) goto fail_alloc; \
+        val_tmp = (yyjson_val *)alc.realloc(alc.ctx, (void *)val_hdr, \
+                                            alc_old * sizeof(yyjson_val), \
+                                            alc_len * sizeof(yyjson_val)); \
+        if ((!val_tmp)) goto fail_alloc; \
+        val = val_tmp + (usize)(val - val_hdr); \
+        ctn = val_tmp + (usize)(ctn - val_hdr); \
+        state->val = val_tmp + (usize)(state->val - val_hdr); \
+        state->val_hdr = val_hdr = val_tmp; \
+        val_end = val_tmp + (alc_len - 2); \
+        state->val_end = val_end; \
+    } \
+} while (false)
+
+    /* save position where it's possible to resume incremental parsing */
+#define save_incr_state(_label) do { \
+    state->label = LABEL_##_label; \
+    state->cur = cur; \
+    state->val = val; \
+    state->ctn_len = ctn_len; \
+    state->hdr_len = hdr_len; \
+    state->raw_ptr = raw_ptr; \
+    if (unlikely(cur >= end)) goto unexpected_end; \
+} while (false)
+
+#define check_maybe_truncated_number() do { \
+    if (unlikely(cur >= end)) { \
+        if (unlikely(cur > state->cur + INCR_NUM_MAX_LEN)) { \
+            msg = "number too long"; \
+            goto fail_number; \
+        } \
+        goto unexpected_end; \
+    } \
+} while (false)
+
+    u8 *hdr = NULL, *end = NULL, *cur = NULL;
+    yyjson_read_flag flg;
+    yyjson_alc alc;
+    usize dat_len; /* data length in bytes, hint for allocator */
+    usize hdr_len; /* value count used by yyjson_doc */
+    usize alc_len; /* value count allocated */
+    usize alc_max; /* maximum value count for allocator */
+    usize ctn_len; /* the number of elements in current container */
+    yyjson_val *val_hdr; /* the head of allocated values */
+    yyjson_val *val_end; /* the end of allocated values */
+    yyjson_val *val_tmp; /* temporary pointer for realloc */
+    yyjson_val *val; /* current JSON value */
+    yyjson_val *ctn; /* current container */
+    yyjson_val *ctn_parent; /* parent of current container */
+    yyjson_doc *doc; /* the JSON document, equals to val_hdr */
+    const char *msg; /* error message */
+
     yyjson_read_err tmp_err;
-    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
-    yyjson_doc *doc;
-    u8 *hdr = NULL, *eof, *cur;
+    u8 *raw_ptr; /* deferred raw null-terminator position, committed at save */
+    u8 **pre = &raw_ptr; /* previous raw end pointer */
+    u8 **con = NULL; /* for incremental string parsing */
+    u8 saved_end = '\0'; /* saved end char */
 
-    /* validate input parameters */
-    if (!err) err = &tmp_err;
-    if (unlikely(!dat)) return_err(0, INVALID_PARAMETER, "input data is NULL");
-    if (unlikely(!len)) return_err(0, INVALID_PARAMETER, "input length is 0");
+#if YYJSON_READER_DEPTH_LIMIT
+    u32 container_depth = 0; /* current array/object depth */
+#endif
 
-    /* add 4-byte zero padding for input data if necessary */
-    if (has_flg(INSITU)) {
-        hdr = (u8 *)dat;
-        eof = (u8 *)dat + len;
-        cur = (u8 *)dat;
-    } else {
-        if (unlikely(len >= USIZE_MAX - YYJSON_PADDING_SIZE)) {
-            return_err(0, MEMORY_ALLOCATION, MSG_MALLOC);
-        }
-        hdr = (u8 *)alc.malloc(alc.ctx, len + YYJSON_PADDING_SIZE);
-        if (unlikely(!hdr)) {
-            return_err(0, MEMORY_ALLOCATION, MSG_MALLOC);
-        }
-        eof = hdr + len;
-        cur = hdr;
-        memcpy(hdr, dat, len);
+    /* validate input parameters */
+    if (!err) err = &tmp_err;
+    if (unlikely(!state)) {
+        return_err_inv_param("input state is NULL");
+    }
+    if (unlikely(!len)) {
+        return_err_inv_param("input length is 0");
+    }
+    if (unlikely(len > state->buf_len)) {
+        return_err_inv_param("length is greater than total input length");
     }
-    memset(eof, 0, YYJSON_PADDING_SIZE);
 
-    if (has_allow(BOM)) {
-        if (len >= 3 && is_utf8_bom(cur)) cur += 3;
+    /* restore state saved from the previous call */
+    hdr = state->hdr;
+    end = state->hdr + len;
+    cur = state->cur;
+    flg = state->flg;
+    alc = state->alc;
+    ctn_len = state->ctn_len;
+    hdr_len = state->hdr_len;
+    alc_len = state->alc_len;
+    val = state->val;
+    val_hdr = state->val_hdr;
+    val_end = state->val_end;
+    ctn = state->ctn;
+    con = state->str_con;
+    raw_ptr = state->raw_ptr;
+    alc_max = USIZE_MAX / sizeof(yyjson_val);
+
+    /* insert null terminator to make us stop at the specified end, even if
+       the data contains more valid JSON */
+    saved_end = *end;
+    *end = '\0';
+
+    /* resume parsing from the last save point */
+    switch (state->label) {
+    case LABEL_doc_begin: goto doc_begin;
+    case LABEL_arr_val_begin: goto arr_val_begin;
+    case LABEL_arr_val_end: goto arr_val_end;
+    case LABEL_obj_key_begin: goto obj_key_begin;
+    case LABEL_obj_key_end: goto obj_key_end;
+    case LABEL_obj_val_begin: goto obj_val_begin;
+    case LABEL_obj_val_end: goto obj_val_end;
+    case LABEL_doc_end: goto doc_end;
+    default: return_err_inv_param("invalid incremental state");
     }
 
+doc_begin:
     /* skip empty contents before json document */
     if (unlikely(!char_is_ctn(*cur))) {
         while (char_is_space(*cur)) cur++;
-        if (unlikely(!char_is_ctn(*cur))) {
-            if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
-                if (!skip_trivia(&cur, eof, flg) && cur == eof) {
-                    return_err(cur - hdr, INVALID_COMMENT, MSG_COMMENT);
-                }
-            }
-        }
-        if (unlikely(cur >= eof)) {
-            return_err(0, EMPTY_CONTENT, "input data is empty");
-        }
+        if (unlikely(cur >= end)) goto unexpected_end; /* input data is empty */
     }
 
-    /* read json document */
-    if (likely(char_is_ctn(*cur))) {
-        if (char_is_space(cur[1]) && char_is_space(cur[2])) {
-            doc = read_root_pretty(hdr, cur, eof, alc, flg, err);
+    /* allocate memory for document */
+    if (!val_hdr) {
+        hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
+        hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
+        if (likely(char_is_ctn(*cur))) {
+            dat_len = has_flg(STOP_WHEN_DONE) ? 256 : state->buf_len;
+            alc_len = hdr_len +
+                    (dat_len / YYJSON_READER_ESTIMATED_MINIFY_RATIO) + 4;
+            alc_len = yyjson_min(alc_len, alc_max);
         } else {
-            doc = read_root_minify(hdr, cur, eof, alc, flg, err);
+            alc_len = hdr_len + 1; /* single value */
         }
-    } else {
-        doc = read_root_single(hdr, cur, eof, alc, flg, err);
+        val_hdr = (yyjson_val *)alc.malloc(alc.ctx,
+                                           alc_len * sizeof(yyjson_val));
+        if (unlikely(!val_hdr)) goto fail_alloc;
+        val_end = val_hdr + (alc_len - 2); /* padding for kv pair reading */
+        val = val_hdr + hdr_len;
+        ctn = val;
+        ctn_len = 0;
+        state->val_hdr = val_hdr;
+        state->val_end = val_end;
+        save_incr_state(doc_begin);
     }
 
-    /* check result */
-    if (likely(doc)) {
-        memset(err, 0, sizeof(yyjson_read_err));
-    } else {
-        /* RFC 8259: JSON text MUST be encoded using UTF-8 */
-        if (err->pos == 0 && err->code != YYJSON_READ_ERROR_MEMORY_ALLOCATION) {
-            if (is_utf8_bom(hdr)) err->msg = MSG_ERR_BOM;
-            else if (len >= 4 && is_utf32_bom(hdr)) err->msg = MSG_ERR_UTF32;
-            else if (len >= 2 && is_utf16_bom(hdr)) err->msg = MSG_ERR_UTF16;
+    /* read json document */
+    if (*cur == '{') {
+        cur++;
+        ctn->tag = YYJSON_TYPE_OBJ;
+        ctn->uni.ofs = 0;
+        goto obj_key_begin;
+    }
+    if (*cur == '[') {
+        cur++;
+        ctn->tag = YYJSON_TYPE_ARR;
+        ctn->uni.ofs = 0;
+        goto arr_val_begin;
+    }
+    if (char_is_num(*cur)) {
+        if (likely(read_num(&cur, end, pre, flg, val, &msg))) {
+            /* a root number may continue with more digits in a later chunk */
+            if (unlikely(len < state->buf_len)) check_maybe_truncated_number();
+            goto doc_end;
         }
-        if (!has_flg(INSITU)) alc.free(alc.ctx, hdr);
+        goto fail_number;
+    }
+    if (*cur == '"') {
+        if (likely(read_str_con(&cur, end, flg, val, &msg, con))) goto doc_end;
+        goto fail_string;
+    }
+    if (*cur == 't') {
+        if (likely(read_true(&cur, val))) goto doc_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        if (likely(read_false(&cur, val))) goto doc_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        if (likely(read_null(&cur, val))) goto doc_end;
+        goto fail_literal_null;
     }
-    return doc;
-
-#undef return_err
-}
-
-#if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
-
-yyjson_doc *yyjson_read_file(const char *path,
-                             yyjson_read_flag flg,
-                             const yyjson_alc *alc_ptr,
-                             yyjson_read_err *err) {
-#define return_err(_code, _msg) do { \
-    err->pos = 0; \
-    err->msg = _msg; \
-    err->code = YYJSON_READ_ERROR_##_code; \
-    return NULL; \
-} while (false)
-
-    yyjson_read_err tmp_err;
-    yyjson_doc *doc;
-    FILE *file;
-
-    if (!err) err = &tmp_err;
-    if (unlikely(!path)) return_err(INVALID_PARAMETER, "input path is NULL");
 
-    file = fopen_readonly(path);
-    if (unlikely(!file)) return_err(FILE_OPEN, MSG_FREAD);
+    msg = "unexpected character, expected a valid root value";
+    if (cur == hdr) {
+        /* RFC 8259: JSON text MUST be encoded using UTF-8 */
+        if (is_utf8_bom(hdr)) msg = MSG_ERR_BOM;
+        else if (len >= 4 && is_utf32_bom(hdr)) msg = MSG_ERR_UTF32;
+        else if (len >= 2 && is_utf16_bom(hdr)) msg = MSG_ERR_UTF16;
+    }
+    return_err(cur, UNEXPECTED_CHARACTER, msg);
 
-    doc = yyjson_read_fp(file, flg, alc_ptr, err);
-    fclose(file);
-    return doc;
+arr_begin:
+#if YYJSON_READER_DEPTH_LIMIT
+    container_depth++;
+    if (unlikely(container_depth >= YYJSON_READER_DEPTH_LIMIT)) {
+        goto fail_depth;
+    }
+#endif
 
-#undef return_err
-}
+    /* save current container */
+    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
+               (ctn->tag & YYJSON_TAG_MASK);
 
-yyjson_doc *yyjson_read_fp(FILE *file,
-                           yyjson_read_flag flg,
-                           const yyjson_alc *alc_ptr,
-                           yyjson_read_err *err) {
-#define return_err(_code, _msg) do { \
-    err->pos = 0; \
-    err->msg = _msg; \
-    err->code = YYJSON_READ_ERROR_##_code; \
-    if (buf) alc.free(alc.ctx, buf); \
-    return NULL; \
-} while (false)
+    /* create a new array value, save parent container offset */
+    val_incr();
+    val->tag = YYJSON_TYPE_ARR;
+    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
 
-    yyjson_read_err tmp_err;
-    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
-    yyjson_doc *doc;
+    /* push the new array value as current container */
+    ctn = val;
+    ctn_len = 0;
 
-    long file_size = 0, file_pos;
-    void *buf = NULL;
-    usize buf_size = 0;
-    usize dat_size = 0;
+arr_val_begin:
+    save_incr_state(arr_val_begin);
+arr_val_continue:
+    if (*cur == '{') {
+        cur++;
+        goto obj_begin;
+    }
+    if (*cur == '[') {
+        cur++;
+        goto arr_begin;
+    }
+    if (char_is_num(*cur)) {
+        val_incr();
+        ctn_len++;
+        if (likely(read_num(&cur, end, pre, flg, val, &msg))) {
+            goto arr_val_maybe_end;
+        }
+        goto fail_number;
+    }
+    if (*cur == '"') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_str_con(&cur, end, flg, val, &msg, con)))
+            goto arr_val_end;
+        goto fail_string;
+    }
+    if (*cur == 't') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_true(&cur, val))) goto arr_val_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_false(&cur, val))) goto arr_val_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        val_incr();
+        ctn_len++;
+        if (likely(read_null(&cur, val))) goto arr_val_end;
+        goto fail_literal_null;
+    }
+    if (*cur == ']') {
+        cur++;
+        if (likely(ctn_len == 0)) goto arr_end;
+        do { cur--; } while (*cur != ',');
+        goto fail_trailing_comma;
+    }
+    if (char_is_space(*cur)) {
+        while (char_is_space(*++cur));
+        goto arr_val_continue;
+    }
+    goto fail_character_val;
 
-    /* validate input parameters */
-    if (!err) err = &tmp_err;
-    if (unlikely(!file)) return_err(INVALID_PARAMETER, "input file is NULL");
+arr_val_maybe_end:
+    /* if incremental parsing stops in the middle of a number, it may continue
+       with more digits, so arr val maybe didn't end yet */
+    check_maybe_truncated_number();
 
-    /* get current position */
-    file_pos = ftell(file);
-    if (file_pos != -1) {
-        /* get total file size, may fail */
-        if (fseek(file, 0, SEEK_END) == 0) {
-            file_size = ftell(file);
-            if (file_size == -1) file_size = 0;
-        }
-        /* reset to original position, may fail */
-        if (fseek(file, file_pos, SEEK_SET) != 0) file_size = 0;
-        /* get file size from current position to end */
-        if (file_size > 0) file_size -= file_pos;
+arr_val_end:
+    save_incr_state(arr_val_end);
+    if (*cur == ',') {
+        cur++;
+        goto arr_val_begin;
+    }
+    if (*cur == ']') {
+        cur++;
+        goto arr_end;
+    }
+    if (char_is_space(*cur)) {
+        while (char_is_space(*++cur));
+        goto arr_val_end;
     }
+    goto fail_character_arr_end;
 
-    /* read file */
-    if (file_size > 0) {
-        /* read the entire file in one call */
-        dat_size = (usize)file_size;
-        buf_size = dat_size + YYJSON_PADDING_SIZE;
-        buf = alc.malloc(alc.ctx, buf_size);
-        if (buf == NULL) {
-            return_err(MEMORY_ALLOCATION, MSG_MALLOC);
-        }
-        if (fread_safe(buf, dat_size, file) != dat_size) {
-            return_err(FILE_READ, MSG_FREAD);
-        }
-    } else {
-        /* failed to get file size, read it as a stream */
-        usize chunk_min = (usize)64;
-        usize chunk_max = (usize)512 * 1024 * 1024;
-        usize chunk_now = chunk_min;
-        usize read_size;
-        void *tmp;
+arr_end:
+#if YYJSON_READER_DEPTH_LIMIT
+    container_depth--;
+#endif
+    /* get parent container */
+    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
 
-        buf_size = YYJSON_PADDING_SIZE;
-        while (true) {
-            if (buf_size + chunk_now < buf_size) { /* overflow */
-                return_err(MEMORY_ALLOCATION, MSG_MALLOC);
-            }
-            buf_size += chunk_now;
-            if (!buf) {
-                buf = alc.malloc(alc.ctx, buf_size);
-                if (!buf) return_err(MEMORY_ALLOCATION, MSG_MALLOC);
-            } else {
-                tmp = alc.realloc(alc.ctx, buf, buf_size - chunk_now, buf_size);
-                if (!tmp) return_err(MEMORY_ALLOCATION, MSG_MALLOC);
-                buf = tmp;
-            }
-            tmp = ((u8 *)buf) + buf_size - YYJSON_PADDING_SIZE - chunk_now;
-            read_size = fread_safe(tmp, chunk_now, file);
-            dat_size += read_size;
-            if (read_size != chunk_now) break;
+    /* save the next sibling value offset */
+    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
+    ctn->tag = ((ctn_len) << YYJSON_TAG_BIT) | YYJSON_TYPE_ARR;
+    if (unlikely(ctn == ctn_parent)) goto doc_end;
 
-            chunk_now *= 2;
-            if (chunk_now > chunk_max) chunk_now = chunk_max;
-        }
+    /* pop parent as current container */
+    ctn = ctn_parent;
+    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
+    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
+        goto obj_val_end;
+    } else {
+        goto arr_val_end;
     }
 
-    /* read JSON */
-    memset((u8 *)buf + dat_size, 0, YYJSON_PADDING_SIZE);
-    flg |= YYJSON_READ_INSITU;
-    doc = yyjson_read_opts((char *)buf, dat_size, flg, &alc, err);
-    if (doc) {
-        doc->str_pool = (char *)buf;
-        return doc;
-    } else {
-        alc.free(alc.ctx, buf);
-        return NULL;
+obj_begin:
+#if YYJSON_READER_DEPTH_LIMIT
+    container_depth++;
+    if (unlikely(container_depth >= YYJSON_READER_DEPTH_LIMIT)) {
+        goto fail_depth;
     }
+#endif
 
-#undef return_err
-}
+    /* push container */
+    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
+               (ctn->tag & YYJSON_TAG_MASK);
+    val_incr();
+    val->tag = YYJSON_TYPE_OBJ;
+    /* offset to the parent */
+    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
+    ctn = val;
+    ctn_len = 0;
 
-#endif /* !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE */
+obj_key_begin:
+    save_incr_state(obj_key_begin);
+obj_key_continue:
+    if (likely(*cur == '"')) {
+        val_incr();
+        ctn_len++;
+        if (likely(read_str_con(&cur, end, flg, val, &msg, con)))
+            goto obj_key_end;
+        goto fail_string;
+    }
+    if (likely(*cur == '}')) {
+        cur++;
+        if (likely(ctn_len == 0)) goto obj_end;
+        do { cur--; } while (*cur != ',');
+        goto fail_trailing_comma;
+    }
+    if (char_is_space(*cur)) {
+        while (char_is_space(*++cur));
+        goto obj_key_continue;
+    }
+    goto fail_character_obj_key;
 
-const char *yyjson_read_number(const char *dat,
-                               yyjson_val *val,
-                               yyjson_read_flag flg,
-                               const yyjson_alc *alc,
-                               yyjson_read_err *err) {
-#define return_err(_pos, _code, _msg) do { \
-    err->pos = _pos > hdr ? (usize)(_pos - hdr) : 0; \
-    err->msg = _msg; \
-    err->code = YYJSON_READ_ERROR_##_code; \
-    return NULL; \
-} while (false)
+obj_key_end:
+    save_incr_state(obj_key_end);
+    if (*cur == ':') {
+        cur++;
+        goto obj_val_begin;
+    }
+    if (char_is_space(*cur)) {
+        while (char_is_space(*++cur));
+        goto obj_key_end;
+    }
+    goto fail_character_obj_sep;
 
-    u8 *hdr = constcast(u8 *)dat, *cur = hdr;
-    u8 raw_end[1]; /* raw end for null-terminator */
-    u8 *raw_ptr = raw_end;
-    u8 **pre = &raw_ptr; /* previous raw end pointer */
-    const char *msg;
-    yyjson_read_err tmp_err;
+obj_val_begin:
+    save_incr_state(obj_val_begin);
+obj_val_continue:
+    if (*cur == '"') {
+        val++;
+        ctn_len++;
+        if (likely(read_str_con(&cur, end, flg, val, &msg, con)))
+            goto obj_val_end;
+        goto fail_string;
+    }
+    if (char_is_num(*cur)) {
+        val++;
+        ctn_len++;
+        if (likely(read_num(&cur, end, pre, flg, val, &msg))) {
+            goto obj_val_maybe_end;
+        }
+        goto fail_number;
+    }
+    if (*cur == '{') {
+        cur++;
+        goto obj_begin;
+    }
+    if (*cur == '[') {
+        cur++;
+        goto arr_begin;
+    }
+    if (*cur == 't') {
+        val++;
+        ctn_len++;
+        if (likely(read_true(&cur, val))) goto obj_val_end;
+        goto fail_literal_true;
+    }
+    if (*cur == 'f') {
+        val++;
+        ctn_len++;
+        if (likely(read_false(&cur, val))) goto obj_val_end;
+        goto fail_literal_false;
+    }
+    if (*cur == 'n') {
+        val++;
+        ctn_len++;
+        if (likely(read_null(&cur, val))) goto obj_val_end;
+        goto fail_literal_null;
+    }
+    if (char_is_space(*cur)) {
+        while (char_is_space(*++cur));
+        goto obj_val_continue;
+    }
+    goto fail_character_val;
 
-#if YYJSON_DISABLE_FAST_FP_CONV
-    u8 buf[128];
-    usize dat_len;
-#endif
+obj_val_maybe_end:
+    /* if incremental parsing stops in the middle of a number, it may continue
+       with more digits, so obj val maybe didn't end yet */
+    check_maybe_truncated_number();
 
-    if (!err) err = &tmp_err;
-    if (unlikely(!dat)) {
-        return_err(cur, INVALID_PARAMETER, "input data is NULL");
+obj_val_end:
+    save_incr_state(obj_val_end);
+    if (likely(*cur == ',')) {
+        cur++;
+        goto obj_key_begin;
     }
-    if (unlikely(!val)) {
-        return_err(cur, INVALID_PARAMETER, "output value is NULL");
+    if (likely(*cur == '}')) {
+        cur++;
+        goto obj_end;
     }
+    if (char_is_space(*cur)) {
+        while (char_is_space(*++cur));
+        goto obj_val_end;
+    }
+    goto fail_character_obj_end;
+
+obj_end:
+#if YYJSON_READER_DEPTH_LIMIT
+    container_depth--;
+#endif
 
-#if YYJSON_DISABLE_FAST_FP_CONV
-    if (!alc) alc = &YYJSON_DEFAULT_ALC;
-    dat_len = strlen(dat);
-    if (dat_len < sizeof(buf)) {
-        memcpy(buf, dat, dat_len + 1);
-        hdr = buf;
-        cur = hdr;
+    /* pop container */
+    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
+    /* point to the next value */
+    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
+    ctn->tag = (ctn_len << (YYJSON_TAG_BIT - 1)) | YYJSON_TYPE_OBJ;
+    if (unlikely(ctn == ctn_parent)) goto doc_end;
+    ctn = ctn_parent;
+    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
+    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
+        goto obj_val_end;
     } else {
-        hdr = (u8 *)alc->malloc(alc->ctx, dat_len + 1);
-        cur = hdr;
-        if (unlikely(!hdr)) {
-            return_err(cur, MEMORY_ALLOCATION, MSG_MALLOC);
-        }
-        memcpy(hdr, dat, dat_len + 1);
+        goto arr_val_end;
     }
-    hdr[dat_len] = 0;
-#endif
 
-#if YYJSON_DISABLE_FAST_FP_CONV
-    if (!read_num(&cur, pre, flg, val, &msg)) {
-        if (dat_len >= sizeof(buf)) alc->free(alc->ctx, hdr);
-        return_err(cur, INVALID_NUMBER, msg);
+doc_end:
+    /* check invalid contents after json document */
+    if (unlikely(cur < end || len < state->buf_len) &&
+        !has_flg(STOP_WHEN_DONE)) {
+        save_incr_state(doc_end);
+        while (char_is_space(*cur)) cur++;
+        if (unlikely(cur < end)) goto fail_garbage;
+        /* the document is complete for the bytes seen so far, but more input
+           is still pending; it may hold trailing content that has to be
+           rejected, so request the remaining data before finalizing */
+        if (unlikely(len < state->buf_len)) goto unexpected_end;
     }
-    if (dat_len >= sizeof(buf)) alc->free(alc->ctx, hdr);
-    if (yyjson_is_raw(val)) val->uni.str = dat;
-    return dat + (cur - hdr);
-#else
-    if (!read_num(&cur, pre, flg, val, &msg)) {
-        return_err(cur, INVALID_NUMBER, msg);
+
+    **pre = '\0';
+    doc = (yyjson_doc *)val_hdr;
+    doc->root = val_hdr + hdr_len;
+    doc->alc = alc;
+    doc->dat_read = (usize)(cur - hdr);
+    doc->val_read = (usize)((val - doc->root) + 1);
+    doc->str_pool = has_flg(INSITU) ? NULL : (char *)hdr;
+    memset(&doc->ext, 0, sizeof(yyjson_doc_ext));
+    state->hdr = NULL;
+    state->val_hdr = NULL;
+    memset(err, 0, sizeof(yyjson_read_err));
+    return doc;
+
+unexpected_end:
+    err->pos = len;
+    /* if no more data, stop the incr read */
+    if (unlikely(len >= state->buf_len)) {
+        err->code = YYJSON_READ_ERROR_UNEXPECTED_END;
+        err->msg = MSG_NOT_END;
+        return NULL;
     }
-    return (const char *)cur;
-#endif
+    /* save parser state in extended error struct, in addition to what was
+     * stored in the last save_incr_state */
+    err->code = YYJSON_READ_ERROR_MORE;
+    err->msg = "need more data";
+    state->val_end = val_end;
+    state->ctn = ctn;
+    state->alc_len = alc_len;
+    /* restore the end where we've inserted a null terminator */
+    *end = saved_end;
+    return NULL;
+
+fail_string:            return_err(cur, INVALID_STRING, msg);
+fail_number:            return_err(cur, INVALID_NUMBER, msg);
+fail_alloc:             return_err(cur, MEMORY_ALLOCATION, MSG_MALLOC);
+fail_trailing_comma:    return_err(cur, JSON_STRUCTURE, MSG_COMMA);
+fail_literal_true:      return_err(cur, LITERAL, MSG_CHAR_T);
+fail_literal_false:     return_err(cur, LITERAL, MSG_CHAR_F);
+fail_literal_null:      return_err(cur, LITERAL, MSG_CHAR_N);
+fail_character_val:     return_err(cur, UNEXPECTED_CHARACTER, MSG_CHAR);
+fail_character_arr_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_ARR_END);
+fail_character_obj_key: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_KEY);
+fail_character_obj_sep: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_SEP);
+fail_character_obj_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_END);
+fail_garbage:           return_err(cur, UNEXPECTED_CONTENT, MSG_GARBAGE);
+fail_depth:             return_err(cur, DEPTH, MSG_DEPTH);
 
+#undef val_incr
 #undef return_err
+#undef return_err_inv_param
+#undef save_incr_state
+#undef check_maybe_truncated_number
 }
 
+#endif /* YYJSON_DISABLE_INCR_READER */
 
 
 /*==============================================================================
- * MARK: - Incremental JSON Reader (Public)
+ * MARK: - JSON Lines Reader (Public)
  *============================================================================*/
 
-#if !YYJSON_DISABLE_INCR_READER
-
-/* labels within yyjson_incr_read() to resume incremental parsing */
-#define LABEL_doc_begin     0
-#define LABEL_arr_val_begin 1
-#define LABEL_arr_val_end   2
-#define LABEL_obj_key_begin 3
-#define LABEL_obj_key_end   4
-#define LABEL_obj_val_begin 5
-#define LABEL_obj_val_end   6
-#define LABEL_doc_end       7
+/** The memory of a record in the arena of JSON Lines reader. */
+typedef struct ndjson_slot {
+    usize ofs; /* offset of the memory pool in the arena */
+    usize size; /* size of the memory pool, 0 to use the reader's allocator */
+    yyjson_doc *own; /* document allocated by the reader's allocator */
+} ndjson_slot;
 
-/** State for incremental JSON reader, opaque in the API. */
-struct yyjson_incr_state {
-    u32 label; /* current parser goto label */
+/** State for JSON Lines reader, opaque in the API. */
+struct yyjson_ndjson {
     yyjson_alc alc; /* allocator */
-    yyjson_read_flag flg; /* read flags */
-    u8 *hdr; /* JSON data header */
-    u8 *cur; /* current position in JSON data */
-    usize buf_len; /* total buffer length (without padding) */
-    usize hdr_len; /* value count used by yyjson_doc */
-    usize alc_len; /* value count allocated */
-    usize ctn_len; /* the number of elements in current container */
-    yyjson_val *val_hdr; /* the head of allocated values */
-    yyjson_val *val_end; /* the end of allocated values */
-    yyjson_val *val; /* current JSON value */
-    yyjson_val *ctn; /* current container */
-    u8 *str_con[2]; /* string parser incremental state */
-    u8 *raw_ptr; /* pending position for a deferred raw null-terminator */
-    u8 raw_end[1]; /* dummy target for the first deferred null-terminator */
+    yyjson_read_flag flg; /* read flags for each record */
+    const u8 *dat; /* input data, or the buffer of file */
+    usize len; /* length of data in `dat` */
+    usize cur; /* current offset in `dat` */
+    usize base; /* offset of `dat` in the input */
+    usize line; /* line number at `cur` */
+    bool done; /* no more record */
+    u8 *arena; /* memory pools of the documents */
+    usize arena_size; /* size of the arena */
+    ndjson_slot *slots; /* memory of the records in current batch */
+    usize slot_num; /* number of slots allocated */
+    yyjson_ndjson_rec *recs; /* records in current batch */
+#if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
+    FILE *file; /* input file, or NULL */
+    usize buf_size; /* size of the file buffer */
+    bool file_end; /* the file is read to the end */
+#endif
 };
 
-yyjson_incr_state *yyjson_incr_new(char *buf, size_t buf_len,
-                                   yyjson_read_flag flg,
-                                   const yyjson_alc *alc_ptr) {
-    yyjson_incr_state *state = NULL;
-    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
-
-    /* remove non-standard flags */
-    flg &= ~YYJSON_READ_JSON5;
-    flg &= ~YYJSON_READ_ALLOW_BOM;
-    flg &= ~YYJSON_READ_ALLOW_INVALID_UNICODE;
-
-    if (unlikely(!buf)) return NULL;
-    if (unlikely(buf_len >= USIZE_MAX - YYJSON_PADDING_SIZE)) return NULL;
-    state = (yyjson_incr_state *)alc.malloc(alc.ctx, sizeof(*state));
-    if (!state) return NULL;
-    memset(state, 0, sizeof(yyjson_incr_state));
-    state->alc = alc;
-    state->flg = flg;
-    state->buf_len = buf_len;
-
-    /* add 4-byte zero padding for input data if necessary */
-    if (has_flg(INSITU)) {
-        state->hdr = (u8 *)buf;
-    } else {
-        state->hdr = (u8 *)alc.malloc(alc.ctx, buf_len + YYJSON_PADDING_SIZE);
-        if (unlikely(!state->hdr)) {
-            alc.free(alc.ctx, state);
-            return NULL;
-        }
-        memcpy(state->hdr, buf, buf_len);
-    }
-    memset(state->hdr + buf_len, 0, YYJSON_PADDING_SIZE);
-    state->cur = state->hdr;
-    state->raw_ptr = state->raw_end;
-    state->label = LABEL_doc_begin;
-    return state;
-}
-
-void yyjson_incr_free(yyjson_incr_state *state) {
-    if (state) {
-        yyjson_alc alc = state->alc;
-        memset(&state->alc, 0, sizeof(alc));
-        if (state->val_hdr) {
-            alc.free(alc.ctx, (void *)state->val_hdr);
-        }
-        if (state->hdr && !(state->flg & YYJSON_READ_INSITU)) {
-            alc.free(alc.ctx, state->hdr);
-        }
-        alc.free(alc.ctx, state);
+/** Free the documents of the previous batch allocated by the allocator. */
+static_inline void ndjson_release(yyjson_ndjson *nd) {
+    usize i;
+    for (i = 0; i < nd->slot_num; i++) {
+        yyjson_doc_free(nd->slots[i].own);
+        nd->slots[i].own = NULL;
     }
 }
 
-yyjson_doc *yyjson_incr_read(yyjson_incr_state *state, size_t len,
-                             yyjson_read_err *err) {
-#define return_err_inv_param(_msg) do { \
-    err->pos = 0; \
-    err->msg = _msg; \
-    err->code = YYJSON_READ_ERROR_INVALID_PARAMETER; \
-    return NULL; \
-} while (false)
-
-#define return_err(_pos, _code, _msg) do { \
-    if (is_truncated_end(hdr, _pos, end, YYJSON_READ_ERROR_##_code, flg)) { \
-        goto unexpected_end; \
-    } else { \
-        err->pos = (usize)(_pos - hdr); \
-        err->code = YYJSON_READ_ERROR_##_code; \
-        err->msg = _msg; \
-    } \
-    return NULL; \
-} while (false)
-
-#define val_incr() do { \
-    val++; \
-    if (unlikely(val >= val_end)) { \
-        usize alc_old = alc_len; \
-        alc_len += alc_len / 2; \
-        if ((sizeof(usize) < 8) && (alc_len >= alc_max)) goto fail_alloc; \
-        val_tmp = (yyjson_val *)alc.realloc(alc.ctx, (void *)val_hdr, \
-                                            alc_old * sizeof(yyjson_val), \
-                                            alc_len * sizeof(yyjson_val)); \
-        if ((!val_tmp)) goto fail_alloc; \
-        val = val_tmp + (usize)(val - val_hdr); \
-        ctn = val_tmp + (usize)(ctn - val_hdr); \
-        state->val = val_tmp + (usize)(state->val - val_hdr); \
-        state->val_hdr = val_hdr = val_tmp; \
-        val_end = val_tmp + (alc_len - 2); \
-        state->val_end = val_end; \
-    } \
-} while (false)
-
-    /* save position where it's possible to resume incremental parsing */
-#define save_incr_state(_label) do { \
-    state->label = LABEL_##_label; \
-    state->cur = cur; \
-    state->val = val; \
-    state->ctn_len = ctn_len; \
-    state->hdr_len = hdr_len; \
-    state->raw_ptr = raw_ptr; \
-    if (unlikely(cur >= end)) goto unexpected_end; \
-} while (false)
-
-#define check_maybe_truncated_number() do { \
-    if (unlikely(cur >= end)) { \
-        if (unlikely(cur > state->cur + INCR_NUM_MAX_LEN)) { \
-            msg = "number too long"; \
-            goto fail_number; \
-        } \
-        goto unexpected_end; \
-    } \
-} while (false)
-
-    u8 *hdr = NULL, *end = NULL, *cur = NULL;
-    yyjson_read_flag flg;
-    yyjson_alc alc;
-    usize dat_len; /* data length in bytes, hint for allocator */
-    usize hdr_len; /* value count used by yyjson_doc */
-    usize alc_len; /* value count allocated */
-    usize alc_max; /* maximum value count for allocator */
-    usize ctn_len; /* the number of elements in current container */
-    yyjson_val *val_hdr; /* the head of allocated values */
-    yyjson_val *val_end; /* the end of allocated values */
-    yyjson_val *val_tmp; /* temporary pointer for realloc */
-    yyjson_val *val; /* current JSON value */
-    yyjson_val *ctn; /* current container */
-    yyjson_val *ctn_parent; /* parent of current container */
-    yyjson_doc *doc; /* the JSON document, equals to val_hdr */
-    const char *msg; /* error message */
-
-    yyjson_read_err tmp_err;
-    u8 *raw_ptr; /* deferred raw null-terminator position, committed at save */
-    u8 **pre = &raw_ptr; /* previous raw end pointer */
-    u8 **con = NULL; /* for incremental string parsing */
-    u8 saved_end = '\0'; /* saved end char */
+/** Skip the UTF-8 BOM at the beginning of input if it's allowed. */
+static_inline void ndjson_skip_bom(yyjson_ndjson *nd, yyjson_read_flag flg) {
+    if (has_allow(BOM) && nd->len >= 3 && is_utf8_bom(nd->dat)) nd->cur = 3;
+}
 
-#if YYJSON_READER_DEPTH_LIMIT
-    u32 container_depth = 0; /* current array/object depth */
+/** Returns whether all the data in the buffer has been read from the input. */
+static_inline bool ndjson_is_end(yyjson_ndjson *nd) {
+#if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
+    return !nd->file || nd->file_end;
+#else
+    return true;
 #endif
+}
 
-    /* validate input parameters */
-    if (!err) err = &tmp_err;
-    if (unlikely(!state)) {
-        return_err_inv_param("input state is NULL");
+/** Returns the first line break in `[cur, end)`, or NULL. */
+static_inline const u8 *ndjson_find_nl(const u8 *cur, const u8 *end) {
+#if !YYJSON_FREESTANDING
+    return (const u8 *)memchr(cur, '\n', (usize)(end - cur));
+#else
+    for (; cur < end; cur++) if (*cur == '\n') return cur;
+    return NULL;
+#endif
+}
+
+/**
+ Find the next non-blank line from the current offset.
+ Returns 1 if a line is found, 0 if there's no more line,
+ or -1 if the line is incomplete and the buffer should be filled.
+ */
+static_inline i32 ndjson_find(yyjson_ndjson *nd, yyjson_ndjson_rec *rec) {
+    const u8 *hdr = nd->dat, *end = hdr + nd->len, *cur, *nl, *tmp;
+    while (nd->cur < nd->len) {
+        cur = hdr + nd->cur;
+        nl = ndjson_find_nl(cur, end);
+        if (!nl) {
+            if (!ndjson_is_end(nd)) return -1;
+            nl = end;
+        }
+        nd->cur = (usize)(nl - hdr) + (nl < end);
+        nd->line += (nl < end);
+        for (tmp = cur; tmp < nl && char_is_space(*tmp); tmp++);
+        if (tmp == nl) continue; /* blank line */
+        rec->doc = NULL;
+        rec->pos = nd->base + (usize)(cur - hdr);
+        rec->len = (usize)(nl - cur);
+        rec->len -= (nl < end && *(nl - 1) == '\r'); /* CRLF line break */
+        rec->line = nd->line - (nl < end);
+        return 1;
     }
-    if (unlikely(!len)) {
-        return_err_inv_param("input length is 0");
+    return ndjson_is_end(nd) ? 0 : -1;
+}
+
+#if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
+/** Move the unread data to the beginning of the file buffer and read more
+    data from the file, the buffer grows if it's full. */
+static bool ndjson_fill(yyjson_ndjson *nd, yyjson_read_err *err) {
+    u8 *buf = constcast(u8 *)nd->dat;
+    usize len = nd->len - nd->cur, size = nd->buf_size, read_size;
+
+    memmove(buf, buf + nd->cur, len);
+    nd->base += nd->cur;
+    nd->cur = 0;
+    nd->len = len;
+    if (len == size) {
+        if (size > USIZE_MAX / 2) {
+            buf = NULL;
+        } else {
+            buf = (u8 *)nd->alc.realloc(nd->alc.ctx, buf, size, size * 2);
+        }
+        if (!buf) {
+            err->code = YYJSON_READ_ERROR_MEMORY_ALLOCATION;
+            err->msg = MSG_MALLOC;
+            return false;
+        }
+        nd->dat = buf;
+        nd->buf_size = size * 2;
+    }
+    read_size = fread_safe(buf + len, nd->buf_size - len, nd->file);
+    nd->len += read_size;
+    if (read_size < nd->buf_size - len) {
+        nd->file_end = true;
+        if (ferror(nd->file)) {
+            err->code = YYJSON_READ_ERROR_FILE_READ;
+            err->msg = MSG_FREAD;
+            return false;
+        }
     }
-    if (unlikely(len > state->buf_len)) {
-        return_err_inv_param("length is greater than total input length");
+    return true;
+}
+#endif
+
+/** Read a record with its own memory pool. */
+static void ndjson_read_task(void *arg, usize idx) {
+    yyjson_ndjson *nd = (yyjson_ndjson *)arg;
+    yyjson_ndjson_rec *rec = nd->recs + idx;
+    ndjson_slot *slot = nd->slots + idx;
+    char *dat = constcast(char *)(nd->dat + (rec->pos - nd->base));
+    yyjson_alc pool;
+
+    if (slot->size) {
+        yyjson_alc_pool_init(&pool, nd->arena + slot->ofs, slot->size);
+        rec->doc = yyjson_read_opts(dat, rec->len, nd->flg, &pool, &rec->err);
+        if (rec->doc || rec->err.code != YYJSON_READ_ERROR_MEMORY_ALLOCATION) {
+            if (!rec->doc) rec->err.pos += rec->pos;
+            return;
+        }
+        /* some invalid input may need more memory before the error */
     }
+    rec->doc = yyjson_read_opts(dat, rec->len, nd->flg, &nd->alc, &rec->err);
+    slot->own = rec->doc;
+    if (!rec->doc) rec->err.pos += rec->pos;
+}
 
-    /* restore state saved from the previous call */
-    hdr = state->hdr;
-    end = state->hdr + len;
-    cur = state->cur;
-    flg = state->flg;
-    alc = state->alc;
-    ctn_len = state->ctn_len;
-    hdr_len = state->hdr_len;
-    alc_len = state->alc_len;
-    val = state->val;
-    val_hdr = state->val_hdr;
-    val_end = state->val_end;
-    ctn = state->ctn;
-    con = state->str_con;
-    raw_ptr = state->raw_ptr;
-    alc_max = USIZE_MAX / sizeof(yyjson_val);
+yyjson_ndjson *yyjson_ndjson_new(const char *dat, usize len,
+                                 yyjson_read_flag flg,
+                                 const yyjson_alc *alc_ptr) {
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    yyjson_ndjson *nd;
+    if (!dat) return NULL;
+    nd = (yyjson_ndjson *)alc.malloc(alc.ctx, sizeof(yyjson_ndjson));
+    if (!nd) return NULL;
+    memset(nd, 0, sizeof(yyjson_ndjson));
+    nd->alc = alc;
+    nd->flg = flg & ~(YYJSON_READ_INSITU | YYJSON_READ_ALLOW_BOM |
+                    YYJSON_READ_ZERO_COPY);
+    nd->dat = (const u8 *)dat;
+    nd->len = len;
+    nd->line = 1;
+    ndjson_skip_bom(nd, flg);
+    return nd;
+}
 
-    /* insert null terminator to make us stop at the specified end, even if
-       the data contains more valid JSON */
-    saved_end = *end;
-    *end = '\0';
+#if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
 
-    /* resume parsing from the last save point */
-    switch (state->label) {
-    case LABEL_doc_begin: goto doc_begin;
-    case LABEL_arr_val_begin: goto arr_val_begin;
-    case LABEL_arr_val_end: goto arr_val_end;
-    case LABEL_obj_key_begin: goto obj_key_begin;
-    case LABEL_obj_key_end: goto obj_key_end;
-    case LABEL_obj_val_begin: goto obj_val_begin;
-    case LABEL_obj_val_end: goto obj_val_end;
-    case LABEL_doc_end: goto doc_end;
-    default: return_err_inv_param("invalid incremental state");
+yyjson_ndjson *yyjson_ndjson_new_fp(FILE *file,
+                                    yyjson_read_flag flg,
+                                    const yyjson_alc *alc_ptr) {
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    yyjson_ndjson *nd;
+    yyjson_read_err err;
+    u8 *buf;
+    if (!file) return NULL;
+    nd = (yyjson_ndjson *)alc.malloc(alc.ctx, sizeof(yyjson_ndjson));
+    if (!nd) return NULL;
+    buf = (u8 *)alc.malloc(alc.ctx, YYJSON_READER_NDJSON_BUF_SIZE);
+    if (!buf) {
+        alc.free(alc.ctx, nd);
+        return NULL;
     }
-
-doc_begin:
-    /* skip empty contents before json document */
-    if (unlikely(!char_is_ctn(*cur))) {
-        while (char_is_space(*cur)) cur++;
-        if (unlikely(cur >= end)) goto unexpected_end; /* input data is empty */
+    memset(nd, 0, sizeof(yyjson_ndjson));
+    nd->alc = alc;
+    nd->flg = flg & ~(YYJSON_READ_INSITU | YYJSON_READ_ALLOW_BOM |
+                    YYJSON_READ_ZERO_COPY);
+    nd->dat = buf;
+    nd->line = 1;
+    nd->file = file;
+    nd->buf_size = YYJSON_READER_NDJSON_BUF_SIZE;
+    if (!ndjson_fill(nd, &err)) {
+        yyjson_ndjson_free(nd);
+        return NULL;
     }
+    ndjson_skip_bom(nd, flg);
+    return nd;
+}
 
-    /* allocate memory for document */
-    if (!val_hdr) {
-        hdr_len = sizeof(yyjson_doc) / sizeof(yyjson_val);
-        hdr_len += (sizeof(yyjson_doc) % sizeof(yyjson_val)) > 0;
-        if (likely(char_is_ctn(*cur))) {
-            dat_len = has_flg(STOP_WHEN_DONE) ? 256 : state->buf_len;
-            alc_len = hdr_len +
-                    (dat_len / YYJSON_READER_ESTIMATED_MINIFY_RATIO) + 4;
-            alc_len = yyjson_min(alc_len, alc_max);
+#endif /* !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE */
+
+usize yyjson_ndjson_read(yyjson_ndjson *nd, yyjson_ndjson_rec *recs,
+                         usize num, yyjson_par_run run, void *run_ctx) {
+    yyjson_read_flag flg;
+    yyjson_ndjson_rec *rec;
+    ndjson_slot *slot;
+    usize i, cnt = 0, size = 0;
+    i32 ret;
+
+    if (!nd || !recs || !num) return 0;
+    ndjson_release(nd);
+    if (nd->done) return 0;
+    flg = nd->flg;
+
+    if (num > nd->slot_num) {
+        slot = (ndjson_slot *)nd->alc.malloc(nd->alc.ctx,
+                                             num * sizeof(ndjson_slot));
+        if (slot) {
+            if (nd->slots) nd->alc.free(nd->alc.ctx, nd->slots);
+            memset(slot, 0, num * sizeof(ndjson_slot));
+            nd->slots = slot;
+            nd->slot_num = num;
+        } else if (nd->slot_num) {
+            num = nd->slot_num;
         } else {
-            alc_len = hdr_len + 1; /* single value */
+            memset(recs, 0, sizeof(yyjson_ndjson_rec));
+            recs->pos = nd->base + nd->cur;
+            recs->err.code = YYJSON_READ_ERROR_MEMORY_ALLOCATION;
+            recs->err.msg = MSG_MALLOC;
+            recs->err.pos = recs->pos;
+            nd->done = true;
+            return 1;
         }
-        val_hdr = (yyjson_val *)alc.malloc(alc.ctx,
-                                           alc_len * sizeof(yyjson_val));
-        if (unlikely(!val_hdr)) goto fail_alloc;
-        val_end = val_hdr + (alc_len - 2); /* padding for kv pair reading */
-        val = val_hdr + hdr_len;
-        ctn = val;
-        ctn_len = 0;
-        state->val_hdr = val_hdr;
-        state->val_end = val_end;
-        save_incr_state(doc_begin);
     }
 
-    /* read json document */
-    if (*cur == '{') {
-        cur++;
-        ctn->tag = YYJSON_TYPE_OBJ;
-        ctn->uni.ofs = 0;
-        goto obj_key_begin;
-    }
-    if (*cur == '[') {
-        cur++;
-        ctn->tag = YYJSON_TYPE_ARR;
-        ctn->uni.ofs = 0;
-        goto arr_val_begin;
-    }
-    if (char_is_num(*cur)) {
-        if (likely(read_num(&cur, pre, flg, val, &msg))) {
-            /* a root number may continue with more digits in a later chunk */
-            if (unlikely(len < state->buf_len)) check_maybe_truncated_number();
-            goto doc_end;
+    /* find the records, the file buffer is filled only before the first one
+       because the records refer to the data in the buffer */
+    while (cnt < num) {
+        rec = recs + cnt;
+        ret = ndjson_find(nd, rec);
+        if (ret > 0) {
+            slot = nd->slots + cnt;
+            slot->size = yyjson_read_max_memory_usage(rec->len, flg);
+            slot->size = size_align_up(slot->size, sizeof(yyjson_val));
+            slot->ofs = size;
+            size += slot->size;
+            if (size < slot->ofs) size = USIZE_MAX; /* overflow */
+            cnt++;
+            continue;
         }
-        goto fail_number;
-    }
-    if (*cur == '"') {
-        if (likely(read_str_con(&cur, end, flg, val, &msg, con))) goto doc_end;
-        goto fail_string;
+#if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
+        if (ret < 0 && cnt == 0) {
+            if (ndjson_fill(nd, &rec->err)) continue;
+            /* return the error as a record */
+            rec->doc = NULL;
+            rec->pos = nd->base + nd->cur;
+            rec->len = 0;
+            rec->line = nd->line;
+            rec->err.pos = rec->pos;
+            nd->done = true;
+            return 1;
+        }
+#endif
+        break;
     }
-    if (*cur == 't') {
-        if (likely(read_true(&cur, val))) goto doc_end;
-        goto fail_literal_true;
+    if (cnt == 0) {
+        nd->done = ndjson_is_end(nd);
+        return 0;
     }
-    if (*cur == 'f') {
-        if (likely(read_false(&cur, val))) goto doc_end;
-        goto fail_literal_false;
+
+    /* allocate the arena, or read with the allocator if it fails */
+    if (size > nd->arena_size) {
+        if (nd->arena) nd->alc.free(nd->alc.ctx, nd->arena);
+        nd->arena_size = 0;
+        nd->arena = (u8 *)nd->alc.malloc(nd->alc.ctx, size);
+        if (nd->arena) nd->arena_size = size;
     }
-    if (*cur == 'n') {
-        if (likely(read_null(&cur, val))) goto doc_end;
-        goto fail_literal_null;
+    if (!nd->arena_size) {
+        for (i = 0; i < cnt; i++) nd->slots[i].size = 0;
     }
 
-    msg = "unexpected character, expected a valid root value";
-    if (cur == hdr) {
-        /* RFC 8259: JSON text MUST be encoded using UTF-8 */
-        if (is_utf8_bom(hdr)) msg = MSG_ERR_BOM;
-        else if (len >= 4 && is_utf32_bom(hdr)) msg = MSG_ERR_UTF32;
-        else if (len >= 2 && is_utf16_bom(hdr)) msg = MSG_ERR_UTF16;
+    /* read the records */
+    nd->recs = recs;
+    if (run) {
+        run(run_ctx, ndjson_read_task, (void *)nd, cnt);
+    } else {
+        for (i = 0; i < cnt; i++) ndjson_read_task((void *)nd, i);
     }
-    return_err(cur, UNEXPECTED_CHARACTER, msg);
+    nd->recs = NULL;
+    return cnt;
+}
 
-arr_begin:
-#if YYJSON_READER_DEPTH_LIMIT
-    container_depth++;
-    if (unlikely(container_depth >= YYJSON_READER_DEPTH_LIMIT)) {
-        goto fail_depth;
-    }
+void yyjson_ndjson_free(yyjson_ndjson *nd) {
+    yyjson_alc alc;
+    if (!nd) return;
+    alc = nd->alc;
+    ndjson_release(nd);
+    if (nd->slots) alc.free(alc.ctx, nd->slots);
+    if (nd->arena) alc.free(alc.ctx, nd->arena);
+#if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
+    if (nd->file) alc.free(alc.ctx, constcast(void *)nd->dat);
 #endif
+    alc.free(alc.ctx, nd);
+}
 
-    /* save current container */
-    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
-               (ctn->tag & YYJSON_TAG_MASK);
 
-    /* create a new array value, save parent container offset */
-    val_incr();
-    val->tag = YYJSON_TYPE_ARR;
-    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
+/*==============================================================================
+ * MARK: - JSON SAX Reader (Public)
+ *
+ * The SAX reader uses the same state machine as `read_root_pretty()`, but it
+ * reads each scalar value into a local `yyjson_val` and reports it to the
+ * callback instead of appending it to the document. The only state kept for
+ * the containers is a stack with one bit per nesting level (object or array).
+ *
+ * Raw values (numbers as raw, unquoted keys) are not null-terminated by the
+ * readers until the next raw value is read, so a null-terminator is written
+ * temporarily while the callback runs, and the byte is restored afterwards.
+ *
+ * With `YYJSON_READ_ZERO_COPY`, the input is neither copied nor written. The
+ * escaped strings are unescaped into the string pool of the zero-copy reader,
+ * which only holds the current string and is reused after each callback, so
+ * it is bounded by the longest escaped string instead of the input size.
+ *============================================================================*/
 
-    /* push the new array value as current container */
-    ctn = val;
-    ctn_len = 0;
+/** Read JSON with the SAX callback, returns the bytes read or 0 on error. */
+static_noinline usize read_sax(u8 *hdr, u8 *cur, u8 *eof,
+                               yyjson_alc alc,
+                               yyjson_read_flag flg,
+                               yyjson_sax_cb cb, void *ctx,
+                               yyjson_read_err *err,
+                               copy_pool *pool) {
+#define return_err(_pos, _code, _msg) do { \
+    if (is_truncated_end(hdr, _pos, eof, YYJSON_READ_ERROR_##_code, flg)) { \
+        err->pos = (usize)(eof - hdr); \
+        err->code = YYJSON_READ_ERROR_UNEXPECTED_END; \
+        err->msg = MSG_NOT_END; \
+    } else { \
+        err->pos = (usize)(_pos - hdr); \
+        err->code = YYJSON_READ_ERROR_##_code; \
+        err->msg = _msg; \
+    } \
+    if (stk != stk_buf) alc.free(alc.ctx, stk); \
+    return 0; \
+} while (false)
+
+#define sax_evt(_evt) do { \
+    if (unlikely(!cb(ctx, YYJSON_SAX_##_evt, NULL))) goto doc_stop; \
+} while (false)
+
+#define sax_val(_evt) do { \
+    bool suc; \
+    u8 raw_chr = *raw_ptr; \
+    *raw_ptr = '\0'; /* temporary null-terminator for raw string */ \
+    if (pool && pool->cur != pool->hdr) { /* string unescaped into pool */ \
+        val.uni.str = (const char *)pool->hdr + val.uni.ofs; \
+        pool->cur = pool->hdr; \
+    } \
+    suc = cb(ctx, YYJSON_SAX_##_evt, &val); \
+    *raw_ptr = raw_chr; \
+    raw_ptr = raw_end; \
+    if (unlikely(!suc)) goto doc_stop; \
+} while (false)
+
+#define stk_push(_obj) do { \
+    if (unlikely(depth == stk_cap * 64)) { \
+        stk_tmp = (u64 *)alc.malloc(alc.ctx, stk_cap * 2 * sizeof(u64)); \
+        if (unlikely(!stk_tmp)) goto fail_alloc; \
+        memcpy(stk_tmp, stk, stk_cap * sizeof(u64)); \
+        if (stk != stk_buf) alc.free(alc.ctx, stk); \
+        stk = stk_tmp; \
+        stk_cap *= 2; \
+    } \
+    if (_obj) stk[depth / 64] |= (u64)1 << (depth % 64); \
+    else stk[depth / 64] &= ~((u64)1 << (depth % 64)); \
+    depth++; \
+} while (false)
+
+#define stk_top_is_obj() \
+    ((stk[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1)
+
+    u64 stk_buf[YYJSON_READER_SAX_STACK_SIZE]; /* local nesting stack */
+    u64 *stk = stk_buf; /* nesting stack, one bit per level, 1 for object */
+    u64 *stk_tmp; /* temporary pointer for stack growth */
+    usize stk_cap = YYJSON_READER_SAX_STACK_SIZE; /* stack capacity in words */
+    usize depth = 0; /* current array/object depth */
+    bool empty = true; /* current container has no value yet */
+    yyjson_val val; /* current scalar value or key */
+    const char *msg; /* error message */
+
+    u8 raw_end[1]; /* raw end for null-terminator */
+    u8 *raw_ptr = raw_end;
+    u8 **pre = &raw_ptr; /* previous raw end pointer */
+
+    goto val_begin;
+
+arr_begin:
+    stk_push(false);
+#if YYJSON_READER_DEPTH_LIMIT
+    if (unlikely(depth >= YYJSON_READER_DEPTH_LIMIT)) goto fail_depth;
+#endif
+    sax_evt(ARR_BEGIN);
+    empty = true;
 
 arr_val_begin:
-    save_incr_state(arr_val_begin);
-arr_val_continue:
-    if (*cur == '{') {
-        cur++;
-        goto obj_begin;
-    }
-    if (*cur == '[') {
-        cur++;
-        goto arr_begin;
-    }
-    if (char_is_num(*cur)) {
-        val_incr();
-        ctn_len++;
-        if (likely(read_num(&cur, pre, flg, val, &msg))) goto arr_val_maybe_end;
-        goto fail_number;
-    }
-    if (*cur == '"') {
-        val_incr();
-        ctn_len++;
-        if (likely(read_str_con(&cur, end, flg, val, &msg, con)))
-            goto arr_val_end;
-        goto fail_string;
-    }
-    if (*cur == 't') {
-        val_incr();
-        ctn_len++;
-        if (likely(read_true(&cur, val))) goto arr_val_end;
-        goto fail_literal_true;
-    }
-    if (*cur == 'f') {
-        val_incr();
-        ctn_len++;
-        if (likely(read_false(&cur, val))) goto arr_val_end;
-        goto fail_literal_false;
-    }
-    if (*cur == 'n') {
-        val_incr();
-        ctn_len++;
-        if (likely(read_null(&cur, val))) goto arr_val_end;
-        goto fail_literal_null;
-    }
+    if (char_is_space(*cur)) cur = skip_space(cur + 1, eof);
     if (*cur == ']') {
         cur++;
-        if (likely(ctn_len == 0)) goto arr_end;
+        if (likely(empty)) goto arr_end;
+        if (has_allow(TRAILING_COMMAS)) goto arr_end;
         do { cur--; } while (*cur != ',');
         goto fail_trailing_comma;
     }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto arr_val_continue;
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto arr_val_begin;
+        if (cur == eof) goto fail_comment;
     }
-    goto fail_character_val;
-
-arr_val_maybe_end:
-    /* if incremental parsing stops in the middle of a number, it may continue
-       with more digits, so arr val maybe didn't end yet */
-    check_maybe_truncated_number();
+    goto val_begin;
 
 arr_val_end:
-    save_incr_state(arr_val_end);
     if (*cur == ',') {
         cur++;
         goto arr_val_begin;
@@ -6927,100 +11126,105 @@ arr_val_end:
         goto arr_end;
     }
     if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
+        cur = skip_space(cur + 1, eof);
         goto arr_val_end;
     }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto arr_val_end;
+        if (cur == eof) goto fail_comment;
+    }
     goto fail_character_arr_end;
 
 arr_end:
-#if YYJSON_READER_DEPTH_LIMIT
-    container_depth--;
-#endif
-    /* get parent container */
-    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
-
-    /* save the next sibling value offset */
-    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
-    ctn->tag = ((ctn_len) << YYJSON_TAG_BIT) | YYJSON_TYPE_ARR;
-    if (unlikely(ctn == ctn_parent)) goto doc_end;
-
-    /* pop parent as current container */
-    ctn = ctn_parent;
-    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
-    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
-        goto obj_val_end;
-    } else {
-        goto arr_val_end;
-    }
+    depth--;
+    sax_evt(ARR_END);
+    goto val_end;
 
 obj_begin:
+    stk_push(true);
 #if YYJSON_READER_DEPTH_LIMIT
-    container_depth++;
-    if (unlikely(container_depth >= YYJSON_READER_DEPTH_LIMIT)) {
-        goto fail_depth;
-    }
+    if (unlikely(depth >= YYJSON_READER_DEPTH_LIMIT)) goto fail_depth;
 #endif
-
-    /* push container */
-    ctn->tag = (((u64)ctn_len + 1) << YYJSON_TAG_BIT) |
-               (ctn->tag & YYJSON_TAG_MASK);
-    val_incr();
-    val->tag = YYJSON_TYPE_OBJ;
-    /* offset to the parent */
-    val->uni.ofs = (usize)((u8 *)val - (u8 *)ctn);
-    ctn = val;
-    ctn_len = 0;
+    sax_evt(OBJ_BEGIN);
+    empty = true;
 
 obj_key_begin:
-    save_incr_state(obj_key_begin);
-obj_key_continue:
+    if (char_is_space(*cur)) cur = skip_space(cur + 1, eof);
     if (likely(*cur == '"')) {
-        val_incr();
-        ctn_len++;
-        if (likely(read_str_con(&cur, end, flg, val, &msg, con)))
-            goto obj_key_end;
+        if (likely(read_str(&cur, eof, flg, &val, &msg, pool))) goto obj_key_end;
         goto fail_string;
     }
     if (likely(*cur == '}')) {
         cur++;
-        if (likely(ctn_len == 0)) goto obj_end;
+        if (likely(empty)) goto obj_end;
+        if (has_allow(TRAILING_COMMAS)) goto obj_end;
         do { cur--; } while (*cur != ',');
         goto fail_trailing_comma;
     }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto obj_key_continue;
+    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
+        if (likely(read_str_sq(&cur, eof, flg, &val, &msg, pool))) goto obj_key_end;
+        goto fail_string;
+    }
+    if (has_allow(UNQUOTED_KEY) && char_is_id_start(*cur)) {
+        if (read_str_id(&cur, eof, flg, pre, &val, &msg)) goto obj_key_end;
+        goto fail_string;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto obj_key_begin;
+        if (cur == eof) goto fail_comment;
     }
     goto fail_character_obj_key;
 
 obj_key_end:
-    save_incr_state(obj_key_end);
+    sax_val(KEY);
+obj_key_sep:
     if (*cur == ':') {
         cur++;
         goto obj_val_begin;
     }
     if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto obj_key_end;
+        cur = skip_space(cur + 1, eof);
+        goto obj_key_sep;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto obj_key_sep;
+        if (cur == eof) goto fail_comment;
     }
     goto fail_character_obj_sep;
 
 obj_val_begin:
-    save_incr_state(obj_val_begin);
-obj_val_continue:
-    if (*cur == '"') {
-        val++;
-        ctn_len++;
-        if (likely(read_str_con(&cur, end, flg, val, &msg, con)))
-            goto obj_val_end;
-        goto fail_string;
+    if (char_is_space(*cur)) cur = skip_space(cur + 1, eof);
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto obj_val_begin;
+        if (cur == eof) goto fail_comment;
     }
-    if (char_is_num(*cur)) {
-        val++;
-        ctn_len++;
-        if (likely(read_num(&cur, pre, flg, val, &msg))) goto obj_val_maybe_end;
-        goto fail_number;
+    goto val_begin;
+
+obj_val_end:
+    if (likely(*cur == ',')) {
+        cur++;
+        goto obj_key_begin;
+    }
+    if (likely(*cur == '}')) {
+        cur++;
+        goto obj_end;
+    }
+    if (char_is_space(*cur)) {
+        cur = skip_space(cur + 1, eof);
+        goto obj_val_end;
+    }
+    if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+        if (skip_trivia(&cur, eof, flg)) goto obj_val_end;
+        if (cur == eof) goto fail_comment;
     }
+    goto fail_character_obj_end;
+
+obj_end:
+    depth--;
+    sax_evt(OBJ_END);
+    goto val_end;
+
+val_begin:
     if (*cur == '{') {
         cur++;
         goto obj_begin;
@@ -7029,138 +11233,192 @@ obj_val_continue:
         cur++;
         goto arr_begin;
     }
+    if (char_is_num(*cur)) {
+        if (likely(read_num(&cur, eof, pre, flg, &val, &msg))) goto val_read;
+        goto fail_number;
+    }
+    if (*cur == '"') {
+        if (likely(read_str(&cur, eof, flg, &val, &msg, pool))) goto val_read;
+        goto fail_string;
+    }
     if (*cur == 't') {
-        val++;
-        ctn_len++;
-        if (likely(read_true(&cur, val))) goto obj_val_end;
+        if (likely(read_true(&cur, &val))) goto val_read;
         goto fail_literal_true;
     }
     if (*cur == 'f') {
-        val++;
-        ctn_len++;
-        if (likely(read_false(&cur, val))) goto obj_val_end;
+        if (likely(read_false(&cur, &val))) goto val_read;
         goto fail_literal_false;
     }
     if (*cur == 'n') {
-        val++;
-        ctn_len++;
-        if (likely(read_null(&cur, val))) goto obj_val_end;
+        if (likely(read_null(&cur, &val))) goto val_read;
+        if (has_allow(INF_AND_NAN)) {
+            if (read_nan(&cur, pre, flg, &val)) goto val_read;
+        }
         goto fail_literal_null;
     }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto obj_val_continue;
+    if (has_allow(INF_AND_NAN)) {
+        if (read_inf_or_nan(&cur, pre, flg, &val)) goto val_read;
+    }
+    if (has_allow(SINGLE_QUOTED_STR) && *cur == '\'') {
+        if (likely(read_str_sq(&cur, eof, flg, &val, &msg, pool))) goto val_read;
+        goto fail_string;
     }
     goto fail_character_val;
 
-obj_val_maybe_end:
-    /* if incremental parsing stops in the middle of a number, it may continue
-       with more digits, so obj val maybe didn't end yet */
-    check_maybe_truncated_number();
+val_read:
+    sax_val(VAL);
+val_end:
+    empty = false;
+    if (unlikely(depth == 0)) goto doc_end;
+    if (stk_top_is_obj()) goto obj_val_end;
+    goto arr_val_end;
 
-obj_val_end:
-    save_incr_state(obj_val_end);
-    if (likely(*cur == ',')) {
-        cur++;
-        goto obj_key_begin;
-    }
-    if (likely(*cur == '}')) {
-        cur++;
-        goto obj_end;
-    }
-    if (char_is_space(*cur)) {
-        while (char_is_space(*++cur));
-        goto obj_val_end;
+doc_end:
+    /* check invalid contents after json document */
+    if (unlikely(cur < eof) && !has_flg(STOP_WHEN_DONE)) {
+        while (char_is_space(*cur)) cur++;
+        if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+            if (!skip_trivia(&cur, eof, flg) && cur == eof) {
+                goto fail_comment;
+            }
+        }
+        if (unlikely(cur < eof)) goto fail_garbage;
     }
-    goto fail_character_obj_end;
 
-obj_end:
+doc_stop:
+    if (stk != stk_buf) alc.free(alc.ctx, stk);
+    return (usize)(cur - hdr);
+
+fail_string:            return_err(cur, INVALID_STRING, msg);
+fail_number:            return_err(cur, INVALID_NUMBER, msg);
+fail_alloc:             return_err(cur, MEMORY_ALLOCATION, MSG_MALLOC);
+fail_trailing_comma:    return_err(cur, JSON_STRUCTURE, MSG_COMMA);
+fail_literal_true:      return_err(cur, LITERAL, MSG_CHAR_T);
+fail_literal_false:     return_err(cur, LITERAL, MSG_CHAR_F);
+fail_literal_null:      return_err(cur, LITERAL, MSG_CHAR_N);
+fail_character_val:     return_err(cur, UNEXPECTED_CHARACTER, MSG_CHAR);
+fail_character_arr_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_ARR_END);
+fail_character_obj_key: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_KEY);
+fail_character_obj_sep: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_SEP);
+fail_character_obj_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_END);
+fail_comment:           return_err(cur, INVALID_COMMENT, MSG_COMMENT);
+fail_garbage:           return_err(cur, UNEXPECTED_CONTENT, MSG_GARBAGE);
 #if YYJSON_READER_DEPTH_LIMIT
-    container_depth--;
+fail_depth:             return_err(cur, DEPTH, MSG_DEPTH);
 #endif
 
-    /* pop container */
-    ctn_parent = (yyjson_val *)(void *)((u8 *)ctn - ctn->uni.ofs);
-    /* point to the next value */
-    ctn->uni.ofs = (usize)((u8 *)val - (u8 *)ctn) + sizeof(yyjson_val);
-    ctn->tag = (ctn_len << (YYJSON_TAG_BIT - 1)) | YYJSON_TYPE_OBJ;
-    if (unlikely(ctn == ctn_parent)) goto doc_end;
-    ctn = ctn_parent;
-    ctn_len = (usize)(ctn->tag >> YYJSON_TAG_BIT);
-    if ((ctn->tag & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ) {
-        goto obj_val_end;
+#undef stk_top_is_obj
+#undef stk_push
+#undef sax_val
+#undef sax_evt
+#undef return_err
+}
+
+usize yyjson_read_sax(char *dat, usize len,
+                      yyjson_read_flag flg,
+                      const yyjson_alc *alc_ptr,
+                      yyjson_sax_cb cb, void *ctx,
+                      yyjson_read_err *err) {
+#define return_err(_pos, _code, _msg) do { \
+    err->pos = (usize)(_pos); \
+    err->msg = _msg; \
+    err->code = YYJSON_READ_ERROR_##_code; \
+    if (!has_flg(INSITU) && hdr) alc.free(alc.ctx, (void *)hdr); \
+    return 0; \
+} while (false)
+
+    yyjson_read_err tmp_err;
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    usize ret, i;
+    u8 *hdr = NULL, *eof, *cur;
+    copy_pool copy = { NULL, NULL, NULL, NULL, false }, *pool = NULL;
+
+    /* validate input parameters */
+    if (!err) err = &tmp_err;
+    if (unlikely(!dat)) return_err(0, INVALID_PARAMETER, "input data is NULL");
+    if (unlikely(!len)) return_err(0, INVALID_PARAMETER, "input length is 0");
+    if (unlikely(!cb)) return_err(0, INVALID_PARAMETER, "callback is NULL");
+    if (has_flg(ZERO_COPY)) {
+        if (unlikely(flg & (YYJSON_READ_INSITU |
+                            YYJSON_READ_NUMBER_AS_RAW |
+                            YYJSON_READ_BIGNUM_AS_RAW |
+                            YYJSON_READ_ALLOW_UNQUOTED_KEY))) {
+            return_err(0, INVALID_PARAMETER,
+                       "flag is not supported with zero-copy reading");
+        }
+        for (i = 0; i < YYJSON_PADDING_SIZE; i++) {
+            if (unlikely(dat[len + i])) {
+                return_err(0, INVALID_PARAMETER,
+                           "input data is not padded with zero bytes");
+            }
+        }
+        /* read the input in place, the strings are never written to it */
+        flg |= YYJSON_READ_INSITU;
+        copy.alc = &alc;
+        pool = &copy;
+    }
+
+    /* add 4-byte zero padding for input data if necessary */
+    if (has_flg(INSITU)) {
+        hdr = (u8 *)dat;
+        eof = (u8 *)dat + len;
+        cur = (u8 *)dat;
+        if (!pool) memset(eof, 0, YYJSON_PADDING_SIZE);
     } else {
-        goto arr_val_end;
+        if (unlikely(len >= USIZE_MAX - YYJSON_PADDING_SIZE)) {
+            return_err(0, MEMORY_ALLOCATION, MSG_MALLOC);
+        }
+        hdr = (u8 *)alc.malloc(alc.ctx, len + YYJSON_PADDING_SIZE);
+        if (unlikely(!hdr)) {
+            return_err(0, MEMORY_ALLOCATION, MSG_MALLOC);
+        }
+        eof = hdr + len;
+        cur = hdr;
+        memcpy(hdr, dat, len);
+        memset(eof, 0, YYJSON_PADDING_SIZE);
     }
 
-doc_end:
-    /* check invalid contents after json document */
-    if (unlikely(cur < end || len < state->buf_len) &&
-        !has_flg(STOP_WHEN_DONE)) {
-        save_incr_state(doc_end);
+    if (has_allow(BOM)) {
+        if (len >= 3 && is_utf8_bom(cur)) cur += 3;
+    }
+
+    /* skip empty contents before json document */
+    if (unlikely(!char_is_ctn(*cur))) {
         while (char_is_space(*cur)) cur++;
-        if (unlikely(cur < end)) goto fail_garbage;
-        /* the document is complete for the bytes seen so far, but more input
-           is still pending; it may hold trailing content that has to be
-           rejected, so request the remaining data before finalizing */
-        if (unlikely(len < state->buf_len)) goto unexpected_end;
+        if (unlikely(!char_is_ctn(*cur))) {
+            if (has_allow(TRIVIA) && char_is_trivia(*cur)) {
+                if (!skip_trivia(&cur, eof, flg) && cur == eof) {
+                    return_err(cur - hdr, INVALID_COMMENT, MSG_COMMENT);
+                }
+            }
+        }
+        if (unlikely(cur >= eof)) {
+            return_err(0, EMPTY_CONTENT, "input data is empty");
+        }
     }
 
-    **pre = '\0';
-    doc = (yyjson_doc *)val_hdr;
-    doc->root = val_hdr + hdr_len;
-    doc->alc = alc;
-    doc->dat_read = (usize)(cur - hdr);
-    doc->val_read = (usize)((val - doc->root) + 1);
-    doc->str_pool = has_flg(INSITU) ? NULL : (char *)hdr;
-    state->hdr = NULL;
-    state->val_hdr = NULL;
-    memset(err, 0, sizeof(yyjson_read_err));
-    return doc;
+    /* read json document */
+    ret = read_sax(hdr, cur, eof, alc, flg, cb, ctx, err, pool);
+    if (pool && copy.hdr) alc.free(alc.ctx, copy.hdr);
 
-unexpected_end:
-    err->pos = len;
-    /* if no more data, stop the incr read */
-    if (unlikely(len >= state->buf_len)) {
-        err->code = YYJSON_READ_ERROR_UNEXPECTED_END;
-        err->msg = MSG_NOT_END;
-        return NULL;
+    /* check result */
+    if (likely(ret)) {
+        memset(err, 0, sizeof(yyjson_read_err));
+    } else {
+        if (copy.oom) err->code = YYJSON_READ_ERROR_MEMORY_ALLOCATION;
+        /* RFC 8259: JSON text MUST be encoded using UTF-8 */
+        if (err->pos == 0 && err->code != YYJSON_READ_ERROR_MEMORY_ALLOCATION) {
+            if (is_utf8_bom(hdr)) err->msg = MSG_ERR_BOM;
+            else if (len >= 4 && is_utf32_bom(hdr)) err->msg = MSG_ERR_UTF32;
+            else if (len >= 2 && is_utf16_bom(hdr)) err->msg = MSG_ERR_UTF16;
+        }
     }
-    /* save parser state in extended error struct, in addition to what was
-     * stored in the last save_incr_state */
-    err->code = YYJSON_READ_ERROR_MORE;
-    err->msg = "need more data";
-    state->val_end = val_end;
-    state->ctn = ctn;
-    state->alc_len = alc_len;
-    /* restore the end where we've inserted a null terminator */
-    *end = saved_end;
-    return NULL;
-
-fail_string:            return_err(cur, INVALID_STRING, msg);
-fail_number:            return_err(cur, INVALID_NUMBER, msg);
-fail_alloc:             return_err(cur, MEMORY_ALLOCATION, MSG_MALLOC);
-fail_trailing_comma:    return_err(cur, JSON_STRUCTURE, MSG_COMMA);
-fail_literal_true:      return_err(cur, LITERAL, MSG_CHAR_T);
-fail_literal_false:     return_err(cur, LITERAL, MSG_CHAR_F);
-fail_literal_null:      return_err(cur, LITERAL, MSG_CHAR_N);
-fail_character_val:     return_err(cur, UNEXPECTED_CHARACTER, MSG_CHAR);
-fail_character_arr_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_ARR_END);
-fail_character_obj_key: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_KEY);
-fail_character_obj_sep: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_SEP);
-fail_character_obj_end: return_err(cur, UNEXPECTED_CHARACTER, MSG_OBJ_END);
-fail_garbage:           return_err(cur, UNEXPECTED_CONTENT, MSG_GARBAGE);
-fail_depth:             return_err(cur, DEPTH, MSG_DEPTH);
+    if (!has_flg(INSITU)) alc.free(alc.ctx, hdr);
+    return ret;
 
-#undef val_incr
 #undef return_err
-#undef return_err_inv_param
-#undef save_incr_state
-#undef check_maybe_truncated_number
 }
 
-#endif /* YYJSON_DISABLE_INCR_READER */
-
 #undef has_flg
 #undef has_allow
 #endif /* YYJSON_DISABLE_READER */
@@ -8390,8 +12648,10 @@ static_noinline u8 *write_f64_raw_fixed(u8 *buf, u64 raw,
 
 #endif /* FP_WRITER */
 
-/** Write a JSON number (requires 40 bytes buffer). */
-static_inline u8 *write_num(u8 *cur, yyjson_val *val, yyjson_write_flag flg) {
+/** Write a JSON number (requires 40 bytes buffer), `val_fmt` is the output
+    format of real number, see `YYJSON_WRITE_FP_TO_xxx`. */
+static_inline u8 *write_num_fmt(u8 *cur, yyjson_val *val, u32 val_fmt,
+                                yyjson_write_flag flg) {
     if (!(val->tag & YYJSON_SUBTYPE_REAL)) {
         u64 pos = val->uni.u64;
         u64 neg = ~pos + 1;
@@ -8400,7 +12660,6 @@ static_inline u8 *write_num(u8 *cur, yyjson_val *val, yyjson_write_flag flg) {
         return write_u64(sign ? neg : pos, cur + sign);
     } else {
         u64 raw = val->uni.u64;
-        u32 val_fmt = (u32)(val->tag >> 32);
         u32 all_fmt = flg;
         u32 fmt = val_fmt | all_fmt;
         if (likely(!(fmt >> (32 - YYJSON_WRITE_FP_FLAG_BITS)))) {
@@ -8424,6 +12683,11 @@ static_inline u8 *write_num(u8 *cur, yyjson_val *val, yyjson_write_flag flg) {
     }
 }
 
+/** Write a JSON number (requires 40 bytes buffer). */
+static_inline u8 *write_num(u8 *cur, yyjson_val *val, yyjson_write_flag flg) {
+    return write_num_fmt(cur, val, (u32)(val->tag >> 32), flg);
+}
+
 char *yyjson_write_number(const yyjson_val *val, char *buf) {
     if (unlikely(!val || !buf)) return NULL;
     switch (val->tag & YYJSON_TAG_MASK) {
@@ -8464,6 +12728,15 @@ char *yyjson_write_number(const yyjson_val *val, char *buf) {
     }
 }
 
+#if YYJSON_MUT_COMPACT
+char *yyjson_mut_write_number(const yyjson_mut_val *val, char *buf) {
+    yyjson_val num;
+    if (unlikely(!val || !buf)) return NULL;
+    unsafe_yyjson_mut_val_to_imut(&num, val);
+    return yyjson_write_number(&num, buf);
+}
+#endif
+
 
 
 /*==============================================================================
@@ -8835,6 +13108,24 @@ static_inline u8 *write_str_noesc(u8 *cur, const u8 *str, usize str_len) {
     return cur;
 }
 
+/**
+ Returns whether the string has only ASCII characters that don't need to be
+ escaped, that is, no byte of the string is marked in `enc_table_cpy`.
+ */
+static_inline bool write_str_is_noesc(const u8 *str, usize str_len) {
+    const u8 *end = str + str_len;
+#if YYJSON_HAS_SIMD
+    while (end - str >= SIMD_STR_SIZE) {
+        if (simd_str_stop(str, '"') < SIMD_STR_SIZE) return false;
+        str += SIMD_STR_SIZE;
+    }
+#endif
+    while (end > str) {
+        if (enc_table_cpy[*str++]) return false;
+    }
+    return true;
+}
+
 /**
  Write UTF-8 string (requires len * 6 + 2 bytes buffer).
  @param cur Buffer cursor.
@@ -8856,9 +13147,26 @@ static_inline u8 *write_str(u8 *cur, bool esc, bool inv,
 
     const u8 *src = str;
     const u8 *end = str + str_len;
+#if YYJSON_HAS_SIMD
+    /* the slash stops the SIMD copy only if the table escapes it */
+    const u8 sla = enc_table['/'] ? (u8)'/' : (u8)'"';
+#endif
     *cur++ = '"';
 
 copy_ascii:
+#if YYJSON_HAS_SIMD
+    /*
+     Copy continuous ASCII in blocks, the whole block is copied and the cursor
+     is moved to the first byte that needs the table (there are at least
+     `SIMD_STR_SIZE` bytes left for the output, see the buffer size above).
+     */
+    while (end - src >= SIMD_STR_SIZE) {
+        usize n = simd_str_esc_copy(cur, src, sla);
+        cur += n; src += n;
+        if (n < SIMD_STR_SIZE) goto copy_utf8;
+    }
+#endif
+
     /*
      Copy continuous ASCII, loop unrolling, same as the following code:
 
@@ -9098,6 +13406,58 @@ static_inline u8 *write_indent(u8 *cur, usize level, usize spaces) {
     return cur;
 }
 
+/** The output of the streaming writer. */
+typedef struct write_sink {
+    yyjson_write_sink func; /* the sink function */
+    void *ctx; /* the sink context */
+    usize buf_len; /* initial size of the buffer */
+    usize total; /* number of bytes flushed to the sink */
+    yyjson_write_sink ref; /* the sink of the referenced strings, or NULL */
+    usize ref_len; /* the minimum length of the referenced strings */
+    yyjson_write_sink esc; /* the sink escaping the referenced strings itself,
+                              or NULL, its output is not counted in `total` */
+} write_sink;
+
+/** Returns whether a string (or raw value) should be passed to the sink by
+    reference, instead of being copied to the buffer. */
+#define write_sink_can_ref(sink, len) \
+    (unlikely(sink != NULL) && sink->ref && len >= sink->ref_len)
+
+/** Returns whether a string that may need escapes can be passed to the sink
+    by reference, see `write_sink_can_ref()`. */
+#define write_sink_can_esc(sink, len) \
+    (write_sink_can_ref(sink, len) && sink->esc)
+
+/* Number of bytes kept in the buffer after a flush, the writer may rewrite
+   the trailing comma and newline of the last value. */
+#define WRITE_SINK_KEEP 2
+
+/** Flush the written data to the sink, except for the last few bytes. */
+static_noinline bool write_sink_flush(write_sink *sink, u8 *hdr, u8 **cur) {
+    usize len = (usize)(*cur - hdr);
+    if (len <= WRITE_SINK_KEEP) return true;
+    len -= WRITE_SINK_KEEP;
+    if (!sink->func(sink->ctx, (const char *)hdr, len)) return false;
+    memmove(hdr, hdr + len, WRITE_SINK_KEEP);
+    *cur = hdr + WRITE_SINK_KEEP;
+    sink->total += len;
+    return true;
+}
+
+/** Flush all the written data to the sink, then pass the string to the sink
+    by reference, without copying it to the buffer. If `esc` is true, the
+    string is passed to the escaping sink if there is one. */
+static_noinline bool write_sink_ref(write_sink *sink, u8 *hdr, u8 **cur,
+                                    const u8 *str, usize str_len, bool esc) {
+    usize len = (usize)(*cur - hdr);
+    yyjson_write_sink ref = (esc && sink->esc) ? sink->esc : sink->ref;
+    if (len && !sink->func(sink->ctx, (const char *)hdr, len)) return false;
+    *cur = hdr;
+    if (!ref(sink->ctx, (const char *)str, str_len)) return false;
+    sink->total += len + str_len;
+    return true;
+}
+
 #if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
 
 /** Write data to file pointer. */
@@ -9161,6 +13521,17 @@ static_inline void yyjson_write_ctx_get(yyjson_write_ctx *ctx,
     *is_obj = (bool)(tag & 1);
 }
 
+/** A part of the root container for the parallel writer. */
+typedef struct write_part {
+    const yyjson_val *val; /* the first element (or key) of this part */
+    usize len; /* the number of elements (or key-value pairs) */
+    usize size; /* the size of the values of this part in bytes */
+    usize pos; /* the position of this part in the output */
+    u8 *dat; /* the output of this part, written as a container */
+    usize dat_len; /* the length of the output */
+    yyjson_write_err err; /* the error information */
+} write_part;
+
 /** Write single JSON value. */
 static_inline u8 *write_root_single(yyjson_val *val,
                                     yyjson_write_flag flg,
@@ -9270,12 +13641,15 @@ fail_str:   return_err(INVALID_STRING, MSG_ERR_UTF8);
 }
 
 /** Write JSON document minify.
-    The root of this document should be a non-empty container. */
+    The root of this document should be a non-empty container.
+    If `part` is not NULL, only the elements of this part are written. */
 static_inline u8 *write_root_minify(const yyjson_val *root,
                                     const yyjson_write_flag flg,
                                     const yyjson_alc alc,
                                     char *buf, usize *dat_len,
-                                    yyjson_write_err *err) {
+                                    write_sink *sink,
+                                    yyjson_write_err *err,
+                                    const write_part *part) {
 #define return_err(_code, _msg) do { \
     *dat_len = 0; \
     err->code = YYJSON_WRITE_ERROR_##_code; \
@@ -9287,23 +13661,26 @@ static_inline u8 *write_root_minify(const yyjson_val *root,
 #define incr_len(_len) do { \
     ext_len = (usize)(_len); \
     if (unlikely((u8 *)(cur + ext_len) >= (u8 *)ctx)) { \
-        usize ctx_pos = (usize)((u8 *)ctx - hdr); \
-        usize cur_pos = (usize)(cur - hdr); \
-        yyjson_assume((u8 *)ctx <= (u8 *)end); \
-        ctx_len = (usize)((u8 *)end - (u8 *)ctx); \
-        alc_inc = yyjson_max(alc_len / 2, ext_len); \
-        alc_inc = size_align_up(alc_inc, sizeof(yyjson_write_ctx)); \
-        if ((sizeof(usize) < 8) && size_add_is_overflow(alc_len, alc_inc)) \
-            goto fail_alloc; \
-        alc_len += alc_inc; \
-        tmp = (u8 *)alc.realloc(alc.ctx, hdr, alc_len - alc_inc, alc_len); \
-        if (unlikely(!tmp)) goto fail_alloc; \
-        ctx_tmp = (yyjson_write_ctx *)(void *)(tmp + (alc_len - ctx_len)); \
-        memmove((void *)ctx_tmp, (void *)(tmp + ctx_pos), ctx_len); \
-        ctx = ctx_tmp; \
-        cur = tmp + cur_pos; \
-        end = tmp + alc_len; \
-        hdr = tmp; \
+        if (sink && !write_sink_flush(sink, hdr, &cur)) goto fail_sink; \
+        if ((u8 *)(cur + ext_len) >= (u8 *)ctx) { \
+            usize ctx_pos = (usize)((u8 *)ctx - hdr); \
+            usize cur_pos = (usize)(cur - hdr); \
+            yyjson_assume((u8 *)ctx <= (u8 *)end); \
+            ctx_len = (usize)((u8 *)end - (u8 *)ctx); \
+            alc_inc = yyjson_max(alc_len / 2, ext_len); \
+            alc_inc = size_align_up(alc_inc, sizeof(yyjson_write_ctx)); \
+            if ((sizeof(usize) < 8) && size_add_is_overflow(alc_len, alc_inc)) \
+                goto fail_alloc; \
+            alc_len += alc_inc; \
+            tmp = (u8 *)alc.realloc(alc.ctx, hdr, alc_len - alc_inc, alc_len); \
+            if (unlikely(!tmp)) goto fail_alloc; \
+            ctx_tmp = (yyjson_write_ctx *)(void *)(tmp + (alc_len - ctx_len)); \
+            memmove((void *)ctx_tmp, (void *)(tmp + ctx_pos), ctx_len); \
+            ctx = ctx_tmp; \
+            cur = tmp + cur_pos; \
+            end = tmp + alc_len; \
+            hdr = tmp; \
+        } \
     } \
 } while (false)
 
@@ -9333,8 +13710,9 @@ static_inline u8 *write_root_minify(const yyjson_val *root,
         alc_len = size_align_down(alc_len, sizeof(yyjson_write_ctx));
         if (alc_len <= sizeof(yyjson_write_ctx)) goto fail_alloc;
     } else {
-        alc_len = root->uni.ofs / sizeof(yyjson_val);
+        alc_len = (part ? part->size : root->uni.ofs) / sizeof(yyjson_val);
         alc_len = alc_len * YYJSON_WRITER_ESTIMATED_MINIFY_RATIO + 64;
+        if (sink) alc_len = sink->buf_len;
         alc_len = size_align_up(alc_len, sizeof(yyjson_write_ctx));
         hdr = (u8 *)alc.malloc(alc.ctx, alc_len);
         if (!hdr) goto fail_alloc;
@@ -9350,6 +13728,10 @@ doc_begin:
     ctn_len = unsafe_yyjson_get_len(val) << (u8)ctn_obj;
     *cur++ = (u8)('[' | ((u8)ctn_obj << 5));
     val++;
+    if (part) {
+        val = constcast(yyjson_val *)part->val;
+        ctn_len = part->len << (u8)ctn_obj;
+    }
 
 val_begin:
     val_type = unsafe_yyjson_get_type(val);
@@ -9358,6 +13740,19 @@ val_begin:
         str_len = unsafe_yyjson_get_len(val);
         str_ptr = (const u8 *)unsafe_yyjson_get_str(val);
         check_str_len(str_len);
+        if (write_sink_can_esc(sink, str_len) ||
+            (write_sink_can_ref(sink, str_len) && cpy &&
+             (unsafe_yyjson_get_subtype(val) ||
+              write_str_is_noesc(str_ptr, str_len)))) {
+            incr_len(16);
+            *cur++ = '"';
+            if (!write_sink_ref(sink, hdr, &cur, str_ptr, str_len, true)) {
+                goto fail_sink;
+            }
+            *cur++ = '"';
+            *cur++ = is_key ? ':' : ',';
+            goto val_end;
+        }
         incr_len(str_len * 6 + 16);
         if (likely(cpy) && unsafe_yyjson_get_subtype(val)) {
             cur = write_str_noesc(cur, str_ptr, str_len);
@@ -9413,6 +13808,14 @@ val_begin:
         str_len = unsafe_yyjson_get_len(val);
         str_ptr = (const u8 *)unsafe_yyjson_get_str(val);
         check_str_len(str_len);
+        if (write_sink_can_ref(sink, str_len)) {
+            incr_len(2);
+            if (!write_sink_ref(sink, hdr, &cur, str_ptr, str_len, false)) {
+                goto fail_sink;
+            }
+            *cur++ = ',';
+            goto val_end;
+        }
         incr_len(str_len + 2);
         cur = write_raw(cur, str_ptr, str_len);
         *cur++ = ',';
@@ -9454,6 +13857,7 @@ fail_alloc: return_err(MEMORY_ALLOCATION, MSG_MALLOC);
 fail_type:  return_err(INVALID_VALUE_TYPE, MSG_ERR_TYPE);
 fail_num:   return_err(NAN_OR_INF, MSG_NAN_INF);
 fail_str:   return_err(INVALID_STRING, MSG_ERR_UTF8);
+fail_sink:  return_err(FILE_WRITE, MSG_SINK);
 
 #undef return_err
 #undef incr_len
@@ -9461,12 +13865,15 @@ fail_str:   return_err(INVALID_STRING, MSG_ERR_UTF8);
 }
 
 /** Write JSON document pretty.
-    The root of this document should be a non-empty container. */
+    The root of this document should be a non-empty container.
+    If `part` is not NULL, only the elements of this part are written. */
 static_inline u8 *write_root_pretty(const yyjson_val *root,
                                     const yyjson_write_flag flg,
                                     const yyjson_alc alc,
                                     char *buf, usize *dat_len,
-                                    yyjson_write_err *err) {
+                                    write_sink *sink,
+                                    yyjson_write_err *err,
+                                    const write_part *part) {
 #define return_err(_code, _msg) do { \
     *dat_len = 0; \
     err->code = YYJSON_WRITE_ERROR_##_code; \
@@ -9478,23 +13885,26 @@ static_inline u8 *write_root_pretty(const yyjson_val *root,
 #define incr_len(_len) do { \
     ext_len = (usize)(_len); \
     if (unlikely((u8 *)(cur + ext_len) >= (u8 *)ctx)) { \
-        usize ctx_pos = (usize)((u8 *)ctx - hdr); \
-        usize cur_pos = (usize)(cur - hdr); \
-        yyjson_assume((u8 *)ctx <= (u8 *)end); \
-        ctx_len = (usize)((u8 *)end - (u8 *)ctx); \
-        alc_inc = yyjson_max(alc_len / 2, ext_len); \
-        alc_inc = size_align_up(alc_inc, sizeof(yyjson_write_ctx)); \
-        if ((sizeof(usize) < 8) && size_add_is_overflow(alc_len, alc_inc)) \
-            goto fail_alloc; \
-        alc_len += alc_inc; \
-        tmp = (u8 *)alc.realloc(alc.ctx, hdr, alc_len - alc_inc, alc_len); \
-        if (unlikely(!tmp)) goto fail_alloc; \
-        ctx_tmp = (yyjson_write_ctx *)(void *)(tmp + (alc_len - ctx_len)); \
-        memmove((void *)ctx_tmp, (void *)(tmp + ctx_pos), ctx_len); \
-        ctx = ctx_tmp; \
-        cur = tmp + cur_pos; \
-        end = tmp + alc_len; \
-        hdr = tmp; \
+        if (sink && !write_sink_flush(sink, hdr, &cur)) goto fail_sink; \
+        if ((u8 *)(cur + ext_len) >= (u8 *)ctx) { \
+            usize ctx_pos = (usize)((u8 *)ctx - hdr); \
+            usize cur_pos = (usize)(cur - hdr); \
+            yyjson_assume((u8 *)ctx <= (u8 *)end); \
+            ctx_len = (usize)((u8 *)end - (u8 *)ctx); \
+            alc_inc = yyjson_max(alc_len / 2, ext_len); \
+            alc_inc = size_align_up(alc_inc, sizeof(yyjson_write_ctx)); \
+            if ((sizeof(usize) < 8) && size_add_is_overflow(alc_len, alc_inc)) \
+                goto fail_alloc; \
+            alc_len += alc_inc; \
+            tmp = (u8 *)alc.realloc(alc.ctx, hdr, alc_len - alc_inc, alc_len); \
+            if (unlikely(!tmp)) goto fail_alloc; \
+            ctx_tmp = (yyjson_write_ctx *)(void *)(tmp + (alc_len - ctx_len)); \
+            memmove((void *)ctx_tmp, (void *)(tmp + ctx_pos), ctx_len); \
+            ctx = ctx_tmp; \
+            cur = tmp + cur_pos; \
+            end = tmp + alc_len; \
+            hdr = tmp; \
+        } \
     } \
 } while (false)
 
@@ -9525,8 +13935,9 @@ static_inline u8 *write_root_pretty(const yyjson_val *root,
         alc_len = size_align_down(alc_len, sizeof(yyjson_write_ctx));
         if (alc_len <= sizeof(yyjson_write_ctx)) goto fail_alloc;
     } else {
-        alc_len = root->uni.ofs / sizeof(yyjson_val);
+        alc_len = (part ? part->size : root->uni.ofs) / sizeof(yyjson_val);
         alc_len = alc_len * YYJSON_WRITER_ESTIMATED_PRETTY_RATIO + 64;
+        if (sink) alc_len = sink->buf_len;
         alc_len = size_align_up(alc_len, sizeof(yyjson_write_ctx));
         hdr = (u8 *)alc.malloc(alc.ctx, alc_len);
         if (!hdr) goto fail_alloc;
@@ -9544,6 +13955,10 @@ doc_begin:
     *cur++ = '\n';
     val++;
     level = 1;
+    if (part) {
+        val = constcast(yyjson_val *)part->val;
+        ctn_len = part->len << (u8)ctn_obj;
+    }
 
 val_begin:
     val_type = unsafe_yyjson_get_type(val);
@@ -9553,6 +13968,21 @@ val_begin:
         str_len = unsafe_yyjson_get_len(val);
         str_ptr = (const u8 *)unsafe_yyjson_get_str(val);
         check_str_len(str_len);
+        if (write_sink_can_esc(sink, str_len) ||
+            (write_sink_can_ref(sink, str_len) && cpy &&
+             (unsafe_yyjson_get_subtype(val) ||
+              write_str_is_noesc(str_ptr, str_len)))) {
+            incr_len(16 + (no_indent ? 0 : level * 4));
+            cur = write_indent(cur, no_indent ? 0 : level, spaces);
+            *cur++ = '"';
+            if (!write_sink_ref(sink, hdr, &cur, str_ptr, str_len, true)) {
+                goto fail_sink;
+            }
+            *cur++ = '"';
+            *cur++ = is_key ? ':' : ',';
+            *cur++ = is_key ? ' ' : '\n';
+            goto val_end;
+        }
         if ((sizeof(usize) < 8) && !no_indent &&
             level > (USIZE_MAX - 16 - str_len * 6) / 4) goto fail_alloc;
         incr_len(str_len * 6 + 16 + (no_indent ? 0 : level * 4));
@@ -9626,6 +14056,16 @@ val_begin:
         str_len = unsafe_yyjson_get_len(val);
         str_ptr = (const u8 *)unsafe_yyjson_get_str(val);
         check_str_len(str_len);
+        if (write_sink_can_ref(sink, str_len)) {
+            incr_len(3 + (no_indent ? 0 : level * 4));
+            cur = write_indent(cur, no_indent ? 0 : level, spaces);
+            if (!write_sink_ref(sink, hdr, &cur, str_ptr, str_len, false)) {
+                goto fail_sink;
+            }
+            *cur++ = ',';
+            *cur++ = '\n';
+            goto val_end;
+        }
         incr_len(str_len + 3 + (no_indent ? 0 : level * 4));
         cur = write_indent(cur, no_indent ? 0 : level, spaces);
         cur = write_raw(cur, str_ptr, str_len);
@@ -9633,60 +14073,519 @@ val_begin:
         *cur++ = '\n';
         goto val_end;
     }
-    goto fail_type;
+    goto fail_type;
+
+val_end:
+    val++;
+    ctn_len--;
+    if (unlikely(ctn_len == 0)) goto ctn_end;
+    goto val_begin;
+
+ctn_end:
+    cur -= 2;
+    *cur++ = '\n';
+    incr_len(level * 4);
+    cur = write_indent(cur, --level, spaces);
+    *cur++ = (u8)(']' | ((u8)ctn_obj << 5));
+    if (unlikely((u8 *)ctx >= end)) goto doc_end;
+    yyjson_write_ctx_get(ctx++, &ctn_len, &ctn_obj);
+    ctn_len--;
+    *cur++ = ',';
+    *cur++ = '\n';
+    if (likely(ctn_len > 0)) {
+        goto val_begin;
+    } else {
+        goto ctn_end;
+    }
+
+doc_end:
+    if (newline) {
+        incr_len(2);
+        *cur++ = '\n';
+    }
+    *cur = '\0';
+    *dat_len = (usize)(cur - hdr);
+    memset(err, 0, sizeof(yyjson_write_err));
+    return hdr;
+
+fail_alloc: return_err(MEMORY_ALLOCATION, MSG_MALLOC);
+fail_type:  return_err(INVALID_VALUE_TYPE, MSG_ERR_TYPE);
+fail_num:   return_err(NAN_OR_INF, MSG_NAN_INF);
+fail_str:   return_err(INVALID_STRING, MSG_ERR_UTF8);
+fail_sink:  return_err(FILE_WRITE, MSG_SINK);
+
+#undef return_err
+#undef incr_len
+#undef check_str_len
+}
+
+/*==============================================================================
+ * MARK: - JSON Writer Length (Private)
+ *
+ * The output length is counted without writing the output: the brackets, the
+ * separators and the indents are counted from the number of values and their
+ * nesting level, and the strings without escapes from their length. Only the
+ * numbers and the strings with escapes are measured, a number is written to a
+ * local buffer, an escaped string is scanned with the encoding table.
+ *
+ * In the pretty output, a value at level `n` (the root is at level 0) takes
+ * `n * spaces` bytes of indent (except an object value) and 2 bytes of
+ * separator (`,\n` or `: `). A non-empty container takes `n * spaces + 2`
+ * bytes for the brackets, the newline after `[` and the indent before `]`,
+ * as the separator after its last value is replaced by a newline. In the
+ * minified output, the separator takes 1 byte and a non-empty container takes
+ * 1 byte, as the separator after its last value is replaced by `]`.
+ *============================================================================*/
+
+/** The nesting level of the length counter. */
+typedef struct write_len_ctx {
+    const void *ctn; /* the container */
+    usize tag; /* the values left (twice the pairs for an object) shifted
+                  left by 1, the lowest bit is set for an object */
+} write_len_ctx;
+
+/** The initial depth of the stack of the length counter. */
+#define WRITE_LEN_STACK_SIZE 32
+
+/**
+ Returns the length of an escaped string with the quotes, see `write_str()`,
+ or 0 on invalid unicode.
+ */
+static_noinline usize write_str_len(bool esc, bool inv,
+                                    const u8 *str, usize str_len,
+                                    const char_enc_type *enc_table) {
+    const u8 *src = str;
+    const u8 *end = str + str_len;
+    usize len = 2;
+    char_enc_type type;
+
+    while (src < end) {
+        type = enc_table[*src];
+        if (likely(type == CHAR_ENC_CPY_1)) {
+            len++;
+            src++;
+            continue;
+        }
+        if (unlikely(src + 4 > end) && end - src < type / 2) goto err_one;
+        switch (type) {
+            case CHAR_ENC_CPY_2: {
+#if !YYJSON_DISABLE_UTF8_VALIDATION
+                u32 uni = 0;
+                byte_copy_2(&uni, src);
+                if (unlikely(!is_utf8_seq2(uni))) goto err_cpy;
+#endif
+                len += 2;
+                src += 2;
+                continue;
+            }
+            case CHAR_ENC_CPY_3: {
+#if !YYJSON_DISABLE_UTF8_VALIDATION
+                u32 uni, tmp;
+                if (likely(src + 4 <= end)) uni = byte_load_4(src);
+                else uni = byte_load_3(src);
+                if (unlikely(!is_utf8_seq3(uni))) goto err_cpy;
+#endif
+                len += 3;
+                src += 3;
+                continue;
+            }
+            case CHAR_ENC_CPY_4: {
+#if !YYJSON_DISABLE_UTF8_VALIDATION
+                u32 uni, tmp;
+                uni = byte_load_4(src);
+                if (unlikely(!is_utf8_seq4(uni))) goto err_cpy;
+#endif
+                len += 4;
+                src += 4;
+                continue;
+            }
+            case CHAR_ENC_ESC_A: {
+                len += 2;
+                src += 1;
+                continue;
+            }
+            case CHAR_ENC_ESC_1: {
+                len += 6;
+                src += 1;
+                continue;
+            }
+            case CHAR_ENC_ESC_2: {
+#if !YYJSON_DISABLE_UTF8_VALIDATION
+                u32 v4 = 0;
+                u16 v2 = byte_load_2(src);
+                byte_copy_2(&v4, &v2);
+                if (unlikely(!is_utf8_seq2(v4))) goto err_esc;
+#endif
+                len += 6;
+                src += 2;
+                continue;
+            }
+            case CHAR_ENC_ESC_3: {
+#if !YYJSON_DISABLE_UTF8_VALIDATION
+                u32 v, tmp;
+                v = byte_load_3(src);
+                if (unlikely(!is_utf8_seq3(v))) goto err_esc;
+#endif
+                len += 6;
+                src += 3;
+                continue;
+            }
+            case CHAR_ENC_ESC_4: {
+#if !YYJSON_DISABLE_UTF8_VALIDATION
+                u32 v, tmp;
+                v = byte_load_4(src);
+                if (unlikely(!is_utf8_seq4(v))) goto err_esc;
+#endif
+                len += 12;
+                src += 4;
+                continue;
+            }
+            default: goto err_one;
+        }
+
+err_one:
+        if (esc) goto err_esc;
+        else goto err_cpy;
+
+err_cpy:
+        if (!inv) return 0;
+        len += 1;
+        src += 1;
+        continue;
+
+err_esc:
+        if (!inv) return 0;
+        len += 6;
+        src += 1;
+    }
+    return len;
+}
+
+/** Returns the length of a scalar value (or mutable value) in the output,
+    the error is set in `err`. */
+static_inline usize write_len_scalar(const void *ptr, bool mut,
+                                     yyjson_write_flag flg,
+                                     const char_enc_type *enc_table,
+                                     yyjson_write_err *err) {
+    yyjson_val *val = (yyjson_val *)constcast(void *)ptr;
+    const yyjson_mut_val *mval = (const yyjson_mut_val *)ptr;
+    u8 buf[FP_BUF_LEN], *cur;
+    usize str_len;
+    const u8 *str_ptr;
+    u32 val_fmt;
+    bool cpy = (enc_table == enc_table_cpy);
+
+    switch (unsafe_yyjson_get_type(val)) {
+        case YYJSON_TYPE_STR:
+            str_len = mut ? unsafe_yyjson_mut_get_len(mval)
+                          : unsafe_yyjson_get_len(val);
+            str_ptr = (const u8 *)(mut ? unsafe_yyjson_mut_get_str(mval)
+                                       : unsafe_yyjson_get_str(val));
+            if ((sizeof(usize) < 8) && str_len >= (USIZE_MAX - 16) / 6) break;
+            if (likely(cpy) && (unsafe_yyjson_get_subtype(val) ||
+                                write_str_is_noesc(str_ptr, str_len))) {
+                return str_len + 2;
+            }
+            str_len = write_str_len(has_flg(ESCAPE_UNICODE) != 0,
+                                    has_allow(INVALID_UNICODE) != 0,
+                                    str_ptr, str_len, enc_table);
+            if (unlikely(!str_len)) {
+                err->code = YYJSON_WRITE_ERROR_INVALID_STRING;
+                err->msg = MSG_ERR_UTF8;
+                return 0;
+            }
+            return str_len;
+        case YYJSON_TYPE_NUM:
+            val_fmt = mut ? unsafe_yyjson_mut_get_fp_fmt(mval)
+                          : (u32)(val->tag >> 32);
+            cur = write_num_fmt(buf, val, val_fmt, flg);
+            if (unlikely(!cur)) {
+                err->code = YYJSON_WRITE_ERROR_NAN_OR_INF;
+                err->msg = MSG_NAN_INF;
+                return 0;
+            }
+            return (usize)(cur - buf);
+        case YYJSON_TYPE_RAW:
+            str_len = mut ? unsafe_yyjson_mut_get_len(mval)
+                          : unsafe_yyjson_get_len(val);
+            if ((sizeof(usize) < 8) && str_len >= (USIZE_MAX - 16) / 6) break;
+            return str_len;
+        case YYJSON_TYPE_BOOL:
+            return unsafe_yyjson_get_bool(val) ? 4 : 5;
+        case YYJSON_TYPE_NULL:
+            return 4;
+        default:
+            err->code = YYJSON_WRITE_ERROR_INVALID_VALUE_TYPE;
+            err->msg = MSG_ERR_TYPE;
+            return 0;
+    }
+    err->code = YYJSON_WRITE_ERROR_MEMORY_ALLOCATION;
+    err->msg = MSG_MALLOC;
+    return 0;
+}
+
+/**
+ Returns the output length of a value, without the null-terminator,
+ the error is set in `err`. The stack grows with `alc` for the deep nesting
+ levels.
+ */
+static_noinline usize write_len_root(const yyjson_val *root,
+                                     yyjson_write_flag flg,
+                                     const yyjson_alc *alc,
+                                     yyjson_write_err *err) {
+#define return_err(_code, _msg) do { \
+    err->code = YYJSON_WRITE_ERROR_##_code; \
+    err->msg = _msg; \
+    goto fail; \
+} while (false)
+
+    write_len_ctx stk_buf[WRITE_LEN_STACK_SIZE];
+    write_len_ctx *stk = stk_buf, *top = NULL, *tmp;
+    usize stk_cap = WRITE_LEN_STACK_SIZE, level = 0, ctn_len;
+    bool obj;
+    u64 len = 0;
+    yyjson_val *val = constcast(yyjson_val *)root;
+    yyjson_type val_type;
+    const char_enc_type *enc_table = get_enc_table_with_flag(flg);
+    bool pretty = (flg & (YYJSON_WRITE_PRETTY |
+                          YYJSON_WRITE_PRETTY_TWO_SPACES)) != 0;
+    usize spaces = has_flg(PRETTY_TWO_SPACES) ? 2 : 4;
+    usize sep = pretty ? 2 : 1;
+
+    memset(err, 0, sizeof(yyjson_write_err));
+
+val_begin:
+    if (level) {
+        len += sep;
+        /* the object values are not indented */
+        if (pretty && (top->tag & 3) != 3) len += level * spaces;
+    }
+    val_type = unsafe_yyjson_get_type(val);
+    if (val_type == YYJSON_TYPE_ARR || val_type == YYJSON_TYPE_OBJ) {
+        ctn_len = unsafe_yyjson_get_len(val);
+        if (ctn_len == 0) {
+            len += 2;
+            goto val_end;
+        }
+        len += pretty ? level * spaces + 2 : 1;
+        if (unlikely(level == stk_cap)) {
+            tmp = (write_len_ctx *)alc->malloc(alc->ctx,
+                                               stk_cap * 2 * sizeof(*stk));
+            if (unlikely(!tmp)) return_err(MEMORY_ALLOCATION, MSG_MALLOC);
+            memcpy(tmp, stk, stk_cap * sizeof(*stk));
+            if (stk != stk_buf) alc->free(alc->ctx, stk);
+            stk = tmp;
+            stk_cap *= 2;
+        }
+        top = stk + level++;
+        obj = (val_type == YYJSON_TYPE_OBJ);
+        top->tag = (ctn_len << ((u8)obj + 1)) | (usize)obj;
+        val++;
+        goto val_begin;
+    }
+    len += write_len_scalar(val, false, flg, enc_table, err);
+    if (unlikely(err->code)) goto fail;
 
 val_end:
     val++;
-    ctn_len--;
-    if (unlikely(ctn_len == 0)) goto ctn_end;
-    goto val_begin;
+    while (level && (top->tag -= 2) < 2) {
+        top = --level ? top - 1 : NULL;
+    }
+    if (level) goto val_begin;
 
-ctn_end:
-    cur -= 2;
-    *cur++ = '\n';
-    incr_len(level * 4);
-    cur = write_indent(cur, --level, spaces);
-    *cur++ = (u8)(']' | ((u8)ctn_obj << 5));
-    if (unlikely((u8 *)ctx >= end)) goto doc_end;
-    yyjson_write_ctx_get(ctx++, &ctn_len, &ctn_obj);
-    ctn_len--;
-    *cur++ = ',';
-    *cur++ = '\n';
-    if (likely(ctn_len > 0)) {
-        goto val_begin;
-    } else {
-        goto ctn_end;
+    if (has_flg(NEWLINE_AT_END)) len++;
+    if ((sizeof(usize) < 8) && len >= USIZE_MAX) {
+        return_err(MEMORY_ALLOCATION, MSG_MALLOC);
     }
+    if (stk != stk_buf) alc->free(alc->ctx, stk);
+    return (usize)len;
 
-doc_end:
-    if (newline) {
-        incr_len(2);
-        *cur++ = '\n';
+fail:
+    if (stk != stk_buf) alc->free(alc->ctx, stk);
+    return 0;
+
+#undef return_err
+}
+
+/** The output of the exact-size writer, with the options to escape the
+    strings written to the output by reference. */
+typedef struct write_exact_out {
+    u8 *cur; /* the write position */
+    u8 *end; /* the end of the output, excluding the null-terminator */
+    bool esc; /* escape unicode */
+    bool inv; /* allow invalid unicode */
+    bool bad_str; /* a string has invalid unicode */
+    const char_enc_type *enc_table; /* the encode type table */
+    const u8 *hex_table; /* the hex digits table */
+} write_exact_out;
+
+/* The length of the pieces of a string escaped on the stack by the
+   exact-size writer, when the output has no room to escape it in place. */
+#define WRITE_EXACT_PIECE_LEN 64
+
+/** The sink of the exact-size writer, copies the data to the output. */
+static bool write_exact_copy(void *ctx, const char *dat, usize len) {
+    write_exact_out *out = (write_exact_out *)ctx;
+    if (unlikely((usize)(out->end - out->cur) < len)) return false;
+    memcpy(out->cur, dat, len);
+    out->cur += len;
+    return true;
+}
+
+/** The string sink of the exact-size writer, escapes a string to the output,
+    the quotes are written by the writer. The string is escaped in place if
+    the output has room for the worst case (see `write_str()`), or else in
+    pieces on the stack, each piece ends before a UTF-8 leading byte. */
+static bool write_exact_str(void *ctx, const char *dat, usize len) {
+    write_exact_out *out = (write_exact_out *)ctx;
+    const u8 *str = (const u8 *)dat, *end = str + len;
+    u8 buf[(WRITE_EXACT_PIECE_LEN + 3) * 6 + 2], *cur;
+    usize n;
+
+    if ((usize)(out->end - out->cur) / 6 > len) {
+        /* rewrite the quote before the string, drop the one after it */
+        cur = write_str(out->cur - 1, out->esc, out->inv, str, len,
+                        out->enc_table, out->hex_table);
+        if (unlikely(!cur)) goto fail_str;
+        out->cur = cur - 1;
+        return true;
     }
-    *cur = '\0';
-    *dat_len = (usize)(cur - hdr);
+    while (str < end) {
+        n = (usize)(end - str);
+        if (n > WRITE_EXACT_PIECE_LEN) {
+            n = WRITE_EXACT_PIECE_LEN;
+            while (n < WRITE_EXACT_PIECE_LEN + 3 && n < (usize)(end - str) &&
+                   (str[n] & 0xC0) == 0x80) n++;
+        }
+        cur = write_str(buf, out->esc, out->inv, str, n,
+                        out->enc_table, out->hex_table);
+        if (unlikely(!cur)) goto fail_str;
+        if (!write_exact_copy(ctx, (const char *)buf + 1,
+                              (usize)(cur - buf) - 2)) return false;
+        str += n;
+    }
+    return true;
+
+fail_str:
+    out->bad_str = true;
+    return false;
+}
+
+/** Initialize the exact-size writer for a buffer of `len + 1` bytes, where
+    `len` is the output length counted by `write_len_root()` or
+    `mut_write_len_root()`. The strings and raw values of at least
+    `YYJSON_WRITER_EXACT_REF_LEN` bytes are written straight to the output,
+    the rest goes through the buffer of the streaming writer, its initial size
+    is `tmp_len`. */
+static void write_exact_init(write_exact_out *out, write_sink *sink,
+                             yyjson_write_flag flg, usize tmp_len,
+                             u8 *buf, usize len,
+                             yyjson_write_err *err) {
+    out->cur = buf;
+    out->end = buf + len;
+    out->esc = has_flg(ESCAPE_UNICODE) != 0;
+    out->inv = has_allow(INVALID_UNICODE) != 0;
+    out->bad_str = false;
+    out->enc_table = get_enc_table_with_flag(flg);
+    out->hex_table = get_hex_table_with_flag(flg);
+    sink->func = write_exact_copy;
+    sink->ctx = (void *)out;
+    sink->buf_len = tmp_len;
+    sink->total = 0;
+    sink->ref = write_exact_copy;
+    sink->ref_len = YYJSON_WRITER_EXACT_REF_LEN;
+    sink->esc = write_exact_str;
     memset(err, 0, sizeof(yyjson_write_err));
-    return hdr;
+}
 
-fail_alloc: return_err(MEMORY_ALLOCATION, MSG_MALLOC);
-fail_type:  return_err(INVALID_VALUE_TYPE, MSG_ERR_TYPE);
-fail_num:   return_err(NAN_OR_INF, MSG_NAN_INF);
-fail_str:   return_err(INVALID_STRING, MSG_ERR_UTF8);
+/** Write a string (or raw value) as the root with the exact-size writer. */
+static void write_exact_single(write_exact_out *out, const u8 *str,
+                               usize str_len, bool raw,
+                               yyjson_write_flag flg,
+                               yyjson_write_err *err) {
+    bool suc;
+    if (raw) {
+        suc = write_exact_copy(out, (const char *)str, str_len);
+    } else {
+        suc = write_exact_copy(out, "\"", 1) &&
+              write_exact_str(out, (const char *)str, str_len) &&
+              write_exact_copy(out, "\"", 1);
+    }
+    if (suc && has_flg(NEWLINE_AT_END)) suc = write_exact_copy(out, "\n", 1);
+    if (!suc) err->code = YYJSON_WRITE_ERROR_FILE_WRITE;
+}
 
-#undef return_err
-#undef incr_len
-#undef check_str_len
+/** Finish the exact-size writer with the rest of the output in `dat`, which
+    is freed. Returns false on error. */
+static bool write_exact_done(write_exact_out *out, u8 *dat, usize dat_len,
+                             const yyjson_alc *alc, yyjson_write_err *err) {
+    if (dat) {
+        if (!write_exact_copy(out, (const char *)dat, dat_len)) {
+            err->code = YYJSON_WRITE_ERROR_FILE_WRITE;
+        }
+        alc->free(alc->ctx, dat);
+    }
+    if (err->code == YYJSON_WRITE_ERROR_FILE_WRITE ||
+        (!err->code && out->cur != out->end)) {
+        /* the sink fails on invalid unicode, or if the output is too small */
+        if (out->bad_str) {
+            err->code = YYJSON_WRITE_ERROR_INVALID_STRING;
+            err->msg = MSG_ERR_UTF8;
+        } else {
+            err->code = YYJSON_WRITE_ERROR_MEMORY_ALLOCATION;
+            err->msg = MSG_MALLOC;
+        }
+    }
+    if (unlikely(err->code)) return false;
+    *out->cur = '\0';
+    return true;
+}
+
+/** Write a value to a buffer of exactly `len + 1` bytes with the exact-size
+    writer, the buffer of the streaming writer is allocated with `alc`. */
+static bool write_root_exact(const yyjson_val *root,
+                             yyjson_write_flag flg,
+                             yyjson_alc alc, usize tmp_len,
+                             u8 *buf, usize len,
+                             yyjson_write_err *err) {
+    write_exact_out out;
+    write_sink sink;
+    u8 *dat = NULL;
+    usize dat_len = 0;
+    yyjson_type type = unsafe_yyjson_get_type(root);
+
+    write_exact_init(&out, &sink, flg, tmp_len, buf, len, err);
+    if (unsafe_yyjson_is_ctn(root) && unsafe_yyjson_get_len(root) > 0) {
+        if (flg & (YYJSON_WRITE_PRETTY | YYJSON_WRITE_PRETTY_TWO_SPACES)) {
+            dat = write_root_pretty(root, flg, alc, NULL, &dat_len,
+                                    &sink, err, NULL);
+        } else {
+            dat = write_root_minify(root, flg, alc, NULL, &dat_len,
+                                    &sink, err, NULL);
+        }
+    } else if (type == YYJSON_TYPE_STR || type == YYJSON_TYPE_RAW) {
+        write_exact_single(&out, (const u8 *)unsafe_yyjson_get_str(root),
+                           unsafe_yyjson_get_len(root),
+                           type == YYJSON_TYPE_RAW, flg, err);
+    } else {
+        dat = write_root_single(constcast(yyjson_val *)root, flg, alc,
+                                NULL, &dat_len, err);
+    }
+    return write_exact_done(&out, dat, dat_len, &alc, err);
 }
 
 static char *write_root(const yyjson_val *val,
                         yyjson_write_flag flg,
                         const yyjson_alc *alc_ptr,
                         char *buf, usize *dat_len,
-                        yyjson_write_err *err) {
+                        write_sink *sink,
+                        yyjson_write_err *err,
+                        const write_part *part) {
     yyjson_write_err tmp_err;
-    usize tmp_dat_len;
+    usize tmp_dat_len, len;
     yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
     yyjson_val *root = constcast(yyjson_val *)val;
+    u8 *hdr;
 
     if (!err) err = &tmp_err;
     if (!dat_len) dat_len = &tmp_dat_len;
@@ -9698,12 +14597,37 @@ static char *write_root(const yyjson_val *val,
         return NULL;
     }
 
+    if (has_flg(PRESIZE) && !buf && !sink && !part) {
+        len = write_len_root(root, flg, &alc, err);
+        if (unlikely(err->code)) {
+            *dat_len = 0;
+            return NULL;
+        }
+        hdr = (u8 *)alc.malloc(alc.ctx, len + 1);
+        if (unlikely(!hdr)) {
+            *dat_len = 0;
+            err->code = YYJSON_WRITE_ERROR_MEMORY_ALLOCATION;
+            err->msg = MSG_MALLOC;
+            return NULL;
+        }
+        if (unlikely(!write_root_exact(root, flg, alc,
+                                       YYJSON_WRITER_STREAM_BUF_SIZE,
+                                       hdr, len, err))) {
+            alc.free(alc.ctx, hdr);
+            *dat_len = 0;
+            return NULL;
+        }
+        *dat_len = len;
+        return (char *)hdr;
+    }
     if (!unsafe_yyjson_is_ctn(root) || unsafe_yyjson_get_len(root) == 0) {
         return (char *)write_root_single(root, flg, alc, buf, dat_len, err);
     } else if (flg & (YYJSON_WRITE_PRETTY | YYJSON_WRITE_PRETTY_TWO_SPACES)) {
-        return (char *)write_root_pretty(root, flg, alc, buf, dat_len, err);
+        return (char *)write_root_pretty(root, flg, alc, buf, dat_len,
+                                         sink, err, part);
     } else {
-        return (char *)write_root_minify(root, flg, alc, buf, dat_len, err);
+        return (char *)write_root_minify(root, flg, alc, buf, dat_len,
+                                         sink, err, part);
     }
 }
 
@@ -9713,117 +14637,558 @@ static char *write_root(const yyjson_val *val,
  * MARK: - JSON Writer (Public)
  *============================================================================*/
 
-char *yyjson_val_write_opts(const yyjson_val *val,
+char *yyjson_val_write_opts(const yyjson_val *val,
+                            yyjson_write_flag flg,
+                            const yyjson_alc *alc_ptr,
+                            usize *dat_len,
+                            yyjson_write_err *err) {
+    return write_root(val, flg, alc_ptr, NULL, dat_len, NULL, err, NULL);
+}
+
+char *yyjson_write_opts(const yyjson_doc *doc,
+                        yyjson_write_flag flg,
+                        const yyjson_alc *alc_ptr,
+                        usize *dat_len,
+                        yyjson_write_err *err) {
+    yyjson_val *root = doc ? doc->root : NULL;
+    return write_root(root, flg, alc_ptr, NULL, dat_len, NULL, err, NULL);
+}
+
+#if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
+
+bool yyjson_val_write_file(const char *path,
+                           const yyjson_val *val,
+                           yyjson_write_flag flg,
+                           const yyjson_alc *alc_ptr,
+                           yyjson_write_err *err) {
+    yyjson_write_err tmp_err;
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    u8 *dat;
+    usize dat_len = 0;
+    yyjson_val *root = constcast(yyjson_val *)val;
+    bool suc;
+
+    if (!err) err = &tmp_err;
+    if (unlikely(!path || !*path)) {
+        err->msg = "input path is invalid";
+        err->code = YYJSON_READ_ERROR_INVALID_PARAMETER;
+        return false;
+    }
+
+    dat = (u8 *)write_root(root, flg, &alc, NULL, &dat_len, NULL, err, NULL);
+    if (unlikely(!dat)) return false;
+    suc = write_dat_to_file(path, dat, dat_len, err);
+    alc.free(alc.ctx, dat);
+    return suc;
+}
+
+bool yyjson_val_write_fp(FILE *fp,
+                         const yyjson_val *val,
+                         yyjson_write_flag flg,
+                         const yyjson_alc *alc_ptr,
+                         yyjson_write_err *err) {
+    yyjson_write_err tmp_err;
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    u8 *dat;
+    usize dat_len = 0;
+    yyjson_val *root = constcast(yyjson_val *)val;
+    bool suc;
+
+    if (!err) err = &tmp_err;
+    if (unlikely(!fp)) {
+        err->msg = "input fp is invalid";
+        err->code = YYJSON_READ_ERROR_INVALID_PARAMETER;
+        return false;
+    }
+
+    dat = (u8 *)write_root(root, flg, &alc, NULL, &dat_len, NULL, err, NULL);
+    if (unlikely(!dat)) return false;
+    suc = write_dat_to_fp(fp, dat, dat_len, err);
+    alc.free(alc.ctx, dat);
+    return suc;
+}
+
+bool yyjson_write_file(const char *path,
+                       const yyjson_doc *doc,
+                       yyjson_write_flag flg,
+                       const yyjson_alc *alc_ptr,
+                       yyjson_write_err *err) {
+    yyjson_val *root = doc ? doc->root : NULL;
+    return yyjson_val_write_file(path, root, flg, alc_ptr, err);
+}
+
+bool yyjson_write_fp(FILE *fp,
+                     const yyjson_doc *doc,
+                     yyjson_write_flag flg,
+                     const yyjson_alc *alc_ptr,
+                     yyjson_write_err *err) {
+    yyjson_val *root = doc ? doc->root : NULL;
+    return yyjson_val_write_fp(fp, root, flg, alc_ptr, err);
+}
+
+#endif /* !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE */
+
+size_t yyjson_val_write_buf(char *buf, size_t buf_len,
+                            const yyjson_val *val,
+                            yyjson_write_flag flg,
+                            yyjson_write_err *err) {
+    yyjson_write_err tmp_err;
+    yyjson_alc alc;
+    usize stk[YYJSON_WRITER_EXACT_STACK_SIZE / sizeof(usize)];
+    usize len = buf_len;
+
+    if (!err) err = &tmp_err;
+    if (unlikely(!buf || !buf_len)) {
+        err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
+        err->msg = "input buf or buf_len is invalid";
+        return 0;
+    }
+
+    /* write in place, the writer needs some room after the output, retry with
+       the exact-size writer if the buffer is too small for the writer */
+    if (!has_flg(PRESIZE) || !val) {
+        write_root(val, flg, &YYJSON_NULL_ALC, buf, &len, NULL, err, NULL);
+        if (err->code != YYJSON_WRITE_ERROR_MEMORY_ALLOCATION) return len;
+    }
+    yyjson_alc_pool_init(&alc, (void *)stk, sizeof(stk));
+    len = write_len_root(val, flg, &alc, err);
+    if (!err->code && len >= buf_len) {
+        err->code = YYJSON_WRITE_ERROR_MEMORY_ALLOCATION;
+        err->msg = MSG_MALLOC;
+        return 0;
+    }
+    if (!err->code && write_root_exact(val, flg, alc,
+                                       YYJSON_WRITER_EXACT_BUF_SIZE,
+                                       (u8 *)buf, len, err)) {
+        return len;
+    }
+    if (has_flg(PRESIZE) && err->code == YYJSON_WRITE_ERROR_MEMORY_ALLOCATION) {
+        /* the memory on the stack is too small for the nesting levels */
+        len = buf_len;
+        write_root(val, flg, &YYJSON_NULL_ALC, buf, &len, NULL, err, NULL);
+        return len;
+    }
+    return 0;
+}
+
+size_t yyjson_write_buf(char *buf, size_t buf_len,
+                        const yyjson_doc *doc,
+                        yyjson_write_flag flg,
+                        yyjson_write_err *err) {
+    yyjson_val *root = doc ? doc->root : NULL;
+    return yyjson_val_write_buf(buf, buf_len, root, flg, err);
+}
+
+/** Write the JSON output to the sink, with the buffer of the writer.
+    Returns the number of bytes written, or 0 on error. */
+static usize write_dat_to_sink(write_sink *sink, u8 *dat, usize dat_len,
+                               const yyjson_alc *alc, yyjson_write_err *err) {
+    bool suc = !dat_len || sink->func(sink->ctx, (const char *)dat, dat_len);
+    alc->free(alc->ctx, dat);
+    if (unlikely(!suc)) {
+        err->msg = MSG_SINK;
+        err->code = YYJSON_WRITE_ERROR_FILE_WRITE;
+        return 0;
+    }
+    return sink->total + dat_len;
+}
+
+/** Initialize the sink, returns false if the sink function is NULL. */
+static bool write_sink_init(write_sink *sink, yyjson_write_sink func,
+                            void *ctx, usize buf_len, yyjson_write_err *err) {
+    if (unlikely(!func)) {
+        err->msg = "input sink is invalid";
+        err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
+        return false;
+    }
+    sink->func = func;
+    sink->ctx = ctx;
+    sink->buf_len = buf_len ? buf_len : YYJSON_WRITER_STREAM_BUF_SIZE;
+    sink->total = 0;
+    sink->ref = NULL;
+    sink->ref_len = 0;
+    sink->esc = NULL;
+    return true;
+}
+
+/** The output of the vectored writer. The data of the copied segments is
+    stored in order in `dat`, their `base` is NULL until the output is done. */
+typedef struct write_iov_ctx {
+    yyjson_alc alc; /* the allocator */
+    u8 *dat; /* the copied data */
+    usize dat_len, dat_cap; /* the length and capacity of the copied data */
+    yyjson_iovec *iov; /* the segments */
+    usize iov_num, iov_cap; /* the number and capacity of the segments */
+} write_iov_ctx;
+
+/** Grow a buffer of the vectored writer to hold at least `size` bytes. */
+static bool write_iov_grow(const yyjson_alc *alc, void **ptr, usize *cap,
+                           usize size) {
+    usize new_cap = *cap + *cap / 2;
+    void *tmp;
+    if (new_cap < size) new_cap = size;
+    if (new_cap < 64) new_cap = 64;
+    if (*ptr) tmp = alc->realloc(alc->ctx, *ptr, *cap, new_cap);
+    else tmp = alc->malloc(alc->ctx, new_cap);
+    if (unlikely(!tmp)) return false;
+    *ptr = tmp;
+    *cap = new_cap;
+    return true;
+}
+
+/** Add a segment, or extend the last segment if both are copied. */
+static bool write_iov_add(write_iov_ctx *ctx, const char *dat, usize len) {
+    yyjson_iovec *iov;
+    usize iov_size = ctx->iov_cap * sizeof(yyjson_iovec);
+    if (!len) return true;
+    if (!dat && ctx->iov_num && !ctx->iov[ctx->iov_num - 1].base) {
+        ctx->iov[ctx->iov_num - 1].len += len;
+        return true;
+    }
+    if (ctx->iov_num == ctx->iov_cap) {
+        if (!write_iov_grow(&ctx->alc, (void **)&ctx->iov, &iov_size,
+                            iov_size + sizeof(yyjson_iovec))) return false;
+        ctx->iov_cap = iov_size / sizeof(yyjson_iovec);
+    }
+    iov = ctx->iov + ctx->iov_num++;
+    iov->base = dat;
+    iov->len = len;
+    return true;
+}
+
+/** The sink of the vectored writer for the buffer, copies the data. */
+static bool write_iov_copy(void *ctx_ptr, const char *dat, usize len) {
+    write_iov_ctx *ctx = (write_iov_ctx *)ctx_ptr;
+    if (!len) return true;
+    if (ctx->dat_cap - ctx->dat_len < len &&
+        !write_iov_grow(&ctx->alc, (void **)&ctx->dat, &ctx->dat_cap,
+                        ctx->dat_len + len)) return false;
+    memcpy(ctx->dat + ctx->dat_len, dat, len);
+    ctx->dat_len += len;
+    return write_iov_add(ctx, NULL, len);
+}
+
+/** The sink of the vectored writer for the strings, references the data. */
+static bool write_iov_ref(void *ctx_ptr, const char *dat, usize len) {
+    return write_iov_add((write_iov_ctx *)ctx_ptr, dat, len);
+}
+
+/** Initialize the vectored writer and its sink. */
+static void write_iov_init(write_iov_ctx *ctx, write_sink *sink,
+                           const yyjson_alc *alc, usize ref_len) {
+    memset(ctx, 0, sizeof(write_iov_ctx));
+    ctx->alc = *alc;
+    sink->func = write_iov_copy;
+    sink->ctx = (void *)ctx;
+    sink->buf_len = YYJSON_WRITER_STREAM_BUF_SIZE;
+    sink->total = 0;
+    sink->ref = write_iov_ref;
+    sink->ref_len = ref_len ? ref_len : YYJSON_WRITER_IOV_REF_LEN;
+    sink->esc = NULL;
+}
+
+/** Finish the vectored writer with the rest of the output in `dat`, which is
+    freed. Returns the segments and the copied data in a single allocation. */
+static yyjson_iovec *write_iov_done(write_iov_ctx *ctx, write_sink *sink,
+                                    u8 *dat, usize dat_len, usize *iov_num,
+                                    usize *len, yyjson_write_err *err) {
+    yyjson_iovec *iov = NULL;
+    usize i, iov_size;
+    u8 *cur;
+    bool suc = true;
+
+    if (dat) {
+        suc = write_iov_copy((void *)ctx, (const char *)dat, dat_len);
+        ctx->alc.free(ctx->alc.ctx, dat);
+        if (unlikely(!suc)) {
+            err->code = YYJSON_WRITE_ERROR_MEMORY_ALLOCATION;
+            err->msg = MSG_MALLOC;
+        }
+    } else if (err->code == YYJSON_WRITE_ERROR_FILE_WRITE) {
+        /* the sink of the vectored writer fails only on allocation */
+        err->code = YYJSON_WRITE_ERROR_MEMORY_ALLOCATION;
+        err->msg = MSG_MALLOC;
+    }
+    if (dat && suc) {
+        iov_size = ctx->iov_num * sizeof(yyjson_iovec);
+        iov = (yyjson_iovec *)ctx->alc.malloc(ctx->alc.ctx,
+                                              iov_size + ctx->dat_len + 1);
+        if (likely(iov)) {
+            if (iov_size) memcpy((void *)iov, (void *)ctx->iov, iov_size);
+            cur = (u8 *)iov + iov_size;
+            if (ctx->dat_len) memcpy(cur, ctx->dat, ctx->dat_len);
+            for (i = 0; i < ctx->iov_num; i++) {
+                if (iov[i].base) continue;
+                iov[i].base = (const void *)cur;
+                cur += iov[i].len;
+            }
+            *iov_num = ctx->iov_num;
+            *len = sink->total + dat_len;
+        } else {
+            err->code = YYJSON_WRITE_ERROR_MEMORY_ALLOCATION;
+            err->msg = MSG_MALLOC;
+        }
+    }
+    if (ctx->dat) ctx->alc.free(ctx->alc.ctx, ctx->dat);
+    if (ctx->iov) ctx->alc.free(ctx->alc.ctx, ctx->iov);
+    if (!iov) {
+        *iov_num = 0;
+        *len = 0;
+    }
+    return iov;
+}
+
+size_t yyjson_val_write_stream(const yyjson_val *val,
+                               yyjson_write_flag flg,
+                               const yyjson_alc *alc_ptr,
+                               size_t buf_len,
+                               yyjson_write_sink func, void *ctx,
+                               yyjson_write_err *err) {
+    yyjson_write_err tmp_err;
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    write_sink sink;
+    usize dat_len = 0;
+    u8 *dat;
+
+    if (!err) err = &tmp_err;
+    if (!write_sink_init(&sink, func, ctx, buf_len, err)) return 0;
+    dat = (u8 *)write_root(val, flg, &alc, NULL, &dat_len, &sink, err, NULL);
+    if (unlikely(!dat)) return 0;
+    return write_dat_to_sink(&sink, dat, dat_len, &alc, err);
+}
+
+size_t yyjson_write_stream(const yyjson_doc *doc,
+                           yyjson_write_flag flg,
+                           const yyjson_alc *alc_ptr,
+                           size_t buf_len,
+                           yyjson_write_sink func, void *ctx,
+                           yyjson_write_err *err) {
+    yyjson_val *root = doc ? doc->root : NULL;
+    return yyjson_val_write_stream(root, flg, alc_ptr, buf_len,
+                                   func, ctx, err);
+}
+
+size_t yyjson_val_write_len(const yyjson_val *val,
                             yyjson_write_flag flg,
                             const yyjson_alc *alc_ptr,
-                            usize *dat_len,
                             yyjson_write_err *err) {
-    return write_root(val, flg, alc_ptr, NULL, dat_len, err);
+    yyjson_write_err tmp_err;
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+
+    if (!err) err = &tmp_err;
+    if (unlikely(!val)) {
+        err->msg = "input JSON is NULL";
+        err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
+        return 0;
+    }
+    return write_len_root(val, flg, &alc, err);
 }
 
-char *yyjson_write_opts(const yyjson_doc *doc,
+size_t yyjson_write_len(const yyjson_doc *doc,
                         yyjson_write_flag flg,
                         const yyjson_alc *alc_ptr,
-                        usize *dat_len,
                         yyjson_write_err *err) {
     yyjson_val *root = doc ? doc->root : NULL;
-    return write_root(root, flg, alc_ptr, NULL, dat_len, err);
+    return yyjson_val_write_len(root, flg, alc_ptr, err);
 }
 
-#if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
-
-bool yyjson_val_write_file(const char *path,
-                           const yyjson_val *val,
-                           yyjson_write_flag flg,
-                           const yyjson_alc *alc_ptr,
-                           yyjson_write_err *err) {
+yyjson_iovec *yyjson_val_write_iov(const yyjson_val *val,
+                                   yyjson_write_flag flg,
+                                   const yyjson_alc *alc_ptr,
+                                   size_t ref_len,
+                                   size_t *iov_num,
+                                   size_t *len,
+                                   yyjson_write_err *err) {
     yyjson_write_err tmp_err;
+    usize tmp_iov_num, tmp_len, dat_len = 0;
     yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    write_iov_ctx ctx;
+    write_sink sink;
     u8 *dat;
-    usize dat_len = 0;
-    yyjson_val *root = constcast(yyjson_val *)val;
-    bool suc;
 
     if (!err) err = &tmp_err;
-    if (unlikely(!path || !*path)) {
-        err->msg = "input path is invalid";
-        err->code = YYJSON_READ_ERROR_INVALID_PARAMETER;
-        return false;
-    }
-
-    dat = (u8 *)write_root(root, flg, &alc, NULL, &dat_len, err);
-    if (unlikely(!dat)) return false;
-    suc = write_dat_to_file(path, dat, dat_len, err);
-    alc.free(alc.ctx, dat);
-    return suc;
+    if (!iov_num) iov_num = &tmp_iov_num;
+    if (!len) len = &tmp_len;
+    write_iov_init(&ctx, &sink, &alc, ref_len);
+    dat = (u8 *)write_root(val, flg, &alc, NULL, &dat_len, &sink, err, NULL);
+    return write_iov_done(&ctx, &sink, dat, dat_len, iov_num, len, err);
 }
 
-bool yyjson_val_write_fp(FILE *fp,
-                         const yyjson_val *val,
-                         yyjson_write_flag flg,
-                         const yyjson_alc *alc_ptr,
-                         yyjson_write_err *err) {
-    yyjson_write_err tmp_err;
-    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
-    u8 *dat;
-    usize dat_len = 0;
-    yyjson_val *root = constcast(yyjson_val *)val;
-    bool suc;
-
-    if (!err) err = &tmp_err;
-    if (unlikely(!fp)) {
-        err->msg = "input fp is invalid";
-        err->code = YYJSON_READ_ERROR_INVALID_PARAMETER;
-        return false;
-    }
+yyjson_iovec *yyjson_write_iov(const yyjson_doc *doc,
+                               yyjson_write_flag flg,
+                               const yyjson_alc *alc_ptr,
+                               size_t ref_len,
+                               size_t *iov_num,
+                               size_t *len,
+                               yyjson_write_err *err) {
+    yyjson_val *root = doc ? doc->root : NULL;
+    return yyjson_val_write_iov(root, flg, alc_ptr, ref_len,
+                                iov_num, len, err);
+}
 
-    dat = (u8 *)write_root(root, flg, &alc, NULL, &dat_len, err);
-    if (unlikely(!dat)) return false;
-    suc = write_dat_to_fp(fp, dat, dat_len, err);
-    alc.free(alc.ctx, dat);
-    return suc;
+/** The shared context of the parallel writer tasks. */
+typedef struct write_par_ctx {
+    const yyjson_val *root; /* the root container */
+    yyjson_write_flag flg; /* the write flags without NEWLINE_AT_END */
+    yyjson_alc alc; /* the allocator */
+    write_part *parts; /* the parts of the root container */
+    usize num; /* the number of parts */
+    const char *sep; /* the separator between the parts */
+    usize sep_len; /* the length of the separator and the brackets */
+    u8 *dat; /* the concatenated output */
+} write_par_ctx;
+
+/** Write a part as a container. */
+static void write_par_task(void *arg, usize idx) {
+    write_par_ctx *ctx = (write_par_ctx *)arg;
+    write_part *part = ctx->parts + idx;
+    part->dat = (u8 *)write_root(ctx->root, ctx->flg, &ctx->alc, NULL,
+                                 &part->dat_len, NULL, &part->err, part);
 }
 
-bool yyjson_write_file(const char *path,
-                       const yyjson_doc *doc,
-                       yyjson_write_flag flg,
-                       const yyjson_alc *alc_ptr,
-                       yyjson_write_err *err) {
-    yyjson_val *root = doc ? doc->root : NULL;
-    return yyjson_val_write_file(path, root, flg, alc_ptr, err);
+/** Copy the output of a part to the concatenated output, without the
+    brackets between the parts, and free it. */
+static void write_par_copy_task(void *arg, usize idx) {
+    write_par_ctx *ctx = (write_par_ctx *)arg;
+    write_part *part = ctx->parts + idx;
+    bool last = idx + 1 == ctx->num;
+    usize beg = idx ? ctx->sep_len : 0;
+    usize end = part->dat_len - (last ? 0 : ctx->sep_len);
+    u8 *cur = ctx->dat + part->pos;
+    memcpy(cur, part->dat + beg, end - beg);
+    if (!last) memcpy(cur + end - beg, ctx->sep, ctx->sep_len);
+    ctx->alc.free(ctx->alc.ctx, part->dat);
+    part->dat = NULL;
 }
 
-bool yyjson_write_fp(FILE *fp,
-                     const yyjson_doc *doc,
-                     yyjson_write_flag flg,
-                     const yyjson_alc *alc_ptr,
-                     yyjson_write_err *err) {
-    yyjson_val *root = doc ? doc->root : NULL;
-    return yyjson_val_write_fp(fp, root, flg, alc_ptr, err);
+/** Run the tasks with `run`, or one by one if `run` is NULL. */
+static_inline void write_par_run_tasks(yyjson_par_run run, void *run_ctx,
+                                       yyjson_par_task task,
+                                       write_par_ctx *ctx) {
+    if (run) {
+        run(run_ctx, task, (void *)ctx, ctx->num);
+    } else {
+        usize i;
+        for (i = 0; i < ctx->num; i++) task((void *)ctx, i);
+    }
 }
 
-#endif /* !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE */
+char *yyjson_val_write_par(const yyjson_val *val,
+                           yyjson_write_flag flg,
+                           const yyjson_alc *alc_ptr,
+                           usize par_num,
+                           yyjson_par_run run, void *run_ctx,
+                           usize *dat_len,
+                           yyjson_write_err *err) {
+    yyjson_write_err tmp_err;
+    usize tmp_dat_len;
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    write_par_ctx ctx;
+    write_part *part;
+    const yyjson_val *cur, *beg;
+    usize i, len, num, cnt, size, pos;
+    bool obj, newline = has_flg(NEWLINE_AT_END) != 0;
 
-size_t yyjson_val_write_buf(char *buf, size_t buf_len,
-                            const yyjson_val *val,
-                            yyjson_write_flag flg,
-                            yyjson_write_err *err) {
-    if (unlikely(!buf || !buf_len)) {
-        if (err) err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
-        if (err) err->msg = "input buf or buf_len is invalid";
-        return 0;
+    if (!val || !unsafe_yyjson_is_ctn(val) || !unsafe_yyjson_get_len(val) ||
+        par_num <= 1 || val->uni.ofs < YYJSON_WRITER_PAR_MIN_SIZE * 2) {
+        return write_root(val, flg, alc_ptr, NULL, dat_len, NULL, err, NULL);
+    }
+    if (par_num > val->uni.ofs / YYJSON_WRITER_PAR_MIN_SIZE) {
+        par_num = val->uni.ofs / YYJSON_WRITER_PAR_MIN_SIZE;
+    }
+    if (!err) err = &tmp_err;
+    if (!dat_len) dat_len = &tmp_dat_len;
+
+    ctx.parts = (write_part *)alc.malloc(alc.ctx, par_num * sizeof(write_part));
+    if (!ctx.parts) {
+        return write_root(val, flg, alc_ptr, NULL, dat_len, NULL, err, NULL);
+    }
+    memset(ctx.parts, 0, par_num * sizeof(write_part));
+
+    /* split the elements (or key-value pairs) into parts of similar size */
+    obj = unsafe_yyjson_is_obj(val);
+    len = unsafe_yyjson_get_len(val);
+    size = val->uni.ofs / par_num;
+    num = 0;
+    cnt = 0;
+    beg = cur = val + 1;
+    for (i = 0; i < len; i++) {
+        cur = unsafe_yyjson_get_next(cur + obj);
+        cnt++;
+        if (num + 1 < par_num && i + 1 < len &&
+            (usize)((const u8 *)cur - (const u8 *)beg) >= size) {
+            part = ctx.parts + num++;
+            part->val = beg;
+            part->len = cnt;
+            part->size = (usize)((const u8 *)cur - (const u8 *)beg);
+            beg = cur;
+            cnt = 0;
+        }
+    }
+    part = ctx.parts + num++;
+    part->val = beg;
+    part->len = cnt;
+    part->size = (usize)((const u8 *)cur - (const u8 *)beg);
+
+    /* write each part as a container: "[e1,e2]" or "[\n    e1,\n    e2\n]" */
+    ctx.root = val;
+    ctx.flg = flg & ~YYJSON_WRITE_NEWLINE_AT_END;
+    ctx.alc = alc;
+    ctx.num = num;
+    ctx.dat = NULL;
+    if (flg & (YYJSON_WRITE_PRETTY | YYJSON_WRITE_PRETTY_TWO_SPACES)) {
+        ctx.sep = ",\n";
+        ctx.sep_len = 2;
     } else {
-        write_root(val, flg, &YYJSON_NULL_ALC, buf, &buf_len, err);
-        return buf_len;
+        ctx.sep = ",";
+        ctx.sep_len = 1;
+    }
+    write_par_run_tasks(run, run_ctx, write_par_task, &ctx);
+
+    /* the first error is the same as the serial writer */
+    pos = 0;
+    for (i = 0; i < num; i++) {
+        part = ctx.parts + i;
+        if (unlikely(!part->dat)) {
+            *err = part->err;
+            goto fail;
+        }
+        part->pos = pos;
+        pos += part->dat_len - (i ? ctx.sep_len : 0);
+    }
+    ctx.dat = (u8 *)alc.malloc(alc.ctx, pos + newline + 1);
+    if (unlikely(!ctx.dat)) {
+        err->code = YYJSON_WRITE_ERROR_MEMORY_ALLOCATION;
+        err->msg = MSG_MALLOC;
+        goto fail;
+    }
+    write_par_run_tasks(run, run_ctx, write_par_copy_task, &ctx);
+    if (newline) ctx.dat[pos++] = '\n';
+    ctx.dat[pos] = '\0';
+    alc.free(alc.ctx, ctx.parts);
+    *dat_len = pos;
+    memset(err, 0, sizeof(yyjson_write_err));
+    return (char *)ctx.dat;
+
+fail:
+    for (i = 0; i < num; i++) {
+        if (ctx.parts[i].dat) alc.free(alc.ctx, ctx.parts[i].dat);
     }
+    alc.free(alc.ctx, ctx.parts);
+    *dat_len = 0;
+    return NULL;
 }
 
-size_t yyjson_write_buf(char *buf, size_t buf_len,
-                        const yyjson_doc *doc,
-                        yyjson_write_flag flg,
-                        yyjson_write_err *err) {
+char *yyjson_write_par(const yyjson_doc *doc,
+                       yyjson_write_flag flg,
+                       const yyjson_alc *alc_ptr,
+                       usize par_num,
+                       yyjson_par_run run, void *run_ctx,
+                       usize *dat_len,
+                       yyjson_write_err *err) {
     yyjson_val *root = doc ? doc->root : NULL;
-    return yyjson_val_write_buf(buf, buf_len, root, flg, err);
+    return yyjson_val_write_par(root, flg, alc_ptr, par_num, run, run_ctx,
+                                dat_len, err);
 }
 
 
@@ -9859,7 +15224,8 @@ static_inline usize yyjson_mut_doc_estimated_val_num(
     usize sum = 0;
     yyjson_val_chunk *chunk = doc->val_pool.chunks;
     while (chunk) {
-        sum += chunk->chunk_size / sizeof(yyjson_mut_val) - 1;
+        sum += chunk->chunk_size / sizeof(yyjson_mut_val) -
+               YYJSON_MUT_DOC_VAL_CHUNK_HDR;
         if (chunk == doc->val_pool.chunks) {
             sum -= (usize)(doc->val_pool.end - doc->val_pool.cur);
         }
@@ -9874,7 +15240,9 @@ static_inline u8 *mut_write_root_single(yyjson_mut_val *val,
                                         yyjson_alc alc,
                                         char *buf, usize *dat_len,
                                         yyjson_write_err *err) {
-    return write_root_single((yyjson_val *)val, flg, alc, buf, dat_len, err);
+    yyjson_val tmp;
+    unsafe_yyjson_mut_val_to_imut(&tmp, val);
+    return write_root_single(&tmp, flg, alc, buf, dat_len, err);
 }
 
 /** Write JSON document minify.
@@ -9884,6 +15252,7 @@ static_inline u8 *mut_write_root_minify(const yyjson_mut_val *root,
                                         yyjson_write_flag flg,
                                         yyjson_alc alc,
                                         char *buf, usize *dat_len,
+                                        write_sink *sink,
                                         yyjson_write_err *err) {
 #define return_err(_code, _msg) do { \
     *dat_len = 0; \
@@ -9896,23 +15265,27 @@ static_inline u8 *mut_write_root_minify(const yyjson_mut_val *root,
 #define incr_len(_len) do { \
     ext_len = (usize)(_len); \
     if (unlikely((u8 *)(cur + ext_len) >= (u8 *)ctx)) { \
-        usize ctx_pos = (usize)((u8 *)ctx - hdr); \
-        usize cur_pos = (usize)(cur - hdr); \
-        yyjson_assume((u8 *)ctx <= (u8 *)end); \
-        ctx_len = (usize)((u8 *)end - (u8 *)ctx); \
-        alc_inc = yyjson_max(alc_len / 2, ext_len); \
-        alc_inc = size_align_up(alc_inc, sizeof(yyjson_mut_write_ctx)); \
-        if ((sizeof(usize) < 8) && size_add_is_overflow(alc_len, alc_inc)) \
-            goto fail_alloc; \
-        alc_len += alc_inc; \
-        tmp = (u8 *)alc.realloc(alc.ctx, hdr, alc_len - alc_inc, alc_len); \
-        if (unlikely(!tmp)) goto fail_alloc; \
-        ctx_tmp = (yyjson_mut_write_ctx *)(void *)(tmp + (alc_len - ctx_len)); \
-        memmove((void *)ctx_tmp, (void *)(tmp + ctx_pos), ctx_len); \
-        ctx = ctx_tmp; \
-        cur = tmp + cur_pos; \
-        end = tmp + alc_len; \
-        hdr = tmp; \
+        if (sink && !write_sink_flush(sink, hdr, &cur)) goto fail_sink; \
+        if ((u8 *)(cur + ext_len) >= (u8 *)ctx) { \
+            usize ctx_pos = (usize)((u8 *)ctx - hdr); \
+            usize cur_pos = (usize)(cur - hdr); \
+            yyjson_assume((u8 *)ctx <= (u8 *)end); \
+            ctx_len = (usize)((u8 *)end - (u8 *)ctx); \
+            alc_inc = yyjson_max(alc_len / 2, ext_len); \
+            alc_inc = size_align_up(alc_inc, sizeof(yyjson_mut_write_ctx)); \
+            if ((sizeof(usize) < 8) && size_add_is_overflow(alc_len, alc_inc)) \
+                goto fail_alloc; \
+            alc_len += alc_inc; \
+            tmp = (u8 *)alc.realloc(alc.ctx, hdr, alc_len - alc_inc, alc_len); \
+            if (unlikely(!tmp)) goto fail_alloc; \
+            ctx_tmp = (yyjson_mut_write_ctx *)(void *) \
+                      (tmp + (alc_len - ctx_len)); \
+            memmove((void *)ctx_tmp, (void *)(tmp + ctx_pos), ctx_len); \
+            ctx = ctx_tmp; \
+            cur = tmp + cur_pos; \
+            end = tmp + alc_len; \
+            hdr = tmp; \
+        } \
     } \
 } while (false)
 
@@ -9943,6 +15316,7 @@ static_inline u8 *mut_write_root_minify(const yyjson_mut_val *root,
         if (alc_len <= sizeof(yyjson_mut_write_ctx)) goto fail_alloc;
     } else {
         alc_len = estimated_val_num * YYJSON_WRITER_ESTIMATED_MINIFY_RATIO + 64;
+        if (sink) alc_len = sink->buf_len;
         alc_len = size_align_up(alc_len, sizeof(yyjson_mut_write_ctx));
         hdr = (u8 *)alc.malloc(alc.ctx, alc_len);
         if (!hdr) goto fail_alloc;
@@ -9955,19 +15329,33 @@ doc_begin:
     val = constcast(yyjson_mut_val *)root;
     val_type = unsafe_yyjson_get_type(val);
     ctn_obj = (val_type == YYJSON_TYPE_OBJ);
-    ctn_len = unsafe_yyjson_get_len(val) << (u8)ctn_obj;
+    ctn_len = unsafe_yyjson_mut_get_len(val) << (u8)ctn_obj;
     *cur++ = (u8)('[' | ((u8)ctn_obj << 5));
     ctn = val;
-    val = (yyjson_mut_val *)val->uni.ptr; /* tail */
-    val = ctn_obj ? val->next->next : val->next;
+    val = unsafe_yyjson_mut_get_last(val); /* tail */
+    val = unsafe_yyjson_mut_get_next(val);
+    if (ctn_obj) val = unsafe_yyjson_mut_get_next(val);
 
 val_begin:
     val_type = unsafe_yyjson_get_type(val);
     if (val_type == YYJSON_TYPE_STR) {
         is_key = ((u8)ctn_obj & (u8)~ctn_len);
-        str_len = unsafe_yyjson_get_len(val);
-        str_ptr = (const u8 *)unsafe_yyjson_get_str(val);
+        str_len = unsafe_yyjson_mut_get_len(val);
+        str_ptr = (const u8 *)unsafe_yyjson_mut_get_str(val);
         check_str_len(str_len);
+        if (write_sink_can_esc(sink, str_len) ||
+            (write_sink_can_ref(sink, str_len) && cpy &&
+             (unsafe_yyjson_get_subtype(val) ||
+              write_str_is_noesc(str_ptr, str_len)))) {
+            incr_len(16);
+            *cur++ = '"';
+            if (!write_sink_ref(sink, hdr, &cur, str_ptr, str_len, true)) {
+                goto fail_sink;
+            }
+            *cur++ = '"';
+            *cur++ = is_key ? ':' : ',';
+            goto val_end;
+        }
         incr_len(str_len * 6 + 16);
         if (likely(cpy) && unsafe_yyjson_get_subtype(val)) {
             cur = write_str_noesc(cur, str_ptr, str_len);
@@ -9981,14 +15369,15 @@ val_begin:
     }
     if (val_type == YYJSON_TYPE_NUM) {
         incr_len(FP_BUF_LEN);
-        cur = write_num(cur, (yyjson_val *)val, flg);
+        cur = write_num_fmt(cur, (yyjson_val *)val,
+                            unsafe_yyjson_mut_get_fp_fmt(val), flg);
         if (unlikely(!cur)) goto fail_num;
         *cur++ = ',';
         goto val_end;
     }
     if ((val_type & (YYJSON_TYPE_ARR & YYJSON_TYPE_OBJ)) ==
                     (YYJSON_TYPE_ARR & YYJSON_TYPE_OBJ)) {
-        ctn_len_tmp = unsafe_yyjson_get_len(val);
+        ctn_len_tmp = unsafe_yyjson_mut_get_len(val);
         ctn_obj_tmp = (val_type == YYJSON_TYPE_OBJ);
         incr_len(2 * sizeof(*ctx));
         if (unlikely(ctn_len_tmp == 0)) {
@@ -10004,8 +15393,9 @@ val_begin:
             ctn_obj = ctn_obj_tmp;
             *cur++ = (u8)('[' | ((u8)ctn_obj << 5));
             ctn = val;
-            val = (yyjson_mut_val *)ctn->uni.ptr; /* tail */
-            val = ctn_obj ? val->next->next : val->next;
+            val = unsafe_yyjson_mut_get_last(ctn); /* tail */
+            val = unsafe_yyjson_mut_get_next(val);
+            if (ctn_obj) val = unsafe_yyjson_mut_get_next(val);
             goto val_begin;
         }
     }
@@ -10022,9 +15412,17 @@ val_begin:
         goto val_end;
     }
     if (val_type == YYJSON_TYPE_RAW) {
-        str_len = unsafe_yyjson_get_len(val);
-        str_ptr = (const u8 *)unsafe_yyjson_get_str(val);
+        str_len = unsafe_yyjson_mut_get_len(val);
+        str_ptr = (const u8 *)unsafe_yyjson_mut_get_str(val);
         check_str_len(str_len);
+        if (write_sink_can_ref(sink, str_len)) {
+            incr_len(2);
+            if (!write_sink_ref(sink, hdr, &cur, str_ptr, str_len, false)) {
+                goto fail_sink;
+            }
+            *cur++ = ',';
+            goto val_end;
+        }
         incr_len(str_len + 2);
         cur = write_raw(cur, str_ptr, str_len);
         *cur++ = ',';
@@ -10035,7 +15433,7 @@ val_begin:
 val_end:
     ctn_len--;
     if (unlikely(ctn_len == 0)) goto ctn_end;
-    val = val->next;
+    val = unsafe_yyjson_mut_get_next(val);
     goto val_begin;
 
 ctn_end:
@@ -10043,7 +15441,7 @@ ctn_end:
     *cur++ = (u8)(']' | ((u8)ctn_obj << 5));
     *cur++ = ',';
     if (unlikely((u8 *)ctx >= end)) goto doc_end;
-    val = ctn->next;
+    val = unsafe_yyjson_mut_get_next(ctn);
     yyjson_mut_write_ctx_get(ctx++, &ctn, &ctn_len, &ctn_obj);
     ctn_len--;
     if (likely(ctn_len > 0)) {
@@ -10068,6 +15466,7 @@ fail_alloc: return_err(MEMORY_ALLOCATION, MSG_MALLOC);
 fail_type:  return_err(INVALID_VALUE_TYPE, MSG_ERR_TYPE);
 fail_num:   return_err(NAN_OR_INF, MSG_NAN_INF);
 fail_str:   return_err(INVALID_STRING, MSG_ERR_UTF8);
+fail_sink:  return_err(FILE_WRITE, MSG_SINK);
 
 #undef return_err
 #undef incr_len
@@ -10081,6 +15480,7 @@ static_inline u8 *mut_write_root_pretty(const yyjson_mut_val *root,
                                         yyjson_write_flag flg,
                                         yyjson_alc alc,
                                         char *buf, usize *dat_len,
+                                        write_sink *sink,
                                         yyjson_write_err *err) {
 #define return_err(_code, _msg) do { \
     *dat_len = 0; \
@@ -10093,23 +15493,27 @@ static_inline u8 *mut_write_root_pretty(const yyjson_mut_val *root,
 #define incr_len(_len) do { \
     ext_len = (usize)(_len); \
     if (unlikely((u8 *)(cur + ext_len) >= (u8 *)ctx)) { \
-        usize ctx_pos = (usize)((u8 *)ctx - hdr); \
-        usize cur_pos = (usize)(cur - hdr); \
-        yyjson_assume((u8 *)ctx <= (u8 *)end); \
-        ctx_len = (usize)((u8 *)end - (u8 *)ctx); \
-        alc_inc = yyjson_max(alc_len / 2, ext_len); \
-        alc_inc = size_align_up(alc_inc, sizeof(yyjson_mut_write_ctx)); \
-        if ((sizeof(usize) < 8) && size_add_is_overflow(alc_len, alc_inc)) \
-            goto fail_alloc; \
-        alc_len += alc_inc; \
-        tmp = (u8 *)alc.realloc(alc.ctx, hdr, alc_len - alc_inc, alc_len); \
-        if (unlikely(!tmp)) goto fail_alloc; \
-        ctx_tmp = (yyjson_mut_write_ctx *)(void *)(tmp + (alc_len - ctx_len)); \
-        memmove((void *)ctx_tmp, (void *)(tmp + ctx_pos), ctx_len); \
-        ctx = ctx_tmp; \
-        cur = tmp + cur_pos; \
-        end = tmp + alc_len; \
-        hdr = tmp; \
+        if (sink && !write_sink_flush(sink, hdr, &cur)) goto fail_sink; \
+        if ((u8 *)(cur + ext_len) >= (u8 *)ctx) { \
+            usize ctx_pos = (usize)((u8 *)ctx - hdr); \
+            usize cur_pos = (usize)(cur - hdr); \
+            yyjson_assume((u8 *)ctx <= (u8 *)end); \
+            ctx_len = (usize)((u8 *)end - (u8 *)ctx); \
+            alc_inc = yyjson_max(alc_len / 2, ext_len); \
+            alc_inc = size_align_up(alc_inc, sizeof(yyjson_mut_write_ctx)); \
+            if ((sizeof(usize) < 8) && size_add_is_overflow(alc_len, alc_inc)) \
+                goto fail_alloc; \
+            alc_len += alc_inc; \
+            tmp = (u8 *)alc.realloc(alc.ctx, hdr, alc_len - alc_inc, alc_len); \
+            if (unlikely(!tmp)) goto fail_alloc; \
+            ctx_tmp = (yyjson_mut_write_ctx *)(void *) \
+                      (tmp + (alc_len - ctx_len)); \
+            memmove((void *)ctx_tmp, (void *)(tmp + ctx_pos), ctx_len); \
+            ctx = ctx_tmp; \
+            cur = tmp + cur_pos; \
+            end = tmp + alc_len; \
+            hdr = tmp; \
+        } \
     } \
 } while (false)
 
@@ -10141,6 +15545,7 @@ static_inline u8 *mut_write_root_pretty(const yyjson_mut_val *root,
         if (alc_len <= sizeof(yyjson_mut_write_ctx)) goto fail_alloc;
     } else {
         alc_len = estimated_val_num * YYJSON_WRITER_ESTIMATED_PRETTY_RATIO + 64;
+        if (sink) alc_len = sink->buf_len;
         alc_len = size_align_up(alc_len, sizeof(yyjson_mut_write_ctx));
         hdr = (u8 *)alc.malloc(alc.ctx, alc_len);
         if (!hdr) goto fail_alloc;
@@ -10153,12 +15558,13 @@ doc_begin:
     val = constcast(yyjson_mut_val *)root;
     val_type = unsafe_yyjson_get_type(val);
     ctn_obj = (val_type == YYJSON_TYPE_OBJ);
-    ctn_len = unsafe_yyjson_get_len(val) << (u8)ctn_obj;
+    ctn_len = unsafe_yyjson_mut_get_len(val) << (u8)ctn_obj;
     *cur++ = (u8)('[' | ((u8)ctn_obj << 5));
     *cur++ = '\n';
     ctn = val;
-    val = (yyjson_mut_val *)val->uni.ptr; /* tail */
-    val = ctn_obj ? val->next->next : val->next;
+    val = unsafe_yyjson_mut_get_last(val); /* tail */
+    val = unsafe_yyjson_mut_get_next(val);
+    if (ctn_obj) val = unsafe_yyjson_mut_get_next(val);
     level = 1;
 
 val_begin:
@@ -10166,9 +15572,24 @@ val_begin:
     if (val_type == YYJSON_TYPE_STR) {
         is_key = (bool)((u8)ctn_obj & (u8)~ctn_len);
         no_indent = (bool)((u8)ctn_obj & (u8)ctn_len);
-        str_len = unsafe_yyjson_get_len(val);
-        str_ptr = (const u8 *)unsafe_yyjson_get_str(val);
+        str_len = unsafe_yyjson_mut_get_len(val);
+        str_ptr = (const u8 *)unsafe_yyjson_mut_get_str(val);
         check_str_len(str_len);
+        if (write_sink_can_esc(sink, str_len) ||
+            (write_sink_can_ref(sink, str_len) && cpy &&
+             (unsafe_yyjson_get_subtype(val) ||
+              write_str_is_noesc(str_ptr, str_len)))) {
+            incr_len(16 + (no_indent ? 0 : level * 4));
+            cur = write_indent(cur, no_indent ? 0 : level, spaces);
+            *cur++ = '"';
+            if (!write_sink_ref(sink, hdr, &cur, str_ptr, str_len, true)) {
+                goto fail_sink;
+            }
+            *cur++ = '"';
+            *cur++ = is_key ? ':' : ',';
+            *cur++ = is_key ? ' ' : '\n';
+            goto val_end;
+        }
         if ((sizeof(usize) < 8) && !no_indent &&
             level > (USIZE_MAX - 16 - str_len * 6) / 4) goto fail_alloc;
         incr_len(str_len * 6 + 16 + (no_indent ? 0 : level * 4));
@@ -10188,7 +15609,8 @@ val_begin:
         no_indent = (bool)((u8)ctn_obj & (u8)ctn_len);
         incr_len(FP_BUF_LEN + (no_indent ? 0 : level * 4));
         cur = write_indent(cur, no_indent ? 0 : level, spaces);
-        cur = write_num(cur, (yyjson_val *)val, flg);
+        cur = write_num_fmt(cur, (yyjson_val *)val,
+                            unsafe_yyjson_mut_get_fp_fmt(val), flg);
         if (unlikely(!cur)) goto fail_num;
         *cur++ = ',';
         *cur++ = '\n';
@@ -10197,7 +15619,7 @@ val_begin:
     if ((val_type & (YYJSON_TYPE_ARR & YYJSON_TYPE_OBJ)) ==
                     (YYJSON_TYPE_ARR & YYJSON_TYPE_OBJ)) {
         no_indent = (bool)((u8)ctn_obj & (u8)ctn_len);
-        ctn_len_tmp = unsafe_yyjson_get_len(val);
+        ctn_len_tmp = unsafe_yyjson_mut_get_len(val);
         ctn_obj_tmp = (val_type == YYJSON_TYPE_OBJ);
         incr_len(2 * sizeof(*ctx) + (no_indent ? 0 : level * 4));
         if (unlikely(ctn_len_tmp == 0)) {
@@ -10218,8 +15640,9 @@ val_begin:
             *cur++ = (u8)('[' | ((u8)ctn_obj << 5));
             *cur++ = '\n';
             ctn = val;
-            val = (yyjson_mut_val *)ctn->uni.ptr; /* tail */
-            val = ctn_obj ? val->next->next : val->next;
+            val = unsafe_yyjson_mut_get_last(ctn); /* tail */
+            val = unsafe_yyjson_mut_get_next(val);
+            if (ctn_obj) val = unsafe_yyjson_mut_get_next(val);
             goto val_begin;
         }
     }
@@ -10241,9 +15664,19 @@ val_begin:
     }
     if (val_type == YYJSON_TYPE_RAW) {
         no_indent = (bool)((u8)ctn_obj & (u8)ctn_len);
-        str_len = unsafe_yyjson_get_len(val);
-        str_ptr = (const u8 *)unsafe_yyjson_get_str(val);
+        str_len = unsafe_yyjson_mut_get_len(val);
+        str_ptr = (const u8 *)unsafe_yyjson_mut_get_str(val);
         check_str_len(str_len);
+        if (write_sink_can_ref(sink, str_len)) {
+            incr_len(3 + (no_indent ? 0 : level * 4));
+            cur = write_indent(cur, no_indent ? 0 : level, spaces);
+            if (!write_sink_ref(sink, hdr, &cur, str_ptr, str_len, false)) {
+                goto fail_sink;
+            }
+            *cur++ = ',';
+            *cur++ = '\n';
+            goto val_end;
+        }
         incr_len(str_len + 3 + (no_indent ? 0 : level * 4));
         cur = write_indent(cur, no_indent ? 0 : level, spaces);
         cur = write_raw(cur, str_ptr, str_len);
@@ -10256,7 +15689,7 @@ val_begin:
 val_end:
     ctn_len--;
     if (unlikely(ctn_len == 0)) goto ctn_end;
-    val = val->next;
+    val = unsafe_yyjson_mut_get_next(val);
     goto val_begin;
 
 ctn_end:
@@ -10266,7 +15699,7 @@ ctn_end:
     cur = write_indent(cur, --level, spaces);
     *cur++ = (u8)(']' | ((u8)ctn_obj << 5));
     if (unlikely((u8 *)ctx >= end)) goto doc_end;
-    val = ctn->next;
+    val = unsafe_yyjson_mut_get_next(ctn);
     yyjson_mut_write_ctx_get(ctx++, &ctn, &ctn_len, &ctn_obj);
     ctn_len--;
     *cur++ = ',';
@@ -10292,22 +15725,147 @@ fail_alloc: return_err(MEMORY_ALLOCATION, MSG_MALLOC);
 fail_type:  return_err(INVALID_VALUE_TYPE, MSG_ERR_TYPE);
 fail_num:   return_err(NAN_OR_INF, MSG_NAN_INF);
 fail_str:   return_err(INVALID_STRING, MSG_ERR_UTF8);
+fail_sink:  return_err(FILE_WRITE, MSG_SINK);
 
 #undef return_err
 #undef incr_len
 #undef check_str_len
 }
 
+/**
+ Returns the output length of a mutable value, without the null-terminator,
+ the error is set in `err`, see `write_len_root()`.
+ */
+static_noinline usize mut_write_len_root(const yyjson_mut_val *root,
+                                         yyjson_write_flag flg,
+                                         const yyjson_alc *alc,
+                                         yyjson_write_err *err) {
+#define return_err(_code, _msg) do { \
+    err->code = YYJSON_WRITE_ERROR_##_code; \
+    err->msg = _msg; \
+    goto fail; \
+} while (false)
+
+    write_len_ctx stk_buf[WRITE_LEN_STACK_SIZE];
+    write_len_ctx *stk = stk_buf, *top = NULL, *tmp;
+    usize stk_cap = WRITE_LEN_STACK_SIZE, level = 0, ctn_len;
+    bool obj;
+    u64 len = 0;
+    yyjson_mut_val *val = constcast(yyjson_mut_val *)root;
+    yyjson_type val_type;
+    const char_enc_type *enc_table = get_enc_table_with_flag(flg);
+    bool pretty = (flg & (YYJSON_WRITE_PRETTY |
+                          YYJSON_WRITE_PRETTY_TWO_SPACES)) != 0;
+    usize spaces = has_flg(PRETTY_TWO_SPACES) ? 2 : 4;
+    usize sep = pretty ? 2 : 1;
+
+    memset(err, 0, sizeof(yyjson_write_err));
+
+val_begin:
+    if (level) {
+        len += sep;
+        /* the object values are not indented */
+        if (pretty && (top->tag & 3) != 3) len += level * spaces;
+    }
+    val_type = unsafe_yyjson_get_type(val);
+    if (val_type == YYJSON_TYPE_ARR || val_type == YYJSON_TYPE_OBJ) {
+        ctn_len = unsafe_yyjson_mut_get_len(val);
+        if (ctn_len == 0) {
+            len += 2;
+            goto val_end;
+        }
+        len += pretty ? level * spaces + 2 : 1;
+        if (unlikely(level == stk_cap)) {
+            tmp = (write_len_ctx *)alc->malloc(alc->ctx,
+                                               stk_cap * 2 * sizeof(*stk));
+            if (unlikely(!tmp)) return_err(MEMORY_ALLOCATION, MSG_MALLOC);
+            memcpy(tmp, stk, stk_cap * sizeof(*stk));
+            if (stk != stk_buf) alc->free(alc->ctx, stk);
+            stk = tmp;
+            stk_cap *= 2;
+        }
+        top = stk + level++;
+        top->ctn = val;
+        obj = (val_type == YYJSON_TYPE_OBJ);
+        top->tag = (ctn_len << ((u8)obj + 1)) | (usize)obj;
+        val = unsafe_yyjson_mut_get_last(val); /* tail */
+        val = unsafe_yyjson_mut_get_next(val);
+        if (obj) val = unsafe_yyjson_mut_get_next(val);
+        goto val_begin;
+    }
+    len += write_len_scalar(val, true, flg, enc_table, err);
+    if (unlikely(err->code)) goto fail;
+
+val_end:
+    while (level && (top->tag -= 2) < 2) {
+        val = (yyjson_mut_val *)constcast(void *)top->ctn;
+        top = --level ? top - 1 : NULL;
+    }
+    if (level) {
+        val = unsafe_yyjson_mut_get_next(val);
+        goto val_begin;
+    }
+
+    if (has_flg(NEWLINE_AT_END)) len++;
+    if ((sizeof(usize) < 8) && len >= USIZE_MAX) {
+        return_err(MEMORY_ALLOCATION, MSG_MALLOC);
+    }
+    if (stk != stk_buf) alc->free(alc->ctx, stk);
+    return (usize)len;
+
+fail:
+    if (stk != stk_buf) alc->free(alc->ctx, stk);
+    return 0;
+
+#undef return_err
+}
+
+/** Write a mutable value to a buffer of exactly `len + 1` bytes with the
+    exact-size writer, see `write_root_exact()`. */
+static bool mut_write_root_exact(const yyjson_mut_val *root,
+                                 yyjson_write_flag flg,
+                                 yyjson_alc alc, usize tmp_len,
+                                 u8 *buf, usize len,
+                                 yyjson_write_err *err) {
+    write_exact_out out;
+    write_sink sink;
+    u8 *dat = NULL;
+    usize dat_len = 0;
+    yyjson_type type = unsafe_yyjson_get_type(root);
+
+    write_exact_init(&out, &sink, flg, tmp_len, buf, len, err);
+    if (unsafe_yyjson_is_ctn(root) &&
+        unsafe_yyjson_mut_get_len(root) > 0) {
+        if (flg & (YYJSON_WRITE_PRETTY | YYJSON_WRITE_PRETTY_TWO_SPACES)) {
+            dat = mut_write_root_pretty(root, 0, flg, alc, NULL, &dat_len,
+                                        &sink, err);
+        } else {
+            dat = mut_write_root_minify(root, 0, flg, alc, NULL, &dat_len,
+                                        &sink, err);
+        }
+    } else if (type == YYJSON_TYPE_STR || type == YYJSON_TYPE_RAW) {
+        write_exact_single(&out, (const u8 *)unsafe_yyjson_mut_get_str(root),
+                           unsafe_yyjson_mut_get_len(root),
+                           type == YYJSON_TYPE_RAW, flg, err);
+    } else {
+        dat = mut_write_root_single(constcast(yyjson_mut_val *)root, flg, alc,
+                                    NULL, &dat_len, err);
+    }
+    return write_exact_done(&out, dat, dat_len, &alc, err);
+}
+
 static char *mut_write_root(const yyjson_mut_val *val,
                             usize estimated_val_num,
                             yyjson_write_flag flg,
                             const yyjson_alc *alc_ptr,
                             char *buf, usize *dat_len,
+                            write_sink *sink,
                             yyjson_write_err *err) {
     yyjson_write_err tmp_err;
-    usize tmp_dat_len;
+    usize tmp_dat_len, len;
     yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
     yyjson_mut_val *root = constcast(yyjson_mut_val *)val;
+    u8 *hdr;
 
     if (!err) err = &tmp_err;
     if (!dat_len) dat_len = &tmp_dat_len;
@@ -10319,14 +15877,39 @@ static char *mut_write_root(const yyjson_mut_val *val,
         return NULL;
     }
 
-    if (!unsafe_yyjson_is_ctn(root) || unsafe_yyjson_get_len(root) == 0) {
+    if (has_flg(PRESIZE) && !buf && !sink) {
+        len = mut_write_len_root(root, flg, &alc, err);
+        if (unlikely(err->code)) {
+            *dat_len = 0;
+            return NULL;
+        }
+        hdr = (u8 *)alc.malloc(alc.ctx, len + 1);
+        if (unlikely(!hdr)) {
+            *dat_len = 0;
+            err->code = YYJSON_WRITE_ERROR_MEMORY_ALLOCATION;
+            err->msg = MSG_MALLOC;
+            return NULL;
+        }
+        if (unlikely(!mut_write_root_exact(root, flg, alc,
+                                           YYJSON_WRITER_STREAM_BUF_SIZE,
+                                           hdr, len, err))) {
+            alc.free(alc.ctx, hdr);
+            *dat_len = 0;
+            return NULL;
+        }
+        *dat_len = len;
+        return (char *)hdr;
+    }
+    if (!unsafe_yyjson_is_ctn(root) || unsafe_yyjson_mut_get_len(root) == 0) {
         return (char *)mut_write_root_single(root, flg, alc, buf, dat_len, err);
     } else if (flg & (YYJSON_WRITE_PRETTY | YYJSON_WRITE_PRETTY_TWO_SPACES)) {
         return (char *)mut_write_root_pretty(root, estimated_val_num,
-                                             flg, alc, buf, dat_len, err);
+                                             flg, alc, buf, dat_len,
+                                             sink, err);
     } else {
         return (char *)mut_write_root_minify(root, estimated_val_num,
-                                             flg, alc, buf, dat_len, err);
+                                             flg, alc, buf, dat_len,
+                                             sink, err);
     }
 }
 
@@ -10341,7 +15924,7 @@ char *yyjson_mut_val_write_opts(const yyjson_mut_val *val,
                                 const yyjson_alc *alc_ptr,
                                 usize *dat_len,
                                 yyjson_write_err *err) {
-    return mut_write_root(val, 0, flg, alc_ptr, NULL, dat_len, err);
+    return mut_write_root(val, 0, flg, alc_ptr, NULL, dat_len, NULL, err);
 }
 
 char *yyjson_mut_write_opts(const yyjson_mut_doc *doc,
@@ -10359,21 +15942,50 @@ char *yyjson_mut_write_opts(const yyjson_mut_doc *doc,
         estimated_val_num = 0;
     }
     return mut_write_root(root, estimated_val_num,
-                          flg, alc_ptr, NULL, dat_len, err);
+                          flg, alc_ptr, NULL, dat_len, NULL, err);
 }
 
 size_t yyjson_mut_val_write_buf(char *buf, size_t buf_len,
                                 const yyjson_mut_val *val,
                                 yyjson_write_flag flg,
                                 yyjson_write_err *err) {
+    yyjson_write_err tmp_err;
+    yyjson_alc alc;
+    usize stk[YYJSON_WRITER_EXACT_STACK_SIZE / sizeof(usize)];
+    usize len = buf_len;
+
+    if (!err) err = &tmp_err;
     if (unlikely(!buf || !buf_len)) {
-        if (err) err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
-        if (err) err->msg = "input buf or buf_len is invalid";
+        err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
+        err->msg = "input buf or buf_len is invalid";
         return 0;
-    } else {
-        mut_write_root(val, 0, flg, &YYJSON_NULL_ALC, buf, &buf_len, err);
-        return buf_len;
     }
+
+    /* write in place, retry with the exact-size writer if the buffer is too
+       small for the writer, see `yyjson_val_write_buf()` */
+    if (!has_flg(PRESIZE) || !val) {
+        mut_write_root(val, 0, flg, &YYJSON_NULL_ALC, buf, &len, NULL, err);
+        if (err->code != YYJSON_WRITE_ERROR_MEMORY_ALLOCATION) return len;
+    }
+    yyjson_alc_pool_init(&alc, (void *)stk, sizeof(stk));
+    len = mut_write_len_root(val, flg, &alc, err);
+    if (!err->code && len >= buf_len) {
+        err->code = YYJSON_WRITE_ERROR_MEMORY_ALLOCATION;
+        err->msg = MSG_MALLOC;
+        return 0;
+    }
+    if (!err->code && mut_write_root_exact(val, flg, alc,
+                                           YYJSON_WRITER_EXACT_BUF_SIZE,
+                                           (u8 *)buf, len, err)) {
+        return len;
+    }
+    if (has_flg(PRESIZE) && err->code == YYJSON_WRITE_ERROR_MEMORY_ALLOCATION) {
+        /* the memory on the stack is too small for the nesting levels */
+        len = buf_len;
+        mut_write_root(val, 0, flg, &YYJSON_NULL_ALC, buf, &len, NULL, err);
+        return len;
+    }
+    return 0;
 }
 
 size_t yyjson_mut_write_buf(char *buf, size_t buf_len,
@@ -10384,6 +15996,94 @@ size_t yyjson_mut_write_buf(char *buf, size_t buf_len,
     return yyjson_mut_val_write_buf(buf, buf_len, root, flg, err);
 }
 
+size_t yyjson_mut_val_write_stream(const yyjson_mut_val *val,
+                                   yyjson_write_flag flg,
+                                   const yyjson_alc *alc_ptr,
+                                   size_t buf_len,
+                                   yyjson_write_sink func, void *ctx,
+                                   yyjson_write_err *err) {
+    yyjson_write_err tmp_err;
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    write_sink sink;
+    usize dat_len = 0;
+    u8 *dat;
+
+    if (!err) err = &tmp_err;
+    if (!write_sink_init(&sink, func, ctx, buf_len, err)) return 0;
+    dat = (u8 *)mut_write_root(val, 0, flg, &alc, NULL, &dat_len, &sink, err);
+    if (unlikely(!dat)) return 0;
+    return write_dat_to_sink(&sink, dat, dat_len, &alc, err);
+}
+
+size_t yyjson_mut_write_stream(const yyjson_mut_doc *doc,
+                               yyjson_write_flag flg,
+                               const yyjson_alc *alc_ptr,
+                               size_t buf_len,
+                               yyjson_write_sink func, void *ctx,
+                               yyjson_write_err *err) {
+    yyjson_mut_val *root = doc ? doc->root : NULL;
+    return yyjson_mut_val_write_stream(root, flg, alc_ptr, buf_len,
+                                       func, ctx, err);
+}
+
+yyjson_iovec *yyjson_mut_val_write_iov(const yyjson_mut_val *val,
+                                       yyjson_write_flag flg,
+                                       const yyjson_alc *alc_ptr,
+                                       size_t ref_len,
+                                       size_t *iov_num,
+                                       size_t *len,
+                                       yyjson_write_err *err) {
+    yyjson_write_err tmp_err;
+    usize tmp_iov_num, tmp_len, dat_len = 0;
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+    write_iov_ctx ctx;
+    write_sink sink;
+    u8 *dat;
+
+    if (!err) err = &tmp_err;
+    if (!iov_num) iov_num = &tmp_iov_num;
+    if (!len) len = &tmp_len;
+    write_iov_init(&ctx, &sink, &alc, ref_len);
+    dat = (u8 *)mut_write_root(val, 0, flg, &alc, NULL, &dat_len, &sink, err);
+    return write_iov_done(&ctx, &sink, dat, dat_len, iov_num, len, err);
+}
+
+yyjson_iovec *yyjson_mut_write_iov(const yyjson_mut_doc *doc,
+                                   yyjson_write_flag flg,
+                                   const yyjson_alc *alc_ptr,
+                                   size_t ref_len,
+                                   size_t *iov_num,
+                                   size_t *len,
+                                   yyjson_write_err *err) {
+    yyjson_mut_val *root = doc ? doc->root : NULL;
+    return yyjson_mut_val_write_iov(root, flg, alc_ptr, ref_len,
+                                    iov_num, len, err);
+}
+
+size_t yyjson_mut_val_write_len(const yyjson_mut_val *val,
+                                yyjson_write_flag flg,
+                                const yyjson_alc *alc_ptr,
+                                yyjson_write_err *err) {
+    yyjson_write_err tmp_err;
+    yyjson_alc alc = alc_ptr ? *alc_ptr : YYJSON_DEFAULT_ALC;
+
+    if (!err) err = &tmp_err;
+    if (unlikely(!val)) {
+        err->msg = "input JSON is NULL";
+        err->code = YYJSON_WRITE_ERROR_INVALID_PARAMETER;
+        return 0;
+    }
+    return mut_write_len_root(val, flg, &alc, err);
+}
+
+size_t yyjson_mut_write_len(const yyjson_mut_doc *doc,
+                            yyjson_write_flag flg,
+                            const yyjson_alc *alc_ptr,
+                            yyjson_write_err *err) {
+    yyjson_mut_val *root = doc ? doc->root : NULL;
+    return yyjson_mut_val_write_len(root, flg, alc_ptr, err);
+}
+
 #if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
 
 bool yyjson_mut_val_write_file(const char *path,
@@ -10541,20 +16241,19 @@ static_inline bool ptr_token_to_idx(const char *cur, usize len, usize *idx) {
 
 /**
  Compare JSON key with token.
- @param key a string key (yyjson_val or yyjson_mut_val)
+ @param str the string of a key (yyjson_val or yyjson_mut_val)
+ @param str_len the string length of the key
  @param token a JSON pointer token
  @param len unescaped token length
  @param esc number of escaped characters in this token
  @return true if `str` is equal to `token`
  */
-static_inline bool ptr_token_eq(void *key,
+static_inline bool ptr_token_eq(const char *str, usize str_len,
                                 const char *token, usize len, usize esc) {
-    yyjson_val *val = (yyjson_val *)key;
-    if (unsafe_yyjson_get_len(val) != len) return false;
+    if (str_len != len) return false;
     if (likely(!esc)) {
-        return memcmp(val->uni.str, token, len) == 0;
+        return memcmp(str, token, len) == 0;
     } else {
-        const char *str = val->uni.str;
         for (; len-- > 0; token++, str++) {
             if (*token == '~') {
                 if (*str != (*++token == '0' ? '~' : '/')) return false;
@@ -10603,7 +16302,10 @@ static_inline yyjson_val *ptr_obj_get(const yyjson_val *obj, const char *token,
     usize num = unsafe_yyjson_get_len(obj);
     if (unlikely(num == 0)) return NULL;
     for (; num > 0; num--, key = unsafe_yyjson_get_next(key + 1)) {
-        if (ptr_token_eq(key, token, len, esc)) return key + 1;
+        if (ptr_token_eq(unsafe_yyjson_get_str(key),
+                         unsafe_yyjson_get_len(key), token, len, esc)) {
+            return key + 1;
+        }
     }
     return NULL;
 }
@@ -10623,8 +16325,8 @@ static_inline yyjson_mut_val *ptr_mut_arr_get(const yyjson_mut_val *arr,
                                               usize len, usize esc,
                                               yyjson_mut_val **pre,
                                               bool *last) {
-    yyjson_mut_val *val = (yyjson_mut_val *)arr->uni.ptr; /* last (tail) */
-    usize num = unsafe_yyjson_get_len(arr), idx;
+    yyjson_mut_val *val;
+    usize num = unsafe_yyjson_mut_get_len(arr), idx;
     if (last) *last = false;
     if (pre) *pre = NULL;
     if (unlikely(num == 0)) {
@@ -10634,9 +16336,10 @@ static_inline yyjson_mut_val *ptr_mut_arr_get(const yyjson_mut_val *arr,
     if (unlikely(!ptr_token_to_idx(token, len, &idx))) return NULL;
     if (last) *last = (idx == num || idx == USIZE_MAX);
     if (unlikely(idx >= num)) return NULL;
-    while (idx-- > 0) val = val->next;
+    val = unsafe_yyjson_mut_get_last(arr); /* last (tail) */
+    while (idx-- > 0) val = unsafe_yyjson_mut_get_next(val);
     if (pre) *pre = val;
-    return val->next;
+    return unsafe_yyjson_mut_get_next(val);
 }
 
 /**
@@ -10652,15 +16355,17 @@ static_inline yyjson_mut_val *ptr_mut_obj_get(const yyjson_mut_val *obj,
                                               const char *token,
                                               usize len, usize esc,
                                               yyjson_mut_val **pre) {
-    yyjson_mut_val *pre_key = (yyjson_mut_val *)obj->uni.ptr, *key;
-    usize num = unsafe_yyjson_get_len(obj);
+    yyjson_mut_val *pre_key, *key;
+    usize num = unsafe_yyjson_mut_get_len(obj);
     if (pre) *pre = NULL;
     if (unlikely(num == 0)) return NULL;
+    pre_key = unsafe_yyjson_mut_get_last(obj);
     for (; num > 0; num--, pre_key = key) {
-        key = pre_key->next->next;
-        if (ptr_token_eq(key, token, len, esc)) {
+        key = unsafe_yyjson_mut_get_next(unsafe_yyjson_mut_get_next(pre_key));
+        if (ptr_token_eq(unsafe_yyjson_mut_get_str(key),
+                         unsafe_yyjson_mut_get_len(key), token, len, esc)) {
             if (pre) *pre = pre_key;
-            return key->next;
+            return unsafe_yyjson_mut_get_next(key);
         }
     }
     return NULL;
@@ -10847,35 +16552,38 @@ bool unsafe_yyjson_mut_ptr_putx(
     }
 
     /* JSON pointer is resolved, insert or replace target value */
-    ctn_len = unsafe_yyjson_get_len(ctn);
+    ctn_len = unsafe_yyjson_mut_get_len(ctn);
     if (ctn_type == YYJSON_TYPE_OBJ) {
         if (ctx) ctx->ctn = ctn;
         if (!val || insert_new) {
             /* insert new key-value pair */
             key = ptr_new_key(token, token_len, esc, doc);
             if (unlikely(!key)) return_err_alloc(false);
-            if (ctx) ctx->pre = ctn_len ? (yyjson_mut_val *)ctn->uni.ptr : key;
+            if (ctx) {
+                ctx->pre = ctn_len ? unsafe_yyjson_mut_get_last(ctn) : key;
+            }
             unsafe_yyjson_mut_obj_add(ctn, key, new_val, ctn_len);
         } else {
             /* replace exist value */
-            key = pre->next->next;
+            key = unsafe_yyjson_mut_get_next(unsafe_yyjson_mut_get_next(pre));
             if (ctx) ctx->pre = pre;
             if (ctx) ctx->old = val;
             yyjson_mut_obj_put(ctn, key, new_val);
         }
     } else {
-        /* array */
+        /* array, the links are changed below without the index */
+        if (unsafe_yyjson_mut_is_indexed(ctn)) unsafe_yyjson_mut_idx_drop(ctn);
         if (ctx && (val || idx_is_last)) ctx->ctn = ctn;
         if (insert_new) {
             /* append new value */
             if (val) {
-                pre->next = new_val;
-                new_val->next = val;
+                unsafe_yyjson_mut_set_next(pre, new_val);
+                unsafe_yyjson_mut_set_next(new_val, val);
                 if (ctx) ctx->pre = pre;
-                unsafe_yyjson_set_len(ctn, ctn_len + 1);
+                unsafe_yyjson_mut_set_len(ctn, ctn_len + 1);
             } else if (idx_is_last) {
                 if (ctx) ctx->pre = ctn_len ?
-                    (yyjson_mut_val *)ctn->uni.ptr : new_val;
+                    unsafe_yyjson_mut_get_last(ctn) : new_val;
                 yyjson_mut_arr_append(ctn, new_val);
             } else {
                 return_err_resolve(false, token - hdr);
@@ -10884,12 +16592,15 @@ bool unsafe_yyjson_mut_ptr_putx(
             /* replace exist value */
             if (!val) return_err_resolve(false, token - hdr);
             if (ctn_len > 1) {
-                new_val->next = val->next;
-                pre->next = new_val;
-                if (ctn->uni.ptr == val) ctn->uni.ptr = new_val;
+                unsafe_yyjson_mut_set_next(new_val,
+                                           unsafe_yyjson_mut_get_next(val));
+                unsafe_yyjson_mut_set_next(pre, new_val);
+                if (unsafe_yyjson_mut_get_last(ctn) == val) {
+                    unsafe_yyjson_mut_set_last(ctn, new_val);
+                }
             } else {
-                new_val->next = new_val;
-                ctn->uni.ptr = new_val;
+                unsafe_yyjson_mut_set_next(new_val, new_val);
+                unsafe_yyjson_mut_set_last(ctn, new_val);
                 pre = new_val;
             }
             if (ctx) ctx->pre = pre;
@@ -10917,7 +16628,8 @@ yyjson_mut_val *unsafe_yyjson_mut_ptr_replacex(
     if (!cur_val) return NULL;
 
     if (yyjson_mut_is_obj(ctx->ctn)) {
-        yyjson_mut_val *key = ctx->pre->next->next;
+        yyjson_mut_val *key = unsafe_yyjson_mut_get_next(ctx->pre);
+        key = unsafe_yyjson_mut_get_next(key);
         yyjson_mut_obj_put(ctx->ctn, key, new_val);
     } else {
         yyjson_ptr_ctx_replace(ctx, new_val);
@@ -10937,7 +16649,8 @@ yyjson_mut_val *unsafe_yyjson_mut_ptr_removex(
     cur_val = unsafe_yyjson_mut_ptr_getx(val, ptr, len, ctx, err);
     if (cur_val) {
         if (yyjson_mut_is_obj(ctx->ctn)) {
-            yyjson_mut_val *key = ctx->pre->next->next;
+            yyjson_mut_val *key = unsafe_yyjson_mut_get_next(ctx->pre);
+            key = unsafe_yyjson_mut_get_next(key);
             yyjson_mut_obj_put(ctx->ctn, key, NULL);
         } else {
             yyjson_ptr_ctx_remove(ctx);
@@ -10971,9 +16684,8 @@ typedef enum patch_op {
     PATCH_OP_NONE       /* invalid */
 } patch_op;
 
-static patch_op patch_op_get(yyjson_val *op) {
-    const char *str = op->uni.str;
-    switch (unsafe_yyjson_get_len(op)) {
+static patch_op patch_op_get(const char *str, usize len) {
+    switch (len) {
         case 3:
             if (!memcmp(str, "add", 3)) return PATCH_OP_ADD;
             return PATCH_OP_NONE;
@@ -11015,13 +16727,13 @@ static patch_op patch_op_get(yyjson_val *op) {
     return_err(INVALID_MEMBER, "invalid member " _key)
 
 #define ptr_get(_ptr) yyjson_mut_ptr_getx( \
-    root, _ptr->uni.str, _ptr##_len, NULL, &err->ptr)
+    root, _ptr##_str, _ptr##_len, NULL, &err->ptr)
 #define ptr_add(_ptr, _val) yyjson_mut_ptr_addx( \
-    root, _ptr->uni.str, _ptr##_len, _val, doc, false, NULL, &err->ptr)
+    root, _ptr##_str, _ptr##_len, _val, doc, false, NULL, &err->ptr)
 #define ptr_remove(_ptr) yyjson_mut_ptr_removex( \
-    root, _ptr->uni.str, _ptr##_len, NULL, &err->ptr)
+    root, _ptr##_str, _ptr##_len, NULL, &err->ptr)
 #define ptr_replace(_ptr, _val)yyjson_mut_ptr_replacex( \
-    root, _ptr->uni.str, _ptr##_len, _val, NULL, &err->ptr)
+    root, _ptr##_str, _ptr##_len, _val, NULL, &err->ptr)
 
 yyjson_mut_val *yyjson_patch(yyjson_mut_doc *doc,
                              const yyjson_val *orig,
@@ -11051,6 +16763,7 @@ yyjson_mut_val *yyjson_patch(yyjson_mut_doc *doc,
         patch_op op_enum;
         yyjson_val *op, *path, *from = NULL, *value;
         yyjson_mut_val *val = NULL, *test;
+        const char *path_str, *from_str = NULL;
         usize path_len, from_len = 0;
         if (unlikely(!unsafe_yyjson_is_obj(obj))) {
             return_err(INVALID_OPERATION, "JSON patch operation is not object");
@@ -11060,12 +16773,14 @@ yyjson_mut_val *yyjson_patch(yyjson_mut_doc *doc,
         op = yyjson_obj_get(obj, "op");
         if (unlikely(!op)) return_err_key("`op`");
         if (unlikely(!yyjson_is_str(op))) return_err_val("`op`");
-        op_enum = patch_op_get(op);
+        op_enum = patch_op_get(unsafe_yyjson_get_str(op),
+                               unsafe_yyjson_get_len(op));
 
         /* get required member: path */
         path = yyjson_obj_get(obj, "path");
         if (unlikely(!path)) return_err_key("`path`");
         if (unlikely(!yyjson_is_str(path))) return_err_val("`path`");
+        path_str = unsafe_yyjson_get_str(path);
         path_len = unsafe_yyjson_get_len(path);
 
         /* get required member: value, from */
@@ -11080,6 +16795,7 @@ yyjson_mut_val *yyjson_patch(yyjson_mut_doc *doc,
                 from = yyjson_obj_get(obj, "from");
                 if (unlikely(!from)) return_err_key("`from`");
                 if (unlikely(!yyjson_is_str(from))) return_err_val("`from`");
+                from_str = unsafe_yyjson_get_str(from);
                 from_len = unsafe_yyjson_get_len(from);
                 break;
             default:
@@ -11170,6 +16886,7 @@ yyjson_mut_val *yyjson_mut_patch(yyjson_mut_doc *doc,
         patch_op op_enum;
         yyjson_mut_val *op, *path, *from = NULL, *value;
         yyjson_mut_val *val = NULL, *test;
+        const char *path_str, *from_str = NULL;
         usize path_len, from_len = 0;
         if (!unsafe_yyjson_is_obj(obj)) {
             return_err(INVALID_OPERATION, "JSON patch operation is not object");
@@ -11179,13 +16896,15 @@ yyjson_mut_val *yyjson_mut_patch(yyjson_mut_doc *doc,
         op = yyjson_mut_obj_get(obj, "op");
         if (unlikely(!op)) return_err_key("`op`");
         if (unlikely(!yyjson_mut_is_str(op))) return_err_val("`op`");
-        op_enum = patch_op_get((yyjson_val *)(void *)op);
+        op_enum = patch_op_get(unsafe_yyjson_mut_get_str(op),
+                               unsafe_yyjson_mut_get_len(op));
 
         /* get required member: path */
         path = yyjson_mut_obj_get(obj, "path");
         if (unlikely(!path)) return_err_key("`path`");
         if (unlikely(!yyjson_mut_is_str(path))) return_err_val("`path`");
-        path_len = unsafe_yyjson_get_len(path);
+        path_str = unsafe_yyjson_mut_get_str(path);
+        path_len = unsafe_yyjson_mut_get_len(path);
 
         /* get required member: value, from */
         switch ((int)op_enum) {
@@ -11201,7 +16920,8 @@ yyjson_mut_val *yyjson_mut_patch(yyjson_mut_doc *doc,
                 if (unlikely(!yyjson_mut_is_str(from))) {
                     return_err_val("`from`");
                 }
-                from_len = unsafe_yyjson_get_len(from);
+                from_str = unsafe_yyjson_mut_get_str(from);
+                from_len = unsafe_yyjson_mut_get_len(from);
                 break;
             default:
                 break;
@@ -11297,8 +17017,7 @@ yyjson_mut_val *yyjson_merge_patch(yyjson_mut_doc *doc,
 
     memset(&local_orig, 0, sizeof(local_orig));
     if (!yyjson_is_obj(orig)) {
-        local_orig.tag = builder->tag;
-        local_orig.uni = builder->uni;
+        unsafe_yyjson_set_obj(&local_orig, 0);
         orig = &local_orig;
     }
 
@@ -11358,8 +17077,8 @@ yyjson_mut_val *yyjson_mut_merge_patch(yyjson_mut_doc *doc,
     if (orig != &local_orig) {
         yyjson_mut_obj_foreach(orig, idx, max, key, orig_val) {
             patch_val = yyjson_mut_obj_getn(patch,
-                                            unsafe_yyjson_get_str(key),
-                                            unsafe_yyjson_get_len(key));
+                                            unsafe_yyjson_mut_get_str(key),
+                                            unsafe_yyjson_mut_get_len(key));
             if (!patch_val) {
                 mut_key = yyjson_mut_val_mut_copy(doc, key);
                 mut_val = yyjson_mut_val_mut_copy(doc, orig_val);
@@ -11376,8 +17095,8 @@ yyjson_mut_val *yyjson_mut_merge_patch(yyjson_mut_doc *doc,
         }
         mut_key = yyjson_mut_val_mut_copy(doc, key);
         orig_val = yyjson_mut_obj_getn(orig,
-                                       unsafe_yyjson_get_str(key),
-                                       unsafe_yyjson_get_len(key));
+                                       unsafe_yyjson_mut_get_str(key),
+                                       unsafe_yyjson_mut_get_len(key));
         merged_val = yyjson_mut_merge_patch(doc, orig_val, patch_val);
         if (!yyjson_mut_obj_add(builder, mut_key, merged_val)) return NULL;
     }
@@ -102,6 +102,15 @@
 #define YYJSON_DISABLE_UTF8_VALIDATION 0
 #endif
 
+/* Define as 1 to disable SIMD (SSE2/AVX2/NEON) code paths at compile-time.
+   The instruction set is selected by the compiler's target flags
+   (e.g. `-msse2`, `-mavx2`); portable scalar code is used otherwise.
+
+   This slightly reduces binary size, the output is exactly the same. */
+#ifndef YYJSON_DISABLE_SIMD
+#define YYJSON_DISABLE_SIMD 0
+#endif
+
 /* Define as 1 to improve performance on architectures that do not support
    unaligned memory access.
 
@@ -115,6 +124,24 @@
 #define YYJSON_READER_DEPTH_LIMIT 0
 #endif
 
+/* Define as 1 to use a compact layout for mutable values: 16 bytes instead of
+   24 bytes on 64-bit platforms. Values and strings are linked by 32-bit indexes
+   into the document's memory pools, so a mutable document can hold at most
+   4G values and 4GB of strings.
+
+   The `yyjson_mut_*` API is the same, with these differences:
+   - Strings are always copied into the document, for example `yyjson_mut_str()`
+     behaves like `yyjson_mut_strcpy()`.
+   - A value can only be added to containers of the document that created it,
+     use `yyjson_mut_val_mut_copy()` to copy it to another document.
+   - The fields of `yyjson_mut_val` are different and should not be accessed.
+
+   This reduces the memory usage of large mutable documents by about 30%,
+   but traversing and modifying them is slightly slower. */
+#ifndef YYJSON_MUT_COMPACT
+#define YYJSON_MUT_COMPACT 0
+#endif
+
 /* Define as 1 to build without libc (stdlib, string, math, stdio).
    Inline fallbacks for memcpy/memmove/memset/memcmp/strlen are provided.
    Optional `YYJSON_FREESTANDING_HEADER` for custom replacements.
@@ -379,6 +406,9 @@
 #if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
 #include <stdio.h>  /* for FILE, fopen, fread, fwrite, sprintf */
 #endif
+#if !YYJSON_FREESTANDING && YYJSON_MUT_COMPACT
+#include <assert.h> /* for assert, checks the document of compact values */
+#endif
 #if !YYJSON_FREESTANDING
 #include <stdlib.h> /* for malloc, realloc, free, strtod */
 #include <string.h> /* for memcpy, memmove, memset, memcmp, strlen */
@@ -717,6 +747,8 @@ yyjson_api bool yyjson_alc_pool_init(yyjson_alc *alc, void *buf, size_t size);
  This allocator has a similar usage to the pool allocator above. However, when
  there is not enough memory, this allocator will dynamically request more memory
  using libc's `malloc` function, and frees it all at once when it is destroyed.
+ The memory is allocated in chunks of power-of-two sizes (at least 4KB), and
+ an unused chunk can be found for reuse in constant time.
 
  @return A new dynamic allocator, or NULL if memory allocation failed.
  @note The returned value should be freed with `yyjson_alc_dyn_free()`.
@@ -731,6 +763,196 @@ yyjson_api yyjson_alc *yyjson_alc_dyn_new(void);
  */
 yyjson_api void yyjson_alc_dyn_free(yyjson_alc *alc);
 
+/** Memory statistics of a dynamic allocator,
+    see `yyjson_alc_dyn_get_stats()`. */
+typedef struct yyjson_alc_dyn_stats {
+    /** The size of the memory held by the allocator, in bytes, including
+        the unused memory kept for reuse. The chunk sizes are powers of 2. */
+    size_t held_size;
+    /** The size of the memory in use, in bytes, as requested by the callers
+        of malloc/realloc. */
+    size_t used_size;
+    /** The number of malloc calls. */
+    size_t alloc_count;
+    /** The number of malloc calls that reused an unused chunk. The hit rate
+        is `hit_count / alloc_count`. */
+    size_t hit_count;
+    /** The number of realloc calls that need a larger chunk, the chunk is
+        grown in place or moved by libc's `realloc`, not reused. */
+    size_t grow_count;
+} yyjson_alc_dyn_stats;
+
+/**
+ Get the memory statistics of a dynamic allocator.
+ This can be used to decide how long to keep the allocator and its unused
+ memory, for example, to recreate it when `held_size` is much larger than
+ `used_size` for a long time.
+
+ @param alc The dynamic allocator created by `yyjson_alc_dyn_new()`.
+ @param stats A pointer to receive the statistics.
+ @return false if `alc` or `stats` is NULL, or `alc` is not a dynamic allocator.
+ */
+yyjson_api bool yyjson_alc_dyn_get_stats(const yyjson_alc *alc,
+                                         yyjson_alc_dyn_stats *stats);
+
+/**
+ A thread-safe allocator.
+
+ This allocator has a similar usage to the dynamic allocator above, but it can
+ be shared by multiple threads, for example, by a pool of worker threads that
+ read and write JSON documents. The memory is allocated in power-of-two size
+ classes. Unused memory is kept in several caches and a lock-free depot for
+ reuse, and is freed all at once when the allocator is destroyed.
+
+ Threads pick a cache by their stack address, so the number of caches should
+ be close to the number of threads. When the caches are busy, memory is taken
+ from or returned to the depot without locking.
+
+ @param cache_num The number of caches, such as the number of threads.
+    Pass 0 to use the default value (8). The maximum value is 256.
+ @return A new thread-safe allocator, or NULL if memory allocation failed or
+    atomic operations are not supported by the compiler.
+ @note The returned value should be freed with `yyjson_alc_mt_free()`,
+    after all threads have stopped using it.
+ */
+yyjson_api yyjson_alc *yyjson_alc_mt_new(size_t cache_num);
+
+/**
+ Free a thread-safe allocator which is created by `yyjson_alc_mt_new()`.
+ @param alc The thread-safe allocator to be destroyed.
+ */
+yyjson_api void yyjson_alc_mt_free(yyjson_alc *alc);
+
+/** The state of a limited allocator, see `yyjson_alc_limit_init()`.
+    The statistics can be read or reset at any time. */
+typedef struct yyjson_alc_limit {
+    /** The base allocator that provides the memory. */
+    yyjson_alc base;
+    /** The maximum size of memory in use, in bytes.
+        It can be changed at any time, and only affects later allocations. */
+    size_t limit;
+    /** The size of memory in use, in bytes, as requested by the callers of
+        malloc/realloc, not including the two-word header of each chunk. */
+    size_t cur_size;
+    /** The peak value of `cur_size`. */
+    size_t peak_size;
+    /** The number of successful malloc and realloc calls. */
+    size_t alloc_count;
+    /** The number of allocations rejected because of the limit. */
+    size_t fail_count;
+} yyjson_alc_limit;
+
+/**
+ A limited allocator, which enforces a memory budget and records the memory
+ usage of another allocator.
+
+ This allocator may be used to cap the memory that one untrusted input may
+ consume. When an allocation would exceed the limit, it fails like any other
+ allocation failure: the reader returns `YYJSON_READ_ERROR_MEMORY_ALLOCATION`,
+ the writer returns `YYJSON_WRITE_ERROR_MEMORY_ALLOCATION`, and the mutable
+ value creating functions return NULL.
+
+ @param alc The allocator to be initialized.
+    If `alc` is NULL, returns false.
+    If `lim` is NULL, this will be set to an empty allocator.
+ @param lim The state of this allocator, which should be held by the caller
+    while `alc` is in use. It contains the limit and the statistics.
+ @param base The base allocator that provides the memory,
+    pass NULL to use the default allocator (libc's malloc).
+ @param limit The maximum size of memory in use, in bytes.
+ @return true if the `alc` has been successfully initialized.
+
+ @b Example
+ @code
+    // read untrusted JSON with at most 16MB of memory
+    yyjson_alc_limit lim;
+    yyjson_alc alc;
+    yyjson_alc_limit_init(&alc, &lim, NULL, 16 * 1024 * 1024);
+
+    yyjson_read_err err;
+    yyjson_doc *doc = yyjson_read_opts(dat, len, 0, &alc, &err);
+    if (!doc && err.code == YYJSON_READ_ERROR_MEMORY_ALLOCATION) {
+        // rejected, lim.fail_count > 0 if the limit was hit
+    }
+    printf("peak memory: %zu\n", lim.peak_size);
+    yyjson_doc_free(doc);
+ @endcode
+
+ @warning This Allocator is not thread-safe, even if the base allocator is.
+ */
+yyjson_api bool yyjson_alc_limit_init(yyjson_alc *alc, yyjson_alc_limit *lim,
+                                      const yyjson_alc *base, size_t limit);
+
+/** Options for the arena allocator, see `yyjson_alc_arena_new()`.
+    The options are hints: if an option is not available, the allocator falls
+    back to regular pages and the default placement. */
+typedef uint32_t yyjson_arena_flag;
+
+/** Default option: regular pages. */
+static const yyjson_arena_flag YYJSON_ARENA_NOFLAG          = 0;
+
+/** Use transparent huge pages, with `madvise(MADV_HUGEPAGE)` (Linux).
+    The region is aligned to 2MB, and mapped in multiples of 2MB. */
+static const yyjson_arena_flag YYJSON_ARENA_HUGE_PAGE       = 1 << 0;
+
+/** Use explicit 2MB huge pages with `MAP_HUGETLB` (Linux), which must be
+    reserved by the system (e.g. `vm.nr_hugepages`). If there are not enough
+    reserved pages, this falls back to `YYJSON_ARENA_HUGE_PAGE`. */
+static const yyjson_arena_flag YYJSON_ARENA_HUGETLB         = 1 << 1;
+
+/** Prefer to place the memory on the NUMA node `node`, with the `mbind()`
+    system call (Linux). Other nodes are used if this node is out of memory. */
+static const yyjson_arena_flag YYJSON_ARENA_NUMA_NODE       = 1 << 2;
+
+/**
+ An arena allocator, which reserves a memory region for large documents.
+
+ This allocator reserves `size` bytes of virtual memory at once with `mmap()`,
+ and the pages are only used when they are touched. It allocates memory by
+ bumping an offset in the region, so the values and strings of a document are
+ contiguous. Only the last allocation can be resized in place or released;
+ the other memory can be reused after `yyjson_alc_arena_reset()`.
+
+ This may be used to read and traverse multi-GB documents with fewer TLB
+ misses (with huge pages) and with memory local to the reading threads (with
+ NUMA placement). On platforms without `mmap()`, the region is allocated with
+ the default allocator (libc's malloc) and the options are ignored.
+
+ @param size The size of the region in bytes, which is the maximum amount of
+    memory that can be allocated. If `size` is 0, returns NULL.
+ @param flg The options, see `yyjson_arena_flag`.
+ @param node The NUMA node for `YYJSON_ARENA_NUMA_NODE`, less than 256.
+ @return A new arena allocator, or NULL if memory allocation failed.
+ @note The returned value should be freed with `yyjson_alc_arena_free()`.
+
+ @warning This Allocator is not thread-safe.
+ */
+yyjson_api yyjson_alc *yyjson_alc_arena_new(size_t size,
+                                            yyjson_arena_flag flg,
+                                            uint32_t node);
+
+/**
+ Reset an arena allocator created by `yyjson_alc_arena_new()`, so that the
+ whole region can be reused. All the memory allocated from it must no longer
+ be used, such as the documents created with it.
+ @param alc The arena allocator to be reset.
+ */
+yyjson_api void yyjson_alc_arena_reset(yyjson_alc *alc);
+
+/**
+ Returns the options that took effect for an arena allocator created by
+ `yyjson_alc_arena_new()`, for example, `YYJSON_ARENA_HUGE_PAGE` is returned
+ only if the system accepted it. Returns 0 if `alc` is not an arena allocator.
+ */
+yyjson_api yyjson_arena_flag yyjson_alc_arena_get_flag(const yyjson_alc *alc);
+
+/**
+ Free an arena allocator created by `yyjson_alc_arena_new()`, and the memory
+ region. All the memory allocated from it must no longer be used.
+ @param alc The arena allocator to be destroyed.
+ */
+yyjson_api void yyjson_alc_arena_free(yyjson_alc *alc);
+
 
 
 /*==============================================================================
@@ -768,6 +990,9 @@ yyjson_api bool yyjson_locate_pos(const char *str, size_t len, size_t pos,
  */
 typedef struct yyjson_doc yyjson_doc;
 
+/** Opaque indexes of containers in an immutable document. */
+typedef struct yyjson_doc_idx yyjson_doc_idx;
+
 /**
  An immutable value for reading JSON.
  A JSON Value has the same lifetime as its document. The memory is held by its
@@ -782,6 +1007,9 @@ typedef struct yyjson_val yyjson_val;
  */
 typedef struct yyjson_mut_doc yyjson_mut_doc;
 
+/** Opaque indexes of containers in a mutable document. */
+typedef struct yyjson_mut_doc_idx yyjson_mut_doc_idx;
+
 /**
  A mutable value for building JSON.
  A JSON Value has the same lifetime as its document. The memory is held by its
@@ -886,6 +1114,44 @@ static const yyjson_read_flag YYJSON_READ_ALLOW_SINGLE_QUOTED_STR   = 1 << 12;
     non-whitespace character with code point above `U+007F`. */
 static const yyjson_read_flag YYJSON_READ_ALLOW_UNQUOTED_KEY        = 1 << 13;
 
+/** Read the input in two stages: build an index of the structural characters
+    and strings with SIMD first, then build the document from the index.
+    The document and the error information are the same as the default reader.
+    The index costs up to 4 bytes of memory per input byte, and the one-pass
+    default reader is usually faster on a single thread.
+    This flag is ignored (the default reader is used) if the root value is not
+    an array or object, the input is 4GB or larger, or it is combined with
+    `YYJSON_READ_STOP_WHEN_DONE`, `YYJSON_READ_ALLOW_COMMENTS`,
+    `YYJSON_READ_ALLOW_EXT_WHITESPACE`, `YYJSON_READ_ALLOW_SINGLE_QUOTED_STR`
+    or `YYJSON_READ_ALLOW_UNQUOTED_KEY`. */
+static const yyjson_read_flag YYJSON_READ_STRUCTURAL_INDEX          = 1 << 14;
+
+/** Read the input data without copying or modifying it.
+    The strings without escapes reference the input data, they have the
+    `YYJSON_SUBTYPE_NOESC` subtype and are NOT null-terminated, the length
+    should be taken from `yyjson_get_len()`. The other strings are unescaped
+    into a string pool owned by the document. This can halve the peak memory
+    usage when the input is read-only and mostly unescaped.
+    The caller should hold the input data before freeing the document.
+    The input data must be padded by `YYJSON_PADDING_SIZE` zero bytes,
+    which are read but not written.
+    This flag only works with `yyjson_read()`, `yyjson_read_opts()` and
+    `yyjson_read_sax()`. It cannot be combined with `YYJSON_READ_INSITU`,
+    `YYJSON_READ_NUMBER_AS_RAW`, `YYJSON_READ_BIGNUM_AS_RAW` or
+    `YYJSON_READ_ALLOW_UNQUOTED_KEY`, and `YYJSON_READ_STRUCTURAL_INDEX` is
+    ignored. */
+static const yyjson_read_flag YYJSON_READ_ZERO_COPY                 = 1 << 15;
+
+/** Count the values with a SIMD pass over the input before reading, and
+    allocate the values once with this count instead of an estimate from the
+    input length. The count is exact for standard JSON, so the values are not
+    reallocated while reading, at the cost of scanning the input twice.
+    With comments, single-quoted strings or unquoted keys, the count may be
+    larger or smaller, and the values are reallocated if needed.
+    This flag is ignored if it is combined with `YYJSON_READ_STOP_WHEN_DONE`.
+    See `yyjson_doc_get_read_stats()` to compare the memory usage. */
+static const yyjson_read_flag YYJSON_READ_PRECOUNT                  = 1 << 16;
+
 /** Allow JSON5 format, see: [https://json5.org].
     This flag supports all JSON5 features with some additional extensions:
     - Accepts more escape sequences than JSON5 (e.g. `\a`, `\e`).
@@ -966,6 +1232,26 @@ typedef struct yyjson_read_err {
 
 
 
+/** A task of the parallel reader and writer, see `yyjson_par_run`. */
+typedef void (*yyjson_par_task)(void *arg, size_t idx);
+
+/**
+ A task runner for the parallel reader and writer, such as a thread pool.
+
+ It should call `task(arg, idx)` once for each `idx` in `[0, num)` and return
+ after all the calls have finished. The calls may run in any order, and may
+ run concurrently on different threads.
+
+ @param ctx The context passed to `yyjson_read_par()` or `yyjson_write_par()`.
+ @param task The task function.
+ @param arg The argument of the task function.
+ @param num The number of tasks.
+ */
+typedef void (*yyjson_par_run)(void *ctx, yyjson_par_task task, void *arg,
+                               size_t num);
+
+
+
 #if !defined(YYJSON_DISABLE_READER) || !YYJSON_DISABLE_READER
 
 /**
@@ -997,6 +1283,35 @@ yyjson_api yyjson_doc *yyjson_read_opts(char *dat,
                                         const yyjson_alc *alc,
                                         yyjson_read_err *err);
 
+/**
+ Read JSON into an existing document, reusing its memory.
+
+ The memory of the document's values and string pool is retained and reused
+ by the reader, and only grows when the input needs more. So reading inputs of
+ similar size into the same document does not allocate memory after the first
+ read. The memory is not shrunk, see `yyjson_doc_get_capacity()`.
+
+ @param doc The document to read into, its values are no longer available
+    after this call. Pass NULL to create a new document.
+ @param dat The JSON data, same as `yyjson_read_opts()`.
+ @param len The length of JSON data in bytes.
+ @param flg The JSON read options.
+ @param alc The memory allocator used by the new document if `doc` is NULL,
+    otherwise the document's allocator is used.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return The JSON document, which may be moved from `doc`,
+    or NULL if an error occurs, then `doc` is freed.
+    When it's no longer needed, it should be freed with `yyjson_doc_free()`.
+ */
+yyjson_api yyjson_doc *yyjson_read_into(yyjson_doc *doc,
+                                        char *dat,
+                                        size_t len,
+                                        yyjson_read_flag flg,
+                                        const yyjson_alc *alc,
+                                        yyjson_read_err *err);
+
 #if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
 
 /**
@@ -1047,6 +1362,42 @@ yyjson_api yyjson_doc *yyjson_read_fp(FILE *fp,
                                       const yyjson_alc *alc,
                                       yyjson_read_err *err);
 
+/**
+ Read a JSON file with a memory-mapped view of it.
+
+ The file is mapped read-only and read with `YYJSON_READ_ZERO_COPY`, instead
+ of being copied into an allocated buffer. The pages are never written, so they
+ stay shared with the page cache. The strings without escapes reference the
+ mapping and are NOT null-terminated (see `YYJSON_READ_ZERO_COPY`), the other
+ strings are unescaped into a string pool. The zero-filled rest of the last
+ page is used as the padding of the reader. The document owns the mapping,
+ it's unmapped by `yyjson_doc_free()`.
+
+ If memory mapping is not supported by the platform, or the file is not a
+ regular file (pipe, device, etc.), the file is read with `yyjson_read_file()`.
+
+ @param path The JSON file's path.
+    If this path is NULL or invalid, the function will fail and return NULL.
+ @param flg The JSON read options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+    `YYJSON_READ_ZERO_COPY` is always used, `YYJSON_READ_INSITU` is ignored.
+    With the flags not supported by `YYJSON_READ_ZERO_COPY`, the file is read
+    with `yyjson_read_file()`.
+ @param alc The memory allocator used by JSON reader for the values.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return A new JSON document, or NULL if an error occurs.
+    When it's no longer needed, it should be freed with `yyjson_doc_free()`.
+
+ @warning The file should not be truncated while the document is in use,
+    otherwise accessing the strings may raise a signal (e.g. SIGBUS).
+ */
+yyjson_api yyjson_doc *yyjson_read_file_mmap(const char *path,
+                                             yyjson_read_flag flg,
+                                             const yyjson_alc *alc,
+                                             yyjson_read_err *err);
+
 #endif /* !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE */
 
 /**
@@ -1133,6 +1484,221 @@ yyjson_api void yyjson_incr_free(yyjson_incr_state *state);
 
 #endif /* YYJSON_DISABLE_INCR_READER */
 
+/**
+ Read a JSON document with multiple threads.
+
+ The input is split into parts at the commas between the elements (or
+ key-value pairs) of the root array (or object). The split points are chosen by
+ a fast heuristic near evenly spaced positions. The parts are read in parallel
+ with `run`, then merged into one document.
+
+ The document and the error information are the same as `yyjson_read_opts()`.
+ If a part fails to read, for example because a split point is not a real
+ separator or the input is invalid, the whole input is read again with
+ `yyjson_read_opts()` on the calling thread.
+
+ `yyjson_read_opts()` is used directly if `YYJSON_READ_INSITU` is set, the
+ root value is not an array or object, or the input is too small to split.
+ A part containing a trailing comma (`YYJSON_READ_ALLOW_TRAILING_COMMAS`),
+ except the last one, is also read again on the calling thread.
+
+ @param dat The JSON data (UTF-8 without BOM), null-terminator is not required.
+    If `dat` is NULL, returns NULL.
+ @param len The length of JSON data in bytes.
+    If `len` is 0, returns NULL.
+ @param flg The JSON read options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON reader.
+    Pass NULL to use the libc's default allocator.
+    It must be thread-safe if `run` runs the tasks concurrently.
+ @param par_num The maximum number of parts, such as the number of threads.
+ @param run The task runner.
+    Pass NULL to run the tasks one by one on the calling thread.
+ @param run_ctx The context passed to `run`.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return A new JSON document, or NULL if an error occurs.
+    When it's no longer needed, it should be freed with `yyjson_doc_free()`.
+ */
+yyjson_api yyjson_doc *yyjson_read_par(char *dat, size_t len,
+                                       yyjson_read_flag flg,
+                                       const yyjson_alc *alc,
+                                       size_t par_num,
+                                       yyjson_par_run run, void *run_ctx,
+                                       yyjson_read_err *err);
+
+/** Opaque state for JSON Lines (NDJSON) reader. */
+typedef struct yyjson_ndjson yyjson_ndjson;
+
+/** A record read by the JSON Lines reader. */
+typedef struct yyjson_ndjson_rec {
+    /** The document of this record, NULL if an error occurs.
+        It's owned by the reader and is valid until the next call of
+        `yyjson_ndjson_read()` or `yyjson_ndjson_free()`, don't free it. */
+    yyjson_doc *doc;
+    /** Byte offset of this record (the beginning of its line) in the input. */
+    size_t pos;
+    /** Length of this record in bytes, without the line break (LF or CRLF). */
+    size_t len;
+    /** Line number of this record, starting from 1. */
+    size_t line;
+    /** Error information, `err.pos` is the byte offset in the input. */
+    yyjson_read_err err;
+} yyjson_ndjson_rec;
+
+/**
+ Create a JSON Lines (NDJSON) reader for a buffer.
+
+ Each non-blank line of the input is read as a JSON document. The documents
+ of a batch share one piece of memory, which is reused by the next batch, so
+ no allocation happens per record once the memory is large enough.
+
+ To read JSON Lines:
+ 1. Call `yyjson_ndjson_new()` or `yyjson_ndjson_new_fp()` to create a reader.
+ 2. Call `yyjson_ndjson_read()` repeatedly until it returns 0.
+ 3. Call `yyjson_ndjson_free()` to free the reader.
+
+ @param dat The JSON Lines data, null-terminator is not required.
+    The data should be kept unmodified until the reader is freed.
+    If `dat` is NULL, returns NULL.
+ @param len The length of the data in bytes.
+ @param flg The JSON read options for each record.
+    `YYJSON_READ_INSITU` is ignored, `YYJSON_READ_ALLOW_BOM` only allows a BOM
+    at the beginning of the input.
+ @param alc The memory allocator used by the reader.
+    Pass NULL to use the libc's default allocator.
+ @return A new reader, or NULL if an error occurs.
+    It should be freed with `yyjson_ndjson_free()`.
+ */
+yyjson_api yyjson_ndjson *yyjson_ndjson_new(const char *dat, size_t len,
+                                            yyjson_read_flag flg,
+                                            const yyjson_alc *alc);
+
+#if !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE
+
+/**
+ Create a JSON Lines (NDJSON) reader for a file pointer.
+
+ The file is read in chunks from its current position, a line can be longer
+ than a chunk. For a file descriptor, use `fdopen()` to get a file pointer.
+
+ @param fp The file pointer, it should be kept open until the reader is freed.
+    If `fp` is NULL, returns NULL.
+ @param flg The JSON read options for each record, see `yyjson_ndjson_new()`.
+ @param alc The memory allocator used by the reader.
+    Pass NULL to use the libc's default allocator.
+ @return A new reader, or NULL if an error occurs.
+    It should be freed with `yyjson_ndjson_free()`.
+ */
+yyjson_api yyjson_ndjson *yyjson_ndjson_new_fp(FILE *fp,
+                                               yyjson_read_flag flg,
+                                               const yyjson_alc *alc);
+
+#endif /* !YYJSON_FREESTANDING && !YYJSON_DISABLE_FILE */
+
+/**
+ Read the next batch of records.
+
+ The documents of the previous batch are invalidated by this call.
+ A record that fails to read has a NULL document and the error information,
+ the following records are still read. If the file can't be read or memory
+ allocation fails, the last record has the error and the reader stops.
+
+ @param nd The JSON Lines reader.
+ @param recs The records to receive the result.
+ @param num The maximum number of records to read.
+ @param run The task runner to read the records in parallel,
+    see `yyjson_read_par()`. Pass NULL to read them one by one.
+    The allocator must be thread-safe if the tasks run concurrently.
+ @param run_ctx The context passed to `run`.
+ @return The number of records read, or 0 if there's no more record.
+ */
+yyjson_api size_t yyjson_ndjson_read(yyjson_ndjson *nd,
+                                     yyjson_ndjson_rec *recs, size_t num,
+                                     yyjson_par_run run, void *run_ctx);
+
+/** Free a JSON Lines reader and the documents it owns. */
+yyjson_api void yyjson_ndjson_free(yyjson_ndjson *nd);
+
+/** The event type of the SAX reader, see `yyjson_read_sax()`. */
+typedef uint8_t yyjson_sax_event;
+
+/** The beginning of an array, `val` is NULL. */
+static const yyjson_sax_event YYJSON_SAX_ARR_BEGIN  = 1;
+
+/** The end of an array, `val` is NULL. */
+static const yyjson_sax_event YYJSON_SAX_ARR_END    = 2;
+
+/** The beginning of an object, `val` is NULL. */
+static const yyjson_sax_event YYJSON_SAX_OBJ_BEGIN  = 3;
+
+/** The end of an object, `val` is NULL. */
+static const yyjson_sax_event YYJSON_SAX_OBJ_END    = 4;
+
+/** An object key, `val` is a string. */
+static const yyjson_sax_event YYJSON_SAX_KEY        = 5;
+
+/** A value that is not an array or object, `val` is the value
+    (string, number, bool, null, or raw). */
+static const yyjson_sax_event YYJSON_SAX_VAL        = 6;
+
+/**
+ A callback to receive the events of the SAX reader.
+
+ @param ctx The context passed to `yyjson_read_sax()`.
+ @param evt The event type.
+ @param val The key or value of this event, NULL for container events.
+    It can be accessed with the value API such as `yyjson_get_type()`,
+    `yyjson_get_str()` and `yyjson_get_len()`. The value and its string are
+    only valid during this call.
+ @return true to continue reading, false to stop reading.
+ */
+typedef bool (*yyjson_sax_cb)(void *ctx, yyjson_sax_event evt,
+                              const yyjson_val *val);
+
+/**
+ Read JSON and report the values to a callback, without building a document.
+
+ The input is read in the same way as `yyjson_read_opts()`, and each container,
+ key and value is reported to `cb` in document order. The only memory used for
+ the structure is a stack with one bit per nesting level.
+
+ Without `YYJSON_READ_INSITU` or `YYJSON_READ_ZERO_COPY`, the input is copied
+ into a padded buffer as `yyjson_read_opts()` does, so the memory usage is
+ proportional to the input size. Use one of these flags for large inputs:
+ `YYJSON_READ_INSITU` unescapes the strings in place and allocates nothing for
+ most documents; `YYJSON_READ_ZERO_COPY` does not modify the input and
+ unescapes each escaped string into a small scratch buffer which is reused
+ after the callback.
+
+ If `cb` returns false, reading stops and the number of bytes read so far is
+ returned, the rest of the input is not validated. Events before an error are
+ reported as they are read, so the callback may see a part of an invalid
+ document.
+
+ @param dat The JSON data (UTF-8 without BOM), null-terminator is not required.
+    If this parameter is NULL, the function will fail and return 0.
+    The `dat` will not be modified without the flag `YYJSON_READ_INSITU`, so you
+    can pass a `const char *` string and cast it to `char *` if you don't use
+    the `YYJSON_READ_INSITU` flag.
+ @param len The length of JSON data in bytes.
+    If this parameter is 0, the function will fail and return 0.
+ @param flg The JSON read options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON reader.
+    Pass NULL to use the libc's default allocator.
+ @param cb The callback to receive the events, should not be NULL.
+ @param ctx The context passed to `cb`.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return The number of bytes read, or 0 if an error occurs.
+ */
+yyjson_api size_t yyjson_read_sax(char *dat, size_t len,
+                                  yyjson_read_flag flg,
+                                  const yyjson_alc *alc,
+                                  yyjson_sax_cb cb, void *ctx,
+                                  yyjson_read_err *err);
+
 /**
  Returns the maximum memory usage to read a JSON document.
 
@@ -1181,10 +1747,17 @@ yyjson_api_inline size_t yyjson_read_max_memory_usage(size_t len,
      4. yyjson use dynamic memory with a growth factor of 1.5.
 
      The max memory size is (json_size / 2 * 16 * 1.5 + padding).
+
+     5. The structural index uses 4 bytes per token, the max token count is
+        (json_size + 2).
      */
     size_t mul = (size_t)12 + !(flg & YYJSON_READ_INSITU);
-    size_t pad = 256;
+    size_t pad = 320;
     size_t max = (size_t)(~(size_t)0);
+    if (flg & YYJSON_READ_STRUCTURAL_INDEX) {
+        mul += 4;
+        pad += 64;
+    }
     if (flg & YYJSON_READ_STOP_WHEN_DONE) len = len < 256 ? 256 : len;
     if (len >= (max - pad - mul) / mul) return 0;
     return len * mul + pad;
@@ -1217,7 +1790,18 @@ yyjson_api const char *yyjson_read_number(const char *dat,
                                           const yyjson_alc *alc,
                                           yyjson_read_err *err);
 
-/** Same as `yyjson_read_number()`. */
+/**
+ Same as `yyjson_read_number()`.
+ @warning With `YYJSON_MUT_COMPACT`, the value must be created by a document,
+    a raw number string is copied into that document.
+ */
+#if YYJSON_MUT_COMPACT
+yyjson_api const char *yyjson_mut_read_number(const char *dat,
+                                              yyjson_mut_val *val,
+                                              yyjson_read_flag flg,
+                                              const yyjson_alc *alc,
+                                              yyjson_read_err *err);
+#else
 yyjson_api_inline const char *yyjson_mut_read_number(const char *dat,
                                                      yyjson_mut_val *val,
                                                      yyjson_read_flag flg,
@@ -1225,6 +1809,7 @@ yyjson_api_inline const char *yyjson_mut_read_number(const char *dat,
                                                      yyjson_read_err *err) {
     return yyjson_read_number(dat, (yyjson_val *)val, flg, alc, err);
 }
+#endif
 
 #endif /* YYJSON_DISABLE_READER) */
 
@@ -1279,6 +1864,16 @@ static const yyjson_write_flag YYJSON_WRITE_NEWLINE_AT_END          = 1 << 7;
     uppercase. Only effective when `YYJSON_WRITE_ESCAPE_UNICODE` is also set. */
 static const yyjson_write_flag YYJSON_WRITE_LOWERCASE_HEX           = 1 << 8;
 
+/** Count the output length with a first pass (see `yyjson_write_len()`),
+    then allocate the output once with this length, instead of growing it with
+    `realloc()` while writing. The values are then written through the bounded
+    buffer of the streaming writer, which is copied to the output, the long
+    strings are written straight to the output.
+    With `yyjson_write_buf()`, the buffer is expected to be exactly sized
+    (`length + 1` bytes) and is written without allocation, see
+    `yyjson_write_buf()`. This flag is ignored by the streaming writer. */
+static const yyjson_write_flag YYJSON_WRITE_PRESIZE                 = 1 << 9;
+
 
 
 /** The highest 8 bits of `yyjson_write_flag` and real number value's `tag`
@@ -1324,7 +1919,7 @@ static const yyjson_write_code YYJSON_WRITE_ERROR_NAN_OR_INF            = 4;
 /** Failed to open a file. */
 static const yyjson_write_code YYJSON_WRITE_ERROR_FILE_OPEN             = 5;
 
-/** Failed to write a file. */
+/** Failed to write a file or a sink. */
 static const yyjson_write_code YYJSON_WRITE_ERROR_FILE_WRITE            = 6;
 
 /** Invalid unicode in string. */
@@ -1338,6 +1933,29 @@ typedef struct yyjson_write_err {
     const char *msg;
 } yyjson_write_err;
 
+/**
+ A function to receive the output of the streaming writer, see
+ `yyjson_write_stream()`.
+ @param ctx The context passed to the writer.
+ @param dat The output data, without a null-terminator. It's only valid during
+    this call.
+ @param len The length of the data in bytes, never 0.
+ @return true if successful, false to stop the writer with an error.
+ */
+typedef bool (*yyjson_write_sink)(void *ctx, const char *dat, size_t len);
+
+/**
+ A segment of the output of the vectored writer, see `yyjson_write_iov()`.
+ It has the same layout as `struct iovec` of POSIX, so an array of segments
+ can be passed to `writev()` with a cast on these platforms.
+ */
+typedef struct yyjson_iovec {
+    /** The segment data, without a null-terminator. */
+    const void *base;
+    /** The segment length in bytes. */
+    size_t len;
+} yyjson_iovec;
+
 
 
 #if !defined(YYJSON_DISABLE_WRITER) || !YYJSON_DISABLE_WRITER
@@ -1432,8 +2050,12 @@ yyjson_api bool yyjson_write_fp(FILE *fp,
 /**
  Write a document into a buffer.
 
- This function does not allocate memory, but the buffer must be larger than the
- final JSON size to allow temporary space. See `API.md` for details.
+ This function does not allocate memory. The buffer needs some room after the
+ output for the writer, otherwise the output length is counted and the output
+ is written again with the exact length, so a buffer of the output length + 1
+ bytes is enough (see `yyjson_write_len()`), unless the value is nested more
+ than 256 levels deep. With `YYJSON_WRITE_PRESIZE`, the first try is skipped.
+ See `API.md` for details.
 
  @param buf The output buffer.
     If `buf` is NULL, returns 0.
@@ -1453,6 +2075,135 @@ yyjson_api size_t yyjson_write_buf(char *buf, size_t buf_len,
                                    yyjson_write_flag flg,
                                    yyjson_write_err *err);
 
+/**
+ Write a document to a sink function, with a bounded buffer.
+
+ The output is written to the buffer and passed to `sink` each time the buffer
+ is full, so the memory used is bounded by `buf_len`, instead of the size of
+ the whole output. The buffer grows only if a single string, number or nesting
+ level doesn't fit in it. The output has no null-terminator.
+
+ If an error occurs, some output may have been passed to the sink already.
+
+ @param doc The JSON document.
+    If this document is NULL or invalid, returns 0.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used for the buffer.
+    Pass NULL to use the libc's default allocator.
+ @param buf_len The buffer size in bytes, pass 0 to use the default (64KB).
+ @param sink The function to receive the output, should not be NULL.
+ @param ctx The context passed to `sink`.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return The number of bytes written to the sink, or 0 on failure.
+ */
+yyjson_api size_t yyjson_write_stream(const yyjson_doc *doc,
+                                      yyjson_write_flag flg,
+                                      const yyjson_alc *alc,
+                                      size_t buf_len,
+                                      yyjson_write_sink sink, void *ctx,
+                                      yyjson_write_err *err);
+
+/**
+ Get the length of the JSON output of a document, without the null-terminator.
+
+ The document is not written: the length of the structure is counted from the
+ number of values and their nesting level, only the numbers and the strings
+ with escapes are formatted to be measured. The length is exact for the same
+ flags, a buffer of `length + 1` bytes can be passed to the `write_buf()`
+ functions.
+
+ @param doc The JSON document.
+    If this document is NULL or invalid, returns 0.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used for the stack of deeply nested values.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return The output length in bytes, or 0 on failure.
+ */
+yyjson_api size_t yyjson_write_len(const yyjson_doc *doc,
+                                   yyjson_write_flag flg,
+                                   const yyjson_alc *alc,
+                                   yyjson_write_err *err);
+
+/**
+ Write a document to a list of segments (vectored output).
+
+ The strings that don't need to be escaped (ASCII strings without quotes,
+ backslashes or control characters, or strings marked with
+ `YYJSON_SUBTYPE_NOESC`) and the raw values in the containers are referenced
+ in place by the segments if they have at least `ref_len` bytes, instead of
+ being copied to the output. The other output is copied to the same allocation
+ as the segments. This is useful to pass large payloads to `writev()` without
+ copying them. Strings are only referenced if no escape flag is set.
+
+ @param doc The JSON document.
+    If this document is NULL or invalid, returns NULL.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON writer.
+    Pass NULL to use the libc's default allocator.
+ @param ref_len The minimum length of the referenced strings in bytes,
+    pass 0 to use the default (4KB).
+ @param iov_num A pointer to receive the number of segments.
+ @param len A pointer to receive the total output length in bytes.
+    Pass NULL if you don't need length information.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return An array of segments, or NULL if an error occurs.
+    The output has no null-terminator. The referenced strings should be kept
+    alive while the segments are used. When it's no longer needed, it should
+    be freed with free() or alc->free().
+ */
+yyjson_api yyjson_iovec *yyjson_write_iov(const yyjson_doc *doc,
+                                          yyjson_write_flag flg,
+                                          const yyjson_alc *alc,
+                                          size_t ref_len,
+                                          size_t *iov_num,
+                                          size_t *len,
+                                          yyjson_write_err *err);
+
+/**
+ Write a document to JSON string with multiple threads.
+
+ The elements (or key-value pairs) of the root array (or object) are split
+ into parts of similar size, the parts are written in parallel with `run`,
+ then concatenated. The output and the error information are the same as
+ `yyjson_write_opts()`.
+
+ `yyjson_write_opts()` is used directly if the root value is not an array or
+ object, or the document is too small to split.
+
+ @param doc The JSON document.
+    If `doc` is NULL or has no root, returns NULL.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON writer.
+    Pass NULL to use the libc's default allocator.
+    It must be thread-safe if `run` runs the tasks concurrently.
+ @param par_num The maximum number of parts, such as the number of threads.
+ @param run The task runner.
+    Pass NULL to run the tasks one by one on the calling thread.
+ @param run_ctx The context passed to `run`.
+ @param len A pointer to receive output length in bytes (not including the
+    null-terminator). Pass NULL if you don't need length information.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return A new JSON string, or NULL if an error occurs.
+    This string is encoded as UTF-8 with a null-terminator.
+    When it's no longer needed, it should be freed with free() or alc->free().
+ */
+yyjson_api char *yyjson_write_par(const yyjson_doc *doc,
+                                  yyjson_write_flag flg,
+                                  const yyjson_alc *alc,
+                                  size_t par_num,
+                                  yyjson_par_run run, void *run_ctx,
+                                  size_t *len,
+                                  yyjson_write_err *err);
+
 /**
  Write a document to JSON string.
 
@@ -1564,8 +2315,12 @@ yyjson_api bool yyjson_mut_write_fp(FILE *fp,
 /**
  Write a document into a buffer.
 
- This function does not allocate memory, but the buffer must be larger than the
- final JSON size to allow temporary space. See `API.md` for details.
+ This function does not allocate memory. The buffer needs some room after the
+ output for the writer, otherwise the output length is counted and the output
+ is written again with the exact length, so a buffer of the output length + 1
+ bytes is enough (see `yyjson_write_len()`), unless the value is nested more
+ than 256 levels deep. With `YYJSON_WRITE_PRESIZE`, the first try is skipped.
+ See `API.md` for details.
 
  @param buf The output buffer.
     If `buf` is NULL, returns 0.
@@ -1585,6 +2340,97 @@ yyjson_api size_t yyjson_mut_write_buf(char *buf, size_t buf_len,
                                        yyjson_write_flag flg,
                                        yyjson_write_err *err);
 
+/**
+ Write a document to a sink function, with a bounded buffer.
+
+ The output is written to the buffer and passed to `sink` each time the buffer
+ is full, so the memory used is bounded by `buf_len`, instead of the size of
+ the whole output. The buffer grows only if a single string, number or nesting
+ level doesn't fit in it. The output has no null-terminator.
+
+ If an error occurs, some output may have been passed to the sink already.
+
+ @param doc The JSON document.
+    If this document is NULL or invalid, returns 0.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used for the buffer.
+    Pass NULL to use the libc's default allocator.
+ @param buf_len The buffer size in bytes, pass 0 to use the default (64KB).
+ @param sink The function to receive the output, should not be NULL.
+ @param ctx The context passed to `sink`.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return The number of bytes written to the sink, or 0 on failure.
+ */
+yyjson_api size_t yyjson_mut_write_stream(const yyjson_mut_doc *doc,
+                                          yyjson_write_flag flg,
+                                          const yyjson_alc *alc,
+                                          size_t buf_len,
+                                          yyjson_write_sink sink, void *ctx,
+                                          yyjson_write_err *err);
+
+/**
+ Get the length of the JSON output of a document, without the null-terminator.
+
+ The document is not written: the length of the structure is counted from the
+ number of values and their nesting level, only the numbers and the strings
+ with escapes are formatted to be measured. The length is exact for the same
+ flags, a buffer of `length + 1` bytes can be passed to the `write_buf()`
+ functions.
+
+ @param doc The JSON document.
+    If this document is NULL or invalid, returns 0.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used for the stack of deeply nested values.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return The output length in bytes, or 0 on failure.
+ */
+yyjson_api size_t yyjson_mut_write_len(const yyjson_mut_doc *doc,
+                                       yyjson_write_flag flg,
+                                       const yyjson_alc *alc,
+                                       yyjson_write_err *err);
+
+/**
+ Write a document to a list of segments (vectored output).
+
+ The strings that don't need to be escaped (ASCII strings without quotes,
+ backslashes or control characters, or strings marked with
+ `YYJSON_SUBTYPE_NOESC`) and the raw values in the containers are referenced
+ in place by the segments if they have at least `ref_len` bytes, instead of
+ being copied to the output. The other output is copied to the same allocation
+ as the segments. This is useful to pass large payloads to `writev()` without
+ copying them. Strings are only referenced if no escape flag is set.
+
+ @param doc The JSON document.
+    If this document is NULL or invalid, returns NULL.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON writer.
+    Pass NULL to use the libc's default allocator.
+ @param ref_len The minimum length of the referenced strings in bytes,
+    pass 0 to use the default (4KB).
+ @param iov_num A pointer to receive the number of segments.
+ @param len A pointer to receive the total output length in bytes.
+    Pass NULL if you don't need length information.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return An array of segments, or NULL if an error occurs.
+    The output has no null-terminator. The referenced strings should be kept
+    alive while the segments are used. When it's no longer needed, it should
+    be freed with free() or alc->free().
+ */
+yyjson_api yyjson_iovec *yyjson_mut_write_iov(const yyjson_mut_doc *doc,
+                                              yyjson_write_flag flg,
+                                              const yyjson_alc *alc,
+                                              size_t ref_len,
+                                              size_t *iov_num,
+                                              size_t *len,
+                                              yyjson_write_err *err);
+
 /**
  Write a document to JSON string.
 
@@ -1699,8 +2545,12 @@ yyjson_api bool yyjson_val_write_fp(FILE *fp,
 /**
  Write a value into a buffer.
 
- This function does not allocate memory, but the buffer must be larger than the
- final JSON size to allow temporary space. See `API.md` for details.
+ This function does not allocate memory. The buffer needs some room after the
+ output for the writer, otherwise the output length is counted and the output
+ is written again with the exact length, so a buffer of the output length + 1
+ bytes is enough (see `yyjson_write_len()`), unless the value is nested more
+ than 256 levels deep. With `YYJSON_WRITE_PRESIZE`, the first try is skipped.
+ See `API.md` for details.
 
  @param buf The output buffer.
     If `buf` is NULL, returns 0.
@@ -1720,6 +2570,130 @@ yyjson_api size_t yyjson_val_write_buf(char *buf, size_t buf_len,
                                        yyjson_write_flag flg,
                                        yyjson_write_err *err);
 
+/**
+ Write a value to a sink function, with a bounded buffer.
+
+ The output is written to the buffer and passed to `sink` each time the buffer
+ is full, so the memory used is bounded by `buf_len`, instead of the size of
+ the whole output. The buffer grows only if a single string, number or nesting
+ level doesn't fit in it. The output has no null-terminator.
+
+ If an error occurs, some output may have been passed to the sink already.
+
+ @param val The JSON value.
+    If this value is NULL or invalid, returns 0.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used for the buffer.
+    Pass NULL to use the libc's default allocator.
+ @param buf_len The buffer size in bytes, pass 0 to use the default (64KB).
+ @param sink The function to receive the output, should not be NULL.
+ @param ctx The context passed to `sink`.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return The number of bytes written to the sink, or 0 on failure.
+ */
+yyjson_api size_t yyjson_val_write_stream(const yyjson_val *val,
+                                          yyjson_write_flag flg,
+                                          const yyjson_alc *alc,
+                                          size_t buf_len,
+                                          yyjson_write_sink sink, void *ctx,
+                                          yyjson_write_err *err);
+
+/**
+ Get the length of the JSON output of a value, without the null-terminator.
+
+ The value is not written: the length of the structure is counted from the
+ number of values and their nesting level, only the numbers and the strings
+ with escapes are formatted to be measured. The length is exact for the same
+ flags, a buffer of `length + 1` bytes can be passed to the `write_buf()`
+ functions.
+
+ @param val The JSON value.
+    If this value is NULL or invalid, returns 0.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used for the stack of deeply nested values.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return The output length in bytes, or 0 on failure.
+ */
+yyjson_api size_t yyjson_val_write_len(const yyjson_val *val,
+                                       yyjson_write_flag flg,
+                                       const yyjson_alc *alc,
+                                       yyjson_write_err *err);
+
+/**
+ Write a value to a list of segments (vectored output).
+
+ The strings that don't need to be escaped (ASCII strings without quotes,
+ backslashes or control characters, or strings marked with
+ `YYJSON_SUBTYPE_NOESC`) and the raw values in the containers are referenced
+ in place by the segments if they have at least `ref_len` bytes, instead of
+ being copied to the output. The other output is copied to the same allocation
+ as the segments. This is useful to pass large payloads to `writev()` without
+ copying them. Strings are only referenced if no escape flag is set.
+
+ @param val The JSON value.
+    If this value is NULL or invalid, returns NULL.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON writer.
+    Pass NULL to use the libc's default allocator.
+ @param ref_len The minimum length of the referenced strings in bytes,
+    pass 0 to use the default (4KB).
+ @param iov_num A pointer to receive the number of segments.
+ @param len A pointer to receive the total output length in bytes.
+    Pass NULL if you don't need length information.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return An array of segments, or NULL if an error occurs.
+    The output has no null-terminator. The referenced strings should be kept
+    alive while the segments are used. When it's no longer needed, it should
+    be freed with free() or alc->free().
+ */
+yyjson_api yyjson_iovec *yyjson_val_write_iov(const yyjson_val *val,
+                                              yyjson_write_flag flg,
+                                              const yyjson_alc *alc,
+                                              size_t ref_len,
+                                              size_t *iov_num,
+                                              size_t *len,
+                                              yyjson_write_err *err);
+
+/**
+ Write a value to JSON string with multiple threads.
+
+ The output and the error information are the same as
+ `yyjson_val_write_opts()`, see `yyjson_write_par()` for details.
+
+ @param val The JSON root value.
+    If this parameter is NULL, the function will fail and return NULL.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON writer.
+    Pass NULL to use the libc's default allocator.
+    It must be thread-safe if `run` runs the tasks concurrently.
+ @param par_num The maximum number of parts, such as the number of threads.
+ @param run The task runner.
+    Pass NULL to run the tasks one by one on the calling thread.
+ @param run_ctx The context passed to `run`.
+ @param len A pointer to receive output length in bytes (not including the
+    null-terminator). Pass NULL if you don't need length information.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return A new JSON string, or NULL if an error occurs.
+    This string is encoded as UTF-8 with a null-terminator.
+    When it's no longer needed, it should be freed with free() or alc->free().
+ */
+yyjson_api char *yyjson_val_write_par(const yyjson_val *val,
+                                      yyjson_write_flag flg,
+                                      const yyjson_alc *alc,
+                                      size_t par_num,
+                                      yyjson_par_run run, void *run_ctx,
+                                      size_t *len,
+                                      yyjson_write_err *err);
+
 /**
  Write a value to JSON string.
 
@@ -1829,8 +2803,12 @@ yyjson_api bool yyjson_mut_val_write_fp(FILE *fp,
 /**
  Write a value into a buffer.
 
- This function does not allocate memory, but the buffer must be larger than the
- final JSON size to allow temporary space. See `API.md` for details.
+ This function does not allocate memory. The buffer needs some room after the
+ output for the writer, otherwise the output length is counted and the output
+ is written again with the exact length, so a buffer of the output length + 1
+ bytes is enough (see `yyjson_write_len()`), unless the value is nested more
+ than 256 levels deep. With `YYJSON_WRITE_PRESIZE`, the first try is skipped.
+ See `API.md` for details.
 
  @param buf The output buffer.
     If `buf` is NULL, returns 0.
@@ -1850,6 +2828,97 @@ yyjson_api size_t yyjson_mut_val_write_buf(char *buf, size_t buf_len,
                                            yyjson_write_flag flg,
                                            yyjson_write_err *err);
 
+/**
+ Write a value to a sink function, with a bounded buffer.
+
+ The output is written to the buffer and passed to `sink` each time the buffer
+ is full, so the memory used is bounded by `buf_len`, instead of the size of
+ the whole output. The buffer grows only if a single string, number or nesting
+ level doesn't fit in it. The output has no null-terminator.
+
+ If an error occurs, some output may have been passed to the sink already.
+
+ @param val The JSON value.
+    If this value is NULL or invalid, returns 0.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used for the buffer.
+    Pass NULL to use the libc's default allocator.
+ @param buf_len The buffer size in bytes, pass 0 to use the default (64KB).
+ @param sink The function to receive the output, should not be NULL.
+ @param ctx The context passed to `sink`.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return The number of bytes written to the sink, or 0 on failure.
+ */
+yyjson_api size_t yyjson_mut_val_write_stream(const yyjson_mut_val *val,
+                                              yyjson_write_flag flg,
+                                              const yyjson_alc *alc,
+                                              size_t buf_len,
+                                              yyjson_write_sink sink, void *ctx,
+                                              yyjson_write_err *err);
+
+/**
+ Get the length of the JSON output of a value, without the null-terminator.
+
+ The value is not written: the length of the structure is counted from the
+ number of values and their nesting level, only the numbers and the strings
+ with escapes are formatted to be measured. The length is exact for the same
+ flags, a buffer of `length + 1` bytes can be passed to the `write_buf()`
+ functions.
+
+ @param val The JSON value.
+    If this value is NULL or invalid, returns 0.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used for the stack of deeply nested values.
+    Pass NULL to use the libc's default allocator.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return The output length in bytes, or 0 on failure.
+ */
+yyjson_api size_t yyjson_mut_val_write_len(const yyjson_mut_val *val,
+                                           yyjson_write_flag flg,
+                                           const yyjson_alc *alc,
+                                           yyjson_write_err *err);
+
+/**
+ Write a value to a list of segments (vectored output).
+
+ The strings that don't need to be escaped (ASCII strings without quotes,
+ backslashes or control characters, or strings marked with
+ `YYJSON_SUBTYPE_NOESC`) and the raw values in the containers are referenced
+ in place by the segments if they have at least `ref_len` bytes, instead of
+ being copied to the output. The other output is copied to the same allocation
+ as the segments. This is useful to pass large payloads to `writev()` without
+ copying them. Strings are only referenced if no escape flag is set.
+
+ @param val The JSON value.
+    If this value is NULL or invalid, returns NULL.
+ @param flg The JSON write options.
+    Multiple options can be combined with `|` operator. 0 means no options.
+ @param alc The memory allocator used by JSON writer.
+    Pass NULL to use the libc's default allocator.
+ @param ref_len The minimum length of the referenced strings in bytes,
+    pass 0 to use the default (4KB).
+ @param iov_num A pointer to receive the number of segments.
+ @param len A pointer to receive the total output length in bytes.
+    Pass NULL if you don't need length information.
+ @param err A pointer to receive error information.
+    Pass NULL if you don't need error information.
+ @return An array of segments, or NULL if an error occurs.
+    The output has no null-terminator. The referenced strings should be kept
+    alive while the segments are used. When it's no longer needed, it should
+    be freed with free() or alc->free().
+ */
+yyjson_api yyjson_iovec *yyjson_mut_val_write_iov(const yyjson_mut_val *val,
+                                                  yyjson_write_flag flg,
+                                                  const yyjson_alc *alc,
+                                                  size_t ref_len,
+                                                  size_t *iov_num,
+                                                  size_t *len,
+                                                  yyjson_write_err *err);
+
 /**
  Write a value to JSON string.
 
@@ -1895,10 +2964,14 @@ yyjson_api_inline char *yyjson_mut_val_write(const yyjson_mut_val *val,
 yyjson_api char *yyjson_write_number(const yyjson_val *val, char *buf);
 
 /** Same as `yyjson_write_number()`. */
+#if YYJSON_MUT_COMPACT
+yyjson_api char *yyjson_mut_write_number(const yyjson_mut_val *val, char *buf);
+#else
 yyjson_api_inline char *yyjson_mut_write_number(const yyjson_mut_val *val,
                                                 char *buf) {
     return yyjson_write_number((const yyjson_val *)val, buf);
 }
+#endif
 
 #endif /* YYJSON_DISABLE_WRITER */
 
@@ -1922,11 +2995,50 @@ yyjson_api_inline size_t yyjson_doc_get_read_size(const yyjson_doc *doc);
     For example: the value count of `[1,2,3]` is 4. */
 yyjson_api_inline size_t yyjson_doc_get_val_count(const yyjson_doc *doc);
 
+/** Returns the memory size of this document and its string pool in bytes,
+    which is the high-water mark of the documents read into it with
+    `yyjson_read_into()`. Returns 0 if `doc` is NULL or the size is unknown. */
+yyjson_api_inline size_t yyjson_doc_get_capacity(const yyjson_doc *doc);
+
+/** Memory statistics of the values read by the JSON reader,
+    see `yyjson_doc_get_read_stats()`. */
+typedef struct yyjson_read_stats {
+    /** The number of values read, same as `yyjson_doc_get_val_count()`. */
+    size_t val_count;
+    /** The number of values allocated before reading, estimated from the
+        input length, or counted with `YYJSON_READ_PRECOUNT`. */
+    size_t val_alloc;
+    /** The number of values allocated after reading. */
+    size_t val_cap;
+    /** The number of times the values were reallocated while reading. */
+    size_t realloc_count;
+} yyjson_read_stats;
+
+/** Gets the memory statistics of the values read by the JSON reader.
+    Returns false if `doc` or `stats` is NULL, or the statistics are not
+    available, such as the documents from `yyjson_mut_doc_imut_copy()`,
+    `yyjson_read_par()` or the incremental reader. */
+yyjson_api_inline bool yyjson_doc_get_read_stats(const yyjson_doc *doc,
+                                                 yyjson_read_stats *stats);
+
 /** Release the JSON document and free the memory.
     After calling this function, the `doc` and all values from the `doc` are no
     longer available. This function will do nothing if the `doc` is NULL. */
 yyjson_api_inline void yyjson_doc_free(yyjson_doc *doc);
 
+/** Returns the memory size of the container indexes in this document,
+    in bytes. Returns 0 if `doc` is NULL or there's no index. */
+yyjson_api size_t yyjson_doc_index_size(const yyjson_doc *doc);
+
+/** Free the container indexes of this document.
+    The lookups fall back to a linear search until an index is built again.
+    This function will do nothing if the `doc` is NULL. */
+yyjson_api void yyjson_doc_index_free(yyjson_doc *doc);
+
+/** Unmap the memory-mapped file of a document read by
+    `yyjson_read_file_mmap()`, used by `yyjson_doc_free()`. */
+yyjson_api void unsafe_yyjson_doc_unmap(yyjson_doc *doc);
+
 
 
 /*==============================================================================
@@ -2170,6 +3282,41 @@ yyjson_api_inline yyjson_val *yyjson_arr_get_first(const yyjson_val *arr);
         For example: `[1,{},3]` is flat, `[1,[2],3]` is not flat.*/
 yyjson_api_inline yyjson_val *yyjson_arr_get_last(const yyjson_val *arr);
 
+/** Build an offset index for this array, the index is stored in `doc` and used
+    by `yyjson_doc_arr_get()` and `yyjson_doc_arr_slice()`.
+    Returns true if the index is built, already exists, or is not needed
+    because the array is flat.
+    Returns false if `doc/arr` is NULL, `arr` is not an array in `doc`,
+    or memory allocation fails.
+
+    The index uses 4 bytes per element, see `yyjson_doc_index_size()`.
+
+    @warning This function modifies `doc`, it's not thread-safe. */
+yyjson_api bool yyjson_arr_index_build(yyjson_doc *doc, const yyjson_val *arr);
+
+/** Build offset indexes for all the arrays in `doc` that are not flat and
+    have at least `min_size` elements.
+    Returns false if `doc` is NULL or memory allocation fails.
+
+    After this call, `yyjson_doc_arr_get()` and `yyjson_doc_arr_slice()` don't
+    modify `doc` for these arrays, so they can be used by multiple threads.
+
+    @warning This function modifies `doc`, it's not thread-safe. */
+yyjson_api bool yyjson_doc_arr_index_build(yyjson_doc *doc, size_t min_size);
+
+/** Same as `yyjson_arr_get()`, but takes a constant time if `arr` is flat or
+    has an index in `doc`, see `yyjson_arr_index_build()`.
+
+    If the array is not flat, has no index and has at least 32 elements, the
+    index is built on the first call. If `doc` is NULL, `arr` is not in `doc`,
+    or the index can't be built, this function takes a linear search time.
+
+    @warning This function may modify `doc`, it's not thread-safe unless the
+    indexes have been built, or the arrays are flat or have fewer than 32
+    elements. */
+yyjson_api yyjson_val *yyjson_doc_arr_get(yyjson_doc *doc,
+                                          const yyjson_val *arr, size_t idx);
+
 
 
 /*==============================================================================
@@ -2219,6 +3366,28 @@ yyjson_api_inline bool yyjson_arr_iter_init(const yyjson_val *arr,
  */
 yyjson_api_inline yyjson_arr_iter yyjson_arr_iter_with(const yyjson_val *arr);
 
+/**
+ Initialize an iterator for the elements of an array in `[start, end)`.
+
+ The first element is found with `yyjson_doc_arr_get()`, so it takes a constant
+ time if `arr` is flat or has an index in `doc`.
+
+ @param doc The document of the array, may be NULL.
+ @param arr The array to be iterated over.
+    If this parameter is NULL or not an array, `iter` will be set to empty.
+ @param start The index of the first element.
+ @param end The index after the last element, it's clamped to the array size.
+    If `start >= end`, `iter` will be set to empty.
+ @param iter The iterator to be initialized.
+    If this parameter is NULL, the function will fail and return false.
+ @return true if the `iter` has been successfully initialized.
+
+ @warning This function may modify `doc`, see `yyjson_doc_arr_get()`.
+ */
+yyjson_api bool yyjson_doc_arr_slice(yyjson_doc *doc, const yyjson_val *arr,
+                                     size_t start, size_t end,
+                                     yyjson_arr_iter *iter);
+
 /**
  Returns whether the iteration has more elements.
  If `iter` is NULL, returns false.
@@ -2283,6 +3452,40 @@ yyjson_api_inline yyjson_val *yyjson_obj_get(const yyjson_val *obj,
 yyjson_api_inline yyjson_val *yyjson_obj_getn(const yyjson_val *obj,
                                               const char *key, size_t key_len);
 
+/** Build a hash index for this object, the index is stored in `doc` and used
+    by `yyjson_doc_obj_get()` and `yyjson_doc_obj_getn()`.
+    Returns true if the index is built or already exists.
+    Returns false if `doc/obj` is NULL, `obj` is not an object in `doc`,
+    or memory allocation fails.
+
+    The index uses about 16 bytes per key-value pair, see
+    `yyjson_doc_index_size()`. The `yyjson_val` layout is not changed.
+
+    @warning This function modifies `doc`, it's not thread-safe. */
+yyjson_api bool yyjson_obj_index_build(yyjson_doc *doc, const yyjson_val *obj);
+
+/** Same as `yyjson_obj_get()`, but takes a constant time if `obj` has an index
+    in `doc`, see `yyjson_obj_index_build()`.
+
+    If the object has no index and has at least 32 key-value pairs, the index is
+    built on the first lookup. If `doc` is NULL, `obj` is not in `doc`, or the
+    index can't be built, this function takes a linear search time.
+
+    @warning This function may modify `doc`, it's not thread-safe unless the
+    indexes have been built with `yyjson_obj_index_build()`, or the objects have
+    fewer than 32 key-value pairs. */
+yyjson_api_inline yyjson_val *yyjson_doc_obj_get(yyjson_doc *doc,
+                                                 const yyjson_val *obj,
+                                                 const char *key);
+
+/** Same as `yyjson_obj_getn()`, but takes a constant time if `obj` has an index
+    in `doc`, see `yyjson_doc_obj_get()`.
+
+    @warning This function may modify `doc`, see `yyjson_doc_obj_get()`. */
+yyjson_api yyjson_val *yyjson_doc_obj_getn(yyjson_doc *doc,
+                                           const yyjson_val *obj,
+                                           const char *key, size_t key_len);
+
 
 
 /*==============================================================================
@@ -2473,6 +3676,15 @@ yyjson_api bool yyjson_mut_doc_set_str_pool_size(yyjson_mut_doc *doc,
 yyjson_api bool yyjson_mut_doc_set_val_pool_size(yyjson_mut_doc *doc,
                                                  size_t count);
 
+/** Returns the memory size of the container indexes in this document,
+    in bytes. Returns 0 if `doc` is NULL or there's no index. */
+yyjson_api size_t yyjson_mut_doc_index_size(const yyjson_mut_doc *doc);
+
+/** Free the container indexes of this document.
+    The indexed containers fall back to a linear search until an index is built
+    again. This function will do nothing if the `doc` is NULL. */
+yyjson_api void yyjson_mut_doc_index_free(yyjson_mut_doc *doc);
+
 /** Release the JSON document and free the memory.
     After calling this function, the `doc` and all values from the `doc` are no
     longer available. This function will do nothing if the `doc` is NULL.  */
@@ -2876,7 +4088,8 @@ yyjson_api_inline size_t yyjson_mut_arr_size(const yyjson_mut_val *arr);
 
 /** Returns the element at the specified position in this array.
     Returns NULL if array is NULL/empty or the index is out of bounds.
-    @warning This function takes a linear search time. */
+    @warning This function takes a linear search time, or a constant time if
+    the array has an index, see `yyjson_mut_arr_index_build()`. */
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_get(const yyjson_mut_val *arr,
                                                      size_t idx);
 
@@ -2890,6 +4103,28 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_get_first(
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_get_last(
     const yyjson_mut_val *arr);
 
+/** Build an offset index for this array, the index is stored in `doc`.
+    Returns true if the index is built or the array already has an index.
+    Returns false if `doc/arr` is NULL, `arr` is not an array,
+    or memory allocation fails.
+
+    With an index, `yyjson_mut_arr_get()` takes a constant time, and the
+    insertion and removal functions find the position in a constant time,
+    then move the following pointers in the index. The index holds a pointer
+    per element, see `yyjson_mut_doc_index_size()`.
+
+    The array is still a linked list and can be used with all functions. The
+    modification functions keep the index up to date. `yyjson_mut_arr_rotate()`,
+    `yyjson_mut_arr_remove_range()`, the iterator and the JSON Pointer context
+    functions drop the index, call this function again to rebuild it.
+
+    The `arr` should be created by `doc`. Its elements should not be linked
+    or unlinked by other ways, such as `yyjson_mut_set_xxx()` on a shared value.
+
+    @warning This function modifies `doc`, it's not thread-safe. */
+yyjson_api bool yyjson_mut_arr_index_build(yyjson_mut_doc *doc,
+                                           yyjson_mut_val *arr);
+
 
 
 /*==============================================================================
@@ -2990,7 +4225,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_iter_remove(
         (val) = yyjson_mut_arr_get_first(arr); \
         (idx) < (max); \
         (idx)++, \
-        (val) = (val)->next)
+        (val) = unsafe_yyjson_mut_get_next(val))
 
 
 
@@ -3688,7 +4923,8 @@ yyjson_api_inline size_t yyjson_mut_obj_size(const yyjson_mut_val *obj);
 
     The `key` should be a null-terminated UTF-8 string.
 
-    @warning This function takes a linear search time. */
+    @warning This function takes a linear search time, or a constant time if
+    the object has an index, see `yyjson_mut_obj_index_build()`. */
 yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_get(const yyjson_mut_val *obj,
                                                      const char *key);
 
@@ -3699,11 +4935,35 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_get(const yyjson_mut_val *obj,
     The `key` should be a UTF-8 string, null-terminator is not required.
     The `key_len` should be the length of the key, in bytes.
 
-    @warning This function takes a linear search time. */
+    @warning This function takes a linear search time, or a constant time if
+    the object has an index, see `yyjson_mut_obj_index_build()`. */
 yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_getn(const yyjson_mut_val *obj,
                                                       const char *key,
                                                       size_t key_len);
 
+/** Build a hash index for this object, the index is stored in `doc`.
+    Returns true if the index is built or the object already has an index.
+    Returns false if `doc/obj` is NULL, `obj` is not an object,
+    or memory allocation fails.
+
+    With an index, `yyjson_mut_obj_get()` takes a constant time, and so do
+    `yyjson_mut_obj_put()` and the removal functions by key if the object has
+    no duplicate keys. The index uses 48 to 96 bytes per key-value pair on
+    64-bit platforms, see `yyjson_mut_doc_index_size()`.
+
+    The object is still a linked list and can be used with all functions. The
+    modification functions keep the index up to date. `yyjson_mut_obj_insert()`,
+    `yyjson_mut_obj_rotate()`, `yyjson_mut_obj_clear()`,
+    `yyjson_mut_obj_rename_key()`, the iterator and the JSON Pointer context
+    functions drop the index, call this function again to rebuild it.
+
+    The `obj` should be created by `doc`. Its keys should not be changed by
+    other ways, such as `yyjson_mut_set_str()` on a key.
+
+    @warning This function modifies `doc`, it's not thread-safe. */
+yyjson_api bool yyjson_mut_obj_index_build(yyjson_mut_doc *doc,
+                                           yyjson_mut_val *obj);
+
 
 
 /*==============================================================================
@@ -3859,12 +5119,13 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_iter_getn(
 #define yyjson_mut_obj_foreach(obj, idx, max, key, val) \
     for ((idx) = 0, \
         (max) = yyjson_mut_obj_size(obj), \
-        (key) = (max) ? ((yyjson_mut_val *)(obj)->uni.ptr)->next->next : NULL, \
-        (val) = (key) ? (key)->next : NULL; \
+        (key) = (max) ? unsafe_yyjson_mut_get_next(unsafe_yyjson_mut_get_next( \
+            unsafe_yyjson_mut_get_last(obj))) : NULL, \
+        (val) = (key) ? unsafe_yyjson_mut_get_next(key) : NULL; \
         (idx) < (max); \
         (idx)++, \
-        (key) = (val)->next, \
-        (val) = (key)->next)
+        (key) = unsafe_yyjson_mut_get_next(val), \
+        (val) = unsafe_yyjson_mut_get_next(key))
 
 
 
@@ -4970,6 +6231,30 @@ struct yyjson_val {
     yyjson_val_uni uni; /**< payload */
 };
 
+/**
+ The extra state of an immutable document, used by the library internally.
+ The members should be accessed with the API functions, and may be changed in
+ later versions.
+ */
+typedef struct yyjson_doc_ext {
+    /** The indexes of containers (nullable), see `yyjson_obj_index_build()`
+        and `yyjson_arr_index_build()`. */
+    yyjson_doc_idx *idx;
+    /** The memory-mapped file which the strings reference (nullable),
+        see `yyjson_read_file_mmap()`. */
+    void *map;
+    /** The length of the mapping, 0 if not mapped. */
+    size_t map_len;
+    /** The size of the memory of this document and its values in bytes,
+        0 if unknown, see `yyjson_read_into()`. */
+    size_t doc_cap;
+    /** The size of `str_pool` in bytes, 0 if unknown. */
+    size_t str_cap;
+    /** The statistics of the reader, `val_alloc` is 0 if unknown,
+        see `yyjson_doc_get_read_stats()`. */
+    yyjson_read_stats stats;
+} yyjson_doc_ext;
+
 struct yyjson_doc {
     /** Root value of the document (nonnull). */
     yyjson_val *root;
@@ -4981,6 +6266,8 @@ struct yyjson_doc {
     size_t val_read;
     /** The string pool used by JSON values (nullable). */
     char *str_pool;
+    /** The extra state of the document, zero-initialized on creation. */
+    yyjson_doc_ext ext;
 };
 
 
@@ -5332,10 +6619,24 @@ yyjson_api_inline size_t yyjson_doc_get_val_count(const yyjson_doc *doc) {
     return doc ? doc->val_read : 0;
 }
 
+yyjson_api_inline size_t yyjson_doc_get_capacity(const yyjson_doc *doc) {
+    return doc ? doc->ext.doc_cap + doc->ext.str_cap : 0;
+}
+
+yyjson_api_inline bool yyjson_doc_get_read_stats(const yyjson_doc *doc,
+                                                 yyjson_read_stats *stats) {
+    if (!doc || !stats || !doc->ext.stats.val_alloc) return false;
+    *stats = doc->ext.stats;
+    stats->val_count = doc->val_read;
+    return true;
+}
+
 yyjson_api_inline void yyjson_doc_free(yyjson_doc *doc) {
     if (doc) {
         yyjson_alc alc = doc->alc;
+        if (doc->ext.idx) yyjson_doc_index_free(doc);
         memset(&doc->alc, 0, sizeof(alc));
+        if (doc->ext.map_len) unsafe_yyjson_doc_unmap(doc);
         if (doc->str_pool) alc.free(alc.ctx, doc->str_pool);
         alc.free(alc.ctx, doc);
     }
@@ -5709,6 +7010,12 @@ yyjson_api_inline yyjson_val *yyjson_obj_getn(const yyjson_val *obj,
     return NULL;
 }
 
+yyjson_api_inline yyjson_val *yyjson_doc_obj_get(yyjson_doc *doc,
+                                                 const yyjson_val *obj,
+                                                 const char *key) {
+    return yyjson_doc_obj_getn(doc, obj, key, key ? strlen(key) : 0);
+}
+
 
 
 /*==============================================================================
@@ -5788,13 +7095,45 @@ yyjson_api_inline yyjson_val *yyjson_obj_iter_getn(yyjson_obj_iter *iter,
 
 
 
-/*==============================================================================
- * MARK: - Mutable JSON Structure (Implementation)
- *============================================================================*/
+/*==============================================================================
+ * MARK: - Mutable JSON Structure (Implementation)
+ *============================================================================*/
+
+#if YYJSON_MUT_COMPACT
+
+/**
+ Mutable JSON value in compact layout (`YYJSON_MUT_COMPACT`), 16 bytes.
+ The 'tag' field holds, from the lowest bit:
+    - type and subtype (8 bits)
+    - output format of real number, see `YYJSON_WRITE_FP_FLAG_BITS` (5 bits)
+    - slot offset of this value in its pool chunk (19 bits)
+    - index of the next value in circular linked list (32 bits)
+ The 'uni' field holds the number, or for string and container, the length
+ (high 32 bits) and the string offset or the index of the last child value
+ (low 32 bits) in the document's memory pools.
+ */
+struct yyjson_mut_val {
+    uint64_t tag; /**< type, subtype, chunk offset and next index */
+    yyjson_val_uni uni; /**< payload */
+};
+
+/** The bit offset of real number's output format in compact value's tag. */
+#define YYJSON_MUT_FP_BIT       8
+/** The bit offset and mask of chunk offset in compact value's tag. */
+#define YYJSON_MUT_OFS_BIT      13
+#define YYJSON_MUT_OFS_MASK     0x7FFFF
+/** The number of values in a page of value index table (log2). */
+#define YYJSON_MUT_VAL_PAGE_BIT 8
+/** The number of bytes in a page of string offset table (log2). */
+#define YYJSON_MUT_STR_PAGE_BIT 12
+
+#else
 
 /**
  Mutable JSON value, 24 bytes.
- The 'tag' and 'uni' fields are the same as immutable value.
+ The 'tag' and 'uni' fields are the same as immutable value, except that an
+ indexed container has `YYJSON_MUT_IDX_FLAG` set, and its 'uni' field points to
+ the index table, which holds the last child value.
  The 'next' field links all elements inside the container to be a cycle.
  */
 struct yyjson_mut_val {
@@ -5803,6 +7142,12 @@ struct yyjson_mut_val {
     yyjson_mut_val *next; /**< the next value in circular linked list */
 };
 
+#endif
+
+/** The flag of an indexed container in mutable value's tag, it takes one of
+    the reserved bits, see `yyjson_mut_arr_index_build()`. */
+#define YYJSON_MUT_IDX_FLAG     ((uint8_t)0x20)
+
 /**
  A memory chunk in string memory pool.
  */
@@ -5821,16 +7166,27 @@ typedef struct yyjson_str_pool {
     size_t chunk_size; /* chunk size in bytes while creating new chunk */
     size_t chunk_size_max; /* maximum chunk size in bytes */
     yyjson_str_chunk *chunks; /* a linked list of chunks, nullable */
+#if YYJSON_MUT_COMPACT
+    char **pages; /* page table of string offsets, nullable */
+    size_t page_num; /* number of pages in use */
+    size_t page_cap; /* capacity of the page table */
+    size_t end_ofs; /* string offset of `end` */
+#endif
 } yyjson_str_pool;
 
 /**
  A memory chunk in value memory pool.
- `sizeof(yyjson_val_chunk)` should not be larger than `sizeof(yyjson_mut_val)`.
+ The chunk header takes the first value slots of the chunk, it takes one slot
+ unless `YYJSON_MUT_COMPACT` is enabled on 64-bit platforms.
  */
 typedef struct yyjson_val_chunk {
     struct yyjson_val_chunk *next; /* next chunk linked list */
     size_t chunk_size; /* chunk size in bytes */
-    /* char pad[sizeof(yyjson_mut_val) - sizeof(yyjson_val_chunk)]; padding */
+#if YYJSON_MUT_COMPACT
+    yyjson_mut_doc *doc; /* the document of this chunk */
+    uint32_t base; /* index of the first slot (the header) in this chunk */
+#endif
+    /* char pad[]; padding to a multiple of sizeof(yyjson_mut_val) */
     /* yyjson_mut_val vals[]; flexible array member */
 } yyjson_val_chunk;
 
@@ -5843,6 +7199,12 @@ typedef struct yyjson_val_pool {
     size_t chunk_size; /* chunk size in bytes while creating new chunk */
     size_t chunk_size_max; /* maximum chunk size in bytes */
     yyjson_val_chunk *chunks; /* a linked list of chunks, nullable */
+#if YYJSON_MUT_COMPACT
+    yyjson_mut_val **pages; /* page table of value indexes, nullable */
+    size_t page_num; /* number of pages in use */
+    size_t page_cap; /* capacity of the page table */
+    yyjson_mut_doc *doc; /* the document of this pool */
+#endif
 } yyjson_val_pool;
 
 struct yyjson_mut_doc {
@@ -5850,6 +7212,9 @@ struct yyjson_mut_doc {
     yyjson_alc alc; /**< a valid allocator, nonnull */
     yyjson_str_pool str_pool; /**< string memory pool */
     yyjson_val_pool val_pool; /**< value memory pool */
+    /** container indexes, nullable, see `yyjson_mut_arr_index_build()`
+        and `yyjson_mut_obj_index_build()`. */
+    yyjson_mut_doc_idx *idx;
 };
 
 /* Ensures the capacity to at least equal to the specified byte length. */
@@ -5903,9 +7268,406 @@ yyjson_api_inline yyjson_mut_val *unsafe_yyjson_mut_val(yyjson_mut_doc *doc,
     }
     val = pool->cur;
     pool->cur += count;
+#if YYJSON_MUT_COMPACT
+    {
+        /* record the offset in chunk, so the value can find its document */
+        uint64_t ofs = (uint64_t)(val - (yyjson_mut_val *)(void *)pool->chunks);
+        size_t i;
+        for (i = 0; i < count; i++) {
+            val[i].tag = (ofs + i) << YYJSON_MUT_OFS_BIT;
+        }
+    }
+#endif
     return val;
 }
 
+/* Returns the number of values to allocate at once, for the `count` values
+   left of a container created by one call. With `YYJSON_MUT_COMPACT`, the
+   values of one allocation should fit in one pool chunk, so the values of a
+   large container are allocated in runs: the rest of the current chunk, or at
+   most 64K values in a new chunk. */
+yyjson_api_inline size_t unsafe_yyjson_mut_val_run(yyjson_mut_doc *doc,
+                                                   size_t count) {
+#if YYJSON_MUT_COMPACT
+    size_t num = (size_t)(doc->val_pool.end - doc->val_pool.cur);
+    if (num == 0) num = (size_t)1 << 16;
+    return num < count ? num : count;
+#else
+    (void)doc;
+    return count;
+#endif
+}
+
+/* Returns the value after `val` in the current run, `run` is the number of
+   values left in the run, including `val`. A new run is allocated for the
+   `count` values left if the current run is used up. */
+yyjson_api_inline yyjson_mut_val *unsafe_yyjson_mut_val_next(
+    yyjson_mut_doc *doc, yyjson_mut_val *val, size_t *run, size_t count) {
+    if (yyjson_likely(--*run > 0)) return val + 1;
+    *run = unsafe_yyjson_mut_val_run(doc, count);
+    return unsafe_yyjson_mut_val(doc, *run);
+}
+
+
+
+/*==============================================================================
+ * MARK: - Mutable JSON Value Accessor (Implementation)
+ *============================================================================*/
+
+/*
+ These functions access the links, lengths and strings of mutable values,
+ which are stored differently when `YYJSON_MUT_COMPACT` is enabled.
+ In compact layout, a value finds its document through the header of its pool
+ chunk, and resolves an index with the chunk (fast path) or the page table.
+ */
+
+#if YYJSON_MUT_COMPACT
+
+/* Returns the pool chunk of a value. */
+yyjson_api_inline yyjson_val_chunk *unsafe_yyjson_mut_chunk(
+    const yyjson_mut_val *val) {
+    size_t ofs = (size_t)(val->tag >> YYJSON_MUT_OFS_BIT) & YYJSON_MUT_OFS_MASK;
+    yyjson_mut_val *ptr = yyjson_constcast(yyjson_mut_val *)val;
+    return (yyjson_val_chunk *)(void *)(ptr - ofs);
+}
+
+/* Returns the index of a value in its document. */
+yyjson_api_inline uint32_t unsafe_yyjson_mut_idx(const yyjson_mut_val *val) {
+    uint32_t ofs = (uint32_t)(val->tag >> YYJSON_MUT_OFS_BIT);
+    return unsafe_yyjson_mut_chunk(val)->base + (ofs & YYJSON_MUT_OFS_MASK);
+}
+
+/* Returns the value at the index, in the document of another value. */
+yyjson_api_inline yyjson_mut_val *unsafe_yyjson_mut_at(
+    const yyjson_mut_val *val, uint32_t idx) {
+    yyjson_val_chunk *chunk = unsafe_yyjson_mut_chunk(val);
+    uint32_t ofs = idx - chunk->base;
+    if (yyjson_likely(ofs < chunk->chunk_size / sizeof(yyjson_mut_val))) {
+        return (yyjson_mut_val *)(void *)chunk + ofs;
+    } else {
+        yyjson_mut_val **pages = chunk->doc->val_pool.pages;
+        uint32_t mask = ((uint32_t)1 << YYJSON_MUT_VAL_PAGE_BIT) - 1;
+        return pages[idx >> YYJSON_MUT_VAL_PAGE_BIT] + (idx & mask);
+    }
+}
+
+/* Checks that two values are in the same document in debug builds, as the
+   index of a value is only valid in the document that created it. */
+#if !YYJSON_FREESTANDING
+#define unsafe_yyjson_mut_assert_doc(a, b) \
+    assert(unsafe_yyjson_mut_chunk(a)->doc == unsafe_yyjson_mut_chunk(b)->doc)
+#else
+#define unsafe_yyjson_mut_assert_doc(a, b) ((void)0)
+#endif
+
+#endif
+
+/* Returns the next value in circular linked list. */
+yyjson_api_inline yyjson_mut_val *unsafe_yyjson_mut_get_next(
+    const yyjson_mut_val *val) {
+#if YYJSON_MUT_COMPACT
+    return unsafe_yyjson_mut_at(val, (uint32_t)(val->tag >> 32));
+#else
+    return val->next;
+#endif
+}
+
+/* Sets the next value in circular linked list. */
+yyjson_api_inline void unsafe_yyjson_mut_set_next(yyjson_mut_val *val,
+                                                  yyjson_mut_val *next) {
+#if YYJSON_MUT_COMPACT
+    uint64_t idx = unsafe_yyjson_mut_idx(next);
+    unsafe_yyjson_mut_assert_doc(val, next);
+    val->tag = (val->tag & (uint64_t)0xFFFFFFFF) | (idx << 32);
+#else
+    val->next = next;
+#endif
+}
+
+/* Returns whether the container has an index. */
+yyjson_api_inline bool unsafe_yyjson_mut_is_indexed(const yyjson_mut_val *ctn) {
+    return (ctn->tag & YYJSON_MUT_IDX_FLAG) != 0;
+}
+
+/* Returns the last child value of a non-empty container. */
+yyjson_api_inline yyjson_mut_val *unsafe_yyjson_mut_get_last(
+    const yyjson_mut_val *ctn) {
+#if YYJSON_MUT_COMPACT
+    return unsafe_yyjson_mut_at(ctn, (uint32_t)ctn->uni.u64);
+#else
+    /* the index table starts with the last child value */
+    if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(ctn))) {
+        return *(yyjson_mut_val **)ctn->uni.ptr;
+    }
+    return (yyjson_mut_val *)ctn->uni.ptr;
+#endif
+}
+
+/* Sets the last child value of a container. */
+yyjson_api_inline void unsafe_yyjson_mut_set_last(yyjson_mut_val *ctn,
+                                                  yyjson_mut_val *last) {
+#if YYJSON_MUT_COMPACT
+    uint64_t idx = unsafe_yyjson_mut_idx(last);
+    unsafe_yyjson_mut_assert_doc(ctn, last);
+    ctn->uni.u64 = (ctn->uni.u64 & ~(uint64_t)0xFFFFFFFF) | idx;
+#else
+    if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(ctn))) {
+        *(yyjson_mut_val **)ctn->uni.ptr = last;
+        return;
+    }
+    ctn->uni.ptr = (void *)last;
+#endif
+}
+
+/* Drops the index of a container, the index table is kept in the document
+   for reuse. This should be called before the links are changed by a function
+   that doesn't keep the index up to date. */
+yyjson_api_inline void unsafe_yyjson_mut_idx_drop(yyjson_mut_val *ctn) {
+#if !YYJSON_MUT_COMPACT
+    ctn->uni.ptr = (void *)unsafe_yyjson_mut_get_last(ctn);
+#endif
+    ctn->tag &= ~(uint64_t)YYJSON_MUT_IDX_FLAG;
+}
+
+/* Indexed implementations of the container functions, they are called by the
+   functions below if the container has an index. The parameters should be
+   valid, the index is dropped if it can't be updated. */
+yyjson_api yyjson_mut_val *unsafe_yyjson_mut_arr_idx_get(
+    const yyjson_mut_val *arr, size_t idx);
+
+yyjson_api bool unsafe_yyjson_mut_arr_idx_insert(yyjson_mut_val *arr,
+                                                 yyjson_mut_val *val,
+                                                 size_t idx);
+
+yyjson_api yyjson_mut_val *unsafe_yyjson_mut_arr_idx_replace(
+    yyjson_mut_val *arr, size_t idx, yyjson_mut_val *val);
+
+yyjson_api yyjson_mut_val *unsafe_yyjson_mut_arr_idx_remove(
+    yyjson_mut_val *arr, size_t idx);
+
+yyjson_api yyjson_mut_val *unsafe_yyjson_mut_obj_idx_getn(
+    const yyjson_mut_val *obj, const char *key, size_t key_len);
+
+/* Adds the key to the index before it's linked as the last key. */
+yyjson_api void unsafe_yyjson_mut_obj_idx_add(yyjson_mut_val *obj,
+                                              yyjson_mut_val *key);
+
+yyjson_api bool unsafe_yyjson_mut_obj_idx_put(yyjson_mut_val *obj,
+                                              yyjson_mut_val *key,
+                                              yyjson_mut_val *val);
+
+yyjson_api yyjson_mut_val *unsafe_yyjson_mut_obj_idx_remove(
+    yyjson_mut_val *obj, const char *key, size_t key_len);
+
+/* Returns the length of a string or container, or 0 for other types. */
+yyjson_api_inline size_t unsafe_yyjson_mut_get_len(const yyjson_mut_val *val) {
+#if YYJSON_MUT_COMPACT
+    /* raw, string, array and object have length: 0b11100010 */
+    uint8_t type = (uint8_t)(val->tag & YYJSON_TYPE_MASK);
+    if ((0xE2 >> type) & 1) return (size_t)(val->uni.u64 >> 32);
+    return 0;
+#else
+    return unsafe_yyjson_get_len(val);
+#endif
+}
+
+/* Sets the length of a string or container. */
+yyjson_api_inline void unsafe_yyjson_mut_set_len(yyjson_mut_val *val,
+                                                 size_t len) {
+#if YYJSON_MUT_COMPACT
+    val->uni.u64 = ((uint64_t)len << 32) | (uint32_t)val->uni.u64;
+#else
+    unsafe_yyjson_set_len(val, len);
+#endif
+}
+
+/* Sets the type, subtype and length, this keeps the link to the next value.
+   The payload of string and container should be set after this. */
+yyjson_api_inline void unsafe_yyjson_mut_set_tag(yyjson_mut_val *val,
+                                                 yyjson_type type,
+                                                 yyjson_subtype subtype,
+                                                 size_t len) {
+#if YYJSON_MUT_COMPACT
+    uint64_t tag = val->tag & ~(((uint64_t)1 << YYJSON_MUT_OFS_BIT) - 1);
+    val->tag = tag | (uint64_t)(type | subtype);
+    if ((0xE2 >> type) & 1) val->uni.u64 = (uint64_t)len << 32;
+#else
+    unsafe_yyjson_set_tag(val, type, subtype, len);
+#endif
+}
+
+/* Copies the type, length and payload of `src` to `dst` of the same document,
+   this keeps the link of `dst` to the next value. */
+yyjson_api_inline void unsafe_yyjson_mut_set_val(yyjson_mut_val *dst,
+                                                 const yyjson_mut_val *src) {
+    /* the index belongs to `src`, it's not copied */
+    uint64_t flag = (uint64_t)YYJSON_MUT_IDX_FLAG;
+#if YYJSON_MUT_COMPACT
+    uint64_t mask = ((uint64_t)1 << YYJSON_MUT_OFS_BIT) - 1;
+    dst->tag = (dst->tag & ~mask) | (src->tag & mask & ~flag);
+    dst->uni.u64 = src->uni.u64;
+#else
+    dst->tag = src->tag & ~flag;
+    dst->uni.u64 = src->uni.u64;
+    if (yyjson_unlikely(src->tag & flag)) {
+        dst->uni.ptr = (void *)unsafe_yyjson_mut_get_last(src);
+    }
+#endif
+}
+
+/* Returns the string of a string or raw value. */
+yyjson_api_inline const char *unsafe_yyjson_mut_get_str(
+    const yyjson_mut_val *val) {
+#if YYJSON_MUT_COMPACT
+    const yyjson_str_pool *pool = &unsafe_yyjson_mut_chunk(val)->doc->str_pool;
+    uint32_t ofs = (uint32_t)val->uni.u64;
+    uint32_t mask = ((uint32_t)1 << YYJSON_MUT_STR_PAGE_BIT) - 1;
+    return pool->pages[ofs >> YYJSON_MUT_STR_PAGE_BIT] + (ofs & mask);
+#else
+    return val->uni.str;
+#endif
+}
+
+/* Sets a string or raw value, returns false on allocation failure.
+   The string is referenced, or copied to the document in compact layout,
+   unless it was just allocated from the document's string pool. */
+yyjson_api_inline bool unsafe_yyjson_mut_set_strx(yyjson_mut_val *val,
+                                                  yyjson_type type,
+                                                  yyjson_subtype subtype,
+                                                  const char *str,
+                                                  size_t len) {
+#if YYJSON_MUT_COMPACT
+    yyjson_mut_doc *doc = unsafe_yyjson_mut_chunk(val)->doc;
+    yyjson_str_pool *pool = &doc->str_pool;
+    const char *beg = pool->chunks ? (const char *)(pool->chunks + 1) : NULL;
+    if (yyjson_unlikely((uint64_t)len > 0xFFFFFFFF)) return false;
+    if (!(beg && beg <= str && str < pool->cur &&
+          len < (size_t)(pool->cur - str))) {
+        char *mem = unsafe_yyjson_mut_strncpy(doc, str, len);
+        if (yyjson_unlikely(!mem)) return false;
+        str = mem;
+    }
+    unsafe_yyjson_mut_set_tag(val, type, subtype, len);
+    val->uni.u64 |= (uint64_t)(pool->end_ofs - (size_t)(pool->end - str));
+#else
+    unsafe_yyjson_set_tag(val, type, subtype, len);
+    val->uni.str = str;
+#endif
+    return true;
+}
+
+yyjson_api_inline bool unsafe_yyjson_mut_equals_strn(const yyjson_mut_val *val,
+                                                     const char *str,
+                                                     size_t len) {
+    return unsafe_yyjson_mut_get_len(val) == len &&
+           memcmp(unsafe_yyjson_mut_get_str(val), str, len) == 0;
+}
+
+/* Returns the output format of a real number, see `YYJSON_WRITE_FP_TO_xxx`. */
+yyjson_api_inline uint32_t unsafe_yyjson_mut_get_fp_fmt(
+    const yyjson_mut_val *val) {
+#if YYJSON_MUT_COMPACT
+    return (uint32_t)((val->tag >> YYJSON_MUT_FP_BIT) & 0x1F) << (32 - 5);
+#else
+    return (uint32_t)(val->tag >> 32);
+#endif
+}
+
+yyjson_api_inline void unsafe_yyjson_mut_set_fp_to_fixed(yyjson_mut_val *val,
+                                                         int prec) {
+#if YYJSON_MUT_COMPACT
+    uint64_t mask = (uint64_t)(YYJSON_WRITE_FP_TO_FIXED(15) >> (32 - 5));
+    uint64_t fmt = (uint64_t)(YYJSON_WRITE_FP_TO_FIXED(prec) >> (32 - 5));
+    val->tag &= ~(mask << YYJSON_MUT_FP_BIT);
+    val->tag |= fmt << YYJSON_MUT_FP_BIT;
+#else
+    unsafe_yyjson_set_fp_to_fixed(val, prec);
+#endif
+}
+
+yyjson_api_inline void unsafe_yyjson_mut_set_fp_to_float(yyjson_mut_val *val,
+                                                         bool flt) {
+#if YYJSON_MUT_COMPACT
+    uint64_t flag = (uint64_t)(YYJSON_WRITE_FP_TO_FLOAT >> (32 - 5));
+    if (flt) val->tag |= flag << YYJSON_MUT_FP_BIT;
+    else val->tag &= ~(flag << YYJSON_MUT_FP_BIT);
+#else
+    unsafe_yyjson_set_fp_to_float(val, flt);
+#endif
+}
+
+yyjson_api_inline bool unsafe_yyjson_mut_set_raw(yyjson_mut_val *val,
+                                                 const char *raw, size_t len) {
+    return unsafe_yyjson_mut_set_strx(val, YYJSON_TYPE_RAW,
+                                      YYJSON_SUBTYPE_NONE, raw, len);
+}
+
+yyjson_api_inline void unsafe_yyjson_mut_set_null(yyjson_mut_val *val) {
+    unsafe_yyjson_mut_set_tag(val, YYJSON_TYPE_NULL, YYJSON_SUBTYPE_NONE, 0);
+}
+
+yyjson_api_inline void unsafe_yyjson_mut_set_bool(yyjson_mut_val *val,
+                                                  bool num) {
+    yyjson_subtype subtype = num ? YYJSON_SUBTYPE_TRUE : YYJSON_SUBTYPE_FALSE;
+    unsafe_yyjson_mut_set_tag(val, YYJSON_TYPE_BOOL, subtype, 0);
+}
+
+yyjson_api_inline void unsafe_yyjson_mut_set_uint(yyjson_mut_val *val,
+                                                  uint64_t num) {
+    unsafe_yyjson_mut_set_tag(val, YYJSON_TYPE_NUM, YYJSON_SUBTYPE_UINT, 0);
+    val->uni.u64 = num;
+}
+
+yyjson_api_inline void unsafe_yyjson_mut_set_sint(yyjson_mut_val *val,
+                                                  int64_t num) {
+    unsafe_yyjson_mut_set_tag(val, YYJSON_TYPE_NUM, YYJSON_SUBTYPE_SINT, 0);
+    val->uni.i64 = num;
+}
+
+yyjson_api_inline void unsafe_yyjson_mut_set_float(yyjson_mut_val *val,
+                                                   float num) {
+    unsafe_yyjson_mut_set_tag(val, YYJSON_TYPE_NUM, YYJSON_SUBTYPE_REAL, 0);
+    unsafe_yyjson_mut_set_fp_to_float(val, true);
+    val->uni.f64 = (double)num;
+}
+
+yyjson_api_inline void unsafe_yyjson_mut_set_double(yyjson_mut_val *val,
+                                                    double num) {
+    unsafe_yyjson_mut_set_tag(val, YYJSON_TYPE_NUM, YYJSON_SUBTYPE_REAL, 0);
+    val->uni.f64 = num;
+}
+
+yyjson_api_inline void unsafe_yyjson_mut_set_real(yyjson_mut_val *val,
+                                                  double num) {
+    unsafe_yyjson_mut_set_tag(val, YYJSON_TYPE_NUM, YYJSON_SUBTYPE_REAL, 0);
+    val->uni.f64 = num;
+}
+
+yyjson_api_inline bool unsafe_yyjson_mut_set_strn(yyjson_mut_val *val,
+                                                  const char *str,
+                                                  size_t len) {
+    return unsafe_yyjson_mut_set_strx(val, YYJSON_TYPE_STR,
+                                      YYJSON_SUBTYPE_NONE, str, len);
+}
+
+yyjson_api_inline bool unsafe_yyjson_mut_set_str(yyjson_mut_val *val,
+                                                 const char *str) {
+    size_t len = strlen(str);
+    bool noesc = unsafe_yyjson_is_str_noesc(str, len);
+    yyjson_subtype subtype = noesc ? YYJSON_SUBTYPE_NOESC : YYJSON_SUBTYPE_NONE;
+    return unsafe_yyjson_mut_set_strx(val, YYJSON_TYPE_STR, subtype, str, len);
+}
+
+yyjson_api_inline void unsafe_yyjson_mut_set_arr(yyjson_mut_val *val,
+                                                 size_t size) {
+    unsafe_yyjson_mut_set_tag(val, YYJSON_TYPE_ARR, YYJSON_SUBTYPE_NONE, size);
+}
+
+yyjson_api_inline void unsafe_yyjson_mut_set_obj(yyjson_mut_val *val,
+                                                 size_t size) {
+    unsafe_yyjson_mut_set_tag(val, YYJSON_TYPE_OBJ, YYJSON_SUBTYPE_NONE, size);
+}
+
 
 
 /*==============================================================================
@@ -5999,16 +7761,20 @@ yyjson_api_inline yyjson_subtype yyjson_mut_get_subtype(
 }
 
 yyjson_api_inline uint8_t yyjson_mut_get_tag(const yyjson_mut_val *val) {
-    return yyjson_get_tag((const yyjson_val *)val);
+    uint8_t tag = yyjson_get_tag((const yyjson_val *)val);
+    return (uint8_t)(tag & ~YYJSON_MUT_IDX_FLAG);
 }
 
 yyjson_api_inline const char *yyjson_mut_get_type_desc(
     const yyjson_mut_val *val) {
+    if (yyjson_unlikely(val && unsafe_yyjson_mut_is_indexed(val))) {
+        return unsafe_yyjson_is_arr(val) ? "array" : "object";
+    }
     return yyjson_get_type_desc((const yyjson_val *)val);
 }
 
 yyjson_api_inline const char *yyjson_mut_get_raw(const yyjson_mut_val *val) {
-    return yyjson_get_raw((const yyjson_val *)val);
+    return yyjson_mut_is_raw(val) ? unsafe_yyjson_mut_get_str(val) : NULL;
 }
 
 yyjson_api_inline bool yyjson_mut_get_bool(const yyjson_mut_val *val) {
@@ -6036,21 +7802,29 @@ yyjson_api_inline double yyjson_mut_get_num(const yyjson_mut_val *val) {
 }
 
 yyjson_api_inline const char *yyjson_mut_get_str(const yyjson_mut_val *val) {
-    return yyjson_get_str((const yyjson_val *)val);
+    return yyjson_mut_is_str(val) ? unsafe_yyjson_mut_get_str(val) : NULL;
 }
 
 yyjson_api_inline size_t yyjson_mut_get_len(const yyjson_mut_val *val) {
-    return yyjson_get_len((const yyjson_val *)val);
+    return val ? unsafe_yyjson_mut_get_len(val) : 0;
 }
 
 yyjson_api_inline bool yyjson_mut_equals_str(const yyjson_mut_val *val,
                                              const char *str) {
-    return yyjson_equals_str((const yyjson_val *)val, str);
+    if (yyjson_likely(val && str)) {
+        return unsafe_yyjson_is_str(val) &&
+               unsafe_yyjson_mut_equals_strn(val, str, strlen(str));
+    }
+    return false;
 }
 
 yyjson_api_inline bool yyjson_mut_equals_strn(const yyjson_mut_val *val,
                                               const char *str, size_t len) {
-    return yyjson_equals_strn((const yyjson_val *)val, str, len);
+    if (yyjson_likely(val && str)) {
+        return unsafe_yyjson_is_str(val) &&
+               unsafe_yyjson_mut_equals_strn(val, str, len);
+    }
+    return false;
 }
 
 yyjson_api bool unsafe_yyjson_mut_equals(const yyjson_mut_val *lhs,
@@ -6065,84 +7839,81 @@ yyjson_api_inline bool yyjson_mut_equals(const yyjson_mut_val *lhs,
 yyjson_api_inline bool yyjson_mut_set_raw(yyjson_mut_val *val,
                                           const char *raw, size_t len) {
     if (yyjson_unlikely(!val || !raw)) return false;
-    unsafe_yyjson_set_raw(val, raw, len);
-    return true;
+    return unsafe_yyjson_mut_set_raw(val, raw, len);
 }
 
 yyjson_api_inline bool yyjson_mut_set_null(yyjson_mut_val *val) {
     if (yyjson_unlikely(!val)) return false;
-    unsafe_yyjson_set_null(val);
+    unsafe_yyjson_mut_set_null(val);
     return true;
 }
 
 yyjson_api_inline bool yyjson_mut_set_bool(yyjson_mut_val *val, bool num) {
     if (yyjson_unlikely(!val)) return false;
-    unsafe_yyjson_set_bool(val, num);
+    unsafe_yyjson_mut_set_bool(val, num);
     return true;
 }
 
 yyjson_api_inline bool yyjson_mut_set_uint(yyjson_mut_val *val, uint64_t num) {
     if (yyjson_unlikely(!val)) return false;
-    unsafe_yyjson_set_uint(val, num);
+    unsafe_yyjson_mut_set_uint(val, num);
     return true;
 }
 
 yyjson_api_inline bool yyjson_mut_set_sint(yyjson_mut_val *val, int64_t num) {
     if (yyjson_unlikely(!val)) return false;
-    unsafe_yyjson_set_sint(val, num);
+    unsafe_yyjson_mut_set_sint(val, num);
     return true;
 }
 
 yyjson_api_inline bool yyjson_mut_set_int(yyjson_mut_val *val, int64_t num) {
     if (yyjson_unlikely(!val)) return false;
-    unsafe_yyjson_set_sint(val, num);
+    unsafe_yyjson_mut_set_sint(val, num);
     return true;
 }
 
 yyjson_api_inline bool yyjson_mut_set_float(yyjson_mut_val *val, float num) {
     if (yyjson_unlikely(!val)) return false;
-    unsafe_yyjson_set_float(val, num);
+    unsafe_yyjson_mut_set_float(val, num);
     return true;
 }
 
 yyjson_api_inline bool yyjson_mut_set_double(yyjson_mut_val *val, double num) {
     if (yyjson_unlikely(!val)) return false;
-    unsafe_yyjson_set_double(val, num);
+    unsafe_yyjson_mut_set_double(val, num);
     return true;
 }
 
 yyjson_api_inline bool yyjson_mut_set_real(yyjson_mut_val *val, double num) {
     if (yyjson_unlikely(!val)) return false;
-    unsafe_yyjson_set_real(val, num);
+    unsafe_yyjson_mut_set_real(val, num);
     return true;
 }
 
 yyjson_api_inline bool yyjson_mut_set_fp_to_fixed(yyjson_mut_val *val,
                                                   int prec) {
     if (yyjson_unlikely(!yyjson_mut_is_real(val))) return false;
-    unsafe_yyjson_set_fp_to_fixed(val, prec);
+    unsafe_yyjson_mut_set_fp_to_fixed(val, prec);
     return true;
 }
 
 yyjson_api_inline bool yyjson_mut_set_fp_to_float(yyjson_mut_val *val,
                                                   bool flt) {
     if (yyjson_unlikely(!yyjson_mut_is_real(val))) return false;
-    unsafe_yyjson_set_fp_to_float(val, flt);
+    unsafe_yyjson_mut_set_fp_to_float(val, flt);
     return true;
 }
 
 yyjson_api_inline bool yyjson_mut_set_str(yyjson_mut_val *val,
                                           const char *str) {
     if (yyjson_unlikely(!val || !str)) return false;
-    unsafe_yyjson_set_str(val, str);
-    return true;
+    return unsafe_yyjson_mut_set_str(val, str);
 }
 
 yyjson_api_inline bool yyjson_mut_set_strn(yyjson_mut_val *val,
                                            const char *str, size_t len) {
     if (yyjson_unlikely(!val || !str)) return false;
-    unsafe_yyjson_set_strn(val, str, len);
-    return true;
+    return unsafe_yyjson_mut_set_strn(val, str, len);
 }
 
 yyjson_api_inline bool yyjson_mut_set_str_noesc(yyjson_mut_val *val,
@@ -6154,13 +7925,13 @@ yyjson_api_inline bool yyjson_mut_set_str_noesc(yyjson_mut_val *val,
 
 yyjson_api_inline bool yyjson_mut_set_arr(yyjson_mut_val *val) {
     if (yyjson_unlikely(!val)) return false;
-    unsafe_yyjson_set_arr(val, 0);
+    unsafe_yyjson_mut_set_arr(val, 0);
     return true;
 }
 
 yyjson_api_inline bool yyjson_mut_set_obj(yyjson_mut_val *val) {
     if (yyjson_unlikely(!val)) return false;
-    unsafe_yyjson_set_obj(val, 0);
+    unsafe_yyjson_mut_set_obj(val, 0);
     return true;
 }
 
@@ -6192,13 +7963,17 @@ yyjson_api_inline bool yyjson_mut_set_obj(yyjson_mut_val *val) {
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_raw(yyjson_mut_doc *doc,
                                                  const char *str) {
-    yyjson_mut_val_one_str({ unsafe_yyjson_set_raw(val, str, strlen(str)); });
+    yyjson_mut_val_one_str({
+        if (!unsafe_yyjson_mut_set_raw(val, str, strlen(str))) return NULL;
+    });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_rawn(yyjson_mut_doc *doc,
                                                   const char *str,
                                                   size_t len) {
-    yyjson_mut_val_one_str({ unsafe_yyjson_set_raw(val, str, len); });
+    yyjson_mut_val_one_str({
+        if (!unsafe_yyjson_mut_set_raw(val, str, len)) return NULL;
+    });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_rawcpy(yyjson_mut_doc *doc,
@@ -6207,7 +7982,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_rawcpy(yyjson_mut_doc *doc,
         size_t len = strlen(str);
         char *new_str = unsafe_yyjson_mut_strncpy(doc, str, len);
         if (yyjson_unlikely(!new_str)) return NULL;
-        unsafe_yyjson_set_raw(val, new_str, len);
+        if (!unsafe_yyjson_mut_set_raw(val, new_str, len)) return NULL;
     });
 }
 
@@ -6217,66 +7992,70 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_rawncpy(yyjson_mut_doc *doc,
     yyjson_mut_val_one_str({
         char *new_str = unsafe_yyjson_mut_strncpy(doc, str, len);
         if (yyjson_unlikely(!new_str)) return NULL;
-        unsafe_yyjson_set_raw(val, new_str, len);
+        if (!unsafe_yyjson_mut_set_raw(val, new_str, len)) return NULL;
     });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_null(yyjson_mut_doc *doc) {
-    yyjson_mut_val_one({ unsafe_yyjson_set_null(val); });
+    yyjson_mut_val_one({ unsafe_yyjson_mut_set_null(val); });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_true(yyjson_mut_doc *doc) {
-    yyjson_mut_val_one({ unsafe_yyjson_set_bool(val, true); });
+    yyjson_mut_val_one({ unsafe_yyjson_mut_set_bool(val, true); });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_false(yyjson_mut_doc *doc) {
-    yyjson_mut_val_one({ unsafe_yyjson_set_bool(val, false); });
+    yyjson_mut_val_one({ unsafe_yyjson_mut_set_bool(val, false); });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_bool(yyjson_mut_doc *doc,
                                                   bool _val) {
-    yyjson_mut_val_one({ unsafe_yyjson_set_bool(val, _val); });
+    yyjson_mut_val_one({ unsafe_yyjson_mut_set_bool(val, _val); });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_uint(yyjson_mut_doc *doc,
                                                   uint64_t num) {
-    yyjson_mut_val_one({ unsafe_yyjson_set_uint(val, num); });
+    yyjson_mut_val_one({ unsafe_yyjson_mut_set_uint(val, num); });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_sint(yyjson_mut_doc *doc,
                                                   int64_t num) {
-    yyjson_mut_val_one({ unsafe_yyjson_set_sint(val, num); });
+    yyjson_mut_val_one({ unsafe_yyjson_mut_set_sint(val, num); });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_int(yyjson_mut_doc *doc,
                                                  int64_t num) {
-    yyjson_mut_val_one({ unsafe_yyjson_set_sint(val, num); });
+    yyjson_mut_val_one({ unsafe_yyjson_mut_set_sint(val, num); });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_float(yyjson_mut_doc *doc,
                                                    float num) {
-    yyjson_mut_val_one({ unsafe_yyjson_set_float(val, num); });
+    yyjson_mut_val_one({ unsafe_yyjson_mut_set_float(val, num); });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_double(yyjson_mut_doc *doc,
                                                     double num) {
-    yyjson_mut_val_one({ unsafe_yyjson_set_double(val, num); });
+    yyjson_mut_val_one({ unsafe_yyjson_mut_set_double(val, num); });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_real(yyjson_mut_doc *doc,
                                                   double num) {
-    yyjson_mut_val_one({ unsafe_yyjson_set_real(val, num); });
+    yyjson_mut_val_one({ unsafe_yyjson_mut_set_real(val, num); });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_str(yyjson_mut_doc *doc,
                                                  const char *str) {
-    yyjson_mut_val_one_str({ unsafe_yyjson_set_str(val, str); });
+    yyjson_mut_val_one_str({
+        if (!unsafe_yyjson_mut_set_str(val, str)) return NULL;
+    });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_strn(yyjson_mut_doc *doc,
                                                   const char *str,
                                                   size_t len) {
-    yyjson_mut_val_one_str({ unsafe_yyjson_set_strn(val, str, len); });
+    yyjson_mut_val_one_str({
+        if (!unsafe_yyjson_mut_set_strn(val, str, len)) return NULL;
+    });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_strcpy(yyjson_mut_doc *doc,
@@ -6287,8 +8066,8 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_strcpy(yyjson_mut_doc *doc,
         yyjson_subtype sub = noesc ? YYJSON_SUBTYPE_NOESC : YYJSON_SUBTYPE_NONE;
         char *new_str = unsafe_yyjson_mut_strncpy(doc, str, len);
         if (yyjson_unlikely(!new_str)) return NULL;
-        unsafe_yyjson_set_tag(val, YYJSON_TYPE_STR, sub, len);
-        val->uni.str = new_str;
+        if (!unsafe_yyjson_mut_set_strx(val, YYJSON_TYPE_STR, sub,
+                                        new_str, len)) return NULL;
     });
 }
 
@@ -6298,7 +8077,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_strncpy(yyjson_mut_doc *doc,
     yyjson_mut_val_one_str({
         char *new_str = unsafe_yyjson_mut_strncpy(doc, str, len);
         if (yyjson_unlikely(!new_str)) return NULL;
-        unsafe_yyjson_set_strn(val, new_str, len);
+        if (!unsafe_yyjson_mut_set_strn(val, new_str, len)) return NULL;
     });
 }
 
@@ -6312,15 +8091,19 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_strncpy(yyjson_mut_doc *doc,
  *============================================================================*/
 
 yyjson_api_inline size_t yyjson_mut_arr_size(const yyjson_mut_val *arr) {
-    return yyjson_mut_is_arr(arr) ? unsafe_yyjson_get_len(arr) : 0;
+    return yyjson_mut_is_arr(arr) ? unsafe_yyjson_mut_get_len(arr) : 0;
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_get(const yyjson_mut_val *arr,
                                                      size_t idx) {
     if (yyjson_likely(idx < yyjson_mut_arr_size(arr))) {
-        yyjson_mut_val *val = (yyjson_mut_val *)arr->uni.ptr;
-        while (idx-- > 0) val = val->next;
-        return val->next;
+        yyjson_mut_val *val;
+        if (unsafe_yyjson_mut_is_indexed(arr)) {
+            return unsafe_yyjson_mut_arr_idx_get(arr, idx);
+        }
+        val = unsafe_yyjson_mut_get_last(arr);
+        while (idx-- > 0) val = unsafe_yyjson_mut_get_next(val);
+        return unsafe_yyjson_mut_get_next(val);
     }
     return NULL;
 }
@@ -6328,7 +8111,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_get(const yyjson_mut_val *arr,
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_get_first(
     const yyjson_mut_val *arr) {
     if (yyjson_likely(yyjson_mut_arr_size(arr) > 0)) {
-        return ((yyjson_mut_val *)arr->uni.ptr)->next;
+        return unsafe_yyjson_mut_get_next(unsafe_yyjson_mut_get_last(arr));
     }
     return NULL;
 }
@@ -6336,7 +8119,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_get_first(
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_get_last(
     const yyjson_mut_val *arr) {
     if (yyjson_likely(yyjson_mut_arr_size(arr) > 0)) {
-        return ((yyjson_mut_val *)arr->uni.ptr);
+        return unsafe_yyjson_mut_get_last(arr);
     }
     return NULL;
 }
@@ -6351,8 +8134,8 @@ yyjson_api_inline bool yyjson_mut_arr_iter_init(yyjson_mut_val *arr,
                                                 yyjson_mut_arr_iter *iter) {
     if (yyjson_likely(yyjson_mut_is_arr(arr) && iter)) {
         iter->idx = 0;
-        iter->max = unsafe_yyjson_get_len(arr);
-        iter->cur = iter->max ? (yyjson_mut_val *)arr->uni.ptr : NULL;
+        iter->max = unsafe_yyjson_mut_get_len(arr);
+        iter->cur = iter->max ? unsafe_yyjson_mut_get_last(arr) : NULL;
         iter->pre = NULL;
         iter->arr = arr;
         return true;
@@ -6377,7 +8160,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_iter_next(
     if (iter && iter->idx < iter->max) {
         yyjson_mut_val *val = iter->cur;
         iter->pre = val;
-        iter->cur = val->next;
+        iter->cur = unsafe_yyjson_mut_get_next(val);
         iter->idx++;
         return iter->cur;
     }
@@ -6389,12 +8172,17 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_iter_remove(
     if (yyjson_likely(iter && 0 < iter->idx && iter->idx <= iter->max)) {
         yyjson_mut_val *prev = iter->pre;
         yyjson_mut_val *cur = iter->cur;
-        yyjson_mut_val *next = cur->next;
-        if (yyjson_unlikely(iter->idx == iter->max)) iter->arr->uni.ptr = prev;
+        yyjson_mut_val *next = unsafe_yyjson_mut_get_next(cur);
+        if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(iter->arr))) {
+            unsafe_yyjson_mut_idx_drop(iter->arr);
+        }
+        if (yyjson_unlikely(iter->idx == iter->max)) {
+            unsafe_yyjson_mut_set_last(iter->arr, prev);
+        }
         iter->idx--;
         iter->max--;
-        unsafe_yyjson_set_len(iter->arr, iter->max);
-        prev->next = next;
+        unsafe_yyjson_mut_set_len(iter->arr, iter->max);
+        unsafe_yyjson_mut_set_next(prev, next);
         iter->cur = prev;
         return cur;
     }
@@ -6411,7 +8199,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr(yyjson_mut_doc *doc) {
     if (yyjson_likely(doc)) {
         yyjson_mut_val *val = unsafe_yyjson_mut_val(doc, 1);
         if (yyjson_likely(val)) {
-            val->tag = YYJSON_TYPE_ARR | YYJSON_SUBTYPE_NONE;
+            unsafe_yyjson_mut_set_arr(val, 0);
             return val;
         }
     }
@@ -6421,18 +8209,23 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr(yyjson_mut_doc *doc) {
 #define yyjson_mut_arr_with_func(func) \
     if (yyjson_likely(doc && ((0 < count && count < \
         (~(size_t)0) / sizeof(yyjson_mut_val) && vals) || count == 0))) { \
-        yyjson_mut_val *arr = unsafe_yyjson_mut_val(doc, 1 + count); \
+        size_t run = unsafe_yyjson_mut_val_run(doc, 1 + count); \
+        yyjson_mut_val *arr = unsafe_yyjson_mut_val(doc, run); \
         if (yyjson_likely(arr)) { \
-            arr->tag = ((uint64_t)count << YYJSON_TAG_BIT) | YYJSON_TYPE_ARR; \
-            if (count > 0) { \
-                size_t i; \
-                for (i = 0; i < count; i++) { \
-                    yyjson_mut_val *val = arr + i + 1; \
-                    func \
-                    val->next = val + 1; \
-                } \
-                arr[count].next = arr + 1; \
-                arr->uni.ptr = arr + count; \
+            yyjson_mut_val *val = arr, *prev = NULL, *first = NULL; \
+            size_t i; \
+            unsafe_yyjson_mut_set_arr(arr, count); \
+            for (i = 0; i < count; i++) { \
+                val = unsafe_yyjson_mut_val_next(doc, val, &run, count - i); \
+                if (yyjson_unlikely(!val)) return NULL; \
+                func \
+                if (prev) unsafe_yyjson_mut_set_next(prev, val); \
+                else first = val; \
+                prev = val; \
+            } \
+            if (prev) { \
+                unsafe_yyjson_mut_set_next(prev, first); \
+                unsafe_yyjson_mut_set_last(arr, prev); \
             } \
             return arr; \
         } \
@@ -6442,7 +8235,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr(yyjson_mut_doc *doc) {
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_bool(
     yyjson_mut_doc *doc, const bool *vals, size_t count) {
     yyjson_mut_arr_with_func({
-        unsafe_yyjson_set_bool(val, vals[i]);
+        unsafe_yyjson_mut_set_bool(val, vals[i]);
     });
 }
 
@@ -6459,77 +8252,77 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_uint(
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_real(
     yyjson_mut_doc *doc, const double *vals, size_t count) {
     yyjson_mut_arr_with_func({
-        unsafe_yyjson_set_real(val, vals[i]);
+        unsafe_yyjson_mut_set_real(val, vals[i]);
     });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_sint8(
     yyjson_mut_doc *doc, const int8_t *vals, size_t count) {
     yyjson_mut_arr_with_func({
-        unsafe_yyjson_set_sint(val, vals[i]);
+        unsafe_yyjson_mut_set_sint(val, vals[i]);
     });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_sint16(
     yyjson_mut_doc *doc, const int16_t *vals, size_t count) {
     yyjson_mut_arr_with_func({
-        unsafe_yyjson_set_sint(val, vals[i]);
+        unsafe_yyjson_mut_set_sint(val, vals[i]);
     });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_sint32(
     yyjson_mut_doc *doc, const int32_t *vals, size_t count) {
     yyjson_mut_arr_with_func({
-        unsafe_yyjson_set_sint(val, vals[i]);
+        unsafe_yyjson_mut_set_sint(val, vals[i]);
     });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_sint64(
     yyjson_mut_doc *doc, const int64_t *vals, size_t count) {
     yyjson_mut_arr_with_func({
-        unsafe_yyjson_set_sint(val, vals[i]);
+        unsafe_yyjson_mut_set_sint(val, vals[i]);
     });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_uint8(
     yyjson_mut_doc *doc, const uint8_t *vals, size_t count) {
     yyjson_mut_arr_with_func({
-        unsafe_yyjson_set_uint(val, vals[i]);
+        unsafe_yyjson_mut_set_uint(val, vals[i]);
     });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_uint16(
     yyjson_mut_doc *doc, const uint16_t *vals, size_t count) {
     yyjson_mut_arr_with_func({
-        unsafe_yyjson_set_uint(val, vals[i]);
+        unsafe_yyjson_mut_set_uint(val, vals[i]);
     });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_uint32(
     yyjson_mut_doc *doc, const uint32_t *vals, size_t count) {
     yyjson_mut_arr_with_func({
-        unsafe_yyjson_set_uint(val, vals[i]);
+        unsafe_yyjson_mut_set_uint(val, vals[i]);
     });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_uint64(
     yyjson_mut_doc *doc, const uint64_t *vals, size_t count) {
     yyjson_mut_arr_with_func({
-        unsafe_yyjson_set_uint(val, vals[i]);
+        unsafe_yyjson_mut_set_uint(val, vals[i]);
     });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_float(
     yyjson_mut_doc *doc, const float *vals, size_t count) {
     yyjson_mut_arr_with_func({
-        unsafe_yyjson_set_float(val, vals[i]);
+        unsafe_yyjson_mut_set_float(val, vals[i]);
     });
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_double(
     yyjson_mut_doc *doc, const double *vals, size_t count) {
     yyjson_mut_arr_with_func({
-        unsafe_yyjson_set_double(val, vals[i]);
+        unsafe_yyjson_mut_set_double(val, vals[i]);
     });
 }
 
@@ -6537,7 +8330,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_str(
     yyjson_mut_doc *doc, const char **vals, size_t count) {
     yyjson_mut_arr_with_func({
         if (yyjson_unlikely(!vals[i])) return NULL;
-        unsafe_yyjson_set_str(val, vals[i]);
+        if (!unsafe_yyjson_mut_set_str(val, vals[i])) return NULL;
     });
 }
 
@@ -6546,7 +8339,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_strn(
     if (yyjson_unlikely(count > 0 && !lens)) return NULL;
     yyjson_mut_arr_with_func({
         if (yyjson_unlikely(!vals[i])) return NULL;
-        unsafe_yyjson_set_strn(val, vals[i], lens[i]);
+        if (!unsafe_yyjson_mut_set_strn(val, vals[i], lens[i])) return NULL;
     });
 }
 
@@ -6560,7 +8353,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_strcpy(
         len = strlen(str);
         new_str = unsafe_yyjson_mut_strncpy(doc, str, len);
         if (yyjson_unlikely(!new_str)) return NULL;
-        unsafe_yyjson_set_strn(val, new_str, len);
+        if (!unsafe_yyjson_mut_set_strn(val, new_str, len)) return NULL;
     });
 }
 
@@ -6575,7 +8368,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_strncpy(
         len = lens[i];
         new_str = unsafe_yyjson_mut_strncpy(doc, str, len);
         if (yyjson_unlikely(!new_str)) return NULL;
-        unsafe_yyjson_set_strn(val, new_str, len);
+        if (!unsafe_yyjson_mut_set_strn(val, new_str, len)) return NULL;
     });
 }
 
@@ -6590,26 +8383,29 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_with_strncpy(
 yyjson_api_inline bool yyjson_mut_arr_insert(yyjson_mut_val *arr,
                                              yyjson_mut_val *val, size_t idx) {
     if (yyjson_likely(yyjson_mut_is_arr(arr) && val)) {
-        size_t len = unsafe_yyjson_get_len(arr);
+        size_t len = unsafe_yyjson_mut_get_len(arr);
         if (yyjson_likely(idx <= len)) {
-            unsafe_yyjson_set_len(arr, len + 1);
+            if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(arr))) {
+                return unsafe_yyjson_mut_arr_idx_insert(arr, val, idx);
+            }
+            unsafe_yyjson_mut_set_len(arr, len + 1);
             if (len == 0) {
-                val->next = val;
-                arr->uni.ptr = val;
+                unsafe_yyjson_mut_set_next(val, val);
+                unsafe_yyjson_mut_set_last(arr, val);
             } else {
-                yyjson_mut_val *prev = ((yyjson_mut_val *)arr->uni.ptr);
-                yyjson_mut_val *next = prev->next;
+                yyjson_mut_val *prev = unsafe_yyjson_mut_get_last(arr);
+                yyjson_mut_val *next = unsafe_yyjson_mut_get_next(prev);
                 if (idx == len) {
-                    prev->next = val;
-                    val->next = next;
-                    arr->uni.ptr = val;
+                    unsafe_yyjson_mut_set_next(prev, val);
+                    unsafe_yyjson_mut_set_next(val, next);
+                    unsafe_yyjson_mut_set_last(arr, val);
                 } else {
                     while (idx-- > 0) {
                         prev = next;
-                        next = next->next;
+                        next = unsafe_yyjson_mut_get_next(next);
                     }
-                    prev->next = val;
-                    val->next = next;
+                    unsafe_yyjson_mut_set_next(prev, val);
+                    unsafe_yyjson_mut_set_next(val, next);
                 }
             }
             return true;
@@ -6621,17 +8417,20 @@ yyjson_api_inline bool yyjson_mut_arr_insert(yyjson_mut_val *arr,
 yyjson_api_inline bool yyjson_mut_arr_append(yyjson_mut_val *arr,
                                              yyjson_mut_val *val) {
     if (yyjson_likely(yyjson_mut_is_arr(arr) && val)) {
-        size_t len = unsafe_yyjson_get_len(arr);
-        unsafe_yyjson_set_len(arr, len + 1);
+        size_t len = unsafe_yyjson_mut_get_len(arr);
+        if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(arr))) {
+            return unsafe_yyjson_mut_arr_idx_insert(arr, val, len);
+        }
+        unsafe_yyjson_mut_set_len(arr, len + 1);
         if (len == 0) {
-            val->next = val;
+            unsafe_yyjson_mut_set_next(val, val);
         } else {
-            yyjson_mut_val *prev = ((yyjson_mut_val *)arr->uni.ptr);
-            yyjson_mut_val *next = prev->next;
-            prev->next = val;
-            val->next = next;
+            yyjson_mut_val *prev = unsafe_yyjson_mut_get_last(arr);
+            yyjson_mut_val *next = unsafe_yyjson_mut_get_next(prev);
+            unsafe_yyjson_mut_set_next(prev, val);
+            unsafe_yyjson_mut_set_next(val, next);
         }
-        arr->uni.ptr = val;
+        unsafe_yyjson_mut_set_last(arr, val);
         return true;
     }
     return false;
@@ -6640,16 +8439,19 @@ yyjson_api_inline bool yyjson_mut_arr_append(yyjson_mut_val *arr,
 yyjson_api_inline bool yyjson_mut_arr_prepend(yyjson_mut_val *arr,
                                               yyjson_mut_val *val) {
     if (yyjson_likely(yyjson_mut_is_arr(arr) && val)) {
-        size_t len = unsafe_yyjson_get_len(arr);
-        unsafe_yyjson_set_len(arr, len + 1);
+        size_t len = unsafe_yyjson_mut_get_len(arr);
+        if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(arr))) {
+            return unsafe_yyjson_mut_arr_idx_insert(arr, val, 0);
+        }
+        unsafe_yyjson_mut_set_len(arr, len + 1);
         if (len == 0) {
-            val->next = val;
-            arr->uni.ptr = val;
+            unsafe_yyjson_mut_set_next(val, val);
+            unsafe_yyjson_mut_set_last(arr, val);
         } else {
-            yyjson_mut_val *prev = ((yyjson_mut_val *)arr->uni.ptr);
-            yyjson_mut_val *next = prev->next;
-            prev->next = val;
-            val->next = next;
+            yyjson_mut_val *prev = unsafe_yyjson_mut_get_last(arr);
+            yyjson_mut_val *next = unsafe_yyjson_mut_get_next(prev);
+            unsafe_yyjson_mut_set_next(prev, val);
+            unsafe_yyjson_mut_set_next(val, next);
         }
         return true;
     }
@@ -6660,23 +8462,29 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_replace(yyjson_mut_val *arr,
                                                          size_t idx,
                                                          yyjson_mut_val *val) {
     if (yyjson_likely(yyjson_mut_is_arr(arr) && val)) {
-        size_t len = unsafe_yyjson_get_len(arr);
+        size_t len = unsafe_yyjson_mut_get_len(arr);
         if (yyjson_likely(idx < len)) {
+            if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(arr))) {
+                return unsafe_yyjson_mut_arr_idx_replace(arr, idx, val);
+            }
             if (yyjson_likely(len > 1)) {
-                yyjson_mut_val *prev = ((yyjson_mut_val *)arr->uni.ptr);
-                yyjson_mut_val *next = prev->next;
+                yyjson_mut_val *prev = unsafe_yyjson_mut_get_last(arr);
+                yyjson_mut_val *next = unsafe_yyjson_mut_get_next(prev);
                 while (idx-- > 0) {
                     prev = next;
-                    next = next->next;
+                    next = unsafe_yyjson_mut_get_next(next);
+                }
+                unsafe_yyjson_mut_set_next(prev, val);
+                unsafe_yyjson_mut_set_next(val,
+                                           unsafe_yyjson_mut_get_next(next));
+                if (next == unsafe_yyjson_mut_get_last(arr)) {
+                    unsafe_yyjson_mut_set_last(arr, val);
                 }
-                prev->next = val;
-                val->next = next->next;
-                if ((void *)next == arr->uni.ptr) arr->uni.ptr = val;
                 return next;
             } else {
-                yyjson_mut_val *prev = ((yyjson_mut_val *)arr->uni.ptr);
-                val->next = val;
-                arr->uni.ptr = val;
+                yyjson_mut_val *prev = unsafe_yyjson_mut_get_last(arr);
+                unsafe_yyjson_mut_set_next(val, val);
+                unsafe_yyjson_mut_set_last(arr, val);
                 return prev;
             }
         }
@@ -6687,21 +8495,27 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_replace(yyjson_mut_val *arr,
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_remove(yyjson_mut_val *arr,
                                                         size_t idx) {
     if (yyjson_likely(yyjson_mut_is_arr(arr))) {
-        size_t len = unsafe_yyjson_get_len(arr);
+        size_t len = unsafe_yyjson_mut_get_len(arr);
         if (yyjson_likely(idx < len)) {
-            unsafe_yyjson_set_len(arr, len - 1);
+            if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(arr))) {
+                return unsafe_yyjson_mut_arr_idx_remove(arr, idx);
+            }
+            unsafe_yyjson_mut_set_len(arr, len - 1);
             if (yyjson_likely(len > 1)) {
-                yyjson_mut_val *prev = ((yyjson_mut_val *)arr->uni.ptr);
-                yyjson_mut_val *next = prev->next;
+                yyjson_mut_val *prev = unsafe_yyjson_mut_get_last(arr);
+                yyjson_mut_val *next = unsafe_yyjson_mut_get_next(prev);
                 while (idx-- > 0) {
                     prev = next;
-                    next = next->next;
+                    next = unsafe_yyjson_mut_get_next(next);
+                }
+                unsafe_yyjson_mut_set_next(prev,
+                                           unsafe_yyjson_mut_get_next(next));
+                if (next == unsafe_yyjson_mut_get_last(arr)) {
+                    unsafe_yyjson_mut_set_last(arr, prev);
                 }
-                prev->next = next->next;
-                if ((void *)next == arr->uni.ptr) arr->uni.ptr = prev;
                 return next;
             } else {
-                return ((yyjson_mut_val *)arr->uni.ptr);
+                return unsafe_yyjson_mut_get_last(arr);
             }
         }
     }
@@ -6711,16 +8525,19 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_remove(yyjson_mut_val *arr,
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_remove_first(
     yyjson_mut_val *arr) {
     if (yyjson_likely(yyjson_mut_is_arr(arr))) {
-        size_t len = unsafe_yyjson_get_len(arr);
+        size_t len = unsafe_yyjson_mut_get_len(arr);
+        if (yyjson_unlikely(len && unsafe_yyjson_mut_is_indexed(arr))) {
+            return unsafe_yyjson_mut_arr_idx_remove(arr, 0);
+        }
         if (len > 1) {
-            yyjson_mut_val *prev = ((yyjson_mut_val *)arr->uni.ptr);
-            yyjson_mut_val *next = prev->next;
-            prev->next = next->next;
-            unsafe_yyjson_set_len(arr, len - 1);
+            yyjson_mut_val *prev = unsafe_yyjson_mut_get_last(arr);
+            yyjson_mut_val *next = unsafe_yyjson_mut_get_next(prev);
+            unsafe_yyjson_mut_set_next(prev, unsafe_yyjson_mut_get_next(next));
+            unsafe_yyjson_mut_set_len(arr, len - 1);
             return next;
         } else if (len == 1) {
-            yyjson_mut_val *prev = ((yyjson_mut_val *)arr->uni.ptr);
-            unsafe_yyjson_set_len(arr, 0);
+            yyjson_mut_val *prev = unsafe_yyjson_mut_get_last(arr);
+            unsafe_yyjson_mut_set_len(arr, 0);
             return prev;
         }
     }
@@ -6730,19 +8547,22 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_remove_first(
 yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_remove_last(
     yyjson_mut_val *arr) {
     if (yyjson_likely(yyjson_mut_is_arr(arr))) {
-        size_t len = unsafe_yyjson_get_len(arr);
+        size_t len = unsafe_yyjson_mut_get_len(arr);
+        if (yyjson_unlikely(len && unsafe_yyjson_mut_is_indexed(arr))) {
+            return unsafe_yyjson_mut_arr_idx_remove(arr, len - 1);
+        }
         if (yyjson_likely(len > 1)) {
-            yyjson_mut_val *prev = ((yyjson_mut_val *)arr->uni.ptr);
-            yyjson_mut_val *next = prev->next;
-            unsafe_yyjson_set_len(arr, len - 1);
-            while (--len > 0) prev = prev->next;
-            prev->next = next;
-            next = (yyjson_mut_val *)arr->uni.ptr;
-            arr->uni.ptr = prev;
+            yyjson_mut_val *prev = unsafe_yyjson_mut_get_last(arr);
+            yyjson_mut_val *next = unsafe_yyjson_mut_get_next(prev);
+            unsafe_yyjson_mut_set_len(arr, len - 1);
+            while (--len > 0) prev = unsafe_yyjson_mut_get_next(prev);
+            unsafe_yyjson_mut_set_next(prev, next);
+            next = unsafe_yyjson_mut_get_last(arr);
+            unsafe_yyjson_mut_set_last(arr, prev);
             return next;
         } else if (len == 1) {
-            yyjson_mut_val *prev = ((yyjson_mut_val *)arr->uni.ptr);
-            unsafe_yyjson_set_len(arr, 0);
+            yyjson_mut_val *prev = unsafe_yyjson_mut_get_last(arr);
+            unsafe_yyjson_mut_set_len(arr, 0);
             return prev;
         }
     }
@@ -6754,18 +8574,23 @@ yyjson_api_inline bool yyjson_mut_arr_remove_range(yyjson_mut_val *arr,
     if (yyjson_likely(yyjson_mut_is_arr(arr))) {
         yyjson_mut_val *prev, *next;
         bool tail_removed;
-        size_t len = unsafe_yyjson_get_len(arr);
+        size_t len = unsafe_yyjson_mut_get_len(arr);
         if (yyjson_unlikely(_len > len || _idx > len - _len)) return false;
         if (yyjson_unlikely(_len == 0)) return true;
-        unsafe_yyjson_set_len(arr, len - _len);
+        if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(arr))) {
+            unsafe_yyjson_mut_idx_drop(arr);
+        }
+        unsafe_yyjson_mut_set_len(arr, len - _len);
         if (yyjson_unlikely(len == _len)) return true;
         tail_removed = (_idx + _len == len);
-        prev = ((yyjson_mut_val *)arr->uni.ptr);
-        while (_idx-- > 0) prev = prev->next;
-        next = prev->next;
-        while (_len-- > 0) next = next->next;
-        prev->next = next;
-        if (yyjson_unlikely(tail_removed)) arr->uni.ptr = prev;
+        prev = unsafe_yyjson_mut_get_last(arr);
+        while (_idx-- > 0) prev = unsafe_yyjson_mut_get_next(prev);
+        next = unsafe_yyjson_mut_get_next(prev);
+        while (_len-- > 0) next = unsafe_yyjson_mut_get_next(next);
+        unsafe_yyjson_mut_set_next(prev, next);
+        if (yyjson_unlikely(tail_removed)) {
+            unsafe_yyjson_mut_set_last(arr, prev);
+        }
         return true;
     }
     return false;
@@ -6773,7 +8598,7 @@ yyjson_api_inline bool yyjson_mut_arr_remove_range(yyjson_mut_val *arr,
 
 yyjson_api_inline bool yyjson_mut_arr_clear(yyjson_mut_val *arr) {
     if (yyjson_likely(yyjson_mut_is_arr(arr))) {
-        unsafe_yyjson_set_len(arr, 0);
+        unsafe_yyjson_mut_set_len(arr, 0);
         return true;
     }
     return false;
@@ -6782,10 +8607,14 @@ yyjson_api_inline bool yyjson_mut_arr_clear(yyjson_mut_val *arr) {
 yyjson_api_inline bool yyjson_mut_arr_rotate(yyjson_mut_val *arr,
                                              size_t idx) {
     if (yyjson_likely(yyjson_mut_is_arr(arr) &&
-                      unsafe_yyjson_get_len(arr) > idx)) {
-        yyjson_mut_val *val = (yyjson_mut_val *)arr->uni.ptr;
-        while (idx-- > 0) val = val->next;
-        arr->uni.ptr = (void *)val;
+                      unsafe_yyjson_mut_get_len(arr) > idx)) {
+        yyjson_mut_val *val;
+        if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(arr))) {
+            unsafe_yyjson_mut_idx_drop(arr);
+        }
+        val = unsafe_yyjson_mut_get_last(arr);
+        while (idx-- > 0) val = unsafe_yyjson_mut_get_next(val);
+        unsafe_yyjson_mut_set_last(arr, val);
         return true;
     }
     return false;
@@ -6964,7 +8793,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_arr_add_obj(yyjson_mut_doc *doc,
  *============================================================================*/
 
 yyjson_api_inline size_t yyjson_mut_obj_size(const yyjson_mut_val *obj) {
-    return yyjson_mut_is_obj(obj) ? unsafe_yyjson_get_len(obj) : 0;
+    return yyjson_mut_is_obj(obj) ? unsafe_yyjson_mut_get_len(obj) : 0;
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_get(const yyjson_mut_val *obj,
@@ -6977,10 +8806,16 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_getn(const yyjson_mut_val *obj,
                                                       size_t key_len) {
     size_t len = yyjson_mut_obj_size(obj);
     if (yyjson_likely(len && _key)) {
-        yyjson_mut_val *key = ((yyjson_mut_val *)obj->uni.ptr)->next->next;
+        yyjson_mut_val *key;
+        if (unsafe_yyjson_mut_is_indexed(obj)) {
+            return unsafe_yyjson_mut_obj_idx_getn(obj, _key, key_len);
+        }
+        key = unsafe_yyjson_mut_get_last(obj);
+        key = unsafe_yyjson_mut_get_next(unsafe_yyjson_mut_get_next(key));
         while (len-- > 0) {
-            if (unsafe_yyjson_equals_strn(key, _key, key_len)) return key->next;
-            key = key->next->next;
+            yyjson_mut_val *val = unsafe_yyjson_mut_get_next(key);
+            if (unsafe_yyjson_mut_equals_strn(key, _key, key_len)) return val;
+            key = unsafe_yyjson_mut_get_next(val);
         }
     }
     return NULL;
@@ -6996,8 +8831,8 @@ yyjson_api_inline bool yyjson_mut_obj_iter_init(yyjson_mut_val *obj,
                                                 yyjson_mut_obj_iter *iter) {
     if (yyjson_likely(yyjson_mut_is_obj(obj) && iter)) {
         iter->idx = 0;
-        iter->max = unsafe_yyjson_get_len(obj);
-        iter->cur = iter->max ? (yyjson_mut_val *)obj->uni.ptr : NULL;
+        iter->max = unsafe_yyjson_mut_get_len(obj);
+        iter->cur = iter->max ? unsafe_yyjson_mut_get_last(obj) : NULL;
         iter->pre = NULL;
         iter->obj = obj;
         return true;
@@ -7022,7 +8857,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_iter_next(
     if (iter && iter->idx < iter->max) {
         yyjson_mut_val *key = iter->cur;
         iter->pre = key;
-        iter->cur = key->next->next;
+        iter->cur = unsafe_yyjson_mut_get_next(unsafe_yyjson_mut_get_next(key));
         iter->idx++;
         return iter->cur;
     }
@@ -7031,7 +8866,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_iter_next(
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_iter_get_val(
     yyjson_mut_val *key) {
-    return key ? key->next : NULL;
+    return key ? unsafe_yyjson_mut_get_next(key) : NULL;
 }
 
 yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_iter_remove(
@@ -7039,14 +8874,20 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_iter_remove(
     if (yyjson_likely(iter && 0 < iter->idx && iter->idx <= iter->max)) {
         yyjson_mut_val *prev = iter->pre;
         yyjson_mut_val *cur = iter->cur;
-        yyjson_mut_val *next = cur->next->next;
-        if (yyjson_unlikely(iter->idx == iter->max)) iter->obj->uni.ptr = prev;
+        yyjson_mut_val *val = unsafe_yyjson_mut_get_next(cur);
+        yyjson_mut_val *next = unsafe_yyjson_mut_get_next(val);
+        if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(iter->obj))) {
+            unsafe_yyjson_mut_idx_drop(iter->obj);
+        }
+        if (yyjson_unlikely(iter->idx == iter->max)) {
+            unsafe_yyjson_mut_set_last(iter->obj, prev);
+        }
         iter->idx--;
         iter->max--;
-        unsafe_yyjson_set_len(iter->obj, iter->max);
-        prev->next->next = next;
+        unsafe_yyjson_mut_set_len(iter->obj, iter->max);
+        unsafe_yyjson_mut_set_next(unsafe_yyjson_mut_get_next(prev), next);
         iter->cur = prev;
-        return cur->next;
+        return val;
     }
     return NULL;
 }
@@ -7064,13 +8905,13 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_iter_getn(
         yyjson_mut_val *pre, *cur = iter->cur;
         while (idx++ < max) {
             pre = cur;
-            cur = cur->next->next;
-            if (unsafe_yyjson_equals_strn(cur, key, key_len)) {
+            cur = unsafe_yyjson_mut_get_next(unsafe_yyjson_mut_get_next(cur));
+            if (unsafe_yyjson_mut_equals_strn(cur, key, key_len)) {
                 iter->idx += idx;
                 if (iter->idx > max) iter->idx -= max;
                 iter->pre = pre;
                 iter->cur = cur;
-                return cur->next;
+                return unsafe_yyjson_mut_get_next(cur);
             }
         }
     }
@@ -7087,7 +8928,7 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_obj(yyjson_mut_doc *doc) {
     if (yyjson_likely(doc)) {
         yyjson_mut_val *val = unsafe_yyjson_mut_val(doc, 1);
         if (yyjson_likely(val)) {
-            val->tag = YYJSON_TYPE_OBJ | YYJSON_SUBTYPE_NONE;
+            unsafe_yyjson_mut_set_obj(val, 0);
             return val;
         }
     }
@@ -7101,27 +8942,36 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_with_str(yyjson_mut_doc *doc,
     if (yyjson_likely(doc && ((count > 0 && count <
         (~(size_t)0) / sizeof(yyjson_mut_val) / 2 &&
         keys && vals) || (count == 0)))) {
-        yyjson_mut_val *obj = unsafe_yyjson_mut_val(doc, 1 + count * 2);
+        size_t run = unsafe_yyjson_mut_val_run(doc, 1 + count * 2);
+        yyjson_mut_val *obj = unsafe_yyjson_mut_val(doc, run);
         if (yyjson_likely(obj)) {
-            obj->tag = ((uint64_t)count << YYJSON_TAG_BIT) | YYJSON_TYPE_OBJ;
-            if (count > 0) {
-                size_t i;
-                for (i = 0; i < count; i++) {
-                    yyjson_mut_val *key = obj + (i * 2 + 1);
-                    yyjson_mut_val *val = obj + (i * 2 + 2);
-                    uint64_t key_len, val_len;
-                    if (yyjson_unlikely(!keys[i] || !vals[i])) return NULL;
-                    key_len = (uint64_t)strlen(keys[i]);
-                    val_len = (uint64_t)strlen(vals[i]);
-                    key->tag = (key_len << YYJSON_TAG_BIT) | YYJSON_TYPE_STR;
-                    val->tag = (val_len << YYJSON_TAG_BIT) | YYJSON_TYPE_STR;
-                    key->uni.str = keys[i];
-                    val->uni.str = vals[i];
-                    key->next = val;
-                    val->next = val + 1;
+            yyjson_mut_val *key = NULL, *val = obj;
+            yyjson_mut_val *prev = NULL, *first = NULL;
+            size_t i, left;
+            unsafe_yyjson_mut_set_obj(obj, count);
+            for (i = 0; i < count; i++) {
+                size_t key_len, val_len;
+                if (yyjson_unlikely(!keys[i] || !vals[i])) return NULL;
+                left = (count - i) * 2;
+                key = unsafe_yyjson_mut_val_next(doc, val, &run, left);
+                if (yyjson_unlikely(!key)) return NULL;
+                val = unsafe_yyjson_mut_val_next(doc, key, &run, left - 1);
+                if (yyjson_unlikely(!val)) return NULL;
+                key_len = strlen(keys[i]);
+                val_len = strlen(vals[i]);
+                if (yyjson_unlikely(
+                    !unsafe_yyjson_mut_set_strn(key, keys[i], key_len) ||
+                    !unsafe_yyjson_mut_set_strn(val, vals[i], val_len))) {
+                    return NULL;
                 }
-                obj[count * 2].next = obj + 1;
-                obj->uni.ptr = obj + (count * 2 - 1);
+                unsafe_yyjson_mut_set_next(key, val);
+                if (prev) unsafe_yyjson_mut_set_next(prev, key);
+                else first = key;
+                prev = val;
+            }
+            if (prev) {
+                unsafe_yyjson_mut_set_next(prev, first);
+                unsafe_yyjson_mut_set_last(obj, key);
             }
             return obj;
         }
@@ -7135,29 +8985,38 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_with_kv(yyjson_mut_doc *doc,
     if (yyjson_likely(doc && ((count > 0 && count <
         (~(size_t)0) / sizeof(yyjson_mut_val) / 2 &&
         pairs) || (count == 0)))) {
-        yyjson_mut_val *obj = unsafe_yyjson_mut_val(doc, 1 + count * 2);
+        size_t run = unsafe_yyjson_mut_val_run(doc, 1 + count * 2);
+        yyjson_mut_val *obj = unsafe_yyjson_mut_val(doc, run);
         if (yyjson_likely(obj)) {
-            obj->tag = ((uint64_t)count << YYJSON_TAG_BIT) | YYJSON_TYPE_OBJ;
-            if (count > 0) {
-                size_t i;
-                for (i = 0; i < count; i++) {
-                    yyjson_mut_val *key = obj + (i * 2 + 1);
-                    yyjson_mut_val *val = obj + (i * 2 + 2);
-                    const char *key_str = pairs[i * 2 + 0];
-                    const char *val_str = pairs[i * 2 + 1];
-                    uint64_t key_len, val_len;
-                    if (yyjson_unlikely(!key_str || !val_str)) return NULL;
-                    key_len = (uint64_t)strlen(key_str);
-                    val_len = (uint64_t)strlen(val_str);
-                    key->tag = (key_len << YYJSON_TAG_BIT) | YYJSON_TYPE_STR;
-                    val->tag = (val_len << YYJSON_TAG_BIT) | YYJSON_TYPE_STR;
-                    key->uni.str = key_str;
-                    val->uni.str = val_str;
-                    key->next = val;
-                    val->next = val + 1;
+            yyjson_mut_val *key = NULL, *val = obj;
+            yyjson_mut_val *prev = NULL, *first = NULL;
+            size_t i, left;
+            unsafe_yyjson_mut_set_obj(obj, count);
+            for (i = 0; i < count; i++) {
+                const char *key_str = pairs[i * 2 + 0];
+                const char *val_str = pairs[i * 2 + 1];
+                size_t key_len, val_len;
+                if (yyjson_unlikely(!key_str || !val_str)) return NULL;
+                left = (count - i) * 2;
+                key = unsafe_yyjson_mut_val_next(doc, val, &run, left);
+                if (yyjson_unlikely(!key)) return NULL;
+                val = unsafe_yyjson_mut_val_next(doc, key, &run, left - 1);
+                if (yyjson_unlikely(!val)) return NULL;
+                key_len = strlen(key_str);
+                val_len = strlen(val_str);
+                if (yyjson_unlikely(
+                    !unsafe_yyjson_mut_set_strn(key, key_str, key_len) ||
+                    !unsafe_yyjson_mut_set_strn(val, val_str, val_len))) {
+                    return NULL;
                 }
-                obj[count * 2].next = obj + 1;
-                obj->uni.ptr = obj + (count * 2 - 1);
+                unsafe_yyjson_mut_set_next(key, val);
+                if (prev) unsafe_yyjson_mut_set_next(prev, key);
+                else first = key;
+                prev = val;
+            }
+            if (prev) {
+                unsafe_yyjson_mut_set_next(prev, first);
+                unsafe_yyjson_mut_set_last(obj, key);
             }
             return obj;
         }
@@ -7175,41 +9034,51 @@ yyjson_api_inline void unsafe_yyjson_mut_obj_add(yyjson_mut_val *obj,
                                                  yyjson_mut_val *key,
                                                  yyjson_mut_val *val,
                                                  size_t len) {
+    if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(obj))) {
+        unsafe_yyjson_mut_obj_idx_add(obj, key);
+    }
     if (yyjson_likely(len)) {
-        yyjson_mut_val *prev_val = ((yyjson_mut_val *)obj->uni.ptr)->next;
-        yyjson_mut_val *next_key = prev_val->next;
-        prev_val->next = key;
-        val->next = next_key;
+        yyjson_mut_val *prev_key = unsafe_yyjson_mut_get_last(obj);
+        yyjson_mut_val *prev_val = unsafe_yyjson_mut_get_next(prev_key);
+        yyjson_mut_val *next_key = unsafe_yyjson_mut_get_next(prev_val);
+        unsafe_yyjson_mut_set_next(prev_val, key);
+        unsafe_yyjson_mut_set_next(val, next_key);
     } else {
-        val->next = key;
+        unsafe_yyjson_mut_set_next(val, key);
     }
-    key->next = val;
-    obj->uni.ptr = (void *)key;
-    unsafe_yyjson_set_len(obj, len + 1);
+    unsafe_yyjson_mut_set_next(key, val);
+    unsafe_yyjson_mut_set_last(obj, key);
+    unsafe_yyjson_mut_set_len(obj, len + 1);
 }
 
 yyjson_api_inline yyjson_mut_val *unsafe_yyjson_mut_obj_remove(
     yyjson_mut_val *obj, const char *key, size_t key_len) {
-    size_t obj_len = unsafe_yyjson_get_len(obj);
+    size_t obj_len = unsafe_yyjson_mut_get_len(obj);
+    if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(obj))) {
+        return unsafe_yyjson_mut_obj_idx_remove(obj, key, key_len);
+    }
     if (obj_len) {
-        yyjson_mut_val *pre_key = (yyjson_mut_val *)obj->uni.ptr;
-        yyjson_mut_val *cur_key = pre_key->next->next;
+        yyjson_mut_val *pre_key = unsafe_yyjson_mut_get_last(obj);
+        yyjson_mut_val *cur_key = unsafe_yyjson_mut_get_next(pre_key);
         yyjson_mut_val *removed_item = NULL;
         size_t i;
+        cur_key = unsafe_yyjson_mut_get_next(cur_key);
         for (i = 0; i < obj_len; i++) {
-            if (unsafe_yyjson_equals_strn(cur_key, key, key_len)) {
-                if (!removed_item) removed_item = cur_key->next;
-                cur_key = cur_key->next->next;
-                pre_key->next->next = cur_key;
-                if (i + 1 == obj_len) obj->uni.ptr = pre_key;
+            yyjson_mut_val *cur_val = unsafe_yyjson_mut_get_next(cur_key);
+            if (unsafe_yyjson_mut_equals_strn(cur_key, key, key_len)) {
+                if (!removed_item) removed_item = cur_val;
+                cur_key = unsafe_yyjson_mut_get_next(cur_val);
+                unsafe_yyjson_mut_set_next(unsafe_yyjson_mut_get_next(pre_key),
+                                           cur_key);
+                if (i + 1 == obj_len) unsafe_yyjson_mut_set_last(obj, pre_key);
                 i--;
                 obj_len--;
             } else {
                 pre_key = cur_key;
-                cur_key = cur_key->next->next;
+                cur_key = unsafe_yyjson_mut_get_next(cur_val);
             }
         }
-        unsafe_yyjson_set_len(obj, obj_len);
+        unsafe_yyjson_mut_set_len(obj, obj_len);
         return removed_item;
     } else {
         return NULL;
@@ -7219,19 +9088,27 @@ yyjson_api_inline yyjson_mut_val *unsafe_yyjson_mut_obj_remove(
 yyjson_api_inline bool unsafe_yyjson_mut_obj_replace(yyjson_mut_val *obj,
                                                      yyjson_mut_val *key,
                                                      yyjson_mut_val *val) {
-    size_t key_len = unsafe_yyjson_get_len(key);
-    size_t obj_len = unsafe_yyjson_get_len(obj);
+    const char *key_str = unsafe_yyjson_mut_get_str(key);
+    size_t key_len = unsafe_yyjson_mut_get_len(key);
+    size_t obj_len = unsafe_yyjson_mut_get_len(obj);
+    if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(obj))) {
+        yyjson_mut_val *cur_val;
+        cur_val = unsafe_yyjson_mut_obj_idx_getn(obj, key_str, key_len);
+        if (cur_val) unsafe_yyjson_mut_set_val(cur_val, val);
+        return cur_val != NULL;
+    }
     if (obj_len) {
-        yyjson_mut_val *pre_key = (yyjson_mut_val *)obj->uni.ptr;
-        yyjson_mut_val *cur_key = pre_key->next->next;
+        yyjson_mut_val *pre_key = unsafe_yyjson_mut_get_last(obj);
+        yyjson_mut_val *cur_key = unsafe_yyjson_mut_get_next(pre_key);
         size_t i;
+        cur_key = unsafe_yyjson_mut_get_next(cur_key);
         for (i = 0; i < obj_len; i++) {
-            if (unsafe_yyjson_equals_strn(cur_key, key->uni.str, key_len)) {
-                cur_key->next->tag = val->tag;
-                cur_key->next->uni.u64 = val->uni.u64;
+            yyjson_mut_val *cur_val = unsafe_yyjson_mut_get_next(cur_key);
+            if (unsafe_yyjson_mut_equals_strn(cur_key, key_str, key_len)) {
+                unsafe_yyjson_mut_set_val(cur_val, val);
                 return true;
             } else {
-                cur_key = cur_key->next->next;
+                cur_key = unsafe_yyjson_mut_get_next(cur_val);
             }
         }
     }
@@ -7240,9 +9117,15 @@ yyjson_api_inline bool unsafe_yyjson_mut_obj_replace(yyjson_mut_val *obj,
 
 yyjson_api_inline void unsafe_yyjson_mut_obj_rotate(yyjson_mut_val *obj,
                                                     size_t idx) {
-    yyjson_mut_val *key = (yyjson_mut_val *)obj->uni.ptr;
-    while (idx-- > 0) key = key->next->next;
-    obj->uni.ptr = (void *)key;
+    yyjson_mut_val *key;
+    if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(obj))) {
+        unsafe_yyjson_mut_idx_drop(obj);
+    }
+    key = unsafe_yyjson_mut_get_last(obj);
+    while (idx-- > 0) {
+        key = unsafe_yyjson_mut_get_next(unsafe_yyjson_mut_get_next(key));
+    }
+    unsafe_yyjson_mut_set_last(obj, key);
 }
 
 yyjson_api_inline bool yyjson_mut_obj_add(yyjson_mut_val *obj,
@@ -7250,7 +9133,8 @@ yyjson_api_inline bool yyjson_mut_obj_add(yyjson_mut_val *obj,
                                           yyjson_mut_val *val) {
     if (yyjson_likely(yyjson_mut_is_obj(obj) &&
                       yyjson_mut_is_str(key) && val)) {
-        unsafe_yyjson_mut_obj_add(obj, key, val, unsafe_yyjson_get_len(obj));
+        size_t len = unsafe_yyjson_mut_get_len(obj);
+        unsafe_yyjson_mut_obj_add(obj, key, val, len);
         return true;
     }
     return false;
@@ -7260,19 +9144,26 @@ yyjson_api_inline bool yyjson_mut_obj_put(yyjson_mut_val *obj,
                                           yyjson_mut_val *key,
                                           yyjson_mut_val *val) {
     bool replaced = false;
+    const char *key_str;
     size_t key_len;
     yyjson_mut_obj_iter iter;
     yyjson_mut_val *cur_key;
     if (yyjson_unlikely(!yyjson_mut_is_obj(obj) ||
                         !yyjson_mut_is_str(key))) return false;
-    key_len = unsafe_yyjson_get_len(key);
+    if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(obj))) {
+        return unsafe_yyjson_mut_obj_idx_put(obj, key, val);
+    }
+    key_str = unsafe_yyjson_mut_get_str(key);
+    key_len = unsafe_yyjson_mut_get_len(key);
     yyjson_mut_obj_iter_init(obj, &iter);
     while ((cur_key = yyjson_mut_obj_iter_next(&iter)) != 0) {
-        if (unsafe_yyjson_equals_strn(cur_key, key->uni.str, key_len)) {
+        if (unsafe_yyjson_mut_equals_strn(cur_key, key_str, key_len)) {
             if (!replaced && val) {
+                yyjson_mut_val *cur_val = unsafe_yyjson_mut_get_next(cur_key);
                 replaced = true;
-                val->next = cur_key->next->next;
-                cur_key->next = val;
+                unsafe_yyjson_mut_set_next(val,
+                                           unsafe_yyjson_mut_get_next(cur_val));
+                unsafe_yyjson_mut_set_next(cur_key, val);
             } else {
                 yyjson_mut_obj_iter_remove(&iter);
             }
@@ -7288,13 +9179,13 @@ yyjson_api_inline bool yyjson_mut_obj_insert(yyjson_mut_val *obj,
                                              size_t idx) {
     if (yyjson_likely(yyjson_mut_is_obj(obj) &&
                       yyjson_mut_is_str(key) && val)) {
-        size_t len = unsafe_yyjson_get_len(obj);
+        size_t len = unsafe_yyjson_mut_get_len(obj);
         if (yyjson_likely(len >= idx)) {
             if (len > idx) {
-                void *ptr = obj->uni.ptr;
+                yyjson_mut_val *last = unsafe_yyjson_mut_get_last(obj);
                 unsafe_yyjson_mut_obj_rotate(obj, idx);
                 unsafe_yyjson_mut_obj_add(obj, key, val, len);
-                obj->uni.ptr = ptr;
+                unsafe_yyjson_mut_set_last(obj, last);
             } else {
                 unsafe_yyjson_mut_obj_add(obj, key, val, len);
             }
@@ -7307,8 +9198,8 @@ yyjson_api_inline bool yyjson_mut_obj_insert(yyjson_mut_val *obj,
 yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_remove(yyjson_mut_val *obj,
     yyjson_mut_val *key) {
     if (yyjson_likely(yyjson_mut_is_obj(obj) && yyjson_mut_is_str(key))) {
-        return unsafe_yyjson_mut_obj_remove(obj, key->uni.str,
-                                            unsafe_yyjson_get_len(key));
+        return unsafe_yyjson_mut_obj_remove(obj, unsafe_yyjson_mut_get_str(key),
+                                            unsafe_yyjson_mut_get_len(key));
     }
     return NULL;
 }
@@ -7332,7 +9223,10 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_remove_keyn(
 
 yyjson_api_inline bool yyjson_mut_obj_clear(yyjson_mut_val *obj) {
     if (yyjson_likely(yyjson_mut_is_obj(obj))) {
-        unsafe_yyjson_set_len(obj, 0);
+        if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(obj))) {
+            unsafe_yyjson_mut_idx_drop(obj);
+        }
+        unsafe_yyjson_mut_set_len(obj, 0);
         return true;
     }
     return false;
@@ -7351,7 +9245,7 @@ yyjson_api_inline bool yyjson_mut_obj_replace(yyjson_mut_val *obj,
 yyjson_api_inline bool yyjson_mut_obj_rotate(yyjson_mut_val *obj,
                                              size_t idx) {
     if (yyjson_likely(yyjson_mut_is_obj(obj) &&
-                      unsafe_yyjson_get_len(obj) > idx)) {
+                      unsafe_yyjson_mut_get_len(obj) > idx)) {
         unsafe_yyjson_mut_obj_rotate(obj, idx);
         return true;
     }
@@ -7368,14 +9262,11 @@ yyjson_api_inline bool yyjson_mut_obj_rotate(yyjson_mut_val *obj,
     if (yyjson_likely(doc && yyjson_mut_is_obj(obj) && _key)) { \
         yyjson_mut_val *key = unsafe_yyjson_mut_val(doc, 2); \
         if (yyjson_likely(key)) { \
-            size_t len = unsafe_yyjson_get_len(obj); \
+            size_t len = unsafe_yyjson_mut_get_len(obj); \
             yyjson_mut_val *val = key + 1; \
-            size_t key_len = strlen(_key); \
-            bool noesc = unsafe_yyjson_is_str_noesc(_key, key_len); \
-            key->tag = YYJSON_TYPE_STR; \
-            key->tag |= noesc ? YYJSON_SUBTYPE_NOESC : YYJSON_SUBTYPE_NONE; \
-            key->tag |= (uint64_t)strlen(_key) << YYJSON_TAG_BIT; \
-            key->uni.str = _key; \
+            if (yyjson_unlikely(!unsafe_yyjson_mut_set_str(key, _key))) { \
+                return false; \
+            } \
             func \
             unsafe_yyjson_mut_obj_add(obj, key, val, len); \
             return true; \
@@ -7386,68 +9277,68 @@ yyjson_api_inline bool yyjson_mut_obj_rotate(yyjson_mut_val *obj,
 yyjson_api_inline bool yyjson_mut_obj_add_null(yyjson_mut_doc *doc,
                                                yyjson_mut_val *obj,
                                                const char *_key) {
-    yyjson_mut_obj_add_func({ unsafe_yyjson_set_null(val); });
+    yyjson_mut_obj_add_func({ unsafe_yyjson_mut_set_null(val); });
 }
 
 yyjson_api_inline bool yyjson_mut_obj_add_true(yyjson_mut_doc *doc,
                                                yyjson_mut_val *obj,
                                                const char *_key) {
-    yyjson_mut_obj_add_func({ unsafe_yyjson_set_bool(val, true); });
+    yyjson_mut_obj_add_func({ unsafe_yyjson_mut_set_bool(val, true); });
 }
 
 yyjson_api_inline bool yyjson_mut_obj_add_false(yyjson_mut_doc *doc,
                                                 yyjson_mut_val *obj,
                                                 const char *_key) {
-    yyjson_mut_obj_add_func({ unsafe_yyjson_set_bool(val, false); });
+    yyjson_mut_obj_add_func({ unsafe_yyjson_mut_set_bool(val, false); });
 }
 
 yyjson_api_inline bool yyjson_mut_obj_add_bool(yyjson_mut_doc *doc,
                                                yyjson_mut_val *obj,
                                                const char *_key,
                                                bool _val) {
-    yyjson_mut_obj_add_func({ unsafe_yyjson_set_bool(val, _val); });
+    yyjson_mut_obj_add_func({ unsafe_yyjson_mut_set_bool(val, _val); });
 }
 
 yyjson_api_inline bool yyjson_mut_obj_add_uint(yyjson_mut_doc *doc,
                                                yyjson_mut_val *obj,
                                                const char *_key,
                                                uint64_t _val) {
-    yyjson_mut_obj_add_func({ unsafe_yyjson_set_uint(val, _val); });
+    yyjson_mut_obj_add_func({ unsafe_yyjson_mut_set_uint(val, _val); });
 }
 
 yyjson_api_inline bool yyjson_mut_obj_add_sint(yyjson_mut_doc *doc,
                                                yyjson_mut_val *obj,
                                                const char *_key,
                                                int64_t _val) {
-    yyjson_mut_obj_add_func({ unsafe_yyjson_set_sint(val, _val); });
+    yyjson_mut_obj_add_func({ unsafe_yyjson_mut_set_sint(val, _val); });
 }
 
 yyjson_api_inline bool yyjson_mut_obj_add_int(yyjson_mut_doc *doc,
                                               yyjson_mut_val *obj,
                                               const char *_key,
                                               int64_t _val) {
-    yyjson_mut_obj_add_func({ unsafe_yyjson_set_sint(val, _val); });
+    yyjson_mut_obj_add_func({ unsafe_yyjson_mut_set_sint(val, _val); });
 }
 
 yyjson_api_inline bool yyjson_mut_obj_add_float(yyjson_mut_doc *doc,
                                                 yyjson_mut_val *obj,
                                                 const char *_key,
                                                 float _val) {
-    yyjson_mut_obj_add_func({ unsafe_yyjson_set_float(val, _val); });
+    yyjson_mut_obj_add_func({ unsafe_yyjson_mut_set_float(val, _val); });
 }
 
 yyjson_api_inline bool yyjson_mut_obj_add_double(yyjson_mut_doc *doc,
                                                  yyjson_mut_val *obj,
                                                  const char *_key,
                                                  double _val) {
-    yyjson_mut_obj_add_func({ unsafe_yyjson_set_double(val, _val); });
+    yyjson_mut_obj_add_func({ unsafe_yyjson_mut_set_double(val, _val); });
 }
 
 yyjson_api_inline bool yyjson_mut_obj_add_real(yyjson_mut_doc *doc,
                                                yyjson_mut_val *obj,
                                                const char *_key,
                                                double _val) {
-    yyjson_mut_obj_add_func({ unsafe_yyjson_set_real(val, _val); });
+    yyjson_mut_obj_add_func({ unsafe_yyjson_mut_set_real(val, _val); });
 }
 
 yyjson_api_inline bool yyjson_mut_obj_add_str(yyjson_mut_doc *doc,
@@ -7456,11 +9347,9 @@ yyjson_api_inline bool yyjson_mut_obj_add_str(yyjson_mut_doc *doc,
                                               const char *_val) {
     if (yyjson_unlikely(!_val)) return false;
     yyjson_mut_obj_add_func({
-        size_t val_len = strlen(_val);
-        bool val_noesc = unsafe_yyjson_is_str_noesc(_val, val_len);
-        val->tag = ((uint64_t)strlen(_val) << YYJSON_TAG_BIT) | YYJSON_TYPE_STR;
-        val->tag |= val_noesc ? YYJSON_SUBTYPE_NOESC : YYJSON_SUBTYPE_NONE;
-        val->uni.str = _val;
+        if (yyjson_unlikely(!unsafe_yyjson_mut_set_str(val, _val))) {
+            return false;
+        }
     });
 }
 
@@ -7471,8 +9360,9 @@ yyjson_api_inline bool yyjson_mut_obj_add_strn(yyjson_mut_doc *doc,
                                                size_t _len) {
     if (yyjson_unlikely(!_val)) return false;
     yyjson_mut_obj_add_func({
-        val->tag = ((uint64_t)_len << YYJSON_TAG_BIT) | YYJSON_TYPE_STR;
-        val->uni.str = _val;
+        if (yyjson_unlikely(!unsafe_yyjson_mut_set_strn(val, _val, _len))) {
+            return false;
+        }
     });
 }
 
@@ -7483,9 +9373,9 @@ yyjson_api_inline bool yyjson_mut_obj_add_strcpy(yyjson_mut_doc *doc,
     if (yyjson_unlikely(!_val)) return false;
     yyjson_mut_obj_add_func({
         size_t _len = strlen(_val);
-        val->uni.str = unsafe_yyjson_mut_strncpy(doc, _val, _len);
-        if (yyjson_unlikely(!val->uni.str)) return false;
-        val->tag = ((uint64_t)_len << YYJSON_TAG_BIT) | YYJSON_TYPE_STR;
+        char *_cpy = unsafe_yyjson_mut_strncpy(doc, _val, _len);
+        if (yyjson_unlikely(!_cpy)) return false;
+        unsafe_yyjson_mut_set_strn(val, _cpy, _len);
     });
 }
 
@@ -7496,9 +9386,9 @@ yyjson_api_inline bool yyjson_mut_obj_add_strncpy(yyjson_mut_doc *doc,
                                                   size_t _len) {
     if (yyjson_unlikely(!_val)) return false;
     yyjson_mut_obj_add_func({
-        val->uni.str = unsafe_yyjson_mut_strncpy(doc, _val, _len);
-        if (yyjson_unlikely(!val->uni.str)) return false;
-        val->tag = ((uint64_t)_len << YYJSON_TAG_BIT) | YYJSON_TYPE_STR;
+        char *_cpy = unsafe_yyjson_mut_strncpy(doc, _val, _len);
+        if (yyjson_unlikely(!_cpy)) return false;
+        unsafe_yyjson_mut_set_strn(val, _cpy, _len);
     });
 }
 
@@ -7539,10 +9429,13 @@ yyjson_api_inline yyjson_mut_val *yyjson_mut_obj_remove_strn(
         yyjson_mut_val *key;
         yyjson_mut_obj_iter iter;
         yyjson_mut_val *val_removed = NULL;
+        if (yyjson_unlikely(unsafe_yyjson_mut_is_indexed(obj))) {
+            return unsafe_yyjson_mut_obj_idx_remove(obj, _key, _len);
+        }
         yyjson_mut_obj_iter_init(obj, &iter);
         while ((key = yyjson_mut_obj_iter_next(&iter)) != NULL) {
-            if (unsafe_yyjson_equals_strn(key, _key, _len)) {
-                if (!val_removed) val_removed = key->next;
+            if (unsafe_yyjson_mut_equals_strn(key, _key, _len)) {
+                if (!val_removed) val_removed = unsafe_yyjson_mut_get_next(key);
                 yyjson_mut_obj_iter_remove(&iter);
             }
         }
@@ -7570,9 +9463,12 @@ yyjson_api_inline bool yyjson_mut_obj_rename_keyn(yyjson_mut_doc *doc,
     yyjson_mut_val *old_key;
     yyjson_mut_obj_iter iter;
     if (!doc || !obj || !key || !new_key) return false;
+    if (yyjson_mut_is_obj(obj) && unsafe_yyjson_mut_is_indexed(obj)) {
+        unsafe_yyjson_mut_idx_drop(obj);
+    }
     yyjson_mut_obj_iter_init(obj, &iter);
     while ((old_key = yyjson_mut_obj_iter_next(&iter))) {
-        if (unsafe_yyjson_equals_strn((void *)old_key, key, len)) {
+        if (unsafe_yyjson_mut_equals_strn(old_key, key, len)) {
             if (!cpy_key) {
                 cpy_key = unsafe_yyjson_mut_strncpy(doc, new_key, new_len);
                 if (!cpy_key) return false;
@@ -8129,51 +10025,61 @@ yyjson_api_inline bool yyjson_ptr_ctx_append(yyjson_ptr_ctx *ctx,
     yyjson_mut_val *ctn, *pre_key, *pre_val, *cur_key, *cur_val;
     if (!ctx || !ctx->ctn || !val) return false;
     ctn = ctx->ctn;
+    if (unsafe_yyjson_mut_is_indexed(ctn)) unsafe_yyjson_mut_idx_drop(ctn);
 
     if (yyjson_mut_is_obj(ctn)) {
         if (!key) return false;
-        key->next = val;
+        unsafe_yyjson_mut_set_next(key, val);
         pre_key = ctx->pre;
-        if (unsafe_yyjson_get_len(ctn) == 0) {
-            val->next = key;
-            ctn->uni.ptr = key;
+        if (unsafe_yyjson_mut_get_len(ctn) == 0) {
+            unsafe_yyjson_mut_set_next(val, key);
+            unsafe_yyjson_mut_set_last(ctn, key);
             ctx->pre = key;
         } else if (!pre_key) {
-            pre_key = (yyjson_mut_val *)ctn->uni.ptr;
-            pre_val = pre_key->next;
-            val->next = pre_val->next;
-            pre_val->next = key;
-            ctn->uni.ptr = key;
+            pre_key = unsafe_yyjson_mut_get_last(ctn);
+            pre_val = unsafe_yyjson_mut_get_next(pre_key);
+            unsafe_yyjson_mut_set_next(val,
+                                       unsafe_yyjson_mut_get_next(pre_val));
+            unsafe_yyjson_mut_set_next(pre_val, key);
+            unsafe_yyjson_mut_set_last(ctn, key);
             ctx->pre = pre_key;
         } else {
-            cur_key = pre_key->next->next;
-            cur_val = cur_key->next;
-            val->next = cur_val->next;
-            cur_val->next = key;
-            if (ctn->uni.ptr == cur_key) ctn->uni.ptr = key;
+            cur_key = unsafe_yyjson_mut_get_next(pre_key);
+            cur_key = unsafe_yyjson_mut_get_next(cur_key);
+            cur_val = unsafe_yyjson_mut_get_next(cur_key);
+            unsafe_yyjson_mut_set_next(val,
+                                       unsafe_yyjson_mut_get_next(cur_val));
+            unsafe_yyjson_mut_set_next(cur_val, key);
+            if (unsafe_yyjson_mut_get_last(ctn) == cur_key) {
+                unsafe_yyjson_mut_set_last(ctn, key);
+            }
             ctx->pre = cur_key;
         }
     } else {
         pre_val = ctx->pre;
-        if (unsafe_yyjson_get_len(ctn) == 0) {
-            val->next = val;
-            ctn->uni.ptr = val;
+        if (unsafe_yyjson_mut_get_len(ctn) == 0) {
+            unsafe_yyjson_mut_set_next(val, val);
+            unsafe_yyjson_mut_set_last(ctn, val);
             ctx->pre = val;
         } else if (!pre_val) {
-            pre_val = (yyjson_mut_val *)ctn->uni.ptr;
-            val->next = pre_val->next;
-            pre_val->next = val;
-            ctn->uni.ptr = val;
+            pre_val = unsafe_yyjson_mut_get_last(ctn);
+            unsafe_yyjson_mut_set_next(val,
+                                       unsafe_yyjson_mut_get_next(pre_val));
+            unsafe_yyjson_mut_set_next(pre_val, val);
+            unsafe_yyjson_mut_set_last(ctn, val);
             ctx->pre = pre_val;
         } else {
-            cur_val = pre_val->next;
-            val->next = cur_val->next;
-            cur_val->next = val;
-            if (ctn->uni.ptr == cur_val) ctn->uni.ptr = val;
+            cur_val = unsafe_yyjson_mut_get_next(pre_val);
+            unsafe_yyjson_mut_set_next(val,
+                                       unsafe_yyjson_mut_get_next(cur_val));
+            unsafe_yyjson_mut_set_next(cur_val, val);
+            if (unsafe_yyjson_mut_get_last(ctn) == cur_val) {
+                unsafe_yyjson_mut_set_last(ctn, val);
+            }
             ctx->pre = cur_val;
         }
     }
-    unsafe_yyjson_inc_len(ctn);
+    unsafe_yyjson_mut_set_len(ctn, unsafe_yyjson_mut_get_len(ctn) + 1);
     return true;
 }
 
@@ -8182,26 +10088,30 @@ yyjson_api_inline bool yyjson_ptr_ctx_replace(yyjson_ptr_ctx *ctx,
     yyjson_mut_val *ctn, *pre_key, *cur_key, *pre_val, *cur_val;
     if (!ctx || !ctx->ctn || !ctx->pre || !val) return false;
     ctn = ctx->ctn;
+    if (unsafe_yyjson_mut_is_indexed(ctn)) unsafe_yyjson_mut_idx_drop(ctn);
     if (yyjson_mut_is_obj(ctn)) {
         pre_key = ctx->pre;
-        pre_val = pre_key->next;
-        cur_key = pre_val->next;
-        cur_val = cur_key->next;
+        pre_val = unsafe_yyjson_mut_get_next(pre_key);
+        cur_key = unsafe_yyjson_mut_get_next(pre_val);
+        cur_val = unsafe_yyjson_mut_get_next(cur_key);
         /* replace current value */
-        cur_key->next = val;
-        val->next = cur_val->next;
+        unsafe_yyjson_mut_set_next(cur_key, val);
+        unsafe_yyjson_mut_set_next(val, unsafe_yyjson_mut_get_next(cur_val));
         ctx->old = cur_val;
     } else {
         pre_val = ctx->pre;
-        cur_val = pre_val->next;
+        cur_val = unsafe_yyjson_mut_get_next(pre_val);
         /* replace current value */
         if (pre_val != cur_val) {
-            val->next = cur_val->next;
-            pre_val->next = val;
-            if (ctn->uni.ptr == cur_val) ctn->uni.ptr = val;
+            unsafe_yyjson_mut_set_next(val,
+                                       unsafe_yyjson_mut_get_next(cur_val));
+            unsafe_yyjson_mut_set_next(pre_val, val);
+            if (unsafe_yyjson_mut_get_last(ctn) == cur_val) {
+                unsafe_yyjson_mut_set_last(ctn, val);
+            }
         } else {
-            val->next = val;
-            ctn->uni.ptr = val;
+            unsafe_yyjson_mut_set_next(val, val);
+            unsafe_yyjson_mut_set_last(ctn, val);
             ctx->pre = val;
         }
         ctx->old = cur_val;
@@ -8214,28 +10124,34 @@ yyjson_api_inline bool yyjson_ptr_ctx_remove(yyjson_ptr_ctx *ctx) {
     size_t len;
     if (!ctx || !ctx->ctn || !ctx->pre) return false;
     ctn = ctx->ctn;
+    if (unsafe_yyjson_mut_is_indexed(ctn)) unsafe_yyjson_mut_idx_drop(ctn);
     if (yyjson_mut_is_obj(ctn)) {
         pre_key = ctx->pre;
-        pre_val = pre_key->next;
-        cur_key = pre_val->next;
-        cur_val = cur_key->next;
+        pre_val = unsafe_yyjson_mut_get_next(pre_key);
+        cur_key = unsafe_yyjson_mut_get_next(pre_val);
+        cur_val = unsafe_yyjson_mut_get_next(cur_key);
         /* remove current key-value */
-        pre_val->next = cur_val->next;
-        if (ctn->uni.ptr == cur_key) ctn->uni.ptr = pre_key;
+        unsafe_yyjson_mut_set_next(pre_val,
+                                   unsafe_yyjson_mut_get_next(cur_val));
+        if (unsafe_yyjson_mut_get_last(ctn) == cur_key) {
+            unsafe_yyjson_mut_set_last(ctn, pre_key);
+        }
         ctx->pre = NULL;
         ctx->old = cur_val;
     } else {
         pre_val = ctx->pre;
-        cur_val = pre_val->next;
+        cur_val = unsafe_yyjson_mut_get_next(pre_val);
         /* remove current key-value */
-        pre_val->next = cur_val->next;
-        if (ctn->uni.ptr == cur_val) ctn->uni.ptr = pre_val;
+        unsafe_yyjson_mut_set_next(pre_val,
+                                   unsafe_yyjson_mut_get_next(cur_val));
+        if (unsafe_yyjson_mut_get_last(ctn) == cur_val) {
+            unsafe_yyjson_mut_set_last(ctn, pre_val);
+        }
         ctx->pre = NULL;
         ctx->old = cur_val;
     }
-    len = unsafe_yyjson_get_len(ctn) - 1;
-    if (len == 0) ctn->uni.ptr = NULL;
-    unsafe_yyjson_set_len(ctn, len);
+    len = unsafe_yyjson_mut_get_len(ctn) - 1;
+    unsafe_yyjson_mut_set_len(ctn, len);
     return true;
 }
 
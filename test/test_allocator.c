@@ -2,6 +2,9 @@
 
 #include "yyjson.h"
 #include "yy_test_utils.h"
+#if YY_TEST_USE_PTHREADS
+#include <pthread.h>
+#endif
 
 #define NUM_PTR 16
 #define BUF_SIZE 1024
@@ -311,6 +314,7 @@ static void test_alc_dyn(void) {
     yy_rand_reset(0);
     memset(ptr, 0, sizeof(ptr));
     memset(ptr_size, 0, sizeof(ptr_size));
+    usize malloc_count = 0;
     for (int p = 0; p < 10000; p++) {
         int i = yy_rand_u32_uniform(NUM_PTR);
         usize inc = yy_rand_u32_uniform(0x4000) + 1;
@@ -332,12 +336,473 @@ static void test_alc_dyn(void) {
             }
         } else {
             tmp = alc->malloc(alc->ctx, inc);
+            malloc_count++;
             if (tmp) memset(tmp, 0xFF, inc);
             ptr[i] = tmp;
             ptr_size[i] = tmp ? inc : 0;
         }
     }
+    {
+        yyjson_alc_dyn_stats stats;
+        usize used = 0;
+        for (int i = 0; i < NUM_PTR; i++) used += ptr_size[i];
+        yy_assert(yyjson_alc_dyn_get_stats(alc, &stats));
+        yy_assert(stats.used_size == used);
+        yy_assert(stats.held_size >= used);
+        yy_assert(stats.alloc_count == malloc_count);
+        yy_assert(stats.hit_count > 0);
+        yy_assert(stats.hit_count < stats.alloc_count);
+        yy_assert(stats.grow_count > 0);
+    }
     yyjson_alc_dyn_free(alc);
+    
+    
+    // statistics
+    {
+        yyjson_alc_dyn_stats stats;
+        yyjson_alc pool;
+        char buf[BUF_SIZE];
+        void *tmp;
+        
+        yy_assert(yyjson_alc_pool_init(&pool, buf, sizeof(buf)));
+        yy_assert(!yyjson_alc_dyn_get_stats(&pool, &stats));
+        yy_assert(!yyjson_alc_dyn_get_stats(NULL, &stats));
+        
+        alc = yyjson_alc_dyn_new();
+        yy_assert(!yyjson_alc_dyn_get_stats(alc, NULL));
+        yy_assert(yyjson_alc_dyn_get_stats(alc, &stats));
+        yy_assert(stats.held_size == 0 && stats.used_size == 0);
+        yy_assert(stats.alloc_count == 0 && stats.hit_count == 0);
+        yy_assert(stats.grow_count == 0);
+        
+        // the chunk size is a power of 2, at least 4KB
+        ptr[0] = alc->malloc(alc->ctx, 100);
+        yyjson_alc_dyn_get_stats(alc, &stats);
+        yy_assert(stats.held_size == 0x1000 && stats.used_size == 100);
+        yy_assert(stats.alloc_count == 1 && stats.hit_count == 0);
+        ptr[1] = alc->malloc(alc->ctx, 0x1000);
+        yyjson_alc_dyn_get_stats(alc, &stats);
+        yy_assert(stats.held_size == 0x3000 && stats.used_size == 0x1064);
+        
+        // realloc in the same chunk
+        tmp = alc->realloc(alc->ctx, ptr[0], 100, 200);
+        yy_assert(tmp == ptr[0]);
+        yyjson_alc_dyn_get_stats(alc, &stats);
+        yy_assert(stats.held_size == 0x3000 && stats.used_size == 0x10C8);
+        yy_assert(stats.alloc_count == 2 && stats.grow_count == 0);
+        
+        // realloc to a larger chunk
+        memset(ptr[0], 0xAB, 200);
+        ptr[0] = alc->realloc(alc->ctx, ptr[0], 200, 0x2000);
+        yy_assert(ptr[0] && ((u8 *)ptr[0])[199] == 0xAB);
+        yyjson_alc_dyn_get_stats(alc, &stats);
+        yy_assert(stats.held_size == 0x6000 && stats.used_size == 0x3000);
+        yy_assert(stats.alloc_count == 2 && stats.grow_count == 1);
+        
+        // reuse the smallest unused chunk that is large enough
+        alc->free(alc->ctx, ptr[0]);
+        alc->free(alc->ctx, ptr[1]);
+        yyjson_alc_dyn_get_stats(alc, &stats);
+        yy_assert(stats.held_size == 0x6000 && stats.used_size == 0);
+        tmp = alc->malloc(alc->ctx, 0x1000); // 8KB chunk
+        yy_assert(tmp == ptr[1]);
+        tmp = alc->malloc(alc->ctx, 100); // 16KB chunk
+        yy_assert(tmp == ptr[0]);
+        yyjson_alc_dyn_get_stats(alc, &stats);
+        yy_assert(stats.held_size == 0x6000 && stats.used_size == 0x1064);
+        yy_assert(stats.alloc_count == 4 && stats.hit_count == 2);
+        
+        // resize the largest unused chunk if no chunk is large enough
+        alc->free(alc->ctx, ptr[0]);
+        ptr[0] = alc->malloc(alc->ctx, 0x10000);
+        yy_assert(ptr[0]);
+        yyjson_alc_dyn_get_stats(alc, &stats);
+        yy_assert(stats.held_size == 0x22000);
+        yy_assert(stats.alloc_count == 5 && stats.hit_count == 2);
+        yy_assert(stats.grow_count == 1);
+        yyjson_alc_dyn_free(alc);
+    }
+}
+
+/// Fill the memory with a pattern of the seed.
+static void alc_mem_fill(void *ptr, usize len, usize seed) {
+    u8 *cur = (u8 *)ptr;
+    for (usize i = 0; i < len; i++) cur[i] = (u8)(seed + i * 7);
+}
+
+/// Returns whether the memory contains the pattern of the seed.
+static bool alc_mem_check(void *ptr, usize len, usize seed) {
+    u8 *cur = (u8 *)ptr;
+    for (usize i = 0; i < len; i++) {
+        if (cur[i] != (u8)(seed + i * 7)) return false;
+    }
+    return true;
+}
+
+/// Random malloc/realloc/free with a shared allocator, returns the errors.
+static usize alc_mt_random(yyjson_alc *alc, u32 seed, int count) {
+    void *ptr[NUM_PTR];
+    usize ptr_size[NUM_PTR];
+    usize err = 0;
+    u32 rnd = seed * 2654435761u + 1;
+    memset(ptr, 0, sizeof(ptr));
+    memset(ptr_size, 0, sizeof(ptr_size));
+    for (int p = 0; p < count; p++) {
+        rnd = rnd * 1103515245u + 12345u;
+        int i = (int)((rnd >> 16) % NUM_PTR);
+        usize inc = (usize)((rnd >> 4) % 0x4000) + 1;
+        usize key = (usize)seed * NUM_PTR + (usize)i;
+        if (ptr[i]) {
+            if (!alc_mem_check(ptr[i], ptr_size[i], key)) err++;
+            if ((rnd >> 28) == 0) {
+                void *tmp = alc->realloc(alc->ctx, ptr[i], ptr_size[i],
+                                         ptr_size[i] + inc);
+                if (!tmp) { err++; continue; }
+                if (!alc_mem_check(tmp, ptr_size[i], key)) err++;
+                ptr[i] = tmp;
+                ptr_size[i] += inc;
+                alc_mem_fill(ptr[i], ptr_size[i], key);
+            } else {
+                alc->free(alc->ctx, ptr[i]);
+                ptr[i] = NULL;
+                ptr_size[i] = 0;
+            }
+        } else {
+            ptr[i] = alc->malloc(alc->ctx, inc);
+            if (!ptr[i]) { err++; continue; }
+            ptr_size[i] = inc;
+            alc_mem_fill(ptr[i], inc, key);
+        }
+    }
+    for (int i = 0; i < NUM_PTR; i++) {
+        if (!ptr[i]) continue;
+        if (!alc_mem_check(ptr[i], ptr_size[i],
+                           (usize)seed * NUM_PTR + (usize)i)) err++;
+        alc->free(alc->ctx, ptr[i]);
+    }
+    return err;
+}
+
+/// Read and write JSON with a shared allocator, returns the errors.
+static usize alc_mt_json(yyjson_alc *alc, int count) {
+    const char *json = "{\"id\":12345,\"name\":\"yyjson\",\"list\":"
+                       "[1,2.5,true,null,\"str\",{\"a\":[]}]}";
+    usize err = 0;
+    for (int p = 0; p < count; p++) {
+        yyjson_doc *doc = yyjson_read_opts((char *)json, strlen(json), 0,
+                                           alc, NULL);
+        yyjson_mut_doc *mdoc = yyjson_doc_mut_copy(doc, alc);
+        usize len;
+        char *str = yyjson_mut_write_opts(mdoc, 0, alc, &len, NULL);
+        if (!doc || !mdoc || !str || strcmp(str, json) != 0) err++;
+        if (str) alc->free(alc->ctx, str);
+        yyjson_mut_doc_free(mdoc);
+        yyjson_doc_free(doc);
+    }
+    return err;
+}
+
+#if YY_TEST_USE_PTHREADS
+typedef struct {
+    yyjson_alc *alc;
+    u32 seed;
+    usize err;
+} alc_mt_task;
+
+static void *alc_mt_thread(void *arg) {
+    alc_mt_task *task = (alc_mt_task *)arg;
+    task->err = alc_mt_random(task->alc, task->seed, 20000);
+    task->err += alc_mt_json(task->alc, 2000);
+    return NULL;
+}
+#endif
+
+static void test_alc_mt(void) {
+    yyjson_alc *alc;
+    void *ptr;
+    
+    
+    // new and destroy
+    alc = yyjson_alc_mt_new(0);
+    yy_assert(alc);
+    yy_assert(!alc->malloc(alc->ctx, SIZE_MAX));
+    yy_assert(!alc->malloc(alc->ctx, SIZE_MAX - 16));
+    yy_assert(!alc->malloc(alc->ctx, SIZE_MAX / 2 + 1));
+    yyjson_alc_mt_free(alc);
+    yyjson_alc_mt_free(NULL);
+    alc = yyjson_alc_mt_new(100000);
+    yy_assert(alc);
+    yyjson_alc_mt_free(alc);
+    
+    
+    // new, alloc, destroy without free
+    alc = yyjson_alc_mt_new(1);
+    ptr = alc->malloc(alc->ctx, 1);
+    yy_assert(ptr);
+    memset(ptr, 0xFF, 1);
+    ptr = alc->malloc(alc->ctx, 0x100000);
+    yy_assert(ptr);
+    memset(ptr, 0xFF, 0x100000);
+    yyjson_alc_mt_free(alc);
+    
+    
+    // reuse freed memory
+    alc = yyjson_alc_mt_new(1);
+    ptr = alc->malloc(alc->ctx, 0x100);
+    yy_assert(ptr);
+    alc->free(alc->ctx, ptr);
+    yy_assert(alc->malloc(alc->ctx, 0x180) == ptr);
+    yy_assert(alc->realloc(alc->ctx, ptr, 0x180, 0x1E0) == ptr);
+    alc->free(alc->ctx, ptr);
+    yyjson_alc_mt_free(alc);
+    
+    
+    // random, on one thread
+    for (usize num = 1; num <= 4; num++) {
+        alc = yyjson_alc_mt_new(num);
+        yy_assert(alc_mt_random(alc, 0, 10000) == 0);
+        yy_assert(alc_mt_random(alc, 1, 10000) == 0);
+        yy_assert(alc_mt_json(alc, 100) == 0);
+        yyjson_alc_mt_free(alc);
+    }
+    
+    
+#if YY_TEST_USE_PTHREADS
+    // random, on multiple threads sharing one allocator
+    for (usize num = 1; num <= 8; num *= 2) {
+        pthread_t threads[8];
+        alc_mt_task tasks[8];
+        alc = yyjson_alc_mt_new(num);
+        for (u32 i = 0; i < 8; i++) {
+            tasks[i].alc = alc;
+            tasks[i].seed = i;
+            tasks[i].err = 0;
+            yy_assert(!pthread_create(&threads[i], NULL,
+                                      alc_mt_thread, &tasks[i]));
+        }
+        for (u32 i = 0; i < 8; i++) {
+            pthread_join(threads[i], NULL);
+            yy_assert(tasks[i].err == 0);
+        }
+        yyjson_alc_mt_free(alc);
+    }
+#endif
+}
+
+static void test_alc_limit(void) {
+    yyjson_alc alc, dyn_alc;
+    yyjson_alc_limit lim;
+    void *ptr[4];
+    
+    
+    // init
+    yy_assert(!yyjson_alc_limit_init(NULL, &lim, NULL, 100));
+    yy_assert(!yyjson_alc_limit_init(&alc, NULL, NULL, 100));
+    yy_assert(!alc.malloc(alc.ctx, 1));
+    yy_assert(yyjson_alc_limit_init(&alc, &lim, NULL, 100));
+    yy_assert(lim.limit == 100 && lim.cur_size == 0 && lim.peak_size == 0);
+    yy_assert(lim.alloc_count == 0 && lim.fail_count == 0);
+    
+    
+    // malloc, realloc and free within the limit
+    ptr[0] = alc.malloc(alc.ctx, 60);
+    yy_assert(ptr[0]);
+    memset(ptr[0], 0xAB, 60);
+    yy_assert(lim.cur_size == 60 && lim.peak_size == 60);
+    yy_assert(!alc.malloc(alc.ctx, 41));
+    yy_assert(lim.fail_count == 1);
+    ptr[1] = alc.malloc(alc.ctx, 40);
+    yy_assert(ptr[1]);
+    yy_assert(lim.cur_size == 100 && lim.peak_size == 100);
+    yy_assert(!alc.malloc(alc.ctx, 1));
+    yy_assert(!alc.malloc(alc.ctx, SIZE_MAX));
+    yy_assert(lim.fail_count == 3);
+    alc.free(alc.ctx, ptr[1]);
+    yy_assert(lim.cur_size == 60 && lim.peak_size == 100);
+    yy_assert(!alc.realloc(alc.ctx, ptr[0], 60, 101));
+    yy_assert(lim.fail_count == 4);
+    ptr[0] = alc.realloc(alc.ctx, ptr[0], 60, 100);
+    yy_assert(ptr[0] && ((u8 *)ptr[0])[59] == 0xAB);
+    yy_assert(lim.cur_size == 100 && lim.alloc_count == 3);
+    alc.free(alc.ctx, ptr[0]);
+    yy_assert(lim.cur_size == 0 && lim.peak_size == 100);
+    
+    // change the limit
+    lim.limit = SIZE_MAX;
+    yy_assert(!alc.malloc(alc.ctx, SIZE_MAX));
+    yy_assert(!alc.malloc(alc.ctx, SIZE_MAX - 8));
+    lim.limit = 10;
+    yy_assert(!alc.malloc(alc.ctx, 11));
+    
+    
+    // wrap a dynamic allocator
+    {
+        yyjson_alc *dyn = yyjson_alc_dyn_new();
+        yyjson_alc_dyn_stats stats;
+        yy_assert(yyjson_alc_limit_init(&alc, &lim, dyn, 0x10000));
+        dyn_alc = *dyn;
+        ptr[0] = alc.malloc(alc.ctx, 0x100);
+        ptr[1] = alc.malloc(alc.ctx, 0x200);
+        yy_assert(ptr[0] && ptr[1]);
+        yy_assert(yyjson_alc_dyn_get_stats(&dyn_alc, &stats));
+        yy_assert(stats.used_size == 0x300 + 2 * 2 * sizeof(size_t));
+        yy_assert(lim.cur_size == 0x300);
+        alc.free(alc.ctx, ptr[0]);
+        alc.free(alc.ctx, ptr[1]);
+        yy_assert(lim.cur_size == 0);
+        yyjson_alc_dyn_free(dyn);
+    }
+    
+    
+    // read and write JSON with a budget
+    {
+        const char *json = "{\"a\":[1,2,3,\"abcdefghijklmnopqrstuvwxyz\"],"
+                           "\"b\":{\"c\":true,\"d\":null}}";
+        usize len = strlen(json), max = 0, limit;
+        yyjson_read_err err;
+        yyjson_write_err werr;
+        yyjson_doc *doc;
+        yyjson_mut_doc *mdoc;
+        char *str;
+        
+        yyjson_alc_limit_init(&alc, &lim, NULL, 0x10000);
+        doc = yyjson_read_opts((char *)json, len, 0, &alc, &err);
+        yy_assert(doc);
+        yy_assert(lim.cur_size > 0 && lim.cur_size == lim.peak_size);
+        str = yyjson_write_opts(doc, 0, &alc, NULL, &werr);
+        yy_assert(str && strcmp(str, json) == 0);
+        alc.free(alc.ctx, str);
+        max = lim.peak_size;
+        yyjson_doc_free(doc);
+        yy_assert(lim.cur_size == 0);
+        
+        // the reader fails cleanly when the budget is too small
+        for (limit = 0; limit < max; limit += 8) {
+            yyjson_alc_limit_init(&alc, &lim, NULL, limit);
+            doc = yyjson_read_opts((char *)json, len, 0, &alc, &err);
+            if (doc) {
+                str = yyjson_write_opts(doc, 0, &alc, NULL, &werr);
+                yy_assert(!str);
+                yy_assert(werr.code == YYJSON_WRITE_ERROR_MEMORY_ALLOCATION);
+                yyjson_doc_free(doc);
+            } else {
+                yy_assert(err.code == YYJSON_READ_ERROR_MEMORY_ALLOCATION);
+            }
+            yy_assert(lim.fail_count > 0);
+            yy_assert(lim.cur_size == 0);
+            yy_assert(lim.peak_size <= limit);
+        }
+        
+        // the mutable document fails cleanly when the budget is too small
+        yyjson_alc_limit_init(&alc, &lim, NULL, 0x1000);
+        mdoc = yyjson_mut_doc_new(&alc);
+        yy_assert(mdoc);
+        {
+            yyjson_mut_val *arr = yyjson_mut_arr(mdoc);
+            bool failed = false;
+            for (int i = 0; i < 10000 && !failed; i++) {
+                failed = !yyjson_mut_arr_add_strcpy(mdoc, arr, "string");
+            }
+            yy_assert(failed);
+            yy_assert(lim.fail_count > 0 && lim.peak_size <= 0x1000);
+        }
+        yyjson_mut_doc_free(mdoc);
+        yy_assert(lim.cur_size == 0);
+    }
+}
+
+static void test_alc_arena(void) {
+    yyjson_arena_flag flg_arr[] = {
+        YYJSON_ARENA_NOFLAG,
+        YYJSON_ARENA_HUGE_PAGE,
+        YYJSON_ARENA_HUGETLB,
+        YYJSON_ARENA_NUMA_NODE,
+        YYJSON_ARENA_HUGE_PAGE | YYJSON_ARENA_NUMA_NODE,
+    };
+    yyjson_alc *alc;
+    yyjson_alc pool;
+    char buf[BUF_SIZE];
+    u8 *ptr[4];
+    
+    
+    // new and destroy
+    yy_assert(!yyjson_alc_arena_new(0, 0, 0));
+    yyjson_alc_arena_free(NULL);
+    yyjson_alc_arena_reset(NULL);
+    yy_assert(yyjson_alc_arena_get_flag(NULL) == 0);
+    yy_assert(yyjson_alc_pool_init(&pool, buf, sizeof(buf)));
+    yy_assert(yyjson_alc_arena_get_flag(&pool) == 0);
+    yyjson_alc_arena_reset(&pool);
+    
+    
+    for (usize f = 0; f < yy_nelems(flg_arr); f++) {
+        yyjson_arena_flag flg = flg_arr[f];
+        alc = yyjson_alc_arena_new(0x10000, flg, 0);
+        yy_assert(alc);
+        yy_assert((yyjson_alc_arena_get_flag(alc) & ~flg) == 0 ||
+                  (flg == YYJSON_ARENA_HUGETLB &&
+                   yyjson_alc_arena_get_flag(alc) == YYJSON_ARENA_HUGE_PAGE));
+        
+        // bump allocation, aligned to 16 bytes
+        ptr[0] = (u8 *)alc->malloc(alc->ctx, 10);
+        ptr[1] = (u8 *)alc->malloc(alc->ctx, 20);
+        yy_assert(ptr[0] && ptr[1]);
+        yy_assert(ptr[1] == ptr[0] + 16);
+        memset(ptr[0], 0xAA, 10);
+        memset(ptr[1], 0xBB, 20);
+        
+        // the last allocation is resized in place
+        yy_assert(alc->realloc(alc->ctx, ptr[1], 20, 100) == ptr[1]);
+        memset(ptr[1], 0xBB, 100);
+        
+        // the others are copied
+        ptr[2] = (u8 *)alc->realloc(alc->ctx, ptr[0], 10, 40);
+        yy_assert(ptr[2] == ptr[1] + 112);
+        yy_assert(ptr[2][9] == 0xAA && ptr[1][99] == 0xBB);
+        
+        // only the last allocation is released
+        alc->free(alc->ctx, ptr[1]);
+        alc->free(alc->ctx, ptr[2]);
+        ptr[3] = (u8 *)alc->malloc(alc->ctx, 1);
+        yy_assert(ptr[3] == ptr[2]);
+        
+        // out of memory
+        yy_assert(!alc->malloc(alc->ctx, 0x10000));
+        yy_assert(!alc->realloc(alc->ctx, ptr[3], 1, 0x10000));
+        yy_assert(!alc->realloc(alc->ctx, ptr[1], 100, 0x10000));
+        
+        // reset
+        yyjson_alc_arena_reset(alc);
+        ptr[3] = (u8 *)alc->malloc(alc->ctx, 0x10000);
+        yy_assert(ptr[3] == ptr[0]);
+        memset(ptr[3], 0, 0x10000);
+        yy_assert(!alc->malloc(alc->ctx, 1));
+        yyjson_alc_arena_free(alc);
+    }
+    
+    
+    // read and write JSON
+    {
+        const char *json = "{\"a\":[1,2,3,\"abcdefghijklmnopqrstuvwxyz\"],"
+                           "\"b\":{\"c\":true,\"d\":null}}";
+        usize len = strlen(json);
+        alc = yyjson_alc_arena_new(0x100000, YYJSON_ARENA_HUGE_PAGE, 0);
+        yy_assert(alc);
+        for (int i = 0; i < 3; i++) {
+            yyjson_doc *doc = yyjson_read_opts((char *)json, len, 0, alc, NULL);
+            yyjson_mut_doc *mdoc = yyjson_doc_mut_copy(doc, alc);
+            char *str = yyjson_mut_write_opts(mdoc, 0, alc, NULL, NULL);
+            yy_assert(doc && mdoc && str && strcmp(str, json) == 0);
+            yyjson_mut_doc_free(mdoc);
+            yyjson_doc_free(doc);
+            yyjson_alc_arena_reset(alc);
+        }
+        yyjson_alc_arena_free(alc);
+        
+        alc = yyjson_alc_arena_new(64, 0, 0);
+        yy_assert(!yyjson_read_opts((char *)json, len, 0, alc, NULL));
+        yyjson_alc_arena_free(alc);
+    }
 }
 
 
@@ -347,4 +812,7 @@ yy_test_case(test_allocator) {
     test_alc_pool_func();
     test_alc_pool_read();
     test_alc_dyn();
+    test_alc_mt();
+    test_alc_limit();
+    test_alc_arena();
 }
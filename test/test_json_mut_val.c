@@ -3,6 +3,14 @@
 #include "yyjson.h"
 #include "yy_test_utils.h"
 
+/// Whether the value references the string, compact values copy the string.
+#if YYJSON_MUT_COMPACT
+#define mut_str_ref(val, str) \
+    (memcmp(yyjson_mut_get_str(val), (str), yyjson_mut_get_len(val)) == 0)
+#else
+#define mut_str_ref(val, str) (yyjson_mut_get_str(val) == (str))
+#endif
+
 
 
 /*==============================================================================
@@ -67,7 +75,7 @@ static void validate_mut_str(yyjson_mut_doc *doc,
         yy_assert(strcmp(yyjson_mut_get_str(val), str) == 0);
         yy_assert(yyjson_mut_get_len(val) == strlen(str));
         yy_assert(yyjson_mut_equals_str(val, str));
-        yy_assert(yyjson_mut_get_str(val) == str);
+        yy_assert(mut_str_ref(val, str));
     } else {
         yy_assert(val == NULL);
     }
@@ -79,7 +87,7 @@ static void validate_mut_str(yyjson_mut_doc *doc,
         yy_assert(strcmp(yyjson_mut_get_str(val), str) == 0);
         yy_assert(yyjson_mut_get_len(val) == len);
         yy_assert(yyjson_mut_equals_str(val, str) == (strlen(str) == len));
-        yy_assert(yyjson_mut_get_str(val) == str);
+        yy_assert(mut_str_ref(val, str));
     } else {
         yy_assert(val == NULL);
     }
@@ -202,7 +210,7 @@ static void test_json_mut_val_api(void) {
     yy_assert(yyjson_mut_float(NULL, (f32)123.0) == NULL);
     val = yyjson_mut_float(doc, (f32)123.0);
     yy_assert(validate_mut_val_type(val, YYJSON_TYPE_NUM, YYJSON_SUBTYPE_REAL));
-    yy_assert((val->tag >> 32) == YYJSON_WRITE_FP_TO_FLOAT);
+    yy_assert(unsafe_yyjson_mut_get_fp_fmt(val) == YYJSON_WRITE_FP_TO_FLOAT);
     yy_assert(strcmp(yyjson_mut_get_type_desc(val), "real") == 0);
     yy_assert(yyjson_mut_get_uint(val) == (u64)0);
     yy_assert(yyjson_mut_get_sint(val) == (i64)0);
@@ -213,7 +221,7 @@ static void test_json_mut_val_api(void) {
     yy_assert(yyjson_mut_double(NULL, 123.0) == NULL);
     val = yyjson_mut_double(doc, 123.0);
     yy_assert(validate_mut_val_type(val, YYJSON_TYPE_NUM, YYJSON_SUBTYPE_REAL));
-    yy_assert((val->tag >> 32) == 0);
+    yy_assert(unsafe_yyjson_mut_get_fp_fmt(val) == 0);
     yy_assert(strcmp(yyjson_mut_get_type_desc(val), "real") == 0);
     yy_assert(yyjson_mut_get_uint(val) == (u64)0);
     yy_assert(yyjson_mut_get_sint(val) == (i64)0);
@@ -1199,7 +1207,7 @@ static void test_json_mut_arr_api(void) {
         yy_assert(yyjson_mut_equals_str(val, "bc"));
         val = yyjson_mut_arr_get(arr, 3);
         yy_assert(yyjson_mut_equals_str(val, "abc"));
-        yy_assert(yyjson_mut_get_str(val) == vals[3]);
+        yy_assert(mut_str_ref(val, vals[3]));
         
         arr = yyjson_mut_arr_with_strn(doc, vals, lens, len);
         yy_assert(yyjson_mut_is_arr(arr));
@@ -1212,7 +1220,7 @@ static void test_json_mut_arr_api(void) {
         yy_assert(yyjson_mut_equals_str(val, "bc"));
         val = yyjson_mut_arr_get(arr, 3);
         yy_assert(yyjson_mut_equals_strn(val, "abc\0def", 7));
-        yy_assert(yyjson_mut_get_str(val) == vals[3]);
+        yy_assert(mut_str_ref(val, vals[3]));
         
         arr = yyjson_mut_arr_with_strcpy(doc, vals, len);
         yy_assert(yyjson_mut_is_arr(arr));
@@ -1324,16 +1332,17 @@ static void validate_mut_obj(yyjson_mut_val *obj,
         }
         
         // test all key-val pairs
-        first_key = ((yyjson_mut_val *)obj->uni.ptr)->next->next;
+        first_key = unsafe_yyjson_mut_get_next(unsafe_yyjson_mut_get_next(
+            unsafe_yyjson_mut_get_last(obj)));
         key = first_key;
-        val = key->next;
+        val = unsafe_yyjson_mut_get_next(key);
         for (usize i = 0; i < len; i++) {
             const char *str = keys[i];
             usize str_len = key_lens[i];
             yy_assert(yyjson_mut_equals_strn(key, str, str_len));
             yy_assert(yyjson_mut_get_int(val) == vals[i]);
-            key = val->next;
-            val = key->next;
+            key = unsafe_yyjson_mut_get_next(val);
+            val = unsafe_yyjson_mut_get_next(key);
         }
         yy_assert(key == first_key);
         
@@ -1406,7 +1415,9 @@ static void test_json_mut_obj_api(void) {
     yy_assert(!yyjson_mut_doc_set_val_pool_size(doc, ~(size_t)0));
     
     yy_assert(yyjson_mut_doc_set_val_pool_size(doc, 100));
-    yy_assert(doc->val_pool.chunk_size == 100 * sizeof(yyjson_mut_val) + sizeof(yyjson_mut_val));
+    yy_assert(doc->val_pool.chunk_size == 100 * sizeof(yyjson_mut_val) +
+              (sizeof(yyjson_val_chunk) + sizeof(yyjson_mut_val) - 1) /
+              sizeof(yyjson_mut_val) * sizeof(yyjson_mut_val));
     
     yyjson_mut_doc_free(doc);
     
@@ -1738,13 +1749,13 @@ static void test_json_mut_obj_api(void) {
     str = "xxx";
     yy_assert(yyjson_mut_obj_add_str(doc, obj, "aa", str));
     val = yyjson_mut_obj_get(obj, "aa");
-    yy_assert(yyjson_mut_get_str(val) == str);
+    yy_assert(mut_str_ref(val, str));
     yy_assert(yyjson_mut_get_len(val) == 3);
     
     str = "xxx\0xxx";
     yy_assert(yyjson_mut_obj_add_strn(doc, obj, "bb", str, 7));
     val = yyjson_mut_obj_get(obj, "bb");
-    yy_assert(yyjson_mut_get_str(val) == str);
+    yy_assert(mut_str_ref(val, str));
     yy_assert(yyjson_mut_get_len(val) == 7);
     
     str = "xxx";
@@ -2190,8 +2201,8 @@ static void test_json_mut_doc_api(void) {
         
         yyjson_mut_val *v1 = yyjson_mut_int(doc, 0);
         yyjson_mut_val *v2 = yyjson_mut_int(doc, 0);
-        v1->tag = 0;
-        v2->tag = 0;
+        unsafe_yyjson_mut_set_tag(v1, YYJSON_TYPE_NONE, YYJSON_SUBTYPE_NONE, 0);
+        unsafe_yyjson_mut_set_tag(v2, YYJSON_TYPE_NONE, YYJSON_SUBTYPE_NONE, 0);
         yy_assert(yyjson_mut_equals(v1, v2) == false);
         
         yyjson_mut_doc_free(doc);
@@ -2360,6 +2371,448 @@ static void test_json_mut_equals_api(void) {
 
 
 
+/*==============================================================================
+ * MARK: - Index
+ *============================================================================*/
+
+/// Validate the array with the expected elements, using the index.
+static void validate_mut_arr_index(yyjson_mut_val *arr,
+                                   yyjson_mut_val **vals, usize len) {
+    yyjson_mut_arr_iter iter;
+    yyjson_mut_val *val;
+    usize i = 0;
+    yy_assert(yyjson_mut_arr_size(arr) == len);
+    yyjson_mut_arr_iter_init(arr, &iter);
+    while ((val = yyjson_mut_arr_iter_next(&iter))) {
+        yy_assert(i < len && val == vals[i]);
+        i++;
+    }
+    yy_assert(i == len);
+    if (len) yy_assert(yyjson_mut_arr_get_first(arr) == vals[0]);
+    if (len) yy_assert(yyjson_mut_arr_get_last(arr) == vals[len - 1]);
+    for (i = 0; i < len; i++) {
+        yy_assert(yyjson_mut_arr_get(arr, i) == vals[i]);
+    }
+    yy_assert(yyjson_mut_arr_get(arr, len) == NULL);
+}
+
+static void test_json_mut_arr_index_api(void) {
+    usize cap = 4096, len = 0, i, idx;
+    yyjson_mut_val **vals = (yyjson_mut_val **)malloc(cap * sizeof(void *));
+    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
+    yyjson_mut_val *arr = yyjson_mut_arr(doc), *val;
+    yyjson_mut_val *cpy;
+    yy_assert(vals);
+    yy_rand_reset(0);
+
+    // build the index for an empty array
+    yy_assert(yyjson_mut_doc_index_size(doc) == 0);
+    yy_assert(yyjson_mut_arr_index_build(doc, arr));
+    yy_assert(yyjson_mut_arr_index_build(doc, arr));
+    yy_assert(yyjson_mut_doc_index_size(doc) > 0);
+    yy_assert(yyjson_mut_get_tag(arr) == YYJSON_TYPE_ARR);
+    yy_assert(strcmp(yyjson_mut_get_type_desc(arr), "array") == 0);
+    for (i = 0; i < 8; i++) {
+        val = yyjson_mut_int(doc, (i64)i);
+        yy_assert(yyjson_mut_arr_append(arr, val));
+        vals[len++] = val;
+    }
+    validate_mut_arr_index(arr, vals, len);
+
+    // random modifications, some of them drop the index
+    for (i = 0; i < 20000; i++) {
+        u32 op = yy_rand_u32_uniform(12);
+        val = yyjson_mut_int(doc, (i64)i);
+        idx = len ? (usize)yy_rand_u64_uniform(len) : 0;
+        if (len == 0 || (op <= 2 && len + 1 < cap)) {
+            idx = op == 0 ? len : (usize)yy_rand_u64_uniform(len + 1);
+            yy_assert(yyjson_mut_arr_insert(arr, val, idx));
+            memmove(vals + idx + 1, vals + idx, (len - idx) * sizeof(void *));
+            vals[idx] = val;
+            len++;
+        } else if (op <= 4) {
+            yy_assert(yyjson_mut_arr_remove(arr, idx) == vals[idx]);
+            memmove(vals + idx, vals + idx + 1, (len - idx - 1) * sizeof(void *));
+            len--;
+        } else if (op == 5) {
+            yy_assert(yyjson_mut_arr_replace(arr, idx, val) == vals[idx]);
+            vals[idx] = val;
+        } else if (op == 6) {
+            yy_assert(yyjson_mut_arr_get(arr, idx) == vals[idx]);
+        } else if (op == 7 && len + 1 < cap) {
+            yy_assert(yyjson_mut_arr_prepend(arr, val));
+            memmove(vals + 1, vals, len * sizeof(void *));
+            vals[0] = val;
+            len++;
+        } else if (op == 8) {
+            yy_assert(yyjson_mut_arr_remove_first(arr) == vals[0]);
+            memmove(vals, vals + 1, (len - 1) * sizeof(void *));
+            len--;
+        } else if (op == 9) {
+            yy_assert(yyjson_mut_arr_remove_last(arr) == vals[len - 1]);
+            len--;
+        } else if (op == 10 && len > 1) {
+            // rotate drops the index
+            yy_assert(yyjson_mut_arr_rotate(arr, 1));
+            val = vals[0];
+            memmove(vals, vals + 1, (len - 1) * sizeof(void *));
+            vals[len - 1] = val;
+            validate_mut_arr_index(arr, vals, len);
+            yy_assert(yyjson_mut_arr_index_build(doc, arr));
+        } else if (len > 2) {
+            // remove range drops the index
+            yy_assert(yyjson_mut_arr_remove_range(arr, 1, 1));
+            memmove(vals + 1, vals + 2, (len - 2) * sizeof(void *));
+            len--;
+            validate_mut_arr_index(arr, vals, len);
+            yy_assert(yyjson_mut_arr_index_build(doc, arr));
+        }
+        if (i % 1000 == 0) validate_mut_arr_index(arr, vals, len);
+    }
+    validate_mut_arr_index(arr, vals, len);
+
+    // the copy has no index, but the same elements
+    cpy = yyjson_mut_val_mut_copy(doc, arr);
+    yy_assert(yyjson_mut_equals(cpy, arr));
+    yy_assert(yyjson_mut_arr_size(cpy) == len);
+
+    // free the indexes, then build again
+    yyjson_mut_doc_index_free(doc);
+    yy_assert(yyjson_mut_doc_index_size(doc) == 0);
+    validate_mut_arr_index(arr, vals, len);
+    yy_assert(yyjson_mut_arr_index_build(doc, arr));
+    yy_assert(yyjson_mut_doc_index_size(doc) > 0);
+    validate_mut_arr_index(arr, vals, len);
+    while (len > 0) {
+        yy_assert(yyjson_mut_arr_remove(arr, len - 1) == vals[len - 1]);
+        len--;
+    }
+    validate_mut_arr_index(arr, vals, len);
+    val = yyjson_mut_null(doc);
+    yy_assert(yyjson_mut_arr_append(arr, val));
+    yy_assert(yyjson_mut_arr_replace(arr, 0, vals[0]) == val);
+    yy_assert(yyjson_mut_arr_get(arr, 0) == vals[0]);
+    yy_assert(yyjson_mut_arr_get_first(arr) == vals[0]);
+    yy_assert(yyjson_mut_arr_clear(arr));
+    yy_assert(yyjson_mut_arr_size(arr) == 0);
+    yy_assert(yyjson_mut_arr_append(arr, val));
+    yy_assert(yyjson_mut_arr_get(arr, 0) == val);
+
+    // invalid parameters
+    yy_assert(!yyjson_mut_arr_index_build(NULL, arr));
+    yy_assert(!yyjson_mut_arr_index_build(doc, NULL));
+    yy_assert(!yyjson_mut_arr_index_build(doc, val));
+    yy_assert(yyjson_mut_doc_index_size(NULL) == 0);
+    yyjson_mut_doc_index_free(NULL);
+
+    yyjson_mut_doc_free(doc);
+    free(vals);
+}
+
+/// Validate the object with the same key-value pairs as the reference.
+static void validate_mut_obj_index(yyjson_mut_val *obj, yyjson_mut_val *ref) {
+    yyjson_mut_obj_iter iter, ref_iter;
+    yyjson_mut_val *key, *ref_key;
+    yy_assert(yyjson_mut_obj_size(obj) == yyjson_mut_obj_size(ref));
+    yyjson_mut_obj_iter_init(obj, &iter);
+    yyjson_mut_obj_iter_init(ref, &ref_iter);
+    while ((key = yyjson_mut_obj_iter_next(&iter))) {
+        ref_key = yyjson_mut_obj_iter_next(&ref_iter);
+        yy_assert(ref_key);
+        yy_assert(yyjson_mut_equals_str(key, yyjson_mut_get_str(ref_key)));
+        yy_assert(yyjson_mut_get_sint(yyjson_mut_obj_iter_get_val(key)) ==
+                  yyjson_mut_get_sint(yyjson_mut_obj_iter_get_val(ref_key)));
+        yy_assert(yyjson_mut_obj_get(obj, yyjson_mut_get_str(key)) ==
+                  yyjson_mut_obj_get(obj, yyjson_mut_get_str(key)));
+    }
+    yy_assert(!yyjson_mut_obj_iter_next(&ref_iter));
+}
+
+static void test_json_mut_obj_index_api(void) {
+    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
+    yyjson_mut_val *obj = yyjson_mut_obj(doc), *ref = yyjson_mut_obj(doc);
+    yyjson_mut_val *val, *ref_val;
+    char buf[32];
+    usize i;
+    yy_rand_reset(0);
+
+    for (i = 0; i < 8; i++) {
+        snprintf(buf, sizeof(buf), "key%d", (int)i);
+        yy_assert(yyjson_mut_obj_add(obj, yyjson_mut_strcpy(doc, buf),
+                                     yyjson_mut_sint(doc, (i64)i)));
+        yyjson_mut_obj_add(ref, yyjson_mut_strcpy(doc, buf),
+                           yyjson_mut_sint(doc, (i64)i));
+    }
+    yy_assert(yyjson_mut_obj_index_build(doc, obj));
+    yy_assert(yyjson_mut_obj_index_build(doc, obj));
+    yy_assert(yyjson_mut_doc_index_size(doc) > 0);
+    yy_assert(yyjson_mut_get_tag(obj) == YYJSON_TYPE_OBJ);
+    yy_assert(strcmp(yyjson_mut_get_type_desc(obj), "object") == 0);
+    yy_assert(yyjson_mut_get_sint(yyjson_mut_obj_get(obj, "key3")) == 3);
+    yy_assert(!yyjson_mut_obj_get(obj, "key8"));
+
+    // remove a middle key then insert a new key, the index is not stale
+    yy_assert(yyjson_mut_get_sint(yyjson_mut_obj_remove_key(obj, "key3")) == 3);
+    yy_assert(yyjson_mut_get_sint(yyjson_mut_obj_remove_key(ref, "key3")) == 3);
+    yy_assert(yyjson_mut_obj_insert(obj, yyjson_mut_str(doc, "new"),
+                                    yyjson_mut_sint(doc, 100), 2));
+    yy_assert(yyjson_mut_obj_insert(ref, yyjson_mut_str(doc, "new"),
+                                    yyjson_mut_sint(doc, 100), 2));
+    yy_assert(!yyjson_mut_obj_get(obj, "key3"));
+    yy_assert(yyjson_mut_get_sint(yyjson_mut_obj_get(obj, "new")) == 100);
+    validate_mut_obj_index(obj, ref);
+
+    // rename a key, the index is not stale
+    yy_assert(yyjson_mut_obj_index_build(doc, obj));
+    yy_assert(yyjson_mut_obj_rename_key(doc, obj, "key5", "key55"));
+    yy_assert(yyjson_mut_obj_rename_key(doc, ref, "key5", "key55"));
+    yy_assert(!yyjson_mut_obj_get(obj, "key5"));
+    yy_assert(yyjson_mut_get_sint(yyjson_mut_obj_get(obj, "key55")) == 5);
+    validate_mut_obj_index(obj, ref);
+    yy_assert(yyjson_mut_obj_index_build(doc, obj));
+
+    // random modifications, compared with the unindexed object
+    for (i = 0; i < 30000; i++) {
+        u32 op = yy_rand_u32_uniform(20);
+        usize key_len;
+        snprintf(buf, sizeof(buf), "key%d", (int)yy_rand_u32_uniform(300));
+        key_len = strlen(buf);
+        if (op < 6) {
+            val = yyjson_mut_obj_getn(obj, buf, key_len);
+            ref_val = yyjson_mut_obj_getn(ref, buf, key_len);
+            yy_assert(yyjson_mut_get_sint(val) == yyjson_mut_get_sint(ref_val));
+            yy_assert(!val == !ref_val);
+        } else if (op < 11) {
+            yy_assert(yyjson_mut_obj_put(obj, yyjson_mut_strcpy(doc, buf),
+                                         yyjson_mut_sint(doc, (i64)i)));
+            yy_assert(yyjson_mut_obj_put(ref, yyjson_mut_strcpy(doc, buf),
+                                         yyjson_mut_sint(doc, (i64)i)));
+        } else if (op < 13) {
+            yy_assert(yyjson_mut_obj_put(obj, yyjson_mut_strcpy(doc, buf),
+                                         NULL));
+            yy_assert(yyjson_mut_obj_put(ref, yyjson_mut_strcpy(doc, buf),
+                                         NULL));
+        } else if (op < 16) {
+            val = yyjson_mut_obj_remove_key(obj, buf);
+            ref_val = yyjson_mut_obj_remove_key(ref, buf);
+            yy_assert(yyjson_mut_get_sint(val) == yyjson_mut_get_sint(ref_val));
+            yy_assert(!val == !ref_val);
+        } else if (op < 18) {
+            // duplicate keys are allowed, but make the index fall back to
+            // the linear functions, build it again after that
+            if (yyjson_mut_obj_getn(ref, buf, key_len) && i % 64) continue;
+            yy_assert(yyjson_mut_obj_add(obj, yyjson_mut_strcpy(doc, buf),
+                                         yyjson_mut_sint(doc, (i64)i)));
+            yy_assert(yyjson_mut_obj_add(ref, yyjson_mut_strcpy(doc, buf),
+                                         yyjson_mut_sint(doc, (i64)i)));
+        } else if (op == 18) {
+            val = yyjson_mut_sint(doc, (i64)i);
+            ref_val = yyjson_mut_sint(doc, (i64)i);
+            yy_assert(yyjson_mut_obj_replace(obj, yyjson_mut_str(doc, buf),
+                                             val) ==
+                      yyjson_mut_obj_replace(ref, yyjson_mut_str(doc, buf),
+                                             ref_val));
+        } else {
+            // insert drops the index
+            if (yyjson_mut_obj_getn(ref, buf, key_len)) continue;
+            yy_assert(yyjson_mut_obj_insert(obj, yyjson_mut_strcpy(doc, buf),
+                                            yyjson_mut_sint(doc, (i64)i), 0));
+            yy_assert(yyjson_mut_obj_insert(ref, yyjson_mut_strcpy(doc, buf),
+                                            yyjson_mut_sint(doc, (i64)i), 0));
+            yy_assert(yyjson_mut_obj_index_build(doc, obj));
+        }
+        if (i % 1000 == 0) {
+            validate_mut_obj_index(obj, ref);
+            yy_assert(yyjson_mut_obj_index_build(doc, obj));
+        }
+    }
+    validate_mut_obj_index(obj, ref);
+
+    // free the indexes, build again, then remove all keys
+    yyjson_mut_doc_index_free(doc);
+    yy_assert(yyjson_mut_doc_index_size(doc) == 0);
+    validate_mut_obj_index(obj, ref);
+    yy_assert(yyjson_mut_obj_index_build(doc, obj));
+    yy_assert(yyjson_mut_doc_index_size(doc) > 0);
+    for (i = 0; i < 300; i++) {
+        snprintf(buf, sizeof(buf), "key%d", (int)i);
+        val = yyjson_mut_obj_remove_key(obj, buf);
+        ref_val = yyjson_mut_obj_remove_key(ref, buf);
+        yy_assert(yyjson_mut_get_sint(val) == yyjson_mut_get_sint(ref_val));
+    }
+    yy_assert(yyjson_mut_obj_remove_key(obj, "new"));
+    yy_assert(yyjson_mut_obj_remove_key(ref, "new"));
+    validate_mut_obj_index(obj, ref);
+    yy_assert(yyjson_mut_obj_size(obj) == 0);
+    yy_assert(yyjson_mut_obj_index_build(doc, obj));
+    yy_assert(yyjson_mut_obj_add(obj, yyjson_mut_str(doc, "a"),
+                                 yyjson_mut_sint(doc, 1)));
+    yy_assert(yyjson_mut_get_sint(yyjson_mut_obj_get(obj, "a")) == 1);
+    yy_assert(yyjson_mut_obj_clear(obj));
+    yy_assert(!yyjson_mut_obj_get(obj, "a"));
+
+    // invalid parameters
+    val = yyjson_mut_sint(doc, 2);
+    yy_assert(!yyjson_mut_obj_index_build(NULL, obj));
+    yy_assert(!yyjson_mut_obj_index_build(doc, NULL));
+    yy_assert(!yyjson_mut_obj_index_build(doc, val));
+
+    yyjson_mut_doc_free(doc);
+}
+
+
+
+/*==============================================================================
+ * MARK: - Compact
+ *============================================================================*/
+
+static void test_json_mut_compact_api(void) {
+    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL), *doc2;
+    yyjson_mut_val *arr, *obj, *val, *cpy;
+    yyjson_doc *idoc;
+    char buf[32];
+    usize i, num = 600000;
+
+#if YYJSON_MUT_COMPACT
+    yy_assert(sizeof(yyjson_mut_val) == 16);
+#endif
+
+    // more values than a single pool chunk holds
+    arr = yyjson_mut_arr(doc);
+    yyjson_mut_doc_set_root(doc, arr);
+    for (i = 0; i < num; i++) {
+        snprintf(buf, sizeof(buf), "s%d", (int)i);
+        if (i % 3 == 0) {
+            yy_assert(yyjson_mut_arr_add_uint(doc, arr, i));
+        } else if (i % 3 == 1) {
+            yy_assert(yyjson_mut_arr_add_strcpy(doc, arr, buf));
+        } else {
+            obj = yyjson_mut_arr_add_obj(doc, arr);
+            yy_assert(yyjson_mut_obj_add_strcpy(doc, obj, buf, buf));
+        }
+    }
+    yy_assert(yyjson_mut_arr_size(arr) == num);
+    yy_assert(yyjson_mut_get_uint(yyjson_mut_arr_get(arr, num - 3)) == num - 3);
+    val = yyjson_mut_arr_get(arr, num - 1);
+    yy_assert(yyjson_mut_equals_str(yyjson_mut_obj_get(val, "s599999"),
+                                    "s599999"));
+
+    // strings not owned by the document
+#if YYJSON_MUT_COMPACT
+    val = yyjson_mut_str(doc, buf);
+    yy_assert(yyjson_mut_get_str(val) != buf);
+    yy_assert(yyjson_mut_equals_str(val, buf));
+#endif
+
+    // copy to another document, write and read back
+    doc2 = yyjson_mut_doc_new(NULL);
+    cpy = yyjson_mut_val_mut_copy(doc2, arr);
+    yy_assert(yyjson_mut_equals(arr, cpy));
+    yy_assert(yyjson_mut_arr_remove_first(cpy));
+    yy_assert(yyjson_mut_arr_size(cpy) == num - 1);
+    yy_assert(yyjson_mut_arr_size(arr) == num);
+    yyjson_mut_doc_free(doc2);
+
+    idoc = yyjson_mut_doc_imut_copy(doc, NULL);
+    yy_assert(yyjson_arr_size(yyjson_doc_get_root(idoc)) == num);
+    doc2 = yyjson_doc_mut_copy(idoc, NULL);
+    yy_assert(yyjson_mut_equals(arr, yyjson_mut_doc_get_root(doc2)));
+    yyjson_mut_doc_free(doc2);
+    yyjson_doc_free(idoc);
+
+#if !YYJSON_DISABLE_READER && !YYJSON_DISABLE_WRITER
+    usize len;
+    char *str = yyjson_mut_write(doc, 0, &len);
+    yy_assert(str);
+    idoc = yyjson_read(str, len, 0);
+    doc2 = yyjson_doc_mut_copy(idoc, NULL);
+    yy_assert(yyjson_mut_equals(arr, yyjson_mut_doc_get_root(doc2)));
+    yyjson_mut_doc_free(doc2);
+    yyjson_doc_free(idoc);
+    free(str);
+#endif
+
+    yyjson_mut_doc_free(doc);
+
+    // with_xxx containers larger than a single pool chunk
+    {
+        usize big = 1000000;
+        int64_t *nums = (int64_t *)malloc(big * sizeof(int64_t));
+        const char **keys = (const char **)malloc(big * sizeof(char *));
+        const char **vals = (const char **)malloc(big * sizeof(char *));
+        const char **kvs = (const char **)malloc(big * 2 * sizeof(char *));
+        yy_assert(nums && keys && vals && kvs);
+        for (i = 0; i < big; i++) {
+            nums[i] = (int64_t)i - 500000;
+            keys[i] = (i % 2) ? "a" : "b";
+            vals[i] = (i % 3) ? "x" : "y";
+            kvs[i * 2] = keys[i];
+            kvs[i * 2 + 1] = vals[i];
+        }
+
+        doc = yyjson_mut_doc_new(NULL);
+        yy_assert(yyjson_mut_arr(doc)); // start in a partly used chunk
+        arr = yyjson_mut_arr_with_sint64(doc, nums, big);
+        yy_assert(arr);
+        yy_assert(yyjson_mut_arr_size(arr) == big);
+        yy_assert(yyjson_mut_get_sint(yyjson_mut_arr_get_first(arr)) ==
+                  -500000);
+        yy_assert(yyjson_mut_get_sint(yyjson_mut_arr_get_last(arr)) ==
+                  (int64_t)big - 500001);
+        {
+            yyjson_mut_arr_iter iter = yyjson_mut_arr_iter_with(arr);
+            i = 0;
+            while ((val = yyjson_mut_arr_iter_next(&iter))) {
+                if (yyjson_mut_get_sint(val) != nums[i]) break;
+                i++;
+            }
+            yy_assert(i == big);
+        }
+
+        obj = yyjson_mut_obj_with_str(doc, keys, vals, big);
+        yy_assert(obj);
+        yy_assert(yyjson_mut_obj_size(obj) == big);
+        cpy = yyjson_mut_obj_with_kv(doc, kvs, big);
+        yy_assert(cpy);
+        yy_assert(yyjson_mut_obj_size(cpy) == big);
+        {
+            yyjson_mut_obj_iter iter = yyjson_mut_obj_iter_with(obj);
+            yyjson_mut_obj_iter iter2 = yyjson_mut_obj_iter_with(cpy);
+            yyjson_mut_val *key, *key2;
+            i = 0;
+            while ((key = yyjson_mut_obj_iter_next(&iter))) {
+                key2 = yyjson_mut_obj_iter_next(&iter2);
+                val = yyjson_mut_obj_iter_get_val(key);
+                if (!key2 || !yyjson_mut_equals_str(key, keys[i]) ||
+                    !yyjson_mut_equals_str(val, vals[i]) ||
+                    !yyjson_mut_equals_str(key2, keys[i]) ||
+                    !yyjson_mut_equals_str(yyjson_mut_obj_iter_get_val(key2),
+                                           vals[i])) break;
+                i++;
+            }
+            yy_assert(i == big);
+        }
+
+#if !YYJSON_DISABLE_READER && !YYJSON_DISABLE_WRITER
+        yyjson_mut_doc_set_root(doc, arr);
+        str = yyjson_mut_write(doc, 0, &len);
+        yy_assert(str);
+        idoc = yyjson_read(str, len, 0);
+        yy_assert(yyjson_arr_size(yyjson_doc_get_root(idoc)) == big);
+        yyjson_doc_free(idoc);
+        free(str);
+#endif
+
+        yyjson_mut_doc_free(doc);
+        free(nums);
+        free(keys);
+        free(vals);
+        free(kvs);
+    }
+}
+
+
+
 /*==============================================================================
  * MARK: - Entry
  *============================================================================*/
@@ -2368,6 +2821,9 @@ yy_test_case(test_json_mut_val) {
     test_json_mut_val_api();
     test_json_mut_arr_api();
     test_json_mut_obj_api();
+    test_json_mut_arr_index_api();
+    test_json_mut_obj_index_api();
     test_json_mut_doc_api();
     test_json_mut_equals_api();
+    test_json_mut_compact_api();
 }
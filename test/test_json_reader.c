@@ -37,6 +37,261 @@ static const yyjson_read_flag ALL_FLAGS[] = {
  * MARK: - Helper
  *============================================================================*/
 
+static void test_read_index(const char *path, char *dat, usize len,
+                            yyjson_read_flag flg, yyjson_doc *ref,
+                            yyjson_read_err *ref_err) {
+    // read with structural index, the result should be the same as `ref`
+    flg |= YYJSON_READ_STRUCTURAL_INDEX;
+    for (int insitu = 0; insitu <= 1; insitu++) {
+        char *dat_cpy = NULL;
+        void *buf = NULL;
+        yyjson_alc alc;
+        yyjson_read_err err;
+        yyjson_doc *doc;
+        if (insitu) {
+            dat_cpy = malloc(len + YYJSON_PADDING_SIZE);
+            yy_assert(dat_cpy);
+            memcpy(dat_cpy, dat, len);
+            memset(dat_cpy + len, 0, YYJSON_PADDING_SIZE);
+            usize max_mem_len = yyjson_read_max_memory_usage(
+                len, flg | YYJSON_READ_INSITU);
+            buf = malloc(max_mem_len);
+            yyjson_alc_pool_init(&alc, buf, max_mem_len);
+            doc = yyjson_read_opts(dat_cpy, len, flg | YYJSON_READ_INSITU,
+                                   &alc, &err);
+        } else {
+            doc = yyjson_read_opts(dat, len, flg, NULL, &err);
+        }
+        yy_assertf((doc != NULL) == (ref != NULL),
+                   "structural index result mismatch (0x%X): %s", flg, path);
+        if (!insitu || ref) {
+            // the pool may run out of memory for some invalid input
+            yy_assert(err.code == ref_err->code);
+            yy_assert(err.pos == ref_err->pos);
+        }
+        if (doc) {
+            yy_assert(yyjson_equals(yyjson_doc_get_root(doc),
+                                    yyjson_doc_get_root(ref)));
+            yy_assert(yyjson_doc_get_read_size(doc) ==
+                      yyjson_doc_get_read_size(ref));
+            yy_assert(yyjson_doc_get_val_count(doc) ==
+                      yyjson_doc_get_val_count(ref));
+        }
+        yyjson_doc_free(doc);
+        free(buf);
+        free(dat_cpy);
+    }
+}
+
+typedef struct {
+    yy_buf buf; // events in text form
+    usize num; // number of events
+    usize stop; // return false on this event if not 0
+    bool zero_copy; // the strings without escapes are not null-terminated
+} sax_rec;
+
+static void sax_rec_val(yy_buf *buf, u8 evt, const yyjson_val *val,
+                        bool zero_copy) {
+    yy_assert(yy_buf_append(buf, &evt, 1));
+    if (!val) return;
+    yy_assert(yy_buf_append(buf, (u8 *)(void *)&val->tag, sizeof(val->tag)));
+    if (yyjson_is_str(val) || yyjson_is_raw(val)) {
+        const char *str = yyjson_get_str(val) ? yyjson_get_str(val)
+                                              : yyjson_get_raw(val);
+        if (!zero_copy || !(val->tag & YYJSON_SUBTYPE_NOESC)) {
+            yy_assert(str[yyjson_get_len(val)] == '\0');
+        }
+        yy_assert(yy_buf_append(buf, (u8 *)str, yyjson_get_len(val)));
+    } else if (yyjson_is_num(val)) {
+        yy_assert(yy_buf_append(buf, (u8 *)(void *)&val->uni,
+                                sizeof(val->uni)));
+    }
+}
+
+static bool sax_rec_cb(void *ctx, yyjson_sax_event evt,
+                       const yyjson_val *val) {
+    sax_rec *rec = (sax_rec *)ctx;
+    yy_assert((val != NULL) == (evt == YYJSON_SAX_KEY ||
+                                evt == YYJSON_SAX_VAL));
+    sax_rec_val(&rec->buf, evt, val, rec->zero_copy);
+    rec->num++;
+    return rec->num != rec->stop;
+}
+
+// record the events of a document, in the same form as `sax_rec_cb()`
+static usize sax_rec_doc(yy_buf *buf, yyjson_val *val) {
+    usize num = 1, idx, max;
+    yyjson_val *key, *ele;
+    if (yyjson_is_arr(val)) {
+        sax_rec_val(buf, YYJSON_SAX_ARR_BEGIN, NULL, false);
+        yyjson_arr_foreach(val, idx, max, ele) {
+            num += sax_rec_doc(buf, ele);
+        }
+        sax_rec_val(buf, YYJSON_SAX_ARR_END, NULL, false);
+        num++;
+    } else if (yyjson_is_obj(val)) {
+        sax_rec_val(buf, YYJSON_SAX_OBJ_BEGIN, NULL, false);
+        yyjson_obj_foreach(val, idx, max, key, ele) {
+            sax_rec_val(buf, YYJSON_SAX_KEY, key, false);
+            num += 1 + sax_rec_doc(buf, ele);
+        }
+        sax_rec_val(buf, YYJSON_SAX_OBJ_END, NULL, false);
+        num++;
+    } else {
+        sax_rec_val(buf, YYJSON_SAX_VAL, val, false);
+    }
+    return num;
+}
+
+static void test_read_sax(const char *path, char *dat, usize len,
+                          yyjson_read_flag flg, yyjson_doc *ref,
+                          yyjson_read_err *ref_err) {
+    // read with SAX callback, the events should match the document `ref`
+    yy_buf ref_buf;
+    usize ref_num = 0, stop;
+    flg &= ~YYJSON_READ_STRUCTURAL_INDEX;
+    yy_assert(yy_buf_init(&ref_buf, 0));
+    if (ref) ref_num = sax_rec_doc(&ref_buf, yyjson_doc_get_root(ref));
+    
+    // mode 0: copy, 1: insitu, 2: zero-copy
+    for (int mode = 0; mode <= 2; mode++) {
+        sax_rec rec;
+        yyjson_read_err err;
+        usize ret;
+        char *dat_cpy = NULL;
+        if (mode == 2 && (flg & (YYJSON_READ_NUMBER_AS_RAW |
+                                 YYJSON_READ_BIGNUM_AS_RAW |
+                                 YYJSON_READ_ALLOW_UNQUOTED_KEY))) continue;
+        yy_assert(yy_buf_init(&rec.buf, 0));
+        rec.num = 0;
+        rec.stop = 0;
+        rec.zero_copy = (mode == 2);
+        if (mode) {
+            dat_cpy = malloc(len + YYJSON_PADDING_SIZE);
+            yy_assert(dat_cpy);
+            memcpy(dat_cpy, dat, len);
+            memset(dat_cpy + len, 0, YYJSON_PADDING_SIZE);
+            ret = yyjson_read_sax(dat_cpy, len, flg | (mode == 1 ?
+                                  YYJSON_READ_INSITU : YYJSON_READ_ZERO_COPY),
+                                  NULL, sax_rec_cb, &rec, &err);
+            if (mode == 2) yy_assert(memcmp(dat_cpy, dat, len) == 0);
+        } else {
+            ret = yyjson_read_sax(dat, len, flg, NULL, sax_rec_cb, &rec, &err);
+        }
+        yy_assertf((ret != 0) == (ref != NULL),
+                   "SAX reader result mismatch (0x%X): %s", flg, path);
+        yy_assert(err.code == ref_err->code);
+        yy_assert(err.pos == ref_err->pos);
+        if (ref) {
+            yy_assert(ret == yyjson_doc_get_read_size(ref));
+            yy_assert(rec.num == ref_num);
+            yy_assert(yy_buf_len(&rec.buf) == yy_buf_len(&ref_buf));
+            yy_assert(memcmp(rec.buf.hdr, ref_buf.hdr,
+                             yy_buf_len(&ref_buf)) == 0);
+        }
+        yy_buf_release(&rec.buf);
+        free(dat_cpy);
+    }
+    
+    // stop reading in the callback
+    for (stop = 1; stop < ref_num; stop += (stop < 8 ? 1 : ref_num / 4)) {
+        sax_rec rec;
+        yyjson_read_err err;
+        usize ret;
+        yy_assert(yy_buf_init(&rec.buf, 0));
+        rec.num = 0;
+        rec.stop = stop;
+        rec.zero_copy = false;
+        ret = yyjson_read_sax(dat, len, flg, NULL, sax_rec_cb, &rec, &err);
+        yy_assert(ret > 0 && ret <= yyjson_doc_get_read_size(ref));
+        yy_assert(err.code == YYJSON_READ_SUCCESS);
+        yy_assert(rec.num == stop);
+        yy_assert(memcmp(rec.buf.hdr, ref_buf.hdr, yy_buf_len(&rec.buf)) == 0);
+        yy_buf_release(&rec.buf);
+    }
+    yy_buf_release(&ref_buf);
+}
+
+static void test_read_zero_copy(const char *path, char *dat, usize len,
+                                yyjson_read_flag flg, yyjson_doc *ref,
+                                yyjson_read_err *ref_err) {
+    // read without copying the input, the result should be the same as `ref`
+    yyjson_read_err err;
+    yyjson_doc *doc;
+    char *dat_cpy = malloc(len + YYJSON_PADDING_SIZE);
+    yy_assert(dat_cpy);
+    memcpy(dat_cpy, dat, len);
+    memset(dat_cpy + len, 0, YYJSON_PADDING_SIZE);
+    
+    flg |= YYJSON_READ_ZERO_COPY;
+    doc = yyjson_read_opts(dat_cpy, len, flg, NULL, &err);
+    if (flg & (YYJSON_READ_NUMBER_AS_RAW | YYJSON_READ_BIGNUM_AS_RAW |
+               YYJSON_READ_ALLOW_UNQUOTED_KEY)) {
+        yy_assert(!doc);
+        yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+        free(dat_cpy);
+        return;
+    }
+    yy_assertf((doc != NULL) == (ref != NULL),
+               "zero-copy reader result mismatch (0x%X): %s", flg, path);
+    yy_assert(err.code == ref_err->code);
+    yy_assert(err.pos == ref_err->pos);
+    yy_assert(memcmp(dat_cpy, dat, len) == 0);
+    if (doc) {
+        yyjson_val *val = yyjson_doc_get_root(doc);
+        usize i, num = yyjson_doc_get_val_count(doc);
+        yy_assert(yyjson_equals(val, yyjson_doc_get_root(ref)));
+        yy_assert(yyjson_doc_get_read_size(doc) ==
+                  yyjson_doc_get_read_size(ref));
+        yy_assert(num == yyjson_doc_get_val_count(ref));
+        for (i = 0; i < num; i++, val++) {
+            // only the strings without escapes reference the input
+            bool in_dat = val->uni.str >= dat_cpy &&
+                          val->uni.str < dat_cpy + len;
+            if (!yyjson_is_str(val)) continue;
+            yy_assert(in_dat == ((val->tag & YYJSON_SUBTYPE_NOESC) != 0));
+            if (!in_dat) yy_assert(val->uni.str[yyjson_get_len(val)] == '\0');
+        }
+    }
+    yyjson_doc_free(doc);
+    free(dat_cpy);
+}
+
+static void test_read_precount(const char *path, char *dat, usize len,
+                               yyjson_read_flag flg, yyjson_doc *ref,
+                               yyjson_read_err *ref_err) {
+    // read with the value count pass, the result should be the same as `ref`
+    // and the values are not reallocated for standard JSON
+    const yyjson_read_flag inexact = YYJSON_READ_ALLOW_COMMENTS |
+        YYJSON_READ_ALLOW_EXT_WHITESPACE |
+        YYJSON_READ_ALLOW_SINGLE_QUOTED_STR | YYJSON_READ_ALLOW_UNQUOTED_KEY |
+        YYJSON_READ_STOP_WHEN_DONE;
+    yyjson_read_stats stats;
+    yyjson_read_err err;
+    yyjson_doc *doc;
+    
+    flg |= YYJSON_READ_PRECOUNT;
+    doc = yyjson_read_opts(dat, len, flg, NULL, &err);
+    yy_assertf((doc != NULL) == (ref != NULL),
+               "precount reader result mismatch (0x%X): %s", flg, path);
+    yy_assert(err.code == ref_err->code);
+    yy_assert(err.pos == ref_err->pos);
+    if (doc) {
+        yy_assert(yyjson_equals(yyjson_doc_get_root(doc),
+                                yyjson_doc_get_root(ref)));
+        yy_assert(yyjson_doc_get_val_count(doc) ==
+                  yyjson_doc_get_val_count(ref));
+        yy_assert(yyjson_doc_get_read_stats(doc, &stats));
+        yy_assert(stats.val_count == yyjson_doc_get_val_count(doc));
+        yy_assert(stats.val_cap >= stats.val_count);
+        if (!(flg & inexact)) {
+            yy_assertf(stats.realloc_count == 0,
+                       "precount reader reallocated (0x%X): %s", flg, path);
+        }
+    }
+    yyjson_doc_free(doc);
+}
+
 static void test_read_data(const char *path, char *dat, usize len,
                            yyjson_read_flag flg, expect_type expect) {
 #if YYJSON_DISABLE_UTF8_VALIDATION
@@ -61,6 +316,10 @@ static void test_read_data(const char *path, char *dat, usize len,
         yy_assert(err.code != YYJSON_READ_SUCCESS);
         yy_assert(err.msg != NULL);
     }
+    test_read_index(path, dat, len, flg, doc, &err);
+    test_read_sax(path, dat, len, flg, doc, &err);
+    test_read_zero_copy(path, dat, len, flg, doc, &err);
+    test_read_precount(path, dat, len, flg, doc, &err);
     
     // test write again
 #if !YYJSON_DISABLE_WRITER
@@ -186,11 +445,48 @@ restart_incr_read:
 #endif
 }
 
+#if !YYJSON_DISABLE_FILE
+static void test_read_mmap(const char *path, char *dat, usize len,
+                           yyjson_read_flag flg) {
+    // read with memory-mapped file, the result should be the same as in memory
+    yyjson_read_err err, ref_err;
+    yyjson_doc *doc, *ref;
+    ref = yyjson_read_opts(dat, len, flg, NULL, &ref_err);
+    doc = yyjson_read_file_mmap(path, flg, NULL, &err);
+    yy_assertf((doc != NULL) == (ref != NULL),
+               "memory-mapped file result mismatch (0x%X): %s", flg, path);
+    yy_assert(err.code == ref_err.code);
+    yy_assert(err.pos == ref_err.pos);
+    if (doc) {
+        yy_assert(yyjson_equals(yyjson_doc_get_root(doc),
+                                yyjson_doc_get_root(ref)));
+        yy_assert(yyjson_doc_get_read_size(doc) ==
+                  yyjson_doc_get_read_size(ref));
+        // the strings without escapes reference the read-only mapping
+        if (doc->ext.map) {
+            yyjson_val *val = yyjson_doc_get_root(doc);
+            usize i, num = yyjson_doc_get_val_count(doc);
+            for (i = 0; i < num; i++, val++) {
+                bool in_map = val->uni.str >= (char *)doc->ext.map &&
+                    val->uni.str < (char *)doc->ext.map + doc->ext.map_len;
+                if (!yyjson_is_str(val)) continue;
+                yy_assert(in_map == ((val->tag & YYJSON_SUBTYPE_NOESC) != 0));
+            }
+        }
+    }
+    yyjson_doc_free(doc);
+    yyjson_doc_free(ref);
+}
+#endif
+
 static void test_read_file(const char *path, yyjson_read_flag flg, expect_type expect) {
     u8 *dat;
     usize len;
     yy_assertf(yy_file_read(path, &dat, &len), "fail to read file: %s", path);
     test_read_data(path, (char *)dat, len, flg, expect);
+#if !YYJSON_DISABLE_FILE
+    if (len) test_read_mmap(path, (char *)dat, len, flg);
+#endif
     free(dat);
 }
 
@@ -304,6 +600,44 @@ static void test_json_yyjson(void) {
     yy_assert(!yyjson_read_file(NULL, 0, NULL, NULL));
     yy_assert(!yyjson_read_file("...not a valid file...", 0, NULL, &err));
     yy_assert(err.code == YYJSON_READ_ERROR_FILE_OPEN);
+    
+    // test read memory-mapped file
+    yy_assert(!yyjson_read_file_mmap(NULL, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_read_file_mmap("...not a valid file...", 0, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_FILE_OPEN);
+    {
+        // file sizes around the page size, with or without room for padding
+        const char *tmp_path = "__yyjson_test_mmap__.json";
+        usize sizes[] = { 1, 2, 3, 4095, 4096, 4097, 8191, 8192, 16384,
+                          65533, 65534, 65535, 65536, 65537 };
+        for (usize i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            usize len = sizes[i];
+            char *dat = malloc(len);
+            yy_assert(dat);
+            memset(dat, ' ', len);
+            dat[0] = '1';
+            if (len >= 2) {
+                dat[0] = '[';
+                dat[len - 1] = ']';
+            }
+            if (len >= 4) memcpy(dat + len - 3, "\"\"]", 3);
+            yy_assert(yy_file_write(tmp_path, (u8 *)dat, len));
+            test_read_mmap(tmp_path, dat, len, 0);
+            test_read_mmap(tmp_path, dat, len, YYJSON_READ_STOP_WHEN_DONE);
+            free(dat);
+        }
+        // empty file
+        FILE *fp = yy_file_open(tmp_path, "wb");
+        yy_assert(fp);
+        fclose(fp);
+        yy_assert(!yyjson_read_file_mmap(tmp_path, 0, NULL, &err));
+        yy_assert(err.code != YYJSON_READ_SUCCESS);
+        yy_file_delete(tmp_path);
+    }
+    doc = yyjson_read_file_mmap(dir, 0, NULL, NULL);
+    yy_assert(yyjson_is_arr(yyjson_doc_get_root(doc)));
+    yyjson_doc_free(doc);
 #endif
     
     // test alloc fail
@@ -612,6 +946,801 @@ static void test_json_whitespace(void) {
 
 
 
+/// Append `len` bytes of whitespace from `pat` (repeated) to `buf`.
+static char *append_space(char *buf, const char *pat, usize len) {
+    usize pat_len = strlen(pat);
+    for (usize i = 0; i < len; i++) *buf++ = pat[i % pat_len];
+    return buf;
+}
+
+/// Append a string to `buf`.
+static char *append_str(char *buf, const char *str) {
+    usize len = strlen(str);
+    memcpy(buf, str, len);
+    return buf + len;
+}
+
+/// Long whitespace runs, the reader may skip a block of whitespace at once.
+static void test_json_whitespace_long(void) {
+#if !YYJSON_DISABLE_READER
+    const char *pats[] = { " ", "\t", "\n", "\r\n", " \t\n\r", "\n    " };
+    const char *dst = "[1,{\"a\":[\"b\",true]},[]]";
+    yyjson_doc *doc_dst = yyjson_read(dst, strlen(dst), 0);
+    yy_assert(doc_dst);
+    
+    for (usize p = 0; p < sizeof(pats) / sizeof(pats[0]); p++) {
+        for (usize len = 0; len <= 130; len++) {
+            const char *pat = pats[p];
+            for (int mode = 0; mode <= 2; mode++) {
+                bool cmt = mode == 1;
+#if YYJSON_DISABLE_NON_STANDARD
+                if (cmt) continue;
+#endif
+                yyjson_read_flag flg = cmt ? YYJSON_READ_ALLOW_COMMENTS :
+                    mode == 2 ? YYJSON_READ_STRUCTURAL_INDEX : 0;
+                char *buf = malloc(16 * (len + 16) + 256);
+                char *cur = buf;
+                
+                /* pretty root, `[` followed by 2 spaces */
+                cur = append_str(cur, "[  ");
+                cur = append_space(cur, pat, len);
+                cur = append_str(cur, "1,");
+                cur = append_space(cur, pat, len);
+                if (cmt) cur = append_str(cur, "/* c */");
+                cur = append_space(cur, pat, len);
+                cur = append_str(cur, "{");
+                cur = append_space(cur, pat, len);
+                cur = append_str(cur, "\"a\"");
+                cur = append_space(cur, pat, len);
+                cur = append_str(cur, ":");
+                cur = append_space(cur, pat, len);
+                cur = append_str(cur, "[\"b\"");
+                cur = append_space(cur, pat, len);
+                if (cmt) cur = append_str(cur, "// c\n");
+                cur = append_space(cur, pat, len);
+                cur = append_str(cur, ",true");
+                cur = append_space(cur, pat, len);
+                cur = append_str(cur, "]}");
+                cur = append_space(cur, pat, len);
+                cur = append_str(cur, ",[");
+                cur = append_space(cur, pat, len);
+                cur = append_str(cur, "]]");
+                cur = append_space(cur, pat, len);
+                
+                yyjson_doc *doc = yyjson_read(buf, (usize)(cur - buf), flg);
+                yy_assertf(doc, "read fail, pattern: %u, len: %u, mode: %d\n",
+                           (u32)p, (u32)len, mode);
+                yy_assert(yyjson_equals(yyjson_doc_get_root(doc),
+                                        yyjson_doc_get_root(doc_dst)));
+                yyjson_doc_free(doc);
+                
+                /* invalid character after whitespace */
+                cur = append_str(cur, "x");
+                doc = yyjson_read(buf, (usize)(cur - buf), flg);
+                yy_assert(!doc);
+                free(buf);
+            }
+        }
+    }
+    yyjson_doc_free(doc_dst);
+#endif
+}
+
+
+
+/*==============================================================================
+ * MARK: - Parallel
+ *============================================================================*/
+
+// run the tasks in reverse order
+static void test_par_run(void *ctx, yyjson_par_task task, void *arg,
+                         size_t num) {
+    usize *count = (usize *)ctx;
+    while (num > 0) task(arg, --num);
+    (*count)++;
+}
+
+static void validate_par(const char *name, const char *dat, usize len,
+                         yyjson_read_flag flg) {
+    // read in parallel, the result should be the same as serial reading
+    yyjson_read_err ref_err, err;
+    yyjson_doc *ref = yyjson_read_opts((char *)dat, len, flg, NULL, &ref_err);
+    usize par_nums[] = { 2, 3, 8 };
+    for (usize i = 0; i < sizeof(par_nums) / sizeof(par_nums[0]); i++) {
+        for (int use_run = 0; use_run <= 1; use_run++) {
+            usize count = 0;
+            yyjson_doc *doc = yyjson_read_par((char *)dat, len, flg, NULL,
+                                              par_nums[i],
+                                              use_run ? test_par_run : NULL,
+                                              &count, &err);
+            yy_assertf((doc != NULL) == (ref != NULL),
+                       "parallel read result mismatch: %s\n", name);
+            yy_assert(err.code == ref_err.code);
+            yy_assert(err.pos == ref_err.pos);
+            yy_assert((err.msg == NULL) == (ref_err.msg == NULL));
+            if (doc) {
+                yy_assert(yyjson_equals(yyjson_doc_get_root(doc),
+                                        yyjson_doc_get_root(ref)));
+                yy_assert(yyjson_doc_get_read_size(doc) ==
+                          yyjson_doc_get_read_size(ref));
+                yy_assert(yyjson_doc_get_val_count(doc) ==
+                          yyjson_doc_get_val_count(ref));
+#if !YYJSON_DISABLE_WRITER
+                char *ret = yyjson_write(doc, 0, NULL);
+                char *ref_ret = yyjson_write(ref, 0, NULL);
+                yy_assert(ret && ref_ret && strcmp(ret, ref_ret) == 0);
+                free(ret);
+                free(ref_ret);
+#endif
+            }
+            yyjson_doc_free(doc);
+        }
+    }
+    yyjson_doc_free(ref);
+}
+
+static void par_append(yy_buf *buf, const char *str) {
+    yy_assert(yy_buf_append(buf, (u8 *)str, strlen(str)));
+}
+
+// generate an array (or object) with `num` elements of `pat`,
+// `%d` in `pat` is replaced with the element index
+static char *par_gen(const char *open, const char *pat, const char *sep,
+                     const char *close, usize num, usize *len) {
+    yy_buf buf;
+    char tmp[256];
+    yy_assert(yy_buf_init(&buf, 1024));
+    par_append(&buf, open);
+    for (usize i = 0; i < num; i++) {
+        if (i > 0) par_append(&buf, sep);
+        snprintf(tmp, sizeof(tmp), pat, (int)i);
+        par_append(&buf, tmp);
+    }
+    par_append(&buf, close);
+    *len = yy_buf_len(&buf);
+    yy_assert(yy_buf_append(&buf, (u8 *)"\0", 1));
+    return (char *)buf.hdr;
+}
+
+static void test_json_parallel(void) {
+    char *dat, *tmp;
+    usize len;
+
+    // array of records
+    dat = par_gen("[", "{\"id\":%d,\"name\":\"user\",\"tags\":[\"a\",\"b\"],"
+                  "\"score\":1.5,\"ok\":true,\"next\":null}", ",", "]",
+                  10000, &len);
+    validate_par("records", dat, len, 0);
+    validate_par("records", dat, len, YYJSON_READ_STRUCTURAL_INDEX);
+    validate_par("records", dat, len, YYJSON_READ_NUMBER_AS_RAW);
+    validate_par("records", dat, len, YYJSON_READ_STOP_WHEN_DONE);
+
+    // too small to split, or no split point
+    validate_par("records", dat, 500, 0);
+    validate_par("records", dat, len - 1, 0);
+    dat[len / 2] = '!';
+    validate_par("records", dat, len, 0);
+    free(dat);
+
+    // pretty-printed, with BOM
+    dat = par_gen("\xEF\xBB\xBF  [\n", "    {\n        \"id\": %d,\n"
+                  "        \"list\": [\n            1,\n            2\n"
+                  "        ]\n    }", ",\n", "\n]\n", 5000, &len);
+    validate_par("pretty", dat, len, YYJSON_READ_ALLOW_BOM);
+    validate_par("pretty", dat, len, 0);
+    validate_par("pretty", dat + 3, len - 3, YYJSON_READ_ALLOW_COMMENTS);
+    free(dat);
+
+    // object root, the values have decoy separators
+    dat = par_gen("{", "\"key%d\":{\"a\":[\"x\",\"y\"],\"b\":\"},{\\\"c\\\":\"}",
+                  ",", "}", 10000, &len);
+    validate_par("object", dat, len, 0);
+    free(dat);
+
+    // array of numbers and strings
+    dat = par_gen("[", "%d,-1.25e3,0", ",", "]", 30000, &len);
+    validate_par("numbers", dat, len, 0);
+    validate_par("numbers", dat, len, YYJSON_READ_BIGNUM_AS_RAW);
+    free(dat);
+    dat = par_gen("[", "\"str%d\",\"\\\"],[\\\"\",\"\\u4e2d\\n\"", ", ", "]",
+                  10000, &len);
+    validate_par("strings", dat, len, 0);
+    free(dat);
+    dat = par_gen("[", "[%d,\"],[\"],[[]]", ",", "]", 20000, &len);
+    validate_par("arrays", dat, len, 0);
+    free(dat);
+
+    // trailing commas
+    dat = par_gen("[", "[%d,[1,2]]", ",", ",]", 20000, &len);
+    validate_par("trailing_commas", dat, len, 0);
+    validate_par("trailing_commas", dat, len,
+                 YYJSON_READ_ALLOW_TRAILING_COMMAS);
+    free(dat);
+    dat = par_gen("[", "[%d,[1,2,]]", ",", "]", 20000, &len);
+    validate_par("trailing_commas", dat, len,
+                 YYJSON_READ_ALLOW_TRAILING_COMMAS);
+    free(dat);
+
+    // trailing content
+    dat = par_gen("[", "[%d]", ",", "] [1,2]", 30000, &len);
+    validate_par("trailing_content", dat, len, 0);
+    validate_par("trailing_content", dat, len, YYJSON_READ_STOP_WHEN_DONE);
+    free(dat);
+
+    // the root container is closed early
+    dat = par_gen("[", "[%d]", ",", "]", 30000, &len);
+    tmp = strstr(dat, "[15000]");
+    tmp[7] = ']';
+    validate_par("early_close", dat, len, 0);
+    validate_par("early_close", dat, len, YYJSON_READ_STOP_WHEN_DONE);
+    free(dat);
+
+    // invalid content inside a part
+    dat = par_gen("[", "{\"v\":%d}", ",", "]", 30000, &len);
+    tmp = strstr(dat, "{\"v\":20000}");
+    tmp[3] = 'x';
+    validate_par("invalid", dat, len, 0);
+    tmp[3] = '"';
+    tmp[10] = ',';
+    validate_par("invalid", dat, len, 0);
+    free(dat);
+
+    // empty root and scalar root
+    dat = par_gen("[", "", " ", "]", 200000, &len);
+    validate_par("empty", dat, len, 0);
+    free(dat);
+    dat = par_gen("\"", "%d", "", "\"", 50000, &len);
+    validate_par("scalar", dat, len, 0);
+    free(dat);
+}
+
+
+
+/*==============================================================================
+ * MARK: - JSON Lines
+ *============================================================================*/
+
+// validate the records with the serial reader
+static usize validate_ndjson(yyjson_ndjson *nd, const char *dat, usize len,
+                             yyjson_read_flag flg, usize batch, bool use_run,
+                             usize *lines) {
+    yyjson_ndjson_rec recs[64];
+    usize total = 0, num, i, count = 0, pos = 0;
+    yy_assert(batch <= 64);
+    while ((num = yyjson_ndjson_read(nd, recs, batch,
+                                     use_run ? test_par_run : NULL,
+                                     &count)) > 0) {
+        for (i = 0; i < num; i++) {
+            yyjson_ndjson_rec *rec = recs + i;
+            yyjson_read_err err;
+            yyjson_doc *ref;
+            const char *nl;
+            usize rec_len;
+            yy_assert(rec->pos >= pos && rec->pos + rec->len <= len);
+            yy_assert(rec->pos == 0 || dat[rec->pos - 1] == '\n' ||
+                      (rec->pos == 3 && (flg & YYJSON_READ_ALLOW_BOM)));
+            // the length excludes the line break, both LF and CRLF
+            nl = (const char *)memchr(dat + rec->pos, '\n', len - rec->pos);
+            rec_len = (nl ? (usize)(nl - dat) : len) - rec->pos;
+            if (nl && rec_len && nl[-1] == '\r') rec_len--;
+            yy_assert(rec->len == rec_len);
+            yy_assert(rec->line == lines[total]);
+            pos = rec->pos + rec->len;
+
+            ref = yyjson_read_opts((char *)dat + rec->pos, rec->len,
+                                   flg & ~(YYJSON_READ_ALLOW_BOM |
+                                           YYJSON_READ_INSITU), NULL, &err);
+            yy_assert((rec->doc != NULL) == (ref != NULL));
+            yy_assert(rec->err.code == err.code);
+            yy_assert(rec->err.pos == (ref ? 0 : err.pos + rec->pos));
+            if (ref) {
+                yy_assert(yyjson_equals(yyjson_doc_get_root(rec->doc),
+                                        yyjson_doc_get_root(ref)));
+            }
+            yyjson_doc_free(ref);
+            total++;
+        }
+    }
+    yy_assert(yyjson_ndjson_read(nd, recs, batch, NULL, NULL) == 0);
+    yy_assert(!use_run || count > 0 || total == 0);
+    return total;
+}
+
+// count the records and get their line numbers
+static usize ndjson_lines(const char *dat, usize len, usize *lines) {
+    usize num = 0, line = 1, i = 0, beg;
+    while (i < len) {
+        bool blank = true;
+        for (beg = i; i < len && dat[i] != '\n'; i++) {
+            if (!strchr(" \t\r", dat[i])) blank = false;
+        }
+        if (!blank && lines) lines[num] = line;
+        if (!blank) num++;
+        line++;
+        i++;
+    }
+    (void)beg;
+    return num;
+}
+
+static void test_ndjson_data(const char *dat, usize len,
+                             yyjson_read_flag flg) {
+    usize batches[] = { 1, 3, 64 };
+    usize *lines = (usize *)malloc((ndjson_lines(dat, len, NULL) + 1) *
+                                   sizeof(usize));
+    usize num = ndjson_lines(dat, len, lines);
+    if (len >= 3 && memcmp(dat, "\xEF\xBB\xBF", 3) == 0) {
+        // the BOM is not a part of the first record
+        yy_assert(flg & YYJSON_READ_ALLOW_BOM);
+    }
+
+    for (usize b = 0; b < sizeof(batches) / sizeof(batches[0]); b++) {
+        for (int use_run = 0; use_run <= 1; use_run++) {
+            yyjson_ndjson *nd = yyjson_ndjson_new(dat, len, flg, NULL);
+            yy_assert(nd);
+            yy_assert(validate_ndjson(nd, dat, len, flg, batches[b], use_run,
+                                      lines) == num);
+            yyjson_ndjson_free(nd);
+
+            // read with a pool allocator
+            usize buf_len = yyjson_read_max_memory_usage(len, 0) * 2 + 65536;
+            void *buf = malloc(buf_len);
+            yyjson_alc alc;
+            yyjson_alc_pool_init(&alc, buf, buf_len);
+            nd = yyjson_ndjson_new(dat, len, flg, &alc);
+            yy_assert(nd);
+            yy_assert(validate_ndjson(nd, dat, len, flg, batches[b], use_run,
+                                      lines) == num);
+            yyjson_ndjson_free(nd);
+            free(buf);
+
+#if !YYJSON_DISABLE_FILE
+            const char *path = "__yyjson_test_ndjson__.jsonl";
+            FILE *fp = yy_file_open(path, "wb");
+            yy_assert(fp && fwrite(dat, 1, len, fp) == len);
+            fclose(fp);
+            fp = yy_file_open(path, "rb");
+            yy_assert(fp);
+            nd = yyjson_ndjson_new_fp(fp, flg, NULL);
+            yy_assert(nd);
+            yy_assert(validate_ndjson(nd, dat, len, flg, batches[b], use_run,
+                                      lines) == num);
+            yyjson_ndjson_free(nd);
+            fclose(fp);
+            yy_file_delete(path);
+#endif
+        }
+    }
+    free(lines);
+}
+
+static void test_json_ndjson(void) {
+    const char *str;
+    char *dat;
+    usize len;
+
+    // invalid parameters
+    yy_assert(!yyjson_ndjson_new(NULL, 0, 0, NULL));
+    yy_assert(yyjson_ndjson_read(NULL, NULL, 0, NULL, NULL) == 0);
+    yyjson_ndjson_free(NULL);
+#if !YYJSON_DISABLE_FILE
+    yy_assert(!yyjson_ndjson_new_fp(NULL, 0, NULL));
+#endif
+
+    // empty and blank input
+    test_ndjson_data("", 0, 0);
+    test_ndjson_data("\n\n \t\r\n  ", 8, 0);
+
+    // records
+    str = "{\"id\":1,\"tags\":[\"a\",\"b\"]}\n"
+          "[1,2,3]\r\n"
+          "\n"
+          "  \"str\"  \n"
+          "{\"id\":2,}\n"
+          "123\n"
+          "{\"id\":3} {\"id\":4}\n"
+          "[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[\n"
+          "null";
+    test_ndjson_data(str, strlen(str), 0);
+    test_ndjson_data(str, strlen(str), YYJSON_READ_ALLOW_TRAILING_COMMAS);
+    test_ndjson_data(str, strlen(str), YYJSON_READ_STOP_WHEN_DONE);
+    test_ndjson_data(str, strlen(str), YYJSON_READ_INSITU);
+
+    // CRLF line breaks, a lone CR is a part of the record
+    str = "{\"a\":1}\r\n[2]\r\n\r\n\"s\" \r\r\n3\r\n[4]\r";
+    test_ndjson_data(str, strlen(str), 0);
+    test_ndjson_data(str, strlen(str) - 1, 0);
+
+    // BOM
+    str = "\xEF\xBB\xBF{\"a\":1}\n[2]\n";
+    test_ndjson_data(str, strlen(str), YYJSON_READ_ALLOW_BOM);
+    test_ndjson_data(str + 3, strlen(str) - 3, YYJSON_READ_ALLOW_BOM);
+
+    // many records, and a line longer than the file buffer
+    dat = par_gen("", "{\"id\":%d,\"name\":\"user\"}", "\n", "\n", 5000,
+                  &len);
+    test_ndjson_data(dat, len, 0);
+    free(dat);
+    dat = par_gen("{\"id\":1}\n[", "%d", ",", "]\n[\"x\"]", 100000, &len);
+    test_ndjson_data(dat, len, 0);
+    free(dat);
+}
+
+
+/*==============================================================================
+ * MARK: - SAX
+ *============================================================================*/
+
+static bool sax_count_cb(void *ctx, yyjson_sax_event evt,
+                         const yyjson_val *val) {
+    (void)evt; (void)val;
+    (*(usize *)ctx)++;
+    return true;
+}
+
+static void test_json_sax(void) {
+    yyjson_read_err err;
+    usize num = 0, depth, i;
+    char *dat;
+    
+    // invalid parameters
+    yy_assert(!yyjson_read_sax(NULL, 1, 0, NULL, sax_count_cb, &num, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_read_sax("[]", 0, 0, NULL, sax_count_cb, &num, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_read_sax("[]", 2, 0, NULL, NULL, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_read_sax(" ", 1, 0, NULL, sax_count_cb, &num, NULL));
+    yy_assert(num == 0);
+    
+    // deep nesting, larger than the stack on the C stack
+    depth = 5000;
+#if YYJSON_READER_DEPTH_LIMIT
+    if (depth >= YYJSON_READER_DEPTH_LIMIT) depth = YYJSON_READER_DEPTH_LIMIT - 1;
+#endif
+    dat = malloc(depth * 6 + 1 + YYJSON_PADDING_SIZE);
+    yy_assert(dat);
+    for (i = 0; i < depth; i++) {
+        memcpy(dat + i * 5, (i % 2) ? "[    " : "{\"a\":", 5);
+    }
+    dat[depth * 5] = '1';
+    for (i = 0; i < depth; i++) {
+        dat[depth * 5 + 1 + i] = (char)(((depth - 1 - i) % 2) ? ']' : '}');
+    }
+    num = 0;
+    yy_assert(yyjson_read_sax(dat, depth * 6 + 1, 0, NULL,
+                              sax_count_cb, &num, &err) == depth * 6 + 1);
+    yy_assert(num == depth * 2 + (depth + 1) / 2 + 1);
+    
+    // memory allocation failure for the deep stack
+    {
+        char buf[64];
+        yyjson_alc alc;
+        yyjson_alc_pool_init(&alc, buf, sizeof(buf));
+        yy_assert(!yyjson_read_sax(dat, depth * 6 + 1, YYJSON_READ_INSITU,
+                                   &alc, sax_count_cb, &num, &err));
+        yy_assert(err.code == YYJSON_READ_ERROR_MEMORY_ALLOCATION);
+    }
+    free(dat);
+    
+    // zero-copy: the input should be padded, and some flags are not supported
+    {
+        char buf[64] = "[\"a\\nb\", \"cd\"]";
+        usize buf_len = strlen(buf);
+        yy_assert(yyjson_read_sax(buf, buf_len, YYJSON_READ_ZERO_COPY, NULL,
+                                  sax_count_cb, &num, &err) == buf_len);
+        yy_assert(!yyjson_read_sax(buf, buf_len, YYJSON_READ_ZERO_COPY |
+                                   YYJSON_READ_INSITU, NULL,
+                                   sax_count_cb, &num, &err));
+        yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+        yy_assert(!yyjson_read_sax(buf, buf_len - 2, YYJSON_READ_ZERO_COPY,
+                                   NULL, sax_count_cb, &num, &err));
+        yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    }
+}
+
+
+
+/*==============================================================================
+ * MARK: - Zero-Copy
+ *============================================================================*/
+
+static void *zc_malloc(void *ctx, usize size) {
+    usize *num = (usize *)ctx;
+    if (*num == 0) return NULL;
+    (*num)--;
+    return malloc(size);
+}
+
+static void *zc_realloc(void *ctx, void *ptr, usize old_size, usize size) {
+    usize *num = (usize *)ctx;
+    (void)old_size;
+    if (*num == 0) return NULL;
+    (*num)--;
+    return realloc(ptr, size);
+}
+
+static void zc_free(void *ctx, void *ptr) {
+    (void)ctx;
+    free(ptr);
+}
+
+static void test_json_zero_copy(void) {
+    yyjson_read_err err;
+    yyjson_doc *doc;
+    yyjson_val *val;
+    yy_buf buf;
+    usize i, num;
+    char dat[32];
+    
+    // invalid parameters
+    memset(dat, 0, sizeof(dat));
+    memcpy(dat, "[1,2]", 5);
+    yy_assert(!yyjson_read_opts(dat, 5, YYJSON_READ_ZERO_COPY |
+                                YYJSON_READ_INSITU, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_read_opts(dat, 5, YYJSON_READ_ZERO_COPY |
+                                YYJSON_READ_NUMBER_AS_RAW, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_read_opts(dat, 5, YYJSON_READ_ZERO_COPY |
+                                YYJSON_READ_JSON5, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_read_opts(dat, 4, YYJSON_READ_ZERO_COPY, NULL, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    
+    // strings are not null-terminated, the input is not modified
+    memcpy(dat, "{\"a\":\"bc\",\"d\\n\":\"e\"}", 20);
+    doc = yyjson_read(dat, 20, YYJSON_READ_ZERO_COPY);
+    yy_assert(doc);
+    yy_assert(memcmp(dat, "{\"a\":\"bc\",\"d\\n\":\"e\"}", 20) == 0);
+    val = yyjson_obj_get(yyjson_doc_get_root(doc), "a");
+    yy_assert(yyjson_equals_str(val, "bc"));
+    yy_assert(yyjson_get_str(val) == dat + 6);
+    yy_assert(yyjson_get_str(val)[2] == '"');
+    val = yyjson_obj_get(yyjson_doc_get_root(doc), "d\n");
+    yy_assert(yyjson_equals_str(val, "e"));
+    yyjson_doc_free(doc);
+    
+    // many escaped strings, the string pool grows
+    yy_assert(yy_buf_init(&buf, 0));
+    yy_assert(yy_buf_append(&buf, (u8 *)"[", 1));
+    for (i = 0; i < 1000; i++) {
+        yy_assert(yy_buf_append(&buf, (u8 *)"\"ab\\tcd\",", 9));
+    }
+    yy_assert(yy_buf_append(&buf, (u8 *)"\"ef\"]\0\0\0\0", 9));
+    num = yy_buf_len(&buf) - YYJSON_PADDING_SIZE;
+    doc = yyjson_read((char *)buf.hdr, num, YYJSON_READ_ZERO_COPY);
+    yy_assert(doc);
+    yy_assert(yyjson_arr_size(yyjson_doc_get_root(doc)) == 1001);
+    for (i = 0; i < 1000; i++) {
+        val = yyjson_arr_get(yyjson_doc_get_root(doc), i);
+        yy_assert(yyjson_equals_str(val, "ab\tcd"));
+        yy_assert(yyjson_get_str(val)[5] == '\0');
+    }
+    yyjson_doc_free(doc);
+    
+    // memory allocation failure for the string pool
+    for (i = 0; i < 4; i++) {
+        usize alc_num = i;
+        yyjson_alc alc = { zc_malloc, zc_realloc, zc_free, &alc_num };
+        doc = yyjson_read_opts((char *)buf.hdr, num, YYJSON_READ_ZERO_COPY,
+                               &alc, &err);
+        yy_assert(!doc);
+        yy_assert(err.code == YYJSON_READ_ERROR_MEMORY_ALLOCATION);
+    }
+    yy_buf_release(&buf);
+}
+
+
+
+/*==============================================================================
+ * MARK: - Reuse
+ *============================================================================*/
+
+typedef struct {
+    usize num; // number of malloc and realloc calls
+    usize live; // number of live blocks
+} reuse_cnt;
+
+static void *reuse_cnt_malloc(void *ctx, usize size) {
+    reuse_cnt *cnt = (reuse_cnt *)ctx;
+    cnt->num++;
+    cnt->live++;
+    return malloc(size);
+}
+
+static void *reuse_cnt_realloc(void *ctx, void *ptr, usize old_size,
+                               usize size) {
+    reuse_cnt *cnt = (reuse_cnt *)ctx;
+    (void)old_size;
+    cnt->num++;
+    return realloc(ptr, size);
+}
+
+static void reuse_cnt_free(void *ctx, void *ptr) {
+    reuse_cnt *cnt = (reuse_cnt *)ctx;
+    cnt->live--;
+    free(ptr);
+}
+
+static char *reuse_gen(usize num, usize *len) {
+    // array of objects with escaped strings, with padding
+    yy_buf buf;
+    usize i;
+    yy_assert(yy_buf_init(&buf, 0));
+    yy_assert(yy_buf_append(&buf, (u8 *)"[", 1));
+    for (i = 0; i < num; i++) {
+        const char *str = "{\"id\":12,\"name\":\"a\\tb\",\"ok\":true},";
+        yy_assert(yy_buf_append(&buf, (u8 *)str, strlen(str)));
+    }
+    yy_assert(yy_buf_append(&buf, (u8 *)"null]\0\0\0\0", 9));
+    *len = yy_buf_len(&buf) - YYJSON_PADDING_SIZE;
+    return (char *)buf.hdr;
+}
+
+static void test_json_reuse(void) {
+    const yyjson_read_flag flgs[] = {
+        0,
+        YYJSON_READ_INSITU,
+        YYJSON_READ_ZERO_COPY,
+        YYJSON_READ_STOP_WHEN_DONE,
+    };
+    reuse_cnt cnt = { 0, 0 };
+    yyjson_alc alc = {
+        reuse_cnt_malloc, reuse_cnt_realloc, reuse_cnt_free, &cnt
+    };
+    yyjson_read_err err;
+    yyjson_doc *doc, *ref;
+    usize i, f, len, small_len, cap;
+    char *dat, *small, *cpy;
+    
+    dat = reuse_gen(1000, &len);
+    small = reuse_gen(10, &small_len);
+    cpy = malloc(len + YYJSON_PADDING_SIZE);
+    yy_assert(cpy);
+    ref = yyjson_read(dat, len, 0);
+    yy_assert(ref);
+    
+    for (f = 0; f < sizeof(flgs) / sizeof(flgs[0]); f++) {
+        yyjson_read_flag flg = flgs[f];
+        doc = NULL;
+        for (i = 0; i < 8; i++) {
+            usize num = cnt.num;
+            char *src = (i % 2) ? small : dat;
+            usize src_len = (i % 2) ? small_len : len;
+            memcpy(cpy, src, src_len + YYJSON_PADDING_SIZE);
+            doc = yyjson_read_into(doc, cpy, src_len, flg, &alc, &err);
+            yy_assert(doc);
+            yy_assert(err.code == YYJSON_READ_SUCCESS);
+            yy_assert(yyjson_doc_get_read_size(doc) == src_len);
+            if (i % 2 == 0) {
+                yy_assert(yyjson_equals(yyjson_doc_get_root(doc),
+                                        yyjson_doc_get_root(ref)));
+            } else {
+                yy_assert(yyjson_arr_size(yyjson_doc_get_root(doc)) == 11);
+            }
+            // the memory is not shrunk or grown after the first read
+            if (i == 0) cap = yyjson_doc_get_capacity(doc);
+            yy_assert(yyjson_doc_get_capacity(doc) == cap);
+            if (i > 0) yy_assert(cnt.num == num);
+        }
+        yyjson_doc_free(doc);
+        yy_assert(cnt.live == 0);
+    }
+    
+    // reuse a document from another reader, and a container index
+    doc = yyjson_read_opts(dat, len, 0, &alc, NULL);
+    yy_assert(doc);
+    yy_assert(yyjson_doc_get_capacity(doc) == 0);
+    yy_assert(yyjson_arr_index_build(doc, yyjson_doc_get_root(doc)));
+    doc = yyjson_read_into(doc, small, small_len, 0, NULL, &err);
+    yy_assert(doc);
+    yy_assert(doc->alc.ctx == &cnt);
+    yy_assert(yyjson_doc_get_capacity(doc) > 0);
+    yy_assert(yyjson_arr_size(yyjson_doc_get_root(doc)) == 11);
+    
+    // the document is freed on error
+    doc = yyjson_read_into(doc, (char *)"[1,", 3, 0, NULL, &err);
+    yy_assert(!doc);
+    yy_assert(err.code == YYJSON_READ_ERROR_UNEXPECTED_END);
+    yy_assert(cnt.live == 0);
+    yy_assert(!yyjson_read_into(NULL, NULL, 0, 0, &alc, &err));
+    yy_assert(err.code == YYJSON_READ_ERROR_INVALID_PARAMETER);
+    yy_assert(cnt.live == 0);
+    
+    // read into a new document with the default allocator
+    doc = yyjson_read_into(NULL, small, small_len, 0, NULL, NULL);
+    yy_assert(yyjson_arr_size(yyjson_doc_get_root(doc)) == 11);
+    yyjson_doc_free(doc);
+    
+    yyjson_doc_free(ref);
+    free(cpy);
+    free(small);
+    free(dat);
+}
+
+
+
+/*==============================================================================
+ * MARK: - Precount
+ *============================================================================*/
+
+static void test_json_precount(void) {
+    yyjson_read_stats stats;
+    yyjson_doc *doc, *ref;
+    usize len;
+    const char *str;
+    char *dat;
+    
+    // the estimate is too small for short values, the count is exact
+    dat = reuse_gen(1000, &len);
+    ref = yyjson_read(dat, len, 0);
+    yy_assert(yyjson_doc_get_read_stats(ref, &stats));
+    yy_assert(stats.val_count == 7002);
+    yy_assert(stats.val_alloc < stats.val_count);
+    yy_assert(stats.val_cap >= stats.val_count);
+    yy_assert(stats.realloc_count > 0);
+    
+    doc = yyjson_read(dat, len, YYJSON_READ_PRECOUNT);
+    yy_assert(yyjson_equals(yyjson_doc_get_root(doc),
+                            yyjson_doc_get_root(ref)));
+    yy_assert(yyjson_doc_get_read_stats(doc, &stats));
+    yy_assert(stats.val_count == 7002);
+    yy_assert(stats.val_alloc == stats.val_count + 2);
+    yy_assert(stats.val_cap == stats.val_alloc);
+    yy_assert(stats.realloc_count == 0);
+    yyjson_doc_free(doc);
+    
+    doc = yyjson_read(dat, len, YYJSON_READ_PRECOUNT |
+                                YYJSON_READ_STRUCTURAL_INDEX);
+    yy_assert(yyjson_equals(yyjson_doc_get_root(doc),
+                            yyjson_doc_get_root(ref)));
+    yy_assert(yyjson_doc_get_read_stats(doc, &stats));
+    yy_assert(stats.val_alloc == stats.val_count + 2);
+    yy_assert(stats.realloc_count == 0);
+    yyjson_doc_free(doc);
+    yyjson_doc_free(ref);
+    free(dat);
+    
+    // pretty, empty containers and escaped quotes
+    str = "[\n  [ ],\n  {\"a\\\"\": { }, \"b\": [\"\\\\\", -1.5]},\n  null\n]";
+    doc = yyjson_read(str, strlen(str), YYJSON_READ_PRECOUNT);
+    yy_assert(yyjson_doc_get_read_stats(doc, &stats));
+    yy_assert(stats.val_count == 10);
+    yy_assert(stats.val_alloc == 12);
+    yy_assert(stats.realloc_count == 0);
+    yyjson_doc_free(doc);
+    
+    // a quote in a comment makes the count smaller, the values are reallocated
+    str = "[1, // \"\n 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, \"a\"]";
+    ref = yyjson_read(str, strlen(str), YYJSON_READ_ALLOW_COMMENTS);
+    doc = yyjson_read(str, strlen(str), YYJSON_READ_ALLOW_COMMENTS |
+                                        YYJSON_READ_PRECOUNT);
+    yy_assert(yyjson_equals(yyjson_doc_get_root(doc),
+                            yyjson_doc_get_root(ref)));
+    yy_assert(yyjson_doc_get_read_stats(doc, &stats));
+    yy_assert(stats.val_count == 14);
+    yy_assert(stats.val_alloc < stats.val_count);
+    yy_assert(stats.realloc_count > 0);
+    yyjson_doc_free(doc);
+    yyjson_doc_free(ref);
+    
+    // single value, and the broken input is not counted beyond the max
+    doc = yyjson_read("123", 3, YYJSON_READ_PRECOUNT);
+    yy_assert(yyjson_doc_get_read_stats(doc, &stats));
+    yy_assert(stats.val_count == 1 && stats.val_alloc == 1);
+    yyjson_doc_free(doc);
+    yy_assert(!yyjson_read("[[[[[[[[", 8, YYJSON_READ_PRECOUNT));
+    
+    // no statistics
+    yy_assert(!yyjson_doc_get_read_stats(NULL, &stats));
+    doc = yyjson_read("[1]", 3, 0);
+    yy_assert(!yyjson_doc_get_read_stats(doc, NULL));
+    yyjson_doc_free(doc);
+}
+
+
+
 /*==============================================================================
  * MARK: - Incremental
  *============================================================================*/
@@ -876,6 +2005,13 @@ yy_test_case(test_json_reader) {
     test_json_transform();
     test_json_encoding();
     test_json_whitespace();
+    test_json_whitespace_long();
+    test_json_parallel();
+    test_json_ndjson();
+    test_json_sax();
+    test_json_zero_copy();
+    test_json_reuse();
+    test_json_precount();
     test_json_incremental();
 }
 
@@ -387,6 +387,115 @@ static void test_json_arr_api(void) {
     yyjson_doc_free(doc);
 }
 
+static void validate_arr_index(yyjson_doc *doc, yyjson_val *arr) {
+    // the indexed access should be the same as the linear iteration
+    usize len = yyjson_arr_size(arr), i = 0;
+    yyjson_val **vals = (yyjson_val **)malloc((len + 1) * sizeof(void *));
+    yyjson_arr_iter iter;
+    yyjson_val *val;
+    yy_assert(vals);
+    yyjson_arr_iter_init(arr, &iter);
+    while ((val = yyjson_arr_iter_next(&iter))) vals[i++] = val;
+    vals[len] = NULL;
+    for (i = 0; i <= len; i++) {
+        yy_assert(yyjson_doc_arr_get(doc, arr, i) == vals[i]);
+    }
+    usize ranges[][2] = { {0, 0}, {0, 1}, {0, len}, {len / 2, len},
+                          {len / 3, len / 2}, {len, len + 1}, {1, 0},
+                          {len - 1, (usize)-1} };
+    for (usize r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        usize start = ranges[r][0], end = ranges[r][1];
+        i = start;
+        yy_assert(yyjson_doc_arr_slice(doc, arr, start, end, &iter));
+        while ((val = yyjson_arr_iter_next(&iter))) {
+            yy_assert(i < len && val == vals[i]);
+            i++;
+        }
+        if (end > len) end = len;
+        yy_assert(i == (start < end ? end : start));
+    }
+    free(vals);
+}
+
+static void test_json_arr_index_api(void) {
+    usize sizes[] = { 0, 1, 5, 31, 32, 33, 1000, 100000 };
+    yyjson_arr_iter iter;
+    yyjson_doc *doc, *doc2;
+    yyjson_val *arr, *val;
+    const char *json;
+
+    for (usize i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        usize cap = sizes[i] * 32 + 64, len = 0;
+        char *str = (char *)malloc(cap);
+        yy_assert(str);
+        len += (usize)snprintf(str + len, cap - len, "[");
+        for (usize j = 0; j < sizes[i]; j++) {
+            if (j) str[len++] = ',';
+            if (j % 3 == 0) {
+                len += (usize)snprintf(str + len, cap - len,
+                                       "{\"id\":%d,\"v\":[1,[2]]}", (int)j);
+            } else {
+                len += (usize)snprintf(str + len, cap - len, "%d", (int)j);
+            }
+        }
+        len += (usize)snprintf(str + len, cap - len, "]");
+        doc = yyjson_read(str, len, 0);
+        yy_assert(doc);
+        arr = yyjson_doc_get_root(doc);
+
+        // build on the first access
+        yy_assert(yyjson_doc_index_size(doc) == 0);
+        validate_arr_index(doc, arr);
+        yy_assert((yyjson_doc_index_size(doc) > 0) == (sizes[i] >= 32));
+
+        // build explicitly
+        yyjson_doc_index_free(doc);
+        yy_assert(yyjson_arr_index_build(doc, arr));
+        yy_assert(yyjson_arr_index_build(doc, arr));
+        yy_assert((yyjson_doc_index_size(doc) > 0) == (sizes[i] > 0));
+        validate_arr_index(doc, arr);
+
+        // build for all arrays, including the nested flat ones
+        yyjson_doc_index_free(doc);
+        yy_assert(yyjson_doc_arr_index_build(doc, 0));
+        yy_assert((yyjson_doc_index_size(doc) > 0) == (sizes[i] > 0));
+        validate_arr_index(doc, arr);
+        yyjson_arr_iter_init(arr, &iter);
+        while ((val = yyjson_arr_iter_next(&iter))) {
+            val = yyjson_obj_get(val, "v");
+            if (val) validate_arr_index(doc, val);
+        }
+        yyjson_doc_free(doc);
+        free(str);
+    }
+
+    // invalid parameters
+    json = "[1,[2],{\"a\":[3,[4]]}]";
+    doc = yyjson_read(json, strlen(json), 0);
+    doc2 = yyjson_read(json, strlen(json), 0);
+    arr = yyjson_doc_get_root(doc);
+    yy_assert(!yyjson_arr_index_build(NULL, arr));
+    yy_assert(!yyjson_arr_index_build(doc, NULL));
+    yy_assert(!yyjson_arr_index_build(doc, yyjson_arr_get(arr, 2)));
+    yy_assert(!yyjson_arr_index_build(doc2, arr));
+    yy_assert(yyjson_arr_index_build(doc, yyjson_arr_get(arr, 1)));
+    yy_assert(!yyjson_doc_arr_index_build(NULL, 0));
+    yy_assert(yyjson_get_int(yyjson_doc_arr_get(NULL, arr, 0)) == 1);
+    yy_assert(yyjson_doc_arr_get(doc, NULL, 0) == NULL);
+    yy_assert(yyjson_doc_arr_get(doc, yyjson_arr_get(arr, 2), 0) == NULL);
+    yy_assert(yyjson_arr_index_build(doc, arr));
+    yy_assert(yyjson_doc_arr_get(doc, arr, 2) == yyjson_arr_get(arr, 2));
+    yy_assert(yyjson_doc_arr_get(doc, arr, 3) == NULL);
+    yy_assert(!yyjson_doc_arr_slice(doc, NULL, 0, 1, &iter));
+    yy_assert(!yyjson_arr_iter_has_next(&iter));
+    yy_assert(!yyjson_doc_arr_slice(doc, arr, 0, 1, NULL));
+    yy_assert(yyjson_doc_arr_slice(NULL, arr, 1, 2, &iter));
+    yy_assert(yyjson_arr_iter_next(&iter) == yyjson_arr_get(arr, 1));
+    yy_assert(yyjson_arr_iter_next(&iter) == NULL);
+    yyjson_doc_free(doc);
+    yyjson_doc_free(doc2);
+}
+
 /// Test json object api
 static void test_json_obj_api(void) {
     yyjson_doc *doc;
@@ -717,6 +826,144 @@ static void test_json_obj_api(void) {
     yyjson_doc_free(doc);
 }
 
+static void validate_obj_index(yyjson_doc *doc, yyjson_val *obj) {
+    // the indexed lookup should be the same as the linear search
+    yyjson_val *key, *val;
+    yyjson_obj_iter iter = yyjson_obj_iter_with(obj);
+    while ((key = yyjson_obj_iter_next(&iter))) {
+        val = yyjson_doc_obj_getn(doc, obj, yyjson_get_str(key),
+                                  yyjson_get_len(key));
+        yy_assert(val == yyjson_obj_getn(obj, yyjson_get_str(key),
+                                         yyjson_get_len(key)));
+        yy_assert(val != NULL);
+    }
+    const char *missing[] = { "", "x", "key", "key_", "key_1x", "long_key_0",
+                              "long_key_000000", "\"" };
+    for (usize i = 0; i < sizeof(missing) / sizeof(missing[0]); i++) {
+        yy_assert(yyjson_doc_obj_get(doc, obj, missing[i]) ==
+                  yyjson_obj_get(obj, missing[i]));
+    }
+    yy_assert(yyjson_doc_obj_get(doc, obj, NULL) == NULL);
+}
+
+// generate an object with `num` keys, the values are nested containers
+static char *gen_obj_json(usize num) {
+    usize cap = num * 64 + 64, len = 0;
+    char *json = (char *)malloc(cap);
+    yy_assert(json);
+    len += (usize)snprintf(json + len, cap - len, "{");
+    for (usize i = 0; i < num; i++) {
+        if (i) json[len++] = ',';
+        switch (i % 4) {
+            case 0: len += (usize)snprintf(json + len, cap - len,
+                "\"key_%d\":{\"key_%d\":[1,2]}", (int)i, (int)i); break;
+            case 1: len += (usize)snprintf(json + len, cap - len,
+                "\"long_key_%08d\":[[],{}]", (int)i); break;
+            case 2: len += (usize)snprintf(json + len, cap - len,
+                "\"k\\u0000%d\":%d", (int)i, (int)i); break;
+            default: len += (usize)snprintf(json + len, cap - len,
+                "\"key_%d\":\"v\",\"key_%d\":\"dup\"", (int)(i - 1),
+                (int)i); break;
+        }
+    }
+    len += (usize)snprintf(json + len, cap - len, "}");
+    return json;
+}
+
+static void test_json_obj_index_api(void) {
+    usize sizes[] = { 0, 1, 5, 31, 32, 33, 300, 5000 };
+    yyjson_doc *doc, *doc2;
+    yyjson_val *obj, *val;
+    const char *json;
+    char *str;
+
+    for (usize i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        str = gen_obj_json(sizes[i]);
+        doc = yyjson_read(str, strlen(str), 0);
+        yy_assert(doc);
+        obj = yyjson_doc_get_root(doc);
+
+        // build on the first lookup
+        yy_assert(yyjson_doc_index_size(doc) == 0);
+        validate_obj_index(doc, obj);
+        yy_assert((yyjson_doc_index_size(doc) > 0) ==
+                  (yyjson_obj_size(obj) >= 32));
+
+        // build explicitly
+        yy_assert(yyjson_obj_index_build(doc, obj));
+        yy_assert(yyjson_obj_index_build(doc, obj));
+        yy_assert(yyjson_doc_index_size(doc) > 0);
+        validate_obj_index(doc, obj);
+        yyjson_obj_iter iter = yyjson_obj_iter_with(obj);
+        while ((val = yyjson_obj_iter_next(&iter))) {
+            val = yyjson_obj_iter_get_val(val);
+            if (yyjson_is_obj(val)) {
+                yy_assert(yyjson_obj_index_build(doc, val));
+                validate_obj_index(doc, val);
+            }
+        }
+
+        // free the indexes
+        yyjson_doc_index_free(doc);
+        yy_assert(yyjson_doc_index_size(doc) == 0);
+        validate_obj_index(doc, obj);
+        yyjson_doc_free(doc);
+
+        // build with a small memory pool
+        char buf[1024 * 64];
+        yyjson_alc alc;
+        usize len = strlen(str);
+        if (yyjson_read_max_memory_usage(len, 0) < sizeof(buf) / 2) {
+            yyjson_alc_pool_init(&alc, buf, sizeof(buf));
+            doc = yyjson_read_opts(str, len, 0, &alc, NULL);
+            yy_assert(doc);
+            obj = yyjson_doc_get_root(doc);
+            yyjson_obj_index_build(doc, obj);
+            validate_obj_index(doc, obj);
+            yyjson_doc_free(doc);
+        }
+        free(str);
+    }
+
+    // many objects in one document
+    str = gen_obj_json(3000);
+    doc = yyjson_read(str, strlen(str), 0);
+    obj = yyjson_doc_get_root(doc);
+    yyjson_obj_iter iter = yyjson_obj_iter_with(obj);
+    while ((val = yyjson_obj_iter_next(&iter))) {
+        val = yyjson_obj_iter_get_val(val);
+        if (yyjson_is_obj(val)) yy_assert(yyjson_obj_index_build(doc, val));
+    }
+    iter = yyjson_obj_iter_with(obj);
+    while ((val = yyjson_obj_iter_next(&iter))) {
+        val = yyjson_obj_iter_get_val(val);
+        if (yyjson_is_obj(val)) validate_obj_index(doc, val);
+    }
+    yyjson_doc_free(doc);
+    free(str);
+
+    // invalid parameters
+    json = "{\"a\":1,\"b\":[2]}";
+    doc = yyjson_read(json, strlen(json), 0);
+    doc2 = yyjson_read(json, strlen(json), 0);
+    obj = yyjson_doc_get_root(doc);
+    yy_assert(!yyjson_obj_index_build(NULL, obj));
+    yy_assert(!yyjson_obj_index_build(doc, NULL));
+    yy_assert(!yyjson_obj_index_build(doc, yyjson_obj_get(obj, "b")));
+    yy_assert(!yyjson_obj_index_build(doc2, obj));
+    yy_assert(yyjson_get_int(yyjson_doc_obj_get(NULL, obj, "a")) == 1);
+    yy_assert(yyjson_doc_obj_get(doc, NULL, "a") == NULL);
+    yy_assert(yyjson_doc_obj_get(doc, yyjson_obj_get(obj, "b"), "a") == NULL);
+    yy_assert(yyjson_obj_index_build(doc, obj));
+    yy_assert(yyjson_get_int(yyjson_doc_obj_get(doc, obj, "a")) == 1);
+    yy_assert(yyjson_doc_obj_getn(doc, obj, "ab", 1) ==
+              yyjson_obj_get(obj, "a"));
+    yy_assert(yyjson_doc_index_size(NULL) == 0);
+    yyjson_doc_index_free(NULL);
+    yyjson_doc_free(doc);
+    yyjson_doc_free(doc2);
+}
+
 static void validate_equals(const char *lhs_json, const char *rhs_json, bool equals) {
     yyjson_doc *lhs_doc = yyjson_read(lhs_json, strlen(lhs_json), 0);
     yyjson_doc *rhs_doc = yyjson_read(rhs_json, strlen(rhs_json), 0);
@@ -829,7 +1076,9 @@ static void test_json_equals_api(void) {
 yy_test_case(test_json_val) {
     test_json_val_api();
     test_json_arr_api();
+    test_json_arr_index_api();
     test_json_obj_api();
+    test_json_obj_index_api();
     test_json_equals_api();
 }
 
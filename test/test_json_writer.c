@@ -441,14 +441,14 @@ static void test_json_write(yyjson_alc *alc) {
     
     // invalid
     root = yyjson_mut_null(doc);
-    root->tag = 0;
+    unsafe_yyjson_mut_set_tag(root, YYJSON_TYPE_NONE, YYJSON_SUBTYPE_NONE, 0);
     yyjson_mut_doc_set_root(doc, root);
     validate_json_write(doc, alc, NULL, NULL);
     
     root = yyjson_mut_arr(doc);
     yyjson_mut_doc_set_root(doc, root);
     val = yyjson_mut_null(doc);
-    val->tag = 0;
+    unsafe_yyjson_mut_set_tag(val, YYJSON_TYPE_NONE, YYJSON_SUBTYPE_NONE, 0);
     yyjson_mut_arr_add_val(root, val);
     validate_json_write(doc, alc, NULL, NULL);
     
@@ -836,6 +836,715 @@ static void test_json_write(yyjson_alc *alc) {
     yyjson_mut_doc_free(doc);
 }
 
+/*==============================================================================
+ * MARK: - Stream
+ *============================================================================*/
+
+typedef struct {
+    char *dat;
+    usize len;
+    usize cap;
+    usize calls;
+    usize fail_at; /* fail on this call if not zero */
+} stream_buf;
+
+static bool stream_sink(void *ctx, const char *dat, size_t len) {
+    stream_buf *buf = (stream_buf *)ctx;
+    buf->calls++;
+    yy_assert(dat && len > 0);
+    if (buf->fail_at && buf->calls == buf->fail_at) return false;
+    if (buf->len + len > buf->cap) {
+        buf->cap = (buf->len + len) * 2;
+        buf->dat = (char *)realloc(buf->dat, buf->cap);
+        yy_assert(buf->dat);
+    }
+    memcpy(buf->dat + buf->len, dat, len);
+    buf->len += len;
+    return true;
+}
+
+static void validate_json_write_stream(yyjson_mut_doc *mdoc) {
+    yyjson_write_flag flgs[] = {
+        0, YYJSON_WRITE_PRETTY, YYJSON_WRITE_PRETTY_TWO_SPACES,
+        YYJSON_WRITE_NEWLINE_AT_END,
+        YYJSON_WRITE_PRETTY | YYJSON_WRITE_NEWLINE_AT_END,
+        YYJSON_WRITE_ESCAPE_UNICODE | YYJSON_WRITE_ESCAPE_SLASHES,
+        YYJSON_WRITE_ALLOW_INVALID_UNICODE | YYJSON_WRITE_ALLOW_INF_AND_NAN,
+        YYJSON_WRITE_PRETTY | YYJSON_WRITE_ESCAPE_UNICODE |
+        YYJSON_WRITE_ALLOW_INVALID_UNICODE | YYJSON_WRITE_INF_AND_NAN_AS_NULL,
+        YYJSON_WRITE_PRETTY_TWO_SPACES | YYJSON_WRITE_FP_TO_FIXED(3),
+        YYJSON_WRITE_FP_TO_FLOAT
+    };
+    usize buf_lens[] = { 0, 1, 2, 7, 16, 64, 1000 };
+    yyjson_doc *idoc = yyjson_mut_doc_imut_copy(mdoc, NULL);
+    usize f, b;
+    yy_assert(idoc);
+    
+    for (f = 0; f < yy_nelems(flgs); f++) {
+        usize len;
+        char *ret = yyjson_mut_write(mdoc, flgs[f], &len);
+        yy_assert(ret);
+        for (b = 0; b < yy_nelems(buf_lens); b++) {
+            stream_buf buf;
+            yyjson_write_err err;
+            usize out;
+            
+            memset(&buf, 0, sizeof(buf));
+            out = yyjson_mut_write_stream(mdoc, flgs[f], NULL, buf_lens[b],
+                                          stream_sink, &buf, &err);
+            yy_assert(out == len && buf.len == len);
+            yy_assert(err.code == YYJSON_WRITE_SUCCESS);
+            yy_assert(memcmp(buf.dat, ret, len) == 0);
+            
+            buf.len = buf.calls = 0;
+            out = yyjson_mut_val_write_stream(yyjson_mut_doc_get_root(mdoc),
+                                              flgs[f], NULL, buf_lens[b],
+                                              stream_sink, &buf, NULL);
+            yy_assert(out == len && buf.len == len);
+            yy_assert(memcmp(buf.dat, ret, len) == 0);
+            
+            buf.len = buf.calls = 0;
+            out = yyjson_write_stream(idoc, flgs[f], NULL, buf_lens[b],
+                                      stream_sink, &buf, &err);
+            yy_assert(out == len && buf.len == len);
+            yy_assert(err.code == YYJSON_WRITE_SUCCESS);
+            yy_assert(memcmp(buf.dat, ret, len) == 0);
+            
+            buf.len = buf.calls = 0;
+            out = yyjson_val_write_stream(yyjson_doc_get_root(idoc),
+                                          flgs[f], NULL, buf_lens[b],
+                                          stream_sink, &buf, NULL);
+            yy_assert(out == len && buf.len == len);
+            yy_assert(memcmp(buf.dat, ret, len) == 0);
+            
+            /* the output is flushed in pieces with a small buffer */
+            if (buf_lens[b] && buf_lens[b] < 100 && len > 1000) {
+                yy_assert(buf.calls > 10);
+            }
+            
+            /* sink failure stops the writer */
+            if (buf.calls > 1) {
+                usize calls = buf.calls;
+                buf.len = buf.calls = 0;
+                buf.fail_at = calls - 1;
+                out = yyjson_mut_write_stream(mdoc, flgs[f], NULL,
+                                              buf_lens[b], stream_sink,
+                                              &buf, &err);
+                yy_assert(out == 0);
+                yy_assert(err.code == YYJSON_WRITE_ERROR_FILE_WRITE);
+                yy_assert(buf.calls == calls - 1);
+                
+                buf.len = buf.calls = 0;
+                buf.fail_at = calls;
+                out = yyjson_write_stream(idoc, flgs[f], NULL, buf_lens[b],
+                                          stream_sink, &buf, &err);
+                yy_assert(out == 0);
+                yy_assert(err.code == YYJSON_WRITE_ERROR_FILE_WRITE);
+            }
+            free(buf.dat);
+        }
+        free(ret);
+    }
+    yyjson_doc_free(idoc);
+}
+
+static void test_json_write_stream(void) {
+    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
+    yyjson_mut_val *root, *arr, *obj;
+    char long_str[300];
+    usize i;
+    
+    // scalar roots
+    yyjson_mut_doc_set_root(doc, yyjson_mut_int(doc, -123));
+    validate_json_write_stream(doc);
+    yyjson_mut_doc_set_root(doc, yyjson_mut_str(doc, "abc"));
+    validate_json_write_stream(doc);
+    yyjson_mut_doc_set_root(doc, yyjson_mut_arr(doc));
+    validate_json_write_stream(doc);
+    yyjson_mut_doc_set_root(doc, yyjson_mut_obj(doc));
+    validate_json_write_stream(doc);
+    
+    // nested containers with long strings
+    memset(long_str, 'x', sizeof(long_str) - 1);
+    long_str[sizeof(long_str) - 1] = '\0';
+    long_str[100] = '\n';
+    root = yyjson_mut_obj(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    yyjson_mut_obj_add_str(doc, root, "uni", "\xE2\x82\xAC/\xF0\x9D\x84\x9E");
+    yyjson_mut_obj_add_real(doc, root, "real", 1.25);
+    yyjson_mut_obj_add_null(doc, root, "null");
+    yyjson_mut_obj_add_arr(doc, root, "empty_arr");
+    yyjson_mut_obj_add_obj(doc, root, "empty_obj");
+    arr = yyjson_mut_obj_add_arr(doc, root, "arr");
+    for (i = 0; i < 50; i++) {
+        obj = yyjson_mut_arr_add_obj(doc, arr);
+        yyjson_mut_obj_add_uint(doc, obj, "id", i);
+        yyjson_mut_obj_add_bool(doc, obj, "odd", (i % 2) == 1);
+        yyjson_mut_arr_add_arr(doc, yyjson_mut_obj_add_arr(doc, obj, "nest"));
+    }
+    yyjson_mut_obj_add_str(doc, root, "long", long_str);
+    validate_json_write_stream(doc);
+    
+    // invalid parameters
+    {
+        stream_buf buf;
+        yyjson_write_err err;
+        memset(&buf, 0, sizeof(buf));
+        yy_assert(!yyjson_mut_write_stream(NULL, 0, NULL, 0,
+                                           stream_sink, &buf, &err));
+        yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+        yy_assert(!yyjson_mut_write_stream(doc, 0, NULL, 0,
+                                           NULL, &buf, &err));
+        yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+        yy_assert(!yyjson_write_stream(NULL, 0, NULL, 0,
+                                       stream_sink, &buf, &err));
+        yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+        yy_assert(!yyjson_val_write_stream(NULL, 0, NULL, 0,
+                                           stream_sink, &buf, &err));
+        yy_assert(!yyjson_mut_val_write_stream(NULL, 0, NULL, 0,
+                                               stream_sink, &buf, NULL));
+        yy_assert(buf.calls == 0);
+    }
+    
+    yyjson_mut_doc_free(doc);
+}
+
+/*==============================================================================
+ * MARK: - Parallel
+ *============================================================================*/
+
+// run the tasks in reverse order
+static void test_par_run(void *ctx, yyjson_par_task task, void *arg,
+                         size_t num) {
+    usize *count = (usize *)ctx;
+    while (num > 0) task(arg, --num);
+    (*count)++;
+}
+
+static void validate_json_write_par(yyjson_mut_doc *mdoc, bool split) {
+    // write in parallel, the output should be the same as serial writing
+    yyjson_write_flag flgs[] = {
+        0, YYJSON_WRITE_PRETTY, YYJSON_WRITE_PRETTY_TWO_SPACES,
+        YYJSON_WRITE_NEWLINE_AT_END,
+        YYJSON_WRITE_PRETTY | YYJSON_WRITE_NEWLINE_AT_END,
+        YYJSON_WRITE_ESCAPE_UNICODE | YYJSON_WRITE_ESCAPE_SLASHES,
+        YYJSON_WRITE_ALLOW_INVALID_UNICODE | YYJSON_WRITE_ALLOW_INF_AND_NAN,
+        YYJSON_WRITE_PRETTY | YYJSON_WRITE_ESCAPE_UNICODE |
+        YYJSON_WRITE_ALLOW_INVALID_UNICODE | YYJSON_WRITE_INF_AND_NAN_AS_NULL,
+        YYJSON_WRITE_PRETTY_TWO_SPACES | YYJSON_WRITE_FP_TO_FIXED(3),
+        YYJSON_WRITE_FP_TO_FLOAT
+    };
+    usize par_nums[] = { 1, 2, 3, 8 };
+    yyjson_doc *idoc = yyjson_mut_doc_imut_copy(mdoc, NULL);
+    usize f, p;
+    yy_assert(idoc);
+    
+    for (f = 0; f < yy_nelems(flgs); f++) {
+        yyjson_write_err ref_err, err;
+        usize ref_len, len;
+        char *ref = yyjson_write_opts(idoc, flgs[f], NULL, &ref_len, &ref_err);
+        for (p = 0; p < yy_nelems(par_nums); p++) {
+            for (int use_run = 0; use_run <= 1; use_run++) {
+                usize count = 0;
+                char *ret = yyjson_write_par(idoc, flgs[f], NULL, par_nums[p],
+                                             use_run ? test_par_run : NULL,
+                                             &count, &len, &err);
+                yy_assert((ret != NULL) == (ref != NULL));
+                yy_assert(err.code == ref_err.code);
+                yy_assert((err.msg == NULL) == (ref_err.msg == NULL));
+                yy_assert(len == (ref ? ref_len : 0));
+                if (ref) yy_assert(memcmp(ret, ref, len + 1) == 0);
+                // the tasks run twice: write and concatenate
+                if (use_run && par_nums[p] > 1) {
+                    yy_assert(count == (split ? (usize)(ref ? 2 : 1) : 0));
+                }
+                free(ret);
+                
+                ret = yyjson_val_write_par(yyjson_doc_get_root(idoc),
+                                           flgs[f], NULL, par_nums[p],
+                                           NULL, NULL, NULL, NULL);
+                yy_assert((ret != NULL) == (ref != NULL));
+                if (ref) yy_assert(strcmp(ret, ref) == 0);
+                free(ret);
+            }
+        }
+        free(ref);
+    }
+    yyjson_doc_free(idoc);
+}
+
+static void test_json_write_par(void) {
+    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
+    yyjson_mut_val *root, *obj, *bad = NULL;
+    yyjson_write_err err;
+    usize i;
+    
+    // scalar, empty and small roots are written serially
+    yyjson_mut_doc_set_root(doc, yyjson_mut_int(doc, -123));
+    validate_json_write_par(doc, false);
+    yyjson_mut_doc_set_root(doc, yyjson_mut_arr(doc));
+    validate_json_write_par(doc, false);
+    root = yyjson_mut_arr(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    yyjson_mut_arr_add_str(doc, root, "abc");
+    validate_json_write_par(doc, false);
+    
+    // large array of nested objects, with raw values containing newlines
+    for (i = 0; i < 20000; i++) {
+        obj = yyjson_mut_arr_add_obj(doc, root);
+        yyjson_mut_obj_add_uint(doc, obj, "id", i);
+        yyjson_mut_obj_add_str(doc, obj, "str", "a\"b\\c/\xE2\x82\xAC");
+        yyjson_mut_obj_add_real(doc, obj, "real", (double)i / 8);
+        yyjson_mut_obj_add_arr(doc, obj, "empty");
+        yyjson_mut_arr_add_null(doc, yyjson_mut_obj_add_arr(doc, obj, "arr"));
+        if (i % 100 == 0) {
+            yyjson_mut_arr_append(root, yyjson_mut_raw(doc, "[1,\n2]"));
+        }
+    }
+    validate_json_write_par(doc, true);
+    
+    // large object
+    root = yyjson_mut_obj(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    for (i = 0; i < 20000; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "key%d", (int)i);
+        obj = yyjson_mut_obj(doc);
+        yyjson_mut_obj_add(root, yyjson_mut_strcpy(doc, key), obj);
+        yyjson_mut_obj_add_bool(doc, obj, "odd", (i % 2) == 1);
+        yyjson_mut_obj_add_str(doc, obj, "name", "value");
+        if (i == 12345) bad = obj;
+    }
+    validate_json_write_par(doc, true);
+    
+    // the first error is the same as the serial writer
+    yy_assert(yyjson_mut_obj_add_strn(doc, bad, "bad", "\xFF", 1));
+    yy_assert(yyjson_mut_obj_add_strn(doc, root, "bad", "\xFF", 1));
+    validate_json_write_par(doc, true);
+    
+    // invalid parameters
+    yy_assert(!yyjson_write_par(NULL, 0, NULL, 4, NULL, NULL, NULL, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_val_write_par(NULL, 0, NULL, 4, NULL, NULL, NULL, NULL));
+    
+    yyjson_mut_doc_free(doc);
+}
+
+/*==============================================================================
+ * MARK: - Presize
+ *============================================================================*/
+
+static usize presize_realloc_count;
+
+static void *presize_malloc(void *ctx, usize size) {
+    (void)ctx;
+    return malloc(size);
+}
+
+static void *presize_realloc(void *ctx, void *ptr, usize old_size,
+                             usize size) {
+    (void)ctx; (void)old_size;
+    presize_realloc_count++;
+    return realloc(ptr, size);
+}
+
+static void presize_free(void *ctx, void *ptr) {
+    (void)ctx;
+    free(ptr);
+}
+
+static void validate_json_write_presize(yyjson_mut_doc *mdoc) {
+    yyjson_write_flag flgs[] = {
+        0, YYJSON_WRITE_PRETTY, YYJSON_WRITE_PRETTY_TWO_SPACES,
+        YYJSON_WRITE_NEWLINE_AT_END,
+        YYJSON_WRITE_PRETTY | YYJSON_WRITE_NEWLINE_AT_END,
+        YYJSON_WRITE_ESCAPE_UNICODE | YYJSON_WRITE_ESCAPE_SLASHES,
+        YYJSON_WRITE_ALLOW_INVALID_UNICODE | YYJSON_WRITE_ALLOW_INF_AND_NAN,
+        YYJSON_WRITE_PRETTY | YYJSON_WRITE_ESCAPE_UNICODE |
+        YYJSON_WRITE_ALLOW_INVALID_UNICODE | YYJSON_WRITE_INF_AND_NAN_AS_NULL,
+        YYJSON_WRITE_PRETTY_TWO_SPACES | YYJSON_WRITE_FP_TO_FIXED(3),
+        YYJSON_WRITE_FP_TO_FLOAT
+    };
+    yyjson_alc alc = { presize_malloc, presize_realloc, presize_free, NULL };
+    yyjson_doc *idoc = yyjson_mut_doc_imut_copy(mdoc, NULL);
+    yyjson_write_flag pre = YYJSON_WRITE_PRESIZE;
+    usize f, p;
+    yy_assert(idoc);
+
+    for (f = 0; f < yy_nelems(flgs); f++) {
+        yyjson_write_flag flg = flgs[f];
+        yyjson_write_err err;
+        yyjson_write_code code;
+        usize len, out_len, buf_len;
+        char *ret, *out, *buf;
+
+        ret = yyjson_mut_write_opts(mdoc, flg, NULL, &len, &err);
+        if (!ret) {
+            // the same error as the default writer
+            code = err.code;
+            yy_assert(!yyjson_mut_write_len(mdoc, flg, NULL, &err));
+            yy_assert(err.code == code);
+            yy_assert(!yyjson_write_len(idoc, flg, NULL, &err));
+            yy_assert(err.code == code);
+            yy_assert(!yyjson_mut_write_opts(mdoc, flg | pre, &alc,
+                                             NULL, &err));
+            yy_assert(err.code == code);
+            yy_assert(!yyjson_write_opts(idoc, flg | pre, &alc, NULL, &err));
+            yy_assert(err.code == code);
+            continue;
+        }
+
+        // exact length
+        yy_assert(yyjson_mut_write_len(mdoc, flg, NULL, &err) == len);
+        yy_assert(err.code == YYJSON_WRITE_SUCCESS);
+        yy_assert(yyjson_write_len(idoc, flg, NULL, &err) == len);
+        yy_assert(err.code == YYJSON_WRITE_SUCCESS);
+        yy_assert(yyjson_mut_val_write_len(yyjson_mut_doc_get_root(mdoc),
+                                           flg, &alc, NULL) == len);
+        yy_assert(yyjson_val_write_len(yyjson_doc_get_root(idoc),
+                                       flg, &alc, NULL) == len);
+
+        // allocate the output once, same output as the default writer
+        presize_realloc_count = 0;
+        out = yyjson_mut_write_opts(mdoc, flg | pre, &alc, &out_len, &err);
+        yy_assert(out && out_len == len && memcmp(out, ret, len + 1) == 0);
+        yy_assert(err.code == YYJSON_WRITE_SUCCESS);
+        free(out);
+        out = yyjson_write_opts(idoc, flg | pre, &alc, &out_len, &err);
+        yy_assert(out && out_len == len && memcmp(out, ret, len + 1) == 0);
+        yy_assert(err.code == YYJSON_WRITE_SUCCESS);
+        free(out);
+        yy_assert(presize_realloc_count == 0);
+
+        // exactly sized buffer, with or without the flag, no allocation
+        buf_len = len + 1;
+        buf = (char *)malloc(buf_len);
+        for (p = 0; p < 2; p++) {
+            yyjson_write_flag bflg = p ? (flg | pre) : flg;
+            memset(buf, 0, buf_len);
+            yy_assert(yyjson_mut_write_buf(buf, buf_len, mdoc, bflg,
+                                           &err) == len);
+            yy_assert(err.code == YYJSON_WRITE_SUCCESS);
+            yy_assert(memcmp(buf, ret, len + 1) == 0);
+            memset(buf, 0, buf_len);
+            yy_assert(yyjson_mut_val_write_buf(buf, buf_len,
+                                               yyjson_mut_doc_get_root(mdoc),
+                                               bflg, &err) == len);
+            yy_assert(memcmp(buf, ret, len + 1) == 0);
+            memset(buf, 0, buf_len);
+            yy_assert(yyjson_write_buf(buf, buf_len, idoc, bflg,
+                                       &err) == len);
+            yy_assert(err.code == YYJSON_WRITE_SUCCESS);
+            yy_assert(memcmp(buf, ret, len + 1) == 0);
+            memset(buf, 0, buf_len);
+            yy_assert(yyjson_val_write_buf(buf, buf_len,
+                                           yyjson_doc_get_root(idoc),
+                                           bflg, &err) == len);
+            yy_assert(memcmp(buf, ret, len + 1) == 0);
+
+            // one byte less is too small
+            yy_assert(!yyjson_mut_write_buf(buf, len, mdoc, bflg, &err));
+            yy_assert(err.code == YYJSON_WRITE_ERROR_MEMORY_ALLOCATION);
+            yy_assert(!yyjson_write_buf(buf, len, idoc, bflg, &err));
+            yy_assert(err.code == YYJSON_WRITE_ERROR_MEMORY_ALLOCATION);
+        }
+        free(buf);
+
+        // larger buffer
+        buf_len = len * 2 + 4096;
+        buf = (char *)malloc(buf_len);
+        yy_assert(yyjson_mut_write_buf(buf, buf_len, mdoc, flg | pre,
+                                       &err) == len);
+        yy_assert(err.code == YYJSON_WRITE_SUCCESS);
+        yy_assert(memcmp(buf, ret, len + 1) == 0);
+        memset(buf, 0, buf_len);
+        yy_assert(yyjson_write_buf(buf, buf_len, idoc, flg | pre,
+                                   &err) == len);
+        yy_assert(memcmp(buf, ret, len + 1) == 0);
+        free(buf);
+        free(ret);
+    }
+    yyjson_doc_free(idoc);
+}
+
+static void test_json_write_presize(void) {
+    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
+    yyjson_mut_val *root, *obj;
+    yyjson_write_err err;
+    usize i;
+
+    // scalar roots
+    yyjson_mut_doc_set_root(doc, yyjson_mut_real(doc, 0.1));
+    validate_json_write_presize(doc);
+    yyjson_mut_doc_set_root(doc, yyjson_mut_str(doc, "a/\xE2\x82\xAC"));
+    validate_json_write_presize(doc);
+    yyjson_mut_doc_set_root(doc, yyjson_mut_arr(doc));
+    validate_json_write_presize(doc);
+
+    // large document, larger than the buffer of the streaming writer
+    root = yyjson_mut_arr(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    for (i = 0; i < 5000; i++) {
+        obj = yyjson_mut_arr_add_obj(doc, root);
+        yyjson_mut_obj_add_uint(doc, obj, "id", i);
+        yyjson_mut_obj_add_real(doc, obj, "val", (double)i / 7);
+        yyjson_mut_obj_add_str(doc, obj, "path", "/a/b\n\xF0\x9D\x84\x9E");
+    }
+    validate_json_write_presize(doc);
+
+    // long strings, escaped in pieces at the end of an exactly sized buffer,
+    // with characters across the pieces
+    {
+        const char *pat[] = {
+            "ab\"", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9D\x84\x9E", "\n/",
+            "\x01", "xyz"
+        };
+        char str[4096];
+        usize len = 0, n;
+        for (i = 0; len + 8 < sizeof(str); i++) {
+            n = strlen(pat[i % yy_nelems(pat)]);
+            memcpy(str + len, pat[i % yy_nelems(pat)], n);
+            len += n;
+        }
+        yyjson_mut_doc_set_root(doc, yyjson_mut_strncpy(doc, str, len));
+        validate_json_write_presize(doc);
+        root = yyjson_mut_arr(doc);
+        yyjson_mut_doc_set_root(doc, root);
+        yyjson_mut_arr_add_strncpy(doc, root, str, len);
+        yyjson_mut_arr_add_strncpy(doc, root, str + 1, len - 1);
+        yyjson_mut_arr_add_strncpy(doc, root, str + 3, len - 3);
+        validate_json_write_presize(doc);
+        for (n = 0; n < 5000; n++) yyjson_mut_arr_add_uint(doc, root, n);
+        validate_json_write_presize(doc); // escaped in place
+        str[100] = (char)0xC0;
+        str[len - 2] = (char)0xF0;
+        yyjson_mut_arr_add_strncpy(doc, root, str, len);
+        yyjson_mut_arr_append(root, yyjson_mut_rawncpy(doc, str, len));
+        validate_json_write_presize(doc);
+    }
+
+    // errors are the same as the default writer
+    root = yyjson_mut_arr(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    yyjson_mut_arr_add_real(doc, root, INFINITY);
+    yy_assert(!yyjson_mut_write_len(doc, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_NAN_OR_INF);
+    yy_assert(!yyjson_mut_write_opts(doc, YYJSON_WRITE_PRESIZE, NULL, NULL,
+                                     &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_NAN_OR_INF);
+    yy_assert(!yyjson_write_len(NULL, 0, NULL, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_val_write_len(NULL, 0, NULL, NULL));
+    yy_assert(!yyjson_mut_val_write_len(NULL, 0, NULL, NULL));
+    yy_assert(!yyjson_write_opts(NULL, YYJSON_WRITE_PRESIZE, NULL, NULL,
+                                 &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+
+    // mixed values, nesting deeper than the initial stack of the counter
+    root = yyjson_mut_obj(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    yyjson_mut_obj_add_val(doc, root, "arr", yyjson_mut_arr(doc));
+    yyjson_mut_obj_add_val(doc, root, "obj", yyjson_mut_obj(doc));
+    yyjson_mut_obj_add_null(doc, root, "k\"\t\x01");
+    yyjson_mut_obj_add_true(doc, root, "t");
+    yyjson_mut_obj_add_false(doc, root, "f");
+    yyjson_mut_obj_add_sint(doc, root, "sint", INT64_MIN);
+    yyjson_mut_obj_add_uint(doc, root, "uint", UINT64_MAX);
+    yyjson_mut_obj_add_real(doc, root, "real", -1.5e-300);
+    yyjson_mut_obj_add_float(doc, root, "float", 0.3f);
+    yyjson_mut_obj_add_val(doc, root, "raw", yyjson_mut_raw(doc, "[1, 2]"));
+    yyjson_mut_obj_add_val(doc, root, "empty", yyjson_mut_raw(doc, ""));
+    yyjson_mut_obj_add_str(doc, root, "invalid", "a\xC0\xE2\x82\xF0\x9D");
+    yyjson_mut_obj_add_str(doc, root, "esc", "\xC3\xA9\xE2\x82\xAC"
+                           "\xF0\x9D\x84\x9E\\/\b\x7F");
+    yyjson_mut_obj_add_str(doc, root, "tail", "\xF0\x9D");
+    obj = root;
+    for (i = 0; i < 100; i++) {
+        yyjson_mut_val *arr = yyjson_mut_arr(doc);
+        yyjson_mut_obj_add_val(doc, obj, "next", arr);
+        yyjson_mut_arr_add_int(doc, arr, (int64_t)i);
+        obj = yyjson_mut_arr_add_obj(doc, arr);
+        yyjson_mut_arr_add_real(doc, arr, (double)i / 3);
+    }
+    yyjson_mut_obj_add_real(doc, obj, "nan", NAN);
+    validate_json_write_presize(doc);
+
+    // nesting too deep for the memory on the stack of the exact-size writer,
+    // the buffer needs the room of the default writer
+    {
+        usize len;
+        char *buf, *ret;
+        root = yyjson_mut_arr(doc);
+        yyjson_mut_doc_set_root(doc, root);
+        for (i = 0, obj = root; i < 2000; i++) {
+            obj = yyjson_mut_arr_add_arr(doc, obj);
+        }
+        ret = yyjson_mut_write(doc, 0, &len);
+        yy_assert(ret && yyjson_mut_write_len(doc, 0, NULL, NULL) == len);
+        buf = (char *)malloc(len + 0x10000);
+        yy_assert(!yyjson_mut_write_buf(buf, len + 1, doc,
+                                        YYJSON_WRITE_PRESIZE, &err));
+        yy_assert(err.code == YYJSON_WRITE_ERROR_MEMORY_ALLOCATION);
+        yy_assert(yyjson_mut_write_buf(buf, len + 0x10000, doc,
+                                       YYJSON_WRITE_PRESIZE, &err) == len);
+        yy_assert(memcmp(buf, ret, len + 1) == 0);
+        free(buf);
+        free(ret);
+    }
+
+    yyjson_mut_doc_free(doc);
+}
+
+/*==============================================================================
+ * MARK: - Vectored
+ *============================================================================*/
+
+// concatenate the segments and compare with the serial writer,
+// returns the number of segments referencing `ref`
+static usize validate_json_write_iov_out(yyjson_iovec *iov, usize iov_num,
+                                         usize len, const char *expect,
+                                         usize expect_len, const char *ref) {
+    usize i, pos = 0, ref_num = 0;
+    yy_assert(iov);
+    yy_assert(len == expect_len);
+    for (i = 0; i < iov_num; i++) {
+        yy_assert(iov[i].len > 0);
+        yy_assert(pos + iov[i].len <= expect_len);
+        yy_assert(memcmp(expect + pos, iov[i].base, iov[i].len) == 0);
+        if (iov[i].base == (const void *)ref) ref_num++;
+        pos += iov[i].len;
+    }
+    yy_assert(pos == expect_len);
+    return ref_num;
+}
+
+static void validate_json_write_iov(yyjson_mut_doc *mdoc, const char *ref,
+                                    usize ref_len) {
+    yyjson_write_flag flgs[] = {
+        0, YYJSON_WRITE_PRETTY, YYJSON_WRITE_PRETTY_TWO_SPACES,
+        YYJSON_WRITE_NEWLINE_AT_END,
+        YYJSON_WRITE_PRETTY | YYJSON_WRITE_NEWLINE_AT_END,
+        YYJSON_WRITE_ESCAPE_UNICODE | YYJSON_WRITE_ESCAPE_SLASHES,
+        YYJSON_WRITE_ALLOW_INVALID_UNICODE | YYJSON_WRITE_ALLOW_INF_AND_NAN,
+        YYJSON_WRITE_PRETTY | YYJSON_WRITE_ESCAPE_UNICODE |
+        YYJSON_WRITE_ALLOW_INVALID_UNICODE | YYJSON_WRITE_INF_AND_NAN_AS_NULL,
+        YYJSON_WRITE_PRETTY_TWO_SPACES | YYJSON_WRITE_FP_TO_FIXED(3),
+        YYJSON_WRITE_FP_TO_FLOAT
+    };
+    usize ref_lens[] = { 0, 1, 16, 100000 };
+    yyjson_doc *idoc = yyjson_mut_doc_imut_copy(mdoc, NULL);
+    const char *iref = NULL;
+    usize f, r;
+    yy_assert(idoc);
+
+    // the referenced string in the immutable copy
+    if (ref) {
+        yyjson_val *val = yyjson_doc_get_root(idoc);
+        usize i, max = yyjson_doc_get_val_count(idoc);
+        for (i = 0; i < max; i++) {
+            if (yyjson_is_str(val + i) && yyjson_get_len(val + i) == ref_len &&
+                memcmp(yyjson_get_str(val + i), ref, ref_len) == 0) {
+                iref = yyjson_get_str(val + i);
+            }
+        }
+        yy_assert(iref);
+    }
+
+    for (f = 0; f < yy_nelems(flgs); f++) {
+        usize len;
+        bool esc = (flgs[f] & (YYJSON_WRITE_ESCAPE_UNICODE |
+                               YYJSON_WRITE_ESCAPE_SLASHES)) != 0;
+        char *ret = yyjson_mut_write(mdoc, flgs[f], &len);
+        yy_assert(ret);
+        for (r = 0; r < yy_nelems(ref_lens); r++) {
+            yyjson_write_err err;
+            yyjson_iovec *iov;
+            usize iov_num, out_len, ref_num;
+            bool has_ref = ref && !esc && ref_lens[r] <= ref_len;
+
+            iov = yyjson_mut_write_iov(mdoc, flgs[f], NULL, ref_lens[r],
+                                       &iov_num, &out_len, &err);
+            yy_assert(err.code == YYJSON_WRITE_SUCCESS);
+            ref_num = validate_json_write_iov_out(iov, iov_num, out_len,
+                                                  ret, len, ref);
+            yy_assert(ref_num == (has_ref ? 1 : 0));
+            free(iov);
+
+            iov = yyjson_write_iov(idoc, flgs[f], NULL, ref_lens[r],
+                                   &iov_num, &out_len, &err);
+            yy_assert(err.code == YYJSON_WRITE_SUCCESS);
+            ref_num = validate_json_write_iov_out(iov, iov_num, out_len,
+                                                  ret, len, iref);
+            yy_assert(ref_num == (has_ref ? 1 : 0));
+            free(iov);
+
+            iov = yyjson_mut_val_write_iov(yyjson_mut_doc_get_root(mdoc),
+                                           flgs[f], NULL, ref_lens[r],
+                                           &iov_num, &out_len, NULL);
+            validate_json_write_iov_out(iov, iov_num, out_len, ret, len, NULL);
+            free(iov);
+
+            iov = yyjson_val_write_iov(yyjson_doc_get_root(idoc),
+                                       flgs[f], NULL, ref_lens[r],
+                                       &iov_num, NULL, NULL);
+            validate_json_write_iov_out(iov, iov_num, len, ret, len, NULL);
+            free(iov);
+        }
+        free(ret);
+    }
+    yyjson_doc_free(idoc);
+}
+
+static void test_json_write_iov(void) {
+    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
+    yyjson_mut_val *root, *obj;
+    yyjson_write_err err;
+    usize i, iov_num, len;
+    char *blob = (char *)malloc(20000);
+    const char *ref;
+
+    // scalar roots are copied
+    yyjson_mut_doc_set_root(doc, yyjson_mut_int(doc, 1));
+    validate_json_write_iov(doc, NULL, 0);
+    yyjson_mut_doc_set_root(doc, yyjson_mut_rawn(doc, "", 0));
+    validate_json_write_iov(doc, NULL, 0);
+    yyjson_mut_doc_set_root(doc, yyjson_mut_obj(doc));
+    validate_json_write_iov(doc, NULL, 0);
+
+    // large string and raw values in containers
+    for (i = 0; i < 20000; i++) blob[i] = (char)('A' + (i % 26));
+    root = yyjson_mut_obj(doc);
+    yyjson_mut_doc_set_root(doc, root);
+    yyjson_mut_obj_add_str(doc, root, "name", "a/b\n\xE2\x82\xAC");
+    yyjson_mut_obj_add_strn(doc, root, "blob", blob, 20000);
+    yyjson_mut_obj_add(root, yyjson_mut_str(doc, "raw"),
+                       yyjson_mut_raw(doc, "[1,2,3]"));
+    obj = yyjson_mut_obj_add_obj(doc, root, "nest");
+    for (i = 0; i < 1000; i++) {
+        yyjson_mut_obj_add_uint(doc, obj, "id", i);
+    }
+    yyjson_mut_obj_add_arr(doc, root, "empty");
+    ref = yyjson_mut_get_str(yyjson_mut_obj_get(root, "blob"));
+    validate_json_write_iov(doc, ref, 20000);
+
+    // the string with escapes is copied
+    yyjson_mut_obj_add_strn(doc, root, "esc", "\"quoted\"", 8);
+    validate_json_write_iov(doc, ref, 20000);
+
+    // errors are the same as the serial writer
+    yyjson_mut_obj_add_strn(doc, obj, "bad", "\xFF", 1);
+    yy_assert(!yyjson_mut_write_iov(doc, 0, NULL, 1, &iov_num, &len, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_STRING);
+    yy_assert(iov_num == 0 && len == 0);
+    yy_assert(!yyjson_write_iov(NULL, 0, NULL, 0, &iov_num, &len, &err));
+    yy_assert(err.code == YYJSON_WRITE_ERROR_INVALID_PARAMETER);
+    yy_assert(!yyjson_val_write_iov(NULL, 0, NULL, 0, NULL, NULL, NULL));
+    yy_assert(!yyjson_mut_val_write_iov(NULL, 0, NULL, 0, NULL, NULL, NULL));
+
+    free(blob);
+    yyjson_mut_doc_free(doc);
+}
+
 yy_test_case(test_json_writer) {
     // test read and roundtrip
     {
@@ -848,6 +1557,18 @@ yy_test_case(test_json_writer) {
         free(buf);
     }
     
+    // test streaming writer
+    test_json_write_stream();
+    
+    // test parallel writer
+    test_json_write_par();
+    
+    // test pre-sized writer
+    test_json_write_presize();
+    
+    // test vectored writer
+    test_json_write_iov();
+    
     // test invalid parameters
 #if !YYJSON_DISABLE_FILE
     {
@@ -1120,7 +1841,8 @@ yy_test_case(test_json_writer) {
     }
 #endif
     
-    // test build JSON on stack
+    // test build JSON on stack, compact values must be created by a document
+#if !YYJSON_MUT_COMPACT
     {
         const char *expect = "{\"code\":200,\"msg\":\"success\",\"arr\":[true,false,null,1,-1,0.5,inf]}";
         
@@ -1155,6 +1877,7 @@ yy_test_case(test_json_writer) {
         char *json = yyjson_mut_val_write_opts(&root, 0, &alc, NULL, NULL);
         yy_assert(strcmp(json, expect) == 0);
     }
+#endif
     
     // test bool conversion
     // some environments don't have a native bool type
@@ -931,6 +931,149 @@ static void test_random_int(void) {
     }
 }
 
+/// Append random digits, the first digit is not zero if `nonzero` is true.
+static char *rand_digits(char *cur, u32 len, bool nonzero) {
+    for (u32 i = 0; i < len; i++) {
+        u32 d = yy_rand_u32() % 10;
+        if (i == 0 && nonzero && d == 0) d = 1;
+        *cur++ = (char)('0' + d);
+    }
+    return cur;
+}
+
+/// Test numbers with different digit counts in an array, the reader may read
+/// 8 digits at once, the number reader reads the digits one by one.
+static void test_random_digits(void) {
+    yyjson_read_flag flg_arr[] = {
+        YYJSON_READ_NOFLAG,
+        YYJSON_READ_BIGNUM_AS_RAW,
+        YYJSON_READ_ALLOW_EXT_NUMBER,
+    };
+    const char *sep_arr[] = { ",", ", ", ",\n  " };
+    usize num_count = 2000, num_max = 64;
+    char *buf = (char *)malloc(num_count * (num_max + 4) + 4);
+    char *str_arr = (char *)malloc(num_count * num_max);
+    
+    yy_rand_reset(0);
+    for (usize s = 0; s < yy_nelems(sep_arr); s++) {
+        for (int round = 0; round < 20; round++) {
+            char *cur = buf;
+            *cur++ = '[';
+            for (usize i = 0; i < num_count; i++) {
+                char *str = str_arr + i * num_max, *end = str;
+                u32 type = yy_rand_u32() % 8;
+                if (yy_rand_u32() % 4 == 0) *end++ = '-';
+                end = rand_digits(end, 1 + yy_rand_u32() % 24, true);
+                if (type >= 4) { /// fraction
+                    *end++ = '.';
+                    end = rand_digits(end, 1 + yy_rand_u32() % 24, false);
+                }
+                if (type == 3 || type == 7) { /// exponent
+                    *end++ = (yy_rand_u32() % 2) ? 'e' : 'E';
+                    if (yy_rand_u32() % 2) *end++ = '-';
+                    end = rand_digits(end, 1 + yy_rand_u32() % 2, false);
+                }
+                *end = '\0';
+                memcpy(cur, str, (usize)(end - str));
+                cur += end - str;
+                if (i + 1 < num_count) {
+                    memcpy(cur, sep_arr[s], strlen(sep_arr[s]));
+                    cur += strlen(sep_arr[s]);
+                }
+            }
+            *cur++ = ']';
+            
+            for (usize f = 0; f < yy_nelems(flg_arr); f++) {
+                yyjson_read_flag flg = flg_arr[f];
+                yyjson_doc *doc = yyjson_read(buf, (usize)(cur - buf), flg);
+                yyjson_val *arr = yyjson_doc_get_root(doc);
+                yy_assert(yyjson_arr_size(arr) == num_count);
+                for (usize i = 0; i < num_count; i++) {
+                    const char *str = str_arr + i * num_max;
+                    yyjson_val val;
+                    const char *end = yyjson_read_number(str, &val, flg,
+                                                         NULL, NULL);
+                    yy_assertf(end && *end == '\0', "num: %s", str);
+                    yy_assertf(yyjson_equals(yyjson_arr_get(arr, i), &val),
+                               "num: %s", str);
+                }
+                yyjson_doc_free(doc);
+            }
+        }
+    }
+    free(buf);
+    free(str_arr);
+}
+
+/// Returns whether the value in array is the same as the number read by
+/// `yyjson_read_number()` from `str`.
+static bool int_array_val_eq(yyjson_val *val, yyjson_val *num,
+                             const char *str) {
+    if (yyjson_get_tag(val) != yyjson_get_tag(num)) return false;
+    if (yyjson_is_raw(val)) return strcmp(yyjson_get_raw(val), str) == 0;
+    return val->uni.u64 == num->uni.u64;
+}
+
+/// Test the arrays of plain integers mixed with other numbers and separators,
+/// the values should be the same as `yyjson_read_number()`.
+static void test_int_array(void) {
+    yyjson_read_flag flg_arr[] = {
+        YYJSON_READ_NOFLAG,
+        YYJSON_READ_NUMBER_AS_RAW,
+        YYJSON_READ_BIGNUM_AS_RAW,
+        YYJSON_READ_ALLOW_COMMENTS,
+    };
+    const char *num_arr[] = {
+        "0", "-0", "7", "-7", "10", "123456789012345678",
+        "-123456789012345678", "1234567890123456789", "-9223372036854775808",
+        "-9223372036854775809", "18446744073709551615", "18446744073709551616",
+        "0.5", "-0e1", "12e3", "-1.5E-2",
+    };
+    const char *fmt_arr[] = { /// the number count, the format
+        "1[%s]", "2[%s,%s]", "1[1,%s,2]", "2[-1,%s ,%s\n]",
+        "2[\n  %s,\n  %s\n]", "2[%s/**/,%s]",
+    };
+    const char *err_arr[] = {
+        "[01]", "[1,01]", "[-]", "[1,-]", "[1,-a]", "[1,2x]", "[1,2", "[1,",
+        "[1,]", "[1,-01]", "[1,2.]",
+    };
+    char buf[128];
+    
+    for (usize f = 0; f < yy_nelems(flg_arr); f++) {
+        yyjson_read_flag flg = flg_arr[f];
+        for (usize n = 0; n < yy_nelems(num_arr); n++) {
+            const char *str = num_arr[n];
+            yyjson_val num;
+            const char *end = yyjson_read_number(str, &num, flg, NULL, NULL);
+            yy_assert(end && *end == '\0');
+            
+            for (usize i = 0; i < yy_nelems(fmt_arr); i++) {
+                const char *fmt = fmt_arr[i];
+                yyjson_doc *doc;
+                yyjson_val *val;
+                yyjson_arr_iter iter;
+                usize count = 0;
+                if (!(flg & YYJSON_READ_ALLOW_COMMENTS) &&
+                    strstr(fmt, "/*")) continue;
+                snprintf(buf, sizeof(buf), fmt + 1, str, str);
+                doc = yyjson_read(buf, strlen(buf), flg);
+                yy_assertf(doc, "json: %s", buf);
+                yyjson_arr_iter_init(yyjson_doc_get_root(doc), &iter);
+                while ((val = yyjson_arr_iter_next(&iter))) {
+                    count += int_array_val_eq(val, &num, str);
+                }
+                yy_assertf(count == (usize)(fmt[0] - '0'), "json: %s", buf);
+                yyjson_doc_free(doc);
+            }
+        }
+        for (usize e = 0; e < yy_nelems(err_arr); e++) {
+            const char *str = err_arr[e];
+            yyjson_doc *doc = yyjson_read(str, strlen(str), flg);
+            yy_assertf(!doc, "json: %s", str);
+        }
+    }
+}
+
 /// Test real number read/write fast (do not test all flags).
 static void test_real_fast(f64 num, yyjson_alc *alc,
                            bool test_to_float,
@@ -1211,14 +1354,16 @@ static void test_read_flags(void) {
                 }
             }
             {   /// mut val read
-                yyjson_mut_val val2;
-                const char *end = yyjson_mut_read_number(num_str, &val2, flg, NULL, NULL);
+                yyjson_mut_doc *mdoc = yyjson_mut_doc_new(NULL);
+                yyjson_mut_val *val2 = yyjson_mut_null(mdoc);
+                const char *end = yyjson_mut_read_number(num_str, val2, flg, NULL, NULL);
                 if (val) {
-                    yy_assert(yyjson_equals(val, (yyjson_val *)&val2));
+                    yy_assert(yyjson_mut_equals(yyjson_val_mut_copy(mdoc, val), val2));
                     yy_assert(end && *end == '\0');
                 } else {
                     yy_assert(end != num_str);
                 }
+                yyjson_mut_doc_free(mdoc);
             }
             {   /// minity format read
                 usize buf_len = num_len + 2;
@@ -1452,27 +1597,27 @@ static void test_write_flags(void) {
         yyjson_mut_set_float(&val, (float)1.25);
         yy_assert(yyjson_mut_is_real(&val));
         yy_assert((float)yyjson_mut_get_real(&val) == (float)1.25);
-        yy_assert((val.tag >> 32) == YYJSON_WRITE_FP_TO_FLOAT);
+        yy_assert(unsafe_yyjson_mut_get_fp_fmt(&val) == YYJSON_WRITE_FP_TO_FLOAT);
         yyjson_mut_set_double(&val, 1.25);
         yy_assert(yyjson_mut_is_real(&val));
         yy_assert(yyjson_mut_get_real(&val) == 1.25);
-        yy_assert((val.tag >> 32) == 0);
+        yy_assert(unsafe_yyjson_mut_get_fp_fmt(&val) == 0);
         
         /// set to fixed
         yyjson_mut_set_fp_to_fixed(&val, 12);
         yy_assert(yyjson_mut_is_real(&val));
-        yy_assert((val.tag >> 32) == YYJSON_WRITE_FP_TO_FIXED(12));
+        yy_assert(unsafe_yyjson_mut_get_fp_fmt(&val) == YYJSON_WRITE_FP_TO_FIXED(12));
         yyjson_mut_set_fp_to_fixed(&val, 0);
         yy_assert(yyjson_mut_is_real(&val));
-        yy_assert((val.tag >> 32) == YYJSON_WRITE_FP_TO_FIXED(0));
+        yy_assert(unsafe_yyjson_mut_get_fp_fmt(&val) == YYJSON_WRITE_FP_TO_FIXED(0));
         
         /// set to float
         yyjson_mut_set_fp_to_float(&val, true);
         yy_assert(yyjson_mut_is_real(&val));
-        yy_assert((val.tag >> 32) == YYJSON_WRITE_FP_TO_FLOAT);
+        yy_assert(unsafe_yyjson_mut_get_fp_fmt(&val) == YYJSON_WRITE_FP_TO_FLOAT);
         yyjson_mut_set_fp_to_float(&val, false);
         yy_assert(yyjson_mut_is_real(&val));
-        yy_assert((val.tag >> 32) == 0);
+        yy_assert(unsafe_yyjson_mut_get_fp_fmt(&val) == 0);
     }
     
     /// write number
@@ -1593,6 +1738,8 @@ static void test_number_locale(void) {
 
 static void test_number_extra(void) {
     test_random_int();
+    test_random_digits();
+    test_int_array();
     test_random_real();
     test_special_real();
     
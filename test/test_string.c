@@ -1452,6 +1452,184 @@ static void test_unquoted_key(void) {
 
 
 
+/*==============================================================================
+ * MARK: - Long String
+ *============================================================================*/
+
+/// Validate read: `read([<quo>src<quo>, "tail"])[0] == dst`, with and without
+/// the `INSITU` and `STRUCTURAL_INDEX` flags. The string scanner may process a
+/// block of bytes at once, the tail value is used to make sure it stops at the
+/// right quote.
+static void validate_long_str(char quo, string_val src, string_val dst,
+                              yyjson_read_flag flg) {
+#if !YYJSON_DISABLE_READER
+#if YYJSON_DISABLE_UTF8_VALIDATION
+    if (!yy_str_is_utf8(src.str, src.len)) return;
+#endif
+    
+    const char *tail = "\"tail\"]";
+    usize tail_len = strlen(tail);
+    usize buf_len = 1 + 1 + src.len + 1 + 1 + tail_len;
+    char *buf = malloc(buf_len + YYJSON_PADDING_SIZE);
+    char *cur = buf;
+    *cur++ = '[';
+    *cur++ = quo;
+    memcpy(cur, src.str, src.len); cur += src.len;
+    *cur++ = quo;
+    *cur++ = ',';
+    memcpy(cur, tail, tail_len);
+    
+    for (int mode = 0; mode < 4; mode++) {
+        int insitu = mode & 1;
+        char *dat = buf;
+        yyjson_read_flag f = flg;
+        if (mode & 2) f |= YYJSON_READ_STRUCTURAL_INDEX;
+        if (insitu) {
+            dat = malloc(buf_len + YYJSON_PADDING_SIZE);
+            memcpy(dat, buf, buf_len);
+            memset(dat + buf_len, 0, YYJSON_PADDING_SIZE);
+            f |= YYJSON_READ_INSITU;
+        }
+        yyjson_doc *doc = yyjson_read(dat, buf_len, f);
+        if (dst.str) {
+            yyjson_val *val = yyjson_arr_get(yyjson_doc_get_root(doc), 0);
+            yy_assertf(yyjson_equals_strn(val, dst.str, dst.len),
+                       "read fail, quote: %c, mode: %d, len: %u\n"
+                       "input: %.*s\nexpect: %.*s\n",
+                       quo, mode, (u32)src.len, (int)src.len, src.str,
+                       (int)dst.len, dst.str);
+            val = yyjson_arr_get(yyjson_doc_get_root(doc), 1);
+            yy_assert(yyjson_equals_str(val, "tail"));
+        } else {
+            yy_assertf(!doc,
+                       "input should be rejected, quote: %c, mode: %d, len: %u\n",
+                       quo, mode, (u32)src.len);
+        }
+        yyjson_doc_free(doc);
+        if (insitu) free(dat);
+    }
+    free(buf);
+#endif
+}
+
+/// Insert `ins` at `pos` of a long ASCII string and validate the result.
+static void validate_long_str_ins(char quo, usize len, usize pos,
+                                  const char *ins, const char *out,
+                                  yyjson_read_flag flg) {
+    const char *base = "abcdefghij klmnopqrstuvwxyz 0123456789~\x7F/";
+    usize base_len = strlen(base);
+    usize ins_len = ins ? strlen(ins) : 0;
+    usize out_len = out ? strlen(out) : 0;
+    char *src = malloc(len + ins_len + 1);
+    char *dst = malloc(len + out_len + 1);
+    
+    for (usize i = 0; i < pos; i++) src[i] = base[i % base_len];
+    memcpy(src + pos, ins, ins_len);
+    for (usize i = pos; i < len; i++) src[ins_len + i] = base[i % base_len];
+    
+    for (usize i = 0; i < pos; i++) dst[i] = base[i % base_len];
+    if (out) memcpy(dst + pos, out, out_len);
+    for (usize i = pos; i < len; i++) dst[out_len + i] = base[i % base_len];
+    
+    string_val s = { src, len + ins_len };
+    string_val d = { out ? dst : NULL, len + out_len };
+    validate_long_str(quo, s, d, flg);
+    free(src);
+    free(dst);
+}
+
+/// Insert `ins` at `pos` of a long ASCII string and validate the writer output
+/// with each escape flag. The string writer may copy a block of bytes at once,
+/// the inserted bytes must stop it at any position of the block.
+static void validate_long_str_write_ins(usize len, usize pos, const char *ins,
+                                        const char *esc_non,
+                                        const char *esc_sla,
+                                        const char *esc_uni,
+                                        const char *esc_all) {
+    const char *base = "abcdefghij klmnopqrstuvwxyz 0123456789~\x7F";
+    usize base_len = strlen(base);
+    const char *outs[5] = { ins, esc_non, esc_sla, esc_uni, esc_all };
+    string_val vals[5];
+    char *bufs[5];
+
+    for (int i = 0; i < 5; i++) {
+        usize out_len = strlen(outs[i]);
+        char *buf = malloc(len + out_len + 1);
+        for (usize j = 0; j < pos; j++) buf[j] = base[j % base_len];
+        memcpy(buf + pos, outs[i], out_len);
+        for (usize j = pos; j < len; j++) buf[out_len + j] = base[j % base_len];
+        buf[len + out_len] = '\0';
+        vals[i].str = buf;
+        vals[i].len = len + out_len;
+        bufs[i] = buf;
+    }
+    validate_write((string_set) {
+        vals[0], vals[1], vals[2], vals[3], vals[4], false
+    });
+    for (int i = 0; i < 5; i++) free(bufs[i]);
+}
+
+static void test_long_string(void) {
+    for (usize len = 0; len <= 80; len++) {
+        validate_long_str_write_ins(len, 0, "", "", "", "", "");
+        for (usize pos = 0; pos <= len; pos++) {
+            validate_long_str_write_ins(len, pos, "\"", "\\\"", "\\\"",
+                                        "\\\"", "\\\"");
+            validate_long_str_write_ins(len, pos, "\\", "\\\\", "\\\\",
+                                        "\\\\", "\\\\");
+            validate_long_str_write_ins(len, pos, "\n", "\\n", "\\n",
+                                        "\\n", "\\n");
+            validate_long_str_write_ins(len, pos, "\x1F", "\\u001F",
+                                        "\\u001F", "\\u001F", "\\u001F");
+            validate_long_str_write_ins(len, pos, "/", "/", "\\/",
+                                        "/", "\\/");
+            validate_long_str_write_ins(len, pos, "é", "é", "é",
+                                        "\\u00E9", "\\u00E9");
+            validate_long_str_write_ins(len, pos, "😀", "😀", "😀",
+                                        "\\uD83D\\uDE00", "\\uD83D\\uDE00");
+        }
+    }
+
+
+    for (usize len = 0; len <= 80; len++) {
+        validate_long_str_ins('"', len, 0, "", "", 0);
+        for (usize pos = 0; pos <= len; pos++) {
+            validate_long_str_ins('"', len, pos, "\\n", "\n", 0);
+            validate_long_str_ins('"', len, pos, "\\\"", "\"", 0);
+            validate_long_str_ins('"', len, pos, "\\\\", "\\", 0);
+            validate_long_str_ins('"', len, pos, "\\u00E9", "é", 0);
+            validate_long_str_ins('"', len, pos, "é", "é", 0);
+            validate_long_str_ins('"', len, pos, "中文", "中文", 0);
+            validate_long_str_ins('"', len, pos, "😀", "😀", 0);
+            validate_long_str_ins('"', len, pos, "'", "'", 0);
+            validate_long_str_ins('"', len, pos, "\\n\\t", "\n\t", 0);
+            validate_long_str_ins('"', len, pos, "\x01", NULL, 0);
+            validate_long_str_ins('"', len, pos, "\x1F", NULL, 0);
+            validate_long_str_ins('"', len, pos, "\xFF", NULL, 0);
+            validate_long_str_ins('"', len, pos, "\\x", NULL, 0);
+            /* escape at `pos`, followed by a long run copied in place */
+            validate_long_str_ins('"', len + 40, pos, "\\/", "/", 0);
+            
+#if !YYJSON_DISABLE_NON_STANDARD
+            validate_long_str_ins('"', len, pos, "\xFF", "\xFF",
+                                  YYJSON_READ_ALLOW_INVALID_UNICODE);
+            validate_long_str_ins('\'', len, pos, "", "",
+                                  YYJSON_READ_JSON5);
+            validate_long_str_ins('\'', len, pos, "\"", "\"",
+                                  YYJSON_READ_JSON5);
+            validate_long_str_ins('\'', len, pos, "\\'", "'",
+                                  YYJSON_READ_JSON5);
+            validate_long_str_ins('\'', len, pos, "\\n", "\n",
+                                  YYJSON_READ_JSON5);
+            validate_long_str_ins('\'', len, pos, "é", "é",
+                                  YYJSON_READ_JSON5);
+#endif
+        }
+    }
+}
+
+
+
 /*==============================================================================
  * MARK: - Entry
  *============================================================================*/
@@ -1461,4 +1639,5 @@ yy_test_case(test_string) {
     test_extended_escape();
     test_single_quoted_string();
     test_unquoted_key();
+    test_long_string();
 }